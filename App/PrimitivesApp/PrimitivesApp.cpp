@@ -2,6 +2,8 @@
 #include "Camera/Camera.h"
 #include "Rendering/Renderer.h"
 #include "Rendering/DataTypes.h"
+#include "Scene/FramePipeline.h"
+#include "Profiling/Profiler.h"
 
 using namespace renderer;
 
@@ -28,6 +30,10 @@ PrimitivesApp::PrimitivesApp(HINSTANCE hInstance, HWND windowHandle, int screenW
 	mMouseX = 0;
 	mMouseY = 0;
 	mInitialized = false;
+	mProfileKeyDown = false;
+	mRecordKeyDown = false;
+	mReplayKeyDown = false;
+	mRecordingCamera = false;
 
 	// Determine current performance-counter frequency of the system and the start time
 	LARGE_INTEGER frequencyCount;
@@ -50,6 +56,8 @@ PrimitivesApp::PrimitivesApp(HINSTANCE hInstance, HWND windowHandle, int screenW
 	config.screenHeight = screenHeight;
 	auto renderer = Renderer::Initialize(windowHandle, config);
 	mRenderer.reset(renderer);
+	mPipeline = std::make_unique<FramePipeline>();
+	mCamera = std::make_unique<Camera>(*mRenderer->GetCamera());
 
 	// Create example lights, materials and entities
 
@@ -64,7 +72,7 @@ PrimitivesApp::PrimitivesApp(HINSTANCE hInstance, HWND windowHandle, int screenW
 	mSpotLight->diffuse = { 1, 1, 1 };
 	mSpotLight->specular = { 1, 1, 1 };
 
-	mRenderer->AddSpotLight(mSpotLight);
+	mPipeline->SetSpotLight(*mSpotLight);
 
 	uint32_t maxDist = 30;
 
@@ -95,7 +103,7 @@ PrimitivesApp::PrimitivesApp(HINSTANCE hInstance, HWND windowHandle, int screenW
 			pointLight->diffuse = { 0, 1, 0 };
 			pointLight->specular = { 0, 0.6f, 0 };
 
-			mRenderer->AddPointLight(pointLight);
+			mPipeline->AddPointLight(*pointLight);
 		}
 
 		auto entity = std::make_shared<Entity>();
@@ -109,54 +117,105 @@ PrimitivesApp::PrimitivesApp(HINSTANCE hInstance, HWND windowHandle, int screenW
 			entity->material = glossyMaterial;
 		}
 
-		entity->meshType = MeshType::Cube;
+		entity->mesh = BuiltinMeshes::Cube;
 		entity->scale = { 1, 1, 1 };
 		entity->position = { px, py, pz };
 		entity->rotation = { 0, 1, 0, 45.0f * r };
 		
+		mPipeline->AddEntity(*entity);
 		mEntities.emplace_back(std::move(entity));
-		mRenderer->AddEntity(mEntities[i]);
 	}
-	
+
+	// The renderer is only used from the render thread from here on
+	mRenderThread = std::thread(&PrimitivesApp::RenderThread, this);
 	mInitialized = true;
 }
 
 PrimitivesApp::~PrimitivesApp()
 {
 	ShutdownInput();
+	if (mRenderThread.joinable())
+	{
+		mPipeline->Close();
+		mRenderThread.join();
+	}
 	mRenderer.reset();
 	mApp = nullptr;
 }
 
 bool PrimitivesApp::Update()
 {
+	PROFILE_ZONE("PrimitivesApp::Update");
 	CalculateCurrentTime();
+	mPipeline->BeginFrame();
 	// Return if user hit an exit button
 	if (!HandleInput())
 	{
 		return false;
 	}
 
+	// A replay drives the camera and frame time so the frames match the recording
+	Camera* cam = mCamera.get();
+	if (mCameraPlayer.IsPlaying())
+	{
+		double frameTime = 0;
+		if (mCameraPlayer.Advance(*cam, frameTime))
+		{
+			mFrameTime = frameTime;
+		}
+	}
+	else if (mRecordingCamera)
+	{
+		mCameraTrack.Record(*cam, mFrameTime);
+	}
+
 	// Move the spot light with the camera
-	auto cam = mRenderer->GetCamera();
 	mSpotLight->direction = VF3(cam->GetForward());
 	mSpotLight->position = cam->GetPosition();
 	
+	mPipeline->SetSpotLight(*mSpotLight);
+	mPipeline->SetCamera(0, *cam);
+
 	// Rotate cubes
-	for (auto& entity : mEntities)
+	for (std::uint32_t id = 0; id < mEntities.size(); ++id)
 	{
-		entity->rotation.w += 1.0f;
-		if (entity->rotation.w >= 360)
+		Entity& entity = *mEntities[id];
+		entity.rotation.w += 1.0f;
+		if (entity.rotation.w >= 360)
 		{
-			entity->rotation.w = 0;
+			entity.rotation.w = 0;
 		}
+		mPipeline->SetTransform(id, entity.position, entity.rotation, entity.scale);
 	}
 
-	mRenderer->Render(mFrameTime);	
+	// The next frame is simulated while this one renders, but no further ahead
+	const std::uint64_t frameIndex = mPipeline->Publish(mFrameTime);
+	mPipeline->WaitForAcquired(frameIndex);
 
 	return true;
 }
 
+void PrimitivesApp::RenderThread()
+{
+	Profiler::SetThreadName("Render");
+	while (const FrameSnapshot* frame = mPipeline->WaitForFrame())
+	{
+		const FrameChanges& changes = mPipeline->GetChanges();
+		if (changes.addedSpotLight)
+		{
+			mRenderer->AddSpotLight(changes.addedSpotLight);
+		}
+		for (const auto& pointLight : changes.addedPointLights)
+		{
+			mRenderer->AddPointLight(pointLight);
+		}
+		mRenderer->RemoveEntities(changes.removed);
+		mRenderer->AddEntities(changes.added);
+		mPipeline->ApplyCamera(0, *mRenderer->GetCamera());
+		mRenderer->Render(frame->frameTime);
+	}
+}
+
 void PrimitivesApp::CalculateCurrentTime()
 {
 	LARGE_INTEGER current;
@@ -268,7 +327,7 @@ void PrimitivesApp::ShutdownInput()
 
 bool PrimitivesApp::HandleInput()
 {
-	Camera* camera = mRenderer->GetCamera();
+	Camera* camera = mCamera.get();
 
 	DIMOUSESTATE mouseCurrState;
 
@@ -292,6 +351,14 @@ bool PrimitivesApp::HandleInput()
 	mMouseX += mouseCurrState.lX;
 	mMouseY += mouseCurrState.lY;
 
+	// Input does not move the camera while a recording is replayed
+	if (mCameraPlayer.IsPlaying())
+	{
+		moveAmount = 0;
+		rotAmountX = 0;
+		rotAmountY = 0;
+	}
+
 	camera->SetYaw(rotAmountX);
 	camera->SetPitch(rotAmountY);
 
@@ -327,6 +394,35 @@ bool PrimitivesApp::HandleInput()
 		mSpotLight->diffuse = { 0, 0, 0 };
 		mSpotLight->specular = { 0, 0, 0 };
 	}
+	// Save the recent frames for chrome://tracing once per key press
+	bool profileKeyDown = (keyboardState[DIK_P] & 0x80) != 0;
+	if (profileKeyDown && !mProfileKeyDown)
+	{
+		Profiler::SaveChromeTrace(Profiler::Capture(), "profile.json");
+	}
+	mProfileKeyDown = profileKeyDown;
+	// C starts recording the camera and stops and saves it to camera.track
+	bool recordKeyDown = (keyboardState[DIK_C] & 0x80) != 0;
+	if (recordKeyDown && !mRecordKeyDown && !mCameraPlayer.IsPlaying())
+	{
+		if (mRecordingCamera)
+		{
+			mCameraTrack.Save("camera.track");
+		}
+		else
+		{
+			mCameraTrack.Clear();
+		}
+		mRecordingCamera = !mRecordingCamera;
+	}
+	mRecordKeyDown = recordKeyDown;
+	// V replays camera.track at its recorded frame times
+	bool replayKeyDown = (keyboardState[DIK_V] & 0x80) != 0;
+	if (replayKeyDown && !mReplayKeyDown && !mRecordingCamera && mCameraTrack.Load("camera.track"))
+	{
+		mCameraPlayer.Start(&mCameraTrack);
+	}
+	mReplayKeyDown = replayKeyDown;
 	if (keyboardState[DIK_ESCAPE] & 0x80)
 	{
 		return false;
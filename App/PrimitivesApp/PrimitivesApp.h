@@ -2,10 +2,14 @@
 
 #include "Minimal.h"
 #include "Input.h"
+#include "Camera/CameraTrack.h"
+#include <thread>
 
 namespace renderer
 {
     class Renderer;
+    class Camera;
+    class FramePipeline;
     struct Entity;
     struct SpotLight;
 }
@@ -23,6 +27,7 @@ private:
     bool InitializeInput(HINSTANCE hInstance, HWND windowHandle);
     bool HandleInput();
     void ShutdownInput();
+    void RenderThread();
 
     bool mInitialized;
 
@@ -32,6 +37,11 @@ private:
     double mFrameTime;
 
     std::unique_ptr<renderer::Renderer> mRenderer;
+    // Update simulates the next frame into the pipeline while the render thread draws the last one. The camera
+    // input moves is this thread's, and the renderer's camera follows it a frame behind
+    std::unique_ptr<renderer::FramePipeline> mPipeline;
+    std::unique_ptr<renderer::Camera> mCamera;
+    std::thread mRenderThread;
 
     IDirectInput8* mInput;
     IDirectInputDevice8* mKeyboard;
@@ -41,7 +51,16 @@ private:
     int mScreenHeight;
     int mMouseX;
     int mMouseY;
+    bool mProfileKeyDown;
+    bool mRecordKeyDown;
+    bool mReplayKeyDown;
 
+    // Camera recorded with C and replayed with V so runs can be compared frame for frame
+    renderer::CameraTrack mCameraTrack;
+    renderer::CameraTrackPlayer mCameraPlayer;
+    bool mRecordingCamera;
+
+    // The simulation's, which the render thread has copies of. Entity ids in the pipeline are their indices
     std::shared_ptr<renderer::SpotLight> mSpotLight;
     std::vector<std::shared_ptr<renderer::Entity>> mEntities;
 
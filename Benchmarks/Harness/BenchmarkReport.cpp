@@ -0,0 +1,372 @@
+#include "Harness/BenchmarkReport.h"
+#include <cctype>
+
+namespace benchmarks
+{
+	namespace
+	{
+		void WriteString(std::ostream& stream, const std::string& value)
+		{
+			stream << '"';
+			for (char c : value)
+			{
+				switch (c)
+				{
+				case '"': stream << "\\\""; break;
+				case '\\': stream << "\\\\"; break;
+				case '\n': stream << "\\n"; break;
+				case '\t': stream << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+					}
+					else
+					{
+						stream << c;
+					}
+				}
+			}
+			stream << '"';
+		}
+
+		/** Parsed JSON value. Only as much of JSON as the reports need, which is everything but unicode escapes past ASCII */
+		struct JsonValue
+		{
+			enum class Type { Null, Bool, Number, String, Array, Object };
+
+			Type type = Type::Null;
+			double number = 0;
+			std::string string;
+			std::vector<JsonValue> items;
+			std::vector<std::pair<std::string, JsonValue>> members;
+
+			const JsonValue* Find(const std::string& key) const
+			{
+				for (const auto& member : members)
+				{
+					if (member.first == key)
+					{
+						return &member.second;
+					}
+				}
+				return nullptr;
+			}
+		};
+
+		class JsonParser
+		{
+		public:
+			explicit JsonParser(const std::string& text)
+				: mText(text), mPos(0)
+			{
+
+			}
+
+			bool Parse(JsonValue& value)
+			{
+				if (!ParseValue(value))
+				{
+					return false;
+				}
+				SkipWhitespace();
+				return mPos == mText.size();
+			}
+
+		private:
+			void SkipWhitespace()
+			{
+				while (mPos < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPos])))
+				{
+					++mPos;
+				}
+			}
+
+			bool Consume(char c)
+			{
+				SkipWhitespace();
+				if (mPos < mText.size() && mText[mPos] == c)
+				{
+					++mPos;
+					return true;
+				}
+				return false;
+			}
+
+			bool ConsumeWord(const char* word)
+			{
+				size_t length = std::strlen(word);
+				if (mText.compare(mPos, length, word) != 0)
+				{
+					return false;
+				}
+				mPos += length;
+				return true;
+			}
+
+			bool ParseValue(JsonValue& value)
+			{
+				SkipWhitespace();
+				if (mPos >= mText.size())
+				{
+					return false;
+				}
+
+				switch (mText[mPos])
+				{
+				case '{': return ParseObject(value);
+				case '[': return ParseArray(value);
+				case '"':
+					value.type = JsonValue::Type::String;
+					return ParseString(value.string);
+				case 't':
+					value.type = JsonValue::Type::Bool;
+					value.number = 1;
+					return ConsumeWord("true");
+				case 'f':
+					value.type = JsonValue::Type::Bool;
+					return ConsumeWord("false");
+				case 'n':
+					value.type = JsonValue::Type::Null;
+					return ConsumeWord("null");
+				default:
+					return ParseNumber(value);
+				}
+			}
+
+			bool ParseObject(JsonValue& value)
+			{
+				value.type = JsonValue::Type::Object;
+				Consume('{');
+				if (Consume('}'))
+				{
+					return true;
+				}
+				do
+				{
+					std::pair<std::string, JsonValue> member;
+					SkipWhitespace();
+					if (!ParseString(member.first) || !Consume(':') || !ParseValue(member.second))
+					{
+						return false;
+					}
+					value.members.push_back(std::move(member));
+				} while (Consume(','));
+				return Consume('}');
+			}
+
+			bool ParseArray(JsonValue& value)
+			{
+				value.type = JsonValue::Type::Array;
+				Consume('[');
+				if (Consume(']'))
+				{
+					return true;
+				}
+				do
+				{
+					JsonValue item;
+					if (!ParseValue(item))
+					{
+						return false;
+					}
+					value.items.push_back(std::move(item));
+				} while (Consume(','));
+				return Consume(']');
+			}
+
+			bool ParseString(std::string& string)
+			{
+				if (mPos >= mText.size() || mText[mPos] != '"')
+				{
+					return false;
+				}
+				++mPos;
+				while (mPos < mText.size())
+				{
+					char c = mText[mPos++];
+					if (c == '"')
+					{
+						return true;
+					}
+					if (c != '\\')
+					{
+						string += c;
+						continue;
+					}
+					if (mPos >= mText.size())
+					{
+						return false;
+					}
+					char escape = mText[mPos++];
+					switch (escape)
+					{
+					case 'n': string += '\n'; break;
+					case 't': string += '\t'; break;
+					case 'r': string += '\r'; break;
+					case 'b': string += '\b'; break;
+					case 'f': string += '\f'; break;
+					case 'u':
+						if (mPos + 4 > mText.size())
+						{
+							return false;
+						}
+						string += static_cast<char>(std::strtol(mText.substr(mPos, 4).c_str(), nullptr, 16));
+						mPos += 4;
+						break;
+					default: string += escape; break;
+					}
+				}
+				return false;
+			}
+
+			bool ParseNumber(JsonValue& value)
+			{
+				const char* start = mText.c_str() + mPos;
+				char* end = nullptr;
+				value.type = JsonValue::Type::Number;
+				value.number = std::strtod(start, &end);
+				if (end == start)
+				{
+					return false;
+				}
+				mPos += end - start;
+				return true;
+			}
+
+			const std::string& mText;
+			size_t mPos;
+		};
+
+		double GetNumber(const JsonValue& object, const std::string& key)
+		{
+			const JsonValue* value = object.Find(key);
+			return value && value->type == JsonValue::Type::Number ? value->number : 0;
+		}
+	}
+
+	void BenchmarkReport::WriteJson(const std::vector<BenchmarkResult>& results, std::ostream& stream)
+	{
+		// Enough digits that reading the file back gives the same doubles
+		stream << std::setprecision(17) << "{\n  \"version\": 1,\n  \"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const auto& result = results[i];
+			stream << (i > 0 ? ",\n" : "\n") << "    { \"name\": ";
+			WriteString(stream, result.name);
+			stream << ", \"scale\": " << result.scale << ", \"iterations\": " << result.iterations
+				<< ", \"nsPerIteration\": " << result.nsPerIteration << ", \"nsPerItem\": " << result.nsPerItem
+				<< ", \"counters\": {";
+			for (size_t c = 0; c < result.counters.size(); ++c)
+			{
+				stream << (c > 0 ? ", " : " ");
+				WriteString(stream, result.counters[c].first);
+				stream << ": " << result.counters[c].second;
+			}
+			stream << (result.counters.empty() ? "} }" : " } }");
+		}
+		stream << "\n  ]\n}\n";
+	}
+
+	bool BenchmarkReport::SaveJson(const std::vector<BenchmarkResult>& results, const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		WriteJson(results, file);
+		return static_cast<bool>(file);
+	}
+
+	bool BenchmarkReport::LoadJson(const std::string& path, std::vector<BenchmarkResult>& results)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		std::stringstream text;
+		text << file.rdbuf();
+		const std::string json = text.str();
+
+		JsonValue root;
+		if (!JsonParser(json).Parse(root))
+		{
+			return false;
+		}
+		const JsonValue* benchmarks = root.Find("benchmarks");
+		if (!benchmarks || benchmarks->type != JsonValue::Type::Array)
+		{
+			return false;
+		}
+
+		results.clear();
+		for (const auto& item : benchmarks->items)
+		{
+			const JsonValue* name = item.Find("name");
+			if (!name || name->type != JsonValue::Type::String)
+			{
+				return false;
+			}
+
+			BenchmarkResult result;
+			result.name = name->string;
+			result.scale = static_cast<std::uint64_t>(GetNumber(item, "scale"));
+			result.iterations = static_cast<std::uint64_t>(GetNumber(item, "iterations"));
+			result.nsPerIteration = GetNumber(item, "nsPerIteration");
+			result.nsPerItem = GetNumber(item, "nsPerItem");
+			if (const JsonValue* counters = item.Find("counters"))
+			{
+				for (const auto& counter : counters->members)
+				{
+					result.counters.emplace_back(counter.first, counter.second.number);
+				}
+			}
+			results.push_back(std::move(result));
+		}
+		return true;
+	}
+
+	std::uint32_t BenchmarkReport::Compare(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current, double threshold, std::ostream& stream)
+	{
+		std::map<std::pair<std::string, std::uint64_t>, const BenchmarkResult*> baselineResults;
+		for (const auto& result : baseline)
+		{
+			baselineResults[{ result.name, result.scale }] = &result;
+		}
+
+		stream << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(12) << "Scale"
+			<< std::setw(16) << "base ns/item" << std::setw(14) << "ns/item" << std::setw(10) << "change" << "\n";
+
+		std::uint32_t regressions = 0;
+		for (const auto& result : current)
+		{
+			stream << std::left << std::setw(48) << result.name << std::right << std::setw(12) << result.scale;
+
+			auto found = baselineResults.find({ result.name, result.scale });
+			if (found == baselineResults.end() || found->second->nsPerItem <= 0)
+			{
+				stream << std::setw(16) << "-" << std::setw(14) << std::fixed << std::setprecision(3) << result.nsPerItem
+					<< std::setw(10) << "new" << "\n";
+				continue;
+			}
+
+			const double base = found->second->nsPerItem;
+			const double change = result.nsPerItem / base - 1.0;
+			stream << std::setw(16) << std::fixed << std::setprecision(3) << base << std::setw(14) << result.nsPerItem
+				<< std::setw(9) << std::showpos << std::setprecision(1) << change * 100.0 << std::noshowpos << "%";
+			if (change > threshold)
+			{
+				stream << "  slower";
+				++regressions;
+			}
+			else if (change < -threshold)
+			{
+				stream << "  faster";
+			}
+			stream << "\n";
+		}
+		return regressions;
+	}
+}
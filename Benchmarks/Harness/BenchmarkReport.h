@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Harness/BenchmarkRunner.h"
+
+namespace benchmarks
+{
+	/** Saves results as JSON and compares them against results saved by an earlier run */
+	class BenchmarkReport
+	{
+	public:
+		static void WriteJson(const std::vector<BenchmarkResult>& results, std::ostream& stream);
+		static bool SaveJson(const std::vector<BenchmarkResult>& results, const std::string& path);
+		/** Reads results written by WriteJson. Returns false if the file cannot be read or is not valid JSON */
+		static bool LoadJson(const std::string& path, std::vector<BenchmarkResult>& results);
+		/**
+		 * Prints the change in ns/item of every current result against the baseline result with the same name and scale.
+		 * Returns how many got slower by more than the threshold, which is a fraction such as 0.1 for 10%.
+		 */
+		static std::uint32_t Compare(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current, double threshold, std::ostream& stream);
+	};
+}
@@ -0,0 +1,84 @@
+#include "Harness/BenchmarkRunner.h"
+
+namespace benchmarks
+{
+	const void* volatile gBenchmarkSink = nullptr;
+
+	BenchmarkRunner::BenchmarkRunner(const std::string& filter)
+		: mFilter(filter), mLastRunSkipped(false), mChecksOnly(false)
+	{
+
+	}
+
+	bool BenchmarkRunner::IsEnabled(const std::string& name) const
+	{
+		return mFilter.empty() || name.find(mFilter) != std::string::npos;
+	}
+
+	void BenchmarkRunner::AddCounter(const std::string& name, double value)
+	{
+		if (mResults.empty() || mLastRunSkipped)
+		{
+			return;
+		}
+		mResults.back().counters.emplace_back(name, value);
+		std::cout << "  " << name << " = " << std::setprecision(3) << value << "\n";
+	}
+
+	void BenchmarkRunner::Check(const std::string& name, bool passed)
+	{
+		if (mResults.empty() || mLastRunSkipped || passed)
+		{
+			return;
+		}
+		mFailedChecks.push_back(mResults.back().name + ": " + name);
+		std::cout << "  FAILED " << name << "\n";
+	}
+
+	void BenchmarkRunner::SetChecksOnly(bool checksOnly)
+	{
+		mChecksOnly = checksOnly;
+	}
+
+	const std::vector<BenchmarkResult>& BenchmarkRunner::GetResults() const
+	{
+		return mResults;
+	}
+
+	const std::vector<std::string>& BenchmarkRunner::GetFailedChecks() const
+	{
+		return mFailedChecks;
+	}
+
+	void BenchmarkRunner::PrintTable(std::ostream& stream) const
+	{
+		stream << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(12) << "Scale"
+			<< std::setw(16) << "ns/iter" << std::setw(14) << "ns/item" << "\n";
+		for (const auto& result : mResults)
+		{
+			stream << std::left << std::setw(48) << result.name << std::right << std::setw(12) << result.scale
+				<< std::setw(16) << std::fixed << std::setprecision(1) << result.nsPerIteration
+				<< std::setw(14) << std::setprecision(3) << result.nsPerItem;
+			for (const auto& counter : result.counters)
+			{
+				stream << "  " << counter.first << "=" << counter.second;
+			}
+			stream << "\n";
+		}
+	}
+
+	void BenchmarkRunner::Record(const std::string& name, std::uint64_t scale, std::uint64_t iterations, std::vector<double>& samples)
+	{
+		std::sort(samples.begin(), samples.end());
+
+		BenchmarkResult result;
+		result.name = name;
+		result.scale = scale;
+		result.iterations = iterations;
+		result.nsPerIteration = samples[samples.size() / 2];
+		result.nsPerItem = scale > 0 ? result.nsPerIteration / scale : result.nsPerIteration;
+		mResults.push_back(result);
+
+		std::cout << name << " [" << scale << "]: " << std::fixed << std::setprecision(1) << result.nsPerIteration << " ns/iter\n";
+	}
+}
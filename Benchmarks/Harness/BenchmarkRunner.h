@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Minimal.h"
+#include <chrono>
+
+namespace benchmarks
+{
+	/** Timing of one benchmark at one scale */
+	struct BenchmarkResult
+	{
+		std::string name;
+		// Number of items processed by one iteration
+		std::uint64_t scale = 0;
+		std::uint64_t iterations = 0;
+		// Median of the samples
+		double nsPerIteration = 0;
+		double nsPerItem = 0;
+		// Extra measurements reported by the benchmark, such as cull rates
+		std::vector<std::pair<std::string, double>> counters;
+	};
+
+	/** Runs benchmarks, keeps their results and reports them */
+	class BenchmarkRunner
+	{
+	public:
+		/** Only benchmarks whose name contains the filter are run. An empty filter runs everything */
+		explicit BenchmarkRunner(const std::string& filter);
+		bool IsEnabled(const std::string& name) const;
+		/** Times func, which processes scale items per call, and records the median of several samples */
+		template<typename Func>
+		void Run(const std::string& name, std::uint64_t scale, Func&& func);
+		/** Attaches a measurement to the most recently run benchmark */
+		void AddCounter(const std::string& name, double value);
+		/** Records whether something the most recently run benchmark computed is right. Any failed check fails the run */
+		void Check(const std::string& name, bool passed);
+		/** Runs each benchmark once without sampling, for when only the checks matter */
+		void SetChecksOnly(bool checksOnly);
+		const std::vector<BenchmarkResult>& GetResults() const;
+		/** Benchmark and check names of every failed check */
+		const std::vector<std::string>& GetFailedChecks() const;
+		void PrintTable(std::ostream& stream) const;
+
+	private:
+		template<typename Func>
+		double TimeIterations(Func& func, std::uint64_t iterations) const;
+		void Record(const std::string& name, std::uint64_t scale, std::uint64_t iterations, std::vector<double>& samples);
+
+		std::string mFilter;
+		std::vector<BenchmarkResult> mResults;
+		std::vector<std::string> mFailedChecks;
+		// Counters and checks are dropped when the benchmark they follow was filtered out
+		bool mLastRunSkipped;
+		bool mChecksOnly;
+
+		static constexpr double MinSampleSeconds = 0.05;
+		static constexpr std::uint32_t SampleCount = 5;
+	};
+
+	/** Keeps the compiler from discarding results that are otherwise unused */
+	extern const void* volatile gBenchmarkSink;
+
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+		gBenchmarkSink = &value;
+	}
+
+	template<typename Func>
+	void BenchmarkRunner::Run(const std::string& name, std::uint64_t scale, Func&& func)
+	{
+		mLastRunSkipped = !IsEnabled(name);
+		if (mLastRunSkipped)
+		{
+			return;
+		}
+
+		std::vector<double> samples;
+		if (mChecksOnly)
+		{
+			samples.push_back(TimeIterations(func, 1) * 1e9);
+			Record(name, scale, 1, samples);
+			return;
+		}
+
+		// Grow the iteration count until one sample is long enough to time reliably. This also warms caches.
+		std::uint64_t iterations = 1;
+		for (;;)
+		{
+			double elapsed = TimeIterations(func, iterations);
+			if (elapsed >= MinSampleSeconds || iterations >= (1ull << 32))
+			{
+				break;
+			}
+			double growth = elapsed > 0 ? std::min(std::max(MinSampleSeconds / elapsed * 1.2, 2.0), 100.0) : 100.0;
+			iterations = static_cast<std::uint64_t>(iterations * growth);
+		}
+
+		for (std::uint32_t i = 0; i < SampleCount; ++i)
+		{
+			samples.push_back(TimeIterations(func, iterations) * 1e9 / iterations);
+		}
+		Record(name, scale, iterations, samples);
+	}
+
+	template<typename Func>
+	double BenchmarkRunner::TimeIterations(Func& func, std::uint64_t iterations) const
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (std::uint64_t i = 0; i < iterations; ++i)
+		{
+			func();
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
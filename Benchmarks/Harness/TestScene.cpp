@@ -0,0 +1,148 @@
+#include "Harness/TestScene.h"
+#include <random>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		std::shared_ptr<Material> CreateMaterial()
+		{
+			auto material = std::make_shared<Material>();
+			material->diffuse = { 0.5f, 0.5f, 0.4f, 1 };
+			material->specular = { 0.3f, 0.3f, 0.3f };
+			material->gloss = 1.0f;
+			return material;
+		}
+
+		std::shared_ptr<Entity> CreateCube(const std::shared_ptr<Material>& material, const XMFLOAT3& position, const XMFLOAT3& scale, float angle)
+		{
+			auto entity = std::make_shared<Entity>();
+			entity->material = material;
+			entity->mesh = BuiltinMeshes::Cube;
+			entity->scale = scale;
+			entity->position = position;
+			entity->rotation = { 0, 1, 0, angle };
+			return entity;
+		}
+	}
+
+	std::vector<std::shared_ptr<Entity>> TestScene::CreateEntities(size_t count, float extent, std::uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+		auto material = CreateMaterial();
+
+		std::vector<std::shared_ptr<Entity>> entities;
+		entities.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT3 p = { position(random), position(random), position(random) };
+			entities.emplace_back(CreateCube(material, p, { 1, 1, 1 }, angle(random)));
+		}
+		return entities;
+	}
+
+	std::vector<std::shared_ptr<Entity>> TestScene::CreateCityBlocks(std::uint32_t blocksX, std::uint32_t blocksZ, size_t propsPerBlock, std::uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> height(10.0f, 40.0f);
+		std::uniform_real_distribution<float> offset(0.0f, BlockSize);
+		std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+		auto material = CreateMaterial();
+		const float buildingSize = BlockSize - StreetWidth;
+
+		std::vector<std::shared_ptr<Entity>> entities;
+		entities.reserve(blocksX * blocksZ * (propsPerBlock + 1));
+		for (std::uint32_t z = 0; z < blocksZ; ++z)
+		{
+			for (std::uint32_t x = 0; x < blocksX; ++x)
+			{
+				const float blockX = x * BlockSize;
+				const float blockZ = z * BlockSize;
+				const float h = height(random);
+				XMFLOAT3 center = { blockX + BlockSize * 0.5f, h * 0.5f, blockZ + BlockSize * 0.5f };
+				entities.emplace_back(CreateCube(material, center, { buildingSize, h, buildingSize }, 0));
+
+				for (size_t i = 0; i < propsPerBlock; ++i)
+				{
+					XMFLOAT3 p = { blockX + offset(random), 0.5f, blockZ + offset(random) };
+					entities.emplace_back(CreateCube(material, p, { 1, 1, 1 }, angle(random)));
+				}
+			}
+		}
+		return entities;
+	}
+
+	MeshData TestScene::CreateSphere(std::uint32_t segments, std::uint32_t rings)
+	{
+		MeshData mesh;
+		mesh.vertices.push_back(Vertex(0, 1, 0, 0, 1, 0));
+		for (std::uint32_t ring = 1; ring < rings; ++ring)
+		{
+			const float theta = XM_PI * ring / rings;
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const float phi = XM_2PI * segment / segments;
+				const XMFLOAT3 p(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				mesh.vertices.push_back(Vertex(p.x, p.y, p.z, p.x, p.y, p.z));
+			}
+		}
+		mesh.vertices.push_back(Vertex(0, -1, 0, 0, -1, 0));
+
+		const auto south = static_cast<std::uint32_t>(mesh.vertices.size() - 1);
+		auto ringVertex = [&](std::uint32_t ring, std::uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+		auto addTriangle = [&](std::uint32_t a, std::uint32_t b, std::uint32_t c)
+		{
+			// Clockwise seen from outside, so the face normal points away from the centre
+			const XMFLOAT3& p0 = mesh.vertices[a].position;
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&mesh.vertices[b].position), XMLoadFloat3(&p0)),
+				XMVectorSubtract(XMLoadFloat3(&mesh.vertices[c].position), XMLoadFloat3(&p0)));
+			if (XMVectorGetX(XMVector3Dot(normal, XMLoadFloat3(&p0))) < 0)
+			{
+				std::swap(b, c);
+			}
+			mesh.indices.insert(mesh.indices.end(), { a, b, c });
+		};
+		for (std::uint32_t segment = 0; segment < segments; ++segment)
+		{
+			addTriangle(0, ringVertex(1, segment), ringVertex(1, segment + 1));
+			for (std::uint32_t ring = 1; ring + 1 < rings; ++ring)
+			{
+				addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1));
+				addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment + 1), ringVertex(ring, segment + 1));
+			}
+			addTriangle(south, ringVertex(rings - 1, segment + 1), ringVertex(rings - 1, segment));
+		}
+		return mesh;
+	}
+
+	MeshData TestScene::CreateTerrain(std::uint32_t side)
+	{
+		MeshData mesh;
+		for (std::uint32_t z = 0; z <= side; ++z)
+		{
+			for (std::uint32_t x = 0; x <= side; ++x)
+			{
+				const float height = std::sin(x * 0.2f) * std::cos(z * 0.3f);
+				XMFLOAT3 normal(-0.2f * std::cos(x * 0.2f) * std::cos(z * 0.3f), 1.0f, 0.3f * std::sin(x * 0.2f) * std::sin(z * 0.3f));
+				XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+				mesh.vertices.push_back(Vertex(static_cast<float>(x), height, static_cast<float>(z), normal.x, normal.y, normal.z));
+			}
+		}
+		for (std::uint32_t z = 0; z < side; ++z)
+		{
+			for (std::uint32_t x = 0; x < side; ++x)
+			{
+				const std::uint32_t corner = z * (side + 1) + x;
+				const std::uint32_t above = corner + side + 1;
+				mesh.indices.insert(mesh.indices.end(), { corner, above, above + 1, corner, above + 1, corner + 1 });
+			}
+		}
+		return mesh;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Rendering/DataTypes.h"
+#include "Scene/MeshImporter.h"
+
+namespace benchmarks
+{
+	/** Deterministic content for benchmarks */
+	class TestScene
+	{
+	public:
+		/** Cubes scattered uniformly in a box of the given half extent centred on the origin */
+		static std::vector<std::shared_ptr<renderer::Entity>> CreateEntities(size_t count, float extent, std::uint32_t seed);
+		/**
+		 * Grid of city blocks with a building in each and small props scattered at street level, which makes a
+		 * scene where most entities are hidden from a camera in the streets. Blocks are BlockSize apart from the origin.
+		 */
+		static std::vector<std::shared_ptr<renderer::Entity>> CreateCityBlocks(std::uint32_t blocksX, std::uint32_t blocksZ, size_t propsPerBlock, std::uint32_t seed);
+
+		/** Smooth sphere of radius one, clockwise seen from outside and sharing the vertices around each ring so it has no seam */
+		static renderer::MeshData CreateSphere(std::uint32_t segments, std::uint32_t rings);
+		/** Rolling square of terrain facing up with side quads on each side, whose edges are a border */
+		static renderer::MeshData CreateTerrain(std::uint32_t side);
+
+		static constexpr float BlockSize = 20.0f;
+		static constexpr float StreetWidth = 6.0f;
+	};
+}
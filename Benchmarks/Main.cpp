@@ -0,0 +1,123 @@
+// Headless benchmarks for the renderer's CPU side.
+// Usage: Benchmarks [filter] [--json <path>] [--baseline <path>] [--threshold <percent>] [--check]
+//   --json       saves the results as JSON, which can be used as a baseline by later runs
+//   --baseline   compares the results against a saved run. Exits with 1 if any benchmark got slower than the threshold
+//   --threshold  percentage change in ns/item reported as slower or faster, 10 by default
+//   --check      runs each benchmark once instead of timing it, which is enough to run every check quickly
+// Exits with 1 if any check of what a benchmark computed failed
+
+#include "Suites/Suites.h"
+#include "Harness/BenchmarkReport.h"
+
+using namespace benchmarks;
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	std::string jsonPath;
+	std::string baselinePath;
+	double threshold = 10.0;
+	bool checksOnly = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--json" && hasValue)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (arg == "--baseline" && hasValue)
+		{
+			baselinePath = argv[++i];
+		}
+		else if (arg == "--threshold" && hasValue)
+		{
+			threshold = std::atof(argv[++i]);
+		}
+		else if (arg == "--check")
+		{
+			checksOnly = true;
+		}
+		else if (arg.compare(0, 2, "--") == 0)
+		{
+			std::cerr << "Unknown or incomplete option " << arg << "\n";
+			return 2;
+		}
+		else
+		{
+			filter = arg;
+		}
+	}
+
+	if (checksOnly && !baselinePath.empty())
+	{
+		std::cerr << "--check does not time the benchmarks, so it cannot be compared with a baseline\n";
+		return 2;
+	}
+
+	// Read the baseline first so a bad path fails before minutes of benchmarks
+	std::vector<BenchmarkResult> baseline;
+	if (!baselinePath.empty() && !BenchmarkReport::LoadJson(baselinePath, baseline))
+	{
+		std::cerr << "Could not read baseline " << baselinePath << "\n";
+		return 2;
+	}
+
+	BenchmarkRunner runner(filter);
+	runner.SetChecksOnly(checksOnly);
+	RunMultiViewBenchmarks(runner);
+	RunOcclusionBenchmarks(runner);
+	RunRenderQueueBenchmarks(runner);
+	RunStateTrackerBenchmarks(runner);
+	RunProfilerBenchmarks(runner);
+	RunRenderStatsBenchmarks(runner);
+	RunCameraBenchmarks(runner);
+	RunInstanceBenchmarks(runner);
+	RunLightBenchmarks(runner);
+	RunSceneBenchmarks(runner);
+	RunFrameArenaBenchmarks(runner);
+	RunMemoryTrackerBenchmarks(runner);
+	RunOffsetAllocatorBenchmarks(runner);
+	RunStaticBatchBenchmarks(runner);
+	RunSceneFileBenchmarks(runner);
+	RunMeshImportBenchmarks(runner);
+	RunMeshSimplifyBenchmarks(runner);
+	RunMeshletBenchmarks(runner);
+	RunRayQueryBenchmarks(runner);
+	RunReferenceTracerBenchmarks(runner);
+	RunFrameCaptureBenchmarks(runner);
+	RunSceneCommandBenchmarks(runner);
+
+	std::cout << "\n";
+	runner.PrintTable(std::cout);
+
+	if (!jsonPath.empty() && !BenchmarkReport::SaveJson(runner.GetResults(), jsonPath))
+	{
+		std::cerr << "Could not write " << jsonPath << "\n";
+		return 2;
+	}
+
+	int result = 0;
+	if (!baselinePath.empty())
+	{
+		std::cout << "\nCompared with " << baselinePath << "\n";
+		std::uint32_t regressions = BenchmarkReport::Compare(baseline, runner.GetResults(), threshold / 100.0, std::cout);
+		if (regressions > 0)
+		{
+			std::cout << regressions << " benchmark(s) more than " << std::defaultfloat << threshold << "% slower\n";
+			result = 1;
+		}
+	}
+
+	const std::vector<std::string>& failedChecks = runner.GetFailedChecks();
+	if (!failedChecks.empty())
+	{
+		std::cout << "\n" << failedChecks.size() << " check(s) failed\n";
+		for (const std::string& failedCheck : failedChecks)
+		{
+			std::cout << "  " << failedCheck << "\n";
+		}
+		result = 1;
+	}
+	return result;
+}
@@ -0,0 +1,209 @@
+#include "Suites/Suites.h"
+#include "Camera/Camera.h"
+#include "Camera/CameraTrack.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		/** Sample of version 1 track files, which stored times as floats */
+		struct FloatTimeSample
+		{
+			float time;
+			XMFLOAT3 position;
+			XMFLOAT4 orientation;
+		};
+
+		/** Writes a track file by hand, with whatever sample count the header should claim */
+		template <typename Sample>
+		bool WriteTrackFile(const std::string& path, std::uint64_t sampleCount, const std::vector<Sample>& samples, std::uint32_t version = 2)
+		{
+			std::ofstream file(path, std::ios::binary);
+			file.write("CTRK", 4);
+			file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+			file.write(reinterpret_cast<const char*>(&sampleCount), sizeof(sampleCount));
+			file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(Sample));
+			return static_cast<bool>(file);
+		}
+	}
+
+	void RunCameraBenchmarks(BenchmarkRunner& runner)
+	{
+		// Many cameras rather than one so the matrices come from memory like they would for many views.
+		// A camera with its cached matrices and frustum is over half a kilobyte, so a million would not fit comfortably.
+		for (std::uint32_t count : { 1000u, 10000u, 100000u })
+		{
+			const std::string suffix = "/Cameras=" + std::to_string(count);
+			std::vector<Camera> cameras(count, Camera(XMFLOAT3(0, 2, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 2, 100), Math::Pi * 0.4f, 1280, 720, 0.1f, 1000.0f));
+
+			// Mutators only mark the cached matrices stale
+			runner.Run("Camera/Move" + suffix, count, [&]()
+			{
+				for (auto& camera : cameras)
+				{
+					camera.MoveForwardBack(0.01f);
+					camera.MoveRightLeft(0.01f);
+				}
+			});
+
+			runner.Run("Camera/Rotate" + suffix, count, [&]()
+			{
+				for (auto& camera : cameras)
+				{
+					camera.SetYaw(0.001f);
+					camera.SetPitch(0.0001f);
+				}
+			});
+
+			// A moved camera rebuilds its view matrices and frustum on the next get
+			runner.Run("Camera/MoveAndGetViewProjection" + suffix, count, [&]()
+			{
+				for (auto& camera : cameras)
+				{
+					camera.MoveForwardBack(0.01f);
+					XMMATRIX viewProjection = camera.GetViewProjection();
+					DoNotOptimize(viewProjection);
+				}
+			});
+
+			runner.Run("Camera/ResizeAndGetViewProjection" + suffix, count, [&]()
+			{
+				for (auto& camera : cameras)
+				{
+					camera.SetWidth(camera.GetWidth() == 1280 ? 1281.0f : 1280.0f);
+					XMMATRIX viewProjection = camera.GetViewProjection();
+					DoNotOptimize(viewProjection);
+				}
+			});
+
+			// Getters of an unchanged camera only load the cached matrices
+			for (auto& camera : cameras)
+			{
+				camera.UpdateCache();
+			}
+			runner.Run("Camera/GetMatrices/Cached" + suffix, count, [&]()
+			{
+				for (const auto& camera : cameras)
+				{
+					XMMATRIX view = camera.GetView();
+					XMMATRIX viewProjection = camera.GetViewProjection();
+					DoNotOptimize(view);
+					DoNotOptimize(viewProjection);
+				}
+			});
+		}
+
+		// Replay has to cost next to nothing so it does not change the runs it makes repeatable
+		if (runner.IsEnabled("CameraTrack/Replay"))
+		{
+			const std::uint32_t frameCount = 10000;
+			Camera camera(XMFLOAT3(0, 2, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 2, 100), Math::Pi * 0.4f, 1280, 720, 0.1f, 1000.0f);
+			CameraTrack track;
+			for (std::uint32_t i = 0; i < frameCount; ++i)
+			{
+				camera.MoveForwardBack(0.05f);
+				camera.SetYaw(0.002f);
+				track.Record(camera, 1.0 / 60.0);
+			}
+
+			for (double timeStep : { 0.0, 1.0 / 144.0 })
+			{
+				CameraTrackPlayer player;
+				const std::string mode = timeStep > 0 ? "Fixed144Hz" : "Recorded";
+				runner.Run("CameraTrack/Replay/" + mode, 1, [&]()
+				{
+					double frameTime = 0;
+					if (!player.Advance(camera, frameTime))
+					{
+						player.Start(&track, timeStep);
+						player.Advance(camera, frameTime);
+					}
+					DoNotOptimize(frameTime);
+				});
+			}
+			runner.AddCounter("bytes/frame", sizeof(CameraSample));
+		}
+
+		// Loading checks every sample, and turns away files that do not hold what their header says or that
+		// replaying could not follow
+		if (runner.IsEnabled("CameraTrack/Load"))
+		{
+			const std::uint32_t frameCount = 10000;
+			Camera camera(XMFLOAT3(0, 2, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 2, 100), Math::Pi * 0.4f, 1280, 720, 0.1f, 1000.0f);
+			CameraTrack track;
+			for (std::uint32_t i = 0; i < frameCount; ++i)
+			{
+				camera.MoveForwardBack(0.05f);
+				camera.SetYaw(0.002f);
+				track.Record(camera, 1.0 / 60.0);
+			}
+			const std::string path = (std::filesystem::temp_directory_path() / "benchmark.track").string();
+			track.Save(path);
+
+			CameraTrack loaded;
+			runner.Run("CameraTrack/Load/Frames=10000", frameCount, [&]()
+			{
+				loaded.Load(path);
+				DoNotOptimize(loaded);
+			});
+			runner.Check("round trip", loaded.Load(path) && loaded.GetSamples().size() == frameCount &&
+				std::memcmp(loaded.GetSamples().data(), track.GetSamples().data(), frameCount * sizeof(CameraSample)) == 0);
+
+			// Five hours in, a float time moves in steps of two milliseconds, so kilohertz frames would land on the
+			// same time and the file would not load
+			CameraTrack longTrack;
+			longTrack.Record(camera, 5 * 3600.0);
+			for (std::uint32_t i = 0; i < 1000; ++i)
+			{
+				camera.MoveForwardBack(0.05f);
+				longTrack.Record(camera, 1.0 / 1000.0);
+			}
+			runner.Check("long dense track round trip", longTrack.Save(path) && loaded.Load(path) &&
+				loaded.GetSamples().size() == longTrack.GetSamples().size() &&
+				std::memcmp(loaded.GetSamples().data(), longTrack.GetSamples().data(), longTrack.GetSamples().size() * sizeof(CameraSample)) == 0);
+
+			// Tracks recorded before times were doubles still replay
+			std::vector<FloatTimeSample> floatTimeSamples;
+			for (size_t i = 0; i < 3; ++i)
+			{
+				const CameraSample& sample = track.GetSamples()[i];
+				floatTimeSamples.push_back({ static_cast<float>(sample.time), sample.position, sample.orientation });
+			}
+			runner.Check("version 1 track loads", WriteTrackFile(path, 3, floatTimeSamples, 1) && loaded.Load(path) &&
+				loaded.GetSamples().size() == 3 && loaded.GetSamples()[2].time == floatTimeSamples[2].time);
+			// Rejected files have to leave the first track loaded
+			track.Save(path);
+			loaded.Load(path);
+
+			std::vector<CameraSample> samples(track.GetSamples().begin(), track.GetSamples().begin() + 3);
+			auto rejects = [&](std::uint64_t sampleCount, const std::vector<CameraSample>& fileSamples)
+			{
+				return WriteTrackFile(path, sampleCount, fileSamples) && !loaded.Load(path) && loaded.GetSamples().size() == frameCount;
+			};
+			runner.Check("huge count rejected", rejects(0x0fffffffffffffffull, {}));
+			runner.Check("short file rejected", rejects(4, samples));
+			runner.Check("extra samples rejected", rejects(2, samples));
+			std::vector<CameraSample> broken = samples;
+			broken[2].time = broken[1].time;
+			runner.Check("repeated time rejected", rejects(3, broken));
+			broken = samples;
+			broken[1].time = std::numeric_limits<double>::quiet_NaN();
+			runner.Check("NaN time rejected", rejects(3, broken));
+			broken = samples;
+			broken[1].orientation = { 0, 0, 0, 0 };
+			runner.Check("zero orientation rejected", rejects(3, broken));
+
+			// Orientations rounded on the way to the file come back unit length
+			broken = samples;
+			broken[1].orientation.w *= 1.0005f;
+			const bool renormalized = WriteTrackFile(path, 3, broken) && loaded.Load(path) &&
+				std::abs(XMVectorGetX(XMVector4Length(XMLoadFloat4(&loaded.GetSamples()[1].orientation))) - 1.0f) < 1e-6f;
+			runner.Check("orientations renormalized", renormalized);
+			std::filesystem::remove(path);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#include "Suites/Suites.h"
+#include "Memory/FrameArena.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunFrameArenaBenchmarks(BenchmarkRunner& runner)
+	{
+		// A frame's worth of small transient allocations, freed together
+		const std::uint32_t allocationCount = 1000;
+		std::vector<void*> pointers(allocationCount);
+		runner.Run("FrameArena/Heap/Allocations=1000", allocationCount, [&]()
+		{
+			for (std::uint32_t i = 0; i < allocationCount; ++i)
+			{
+				pointers[i] = ::operator new(16 + (i % 8) * 16);
+			}
+			DoNotOptimize(pointers);
+			for (void* pointer : pointers)
+			{
+				::operator delete(pointer);
+			}
+		});
+
+		FrameArena frameArena;
+		runner.Run("FrameArena/Arena/Allocations=1000", allocationCount, [&]()
+		{
+			frameArena.BeginFrame();
+			LinearArena& arena = frameArena.GetArena();
+			for (std::uint32_t i = 0; i < allocationCount; ++i)
+			{
+				pointers[i] = arena.Allocate(16 + (i % 8) * 16);
+			}
+			DoNotOptimize(pointers);
+		});
+
+		// Numbering materials the way the renderers do for their sort keys
+		std::vector<std::uint32_t> materials(10000);
+		for (size_t i = 0; i < materials.size(); ++i)
+		{
+			materials[i] = static_cast<std::uint32_t>((i * 7919) % 500);
+		}
+		std::unordered_map<std::uint32_t, std::uint32_t> heapIds;
+		runner.Run("FrameArena/Heap/MaterialIds=500", materials.size(), [&]()
+		{
+			heapIds.clear();
+			for (std::uint32_t material : materials)
+			{
+				heapIds.emplace(material, static_cast<std::uint32_t>(heapIds.size()));
+			}
+			DoNotOptimize(heapIds);
+		});
+
+		FrameMap<std::uint32_t, std::uint32_t> arenaIds;
+		runner.Run("FrameArena/Arena/MaterialIds=500", materials.size(), [&]()
+		{
+			frameArena.BeginFrame();
+			const size_t idCount = arenaIds.size();
+			arenaIds = FrameMap<std::uint32_t, std::uint32_t>(&frameArena.GetArena());
+			arenaIds.reserve(idCount);
+			for (std::uint32_t material : materials)
+			{
+				arenaIds.emplace(material, static_cast<std::uint32_t>(arenaIds.size()));
+			}
+			DoNotOptimize(arenaIds);
+		});
+		runner.AddCounter("arena KB", frameArena.GetPeakUsed() / 1024.0);
+	}
+}
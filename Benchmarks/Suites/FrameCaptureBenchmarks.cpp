@@ -0,0 +1,209 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Camera/Camera.h"
+#include "Capture/FrameCapture.h"
+#include "Rendering/MeshRegistry.h"
+#include "Rendering/ReferenceTracer.h"
+#include <filesystem>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		const char* GetLevelName(DeflateLevel level)
+		{
+			return level == DeflateLevel::Fast ? "Fast" : level == DeflateLevel::Default ? "Default" : "Best";
+		}
+
+		/**
+		 * Stands in for a CPU renderer: every pixel of the traced frame lit again by a light sweeping across it, so
+		 * each frame is different and costs about what a simple full screen pass does
+		 */
+		void RenderFrame(const Image& base, std::uint32_t frame, std::uint8_t* pixels)
+		{
+			const auto lightX = static_cast<std::int32_t>((frame * 97) % base.width);
+			for (std::uint32_t y = 0; y < base.height; ++y)
+			{
+				const std::uint8_t* source = base.pixels.data() + static_cast<size_t>(y) * base.width * 4;
+				std::uint8_t* destination = pixels + static_cast<size_t>(y) * base.width * 4;
+				for (std::uint32_t x = 0; x < base.width; ++x)
+				{
+					const std::int32_t distance = std::abs(static_cast<std::int32_t>(x) - lightX);
+					const std::int32_t scale = 192 + std::max(0, 256 - distance) / 4;
+					for (std::uint32_t channel = 0; channel < 3; ++channel)
+					{
+						destination[x * 4 + channel] = static_cast<std::uint8_t>(std::min(255, (source[x * 4 + channel] * scale) >> 8));
+					}
+					destination[x * 4 + 3] = 255;
+				}
+			}
+		}
+	}
+
+	void RunFrameCaptureBenchmarks(BenchmarkRunner& runner)
+	{
+		const std::vector<DeflateLevel> levels = { DeflateLevel::Fast, DeflateLevel::Default, DeflateLevel::Best };
+		const std::vector<const char*> modes = { "Off", "EveryFrame/Drop", "EveryFrame/Wait" };
+		// Tracing the frame takes a while, so it is skipped when nothing here is run
+		std::vector<std::string> names = { "Deflate/Decompress1080p", "ImageFile/EncodePpm1080p" };
+		for (DeflateLevel level : levels)
+		{
+			names.push_back(std::string("Deflate/Compress1080p/Level=") + GetLevelName(level));
+			names.push_back(std::string("ImageFile/EncodePng1080p/Level=") + GetLevelName(level));
+		}
+		for (const char* mode : modes)
+		{
+			names.push_back(std::string("FrameCapture/RenderLoop1080p/Capture=") + mode);
+		}
+		if (std::none_of(names.begin(), names.end(), [&](const std::string& name) { return runner.IsEnabled(name); }))
+		{
+			return;
+		}
+
+		// A traced full HD frame of a crowd of cubes, which has the flat background, edges and shading gradients
+		// of a real frame rather than noise or a test pattern
+		const std::uint32_t width = 1920;
+		const std::uint32_t height = 1080;
+		const float extent = 100.0f;
+		MeshRegistry meshes;
+		const std::vector<std::shared_ptr<Entity>> entities = TestScene::CreateEntities(100000, extent, 21);
+		ReferenceTracer tracer;
+		tracer.Build(entities, meshes);
+		Camera camera({ 0, 0, -extent - 20 }, { 0, 1, 0 }, { 0, 0, 0 }, XM_PIDIV4, static_cast<float>(width), static_cast<float>(height), 0.1f, 1000.0f);
+		Image base;
+		tracer.Render(camera, width, height, base);
+		std::vector<std::uint8_t> rgb;
+		ImageFile::Encode(base, ImageFormat::Ppm, rgb);
+		const std::uint64_t rgbBytes = static_cast<std::uint64_t>(width) * height * 3;
+		rgb.erase(rgb.begin(), rgb.end() - static_cast<std::ptrdiff_t>(rgbBytes));
+
+		// The colour channels as they are, without the PNG row filters
+		std::vector<std::uint8_t> compressed;
+		for (DeflateLevel level : levels)
+		{
+			const std::string name = std::string("Deflate/Compress1080p/Level=") + GetLevelName(level);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			runner.Run(name, rgbBytes, [&]()
+			{
+				compressed.clear();
+				Deflate::Compress(rgb.data(), rgb.size(), compressed, level);
+				DoNotOptimize(compressed);
+			});
+			compressed.clear();
+			Deflate::Compress(rgb.data(), rgb.size(), compressed, level);
+			runner.AddCounter("ratio", static_cast<double>(rgbBytes) / compressed.size());
+			runner.AddCounter("MBPerSecond", rgbBytes * 1e3 / runner.GetResults().back().nsPerIteration);
+		}
+		if (runner.IsEnabled("Deflate/Decompress1080p"))
+		{
+			// Decompresses the last level compressed above, or the default one if none was run
+			if (compressed.empty())
+			{
+				Deflate::Compress(rgb.data(), rgb.size(), compressed, DeflateLevel::Default);
+			}
+			std::vector<std::uint8_t> decompressed;
+			runner.Run("Deflate/Decompress1080p", rgbBytes, [&]()
+			{
+				decompressed.clear();
+				Deflate::Decompress(compressed.data(), compressed.size(), decompressed);
+				DoNotOptimize(decompressed);
+			});
+			runner.AddCounter("MBPerSecond", rgbBytes * 1e3 / runner.GetResults().back().nsPerIteration);
+			decompressed.clear();
+			runner.Check("round trip", Deflate::Decompress(compressed.data(), compressed.size(), decompressed) && decompressed == rgb);
+		}
+
+		// Whole files, read back to check they hold the same pixels
+		const std::string path = (std::filesystem::temp_directory_path() / "frame_capture.png").string();
+		std::vector<std::uint8_t> file;
+		for (DeflateLevel level : levels)
+		{
+			const std::string name = std::string("ImageFile/EncodePng1080p/Level=") + GetLevelName(level);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			runner.Run(name, static_cast<std::uint64_t>(width) * height, [&]()
+			{
+				file.clear();
+				ImageFile::Encode(base, ImageFormat::Png, file, level);
+				DoNotOptimize(file);
+			});
+			Image loaded;
+			const bool roundTrip = ImageFile::SavePng(path, base, level) && ImageFile::LoadPng(path, loaded) &&
+				ImageFile::Compare(base, loaded).sameSize && ImageFile::Compare(base, loaded).maxError == 0;
+			runner.AddCounter("MB", std::filesystem::file_size(path) / (1024.0 * 1024.0));
+			runner.Check("png round trip", roundTrip);
+		}
+		std::filesystem::remove(path);
+		runner.Run("ImageFile/EncodePpm1080p", static_cast<std::uint64_t>(width) * height, [&]()
+		{
+			file.clear();
+			ImageFile::Encode(base, ImageFormat::Ppm, file);
+			DoNotOptimize(file);
+		});
+
+		// A render loop drawing full HD frames on the CPU, without capturing and then capturing every frame to PNG.
+		// Capturing renders straight into the acquired buffer, so the render thread only pays for handing it over.
+		// Dropping keeps rendering at full speed and skips frames the encoders cannot keep up with, and waiting
+		// writes every frame at the speed of the encoders
+		const std::uint32_t framesPerRun = 30;
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "frame_capture";
+		std::filesystem::create_directories(directory);
+		std::vector<std::uint8_t> framebuffer(base.pixels.size());
+		// Time of the run without capturing, which the capturing runs are compared to when it was run
+		double uncapturedNs = 0;
+		bool uncapturedRun = false;
+		for (const char* mode : modes)
+		{
+			const std::string name = std::string("FrameCapture/RenderLoop1080p/Capture=") + mode;
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			const bool capturing = std::string(mode) != "Off";
+			FrameCaptureConfig config;
+			config.dropWhenBusy = std::string(mode) != "EveryFrame/Wait";
+			std::unique_ptr<FrameCapture> capture(capturing ? new FrameCapture(config) : nullptr);
+			std::uint32_t frame = 0;
+			runner.Run(name, framesPerRun, [&]()
+			{
+				for (std::uint32_t i = 0; i < framesPerRun; ++i, ++frame)
+				{
+					Image* image = capture ? capture->Acquire(width, height) : nullptr;
+					RenderFrame(base, frame, image ? image->pixels.data() : framebuffer.data());
+					if (image)
+					{
+						capture->Submit(image, (directory / ("frame" + std::to_string(frame % 8) + ".png")).string(), ImageFormat::Png);
+					}
+				}
+				DoNotOptimize(framebuffer);
+			});
+			const double nsPerIteration = runner.GetResults().back().nsPerIteration;
+			runner.AddCounter("fps", framesPerRun * 1e9 / nsPerIteration);
+			if (!capture)
+			{
+				uncapturedNs = nsPerIteration;
+				uncapturedRun = true;
+				continue;
+			}
+			capture->Flush();
+			const FrameCaptureStats stats = capture->GetStats();
+			const double frames = static_cast<double>(stats.submitted + stats.dropped);
+			if (uncapturedRun && uncapturedNs > 0)
+			{
+				runner.AddCounter("overhead %", (nsPerIteration / uncapturedNs - 1) * 100);
+			}
+			runner.AddCounter("written %", stats.written * 100.0 / frames);
+			runner.AddCounter("call ms per frame", stats.callMilliseconds / frames);
+			runner.AddCounter("encode ms per frame", stats.encodeMilliseconds / std::max<double>(static_cast<double>(stats.written), 1));
+			runner.AddCounter("encoder threads", capture->GetThreadCount());
+		}
+		std::filesystem::remove_all(directory);
+	}
+}
@@ -0,0 +1,52 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Rendering/InstanceBuilder.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunInstanceBenchmarks(BenchmarkRunner& runner)
+	{
+		for (size_t count : { 1000u, 10000u, 100000u, 1000000u })
+		{
+			const std::string suffix = "/Entities=" + std::to_string(count);
+			if (!runner.IsEnabled("Instances/WorldMatrices" + suffix) && !runner.IsEnabled("Instances/Build" + suffix) &&
+				!runner.IsEnabled("Instances/BuildOnArena" + suffix))
+			{
+				continue;
+			}
+			auto entities = TestScene::CreateEntities(count, 250.0f, 33);
+
+			// Just the matrix maths, as if every entity were visible
+			std::vector<MeshInstanceData> instanceData(count);
+			runner.Run("Instances/WorldMatrices" + suffix, count, [&]()
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					instanceData[i].world = XMMatrixTranspose(InstanceBuilder::CalculateWorldMatrix(*entities[i]));
+				}
+				DoNotOptimize(instanceData);
+			});
+
+			// Everything UpdateMeshInstanceBuffer does before the upload when every entity is visible in one view
+			MeshInstances instances;
+			instances.viewCount = 1;
+			instances.masks.assign(count, 1);
+			runner.Run("Instances/Build" + suffix, count, [&]()
+			{
+				InstanceBuilder::Build(entities, instances);
+				DoNotOptimize(instances);
+			});
+
+			// The same with the vectors rebuilt on a frame arena each frame, as the renderers do
+			FrameArena frameArena;
+			runner.Run("Instances/BuildOnArena" + suffix, count, [&]()
+			{
+				frameArena.BeginFrame();
+				InstanceBuilder::Build(entities, instances, &frameArena.GetArena());
+				DoNotOptimize(instances);
+			});
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#include "Suites/Suites.h"
+#include "Rendering/LightPacker.h"
+#include <random>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunLightBenchmarks(BenchmarkRunner& runner)
+	{
+		std::mt19937 random(35);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		for (size_t count : { 1000u, 10000u, 100000u, 1000000u })
+		{
+			const std::string name = "Lights/PackPointLights/Lights=" + std::to_string(count);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+
+			// The renderer caps point lights far lower, so this measures the packing loop rather than a real frame
+			std::vector<std::shared_ptr<PointLight>> lights;
+			lights.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto light = std::make_shared<PointLight>();
+				light->position = { unit(random) * 500.0f, unit(random) * 20.0f, unit(random) * 500.0f };
+				light->range = 10.0f + unit(random) * 40.0f;
+				light->attenuation = { 0, 0.2f, 0 };
+				light->diffuse = { unit(random), unit(random), unit(random) };
+				light->specular = { 1, 1, 1 };
+				lights.push_back(light);
+			}
+
+			std::vector<ShaderPointLight> packed(count);
+			runner.Run(name, count, [&]()
+			{
+				LightPacker::PackPointLights(lights, packed.data(), packed.size());
+				DoNotOptimize(packed);
+			});
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#include "Suites/Suites.h"
+#include "Memory/MemoryTracker.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunMemoryTrackerBenchmarks(BenchmarkRunner& runner)
+	{
+		// Paid by every buffer creation and every tracked container that changes size
+		MemoryTracker& tracker = MemoryTracker::Get();
+		runner.Run("MemoryTracker/AllocateFree", 1, [&]()
+		{
+			tracker.Allocate(MemoryTag::Instances, MemoryDomain::Cpu, 64);
+			tracker.Free(MemoryTag::Instances, MemoryDomain::Cpu, 64);
+		});
+
+		// Owners report their size every frame, which is a compare when it has not changed
+		TrackedMemory memory(MemoryTag::Instances);
+		memory.Set(1024);
+		runner.Run("MemoryTracker/TrackedMemory/Unchanged", 1, [&]()
+		{
+			memory.Set(1024);
+			DoNotOptimize(memory);
+		});
+
+		std::uint64_t bytes = 0;
+		runner.Run("MemoryTracker/TrackedMemory/Changed", 1, [&]()
+		{
+			memory.Set(1024 + (++bytes & 1));
+			DoNotOptimize(memory);
+		});
+	}
+}
@@ -0,0 +1,155 @@
+#include "Suites/Suites.h"
+#include "Scene/MeshImporter.h"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		/** Rolling terrain of about the given number of triangles, as a scanned or sculpted asset would be */
+		MeshData CreateTerrain(size_t triangleCount)
+		{
+			const std::uint32_t side = static_cast<std::uint32_t>(std::sqrt(triangleCount / 2.0));
+			MeshData mesh;
+			mesh.vertices.reserve(static_cast<size_t>(side + 1) * (side + 1));
+			for (std::uint32_t z = 0; z <= side; ++z)
+			{
+				for (std::uint32_t x = 0; x <= side; ++x)
+				{
+					const float height = std::sin(x * 0.05f) * std::cos(z * 0.07f);
+					XMFLOAT3 normal(-0.05f * std::cos(x * 0.05f) * std::cos(z * 0.07f), 1.0f, 0.07f * std::sin(x * 0.05f) * std::sin(z * 0.07f));
+					XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+					mesh.vertices.push_back(Vertex(x * 0.1f, height, z * 0.1f, normal.x, normal.y, normal.z));
+				}
+			}
+			mesh.indices.reserve(static_cast<size_t>(side) * side * 6);
+			for (std::uint32_t z = 0; z < side; ++z)
+			{
+				for (std::uint32_t x = 0; x < side; ++x)
+				{
+					const std::uint32_t corner = z * (side + 1) + x;
+					const std::uint32_t above = corner + side + 1;
+					mesh.indices.insert(mesh.indices.end(), { corner, above, above + 1, corner, above + 1, corner + 1 });
+				}
+			}
+			return mesh;
+		}
+
+		/**
+		 * A glTF of one triangle, three positions in an embedded buffer. The fields given are added to its buffer
+		 * view and its accessor, to make broken files from it
+		 */
+		std::string CreateTriangleGltf(std::uint64_t count, const std::string& viewFields, const std::string& accessorFields)
+		{
+			return "{ \"asset\": { \"version\": \"2.0\" },"
+				" \"buffers\": [ { \"byteLength\": 36, \"uri\": \"data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA\" } ],"
+				" \"bufferViews\": [ { \"buffer\": 0, \"byteLength\": 36" + viewFields + " } ],"
+				" \"accessors\": [ { \"bufferView\": 0, \"componentType\": 5126, \"type\": \"VEC3\", \"count\": " + std::to_string(count) + accessorFields + " } ],"
+				" \"meshes\": [ { \"primitives\": [ { \"attributes\": { \"POSITION\": 0 } } ] } ] }";
+		}
+
+		bool WriteText(const std::string& path, const std::string& text)
+		{
+			std::ofstream file(path, std::ios::binary);
+			file << text;
+			return static_cast<bool>(file);
+		}
+	}
+
+	void RunMeshImportBenchmarks(BenchmarkRunner& runner)
+	{
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::uint32_t> threadCounts = { 1, 2, 4 };
+		if (hardwareThreads > 4)
+		{
+			threadCounts.push_back(hardwareThreads);
+		}
+
+		for (size_t count : { 100000u, 10000000u })
+		{
+			const std::string suffix = "/Triangles=" + std::to_string(count);
+			auto isEnabled = [&](std::uint32_t threads)
+			{
+				return runner.IsEnabled("MeshImport/Obj/Threads=" + std::to_string(threads) + suffix);
+			};
+			if (std::none_of(threadCounts.begin(), threadCounts.end(), isEnabled))
+			{
+				continue;
+			}
+
+			const MeshData terrain = CreateTerrain(count);
+			const std::string path = (std::filesystem::temp_directory_path() / ("benchmark" + std::to_string(count) + ".obj")).string();
+			if (!MeshImporter::ExportObj(path, terrain))
+			{
+				std::cerr << "Could not write " << path << "\n";
+				return;
+			}
+			const double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+			// Warm loads from the file cache. One thread reads the file as a single chunk, which is the plain
+			// single threaded parser; more split it into chunks whose vertices are merged within each chunk only
+			MeshImporter importer;
+			MeshData mesh;
+			for (std::uint32_t threads : threadCounts)
+			{
+				importer.SetThreadCount(threads);
+				runner.Run("MeshImport/Obj/Threads=" + std::to_string(threads) + suffix, terrain.indices.size() / 3, [&]()
+				{
+					importer.Import(path, mesh);
+					DoNotOptimize(mesh);
+				});
+				runner.AddCounter("MB", megabytes);
+				runner.AddCounter("chunks", importer.GetStats().chunks);
+				runner.AddCounter("parse ms", importer.GetStats().parseMilliseconds);
+				runner.AddCounter("merge ms", importer.GetStats().mergeMilliseconds);
+				runner.AddCounter("extra vertices", static_cast<double>(importer.GetStats().vertices - terrain.vertices.size()));
+			}
+			std::filesystem::remove(path);
+		}
+
+		// Files whose buffer views and accessors lie about where their data is must be turned away, not read
+		// outside their buffers. Each one is imported once, and the one good file is timed
+		if (!runner.IsEnabled("MeshImport/Gltf/Triangle"))
+		{
+			return;
+		}
+		const std::string path = (std::filesystem::temp_directory_path() / "benchmark_triangle.gltf").string();
+		if (!WriteText(path, CreateTriangleGltf(3, "", "")))
+		{
+			std::cerr << "Could not write " << path << "\n";
+			return;
+		}
+		MeshImporter importer;
+		MeshData mesh;
+		runner.Run("MeshImport/Gltf/Triangle", 1, [&]()
+		{
+			importer.Import(path, mesh);
+			DoNotOptimize(mesh);
+		});
+		runner.Check("triangle imports", importer.Import(path, mesh) && mesh.indices.size() == 3);
+
+		struct BrokenFile
+		{
+			const char* check;
+			std::string text;
+		};
+		const std::vector<BrokenFile> brokenFiles = {
+			// A stride of 2^51 times 8192 elements wraps to zero in 64 bits
+			{ "huge stride rejected", CreateTriangleGltf(8193, ", \"byteStride\": 2251799813685248", "") },
+			{ "stride over 252 rejected", CreateTriangleGltf(3, ", \"byteStride\": 256", "") },
+			{ "stride not a multiple of 4 rejected", CreateTriangleGltf(3, ", \"byteStride\": 14", "") },
+			{ "count past the view rejected", CreateTriangleGltf(4, "", "") },
+			{ "offset past the view rejected", CreateTriangleGltf(3, "", ", \"byteOffset\": 9007199254740992") },
+			{ "view past the buffer rejected", CreateTriangleGltf(3, ", \"byteOffset\": 4", "") }
+		};
+		for (const BrokenFile& brokenFile : brokenFiles)
+		{
+			runner.Check(brokenFile.check, WriteText(path, brokenFile.text) && !importer.Import(path, mesh) && mesh.indices.empty());
+		}
+		std::filesystem::remove(path);
+	}
+}
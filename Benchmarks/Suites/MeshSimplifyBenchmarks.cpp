@@ -0,0 +1,176 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Scene/MeshSimplifier.h"
+#include <thread>
+#include <unordered_set>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		MeshData CreateCube()
+		{
+			MeshData mesh;
+			mesh.vertices.assign(Cube::vertices, Cube::vertices + Cube::numVertices);
+			mesh.indices.assign(Cube::indices, Cube::indices + Cube::numIndices);
+			return mesh;
+		}
+
+		/** Vertices on an edge with no twin going the other way */
+		std::unordered_set<std::uint32_t> FindBorderVertices(const std::vector<std::uint32_t>& indices)
+		{
+			auto key = [](std::uint32_t a, std::uint32_t b) { return (static_cast<std::uint64_t>(a) << 32) | b; };
+			std::unordered_set<std::uint64_t> edges;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					edges.insert(key(indices[i + k], indices[i + (k + 1) % 3]));
+				}
+			}
+			std::unordered_set<std::uint32_t> border;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t a = indices[i + k];
+					const std::uint32_t b = indices[i + (k + 1) % 3];
+					if (edges.count(key(b, a)) == 0)
+					{
+						border.insert(a);
+						border.insert(b);
+					}
+				}
+			}
+			return border;
+		}
+
+		/**
+		 * Adds the ratio and error of every level, and counters checking them: whether all indices are in range
+		 * without degenerate triangles, how many triangles face away from their vertex normals, and how many border
+		 * vertices were not on the border of the full mesh
+		 */
+		void AddLodCounters(BenchmarkRunner& runner, const MeshData& mesh)
+		{
+			const std::unordered_set<std::uint32_t> border = FindBorderVertices(mesh.indices);
+			bool valid = true;
+			std::uint32_t flipped = 0;
+			std::uint32_t movedBorder = 0;
+			for (size_t level = 0; level < mesh.lods.size(); ++level)
+			{
+				const MeshLod& lod = mesh.lods[level];
+				valid &= lod.indices.size() % 3 == 0;
+				for (size_t i = 0; valid && i < lod.indices.size(); i += 3)
+				{
+					const std::uint32_t a = lod.indices[i];
+					const std::uint32_t b = lod.indices[i + 1];
+					const std::uint32_t c = lod.indices[i + 2];
+					if (a >= mesh.vertices.size() || b >= mesh.vertices.size() || c >= mesh.vertices.size() || a == b || b == c || a == c)
+					{
+						valid = false;
+						break;
+					}
+					const XMVECTOR p0 = XMLoadFloat3(&mesh.vertices[a].position);
+					const XMVECTOR normal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&mesh.vertices[b].position), p0),
+						XMVectorSubtract(XMLoadFloat3(&mesh.vertices[c].position), p0));
+					const XMVECTOR vertexNormals = XMVectorAdd(XMVectorAdd(XMLoadFloat3(&mesh.vertices[a].normal),
+						XMLoadFloat3(&mesh.vertices[b].normal)), XMLoadFloat3(&mesh.vertices[c].normal));
+					flipped += XMVectorGetX(XMVector3Dot(normal, vertexNormals)) < 0 ? 1 : 0;
+				}
+				if (!valid)
+				{
+					break;
+				}
+				for (std::uint32_t vertex : FindBorderVertices(lod.indices))
+				{
+					movedBorder += border.count(vertex) == 0 ? 1 : 0;
+				}
+
+				const std::string prefix = "lod" + std::to_string(level) + " ";
+				runner.AddCounter(prefix + "ratio", static_cast<double>(lod.indices.size()) / mesh.indices.size());
+				runner.AddCounter(prefix + "error", lod.error);
+			}
+			runner.AddCounter("flipped", flipped);
+			runner.AddCounter("moved border", movedBorder);
+			runner.Check("valid triangles", valid);
+			runner.Check("no flipped triangles", flipped == 0);
+			runner.Check("border kept", movedBorder == 0);
+		}
+	}
+
+	void RunMeshSimplifyBenchmarks(BenchmarkRunner& runner)
+	{
+		// A cube has a normal per face at every corner, so nothing can collapse and every level is the full cube
+		{
+			MeshData cube = CreateCube();
+			MeshSimplifier simplifier;
+			runner.Run("MeshSimplify/Cube", 1, [&]()
+			{
+				simplifier.BuildLods(cube);
+				DoNotOptimize(cube);
+			});
+			AddLodCounters(runner, cube);
+		}
+
+		// The whole chain, each level carrying on from the one before it
+		struct Shape
+		{
+			std::string name;
+			MeshData mesh;
+		};
+		std::vector<Shape> shapes;
+		shapes.push_back({ "Sphere", TestScene::CreateSphere(256, 128) });
+		shapes.push_back({ "Terrain", TestScene::CreateTerrain(256) });
+		const std::vector<float> ratios = { 0.5f, 0.25f, 0.125f, 0.03125f };
+		for (Shape& shape : shapes)
+		{
+			const std::string name = "MeshSimplify/" + shape.name + "/Triangles=" + std::to_string(shape.mesh.indices.size() / 3);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			MeshSimplifier simplifier;
+			simplifier.SetLodRatios(ratios);
+			runner.Run(name, shape.mesh.indices.size() / 3, [&]()
+			{
+				simplifier.BuildLods(shape.mesh);
+				DoNotOptimize(shape.mesh);
+			});
+			runner.AddCounter("passes", static_cast<double>(simplifier.GetStats().passes));
+			AddLodCounters(runner, shape.mesh);
+		}
+
+		// Meshes of an import are simplified one per thread at a time
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::uint32_t> threadCounts = { 1, 2, 4 };
+		if (hardwareThreads > 4)
+		{
+			threadCounts.push_back(hardwareThreads);
+		}
+		std::vector<MeshData> meshes;
+		for (std::uint32_t i = 0; i < 16; ++i)
+		{
+			meshes.push_back(i % 2 == 0 ? TestScene::CreateSphere(64 + i * 8, 32 + i * 4) : TestScene::CreateTerrain(64 + i * 8));
+		}
+		std::vector<MeshData*> meshPointers;
+		size_t triangleCount = 0;
+		for (MeshData& mesh : meshes)
+		{
+			meshPointers.push_back(&mesh);
+			triangleCount += mesh.indices.size() / 3;
+		}
+		MeshSimplifier simplifier;
+		for (std::uint32_t threads : threadCounts)
+		{
+			simplifier.SetThreadCount(threads);
+			runner.Run("MeshSimplify/Meshes=16/Threads=" + std::to_string(threads), triangleCount, [&]()
+			{
+				simplifier.BuildLods(meshPointers);
+				DoNotOptimize(meshes);
+			});
+			runner.AddCounter("lod triangles", static_cast<double>(simplifier.GetStats().lodTriangles));
+		}
+	}
+}
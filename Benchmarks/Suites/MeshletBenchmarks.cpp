@@ -0,0 +1,188 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Camera/Camera.h"
+#include "Culling/MeshletCuller.h"
+#include <unordered_set>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		std::uint64_t TriangleKey(const std::uint32_t* triangle)
+		{
+			return static_cast<std::uint64_t>(triangle[0]) | (static_cast<std::uint64_t>(triangle[1]) << 21) |
+				(static_cast<std::uint64_t>(triangle[2]) << 42);
+		}
+
+		/**
+		 * Adds counters checking the meshlets of a mesh: whether every meshlet is within the limits and covers
+		 * exactly its own triangles, and whether the reordered indices hold the same triangles as before
+		 */
+		void AddBuildCounters(BenchmarkRunner& runner, const std::vector<std::uint32_t>& original, const std::vector<std::uint32_t>& indices,
+			const std::vector<Meshlet>& meshlets)
+		{
+			bool withinLimits = true;
+			std::uint32_t nextOffset = 0;
+			std::uint64_t vertices = 0;
+			for (const Meshlet& meshlet : meshlets)
+			{
+				std::unordered_set<std::uint32_t> unique(indices.begin() + meshlet.indexOffset,
+					indices.begin() + meshlet.indexOffset + meshlet.triangleCount * 3);
+				withinLimits &= meshlet.indexOffset == nextOffset && meshlet.triangleCount > 0 &&
+					meshlet.triangleCount <= MeshletCuller::MaxTriangles && meshlet.vertexCount <= MeshletCuller::MaxVertices &&
+					unique.size() == meshlet.vertexCount;
+				nextOffset = meshlet.indexOffset + meshlet.triangleCount * 3;
+				vertices += meshlet.vertexCount;
+			}
+			withinLimits &= nextOffset == indices.size();
+
+			std::vector<std::uint64_t> before;
+			std::vector<std::uint64_t> after;
+			for (size_t i = 0; i < original.size(); i += 3)
+			{
+				before.push_back(TriangleKey(&original[i]));
+			}
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				after.push_back(TriangleKey(&indices[i]));
+			}
+			std::sort(before.begin(), before.end());
+			std::sort(after.begin(), after.end());
+
+			runner.AddCounter("meshlets", static_cast<double>(meshlets.size()));
+			runner.AddCounter("triangles per meshlet", static_cast<double>(indices.size() / 3) / meshlets.size());
+			runner.AddCounter("vertices per meshlet", static_cast<double>(vertices) / meshlets.size());
+			runner.Check("within limits", withinLimits);
+			runner.Check("same triangles", before == after);
+		}
+
+		/**
+		 * Adds the share of triangles culled and of triangles that face away or are off screen, which the share
+		 * culled approaches as meshlets get smaller. Counts the triangles that face the camera and touch the frustum
+		 * but were culled, which must be zero
+		 */
+		void AddCullCounters(BenchmarkRunner& runner, const MeshletCuller& culler, const Camera& camera, const MeshData& mesh,
+			FXMMATRIX world, const std::vector<std::uint32_t>& output)
+		{
+			std::unordered_set<std::uint64_t> drawn;
+			for (size_t i = 0; i < output.size(); i += 3)
+			{
+				drawn.insert(TriangleKey(&output[i]));
+			}
+
+			const XMFLOAT3 position = camera.GetPosition();
+			const XMVECTOR cameraPosition = XMLoadFloat3(&position);
+			std::uint32_t hidden = 0;
+			std::uint32_t wronglyCulled = 0;
+			for (size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				XMVECTOR p[3];
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					p[k] = XMVector3Transform(XMLoadFloat3(&mesh.vertices[mesh.indices[i + k]].position), world);
+				}
+				const XMVECTOR center = XMVectorScale(XMVectorAdd(XMVectorAdd(p[0], p[1]), p[2]), 1.0f / 3);
+				float radius = 0;
+				for (const XMVECTOR& corner : p)
+				{
+					radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corner, center))));
+				}
+				XMFLOAT3 worldCenter;
+				XMStoreFloat3(&worldCenter, center);
+				const XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+				const bool visible = XMVectorGetX(XMVector3Dot(XMVectorSubtract(cameraPosition, p[0]), normal)) > 0 &&
+					camera.GetFrustum().IntersectsSphere(worldCenter, radius);
+				hidden += visible ? 0 : 1;
+				wronglyCulled += visible && drawn.count(TriangleKey(&mesh.indices[i])) == 0 ? 1 : 0;
+			}
+
+			const MeshletCullStats& stats = culler.GetStats();
+			runner.AddCounter("frustum culled", static_cast<double>(stats.frustumCulled));
+			runner.AddCounter("backface culled", static_cast<double>(stats.backfaceCulled));
+			runner.AddCounter("triangles culled", static_cast<double>(stats.trianglesCulled) / stats.triangles);
+			runner.AddCounter("triangles hidden", static_cast<double>(hidden) / (mesh.indices.size() / 3));
+			runner.AddCounter("wrongly culled", wronglyCulled);
+			runner.Check("no visible triangle culled", wronglyCulled == 0);
+		}
+	}
+
+	void RunMeshletBenchmarks(BenchmarkRunner& runner)
+	{
+		struct Shape
+		{
+			std::string name;
+			MeshData mesh;
+			std::vector<Meshlet> meshlets;
+		};
+		std::vector<Shape> shapes;
+		shapes.push_back({ "Sphere", TestScene::CreateSphere(256, 128), {} });
+		shapes.push_back({ "Terrain", TestScene::CreateTerrain(256), {} });
+		for (Shape& shape : shapes)
+		{
+			const std::vector<std::uint32_t> original = shape.mesh.indices;
+			const std::string name = "Meshlet/Build/" + shape.name + "/Triangles=" + std::to_string(original.size() / 3);
+			runner.Run(name, original.size() / 3, [&]()
+			{
+				shape.mesh.indices = original;
+				MeshletCuller::Build(shape.mesh.vertices.data(), static_cast<std::uint32_t>(shape.mesh.vertices.size()), shape.mesh.indices,
+					shape.meshlets);
+				DoNotOptimize(shape.meshlets);
+			});
+			if (shape.meshlets.empty())
+			{
+				shape.mesh.indices = original;
+				MeshletCuller::Build(shape.mesh.vertices.data(), static_cast<std::uint32_t>(shape.mesh.vertices.size()), shape.mesh.indices,
+					shape.meshlets);
+			}
+			else
+			{
+				AddBuildCounters(runner, original, shape.mesh.indices, shape.meshlets);
+			}
+		}
+		const Shape& sphere = shapes[0];
+		const Shape& terrain = shapes[1];
+
+		// Known views: about half of a sphere faces away from a camera outside it, terrain seen from below faces
+		// away everywhere, and a camera looking along the terrain's edge leaves half of it off screen. Stretched
+		// and mirrored instances must keep every triangle the rasterizer would draw
+		struct View
+		{
+			std::string name;
+			const Shape* shape;
+			XMFLOAT3 position;
+			XMFLOAT3 target;
+			XMMATRIX world;
+		};
+		const std::vector<View> views = {
+			{ "Sphere", &sphere, { 0, 0, -4 }, { 0, 0, 0 }, XMMatrixIdentity() },
+			{ "SphereStretched", &sphere, { 1, 2, -6 }, { 0, 0, 0 },
+				XMMatrixScaling(3, 1, 0.5f) * XMMatrixRotationX(0.3f) * XMMatrixRotationY(0.8f) },
+			{ "SphereMirrored", &sphere, { 0, 0, -4 }, { 0, 0, 0 }, XMMatrixScaling(-1, 1, 1) },
+			{ "TerrainBelow", &terrain, { 128, -200, 128 }, { 128, 0, 128 }, XMMatrixIdentity() },
+			{ "TerrainEdge", &terrain, { 0, 40, -60 }, { 0, 0, 128 }, XMMatrixIdentity() },
+		};
+		MeshletCuller culler;
+		std::vector<std::uint32_t> output;
+		for (const View& view : views)
+		{
+			const std::string name = "Meshlet/Cull/" + view.name;
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			Camera camera(view.position, { 0, 1, 0 }, view.target, XM_PIDIV4, 1280, 720, 0.1f, 1000.0f);
+			const std::vector<Meshlet>& meshlets = view.shape->meshlets;
+			const std::vector<std::uint32_t>& indices = view.shape->mesh.indices;
+			runner.Run(name, meshlets.size(), [&]()
+			{
+				output.clear();
+				culler.Begin(camera);
+				culler.Cull(meshlets.data(), static_cast<std::uint32_t>(meshlets.size()), indices.data(), view.world, output);
+				DoNotOptimize(output);
+			});
+			AddCullCounters(runner, culler, camera, view.shape->mesh, view.world, output);
+		}
+	}
+}
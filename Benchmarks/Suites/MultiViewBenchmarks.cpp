@@ -0,0 +1,72 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Camera/Camera.h"
+#include "Rendering/InstanceBuilder.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		// Cameras at the origin spread evenly around the up axis, like cubemap faces or split screen players
+		std::vector<std::unique_ptr<Camera>> CreateCameras(std::uint32_t count)
+		{
+			std::vector<std::unique_ptr<Camera>> cameras;
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				auto camera = std::make_unique<Camera>(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 100), Math::Pi * 0.5f, 512, 512, 0.1f, 500.0f);
+				camera->SetYaw(Math::Pi * 2.0f * i / count);
+				cameras.push_back(std::move(camera));
+			}
+			return cameras;
+		}
+	}
+
+	void RunMultiViewBenchmarks(BenchmarkRunner& runner)
+	{
+		const size_t entityCount = 100000;
+		auto entities = TestScene::CreateEntities(entityCount, 250.0f, 27);
+		const float radius = Cube::boundingRadius;
+
+		for (std::uint32_t viewCount : { 1u, 2u, 4u, 8u, 16u, 32u })
+		{
+			auto cameras = CreateCameras(viewCount);
+			std::vector<Frustum> frustums;
+			for (const auto& camera : cameras)
+			{
+				frustums.push_back(camera->GetFrustum());
+			}
+
+			// All views culled in one pass with the instance data built once
+			{
+				ViewCuller culler;
+				culler.SetViews(frustums.data(), viewCount);
+				MeshInstances instances;
+				runner.Run("MultiView/Shared/Views=" + std::to_string(viewCount), entityCount, [&]()
+				{
+					InstanceBuilder::Build(entities, radius, culler, instances);
+					DoNotOptimize(instances);
+				});
+			}
+
+			// Reference: each view culls the scene and builds its own instance data
+			{
+				std::vector<ViewCuller> cullers(viewCount);
+				for (std::uint32_t v = 0; v < viewCount; ++v)
+				{
+					cullers[v].SetViews(&frustums[v], 1);
+				}
+				MeshInstances instances;
+				runner.Run("MultiView/PerView/Views=" + std::to_string(viewCount), entityCount, [&]()
+				{
+					for (const auto& culler : cullers)
+					{
+						InstanceBuilder::Build(entities, radius, culler, instances);
+						DoNotOptimize(instances);
+					}
+				});
+			}
+		}
+	}
+}
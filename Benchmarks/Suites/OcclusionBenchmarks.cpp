@@ -0,0 +1,96 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Camera/Camera.h"
+#include "Culling/OcclusionCuller.h"
+#include "Rendering/InstanceBuilder.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		void RunOcclusionPass(OcclusionCuller& occlusionCuller, const Camera& camera, const std::vector<std::shared_ptr<Entity>>& entities,
+			const MeshInstances& frustumCulled, std::vector<ViewMask>& masks)
+		{
+			const auto& bounds = frustumCulled.bounds;
+			masks = frustumCulled.masks;
+
+			occlusionCuller.Begin(camera);
+			for (size_t i = 0; i < entities.size(); ++i)
+			{
+				if (masks[i])
+				{
+					occlusionCuller.AddOccluderCandidate(entities[i].get(), XMFLOAT3(bounds.x[i], bounds.y[i], bounds.z[i]), bounds.radius[i]);
+				}
+			}
+			occlusionCuller.RasterizeOccluders();
+			occlusionCuller.Cull(bounds, 1, masks.data());
+		}
+	}
+
+	void RunOcclusionBenchmarks(BenchmarkRunner& runner)
+	{
+		const size_t propsPerBlock = 40;
+		const float radius = Cube::boundingRadius;
+
+		for (std::uint32_t blocks : { 8u, 16u, 32u })
+		{
+			const std::string name = "Occlusion/CityBlocks/Blocks=" + std::to_string(blocks * blocks);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+
+			auto entities = TestScene::CreateCityBlocks(blocks, blocks, propsPerBlock, 28);
+
+			// Standing in a street near the edge of the city and looking slightly across the blocks
+			const float street = (blocks / 2) * TestScene::BlockSize;
+			Camera camera(XMFLOAT3(street, 1.8f, -5.0f), XMFLOAT3(0, 1, 0), XMFLOAT3(street + 150.0f, 1.8f, 1000.0f), Math::Pi * 0.4f, 1920, 1080, 0.5f, 2000.0f);
+
+			Frustum frustum = camera.GetFrustum();
+			ViewCuller viewCuller;
+			viewCuller.SetViews(&frustum, 1);
+			MeshInstances frustumCulled;
+			InstanceBuilder::Cull(entities, radius, viewCuller, frustumCulled);
+
+			OcclusionCuller occlusionCuller;
+			std::vector<ViewMask> masks;
+			runner.Run(name, entities.size(), [&]()
+			{
+				RunOcclusionPass(occlusionCuller, camera, entities, frustumCulled, masks);
+				DoNotOptimize(masks);
+			});
+
+			// Compare the conservative sphere tests with depth testing every pixel of each cube
+			RunOcclusionPass(occlusionCuller, camera, entities, frustumCulled, masks);
+			size_t falsePositives = 0;
+			size_t wronglyCulled = 0;
+			for (size_t i = 0; i < entities.size(); ++i)
+			{
+				if (!frustumCulled.masks[i])
+				{
+					continue;
+				}
+				bool visible = occlusionCuller.IsCubeVisibleExact(*entities[i]);
+				if (masks[i] && !visible)
+				{
+					++falsePositives;
+				}
+				else if (!masks[i] && visible)
+				{
+					++wronglyCulled;
+				}
+			}
+
+			const OcclusionStats& stats = occlusionCuller.GetStats();
+			runner.AddCounter("occluders", stats.occluders);
+			runner.AddCounter("tested", stats.tested);
+			runner.AddCounter("cullRate", stats.GetCullRate());
+			runner.AddCounter("falsePositiveRate", stats.tested > 0 ? static_cast<double>(falsePositives) / stats.tested : 0.0);
+			runner.AddCounter("wronglyCulled", static_cast<double>(wronglyCulled));
+			runner.AddCounter("passMicroseconds", stats.passMicroseconds);
+			runner.Check("no visible entity culled", wronglyCulled == 0);
+		}
+	}
+}
@@ -0,0 +1,236 @@
+#include "Suites/Suites.h"
+#include "Memory/OffsetAllocator.h"
+#include "Memory/BufferSubAllocator.h"
+#include <random>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		// Mesh sized ranges, mostly small with a few big ones
+		std::uint32_t RandomSize(std::mt19937& random)
+		{
+			return (random() % 8 == 0) ? 1024 + random() % 16384 : 1 + random() % 1024;
+		}
+
+		/** Whether every allocation is valid and inside the space, with none overlapping another */
+		bool AreDisjoint(const OffsetAllocator& allocator, std::vector<OffsetAllocation> allocations)
+		{
+			std::sort(allocations.begin(), allocations.end(), [](const OffsetAllocation& a, const OffsetAllocation& b)
+			{
+				return a.offset < b.offset;
+			});
+			std::uint64_t end = 0;
+			for (const OffsetAllocation& allocation : allocations)
+			{
+				if (!allocation.IsValid() || allocation.offset < end)
+				{
+					return false;
+				}
+				end = static_cast<std::uint64_t>(allocation.offset) + allocator.GetAllocationSize(allocation);
+			}
+			return end <= allocator.GetSize();
+		}
+
+		/** Whether the allocations follow each other from offset zero with no gaps */
+		bool IsPacked(const OffsetAllocator& allocator, std::vector<OffsetAllocation> allocations)
+		{
+			std::sort(allocations.begin(), allocations.end(), [](const OffsetAllocation& a, const OffsetAllocation& b)
+			{
+				return a.offset < b.offset;
+			});
+			std::uint32_t end = 0;
+			for (const OffsetAllocation& allocation : allocations)
+			{
+				if (allocation.offset != end)
+				{
+					return false;
+				}
+				end += allocator.GetAllocationSize(allocation);
+			}
+			return true;
+		}
+
+		/** Whether everything was freed and merged back into the one range the space started as */
+		bool IsEmpty(const OffsetAllocator& allocator)
+		{
+			const OffsetAllocatorStats stats = allocator.GetStats();
+			return stats.allocations == 0 && stats.freeRegions == 1 && stats.freeSpace == allocator.GetSize();
+		}
+
+		/** Frees every other block before the rest, so the second half merges on both sides */
+		void FreeAlternately(OffsetAllocator& allocator, const std::vector<OffsetAllocation>& blocks)
+		{
+			for (size_t i = 0; i < blocks.size(); i += 2)
+			{
+				allocator.Free(blocks[i]);
+			}
+			for (size_t i = 1; i < blocks.size(); i += 2)
+			{
+				allocator.Free(blocks[i]);
+			}
+		}
+	}
+
+	void RunOffsetAllocatorBenchmarks(BenchmarkRunner& runner)
+	{
+		// A mega buffer in steady state: meshes are streamed out and in while about half the space is in use
+		const std::uint32_t liveCount = 10000;
+		const std::uint32_t size = 64 * 1024 * 1024;
+		OffsetAllocator allocator(size);
+		std::mt19937 random(17);
+		std::vector<OffsetAllocation> live(liveCount);
+		for (auto& allocation : live)
+		{
+			allocation = allocator.Allocate(RandomSize(random));
+		}
+		std::uint64_t failed = 0;
+		runner.Run("OffsetAllocator/FreeAllocate/Live=10000", 1, [&]()
+		{
+			OffsetAllocation& allocation = live[random() % liveCount];
+			allocator.Free(allocation);
+			allocation = allocator.Allocate(RandomSize(random));
+			failed += allocation.IsValid() ? 0 : 1;
+		});
+		runner.AddCounter("failed", static_cast<double>(failed));
+		runner.Check("every allocation succeeded", failed == 0);
+		runner.Check("live ranges disjoint", AreDisjoint(allocator, live));
+
+		// How fragmented the churn above left the space. Merging on free should keep the largest region big
+		const OffsetAllocatorStats stats = allocator.GetStats();
+		runner.Run("OffsetAllocator/Stats/Live=10000", 1, [&]()
+		{
+			DoNotOptimize(allocator.GetStats());
+		});
+		runner.AddCounter("free regions", stats.freeRegions);
+		runner.AddCounter("largest free %", 100.0 * stats.largestFreeRegion / std::max<std::uint32_t>(stats.freeSpace, 1));
+
+		// The churned space is packed once, following the moves the way a buffer sub-allocator would, before timing
+		// packing again. Each move must land where the next allocation starts, below where it was
+		std::vector<size_t> liveIndices;
+		for (size_t i = 0; i < live.size(); ++i)
+		{
+			liveIndices.resize(std::max<size_t>(liveIndices.size(), live[i].node + 1));
+			liveIndices[live[i].node] = i;
+		}
+		std::uint64_t usedSpace = 0;
+		for (const OffsetAllocation& allocation : live)
+		{
+			usedSpace += allocator.GetAllocationSize(allocation);
+		}
+		bool movedDown = true;
+		const bool compacted = allocator.Compact(0, [&](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count)
+		{
+			movedDown = movedDown && to.IsValid() && to.offset <= from.offset;
+			live[liveIndices[from.node]] = to;
+		});
+		const bool packed = compacted && movedDown && AreDisjoint(allocator, live) && IsPacked(allocator, live) &&
+			allocator.GetStats().freeRegions == 1 && allocator.GetStats().freeSpace == size - usedSpace;
+
+		// Packing moves every allocation, so the cost is one visit and one callback per live range
+		std::uint64_t movedBytes = 0;
+		runner.Run("OffsetAllocator/Compact/Live=10000", liveCount, [&]()
+		{
+			allocator.Compact(0, [&](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count)
+			{
+				movedBytes += from.offset - to.offset;
+			});
+		});
+		DoNotOptimize(movedBytes);
+		runner.AddCounter("free regions after", allocator.GetStats().freeRegions);
+		runner.Check("packed", packed);
+
+		// Shrinking to exactly the space in use fits even where allocating those sizes again would round up past it,
+		// and shrinking below it fails without moving or changing anything
+		{
+			OffsetAllocator shrinking(2000);
+			const OffsetAllocation small = shrinking.Allocate(10);
+			const OffsetAllocation large = shrinking.Allocate(1000);
+			std::vector<OffsetAllocation> moved;
+			const bool exact = shrinking.Compact(1010, [&](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count)
+			{
+				moved.push_back(to);
+			});
+			runner.Check("shrinks to the space in use", exact && small.IsValid() && large.IsValid() && moved.size() == 2 &&
+				moved[0].offset == 0 && moved[1].offset == 10 && shrinking.GetSize() == 1010 && shrinking.GetStats().freeSpace == 0);
+
+			bool calledBack = false;
+			const bool tooSmall = shrinking.Compact(1009, [&](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count)
+			{
+				calledBack = true;
+			});
+			runner.Check("shrinking too far changes nothing", !tooSmall && !calledBack && shrinking.GetSize() == 1010 &&
+				AreDisjoint(shrinking, moved) && IsPacked(shrinking, moved) && shrinking.GetStats().allocations == 2);
+
+			// Growing leaves the allocations where they are and frees the new space as one range
+			const bool grown = shrinking.Compact(4096, [](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count) {});
+			runner.Check("grows", grown && shrinking.GetSize() == 4096 && shrinking.GetStats().freeRegions == 1 &&
+				shrinking.GetStats().freeSpace == 4096 - 1010 && shrinking.Allocate(3000).IsValid());
+		}
+
+		// Filling a space with blocks of a size that is exactly a bin's, then freeing them out of order. The blocks
+		// use every byte, and freeing merges them back into one range
+		const std::uint32_t blockCount = 64;
+		const std::uint32_t blockSize = 256;
+		OffsetAllocator blockSpace(blockCount * blockSize);
+		std::vector<OffsetAllocation> blocks(blockCount);
+		runner.Run("OffsetAllocator/FillAndFree/Blocks=64", blockCount, [&]()
+		{
+			for (auto& block : blocks)
+			{
+				block = blockSpace.Allocate(blockSize);
+			}
+			DoNotOptimize(blocks);
+			FreeAlternately(blockSpace, blocks);
+		});
+		{
+			OffsetAllocator filling(blockCount * blockSize);
+			std::vector<OffsetAllocation> filled(blockCount);
+			for (auto& block : filled)
+			{
+				block = filling.Allocate(blockSize);
+			}
+			runner.Check("blocks fill the space", AreDisjoint(filling, filled) && IsPacked(filling, filled) &&
+				filling.GetStats().freeSpace == 0 && !filling.Allocate(1).IsValid());
+			FreeAlternately(filling, filled);
+			runner.Check("freed blocks merge", IsEmpty(filling) && IsEmpty(blockSpace));
+			runner.Check("whole space allocates", filling.Allocate(blockCount * blockSize).offset == 0);
+
+			// Running out of nodes fails cleanly. One node is kept back and one holds the rest of the space
+			const std::uint32_t maxAllocations = 16;
+			OffsetAllocator limited(1024 * 1024, maxAllocations);
+			std::vector<OffsetAllocation> allocations;
+			for (OffsetAllocation allocation = limited.Allocate(1); allocation.IsValid(); allocation = limited.Allocate(1))
+			{
+				allocations.push_back(allocation);
+			}
+			const bool exhausted = allocations.size() == maxAllocations - 2 && AreDisjoint(limited, allocations);
+			limited.Free(allocations.back());
+			allocations.back() = limited.Allocate(1);
+			const bool reused = allocations.back().IsValid() && AreDisjoint(limited, allocations);
+			for (const OffsetAllocation& allocation : allocations)
+			{
+				limited.Free(allocation);
+			}
+			runner.Check("node exhaustion fails cleanly", exhausted && reused && IsEmpty(limited));
+		}
+
+		// Growing a shared buffer range by range from its creation, as loading a level would
+		runner.Run("BufferSubAllocator/Grow/Ranges=1000", 1000, [&]()
+		{
+			std::uint32_t resizes = 0;
+			BufferSubAllocator ranges(4096, [&](std::uint32_t capacity, const std::vector<BufferRelocation>& moves)
+			{
+				++resizes;
+			});
+			std::mt19937 sizes(23);
+			for (std::uint32_t i = 0; i < 1000; ++i)
+			{
+				DoNotOptimize(ranges.Allocate(RandomSize(sizes)));
+			}
+			DoNotOptimize(resizes);
+		});
+	}
+}
@@ -0,0 +1,105 @@
+#include "Suites/Suites.h"
+#include "Profiling/Profiler.h"
+#include <cstring>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunProfilerBenchmarks(BenchmarkRunner& runner)
+	{
+		// Cost of one zone including both timestamps and the ring buffer write
+		runner.Run("Profiler/Zone", 1, [&]()
+		{
+			ProfileZone zone("Benchmark");
+		});
+
+		runner.Run("Profiler/NestedZones/Depth=4", 4, [&]()
+		{
+			ProfileZone zone0("Level0");
+			{
+				ProfileZone zone1("Level1");
+				{
+					ProfileZone zone2("Level2");
+					{
+						ProfileZone zone3("Level3");
+					}
+				}
+			}
+		});
+
+		// Fill a second thread's timeline so the capture covers several threads
+		if (runner.IsEnabled("Profiler/CaptureAndExport"))
+		{
+			std::thread worker([]()
+			{
+				Profiler::SetThreadName("Benchmark worker");
+				for (std::uint32_t i = 0; i < ThreadProfile::Capacity; ++i)
+				{
+					ProfileZone zone("Worker");
+				}
+			});
+			worker.join();
+
+			std::ostringstream stream;
+			size_t eventCount = 0;
+			runner.Run("Profiler/CaptureAndExport", 1, [&]()
+			{
+				ProfileCapture capture = Profiler::Capture();
+				eventCount = 0;
+				for (const auto& thread : capture.threads)
+				{
+					eventCount += thread.events.size();
+				}
+				stream.str("");
+				Profiler::WriteChromeTrace(capture, stream);
+				DoNotOptimize(stream);
+			});
+			runner.AddCounter("events", static_cast<double>(eventCount));
+			runner.AddCounter("megabytes", stream.str().size() / 1e6);
+
+			// Short lived workers one after another take over the ring of the one before, so memory stays bounded
+			const size_t threadCount = Profiler::Capture().threads.size();
+			for (std::uint32_t i = 0; i < 64; ++i)
+			{
+				std::thread([]()
+				{
+					ProfileZone zone("Short lived");
+				}).join();
+			}
+			runner.Check("exited threads' rings reused", Profiler::Capture().threads.size() <= threadCount + 1);
+
+			// Capturing while a thread wraps its ring only returns events that were complete
+			std::atomic<bool> recording = true;
+			std::thread writer([&]()
+			{
+				Profiler::SetThreadName("Racing writer");
+				while (recording.load(std::memory_order_relaxed))
+				{
+					ProfileZone zone("Racing");
+				}
+			});
+			bool complete = true;
+			for (std::uint32_t i = 0; i < 20; ++i)
+			{
+				for (const auto& thread : Profiler::Capture().threads)
+				{
+					if (thread.threadName != "Racing writer")
+					{
+						continue;
+					}
+					for (size_t j = 0; j < thread.events.size(); ++j)
+					{
+						const ProfileEvent& event = thread.events[j];
+						complete = complete && std::strcmp(event.name, "Racing") == 0 && event.end >= event.start && event.depth == 0 &&
+							(j == 0 || event.end >= thread.events[j - 1].end);
+					}
+				}
+			}
+			recording = false;
+			writer.join();
+			runner.Check("captured events complete", complete);
+		}
+	}
+}
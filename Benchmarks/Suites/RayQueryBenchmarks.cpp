@@ -0,0 +1,270 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Rendering/MeshRegistry.h"
+#include "Scene/RayQuery.h"
+#include <random>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		std::shared_ptr<Entity> CreateEntity(MeshHandle mesh, const XMFLOAT3& position, const XMFLOAT3& scale, const XMFLOAT4& rotation = { 0, 1, 0, 0 })
+		{
+			auto entity = std::make_shared<Entity>();
+			entity->mesh = mesh;
+			entity->position = position;
+			entity->scale = scale;
+			entity->rotation = rotation;
+			return entity;
+		}
+
+		/** A ray at a shape with the hit worked out by hand, or no hit */
+		struct KnownRay
+		{
+			Ray ray;
+			bool hits;
+			float distance;
+			XMFLOAT3 normal;
+		};
+
+		/**
+		 * Primary rays through a width by height grid in front of a camera, ordered in two by two tiles so every
+		 * packet covers neighbouring pixels
+		 */
+		std::vector<Ray> CreateCameraRays(const XMFLOAT3& origin, std::uint32_t width, std::uint32_t height, float fov)
+		{
+			std::vector<Ray> rays;
+			rays.reserve(width * height);
+			const float extent = std::tan(fov * 0.5f);
+			for (std::uint32_t tileY = 0; tileY < height; tileY += 2)
+			{
+				for (std::uint32_t tileX = 0; tileX < width; tileX += 2)
+				{
+					for (std::uint32_t pixel = 0; pixel < 4; ++pixel)
+					{
+						const float x = ((tileX + (pixel & 1) + 0.5f) / width * 2 - 1) * extent;
+						const float y = ((tileY + (pixel >> 1) + 0.5f) / height * 2 - 1) * extent;
+						Ray ray;
+						ray.origin = origin;
+						XMStoreFloat3(&ray.direction, XMVector3Normalize(XMVectorSet(x, y, 1, 0)));
+						rays.push_back(ray);
+					}
+				}
+			}
+			return rays;
+		}
+
+		/** Rays from random points in random directions, so packets rarely stay together */
+		std::vector<Ray> CreateRandomRays(size_t count, float extent, std::uint32_t seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-extent, extent);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::vector<Ray> rays(count);
+			for (Ray& ray : rays)
+			{
+				ray.origin = { position(random), position(random), position(random) };
+				XMVECTOR direction;
+				do
+				{
+					direction = XMVectorSet(unit(random), unit(random), unit(random), 0);
+				} while (XMVectorGetX(XMVector3LengthSq(direction)) < 0.01f);
+				XMStoreFloat3(&ray.direction, XMVector3Normalize(direction));
+			}
+			return rays;
+		}
+
+		/** Segments between random pairs of points, a direction of the whole segment and a max distance of one */
+		std::vector<Ray> CreateSightLines(size_t count, float extent, std::uint32_t seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-extent, extent);
+			std::vector<Ray> rays(count);
+			for (Ray& ray : rays)
+			{
+				ray.origin = { position(random), position(random), position(random) };
+				const XMFLOAT3 target = { position(random), position(random), position(random) };
+				ray.direction = { target.x - ray.origin.x, target.y - ray.origin.y, target.z - ray.origin.z };
+				ray.maxDistance = 1;
+			}
+			return rays;
+		}
+
+		/**
+		 * Casts the first rays at every entity one by one and counts those whose hit the hierarchy got wrong.
+		 * Closest hits may name a different entity at the same distance, and any hits only have to agree on whether
+		 * something was hit
+		 */
+		std::uint32_t CountMismatches(const std::vector<std::shared_ptr<Entity>>& entities, const MeshRegistry& meshes, const std::vector<Ray>& rays,
+			const std::vector<RayHit>& hits, size_t count, RayQueryMode mode)
+		{
+			std::uint32_t mismatches = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				RayHit best;
+				best.distance = FLT_MAX;
+				for (const auto& entity : entities)
+				{
+					RayHit hit;
+					if (RayQuery::IntersectEntity(*entity, meshes, rays[i], hit) && hit.distance < best.distance)
+					{
+						best = hit;
+					}
+				}
+				if (mode == RayQueryMode::Any)
+				{
+					mismatches += (best.entity != nullptr) != (hits[i].entity != nullptr) ? 1 : 0;
+				}
+				else if (best.entity != hits[i].entity && (!best.entity || !hits[i].entity ||
+					std::abs(best.distance - hits[i].distance) > 1e-4f * std::max(1.0f, best.distance)))
+				{
+					++mismatches;
+				}
+			}
+			return mismatches;
+		}
+	}
+
+	void RunRayQueryBenchmarks(BenchmarkRunner& runner)
+	{
+		MeshRegistry meshes;
+		MeshData sphereMesh = TestScene::CreateSphere(64, 32);
+		const MeshHandle sphere = meshes.Register(sphereMesh.vertices, sphereMesh.indices);
+
+		// One shape of every kind, each hit head on so the distance and normal are known
+		{
+			const float side = std::sqrt(0.5f);
+			std::vector<std::shared_ptr<Entity>> shapes = {
+				CreateEntity(BuiltinMeshes::Cube, { 0, 0, 0 }, { 1, 1, 1 }, { 0, 1, 0, 45 }),
+				CreateEntity(BuiltinMeshes::Sphere, { 10, 0, 0 }, { 2, 2, 2 }),
+				CreateEntity(BuiltinMeshes::Sphere, { 20, 0, 0 }, { 4, 1, 1 }),
+				CreateEntity(BuiltinMeshes::Cone, { 30, 0, 0 }, { 2, 2, 2 }),
+				CreateEntity(sphere, { 40, 0, 0 }, { 1, 1, 1 }),
+			};
+			auto ray = [](const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance = FLT_MAX)
+			{
+				Ray result;
+				result.origin = origin;
+				result.direction = direction;
+				result.maxDistance = maxDistance;
+				return result;
+			};
+			const std::vector<KnownRay> known = {
+				// Across the front edge of the turned cube, onto the face on the right of it
+				{ ray({ 0.1f, 0, -5 }, { 0, 0, 1 }), true, 5 + 0.1f - side, { side, 0, -side } },
+				{ ray({ 10, 0, -5 }, { 0, 0, 1 }), true, 4, { 0, 0, -1 } },
+				// Stretched to a radius of two along x
+				{ ray({ 12, 0, 0 }, { 1, 0, 0 }), true, 6, { -1, 0, 0 } },
+				// Halfway up the cone its radius is a quarter of its base
+				{ ray({ 30, 0, -5 }, { 0, 0, 1 }), true, 4.5f, { 0, 1 / std::sqrt(5.0f), -2 / std::sqrt(5.0f) } },
+				{ ray({ 30, -5, 0 }, { 0, 1, 0 }), true, 4, { 0, -1, 0 } },
+				// The mesh sphere has a vertex where the ray meets it
+				{ ray({ 40, 0, -5 }, { 0, 0, 1 }), true, 4, { 0, 0, -1 } },
+				{ ray({ 10, 0, -5 }, { 0, 0, 1 }, 3), false, 0, { 0, 0, 0 } },
+				{ ray({ 50, 0, -5 }, { 0, 0, 1 }), false, 0, { 0, 0, 0 } },
+			};
+			RayQuery query;
+			query.SetThreadCount(1);
+			query.Build(shapes, meshes);
+			std::vector<Ray> rays;
+			for (const KnownRay& knownRay : known)
+			{
+				rays.push_back(knownRay.ray);
+			}
+			std::vector<RayHit> hits(rays.size());
+			runner.Run("RayQuery/KnownShapes", rays.size(), [&]()
+			{
+				query.Intersect(rays.data(), rays.size(), hits.data());
+				DoNotOptimize(hits);
+			});
+			std::uint32_t correct = 0;
+			for (size_t i = 0; i < known.size(); ++i)
+			{
+				const KnownRay& expected = known[i];
+				const RayHit& hit = hits[i];
+				const float normalDot = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&hit.normal), XMLoadFloat3(&expected.normal)));
+				correct += expected.hits ? (hit.entity != nullptr && std::abs(hit.distance - expected.distance) < 1e-3f && normalDot > 0.99f) :
+					(hit.entity == nullptr);
+			}
+			runner.AddCounter("correct", correct);
+			runner.AddCounter("rays", static_cast<double>(known.size()));
+			runner.Check("every known ray correct", correct == known.size());
+		}
+
+		// A crowd of every shape, turned and stretched, with a few registered meshes among them
+		const size_t entityCount = 100000;
+		const float extent = 200.0f;
+		std::vector<std::shared_ptr<Entity>> entities = TestScene::CreateEntities(entityCount, extent, 7);
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			Entity& entity = *entities[i];
+			entity.mesh = i % 100 == 0 ? sphere : i % 3 == 1 ? BuiltinMeshes::Sphere : i % 3 == 2 ? BuiltinMeshes::Cone : BuiltinMeshes::Cube;
+			entity.scale = { 1.0f + (i % 4) * 0.5f, 1.0f + (i % 5) * 0.5f, 1.0f + (i % 7) * 0.25f };
+			entity.rotation = { 1, 1, 0, static_cast<float>(i % 360) };
+		}
+
+		RayQuery query;
+		runner.Run("RayQuery/Build/Entities=" + std::to_string(entityCount), entityCount, [&]()
+		{
+			query.Build(entities, meshes);
+			DoNotOptimize(query);
+		});
+		query.Build(entities, meshes);
+		runner.AddCounter("nodes", query.GetStats().nodes);
+		runner.AddCounter("depth", query.GetStats().depth);
+
+		struct RaySet
+		{
+			std::string name;
+			std::vector<Ray> rays;
+			RayQueryMode mode;
+		};
+		std::vector<RaySet> raySets;
+		raySets.push_back({ "Camera", CreateCameraRays({ 0, 0, -extent - 20 }, 512, 512, 1.0f), RayQueryMode::Closest });
+		raySets.push_back({ "Random", CreateRandomRays(256 * 1024, extent, 11), RayQueryMode::Closest });
+		raySets.push_back({ "SightLines", CreateSightLines(256 * 1024, extent, 13), RayQueryMode::Any });
+
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::uint32_t> threadCounts = { 1, 2, 4 };
+		if (hardwareThreads > 4)
+		{
+			threadCounts.push_back(hardwareThreads);
+		}
+		// Checked against every entity one ray at a time, so only the first few
+		const size_t checkedRays = 256;
+		for (RaySet& set : raySets)
+		{
+			std::vector<RayHit> hits(set.rays.size());
+			bool checked = false;
+			for (std::uint32_t threads : threadCounts)
+			{
+				const std::string name = "RayQuery/" + set.name + "/Threads=" + std::to_string(threads);
+				if (!runner.IsEnabled(name))
+				{
+					continue;
+				}
+				query.SetThreadCount(threads);
+				runner.Run(name, set.rays.size(), [&]()
+				{
+					query.Intersect(set.rays.data(), set.rays.size(), hits.data(), set.mode);
+					DoNotOptimize(hits);
+				});
+				const RayQueryStats& stats = query.GetStats();
+				runner.AddCounter("MRaysPerSecond", set.rays.size() * 1e3 / runner.GetResults().back().nsPerIteration);
+				runner.AddCounter("hit rate", static_cast<double>(stats.hits) / stats.rays);
+				runner.AddCounter("nodes per packet", static_cast<double>(stats.nodesVisited) * RayQuery::PacketSize / stats.rays);
+				runner.AddCounter("shapes per ray", static_cast<double>(stats.shapesTested) / stats.rays);
+				if (!checked)
+				{
+					const double mismatches = CountMismatches(entities, meshes, set.rays, hits, checkedRays, set.mode);
+					runner.AddCounter("mismatches", mismatches);
+					runner.Check("same hits as brute force", mismatches == 0);
+					checked = true;
+				}
+			}
+		}
+	}
+}
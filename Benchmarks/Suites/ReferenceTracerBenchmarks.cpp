@@ -0,0 +1,158 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Camera/Camera.h"
+#include "Rendering/MeshRegistry.h"
+#include "Rendering/ReferenceTracer.h"
+#include <filesystem>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		const std::uint8_t* GetPixel(const Image& image, std::uint32_t x, std::uint32_t y)
+		{
+			return image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+		}
+
+		bool PixelEquals(const Image& image, std::uint32_t x, std::uint32_t y, std::uint8_t r, std::uint8_t g, std::uint8_t b)
+		{
+			const std::uint8_t* pixel = GetPixel(image, x, y);
+			return pixel[0] == r && pixel[1] == g && pixel[2] == b && pixel[3] == 255;
+		}
+	}
+
+	void RunReferenceTracerBenchmarks(BenchmarkRunner& runner)
+	{
+		MeshRegistry meshes;
+		MeshData sphereMesh = TestScene::CreateSphere(64, 32);
+		const MeshHandle sphere = meshes.Register(sphereMesh.vertices, sphereMesh.indices);
+
+		// A cube and a registered sphere, each with a face square on to the camera at z = -1 and lit by one point
+		// light between them. Worked through the shader by hand, the centre pixel is 0.5 of the diffuse plus 0.5 of
+		// the specular plus the ambient: (0.55, 0.45, 0.4), or (140, 115, 102) in the back buffer. The corner
+		// pixel hits nothing and stays black
+		{
+			auto material = std::make_shared<Material>();
+			material->diffuse = { 0.4f, 0.2f, 0.1f, 1 };
+			material->specular = { 0.2f, 0.2f, 0.2f };
+			material->gloss = 8;
+			auto pointLight = std::make_shared<PointLight>();
+			pointLight->position = { 0, 0, -3 };
+			pointLight->range = 10;
+			pointLight->attenuation = { 2, 0, 0 };
+			pointLight->diffuse = { 1, 1, 1 };
+			pointLight->specular = { 1, 1, 1 };
+			// Out of range of the shapes so only the point light reaches them
+			SpotLight spotLight = LightPacker::CreateDefaultSpotLight();
+			spotLight.position = { 0, 100, 0 };
+			spotLight.range = 1;
+
+			auto cube = std::make_shared<Entity>();
+			cube->mesh = BuiltinMeshes::Cube;
+			cube->material = material;
+			cube->scale = { 2, 2, 2 };
+			cube->rotation = { 0, 1, 0, 90 };
+			auto meshSphere = std::make_shared<Entity>(*cube);
+			meshSphere->mesh = sphere;
+			meshSphere->scale = { 1, 1, 1 };
+
+			// An odd size puts the centre of the middle pixel on the axis
+			const std::uint32_t size = 65;
+			Camera camera({ 0, 0, -5 }, { 0, 1, 0 }, { 0, 0, 0 }, XM_PIDIV4, static_cast<float>(size), static_cast<float>(size), 0.1f, 100.0f);
+			ReferenceTracer tracer;
+			tracer.SetThreadCount(1);
+			tracer.SetLights(spotLight, { pointLight });
+			Image image;
+			for (const auto& entity : { cube, meshSphere })
+			{
+				tracer.Build(std::vector<std::shared_ptr<Entity>>{ entity }, meshes);
+				const std::string name = entity == cube ? "ReferenceTracer/KnownPixels/Cube" : "ReferenceTracer/KnownPixels/MeshSphere";
+				runner.Run(name, size * size, [&]()
+				{
+					tracer.Render(camera, size, size, image);
+					DoNotOptimize(image);
+				});
+				tracer.Render(camera, size, size, image);
+				const bool centre = PixelEquals(image, size / 2, size / 2, 140, 115, 102);
+				const bool corner = PixelEquals(image, 0, 0, 0, 0, 0);
+				runner.Check("centre pixel", centre);
+				runner.Check("corner pixel", corner);
+			}
+
+			// Written and read back unchanged
+			const std::string path = (std::filesystem::temp_directory_path() / "reference.ppm").string();
+			Image loaded;
+			const bool roundTrip = ImageFile::SavePpm(path, image) && ImageFile::LoadPpm(path, loaded) &&
+				ImageFile::Compare(image, loaded).sameSize && ImageFile::Compare(image, loaded).maxError == 0;
+			std::filesystem::remove(path);
+			runner.Check("ppm round trip", roundTrip);
+		}
+
+		// Full HD frames of a crowd of cubes, lit by the default spot light and a ring of point lights
+		const size_t entityCount = 100000;
+		const float extent = 100.0f;
+		std::vector<std::shared_ptr<Entity>> entities = TestScene::CreateEntities(entityCount, extent, 21);
+		std::vector<std::shared_ptr<PointLight>> pointLights;
+		for (std::uint32_t i = 0; i < 8; ++i)
+		{
+			const float angle = XM_2PI * i / 8;
+			auto light = std::make_shared<PointLight>();
+			light->position = { std::cos(angle) * extent, std::sin(angle) * extent, -extent };
+			light->range = extent;
+			light->attenuation = { 1, 0.02f, 0 };
+			light->diffuse = { 0.6f, 0.5f, 0.4f };
+			light->specular = { 0.3f, 0.3f, 0.3f };
+			pointLights.push_back(light);
+		}
+
+		ReferenceTracer tracer;
+		tracer.SetLights(LightPacker::CreateDefaultSpotLight(), pointLights);
+		runner.Run("ReferenceTracer/Build/Entities=" + std::to_string(entityCount), entityCount, [&]()
+		{
+			tracer.Build(entities, meshes);
+			DoNotOptimize(tracer);
+		});
+		tracer.Build(entities, meshes);
+
+		const std::uint32_t width = 1920;
+		const std::uint32_t height = 1080;
+		Camera camera({ 0, 0, -extent - 20 }, { 0, 1, 0 }, { 0, 0, 0 }, XM_PIDIV4, static_cast<float>(width), static_cast<float>(height), 0.1f, 1000.0f);
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::uint32_t> threadCounts = { 1, 2, 4 };
+		if (hardwareThreads > 4)
+		{
+			threadCounts.push_back(hardwareThreads);
+		}
+		Image first;
+		Image image;
+		for (std::uint32_t threads : threadCounts)
+		{
+			const std::string name = "ReferenceTracer/Frame1080p/Threads=" + std::to_string(threads);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			tracer.SetThreadCount(threads);
+			runner.Run(name, static_cast<std::uint64_t>(width) * height, [&]()
+			{
+				tracer.Render(camera, width, height, image);
+				DoNotOptimize(image);
+			});
+			const ReferenceTraceStats& stats = tracer.GetStats();
+			runner.AddCounter("seconds per frame", runner.GetResults().back().nsPerIteration / 1e9);
+			runner.AddCounter("MRaysPerSecond", stats.rays * 1e3 / runner.GetResults().back().nsPerIteration);
+			runner.AddCounter("hit rate", static_cast<double>(stats.hits) / stats.rays);
+			// Tiles are shaded independently, so any thread count gives the same image
+			if (first.pixels.empty())
+			{
+				first = image;
+			}
+			const std::uint64_t differing = ImageFile::Compare(first, image).pixelsOverTolerance;
+			runner.AddCounter("pixels differing", static_cast<double>(differing));
+			runner.Check("same image on any thread count", differing == 0);
+		}
+	}
+}
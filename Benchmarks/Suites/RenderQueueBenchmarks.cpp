@@ -0,0 +1,97 @@
+#include "Suites/Suites.h"
+#include "Rendering/RenderQueue.h"
+#include <random>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		// Keys shaped like a frame: one pass, a few meshes and materials and depths spread over the view
+		std::vector<RenderItem> CreateSceneItems(size_t count, std::uint32_t seed)
+		{
+			std::mt19937 random(seed);
+			std::uniform_int_distribution<std::uint32_t> mesh(0, 2);
+			std::uniform_int_distribution<std::uint32_t> material(0, 63);
+			std::uniform_real_distribution<float> depth(0.1f, 4000.0f);
+
+			std::vector<RenderItem> items(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				items[i] = { RenderQueue::MakeKey(RenderPass::Opaque, mesh(random), material(random), depth(random)), static_cast<std::uint32_t>(i) };
+			}
+			return items;
+		}
+
+		// Every bit random so no radix pass can be skipped
+		std::vector<RenderItem> CreateRandomItems(size_t count, std::uint32_t seed)
+		{
+			std::mt19937_64 random(seed);
+			std::vector<RenderItem> items(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				items[i] = { random(), static_cast<std::uint32_t>(i) };
+			}
+			return items;
+		}
+
+		bool IsSorted(const std::vector<RenderItem>& items)
+		{
+			return std::is_sorted(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+		}
+	}
+
+	void RunRenderQueueBenchmarks(BenchmarkRunner& runner)
+	{
+		const size_t itemCount = 1000000;
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+		std::vector<std::uint32_t> threadCounts = { 1, 2, 4 };
+		if (hardwareThreads > 4)
+		{
+			threadCounts.push_back(hardwareThreads);
+		}
+
+		for (const char* keys : { "Scene", "Random" })
+		{
+			const std::string prefix = std::string("RenderQueue/") + keys;
+			if (!runner.IsEnabled(prefix))
+			{
+				continue;
+			}
+			const auto input = std::string(keys) == "Scene" ? CreateSceneItems(itemCount, 29) : CreateRandomItems(itemCount, 29);
+
+			// Every iteration copies the unsorted input first, which is included in the timings
+			std::vector<RenderItem> items;
+			std::vector<RenderItem> scratch;
+			for (std::uint32_t threadCount : threadCounts)
+			{
+				const std::string name = prefix + "/RadixSort/Threads=" + std::to_string(threadCount);
+				runner.Run(name, itemCount, [&]()
+				{
+					items = input;
+					RenderQueue::RadixSort(items, scratch, threadCount);
+					DoNotOptimize(items);
+				});
+				if (runner.IsEnabled(name))
+				{
+					runner.AddCounter("MKeysPerSecond", itemCount * 1e3 / runner.GetResults().back().nsPerIteration);
+					runner.Check("sorted", IsSorted(items));
+				}
+			}
+
+			runner.Run(prefix + "/StdSort", itemCount, [&]()
+			{
+				items = input;
+				std::sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+				DoNotOptimize(items);
+			});
+			if (runner.IsEnabled(prefix + "/StdSort"))
+			{
+				runner.AddCounter("MKeysPerSecond", itemCount * 1e3 / runner.GetResults().back().nsPerIteration);
+			}
+		}
+	}
+}
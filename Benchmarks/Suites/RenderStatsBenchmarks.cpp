@@ -0,0 +1,44 @@
+#include "Suites/Suites.h"
+#include "Rendering/RenderStats.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunRenderStatsBenchmarks(BenchmarkRunner& runner)
+	{
+		// The renderer adds to its counters a handful of times per view, so this only has to stay in the noise
+		RenderCounters counters;
+		runner.Run("RenderStats/CounterAdd", 1, [&]()
+		{
+			counters.Add(RenderCounter::DrawCalls, 1);
+		});
+
+		RenderStats stats;
+		runner.Run("RenderStats/Collect", 1, [&]()
+		{
+			counters.Collect(stats);
+			DoNotOptimize(stats);
+		});
+
+		FrameTimeHistory history;
+		std::uint32_t frame = 0;
+		runner.Run("RenderStats/AddFrameTime", 1, [&]()
+		{
+			history.Add(16.0 + (frame++ % 7));
+		});
+
+		// Reading sorts a copy of the whole window, which is fine for an overlay updated a few times a second
+		for (std::uint32_t i = 0; i < FrameTimeHistory::WindowSize; ++i)
+		{
+			history.Add(16.0 + (frame++ % 7));
+		}
+		FrameTimePercentiles percentiles;
+		runner.Run("RenderStats/Percentiles/Window=1024", FrameTimeHistory::WindowSize, [&]()
+		{
+			percentiles = history.GetPercentiles();
+			DoNotOptimize(percentiles);
+		});
+		runner.AddCounter("p99 ms", percentiles.p99);
+	}
+}
@@ -0,0 +1,47 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Rendering/SceneEntities.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunSceneBenchmarks(BenchmarkRunner& runner)
+	{
+		for (size_t count : { 1000u, 10000u, 100000u, 1000000u })
+		{
+			const std::string name = "Scene/AddEntity/Entities=" + std::to_string(count);
+			const std::string bulkName = "Scene/AddEntities/Entities=" + std::to_string(count);
+			if (!runner.IsEnabled(name) && !runner.IsEnabled(bulkName))
+			{
+				continue;
+			}
+
+			// Spread over every mesh type so each group grows like it would in a mixed scene
+			auto entities = TestScene::CreateEntities(count, 250.0f, 37);
+			for (size_t i = 0; i < count; ++i)
+			{
+				entities[i]->mesh = static_cast<MeshHandle>(i % BuiltinMeshes::Count);
+			}
+
+			// Filling an empty scene, including the groups growing and the entities' reference counts
+			runner.Run(name, count, [&]()
+			{
+				SceneEntities scene;
+				for (const auto& entity : entities)
+				{
+					scene.Add(entity);
+				}
+				DoNotOptimize(scene);
+			});
+
+			// The same scene added as one array, as loading a scene file does
+			runner.Run(bulkName, count, [&]()
+			{
+				SceneEntities scene;
+				scene.Add(entities);
+				DoNotOptimize(scene);
+			});
+		}
+	}
+}
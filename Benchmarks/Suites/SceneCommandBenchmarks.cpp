@@ -0,0 +1,216 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Rendering/SceneEntities.h"
+#include "Scene/SceneCommands.h"
+#include "Profiling/Profiler.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		/** What one producer thread does with its share of the entities */
+		enum class Workload
+		{
+			// Adds every entity of its share
+			Add,
+			// Adds its share of the second half, and moves its share of the first half, removing every fourth
+			Mixed
+		};
+
+		const std::uint32_t BatchSize = 1024;
+
+		/** Commands the producers record between them */
+		size_t CountCommands(Workload workload, size_t entityCount)
+		{
+			return workload == Workload::Add ? entityCount : entityCount + (entityCount / 2 + 3) / 4;
+		}
+
+		void Produce(SceneCommandBuffer& buffer, Workload workload, const std::vector<std::shared_ptr<Entity>>& entities, const std::vector<XMFLOAT3>& positions,
+			std::uint32_t thread, std::uint32_t threadCount)
+		{
+			const size_t half = entities.size() / 2;
+			const size_t first = workload == Workload::Add ? 0 : half;
+			const size_t count = entities.size() - first;
+			for (size_t i = first + count * thread / threadCount; i < first + count * (thread + 1) / threadCount; ++i)
+			{
+				buffer.AddEntity(entities[i]);
+				if (buffer.GetSize() >= BatchSize)
+				{
+					buffer.Submit();
+				}
+			}
+			if (workload == Workload::Mixed)
+			{
+				for (size_t i = half * thread / threadCount; i < half * (thread + 1) / threadCount; ++i)
+				{
+					const Entity& entity = *entities[i];
+					buffer.UpdateEntity(entities[i], { positions[i].x, positions[i].y + 1.0f, positions[i].z }, entity.rotation, entity.scale);
+					if (i % 4 == 0)
+					{
+						buffer.RemoveEntity(entities[i]);
+					}
+					if (buffer.GetSize() >= BatchSize)
+					{
+						buffer.Submit();
+					}
+				}
+			}
+			buffer.Submit();
+		}
+	}
+
+	void RunSceneCommandBenchmarks(BenchmarkRunner& runner)
+	{
+		// Producer threads record their share of the commands and submit them in batches, while this thread merges
+		// whatever has arrived into the scene at each frame boundary until every command is in. Against producers
+		// adding each entity to the scene under a lock, which is the least a shared scene would need. Moves are
+		// from where the entities started, so every run moves them to the same place
+		const std::vector<std::uint32_t> threadCounts = { 1, 4, 16 };
+		std::vector<std::string> names;
+		for (const char* workloadName : { "Add", "Mixed", "LockedAdd" })
+		{
+			for (std::uint32_t threadCount : threadCounts)
+			{
+				names.push_back(std::string("SceneCommands/") + workloadName + "/Producers=" + std::to_string(threadCount));
+			}
+		}
+		if (std::none_of(names.begin(), names.end(), [&](const std::string& name) { return runner.IsEnabled(name); }))
+		{
+			return;
+		}
+
+		const size_t entityCount = 1 << 18;
+		const std::vector<std::shared_ptr<Entity>> entities = TestScene::CreateEntities(entityCount, 500.0f, 5);
+		std::vector<XMFLOAT3> positions;
+		for (const auto& entity : entities)
+		{
+			positions.push_back(entity->position);
+		}
+
+		for (Workload workload : { Workload::Add, Workload::Mixed })
+		{
+			const char* workloadName = workload == Workload::Add ? "Add" : "Mixed";
+			const size_t commandCount = CountCommands(workload, entityCount);
+			for (std::uint32_t threadCount : threadCounts)
+			{
+				const std::string name = std::string("SceneCommands/") + workloadName + "/Producers=" + std::to_string(threadCount);
+				if (!runner.IsEnabled(name))
+				{
+					continue;
+				}
+				size_t sceneSize = 0;
+				std::uint64_t merges = 0;
+				std::uint64_t batches = 0;
+				std::atomic<std::uint64_t> producerNs(0);
+				std::uint64_t mergeNs = 0;
+				bool moved = true;
+				runner.Run(name, commandCount, [&]()
+				{
+					SceneEntities scene;
+					if (workload == Workload::Mixed)
+					{
+						scene.Add(std::vector<std::shared_ptr<Entity>>(entities.begin(), entities.begin() + entityCount / 2));
+					}
+					SceneCommandQueue queue;
+					std::vector<std::thread> producers;
+					for (std::uint32_t thread = 0; thread < threadCount; ++thread)
+					{
+						producers.emplace_back([&, thread]()
+						{
+							const std::uint64_t start = Profiler::Now();
+							SceneCommandBuffer buffer(queue);
+							Produce(buffer, workload, entities, positions, thread, threadCount);
+							producerNs += Profiler::Now() - start;
+						});
+					}
+					SceneChanges changes;
+					size_t merged = 0;
+					merges = 0;
+					batches = 0;
+					producerNs = 0;
+					mergeNs = 0;
+					while (merged < commandCount)
+					{
+						const std::uint64_t start = Profiler::Now();
+						if (!queue.Merge(changes))
+						{
+							std::this_thread::yield();
+							continue;
+						}
+						scene.Remove(changes.removed);
+						scene.Add(changes.added);
+						mergeNs += Profiler::Now() - start;
+						merged += changes.commands;
+						batches += changes.batches;
+						++merges;
+					}
+					for (auto& producer : producers)
+					{
+						producer.join();
+					}
+					sceneSize = scene.Size();
+					DoNotOptimize(sceneSize);
+				});
+				if (workload == Workload::Mixed)
+				{
+					// Moves are applied to the entities themselves, so they are put back for the next run
+					for (size_t i = 0; i < entityCount / 2; ++i)
+					{
+						moved = moved && entities[i]->position.y == positions[i].y + 1.0f;
+						entities[i]->position = positions[i];
+					}
+				}
+				const size_t expected = workload == Workload::Add ? entityCount : entityCount - (entityCount / 2 + 3) / 4;
+				runner.AddCounter("MCommandsPerSecond", commandCount * 1e3 / runner.GetResults().back().nsPerIteration);
+				// What recording costs the producers, and merging and applying the thread that renders
+				runner.AddCounter("producer ns per command", producerNs.load() / static_cast<double>(commandCount));
+				runner.AddCounter("merge ns per command", mergeNs / static_cast<double>(commandCount));
+				runner.AddCounter("merges", static_cast<double>(merges));
+				runner.AddCounter("batches", static_cast<double>(batches));
+				runner.Check("scene as recorded", sceneSize == expected && moved);
+			}
+		}
+
+		for (std::uint32_t threadCount : threadCounts)
+		{
+			const std::string name = "SceneCommands/LockedAdd/Producers=" + std::to_string(threadCount);
+			if (!runner.IsEnabled(name))
+			{
+				continue;
+			}
+			std::atomic<std::uint64_t> producerNs(0);
+			runner.Run(name, entityCount, [&]()
+			{
+				producerNs = 0;
+				SceneEntities scene;
+				std::mutex mutex;
+				std::vector<std::thread> producers;
+				for (std::uint32_t thread = 0; thread < threadCount; ++thread)
+				{
+					producers.emplace_back([&, thread]()
+					{
+						const std::uint64_t start = Profiler::Now();
+						for (size_t i = entityCount * thread / threadCount; i < entityCount * (thread + 1) / threadCount; ++i)
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							scene.Add(entities[i]);
+						}
+						producerNs += Profiler::Now() - start;
+					});
+				}
+				for (auto& producer : producers)
+				{
+					producer.join();
+				}
+				DoNotOptimize(scene.Size());
+			});
+			runner.AddCounter("MCommandsPerSecond", entityCount * 1e3 / runner.GetResults().back().nsPerIteration);
+			runner.AddCounter("producer ns per command", producerNs.load() / static_cast<double>(entityCount));
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Scene/SceneContent.h"
+#include "Scene/SceneText.h"
+#include "Rendering/SceneEntities.h"
+#include <filesystem>
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunSceneFileBenchmarks(BenchmarkRunner& runner)
+	{
+		for (size_t count : { 10000u, 100000u, 500000u })
+		{
+			const std::string suffix = "/Entities=" + std::to_string(count);
+			if (!runner.IsEnabled("SceneFile/Open" + suffix) && !runner.IsEnabled("SceneFile/OpenTrusted" + suffix) &&
+				!runner.IsEnabled("SceneFile/ImportText" + suffix) && !runner.IsEnabled("SceneFile/Load" + suffix) &&
+				!runner.IsEnabled("SceneFile/LoadText" + suffix))
+			{
+				continue;
+			}
+
+			// A layout as a tool would export it, saved in both formats
+			auto entities = TestScene::CreateEntities(count, 250.0f, 40);
+			for (size_t i = 0; i < count; ++i)
+			{
+				entities[i]->mesh = static_cast<MeshHandle>(i % BuiltinMeshes::Count);
+				entities[i]->isStatic = i % 2 == 0;
+			}
+			SceneData data;
+			data.Capture(entities, {}, {});
+			const std::filesystem::path directory = std::filesystem::temp_directory_path();
+			const std::string binaryPath = (directory / ("benchmark" + std::to_string(count) + ".scene")).string();
+			const std::string textPath = (directory / ("benchmark" + std::to_string(count) + ".txt")).string();
+			if (!SceneFile::Save(binaryPath, data.GetArrays()) || !SceneText::Export(textPath, data.GetArrays()))
+			{
+				std::cerr << "Could not write the scene files in " << directory << "\n";
+				return;
+			}
+			const double binaryMegabytes = std::filesystem::file_size(binaryPath) / (1024.0 * 1024.0);
+			const double textMegabytes = std::filesystem::file_size(textPath) / (1024.0 * 1024.0);
+
+			// Files are in the file cache after the first iteration, so these are warm loads. Mapping only touches
+			// the pages that are read, so a trusted open costs the same at every size
+			SceneFile file;
+			runner.Run("SceneFile/Open" + suffix, count, [&]()
+			{
+				file.Open(binaryPath);
+				DoNotOptimize(file.GetArrays());
+			});
+			runner.AddCounter("MB", binaryMegabytes);
+			runner.Run("SceneFile/OpenTrusted" + suffix, count, [&]()
+			{
+				file.Open(binaryPath, false);
+				DoNotOptimize(file.GetArrays());
+			});
+			runner.Run("SceneFile/ImportText" + suffix, count, [&]()
+			{
+				SceneText::Import(textPath, data);
+				DoNotOptimize(data);
+			});
+			runner.AddCounter("MB", textMegabytes);
+
+			// Everything between a file on disk and entities in the renderer's groups
+			runner.Run("SceneFile/Load" + suffix, count, [&]()
+			{
+				file.Open(binaryPath);
+				SceneContent content = SceneContent::Create(file.GetArrays());
+				SceneEntities scene;
+				scene.Add(content.entities);
+				DoNotOptimize(scene);
+			});
+			runner.Run("SceneFile/LoadText" + suffix, count, [&]()
+			{
+				SceneText::Import(textPath, data);
+				SceneContent content = SceneContent::Create(data.GetArrays());
+				SceneEntities scene;
+				scene.Add(content.entities);
+				DoNotOptimize(scene);
+			});
+
+			file.Close();
+			std::filesystem::remove(binaryPath);
+			std::filesystem::remove(textPath);
+		}
+	}
+}
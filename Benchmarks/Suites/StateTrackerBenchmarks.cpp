@@ -0,0 +1,97 @@
+#include "Suites/Suites.h"
+#include "Rendering/StateTracker.h"
+#include "Rendering/RecordingBackend.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	namespace
+	{
+		// Stand in objects. The tracker and recorder only compare the pointers
+		template<typename T>
+		T* FakeObject(std::uintptr_t id)
+		{
+			return reinterpret_cast<T*>(id * 16);
+		}
+
+		/** Binds the same way MeshRenderer does for one frame */
+		void BindFrame(StateTracker& tracker, const PipelineState* pipelineState, std::uint32_t viewCount, std::uint32_t meshCount)
+		{
+			ID3D11RenderTargetView* renderTarget = FakeObject<ID3D11RenderTargetView>(1);
+			tracker.SetRenderTargets(1, &renderTarget, FakeObject<ID3D11DepthStencilView>(2));
+			tracker.SetPipelineState(pipelineState);
+
+			ID3D11Buffer* constantBuffers[3] = { FakeObject<ID3D11Buffer>(3), FakeObject<ID3D11Buffer>(4), FakeObject<ID3D11Buffer>(5) };
+			tracker.SetVSConstantBuffers(0, 1, constantBuffers);
+			tracker.SetPSConstantBuffers(0, 3, constantBuffers);
+			ID3D11ShaderResourceView* resources[1] = { FakeObject<ID3D11ShaderResourceView>(6) };
+			tracker.SetPSShaderResources(0, 1, resources);
+
+			// Every view walks its sorted queue and binds each mesh it draws
+			for (std::uint32_t view = 0; view < viewCount; ++view)
+			{
+				for (std::uint32_t mesh = 0; mesh < meshCount; ++mesh)
+				{
+					ID3D11Buffer* vertexBuffers[2] = { FakeObject<ID3D11Buffer>(100 + mesh * 3), FakeObject<ID3D11Buffer>(101 + mesh * 3) };
+					std::uint32_t strides[2] = { 24, 64 };
+					std::uint32_t offsets[2] = { 0, 0 };
+					tracker.SetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+					tracker.SetIndexBuffer(FakeObject<ID3D11Buffer>(102 + mesh * 3), 42, 0);
+				}
+			}
+
+			tracker.InvalidateRenderTargets();
+		}
+	}
+
+	void RunStateTrackerBenchmarks(BenchmarkRunner& runner)
+	{
+		PipelineStateCache cache;
+		PipelineStateDesc desc;
+		desc.vertexShader = FakeObject<ID3D11VertexShader>(7);
+		desc.inputLayout = FakeObject<ID3D11InputLayout>(8);
+		desc.pixelShader = FakeObject<ID3D11PixelShader>(9);
+		desc.rasterizerState = FakeObject<ID3D11RasterizerState>(10);
+		const PipelineState* pipelineState = cache.GetOrCreate(desc);
+
+		const std::uint32_t frameCount = 100;
+		for (std::uint32_t viewCount : { 1u, 4u })
+		{
+			for (std::uint32_t meshCount : { 1u, 3u })
+			{
+				const std::string name = "StateTracker/Frames/Views=" + std::to_string(viewCount) + "/Meshes=" + std::to_string(meshCount);
+				if (!runner.IsEnabled(name))
+				{
+					continue;
+				}
+
+				RecordingBackend backend;
+				StateTracker tracker(&backend);
+				runner.Run(name, frameCount, [&]()
+				{
+					backend.Clear();
+					tracker.Invalidate();
+					tracker.ResetStats();
+					for (std::uint32_t frame = 0; frame < frameCount; ++frame)
+					{
+						BindFrame(tracker, pipelineState, viewCount, meshCount);
+					}
+					DoNotOptimize(tracker.GetStats());
+				});
+
+				// The recorder sees exactly the binds the tracker reports as issued
+				const StateTrackerStats& stats = tracker.GetStats();
+				runner.AddCounter("issuedPerFrame", static_cast<double>(stats.issued) / frameCount);
+				runner.AddCounter("filteredPerFrame", static_cast<double>(stats.filtered) / frameCount);
+				runner.Check("recorded matches issued", backend.GetCommands().size() == stats.issued);
+			}
+		}
+
+		// Looking up a pipeline state that already exists, as done when state is described per draw
+		runner.Run("StateTracker/PipelineStateCache/Lookup", 1, [&]()
+		{
+			DoNotOptimize(cache.GetOrCreate(desc));
+		});
+	}
+}
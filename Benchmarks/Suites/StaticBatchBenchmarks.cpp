@@ -0,0 +1,59 @@
+#include "Suites/Suites.h"
+#include "Harness/TestScene.h"
+#include "Rendering/StaticBatcher.h"
+
+using namespace renderer;
+
+namespace benchmarks
+{
+	void RunStaticBatchBenchmarks(BenchmarkRunner& runner)
+	{
+		for (size_t count : { 10000u, 100000u })
+		{
+			const std::string suffix = "/Entities=" + std::to_string(count);
+			if (!runner.IsEnabled("StaticBatch/Build" + suffix) && !runner.IsEnabled("StaticBatch/Rebuild" + suffix))
+			{
+				continue;
+			}
+			auto entities = TestScene::CreateEntities(count, 250.0f, 39);
+			const MeshRegistry meshes;
+
+			// Loading a level: every entity is added and every chunk built, on one thread so runs compare across machines
+			StaticBatchStats stats;
+			runner.Run("StaticBatch/Build" + suffix, count, [&]()
+			{
+				StaticBatcher batcher(meshes);
+				for (const auto& entity : entities)
+				{
+					batcher.Add(entity);
+				}
+				batcher.Build(1);
+				stats = batcher.GetStats();
+				batcher.ReleaseRebuiltGeometry();
+			});
+			runner.AddCounter("chunks", stats.chunks);
+			runner.AddCounter("vertices", static_cast<double>(stats.vertices));
+
+			// A frame where a few static entities were moved, which rebuilds their whole chunks
+			StaticBatcher batcher(meshes);
+			for (const auto& entity : entities)
+			{
+				batcher.Add(entity);
+			}
+			batcher.Build(1);
+			batcher.ReleaseRebuiltGeometry();
+			const size_t changes = 10;
+			size_t next = 0;
+			runner.Run("StaticBatch/Rebuild" + suffix, changes, [&]()
+			{
+				for (size_t i = 0; i < changes; ++i)
+				{
+					batcher.MarkChanged(entities[(next++ * 7919) % count].get());
+				}
+				batcher.Build(1);
+				batcher.ReleaseRebuiltGeometry();
+			});
+			runner.AddCounter("chunks rebuilt", batcher.GetStats().rebuilt);
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Harness/BenchmarkRunner.h"
+
+namespace benchmarks
+{
+	void RunMultiViewBenchmarks(BenchmarkRunner& runner);
+	void RunOcclusionBenchmarks(BenchmarkRunner& runner);
+	void RunRenderQueueBenchmarks(BenchmarkRunner& runner);
+	void RunStateTrackerBenchmarks(BenchmarkRunner& runner);
+	void RunProfilerBenchmarks(BenchmarkRunner& runner);
+	void RunRenderStatsBenchmarks(BenchmarkRunner& runner);
+	void RunCameraBenchmarks(BenchmarkRunner& runner);
+	void RunInstanceBenchmarks(BenchmarkRunner& runner);
+	void RunLightBenchmarks(BenchmarkRunner& runner);
+	void RunSceneBenchmarks(BenchmarkRunner& runner);
+	void RunFrameArenaBenchmarks(BenchmarkRunner& runner);
+	void RunMemoryTrackerBenchmarks(BenchmarkRunner& runner);
+	void RunOffsetAllocatorBenchmarks(BenchmarkRunner& runner);
+	void RunStaticBatchBenchmarks(BenchmarkRunner& runner);
+	void RunSceneFileBenchmarks(BenchmarkRunner& runner);
+	void RunMeshImportBenchmarks(BenchmarkRunner& runner);
+	void RunMeshSimplifyBenchmarks(BenchmarkRunner& runner);
+	void RunMeshletBenchmarks(BenchmarkRunner& runner);
+	void RunRayQueryBenchmarks(BenchmarkRunner& runner);
+	void RunReferenceTracerBenchmarks(BenchmarkRunner& runner);
+	void RunFrameCaptureBenchmarks(BenchmarkRunner& runner);
+	void RunSceneCommandBenchmarks(BenchmarkRunner& runner);
+}
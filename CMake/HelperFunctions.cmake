@@ -52,7 +52,7 @@ function(add_common_properties target)
 	elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang" OR CMAKE_CXX_COMPILER_ID MATCHES "AppleClang" OR "${CMAKE_CXX_COMPILER_ID}" STREQUAL "GNU")
 		# Note: Optionally add -ffunction-sections, -fdata-sections, but with linker option --gc-sections
 		# TODO: Use link-time optimization -flto. Might require non-default linker.
-		set_property(TARGET ${target} APPEND PROPERTY COMPILE_OPTIONS -Wall -Wextra -Wno-unused-parameter -fpiC -fno-strict-aliasing -msse4.1)
+		set_property(TARGET ${target} APPEND PROPERTY COMPILE_OPTIONS -Wall -Wextra -Wno-unused-parameter -fPIC -fno-strict-aliasing -msse4.1)
 
 		if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" OR CMAKE_CXX_COMPILER_ID MATCHES "AppleClang")
 			set_property(TARGET ${target} APPEND PROPERTY COMPILE_OPTIONS -fno-ms-compatibility)
@@ -100,7 +100,8 @@ function(add_source_groups srcsVarName srcsToExclude)
 	file(GLOB_RECURSE SRC_FILES CONFIGURE_DEPENDS RELATIVE ${CMAKE_CURRENT_SOURCE_DIR} *.h *.c *.cpp *.rc *.aps *.hlsl *.hlsli)
 	
 	foreach(f ${srcsToExclude})
-		list(FILTER SRC_FILES EXCLUDE REGEX "^${f}")
+		# Matches a whole directory anywhere in the path, so nested platform directories are left out too
+		list(FILTER SRC_FILES EXCLUDE REGEX "(^|/)${f}/")
 	endforeach()
 
 	source_group(TREE ${CMAKE_CURRENT_SOURCE_DIR} FILES ${SRC_FILES})
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Base.h"
+#include <atomic>
+
+namespace renderer
+{
+	/**
+	 * Fixed capacity queue any number of threads can push to and pop from without locks. Every cell carries a
+	 * sequence number saying whether it is free for the push or full for the pop of the current lap, so pushers and
+	 * poppers only contend on their own end. The capacity is rounded up to a power of two.
+	 */
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		explicit BoundedQueue(std::uint32_t capacity)
+		{
+			std::uint32_t size = 1;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			mMask = size - 1;
+			mCells.reset(new Cell[size]);
+			for (std::uint32_t i = 0; i < size; ++i)
+			{
+				mCells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			mHead.store(0, std::memory_order_relaxed);
+			mTail.store(0, std::memory_order_relaxed);
+		}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		/** Returns false if the queue is full */
+		bool TryPush(T value)
+		{
+			std::uint64_t position = mTail.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				Cell& cell = mCells[position & mMask];
+				const std::uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+				const auto lag = static_cast<std::int64_t>(sequence - position);
+				if (lag == 0)
+				{
+					if (mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						cell.value = std::move(value);
+						cell.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (lag < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = mTail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/** Returns false if the queue is empty */
+		bool TryPop(T& value)
+		{
+			std::uint64_t position = mHead.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				Cell& cell = mCells[position & mMask];
+				const std::uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+				const auto lag = static_cast<std::int64_t>(sequence - (position + 1));
+				if (lag == 0)
+				{
+					if (mHead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						value = std::move(cell.value);
+						cell.sequence.store(position + mMask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (lag < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = mHead.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/** Values in the queue. Only a hint while other threads push or pop */
+		std::uint32_t GetSizeHint() const
+		{
+			const std::uint64_t tail = mTail.load(std::memory_order_relaxed);
+			const std::uint64_t head = mHead.load(std::memory_order_relaxed);
+			return tail > head ? static_cast<std::uint32_t>(tail - head) : 0;
+		}
+
+		std::uint32_t GetCapacity() const
+		{
+			return mMask + 1;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<std::uint64_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> mCells;
+		std::uint32_t mMask;
+		// On separate cache lines so pushing and popping threads do not share one
+		alignas(64) std::atomic<std::uint64_t> mHead;
+		alignas(64) std::atomic<std::uint64_t> mTail;
+	};
+}
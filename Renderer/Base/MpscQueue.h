@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Base.h"
+#include <atomic>
+
+namespace renderer
+{
+	/**
+	 * Unbounded queue of nodes any number of threads push to without locks and one thread takes everything from
+	 * at once. Pushing links the node in front of the head with a compare and swap, and taking swaps the head for
+	 * null and reverses the list, so nodes come out in the order they were pushed. Nodes are linked through their
+	 * own next pointer and are owned by whoever holds them, so the queue never allocates.
+	 */
+	template<typename T>
+	class MpscQueue
+	{
+	public:
+		MpscQueue()
+			: mHead(nullptr)
+		{
+		}
+
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+
+		void Push(T* node)
+		{
+			T* head = mHead.load(std::memory_order_relaxed);
+			do
+			{
+				node->next = head;
+			} while (!mHead.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		/** Takes every node pushed so far, oldest first and linked through next, or null if there are none */
+		T* PopAll()
+		{
+			T* node = mHead.exchange(nullptr, std::memory_order_acquire);
+			T* oldest = nullptr;
+			while (node)
+			{
+				T* next = node->next;
+				node->next = oldest;
+				oldest = node;
+				node = next;
+			}
+			return oldest;
+		}
+
+		/** Only a hint while other threads push */
+		bool IsEmpty() const
+		{
+			return mHead.load(std::memory_order_relaxed) == nullptr;
+		}
+
+	private:
+		// On its own cache line, as every pushing thread swaps it
+		alignas(64) std::atomic<T*> mHead;
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Base.h"
+#include <atomic>
+
+namespace renderer
+{
+	/**
+	 * Hands the newest of a stream of values from one writing thread to one reading thread without locks. The
+	 * writer fills its own buffer and publishes it by swapping it with the one in the middle, and the reader takes
+	 * the middle one by swapping it with the buffer it read last, so neither ever waits for the other. A value the
+	 * reader did not take before the next was published comes back to the writer, which can carry over what it held.
+	 */
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer()
+			: mWrite(0), mRead(2), mMiddle(1)
+		{
+		}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		/** The buffer the writer fills. Only the writer may touch it */
+		T& GetWriteBuffer()
+		{
+			return mBuffers[mWrite];
+		}
+
+		/**
+		 * Makes the write buffer the newest value and gives the writer another. Returns true if the value it
+		 * replaces was never taken, in which case that is the buffer now being written
+		 */
+		bool Publish()
+		{
+			const std::uint32_t previous = mMiddle.exchange(mWrite | FreshBit, std::memory_order_acq_rel);
+			mWrite = previous & IndexMask;
+			return (previous & FreshBit) != 0;
+		}
+
+		/** Whether a value was published that the reader has not taken yet */
+		bool HasNew() const
+		{
+			return (mMiddle.load(std::memory_order_acquire) & FreshBit) != 0;
+		}
+
+		/** Takes the newest value if one was published since the last call, otherwise null */
+		T* Acquire()
+		{
+			if (!HasNew())
+			{
+				return nullptr;
+			}
+			const std::uint32_t previous = mMiddle.exchange(mRead, std::memory_order_acq_rel);
+			mRead = previous & IndexMask;
+			return &mBuffers[mRead];
+		}
+
+		/** The value the reader took last. Only the reader may touch it */
+		T& GetReadBuffer()
+		{
+			return mBuffers[mRead];
+		}
+
+	private:
+		static constexpr std::uint32_t IndexMask = 3;
+		static constexpr std::uint32_t FreshBit = 4;
+
+		T mBuffers[3];
+		// Each only used by its own thread, so kept apart
+		alignas(64) std::uint32_t mWrite;
+		alignas(64) std::uint32_t mRead;
+		// Index of the middle buffer, and whether it holds a value the reader has not taken. On its own cache line
+		// as both threads swap it
+		alignas(64) std::atomic<std::uint32_t> mMiddle;
+	};
+}
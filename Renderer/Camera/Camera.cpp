@@ -5,24 +5,22 @@ using namespace DirectX;
 namespace renderer
 {
 	Camera::Camera()
+		: Camera(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 100), 0.4f * 3.14f, 1920, 1080, 1, 4000)
 	{
-		//Set default values.
-		mPosition = XMFLOAT3(0, 0, 0);
-		mUp = XMFLOAT3(0, 1, 0);
-		mTarget = XMFLOAT3(0, 0, 100);
-		mFov = 0.4f * 3.14f;
-		mWidth = 1920;
-		mHeight = 1080;
-		mNearZ = 1;
-		mFarZ = 4000;
-		mWidth = 1920;
-		mHeight = 1080;
+
 	}
 
 	Camera::Camera(XMFLOAT3 position, XMFLOAT3 up, XMFLOAT3 target, float fov, float width, float height, float nearZ, float farZ)
-		: mPosition(position), mUp(up), mTarget(target), mFov(fov), mWidth(width), mHeight(height), mNearZ(nearZ), mFarZ(farZ)
+		: mPosition(position), mWidth(width), mHeight(height), mFov(fov), mNearZ(nearZ), mFarZ(farZ), mViewDirty(true), mProjectionDirty(true)
 	{
-
+		XMVECTOR toTarget = FV(target) - FV(position);
+		mTargetDistance = XMVectorGetX(XMVector3Length(toTarget));
+		if (mTargetDistance == 0.0f)
+		{
+			toTarget = XMVectorSet(0, 0, 1, 0);
+			mTargetDistance = 100;
+		}
+		LookTo(toTarget, FV(up));
 	}
 
 	Camera::~Camera()
@@ -32,64 +30,39 @@ namespace renderer
 
 	void Camera::SetYaw(float yaw)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR forwardLength = FV(mTarget) - vPosition;
-		XMVECTOR rot = XMQuaternionRotationAxis(FV(XMFLOAT3(0, 1, 0)), yaw);
-		mUp = VF3(XMVector3Rotate(FV(mUp), rot));
-		mTarget = VF3(XMVector3Rotate(forwardLength, rot) + vPosition);
+		// Yaw is around the world up axis so the horizon stays level
+		Rotate(XMQuaternionRotationNormal(XMVectorSet(0, 1, 0, 0), yaw));
 	}
 
 	void Camera::SetPitch(float pitch)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR forwardLength = FV(mTarget) - vPosition;
-		XMVECTOR forward = XMVector3Normalize(forwardLength);
-		XMVECTOR vUp = FV(mUp);
-		XMVECTOR right = XMVector3Normalize(XMVector3Cross(forward, vUp));
-		XMVECTOR rot = XMQuaternionRotationAxis(right, pitch);
-		mUp = VF3(XMVector3Rotate(vUp, rot));
-		mTarget = VF3(XMVector3Rotate(forwardLength, rot) + vPosition);
+		// Positive pitch tilts the forward vector upwards
+		Rotate(XMQuaternionRotationNormal(FV(mRight), -pitch));
 	}
 
 	void Camera::MoveForwardBack(float amount)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR vTarget = FV(mTarget);
-		XMVECTOR forward = XMVector3Normalize(vTarget - vPosition);
-		vPosition = vPosition + forward * amount;
-		mPosition = VF3(vPosition);
-		mTarget = VF3(vPosition + forward * 100);
+		mPosition = VF3(FV(mPosition) + FV(mForward) * amount);
+		mViewDirty = true;
 	}
 
 	void Camera::MoveRightLeft(float amount)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR vTarget = FV(mTarget);
-		XMVECTOR forward = XMVector3Normalize(vTarget - vPosition);
-		XMVECTOR right = XMVector3Normalize(XMVector3Cross(FV(mUp), forward));
-		vPosition = vPosition + right * amount;
-		mPosition = VF3(vPosition);
-		mTarget = VF3(vPosition + forward * 100);
+		mPosition = VF3(FV(mPosition) + FV(mRight) * amount);
+		mViewDirty = true;
 	}
 
 	void Camera::MoveUpDown(float amount)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR vTarget = FV(mTarget);
-		XMVECTOR forward = XMVector3Normalize(vTarget - vPosition);
-		vPosition = vPosition + FV(mUp) * amount;
-		mPosition = VF3(vPosition);
-		mTarget = VF3(vPosition + forward * 100);
+		mPosition = VF3(FV(mPosition) + FV(mUp) * amount);
+		mViewDirty = true;
 	}
 
 	void Camera::SetPosition(XMFLOAT3 position)
 	{
-		XMVECTOR vOldPosition = FV(mPosition);
-		XMVECTOR vPosition = FV(position);
-		XMVECTOR vTarget = FV(mTarget);
-		XMVECTOR forward = XMVector3Normalize(vTarget - vOldPosition);
+		// Orientation and target distance are kept so the target moves with the camera
 		mPosition = position;
-		mTarget = VF3(vPosition + forward * XMVector3Length(vTarget - vOldPosition));
+		mViewDirty = true;
 	}
 
 	XMFLOAT3 Camera::GetPosition() const
@@ -97,51 +70,64 @@ namespace renderer
 		return mPosition;
 	}
 
+	void Camera::SetOrientation(XMFLOAT4 orientation)
+	{
+		mOrientation = VF4(XMQuaternionNormalize(FV(orientation)));
+		UpdateBasis();
+	}
+
+	XMFLOAT4 Camera::GetOrientation() const
+	{
+		return mOrientation;
+	}
+
 	void Camera::SetTarget(XMFLOAT3 target)
 	{
-		XMVECTOR vPosition = FV(mPosition);
-		XMVECTOR vTarget = FV(target);
+		XMVECTOR toTarget = FV(target) - FV(mPosition);
+		float distance = XMVectorGetX(XMVector3Length(toTarget));
 		// Ensure position and target are not the same
-		if (XMVector3Equal(vPosition, vTarget))
+		if (distance == 0.0f)
 		{
 			return;
 		}
-		XMVECTOR currentForward = XMVector3Normalize(FV(mTarget) - vPosition);
-		XMVECTOR newForward = XMVector3Normalize(vTarget - vPosition);
-
-		float angle = XMConvertToDegrees(XMVectorGetX(XMVector3AngleBetweenNormals(currentForward, newForward)));
-
-		XMVECTOR rot;
-		if (angle != 0.0f && angle != 180.0f && angle != 360.0f)
+		XMVECTOR currentForward = FV(mForward);
+		XMVECTOR newForward = toTarget / XMVectorReplicate(distance);
+		mTargetDistance = distance;
+
+		// Rotate along the shortest arc so the camera roll is preserved
+		XMVECTOR axis = XMVector3Cross(currentForward, newForward);
+		float angle = XMVectorGetX(XMVector3AngleBetweenNormals(currentForward, newForward));
+		if (XMVectorGetX(XMVector3LengthSq(axis)) > 1e-12f)
 		{
-			XMVECTOR axis = XMVector3Normalize(XMVector3Cross(currentForward, newForward));
-			rot = XMQuaternionRotationAxis(axis, XMConvertToRadians(angle));
-			mUp = VF3(XMVector3Rotate(FV(mUp), rot));
+			Rotate(XMQuaternionRotationNormal(XMVector3Normalize(axis), angle));
+		}
+		else if (XMVectorGetX(XMVector3Dot(currentForward, newForward)) < 0.0f)
+		{
+			// Facing the opposite way so any axis perpendicular to forward works
+			Rotate(XMQuaternionRotationNormal(FV(mUp), XM_PI));
 		}
-		mTarget = target;
 	}
 
 	XMFLOAT3 Camera::GetTarget() const
 	{
-		return mTarget;
+		return VF3(FV(mPosition) + FV(mForward) * mTargetDistance);
 	}
 
 	void Camera::SetUp(XMFLOAT3 up)
 	{
 		XMVECTOR currentUp = FV(mUp);
-		XMVECTOR newUp = FV(up);
+		XMVECTOR newUp = XMVector3Normalize(FV(up));
 
-		float angle = XMConvertToDegrees(XMVectorGetX(XMVector3AngleBetweenNormals(currentUp, newUp)));
-
-		XMVECTOR rot;
-		if (angle != 0.0f && angle != 180.0f && angle != 360.0f)
+		XMVECTOR axis = XMVector3Cross(currentUp, newUp);
+		float angle = XMVectorGetX(XMVector3AngleBetweenNormals(currentUp, newUp));
+		if (XMVectorGetX(XMVector3LengthSq(axis)) > 1e-12f)
 		{
-			XMVECTOR axis = XMVector3Normalize(XMVector3Cross(currentUp, newUp));
-			rot = XMQuaternionRotationAxis(axis, XMConvertToRadians(angle));
-			mTarget = VF3(XMVector3Rotate(FV(mTarget), rot));
+			Rotate(XMQuaternionRotationNormal(XMVector3Normalize(axis), angle));
+		}
+		else if (XMVectorGetX(XMVector3Dot(currentUp, newUp)) < 0.0f)
+		{
+			Rotate(XMQuaternionRotationNormal(FV(mForward), XM_PI));
 		}
-
-		mUp = up;
 	}
 
 	XMFLOAT3 Camera::GetUp() const
@@ -151,27 +137,89 @@ namespace renderer
 
 	XMVECTOR Camera::GetForward() const
 	{
-		return XMVector3Normalize(FV(mTarget) - FV(mPosition));
+		return FV(mForward);
+	}
+
+	XMVECTOR Camera::GetRight() const
+	{
+		return FV(mRight);
 	}
 
 	XMMATRIX Camera::GetView() const
 	{
-		return XMMatrixLookAtLH(FV(mPosition), FV(mTarget), FV(mUp));
+		return XMLoadFloat4x4(&GetMatrices().view);
 	}
 
 	XMMATRIX Camera::GetProjection() const
 	{
-		return XMMatrixPerspectiveFovLH(0.4f * 3.14f, mWidth / mHeight, mNearZ, mFarZ);
+		return XMLoadFloat4x4(&GetMatrices().projection);
 	}
 
 	XMMATRIX Camera::GetViewProjection() const
 	{
-		return GetView() * GetProjection();
+		return XMLoadFloat4x4(&GetMatrices().viewProjection);
+	}
+
+	XMMATRIX Camera::GetInverseView() const
+	{
+		return XMLoadFloat4x4(&GetMatrices().inverseView);
+	}
+
+	XMMATRIX Camera::GetInverseProjection() const
+	{
+		return XMLoadFloat4x4(&GetMatrices().inverseProjection);
+	}
+
+	XMMATRIX Camera::GetInverseViewProjection() const
+	{
+		return XMLoadFloat4x4(&GetMatrices().inverseViewProjection);
+	}
+
+	const CameraMatrices& Camera::GetMatrices() const
+	{
+		UpdateCache();
+		return mMatrices;
+	}
+
+	const Frustum& Camera::GetFrustum() const
+	{
+		UpdateCache();
+		return mFrustum;
+	}
+
+	void Camera::UpdateCache() const
+	{
+		if (!mViewDirty && !mProjectionDirty)
+		{
+			return;
+		}
+
+		if (mViewDirty)
+		{
+			XMMATRIX view = XMMatrixLookToLH(FV(mPosition), FV(mForward), FV(mUp));
+			XMStoreFloat4x4(&mMatrices.view, view);
+			XMStoreFloat4x4(&mMatrices.inverseView, XMMatrixInverse(nullptr, view));
+			mViewDirty = false;
+		}
+
+		if (mProjectionDirty)
+		{
+			XMMATRIX projection = XMMatrixPerspectiveFovLH(mFov, mWidth / mHeight, mNearZ, mFarZ);
+			XMStoreFloat4x4(&mMatrices.projection, projection);
+			XMStoreFloat4x4(&mMatrices.inverseProjection, XMMatrixInverse(nullptr, projection));
+			mProjectionDirty = false;
+		}
+
+		XMMATRIX viewProjection = XMLoadFloat4x4(&mMatrices.view) * XMLoadFloat4x4(&mMatrices.projection);
+		XMStoreFloat4x4(&mMatrices.viewProjection, viewProjection);
+		XMStoreFloat4x4(&mMatrices.inverseViewProjection, XMMatrixInverse(nullptr, viewProjection));
+		mFrustum = Frustum::FromViewProjection(viewProjection);
 	}
 
 	void Camera::SetFOV(float fov)
 	{
 		mFov = fov;
+		mProjectionDirty = true;
 	}
 
 	float Camera::GetFOV() const
@@ -182,6 +230,7 @@ namespace renderer
 	void Camera::SetNearZ(float nearZ)
 	{
 		mNearZ = nearZ;
+		mProjectionDirty = true;
 	}
 
 	float Camera::GetNearZ() const
@@ -192,6 +241,7 @@ namespace renderer
 	void Camera::SetFarZ(float farZ)
 	{
 		mFarZ = farZ;
+		mProjectionDirty = true;
 	}
 
 	float Camera::GetFarZ() const
@@ -202,6 +252,7 @@ namespace renderer
 	void Camera::SetWidth(float width)
 	{
 		mWidth = width;
+		mProjectionDirty = true;
 	}
 
 	float Camera::GetWidth() const
@@ -212,11 +263,49 @@ namespace renderer
 	void Camera::SetHeight(float height)
 	{
 		mHeight = height;
+		mProjectionDirty = true;
 	}
 
 	float Camera::GetHeight() const
 	{
 		return mHeight;
 	}
-}
 
+	void Camera::LookTo(XMVECTOR forward, XMVECTOR up)
+	{
+		XMVECTOR vForward = XMVector3Normalize(forward);
+		XMVECTOR right = XMVector3Cross(up, vForward);
+		if (XMVectorGetX(XMVector3LengthSq(right)) < 1e-12f)
+		{
+			// Up is parallel to forward so pick any perpendicular axis
+			right = XMVector3Cross(XMVectorSet(0, 0, 1, 0), vForward);
+			if (XMVectorGetX(XMVector3LengthSq(right)) < 1e-12f)
+			{
+				right = XMVector3Cross(XMVectorSet(1, 0, 0, 0), vForward);
+			}
+		}
+		right = XMVector3Normalize(right);
+		XMVECTOR vUp = XMVector3Cross(vForward, right);
+
+		// Rows of the camera to world rotation are the basis vectors
+		XMMATRIX rotation(right, vUp, vForward, XMVectorSet(0, 0, 0, 1));
+		mOrientation = VF4(XMQuaternionNormalize(XMQuaternionRotationMatrix(rotation)));
+		UpdateBasis();
+	}
+
+	void Camera::Rotate(XMVECTOR rotation)
+	{
+		// Apply the world space rotation after the current orientation and renormalize to stop drift
+		mOrientation = VF4(XMQuaternionNormalize(XMQuaternionMultiply(FV(mOrientation), rotation)));
+		UpdateBasis();
+	}
+
+	void Camera::UpdateBasis()
+	{
+		XMMATRIX rotation = XMMatrixRotationQuaternion(FV(mOrientation));
+		mRight = VF3(rotation.r[0]);
+		mUp = VF3(rotation.r[1]);
+		mForward = VF3(rotation.r[2]);
+		mViewDirty = true;
+	}
+}
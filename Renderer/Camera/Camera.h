@@ -1,11 +1,23 @@
 #pragma once
 
 #include "Minimal.h"
+#include "Culling/Frustum.h"
 
 using namespace DirectX;
 
 namespace renderer
 {
+	/** Matrices derived from the camera state. Cached by the camera and only rebuilt when it changes */
+	struct CameraMatrices
+	{
+		XMFLOAT4X4 view;
+		XMFLOAT4X4 projection;
+		XMFLOAT4X4 viewProjection;
+		XMFLOAT4X4 inverseView;
+		XMFLOAT4X4 inverseProjection;
+		XMFLOAT4X4 inverseViewProjection;
+	};
+
 	/** Allows for movement of the camera in the scene and calculates view projection matrix */
 	class Camera
 	{
@@ -20,14 +32,25 @@ namespace renderer
 		void MoveUpDown(float amount);
 		void SetPosition(XMFLOAT3 newPos);
 		XMFLOAT3 GetPosition() const;
+		void SetOrientation(XMFLOAT4 orientation);
+		XMFLOAT4 GetOrientation() const;
 		void SetTarget(XMFLOAT3 newTarget);
 		DirectX::XMFLOAT3 GetTarget() const;
 		void SetUp(XMFLOAT3 newUp);
 		XMFLOAT3 GetUp() const;
 		XMVECTOR GetForward() const;
+		XMVECTOR GetRight() const;
 		XMMATRIX GetView() const;
 		XMMATRIX GetProjection() const;
 		XMMATRIX GetViewProjection() const;
+		XMMATRIX GetInverseView() const;
+		XMMATRIX GetInverseProjection() const;
+		XMMATRIX GetInverseViewProjection() const;
+		// Returned references stay valid for the lifetime of the camera and are refreshed in place
+		const CameraMatrices& GetMatrices() const;
+		const Frustum& GetFrustum() const;
+		/** Rebuilds any stale cached data. Call once before sharing the camera with other threads */
+		void UpdateCache() const;
 		void SetFOV(float fov);
 		float GetFOV() const;
 		void SetNearZ(float nearZ);
@@ -40,13 +63,28 @@ namespace renderer
 		float GetHeight() const;
 
 	private:
+		void LookTo(XMVECTOR forward, XMVECTOR up);
+		void Rotate(XMVECTOR rotation);
+		void UpdateBasis();
+
 		XMFLOAT3 mPosition;
-		XMFLOAT3 mTarget;
+		// Rotation from camera space to world space. Kept normalized so the basis never drifts
+		XMFLOAT4 mOrientation;
+		// Distance along the forward vector to the point returned by GetTarget
+		float mTargetDistance;
+		// Basis derived from the orientation whenever it changes
+		XMFLOAT3 mForward;
 		XMFLOAT3 mUp;
+		XMFLOAT3 mRight;
 		float mWidth;
 		float mHeight;
 		float mFov;
 		float mNearZ;
 		float mFarZ;
+
+		mutable CameraMatrices mMatrices;
+		mutable Frustum mFrustum;
+		mutable bool mViewDirty;
+		mutable bool mProjectionDirty;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,260 @@
+#include "CameraTrack.h"
+#include "Camera.h"
+
+namespace renderer
+{
+	namespace
+	{
+		struct TrackHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint64_t sampleCount;
+		};
+
+		constexpr char TrackMagic[4] = { 'C', 'T', 'R', 'K' };
+		constexpr std::uint32_t TrackVersion = 2;
+
+		// Version 1 stored times as floats
+		constexpr std::uint32_t FloatTimeTrackVersion = 1;
+		struct FloatTimeSample
+		{
+			float time;
+			XMFLOAT3 position;
+			XMFLOAT4 orientation;
+		};
+
+		static_assert(sizeof(CameraSample) == 40, "Track files store samples as they are in memory");
+		static_assert(sizeof(FloatTimeSample) == 32, "Version 1 track files store samples as they were in memory");
+	}
+
+	CameraTrack::CameraTrack()
+		: mTime(0)
+	{
+
+	}
+
+	void CameraTrack::Clear()
+	{
+		mSamples.clear();
+		mTime = 0;
+	}
+
+	void CameraTrack::Record(const Camera& camera, double frameTime)
+	{
+		// Time is summed in double so long recordings do not drift
+		mTime += frameTime;
+		mSamples.push_back({ mTime, camera.GetPosition(), 0, camera.GetOrientation() });
+	}
+
+	const std::vector<CameraSample>& CameraTrack::GetSamples() const
+	{
+		return mSamples;
+	}
+
+	double CameraTrack::GetDuration() const
+	{
+		return mSamples.empty() ? 0 : mSamples.back().time;
+	}
+
+	void CameraTrack::Evaluate(double time, size_t& cursor, XMFLOAT3& position, XMFLOAT4& orientation) const
+	{
+		if (mSamples.empty())
+		{
+			return;
+		}
+
+		const size_t last = mSamples.size() - 1;
+		if (time <= mSamples[0].time || last == 0)
+		{
+			cursor = 0;
+			position = mSamples[0].position;
+			orientation = mSamples[0].orientation;
+			return;
+		}
+		if (time >= mSamples[last].time)
+		{
+			cursor = last;
+			position = mSamples[last].position;
+			orientation = mSamples[last].orientation;
+			return;
+		}
+
+		// Step forwards from the cursor, which is one or two samples when playing, and search when seeking back or far ahead
+		cursor = std::min(cursor, last - 1);
+		if (mSamples[cursor].time > time || (cursor + 2 <= last && mSamples[cursor + 2].time <= time))
+		{
+			auto next = std::upper_bound(mSamples.begin(), mSamples.end(), time, [](double t, const CameraSample& sample) { return t < sample.time; });
+			cursor = static_cast<size_t>(next - mSamples.begin()) - 1;
+		}
+		while (mSamples[cursor + 1].time <= time)
+		{
+			++cursor;
+		}
+
+		const CameraSample& a = mSamples[cursor];
+		const CameraSample& b = mSamples[cursor + 1];
+		const double span = b.time - a.time;
+		const float t = span > 0 ? static_cast<float>((time - a.time) / span) : 1.0f;
+		position = VF3(XMVectorLerp(FV(a.position), FV(b.position), t));
+		orientation = VF4(XMQuaternionSlerp(FV(a.orientation), FV(b.orientation), t));
+	}
+
+	bool CameraTrack::Save(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		TrackHeader header;
+		std::memcpy(header.magic, TrackMagic, sizeof(TrackMagic));
+		header.version = TrackVersion;
+		header.sampleCount = mSamples.size();
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(mSamples.data()), mSamples.size() * sizeof(CameraSample));
+		return static_cast<bool>(file);
+	}
+
+	bool CameraTrack::Load(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		TrackHeader header;
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, TrackMagic, sizeof(TrackMagic)) != 0 ||
+			(header.version != TrackVersion && header.version != FloatTimeTrackVersion))
+		{
+			return false;
+		}
+		const bool floatTimes = header.version == FloatTimeTrackVersion;
+		const std::uint64_t sampleSize = floatTimes ? sizeof(FloatTimeSample) : sizeof(CameraSample);
+
+		// The count has to match what is in the file before anything is allocated for it
+		const std::streamoff start = file.tellg();
+		file.seekg(0, std::ios::end);
+		const std::uint64_t remaining = static_cast<std::uint64_t>(file.tellg() - start);
+		file.seekg(start);
+		if (header.sampleCount != remaining / sampleSize || remaining % sampleSize != 0)
+		{
+			return false;
+		}
+
+		std::vector<CameraSample> samples(static_cast<size_t>(header.sampleCount));
+		if (floatTimes)
+		{
+			std::vector<FloatTimeSample> floatTimeSamples(samples.size());
+			if (!file.read(reinterpret_cast<char*>(floatTimeSamples.data()), floatTimeSamples.size() * sizeof(FloatTimeSample)))
+			{
+				return false;
+			}
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				const FloatTimeSample& sample = floatTimeSamples[i];
+				samples[i] = { sample.time, sample.position, 0, sample.orientation };
+			}
+		}
+		else if (!file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(CameraSample)))
+		{
+			return false;
+		}
+
+		// Evaluate searches the times, so they have to go up. Orientations that are off unit length by more than
+		// rounding are renormalized, as slerping between them would scale the camera's axes. The rest are kept to
+		// the bit so a loaded track replays exactly what was recorded
+		double previousTime = 0;
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			CameraSample& sample = samples[i];
+			const XMVECTOR orientation = XMLoadFloat4(&sample.orientation);
+			const float length = XMVectorGetX(XMVector4Length(orientation));
+			if (!std::isfinite(sample.time) || sample.time < 0 || (i > 0 && sample.time <= previousTime) ||
+				!std::isfinite(sample.position.x) || !std::isfinite(sample.position.y) || !std::isfinite(sample.position.z) ||
+				!std::isfinite(length) || std::abs(length - 1.0f) > 1e-3f)
+			{
+				return false;
+			}
+			if (std::abs(length - 1.0f) > 1e-5f)
+			{
+				XMStoreFloat4(&sample.orientation, XMVectorScale(orientation, 1.0f / length));
+			}
+			previousTime = sample.time;
+		}
+		mSamples = std::move(samples);
+		mTime = GetDuration();
+		return true;
+	}
+
+	CameraTrackPlayer::CameraTrackPlayer()
+		: mTrack(nullptr), mTimeStep(0), mTime(0), mFrame(0), mCursor(0)
+	{
+
+	}
+
+	void CameraTrackPlayer::Start(const CameraTrack* track, double timeStep)
+	{
+		mTrack = track;
+		mTimeStep = timeStep;
+		mTime = 0;
+		mFrame = 0;
+		mCursor = 0;
+	}
+
+	void CameraTrackPlayer::Stop()
+	{
+		mTrack = nullptr;
+	}
+
+	bool CameraTrackPlayer::IsPlaying() const
+	{
+		return mTrack != nullptr;
+	}
+
+	bool CameraTrackPlayer::Advance(Camera& camera, double& frameTime)
+	{
+		if (!mTrack)
+		{
+			return false;
+		}
+
+		const auto& samples = mTrack->GetSamples();
+		XMFLOAT3 position;
+		XMFLOAT4 orientation;
+		if (mTimeStep <= 0)
+		{
+			// Recorded frames are replayed as they were, so no interpolation is needed
+			if (mFrame >= samples.size())
+			{
+				Stop();
+				return false;
+			}
+			const CameraSample& sample = samples[mFrame];
+			frameTime = sample.time - mTime;
+			mTime = sample.time;
+			position = sample.position;
+			orientation = sample.orientation;
+		}
+		else
+		{
+			const double time = mFrame * mTimeStep;
+			if (samples.empty() || time > mTrack->GetDuration())
+			{
+				Stop();
+				return false;
+			}
+			frameTime = mTimeStep;
+			mTime = time;
+			mTrack->Evaluate(time, mCursor, position, orientation);
+		}
+
+		camera.SetPosition(position);
+		camera.SetOrientation(orientation);
+		++mFrame;
+		return true;
+	}
+
+	size_t CameraTrackPlayer::GetFrameIndex() const
+	{
+		return mFrame;
+	}
+}
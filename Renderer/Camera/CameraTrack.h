@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Minimal.h"
+
+using namespace DirectX;
+
+namespace renderer
+{
+	class Camera;
+
+	/** Camera state at one frame of a recording. 40 bytes, stored as is in track files */
+	struct CameraSample
+	{
+		// Seconds from the start of the recording to the end of the frame. A float would round frames of a long
+		// recording together
+		double time;
+		XMFLOAT3 position;
+		// Zero, so no byte of a sample is left to chance in a file
+		float padding;
+		XMFLOAT4 orientation;
+	};
+
+	/** Camera states recorded frame by frame, with their frame times, so a run can be replayed exactly */
+	class CameraTrack
+	{
+	public:
+		CameraTrack();
+		void Clear();
+		/** Appends the camera's state at the end of a frame that took frameTime seconds */
+		void Record(const Camera& camera, double frameTime);
+		const std::vector<CameraSample>& GetSamples() const;
+		double GetDuration() const;
+		/**
+		 * Interpolated position and orientation at the time. The cursor is the sample to search from and is moved to
+		 * the segment that was used, so playing forwards costs no search. Times outside the track clamp to its ends.
+		 */
+		void Evaluate(double time, size_t& cursor, XMFLOAT3& position, XMFLOAT4& orientation) const;
+
+		/** Track files are a small header then the samples, little endian */
+		bool Save(const std::string& path) const;
+		/**
+		 * Fails, leaving the track as it was, unless the file holds exactly the samples its header counts, with
+		 * finite values, times that go up and unit orientations. Files from before times were doubles still load
+		 */
+		bool Load(const std::string& path);
+
+	private:
+		std::vector<CameraSample> mSamples;
+		double mTime;
+	};
+
+	/** Drives a camera along a track one frame at a time */
+	class CameraTrackPlayer
+	{
+	public:
+		CameraTrackPlayer();
+		/** A time step of zero replays the recorded frames and frame times. Otherwise frames are that many seconds apart */
+		void Start(const CameraTrack* track, double timeStep = 0);
+		void Stop();
+		bool IsPlaying() const;
+		/** Moves the camera to the next frame and gives its frame time. Returns false once the track has finished */
+		bool Advance(Camera& camera, double& frameTime);
+		size_t GetFrameIndex() const;
+
+	private:
+		const CameraTrack* mTrack;
+		double mTimeStep;
+		double mTime;
+		size_t mFrame;
+		size_t mCursor;
+	};
+}
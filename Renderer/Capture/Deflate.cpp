@@ -0,0 +1,856 @@
+#include "Deflate.h"
+#include "Profiling/Profiler.h"
+#include <functional>
+#include <queue>
+
+namespace renderer
+{
+	namespace
+	{
+		constexpr std::uint32_t WindowSize = 32768;
+		constexpr std::uint32_t WindowMask = WindowSize - 1;
+		constexpr std::uint32_t MinMatch = 3;
+		constexpr std::uint32_t MaxMatch = 258;
+		constexpr std::uint32_t HashBits = 15;
+		constexpr size_t NoPosition = SIZE_MAX;
+		// Symbols gathered before a block is written. Larger blocks spread the code tables over more data but
+		// adapt less to data that changes
+		constexpr size_t BlockSymbols = 1u << 16;
+		constexpr size_t MaxStoredBlock = 65535;
+		constexpr std::uint32_t LiteralLengthCodes = 286;
+		constexpr std::uint32_t DistanceCodes = 30;
+		constexpr std::uint32_t CodeLengthCodes = 19;
+		constexpr std::uint32_t EndOfBlock = 256;
+		constexpr std::uint32_t MaxCodeLength = 15;
+		constexpr std::uint32_t MaxCodeLengthCodeLength = 7;
+
+		const std::uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131,
+			163, 195, 227, 258 };
+		const std::uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		const std::uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+			2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		const std::uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		const std::uint8_t CodeLengthOrder[CodeLengthCodes] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		/** Code of every match length, and of every distance through the low 256 and then in steps of 128 */
+		struct SymbolTables
+		{
+			std::uint8_t lengthCode[MaxMatch + 1];
+			std::uint8_t distanceCode[512];
+
+			SymbolTables()
+			{
+				for (std::uint32_t code = 0; code < 29; ++code)
+				{
+					for (std::uint32_t length = LengthBase[code]; length < LengthBase[code] + (1u << LengthExtra[code]) && length <= MaxMatch; ++length)
+					{
+						lengthCode[length] = static_cast<std::uint8_t>(code);
+					}
+				}
+				for (std::uint32_t code = 0; code < DistanceCodes; ++code)
+				{
+					for (std::uint32_t distance = DistanceBase[code] - 1; distance < DistanceBase[code] - 1 + (1u << DistanceExtra[code]); ++distance)
+					{
+						distanceCode[distance < 256 ? distance : 256 + (distance >> 7)] = static_cast<std::uint8_t>(code);
+					}
+				}
+			}
+
+			std::uint32_t GetDistanceCode(std::uint32_t distance) const
+			{
+				return distanceCode[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+			}
+		};
+
+		const SymbolTables& GetSymbolTables()
+		{
+			static const SymbolTables tables;
+			return tables;
+		}
+
+		/** A literal byte, or a match when the distance is not zero */
+		struct Symbol
+		{
+			std::uint16_t value;
+			std::uint16_t distance;
+		};
+
+		/** Writes bits from the least significant end, as deflate packs them */
+		class BitWriter
+		{
+		public:
+			explicit BitWriter(std::vector<std::uint8_t>& output)
+				: mOutput(output), mBuffer(0), mCount(0)
+			{
+
+			}
+
+			void Write(std::uint32_t bits, std::uint32_t count)
+			{
+				mBuffer |= static_cast<std::uint64_t>(bits) << mCount;
+				mCount += count;
+				if (mCount >= 32)
+				{
+					const auto word = static_cast<std::uint32_t>(mBuffer);
+					const std::uint8_t bytes[4] = { static_cast<std::uint8_t>(word), static_cast<std::uint8_t>(word >> 8),
+						static_cast<std::uint8_t>(word >> 16), static_cast<std::uint8_t>(word >> 24) };
+					mOutput.insert(mOutput.end(), bytes, bytes + 4);
+					mBuffer >>= 32;
+					mCount -= 32;
+				}
+			}
+
+			/** Pads to a whole byte and writes out everything buffered */
+			void Flush()
+			{
+				while (mCount > 0)
+				{
+					mOutput.push_back(static_cast<std::uint8_t>(mBuffer));
+					mBuffer >>= 8;
+					mCount = mCount > 8 ? mCount - 8 : 0;
+				}
+				mBuffer = 0;
+			}
+
+		private:
+			std::vector<std::uint8_t>& mOutput;
+			std::uint64_t mBuffer;
+			std::uint32_t mCount;
+		};
+
+		std::uint32_t ReverseBits(std::uint32_t code, std::uint32_t length)
+		{
+			std::uint32_t reversed = 0;
+			for (std::uint32_t i = 0; i < length; ++i)
+			{
+				reversed = (reversed << 1) | ((code >> i) & 1);
+			}
+			return reversed;
+		}
+
+		/**
+		 * Huffman code lengths of at most maxLength bits, zero for symbols that never occur. Lengths past the limit
+		 * are clamped and the code is made complete again by lengthening the shortest codes that can take it, as
+		 * miniz does, then handed out shortest first in order of frequency
+		 */
+		void BuildCodeLengths(const std::uint32_t* frequencies, std::uint32_t count, std::uint32_t maxLength, std::uint8_t* lengths)
+		{
+			std::fill(lengths, lengths + count, static_cast<std::uint8_t>(0));
+			std::vector<std::uint32_t> symbols;
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				if (frequencies[symbol] > 0)
+				{
+					symbols.push_back(symbol);
+				}
+			}
+			if (symbols.size() < 2)
+			{
+				for (std::uint32_t symbol : symbols)
+				{
+					lengths[symbol] = 1;
+				}
+				return;
+			}
+
+			// Leaves come first and every parent is made after its children, so depths follow in reverse order
+			const auto leafCount = static_cast<std::uint32_t>(symbols.size());
+			std::vector<std::uint32_t> parents(leafCount * 2 - 1, 0);
+			using Entry = std::pair<std::uint64_t, std::uint32_t>;
+			std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+			for (std::uint32_t leaf = 0; leaf < leafCount; ++leaf)
+			{
+				heap.push({ frequencies[symbols[leaf]], leaf });
+			}
+			std::uint32_t next = leafCount;
+			while (heap.size() > 1)
+			{
+				const Entry a = heap.top();
+				heap.pop();
+				const Entry b = heap.top();
+				heap.pop();
+				parents[a.second] = next;
+				parents[b.second] = next;
+				heap.push({ a.first + b.first, next });
+				++next;
+			}
+			std::vector<std::uint32_t> depths(next, 0);
+			std::uint32_t lengthCounts[64] = {};
+			for (std::uint32_t node = next - 1; node-- > 0;)
+			{
+				depths[node] = depths[parents[node]] + 1;
+				if (node < leafCount)
+				{
+					++lengthCounts[std::min(depths[node], maxLength)];
+				}
+			}
+
+			std::uint64_t kraft = 0;
+			for (std::uint32_t length = 1; length <= maxLength; ++length)
+			{
+				kraft += static_cast<std::uint64_t>(lengthCounts[length]) << (maxLength - length);
+			}
+			while (kraft > (1ull << maxLength))
+			{
+				--lengthCounts[maxLength];
+				for (std::uint32_t length = maxLength - 1; length > 0; --length)
+				{
+					if (lengthCounts[length] > 0)
+					{
+						--lengthCounts[length];
+						lengthCounts[length + 1] += 2;
+						break;
+					}
+				}
+				--kraft;
+			}
+
+			std::stable_sort(symbols.begin(), symbols.end(), [&](std::uint32_t a, std::uint32_t b)
+			{
+				return frequencies[a] > frequencies[b];
+			});
+			size_t symbol = 0;
+			for (std::uint32_t length = 1; length <= maxLength; ++length)
+			{
+				for (std::uint32_t i = 0; i < lengthCounts[length]; ++i)
+				{
+					lengths[symbols[symbol++]] = static_cast<std::uint8_t>(length);
+				}
+			}
+		}
+
+		/** Canonical codes for the lengths, bit reversed to be written least significant bit first */
+		void BuildCodes(const std::uint8_t* lengths, std::uint32_t count, std::uint16_t* codes)
+		{
+			std::uint32_t lengthCounts[MaxCodeLength + 1] = {};
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				++lengthCounts[lengths[symbol]];
+			}
+			lengthCounts[0] = 0;
+			std::uint32_t nextCode[MaxCodeLength + 1] = {};
+			std::uint32_t code = 0;
+			for (std::uint32_t length = 1; length <= MaxCodeLength; ++length)
+			{
+				code = (code + lengthCounts[length - 1]) << 1;
+				nextCode[length] = code;
+			}
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				const std::uint32_t length = lengths[symbol];
+				codes[symbol] = length > 0 ? static_cast<std::uint16_t>(ReverseBits(nextCode[length]++, length)) : 0;
+			}
+		}
+
+		/** Decoders that meet a code with one symbol need a second one to be well formed, so unused ones are made up */
+		void EnsureTwoSymbols(std::uint32_t* frequencies, std::uint32_t count)
+		{
+			std::uint32_t used = 0;
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				used += frequencies[symbol] > 0 ? 1 : 0;
+			}
+			for (std::uint32_t symbol = 0; symbol < count && used < 2; ++symbol)
+			{
+				if (frequencies[symbol] == 0)
+				{
+					frequencies[symbol] = 1;
+					++used;
+				}
+			}
+		}
+
+		void WriteStoredBlocks(BitWriter& writer, std::vector<std::uint8_t>& output, const std::uint8_t* data, size_t size, bool final)
+		{
+			size_t offset = 0;
+			do
+			{
+				const size_t length = std::min(size - offset, MaxStoredBlock);
+				const bool last = offset + length == size;
+				writer.Write(final && last ? 1 : 0, 1);
+				writer.Write(0, 2);
+				writer.Flush();
+				writer.Write(static_cast<std::uint32_t>(length), 16);
+				writer.Write(static_cast<std::uint32_t>(~length & 0xFFFF), 16);
+				writer.Flush();
+				output.insert(output.end(), data + offset, data + offset + length);
+				offset += length;
+			} while (offset < size);
+		}
+
+		/** Writes the symbols as one block with codes built for them, or the bytes they cover stored if that is smaller */
+		void WriteBlock(BitWriter& writer, std::vector<std::uint8_t>& output, const std::vector<Symbol>& symbols, const std::uint8_t* data,
+			size_t size, bool final)
+		{
+			const SymbolTables& tables = GetSymbolTables();
+			std::uint32_t literalFrequencies[LiteralLengthCodes] = {};
+			std::uint32_t distanceFrequencies[DistanceCodes] = {};
+			for (const Symbol& symbol : symbols)
+			{
+				if (symbol.distance == 0)
+				{
+					++literalFrequencies[symbol.value];
+				}
+				else
+				{
+					++literalFrequencies[257 + tables.lengthCode[symbol.value]];
+					++distanceFrequencies[tables.GetDistanceCode(symbol.distance)];
+				}
+			}
+			literalFrequencies[EndOfBlock] = 1;
+			EnsureTwoSymbols(literalFrequencies, LiteralLengthCodes);
+			EnsureTwoSymbols(distanceFrequencies, DistanceCodes);
+
+			std::uint8_t lengths[LiteralLengthCodes + DistanceCodes];
+			BuildCodeLengths(literalFrequencies, LiteralLengthCodes, MaxCodeLength, lengths);
+			std::uint8_t* distanceLengths = lengths + LiteralLengthCodes;
+			BuildCodeLengths(distanceFrequencies, DistanceCodes, MaxCodeLength, distanceLengths);
+			std::uint32_t literalCount = LiteralLengthCodes;
+			while (literalCount > 257 && lengths[literalCount - 1] == 0)
+			{
+				--literalCount;
+			}
+			std::uint32_t distanceCount = DistanceCodes;
+			while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0)
+			{
+				--distanceCount;
+			}
+
+			// The two length tables are sent as one run, with repeats of zeros and of the previous length shortened
+			std::uint8_t joined[LiteralLengthCodes + DistanceCodes];
+			std::copy(lengths, lengths + literalCount, joined);
+			std::copy(distanceLengths, distanceLengths + distanceCount, joined + literalCount);
+			const std::uint32_t joinedCount = literalCount + distanceCount;
+			struct LengthSymbol
+			{
+				std::uint8_t code;
+				std::uint8_t extra;
+			};
+			std::vector<LengthSymbol> lengthSymbols;
+			std::uint32_t codeLengthFrequencies[CodeLengthCodes] = {};
+			for (std::uint32_t i = 0; i < joinedCount;)
+			{
+				const std::uint8_t length = joined[i];
+				std::uint32_t run = 1;
+				while (i + run < joinedCount && joined[i + run] == length)
+				{
+					++run;
+				}
+				std::uint32_t left = run;
+				if (length == 0)
+				{
+					while (left >= 11)
+					{
+						const std::uint32_t take = std::min(left, 138u);
+						lengthSymbols.push_back({ 18, static_cast<std::uint8_t>(take - 11) });
+						left -= take;
+					}
+					if (left >= 3)
+					{
+						lengthSymbols.push_back({ 17, static_cast<std::uint8_t>(left - 3) });
+						left = 0;
+					}
+				}
+				else if (left >= 4)
+				{
+					lengthSymbols.push_back({ length, 0 });
+					--left;
+					while (left >= 3)
+					{
+						const std::uint32_t take = std::min(left, 6u);
+						lengthSymbols.push_back({ 16, static_cast<std::uint8_t>(take - 3) });
+						left -= take;
+					}
+				}
+				for (; left > 0; --left)
+				{
+					lengthSymbols.push_back({ length, 0 });
+				}
+				i += run;
+			}
+			for (const LengthSymbol& symbol : lengthSymbols)
+			{
+				++codeLengthFrequencies[symbol.code];
+			}
+			EnsureTwoSymbols(codeLengthFrequencies, CodeLengthCodes);
+			std::uint8_t codeLengthLengths[CodeLengthCodes];
+			BuildCodeLengths(codeLengthFrequencies, CodeLengthCodes, MaxCodeLengthCodeLength, codeLengthLengths);
+			std::uint32_t codeLengthCount = CodeLengthCodes;
+			while (codeLengthCount > 4 && codeLengthLengths[CodeLengthOrder[codeLengthCount - 1]] == 0)
+			{
+				--codeLengthCount;
+			}
+
+			// Sizes in bits of the block both ways
+			std::uint64_t dynamicBits = 3 + 5 + 5 + 4 + 3 * codeLengthCount;
+			for (const LengthSymbol& symbol : lengthSymbols)
+			{
+				dynamicBits += codeLengthLengths[symbol.code] + (symbol.code == 16 ? 2 : symbol.code == 17 ? 3 : symbol.code == 18 ? 7 : 0);
+			}
+			for (std::uint32_t code = 0; code < LiteralLengthCodes; ++code)
+			{
+				dynamicBits += static_cast<std::uint64_t>(literalFrequencies[code]) * (lengths[code] + (code > 256 ? LengthExtra[code - 257] : 0));
+			}
+			for (std::uint32_t code = 0; code < DistanceCodes; ++code)
+			{
+				dynamicBits += static_cast<std::uint64_t>(distanceFrequencies[code]) * (distanceLengths[code] + DistanceExtra[code]);
+			}
+			const std::uint64_t storedBits = (size / MaxStoredBlock + 1) * (3 + 7 + 32) + size * 8;
+			if (storedBits < dynamicBits)
+			{
+				WriteStoredBlocks(writer, output, data, size, final);
+				return;
+			}
+
+			writer.Write(final ? 1 : 0, 1);
+			writer.Write(2, 2);
+			writer.Write(literalCount - 257, 5);
+			writer.Write(distanceCount - 1, 5);
+			writer.Write(codeLengthCount - 4, 4);
+			for (std::uint32_t i = 0; i < codeLengthCount; ++i)
+			{
+				writer.Write(codeLengthLengths[CodeLengthOrder[i]], 3);
+			}
+			std::uint16_t codeLengthCodes[CodeLengthCodes];
+			BuildCodes(codeLengthLengths, CodeLengthCodes, codeLengthCodes);
+			for (const LengthSymbol& symbol : lengthSymbols)
+			{
+				writer.Write(codeLengthCodes[symbol.code], codeLengthLengths[symbol.code]);
+				if (symbol.code >= 16)
+				{
+					writer.Write(symbol.extra, symbol.code == 16 ? 2 : symbol.code == 17 ? 3 : 7);
+				}
+			}
+
+			std::uint16_t literalCodes[LiteralLengthCodes];
+			std::uint16_t distanceCodes[DistanceCodes];
+			BuildCodes(lengths, LiteralLengthCodes, literalCodes);
+			BuildCodes(distanceLengths, DistanceCodes, distanceCodes);
+			for (const Symbol& symbol : symbols)
+			{
+				if (symbol.distance == 0)
+				{
+					writer.Write(literalCodes[symbol.value], lengths[symbol.value]);
+					continue;
+				}
+				const std::uint32_t lengthCode = tables.lengthCode[symbol.value];
+				writer.Write(literalCodes[257 + lengthCode], lengths[257 + lengthCode]);
+				writer.Write(symbol.value - LengthBase[lengthCode], LengthExtra[lengthCode]);
+				const std::uint32_t distanceCode = tables.GetDistanceCode(symbol.distance);
+				writer.Write(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+				writer.Write(symbol.distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+			}
+			writer.Write(literalCodes[EndOfBlock], lengths[EndOfBlock]);
+		}
+
+		/** Reads bits from the least significant end. Reading past the end gives zeros and marks the stream as overrun */
+		class BitReader
+		{
+		public:
+			BitReader(const std::uint8_t* data, size_t size)
+				: mData(data), mSize(size), mPosition(0), mBuffer(0), mCount(0), mOverrun(false)
+			{
+
+			}
+
+			std::uint32_t Read(std::uint32_t count)
+			{
+				while (mCount < count)
+				{
+					if (mPosition == mSize)
+					{
+						mOverrun = true;
+						return 0;
+					}
+					mBuffer |= static_cast<std::uint64_t>(mData[mPosition++]) << mCount;
+					mCount += 8;
+				}
+				const auto bits = static_cast<std::uint32_t>(mBuffer & ((1ull << count) - 1));
+				mBuffer >>= count;
+				mCount -= count;
+				return bits;
+			}
+
+			/** Drops the bits left of the current byte and returns where the next whole byte is */
+			size_t AlignToByte()
+			{
+				mBuffer = 0;
+				mCount = 0;
+				return mPosition;
+			}
+
+			void Skip(size_t bytes)
+			{
+				mPosition += bytes;
+			}
+
+			bool IsOverrun() const
+			{
+				return mOverrun;
+			}
+
+		private:
+			const std::uint8_t* mData;
+			size_t mSize;
+			size_t mPosition;
+			std::uint64_t mBuffer;
+			std::uint32_t mCount;
+			bool mOverrun;
+		};
+
+		/** Canonical code as a count of codes of each length and the symbols in code order */
+		struct HuffmanTable
+		{
+			std::uint16_t counts[MaxCodeLength + 1];
+			std::uint16_t symbols[LiteralLengthCodes + 2];
+		};
+
+		/** Fails if the lengths describe more codes than fit. Codes with room left over are allowed, as zlib allows them */
+		bool BuildTable(const std::uint8_t* lengths, std::uint32_t count, HuffmanTable& table)
+		{
+			std::fill(table.counts, table.counts + MaxCodeLength + 1, static_cast<std::uint16_t>(0));
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				++table.counts[lengths[symbol]];
+			}
+			std::int32_t left = 1;
+			for (std::uint32_t length = 1; length <= MaxCodeLength; ++length)
+			{
+				left = (left << 1) - table.counts[length];
+				if (left < 0)
+				{
+					return false;
+				}
+			}
+			std::uint16_t offsets[MaxCodeLength + 1];
+			offsets[1] = 0;
+			for (std::uint32_t length = 1; length < MaxCodeLength; ++length)
+			{
+				offsets[length + 1] = offsets[length] + table.counts[length];
+			}
+			for (std::uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				if (lengths[symbol] != 0)
+				{
+					table.symbols[offsets[lengths[symbol]]++] = static_cast<std::uint16_t>(symbol);
+				}
+			}
+			return true;
+		}
+
+		/** Next symbol, read a bit at a time, or -1 for a code the table does not have */
+		int DecodeSymbol(BitReader& reader, const HuffmanTable& table)
+		{
+			std::int32_t code = 0;
+			std::int32_t first = 0;
+			std::int32_t index = 0;
+			for (std::uint32_t length = 1; length <= MaxCodeLength; ++length)
+			{
+				code |= static_cast<std::int32_t>(reader.Read(1));
+				const std::int32_t count = table.counts[length];
+				if (code - count < first)
+				{
+					return table.symbols[index + (code - first)];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+		bool InflateCodes(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, std::vector<std::uint8_t>& output, size_t start)
+		{
+			for (;;)
+			{
+				const int symbol = DecodeSymbol(reader, literals);
+				if (symbol < 0 || reader.IsOverrun())
+				{
+					return false;
+				}
+				if (symbol < 256)
+				{
+					output.push_back(static_cast<std::uint8_t>(symbol));
+					continue;
+				}
+				if (symbol == EndOfBlock)
+				{
+					return true;
+				}
+				const int lengthCode = symbol - 257;
+				if (lengthCode >= 29)
+				{
+					return false;
+				}
+				const std::uint32_t length = LengthBase[lengthCode] + reader.Read(LengthExtra[lengthCode]);
+				const int distanceCode = DecodeSymbol(reader, distances);
+				if (distanceCode < 0 || distanceCode >= static_cast<int>(DistanceCodes))
+				{
+					return false;
+				}
+				const std::uint32_t distance = DistanceBase[distanceCode] + reader.Read(DistanceExtra[distanceCode]);
+				if (distance > output.size() - start || reader.IsOverrun())
+				{
+					return false;
+				}
+				// Byte by byte, since a match may overlap what it is copying
+				size_t from = output.size() - distance;
+				for (std::uint32_t i = 0; i < length; ++i)
+				{
+					output.push_back(output[from++]);
+				}
+			}
+		}
+	}
+
+	void Deflate::Compress(const std::uint8_t* data, size_t size, std::vector<std::uint8_t>& output, DeflateLevel level)
+	{
+		PROFILE_ZONE("Deflate::Compress");
+		// Longer chains find longer repeats, and a match at least nice long ends the search
+		const std::uint32_t maxChain = level == DeflateLevel::Fast ? 8 : level == DeflateLevel::Default ? 32 : 512;
+		const std::uint32_t niceLength = level == DeflateLevel::Fast ? 32 : level == DeflateLevel::Default ? 128 : MaxMatch;
+
+		// 32K window, level chosen by the compression level, and the check bits that make the header a multiple of 31
+		const std::uint32_t levelBits = level == DeflateLevel::Fast ? 1 : level == DeflateLevel::Default ? 2 : 3;
+		std::uint32_t header = (0x78 << 8) | (levelBits << 6);
+		header += 31 - header % 31;
+		output.push_back(static_cast<std::uint8_t>(header >> 8));
+		output.push_back(static_cast<std::uint8_t>(header));
+
+		BitWriter writer(output);
+		std::vector<size_t> heads(1u << HashBits, NoPosition);
+		std::vector<size_t> previous(WindowSize, NoPosition);
+		auto hash = [&](size_t position)
+		{
+			const std::uint32_t bytes = (static_cast<std::uint32_t>(data[position]) << 16) | (static_cast<std::uint32_t>(data[position + 1]) << 8) |
+				data[position + 2];
+			return (bytes * 2654435761u) >> (32 - HashBits);
+		};
+		auto insert = [&](size_t position)
+		{
+			const std::uint32_t key = hash(position);
+			previous[position & WindowMask] = heads[key];
+			heads[key] = position;
+		};
+
+		std::vector<Symbol> symbols;
+		symbols.reserve(BlockSymbols);
+		size_t blockStart = 0;
+		size_t position = 0;
+		while (position < size)
+		{
+			std::uint32_t bestLength = 0;
+			std::uint32_t bestDistance = 0;
+			if (position + MinMatch <= size)
+			{
+				const auto maxLength = static_cast<std::uint32_t>(std::min<size_t>(MaxMatch, size - position));
+				const size_t limit = position > WindowSize ? position - WindowSize : 0;
+				const std::uint8_t* current = data + position;
+				size_t candidate = heads[hash(position)];
+				for (std::uint32_t chain = maxChain; candidate != NoPosition && candidate >= limit && chain > 0; --chain)
+				{
+					const std::uint8_t* earlier = data + candidate;
+					// The byte that would make the match longer than the best is checked first, as most candidates fail on it
+					if (earlier[bestLength] == current[bestLength] && earlier[0] == current[0])
+					{
+						std::uint32_t length = 1;
+						while (length < maxLength && earlier[length] == current[length])
+						{
+							++length;
+						}
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestDistance = static_cast<std::uint32_t>(position - candidate);
+							if (length >= niceLength || length == maxLength)
+							{
+								break;
+							}
+						}
+					}
+					candidate = previous[candidate & WindowMask];
+				}
+				insert(position);
+			}
+
+			if (bestLength >= MinMatch)
+			{
+				symbols.push_back({ static_cast<std::uint16_t>(bestLength), static_cast<std::uint16_t>(bestDistance) });
+				const size_t end = position + bestLength;
+				for (++position; position < end; ++position)
+				{
+					if (position + MinMatch <= size)
+					{
+						insert(position);
+					}
+				}
+			}
+			else
+			{
+				symbols.push_back({ data[position], 0 });
+				++position;
+			}
+
+			if (symbols.size() == BlockSymbols)
+			{
+				WriteBlock(writer, output, symbols, data + blockStart, position - blockStart, position == size);
+				symbols.clear();
+				blockStart = position;
+				if (position == size)
+				{
+					break;
+				}
+			}
+		}
+		if (blockStart < size || size == 0)
+		{
+			WriteBlock(writer, output, symbols, data + blockStart, size - blockStart, true);
+		}
+		writer.Flush();
+
+		const std::uint32_t adler = Adler32(data, size);
+		const std::uint8_t checksum[4] = { static_cast<std::uint8_t>(adler >> 24), static_cast<std::uint8_t>(adler >> 16),
+			static_cast<std::uint8_t>(adler >> 8), static_cast<std::uint8_t>(adler) };
+		output.insert(output.end(), checksum, checksum + 4);
+	}
+
+	bool Deflate::Decompress(const std::uint8_t* data, size_t size, std::vector<std::uint8_t>& output)
+	{
+		PROFILE_ZONE("Deflate::Decompress");
+		// Deflate with a window of at most 32K and no preset dictionary
+		if (size < 6 || (data[0] & 0x0F) != 8 || (data[0] >> 4) > 7 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0)
+		{
+			return false;
+		}
+
+		const size_t start = output.size();
+		BitReader reader(data + 2, size - 2);
+		bool final = false;
+		while (!final)
+		{
+			final = reader.Read(1) != 0;
+			const std::uint32_t type = reader.Read(2);
+			if (type == 0)
+			{
+				const size_t offset = reader.AlignToByte();
+				if (offset + 4 > size - 2)
+				{
+					return false;
+				}
+				const std::uint8_t* block = data + 2 + offset;
+				const std::uint32_t length = block[0] | (block[1] << 8);
+				const std::uint32_t check = block[2] | (block[3] << 8);
+				if ((length ^ 0xFFFF) != check || offset + 4 + length > size - 2)
+				{
+					return false;
+				}
+				output.insert(output.end(), block + 4, block + 4 + length);
+				reader.Skip(4 + length);
+				continue;
+			}
+
+			HuffmanTable literals;
+			HuffmanTable distances;
+			std::uint8_t lengths[LiteralLengthCodes + 2 + DistanceCodes + 2] = {};
+			if (type == 1)
+			{
+				// Fixed codes of RFC 1951 3.2.6
+				std::fill(lengths, lengths + 144, static_cast<std::uint8_t>(8));
+				std::fill(lengths + 144, lengths + 256, static_cast<std::uint8_t>(9));
+				std::fill(lengths + 256, lengths + 280, static_cast<std::uint8_t>(7));
+				std::fill(lengths + 280, lengths + 288, static_cast<std::uint8_t>(8));
+				BuildTable(lengths, 288, literals);
+				std::fill(lengths, lengths + 30, static_cast<std::uint8_t>(5));
+				BuildTable(lengths, 30, distances);
+			}
+			else if (type == 2)
+			{
+				const std::uint32_t literalCount = reader.Read(5) + 257;
+				const std::uint32_t distanceCount = reader.Read(5) + 1;
+				const std::uint32_t codeLengthCount = reader.Read(4) + 4;
+				if (literalCount > LiteralLengthCodes || distanceCount > DistanceCodes)
+				{
+					return false;
+				}
+				std::uint8_t codeLengthLengths[CodeLengthCodes] = {};
+				for (std::uint32_t i = 0; i < codeLengthCount; ++i)
+				{
+					codeLengthLengths[CodeLengthOrder[i]] = static_cast<std::uint8_t>(reader.Read(3));
+				}
+				HuffmanTable codeLengths;
+				if (!BuildTable(codeLengthLengths, CodeLengthCodes, codeLengths))
+				{
+					return false;
+				}
+				for (std::uint32_t i = 0; i < literalCount + distanceCount;)
+				{
+					const int symbol = DecodeSymbol(reader, codeLengths);
+					if (symbol < 0 || reader.IsOverrun())
+					{
+						return false;
+					}
+					if (symbol < 16)
+					{
+						lengths[i++] = static_cast<std::uint8_t>(symbol);
+						continue;
+					}
+					if (symbol == 16 && i == 0)
+					{
+						return false;
+					}
+					const std::uint8_t repeated = symbol == 16 ? lengths[i - 1] : 0;
+					const std::uint32_t repeat = symbol == 16 ? 3 + reader.Read(2) : symbol == 17 ? 3 + reader.Read(3) : 11 + reader.Read(7);
+					if (i + repeat > literalCount + distanceCount)
+					{
+						return false;
+					}
+					std::fill(lengths + i, lengths + i + repeat, repeated);
+					i += repeat;
+				}
+				if (lengths[EndOfBlock] == 0 || !BuildTable(lengths, literalCount, literals) ||
+					!BuildTable(lengths + literalCount, distanceCount, distances))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+			if (!InflateCodes(reader, literals, distances, output, start))
+			{
+				return false;
+			}
+		}
+
+		const size_t offset = reader.AlignToByte();
+		if (reader.IsOverrun() || offset + 4 > size - 2)
+		{
+			return false;
+		}
+		const std::uint8_t* checksum = data + 2 + offset;
+		const std::uint32_t expected = (static_cast<std::uint32_t>(checksum[0]) << 24) | (checksum[1] << 16) | (checksum[2] << 8) | checksum[3];
+		return Adler32(output.data() + start, output.size() - start) == expected;
+	}
+
+	std::uint32_t Deflate::Adler32(const std::uint8_t* data, size_t size, std::uint32_t adler)
+	{
+		std::uint32_t a = adler & 0xFFFF;
+		std::uint32_t b = adler >> 16;
+		while (size > 0)
+		{
+			// The most bytes before the sums can overflow 32 bits
+			const size_t run = std::min<size_t>(size, 5552);
+			for (size_t i = 0; i < run; ++i)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += run;
+			size -= run;
+		}
+		return (b << 16) | a;
+	}
+}
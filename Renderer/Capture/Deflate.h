@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Minimal.h"
+
+namespace renderer
+{
+	/** How hard the compressor looks for repeats. Slower levels follow longer chains of earlier matches */
+	enum class DeflateLevel
+	{
+		Fast,
+		Default,
+		Best
+	};
+
+	/**
+	 * Compresses and decompresses zlib streams (RFC 1950 around RFC 1951 deflate), as PNG stores its pixels.
+	 * Compression finds repeats through hash chains over a 32 KB window and writes blocks with Huffman codes built
+	 * for them, or stores blocks as they are when that is smaller. Decompression reads any valid stream, so files
+	 * from other encoders load too.
+	 */
+	class Deflate
+	{
+	public:
+		/** Appends the zlib stream of the data to the output */
+		static void Compress(const std::uint8_t* data, size_t size, std::vector<std::uint8_t>& output, DeflateLevel level = DeflateLevel::Default);
+		/** Appends the decompressed data to the output. Fails on a malformed stream or a wrong checksum */
+		static bool Decompress(const std::uint8_t* data, size_t size, std::vector<std::uint8_t>& output);
+		static std::uint32_t Adler32(const std::uint8_t* data, size_t size, std::uint32_t adler = 1);
+	};
+}
@@ -0,0 +1,202 @@
+#include "FrameCapture.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	FrameCapture::FrameCapture(const FrameCaptureConfig& config)
+		: mConfig(config), mSlots(std::max(config.bufferCount, 1u)), mFree(std::max(config.bufferCount, 1u)), mJobs(std::max(config.bufferCount, 1u)),
+		mSleeping(0), mPending(0), mStopping(false), mSubmitted(0), mWritten(0), mDropped(0), mFailed(0), mBytes(0), mEncodeNanoseconds(0),
+		mCallNanoseconds(0)
+	{
+		for (std::uint32_t slot = 0; slot < mSlots.size(); ++slot)
+		{
+			mFree.TryPush(slot);
+		}
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		const std::uint32_t threadCount = mConfig.threadCount > 0 ? mConfig.threadCount : std::max(hardwareThreads - 1, 1u);
+		mEncoders.reserve(threadCount);
+		for (std::uint32_t thread = 0; thread < threadCount; ++thread)
+		{
+			mEncoders.emplace_back(&FrameCapture::EncoderThread, this);
+		}
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mWake.notify_all();
+		for (auto& encoder : mEncoders)
+		{
+			encoder.join();
+		}
+	}
+
+	Image* FrameCapture::Acquire(std::uint32_t width, std::uint32_t height)
+	{
+		const std::uint64_t start = Profiler::Now();
+		std::uint32_t index = 0;
+		if (!mFree.TryPop(index))
+		{
+			if (mConfig.dropWhenBusy)
+			{
+				++mDropped;
+				mCallNanoseconds += Profiler::Now() - start;
+				return nullptr;
+			}
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDone.wait(lock, [&]() { return mFree.TryPop(index); });
+		}
+		Slot& slot = mSlots[index];
+		slot.image.Resize(width, height);
+		slot.memory.Set(GetCapacityBytes(slot.image.pixels));
+		mCallNanoseconds += Profiler::Now() - start;
+		return &slot.image;
+	}
+
+	std::future<FrameCaptureResult> FrameCapture::Submit(Image* image, const std::string& path, ImageFormat format)
+	{
+		std::promise<FrameCaptureResult> promise;
+		std::future<FrameCaptureResult> future = promise.get_future();
+		Submit(image, path, format, std::move(promise));
+		return future;
+	}
+
+	void FrameCapture::Submit(Image* image, const std::string& path, ImageFormat format, std::promise<FrameCaptureResult> promise)
+	{
+		const std::uint64_t start = Profiler::Now();
+		std::uint32_t index = 0;
+		while (index < mSlots.size() && &mSlots[index].image != image)
+		{
+			++index;
+		}
+		assert(index < mSlots.size());
+		Slot& slot = mSlots[index];
+		slot.path = path;
+		slot.format = format;
+		slot.promise = std::move(promise);
+		++mPending;
+		++mSubmitted;
+		// The queue has room for every slot, so this cannot fail
+		mJobs.TryPush(index);
+
+		// An encoder going to sleep counts itself and then looks at the queue, so either it sees this frame or
+		// this sees it asleep. The lock is taken so the wake cannot come between its look and its wait
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mSleeping.load(std::memory_order_relaxed) > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+			}
+			mWake.notify_one();
+		}
+		mCallNanoseconds += Profiler::Now() - start;
+	}
+
+	std::future<FrameCaptureResult> FrameCapture::Capture(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t rowPitch,
+		const std::string& path, ImageFormat format)
+	{
+		Image* image = Acquire(width, height);
+		if (!image)
+		{
+			FrameCaptureResult result;
+			result.dropped = true;
+			result.path = path;
+			std::promise<FrameCaptureResult> promise;
+			promise.set_value(result);
+			return promise.get_future();
+		}
+
+		const std::uint64_t start = Profiler::Now();
+		const size_t rowSize = static_cast<size_t>(width) * 4;
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			std::memcpy(image->pixels.data() + y * rowSize, pixels + static_cast<size_t>(y) * rowPitch, rowSize);
+		}
+		mCallNanoseconds += Profiler::Now() - start;
+		return Submit(image, path, format);
+	}
+
+	void FrameCapture::Flush()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [&]() { return mPending.load() == 0; });
+	}
+
+	FrameCaptureStats FrameCapture::GetStats() const
+	{
+		FrameCaptureStats stats;
+		stats.submitted = mSubmitted.load();
+		stats.written = mWritten.load();
+		stats.dropped = mDropped.load();
+		stats.failed = mFailed.load();
+		stats.bytes = mBytes.load();
+		stats.encodeMilliseconds = mEncodeNanoseconds.load() / 1e6;
+		stats.callMilliseconds = mCallNanoseconds.load() / 1e6;
+		return stats;
+	}
+
+	std::uint32_t FrameCapture::GetThreadCount() const
+	{
+		return static_cast<std::uint32_t>(mEncoders.size());
+	}
+
+	void FrameCapture::EncoderThread()
+	{
+		Profiler::SetThreadName("Frame encoder");
+		// Kept between frames so encoding does not allocate once it has grown to the frame size
+		std::vector<std::uint8_t> bytes;
+		for (;;)
+		{
+			std::uint32_t index = 0;
+			if (mJobs.TryPop(index))
+			{
+				Encode(index, bytes);
+				continue;
+			}
+
+			// Frames submitted before stopping are all written first
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (mStopping)
+			{
+				return;
+			}
+			++mSleeping;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			mWake.wait(lock, [&]() { return mStopping || mJobs.GetSizeHint() > 0; });
+			--mSleeping;
+		}
+	}
+
+	void FrameCapture::Encode(std::uint32_t index, std::vector<std::uint8_t>& bytes)
+	{
+		PROFILE_ZONE("FrameCapture::Encode");
+		const std::uint64_t start = Profiler::Now();
+		Slot& slot = mSlots[index];
+		bytes.clear();
+		ImageFile::Encode(slot.image, slot.format, bytes, mConfig.level);
+
+		FrameCaptureResult result;
+		result.written = ImageFile::WriteFile(slot.path, bytes);
+		result.path = std::move(slot.path);
+		result.bytes = bytes.size();
+		const std::uint64_t elapsed = Profiler::Now() - start;
+		result.encodeMilliseconds = elapsed / 1e6;
+		++(result.written ? mWritten : mFailed);
+		mBytes += result.written ? bytes.size() : 0;
+		mEncodeNanoseconds += elapsed;
+
+		// The buffer goes back before the future is ready, so a caller that waits for one frame can capture the
+		// next without it being dropped
+		std::promise<FrameCaptureResult> promise = std::move(slot.promise);
+		mFree.TryPush(index);
+		promise.set_value(std::move(result));
+		--mPending;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+		}
+		mDone.notify_all();
+	}
+}
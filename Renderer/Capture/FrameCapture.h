@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Base/BoundedQueue.h"
+#include "Rendering/ImageFile.h"
+#include "Memory/MemoryTracker.h"
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace renderer
+{
+	struct FrameCaptureConfig
+	{
+		// Frames that can wait for or be in encoding at once, each holding a buffer the size of the frame
+		std::uint32_t bufferCount = 4;
+		// Encoder threads. Zero leaves one hardware thread for rendering and encodes on the rest
+		std::uint32_t threadCount = 0;
+		DeflateLevel level = DeflateLevel::Fast;
+		// Drops frames captured while every buffer is taken, rather than making the caller wait for one
+		bool dropWhenBusy = true;
+	};
+
+	struct FrameCaptureResult
+	{
+		bool written = false;
+		// No buffer was free, so the frame was never encoded
+		bool dropped = false;
+		std::string path;
+		size_t bytes = 0;
+		double encodeMilliseconds = 0;
+	};
+
+	struct FrameCaptureStats
+	{
+		std::uint64_t submitted = 0;
+		std::uint64_t written = 0;
+		std::uint64_t dropped = 0;
+		// Encoded but not written, as when the directory does not exist
+		std::uint64_t failed = 0;
+		std::uint64_t bytes = 0;
+		// On the encoder threads
+		double encodeMilliseconds = 0;
+		// In Acquire, Submit and Capture on the capturing threads, which is what capturing costs rendering
+		double callMilliseconds = 0;
+	};
+
+	/**
+	 * Writes frames to image files without holding up the thread that renders them. A frame is copied into one of
+	 * a fixed pool of buffers and its slot handed to encoder threads through a lock free queue, and the future
+	 * returned for it is ready once the file is written. Buffers come back to the pool as files are written, so
+	 * capturing faster than the encoders keep up drops frames, or waits for a buffer if configured to.
+	 */
+	class FrameCapture
+	{
+	public:
+		explicit FrameCapture(const FrameCaptureConfig& config = FrameCaptureConfig());
+		/** Writes the frames already submitted before returning */
+		~FrameCapture();
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		/**
+		 * A free buffer sized for the frame, to be filled and passed to Submit. Null when every buffer is taken
+		 * and frames are dropped when busy, which is counted as a dropped frame
+		 */
+		Image* Acquire(std::uint32_t width, std::uint32_t height);
+		/** Queues a buffer from Acquire to be written to the path. The future is ready once the file is written */
+		std::future<FrameCaptureResult> Submit(Image* image, const std::string& path, ImageFormat format);
+		/** As Submit, completing a promise the caller made earlier */
+		void Submit(Image* image, const std::string& path, ImageFormat format, std::promise<FrameCaptureResult> promise);
+		/**
+		 * Copies rows of four byte RGBA pixels, rowPitch bytes apart as a mapped texture has them, and submits
+		 * them. A dropped frame gives a future that is ready at once
+		 */
+		std::future<FrameCaptureResult> Capture(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t rowPitch,
+			const std::string& path, ImageFormat format);
+		/** Waits until every submitted frame is written */
+		void Flush();
+		FrameCaptureStats GetStats() const;
+		std::uint32_t GetThreadCount() const;
+
+	private:
+		/** One frame buffer and what to do with it once submitted */
+		struct Slot
+		{
+			Image image;
+			std::string path;
+			ImageFormat format = ImageFormat::Png;
+			std::promise<FrameCaptureResult> promise;
+			// Only the thread holding the slot sets it
+			TrackedMemory memory = TrackedMemory(MemoryTag::FrameCapture);
+		};
+
+		void EncoderThread();
+		void Encode(std::uint32_t index, std::vector<std::uint8_t>& bytes);
+
+		FrameCaptureConfig mConfig;
+		std::vector<Slot> mSlots;
+		// Slots that can be acquired, and slots submitted and waiting for an encoder
+		BoundedQueue<std::uint32_t> mFree;
+		BoundedQueue<std::uint32_t> mJobs;
+		std::vector<std::thread> mEncoders;
+
+		// Encoders with nothing to do sleep on the condition, and submitting only takes the lock to wake them
+		// when one is asleep. Waiting for a free buffer or for Flush sleeps on the other
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+		std::atomic<std::uint32_t> mSleeping;
+		std::atomic<std::uint32_t> mPending;
+		std::atomic<bool> mStopping;
+
+		std::atomic<std::uint64_t> mSubmitted;
+		std::atomic<std::uint64_t> mWritten;
+		std::atomic<std::uint64_t> mDropped;
+		std::atomic<std::uint64_t> mFailed;
+		std::atomic<std::uint64_t> mBytes;
+		std::atomic<std::uint64_t> mEncodeNanoseconds;
+		std::atomic<std::uint64_t> mCallNanoseconds;
+	};
+}
@@ -0,0 +1,56 @@
+#include "Culling/Frustum.h"
+
+namespace renderer
+{
+	Frustum Frustum::FromViewProjection(FXMMATRIX viewProj)
+	{
+		// Clip space position is v * M, so each clip component is a dot product with a column of M
+		XMMATRIX columns = XMMatrixTranspose(viewProj);
+
+		XMVECTOR planes[PlaneCount];
+		planes[Left] = columns.r[3] + columns.r[0];
+		planes[Right] = columns.r[3] - columns.r[0];
+		planes[Bottom] = columns.r[3] + columns.r[1];
+		planes[Top] = columns.r[3] - columns.r[1];
+		planes[Near] = columns.r[2];
+		planes[Far] = columns.r[3] - columns.r[2];
+
+		Frustum frustum;
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(planes[i]));
+		}
+		return frustum;
+	}
+
+	bool Frustum::IntersectsSphere(const XMFLOAT3& center, float radius) const
+	{
+		XMVECTOR vCenter = XMVectorSetW(FV(center), 1.0f);
+		XMVECTOR vNegRadius = XMVectorReplicate(-radius);
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			if (XMVector4Less(XMVector4Dot(FV(planes[i]), vCenter), vNegRadius))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Frustum::IntersectsBox(const XMFLOAT3& center, const XMFLOAT3& extents) const
+	{
+		XMVECTOR vCenter = XMVectorSetW(FV(center), 1.0f);
+		XMVECTOR vExtents = FV(extents);
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			XMVECTOR plane = FV(planes[i]);
+			// Projected radius of the box onto the plane normal
+			XMVECTOR radius = XMVector3Dot(vExtents, XMVectorAbs(plane));
+			if (XMVector4Less(XMVector4Dot(plane, vCenter), -radius))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Minimal.h"
+
+using namespace DirectX;
+
+namespace renderer
+{
+	/** View frustum as six normalized planes (xyz = inward normal, w = distance) */
+	struct Frustum
+	{
+		enum Plane
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlaneCount
+		};
+
+		XMFLOAT4 planes[PlaneCount];
+
+		/** Extracts the planes from a row-vector view projection matrix with a [0, 1] depth range */
+		static Frustum FromViewProjection(FXMMATRIX viewProj);
+
+		bool IntersectsSphere(const XMFLOAT3& center, float radius) const;
+		bool IntersectsBox(const XMFLOAT3& center, const XMFLOAT3& extents) const;
+	};
+}
@@ -0,0 +1,291 @@
+#include "Culling/MeshletCuller.h"
+#include "Camera/Camera.h"
+#include <chrono>
+
+namespace renderer
+{
+	namespace
+	{
+		constexpr std::uint32_t NotInMeshlet = ~0u;
+
+		XMVECTOR LoadPosition(const Vertex* vertices, std::uint32_t index)
+		{
+			return XMLoadFloat3(&vertices[index].position);
+		}
+
+		/** Sphere and normal cone of the triangles of a meshlet */
+		void ComputeBounds(const Vertex* vertices, const std::uint32_t* indices, Meshlet& meshlet)
+		{
+			XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+			XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+			XMVECTOR normalSum = XMVectorZero();
+			const std::uint32_t indexCount = meshlet.triangleCount * 3;
+			for (std::uint32_t i = 0; i < indexCount; i += 3)
+			{
+				const XMVECTOR p0 = LoadPosition(vertices, indices[i]);
+				const XMVECTOR p1 = LoadPosition(vertices, indices[i + 1]);
+				const XMVECTOR p2 = LoadPosition(vertices, indices[i + 2]);
+				boundsMin = XMVectorMin(boundsMin, XMVectorMin(p0, XMVectorMin(p1, p2)));
+				boundsMax = XMVectorMax(boundsMax, XMVectorMax(p0, XMVectorMax(p1, p2)));
+				// Scaled by area, so slivers sway the axis less than the triangles that cover the meshlet
+				normalSum = XMVectorAdd(normalSum, XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+			}
+
+			const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+			float radiusSquared = 0;
+			for (std::uint32_t i = 0; i < indexCount; ++i)
+			{
+				radiusSquared = std::max(radiusSquared, XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(LoadPosition(vertices, indices[i]), center))));
+			}
+			XMStoreFloat3(&meshlet.center, center);
+			meshlet.radius = std::sqrt(radiusSquared);
+
+			// The cone is as wide as the face normal farthest from the axis
+			meshlet.coneCosine = -1;
+			if (XMVectorGetX(XMVector3LengthSq(normalSum)) <= 0)
+			{
+				return;
+			}
+			const XMVECTOR axis = XMVector3Normalize(normalSum);
+			float coneCosine = 1;
+			for (std::uint32_t i = 0; i < indexCount; i += 3)
+			{
+				const XMVECTOR p0 = LoadPosition(vertices, indices[i]);
+				const XMVECTOR normal = XMVector3Cross(XMVectorSubtract(LoadPosition(vertices, indices[i + 1]), p0),
+					XMVectorSubtract(LoadPosition(vertices, indices[i + 2]), p0));
+				const float length = XMVectorGetX(XMVector3Length(normal));
+				if (length > 0)
+				{
+					coneCosine = std::min(coneCosine, XMVectorGetX(XMVector3Dot(normal, axis)) / length);
+				}
+			}
+			XMStoreFloat3(&meshlet.coneAxis, axis);
+			meshlet.coneCosine = coneCosine;
+		}
+	}
+
+	void MeshletCuller::Build(const Vertex* vertices, std::uint32_t vertexCount, std::vector<std::uint32_t>& indices, std::vector<Meshlet>& meshlets)
+	{
+		meshlets.clear();
+		const auto triangleCount = static_cast<std::uint32_t>(indices.size() / 3);
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		// Triangles around each vertex
+		std::vector<std::uint32_t> triangleOffsets(static_cast<size_t>(vertexCount) + 1, 0);
+		for (std::uint32_t index : indices)
+		{
+			++triangleOffsets[index + 1];
+		}
+		for (std::uint32_t i = 1; i <= vertexCount; ++i)
+		{
+			triangleOffsets[i] += triangleOffsets[i - 1];
+		}
+		std::vector<std::uint32_t> vertexTriangles(indices.size());
+		std::vector<std::uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (std::uint32_t i = 0; i < indices.size(); ++i)
+		{
+			vertexTriangles[fill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<std::uint8_t> used(triangleCount, 0);
+		// Meshlet each vertex was last added to, so membership needs no clearing between meshlets
+		std::vector<std::uint32_t> vertexMeshlets(vertexCount, NotInMeshlet);
+		std::vector<std::uint32_t> candidates;
+		std::vector<std::uint32_t> reordered;
+		reordered.reserve(indices.size());
+		std::uint32_t nextSeed = 0;
+		while (reordered.size() < indices.size())
+		{
+			const auto meshletIndex = static_cast<std::uint32_t>(meshlets.size());
+			Meshlet meshlet;
+			meshlet.indexOffset = static_cast<std::uint32_t>(reordered.size());
+			XMVECTOR centroidSum = XMVectorZero();
+			candidates.clear();
+
+			auto newVertexCount = [&](std::uint32_t triangle)
+			{
+				std::uint32_t count = 0;
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					count += vertexMeshlets[indices[triangle * 3 + k]] != meshletIndex ? 1 : 0;
+				}
+				return count;
+			};
+
+			while (meshlet.triangleCount < MaxTriangles)
+			{
+				// The neighbour adding the fewest vertices, then the one nearest the meshlet's centre
+				std::uint32_t best = NotInMeshlet;
+				std::uint32_t bestNewVertices = 4;
+				float bestDistance = FLT_MAX;
+				const XMVECTOR centroid = XMVectorScale(centroidSum, meshlet.triangleCount > 0 ? 1.0f / (meshlet.triangleCount * 3) : 0.0f);
+				for (size_t i = 0; i < candidates.size();)
+				{
+					const std::uint32_t triangle = candidates[i];
+					if (used[triangle])
+					{
+						candidates[i] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					++i;
+					const std::uint32_t newVertices = newVertexCount(triangle);
+					if (meshlet.vertexCount + newVertices > MaxVertices || newVertices > bestNewVertices)
+					{
+						continue;
+					}
+					const XMVECTOR triangleCentroid = XMVectorAdd(LoadPosition(vertices, indices[triangle * 3]),
+						XMVectorAdd(LoadPosition(vertices, indices[triangle * 3 + 1]), LoadPosition(vertices, indices[triangle * 3 + 2])));
+					const float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMVectorScale(triangleCentroid, 1.0f / 3), centroid)));
+					if (newVertices < bestNewVertices || distance < bestDistance)
+					{
+						best = triangle;
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+					}
+				}
+
+				// With no neighbour left the meshlet carries on from the next triangle in index order, which imported
+				// meshes usually keep close by
+				if (best == NotInMeshlet)
+				{
+					if (!candidates.empty())
+					{
+						break;
+					}
+					while (nextSeed < triangleCount && used[nextSeed])
+					{
+						++nextSeed;
+					}
+					if (nextSeed == triangleCount || meshlet.vertexCount + newVertexCount(nextSeed) > MaxVertices)
+					{
+						break;
+					}
+					best = nextSeed;
+				}
+
+				used[best] = 1;
+				++meshlet.triangleCount;
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t vertex = indices[best * 3 + k];
+					reordered.push_back(vertex);
+					centroidSum = XMVectorAdd(centroidSum, LoadPosition(vertices, vertex));
+					if (vertexMeshlets[vertex] == meshletIndex)
+					{
+						continue;
+					}
+					vertexMeshlets[vertex] = meshletIndex;
+					++meshlet.vertexCount;
+					for (std::uint32_t i = triangleOffsets[vertex]; i < triangleOffsets[vertex + 1]; ++i)
+					{
+						if (!used[vertexTriangles[i]])
+						{
+							candidates.push_back(vertexTriangles[i]);
+						}
+					}
+				}
+			}
+
+			ComputeBounds(vertices, &reordered[meshlet.indexOffset], meshlet);
+			meshlets.push_back(meshlet);
+		}
+		indices.swap(reordered);
+	}
+
+	void MeshletCuller::Begin(const Camera& camera)
+	{
+		mFrustum = camera.GetFrustum();
+		mCameraPosition = camera.GetPosition();
+		mStats = MeshletCullStats();
+	}
+
+	std::uint32_t MeshletCuller::Cull(const Meshlet* meshlets, std::uint32_t meshletCount, const std::uint32_t* indices, FXMMATRIX world,
+		std::vector<std::uint32_t>& output)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const size_t outputStart = output.size();
+
+		// Row vectors, so the first three rows are the scaled axes of the instance
+		const XMVECTOR axisX = world.r[0];
+		const XMVECTOR axisY = world.r[1];
+		const XMVECTOR axisZ = world.r[2];
+		const float maxScale = std::sqrt(std::max({ XMVectorGetX(XMVector3LengthSq(axisX)), XMVectorGetX(XMVector3LengthSq(axisY)),
+			XMVectorGetX(XMVector3LengthSq(axisZ)) }));
+
+		// Whether a triangle faces the camera does not change under an affine transform, so the cones are tested
+		// against the camera moved into mesh space. Its inverse transform takes the columns of the adjugate
+		const XMVECTOR crossYZ = XMVector3Cross(axisY, axisZ);
+		const float determinant = XMVectorGetX(XMVector3Dot(axisX, crossYZ));
+		const bool useCones = determinant > 0;
+		XMVECTOR cameraPosition = XMVectorZero();
+		if (useCones)
+		{
+			const XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&mCameraPosition), world.r[3]);
+			cameraPosition = XMVectorScale(XMVectorSet(XMVectorGetX(XMVector3Dot(offset, crossYZ)),
+				XMVectorGetX(XMVector3Dot(offset, XMVector3Cross(axisZ, axisX))),
+				XMVectorGetX(XMVector3Dot(offset, XMVector3Cross(axisX, axisY))), 0), 1.0f / determinant);
+		}
+
+		// Visible meshlets next to each other in the index list are copied as one run
+		std::uint32_t runStart = 0;
+		std::uint32_t runEnd = 0;
+		std::uint64_t trianglesCulled = 0;
+		std::uint64_t frustumCulled = 0;
+		std::uint64_t backfaceCulled = 0;
+		std::uint64_t triangles = 0;
+		for (std::uint32_t i = 0; i < meshletCount; ++i)
+		{
+			const Meshlet& meshlet = meshlets[i];
+			triangles += meshlet.triangleCount;
+			XMFLOAT3 worldCenter;
+			XMStoreFloat3(&worldCenter, XMVector3Transform(XMLoadFloat3(&meshlet.center), world));
+			if (!mFrustum.IntersectsSphere(worldCenter, meshlet.radius * maxScale))
+			{
+				++frustumCulled;
+				trianglesCulled += meshlet.triangleCount;
+				continue;
+			}
+
+			// Every triangle faces away if even the normal in the cone closest to the direction from the camera
+			// points away by more than the sphere's radius
+			if (useCones && meshlet.coneCosine > 0)
+			{
+				const XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&meshlet.center), cameraPosition);
+				const float along = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&meshlet.coneAxis)));
+				const float across = std::sqrt(std::max(XMVectorGetX(XMVector3LengthSq(offset)) - along * along, 0.0f));
+				const float coneSine = std::sqrt(1 - meshlet.coneCosine * meshlet.coneCosine);
+				if (along * meshlet.coneCosine - across * coneSine > meshlet.radius)
+				{
+					++backfaceCulled;
+					trianglesCulled += meshlet.triangleCount;
+					continue;
+				}
+			}
+
+			if (meshlet.indexOffset != runEnd)
+			{
+				output.insert(output.end(), indices + runStart, indices + runEnd);
+				runStart = meshlet.indexOffset;
+			}
+			runEnd = meshlet.indexOffset + meshlet.triangleCount * 3;
+		}
+		output.insert(output.end(), indices + runStart, indices + runEnd);
+
+		mStats.meshlets += meshletCount;
+		mStats.frustumCulled += frustumCulled;
+		mStats.backfaceCulled += backfaceCulled;
+		mStats.triangles += triangles;
+		mStats.trianglesCulled += trianglesCulled;
+		mStats.passMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		return static_cast<std::uint32_t>(output.size() - outputStart);
+	}
+
+	const MeshletCullStats& MeshletCuller::GetStats() const
+	{
+		return mStats;
+	}
+}
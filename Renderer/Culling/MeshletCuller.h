@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Culling/Frustum.h"
+#include "Rendering/DataTypes.h"
+
+namespace renderer
+{
+	class Camera;
+
+	/** A small run of triangles of a mesh with the bounds used to cull it */
+	struct Meshlet
+	{
+		// First index of the meshlet's triangles in the mesh's index list
+		std::uint32_t indexOffset = 0;
+		std::uint32_t triangleCount = 0;
+		std::uint32_t vertexCount = 0;
+		// Sphere around the triangles in mesh space
+		XMFLOAT3 center = { 0, 0, 0 };
+		float radius = 0;
+		// Every face normal is within the cone of this axis and cosine. A cosine of zero or less never culls
+		XMFLOAT3 coneAxis = { 0, 0, 1 };
+		float coneCosine = -1;
+	};
+
+	/** Results of the meshlets culled since the last Begin */
+	struct MeshletCullStats
+	{
+		std::uint64_t meshlets = 0;
+		std::uint64_t frustumCulled = 0;
+		std::uint64_t backfaceCulled = 0;
+		std::uint64_t triangles = 0;
+		std::uint64_t trianglesCulled = 0;
+		// Time spent testing meshlets and copying the indices of the visible ones
+		double passMicroseconds = 0;
+	};
+
+	/**
+	 * Culls the meshlets of a mesh instance against the camera's frustum and against their normal cones, so groups
+	 * of triangles that are off screen or all face away are dropped before drawing. The triangles of the meshlets
+	 * left are copied into one index stream that a single draw can use.
+	 */
+	class MeshletCuller
+	{
+	public:
+		static constexpr std::uint32_t MaxVertices = 64;
+		static constexpr std::uint32_t MaxTriangles = 124;
+
+		/**
+		 * Splits a mesh into meshlets of at most MaxVertices vertices and MaxTriangles triangles, reordering the
+		 * indices so every meshlet's triangles are contiguous. Each meshlet grows from a seed triangle by taking the
+		 * neighbouring triangle that adds the fewest vertices, so meshlets are compact patches with tight cones.
+		 */
+		static void Build(const Vertex* vertices, std::uint32_t vertexCount, std::vector<std::uint32_t>& indices, std::vector<Meshlet>& meshlets);
+
+		/** Takes the camera to cull against and clears the stats */
+		void Begin(const Camera& camera);
+		/**
+		 * Appends the indices of the meshlets of one instance that may be visible to output and returns how many
+		 * were appended. The cone test is skipped for mirrored instances, whose triangles the rasterizer sees
+		 * with the opposite winding
+		 */
+		std::uint32_t Cull(const Meshlet* meshlets, std::uint32_t meshletCount, const std::uint32_t* indices, FXMMATRIX world,
+			std::vector<std::uint32_t>& output);
+		const MeshletCullStats& GetStats() const;
+
+	private:
+		Frustum mFrustum;
+		XMFLOAT3 mCameraPosition = { 0, 0, 0 };
+		MeshletCullStats mStats;
+	};
+}
@@ -0,0 +1,399 @@
+#include "Culling/OcclusionCuller.h"
+#include "Camera/Camera.h"
+#include "Rendering/InstanceBuilder.h"
+#include <chrono>
+
+namespace renderer
+{
+	namespace
+	{
+		// Quads of the unit cube as indices into its corners, where bit 0, 1 and 2 of an index select +x, +y and +z
+		constexpr int CubeFaces[6][4] =
+		{
+			{ 0, 1, 3, 2 },
+			{ 4, 5, 7, 6 },
+			{ 0, 2, 6, 4 },
+			{ 1, 3, 7, 5 },
+			{ 0, 1, 5, 4 },
+			{ 2, 3, 7, 6 }
+		};
+
+		/** Edge functions and depth plane of a screen space triangle */
+		struct TriangleSetup
+		{
+			float a[3];
+			float b[3];
+			float c[3];
+			float dzdx;
+			float dzdy;
+			float z0;
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+		};
+
+		bool SetupTriangle(XMFLOAT3 v0, XMFLOAT3 v1, XMFLOAT3 v2, int width, int height, TriangleSetup& setup)
+		{
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (std::abs(area) < 1e-6f)
+			{
+				return false;
+			}
+			// Make the winding consistent so inside is always where every edge function is positive
+			if (area < 0)
+			{
+				std::swap(v1, v2);
+				area = -area;
+			}
+
+			setup.minX = std::max(0, static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+			setup.minY = std::max(0, static_cast<int>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+			setup.maxX = std::min(width - 1, static_cast<int>(std::floor(std::max(v0.x, std::max(v1.x, v2.x)))));
+			setup.maxY = std::min(height - 1, static_cast<int>(std::floor(std::max(v0.y, std::max(v1.y, v2.y)))));
+			if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+			{
+				return false;
+			}
+
+			const XMFLOAT3* vertices[3] = { &v0, &v1, &v2 };
+			for (int i = 0; i < 3; ++i)
+			{
+				const XMFLOAT3& p = *vertices[i];
+				const XMFLOAT3& q = *vertices[(i + 1) % 3];
+				setup.a[i] = p.y - q.y;
+				setup.b[i] = q.x - p.x;
+				setup.c[i] = (q.y - p.y) * p.x - (q.x - p.x) * p.y;
+			}
+
+			// Depth is affine in screen space after the perspective divide
+			setup.dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+			setup.dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+			setup.z0 = v0.z - setup.dzdx * v0.x - setup.dzdy * v0.y;
+			return true;
+		}
+	}
+
+	float OcclusionStats::GetCullRate() const
+	{
+		return tested > 0 ? static_cast<float>(culled) / tested : 0.0f;
+	}
+
+	OcclusionCuller::OcclusionCuller()
+		: mDepth(Width * Height, 1.0f), mTileMaxDepth(TilesX * TilesY, 1.0f), mMaxOccluders(64), mNearZ(0),
+		mProjectionScaleX(1), mProjectionScaleY(1), mDepthScale(1), mDepthOffset(0), mRasterizeMicroseconds(0)
+	{
+
+	}
+
+	void OcclusionCuller::SetMaxOccluders(std::uint32_t maxOccluders)
+	{
+		mMaxOccluders = maxOccluders;
+	}
+
+	std::uint32_t OcclusionCuller::GetMaxOccluders() const
+	{
+		return mMaxOccluders;
+	}
+
+	void OcclusionCuller::Begin(const Camera& camera)
+	{
+		std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+		std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), 1.0f);
+		mCandidates.clear();
+		mStats = OcclusionStats();
+		mRasterizeMicroseconds = 0;
+
+		const CameraMatrices& matrices = camera.GetMatrices();
+		mView = matrices.view;
+		mViewProjection = matrices.viewProjection;
+		mNearZ = camera.GetNearZ();
+		mProjectionScaleX = matrices.projection.m[0][0];
+		mProjectionScaleY = matrices.projection.m[1][1];
+		mDepthScale = matrices.projection.m[2][2];
+		mDepthOffset = matrices.projection.m[3][2];
+	}
+
+	void OcclusionCuller::AddOccluderCandidate(const Entity* entity, const XMFLOAT3& center, float radius)
+	{
+		const float viewZ = center.x * mView.m[0][2] + center.y * mView.m[1][2] + center.z * mView.m[2][2] + mView.m[3][2];
+		// Occluders crossing the near plane are skipped rather than clipped
+		if (viewZ - radius <= mNearZ)
+		{
+			return;
+		}
+		mCandidates.push_back({ entity, radius / viewZ });
+	}
+
+	void OcclusionCuller::RasterizeOccluders()
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		// The nearest large occluders hide the most so keep the biggest on screen
+		if (mCandidates.size() > mMaxOccluders)
+		{
+			std::nth_element(mCandidates.begin(), mCandidates.begin() + mMaxOccluders, mCandidates.end(),
+				[](const OccluderCandidate& a, const OccluderCandidate& b) { return a.screenSize > b.screenSize; });
+			mCandidates.resize(mMaxOccluders);
+		}
+
+		XMFLOAT3 screen[8];
+		for (const auto& candidate : mCandidates)
+		{
+			if (!ProjectCube(*candidate.entity, screen))
+			{
+				continue;
+			}
+			for (const auto& face : CubeFaces)
+			{
+				RasterizeTriangle(screen[face[0]], screen[face[1]], screen[face[2]]);
+				RasterizeTriangle(screen[face[0]], screen[face[2]], screen[face[3]]);
+			}
+			++mStats.occluders;
+		}
+
+		BuildHierarchy();
+
+		mRasterizeMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		mStats.passMicroseconds += mRasterizeMicroseconds;
+	}
+
+	size_t OcclusionCuller::Cull(const BoundingSpheres& spheres, ViewMask viewBit, ViewMask* masks)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		size_t culled = 0;
+		const size_t count = spheres.Size();
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!(masks[i] & viewBit))
+			{
+				continue;
+			}
+			++mStats.tested;
+			if (!IsVisible(XMFLOAT3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]))
+			{
+				masks[i] &= ~viewBit;
+				++culled;
+			}
+		}
+		mStats.culled += static_cast<std::uint32_t>(culled);
+
+		mStats.passMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		return culled;
+	}
+
+	bool OcclusionCuller::IsVisible(const XMFLOAT3& center, float radius) const
+	{
+		XMFLOAT3 viewCenter = VF3(XMVector3Transform(FV(center), XMLoadFloat4x4(&mView)));
+		const float nearest = viewCenter.z - radius;
+		if (nearest <= mNearZ)
+		{
+			return true;
+		}
+		const float farthest = viewCenter.z + radius;
+
+		// Conservative NDC bounds of the sphere. The nearest depth maximizes the extent on the side facing away
+		// from the view axis and the farthest depth on the side crossing it.
+		auto upperBound = [&](float v) { return (v + radius) / ((v + radius) >= 0 ? nearest : farthest); };
+		auto lowerBound = [&](float v) { return (v - radius) / ((v - radius) <= 0 ? nearest : farthest); };
+		const float minNdcX = lowerBound(viewCenter.x) * mProjectionScaleX;
+		const float maxNdcX = upperBound(viewCenter.x) * mProjectionScaleX;
+		const float minNdcY = lowerBound(viewCenter.y) * mProjectionScaleY;
+		const float maxNdcY = upperBound(viewCenter.y) * mProjectionScaleY;
+
+		const int minX = std::max(0, static_cast<int>(std::floor((minNdcX * 0.5f + 0.5f) * Width)));
+		const int maxX = std::min(static_cast<int>(Width) - 1, static_cast<int>(std::floor((maxNdcX * 0.5f + 0.5f) * Width)));
+		const int minY = std::max(0, static_cast<int>(std::floor((0.5f - maxNdcY * 0.5f) * Height)));
+		const int maxY = std::min(static_cast<int>(Height) - 1, static_cast<int>(std::floor((0.5f - minNdcY * 0.5f) * Height)));
+		if (minX > maxX || minY > maxY)
+		{
+			// Off screen entities are left to the frustum culler
+			return true;
+		}
+
+		return IsRectVisible(minX, minY, maxX, maxY, mDepthScale + mDepthOffset / nearest);
+	}
+
+	bool OcclusionCuller::IsCubeVisibleExact(const Entity& entity) const
+	{
+		XMFLOAT3 screen[8];
+		if (!ProjectCube(entity, screen))
+		{
+			return true;
+		}
+		for (const auto& face : CubeFaces)
+		{
+			if (IsTriangleVisible(screen[face[0]], screen[face[1]], screen[face[2]]) ||
+				IsTriangleVisible(screen[face[0]], screen[face[2]], screen[face[3]]))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const OcclusionStats& OcclusionCuller::GetStats() const
+	{
+		return mStats;
+	}
+
+	const float* OcclusionCuller::GetDepthBuffer() const
+	{
+		return mDepth.data();
+	}
+
+	bool OcclusionCuller::ProjectCube(const Entity& entity, XMFLOAT3 screen[8]) const
+	{
+		XMMATRIX worldViewProjection = InstanceBuilder::CalculateWorldMatrix(entity) * XMLoadFloat4x4(&mViewProjection);
+		for (int i = 0; i < 8; ++i)
+		{
+			XMVECTOR corner = XMVectorSet(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 1.0f);
+			XMFLOAT4 clip = VF4(XMVector4Transform(corner, worldViewProjection));
+			if (clip.w <= mNearZ)
+			{
+				return false;
+			}
+			float invW = 1.0f / clip.w;
+			screen[i].x = (clip.x * invW * 0.5f + 0.5f) * Width;
+			screen[i].y = (0.5f - clip.y * invW * 0.5f) * Height;
+			screen[i].z = clip.z * invW;
+		}
+		return true;
+	}
+
+	void OcclusionCuller::RasterizeTriangle(const XMFLOAT3& v0, const XMFLOAT3& v1, const XMFLOAT3& v2)
+	{
+		TriangleSetup setup;
+		if (!SetupTriangle(v0, v1, v2, Width, Height, setup))
+		{
+			return;
+		}
+
+		const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+		const XMVECTOR a0 = XMVectorReplicate(setup.a[0]);
+		const XMVECTOR a1 = XMVectorReplicate(setup.a[1]);
+		const XMVECTOR a2 = XMVectorReplicate(setup.a[2]);
+		const XMVECTOR dzdx = XMVectorReplicate(setup.dzdx);
+		const XMVECTOR zero = XMVectorZero();
+		const XMVECTOR one = XMVectorSplatOne();
+
+		// Rows are walked four pixels at a time from a four aligned start so stores never leave the row
+		const int startX = setup.minX & ~3;
+		for (int y = setup.minY; y <= setup.maxY; ++y)
+		{
+			const float py = y + 0.5f;
+			const XMVECTOR rowE0 = XMVectorReplicate(setup.b[0] * py + setup.c[0]);
+			const XMVECTOR rowE1 = XMVectorReplicate(setup.b[1] * py + setup.c[1]);
+			const XMVECTOR rowE2 = XMVectorReplicate(setup.b[2] * py + setup.c[2]);
+			const XMVECTOR rowZ = XMVectorReplicate(setup.z0 + setup.dzdy * py);
+			float* row = &mDepth[y * Width];
+
+			for (int x = startX; x <= setup.maxX; x += 4)
+			{
+				XMVECTOR px = XMVectorReplicate(static_cast<float>(x)) + laneOffsets;
+				XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, a0, rowE0), zero),
+					XMVectorAndInt(XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, a1, rowE1), zero),
+						XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, a2, rowE2), zero)));
+				XMVECTOR z = XMVectorClamp(XMVectorMultiplyAdd(px, dzdx, rowZ), zero, one);
+
+				XMFLOAT4* depth = reinterpret_cast<XMFLOAT4*>(row + x);
+				XMVECTOR current = XMLoadFloat4(depth);
+				XMStoreFloat4(depth, XMVectorSelect(current, XMVectorMin(current, z), inside));
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsTriangleVisible(const XMFLOAT3& v0, const XMFLOAT3& v1, const XMFLOAT3& v2) const
+	{
+		TriangleSetup setup;
+		if (!SetupTriangle(v0, v1, v2, Width, Height, setup))
+		{
+			return false;
+		}
+
+		for (int y = setup.minY; y <= setup.maxY; ++y)
+		{
+			const float py = y + 0.5f;
+			const float* row = &mDepth[y * Width];
+			for (int x = setup.minX; x <= setup.maxX; ++x)
+			{
+				const float px = x + 0.5f;
+				if (setup.a[0] * px + setup.b[0] * py + setup.c[0] < 0 ||
+					setup.a[1] * px + setup.b[1] * py + setup.c[1] < 0 ||
+					setup.a[2] * px + setup.b[2] * py + setup.c[2] < 0)
+				{
+					continue;
+				}
+				float z = std::min(std::max(setup.z0 + setup.dzdx * px + setup.dzdy * py, 0.0f), 1.0f);
+				if (z <= row[x])
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void OcclusionCuller::BuildHierarchy()
+	{
+		for (std::uint32_t ty = 0; ty < TilesY; ++ty)
+		{
+			for (std::uint32_t tx = 0; tx < TilesX; ++tx)
+			{
+				XMVECTOR tileMax = XMVectorZero();
+				for (std::uint32_t y = 0; y < TileSize; ++y)
+				{
+					const float* row = &mDepth[(ty * TileSize + y) * Width + tx * TileSize];
+					for (std::uint32_t x = 0; x < TileSize; x += 4)
+					{
+						tileMax = XMVectorMax(tileMax, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x)));
+					}
+				}
+				XMFLOAT4 lanes = VF4(tileMax);
+				mTileMaxDepth[ty * TilesX + tx] = std::max(std::max(lanes.x, lanes.y), std::max(lanes.z, lanes.w));
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsRectVisible(int minX, int minY, int maxX, int maxY, float depth) const
+	{
+		const XMVECTOR vDepth = XMVectorReplicate(depth);
+		const XMVECTOR laneIndices = XMVectorSet(0, 1, 2, 3);
+
+		for (int ty = minY / TileSize; ty <= maxY / static_cast<int>(TileSize); ++ty)
+		{
+			for (int tx = minX / TileSize; tx <= maxX / static_cast<int>(TileSize); ++tx)
+			{
+				// Every pixel of the tile is nearer than the entity
+				if (depth > mTileMaxDepth[ty * TilesX + tx])
+				{
+					continue;
+				}
+
+				const int x0 = std::max(minX, tx * static_cast<int>(TileSize));
+				const int x1 = std::min(maxX, (tx + 1) * static_cast<int>(TileSize) - 1);
+				const int y0 = std::max(minY, ty * static_cast<int>(TileSize));
+				const int y1 = std::min(maxY, (ty + 1) * static_cast<int>(TileSize) - 1);
+				const XMVECTOR first = XMVectorReplicate(static_cast<float>(x0));
+				const XMVECTOR last = XMVectorReplicate(static_cast<float>(x1));
+
+				for (int y = y0; y <= y1; ++y)
+				{
+					const float* row = &mDepth[y * Width];
+					for (int x = x0 & ~3; x <= x1; x += 4)
+					{
+						XMVECTOR index = XMVectorReplicate(static_cast<float>(x)) + laneIndices;
+						XMVECTOR inRect = XMVectorAndInt(XMVectorGreaterOrEqual(index, first), XMVectorLessOrEqual(index, last));
+						XMVECTOR behind = XMVectorGreaterOrEqual(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x)), vDepth);
+						if (!XMVector4EqualInt(XMVectorAndInt(inRect, behind), XMVectorZero()))
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
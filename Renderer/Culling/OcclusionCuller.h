@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Culling/ViewCuller.h"
+#include "Rendering/DataTypes.h"
+
+namespace renderer
+{
+	class Camera;
+
+	/** Results of the last occlusion pass */
+	struct OcclusionStats
+	{
+		std::uint32_t occluders = 0;
+		std::uint32_t tested = 0;
+		std::uint32_t culled = 0;
+		// Time spent rasterizing occluders and testing entities
+		double passMicroseconds = 0;
+
+		float GetCullRate() const;
+	};
+
+	/**
+	 * CPU occlusion culling against a coarse depth buffer. The largest cubes on screen are rasterized as occluders,
+	 * then entity bounding spheres are tested against the result. Tests are conservative so an entity is only culled
+	 * when it is certainly hidden.
+	 */
+	class OcclusionCuller
+	{
+	public:
+		static constexpr std::uint32_t Width = 256;
+		static constexpr std::uint32_t Height = 128;
+		// The hierarchy level stores the farthest depth of each tile so most tests never touch pixels
+		static constexpr std::uint32_t TileSize = 8;
+		static constexpr std::uint32_t TilesX = Width / TileSize;
+		static constexpr std::uint32_t TilesY = Height / TileSize;
+
+		OcclusionCuller();
+		void SetMaxOccluders(std::uint32_t maxOccluders);
+		std::uint32_t GetMaxOccluders() const;
+		/** Clears the depth buffer and the occluder candidates for a new pass from the camera */
+		void Begin(const Camera& camera);
+		/** Offers a cube entity as an occluder. Only the largest on screen are rasterized */
+		void AddOccluderCandidate(const Entity* entity, const XMFLOAT3& center, float radius);
+		void RasterizeOccluders();
+		/** Clears the view bit of every sphere that is hidden and returns how many were culled */
+		size_t Cull(const BoundingSpheres& spheres, ViewMask viewBit, ViewMask* masks);
+		bool IsVisible(const XMFLOAT3& center, float radius) const;
+		/** Reference test that depth tests every pixel of the entity's cube. Used to measure false positives */
+		bool IsCubeVisibleExact(const Entity& entity) const;
+		const OcclusionStats& GetStats() const;
+		const float* GetDepthBuffer() const;
+
+	private:
+		struct OccluderCandidate
+		{
+			const Entity* entity;
+			float screenSize;
+		};
+
+		/** Projects the unit cube of an entity. Returns false if it crosses the near plane */
+		bool ProjectCube(const Entity& entity, XMFLOAT3 screen[8]) const;
+		void RasterizeTriangle(const XMFLOAT3& v0, const XMFLOAT3& v1, const XMFLOAT3& v2);
+		bool IsTriangleVisible(const XMFLOAT3& v0, const XMFLOAT3& v1, const XMFLOAT3& v2) const;
+		void BuildHierarchy();
+		bool IsRectVisible(int minX, int minY, int maxX, int maxY, float depth) const;
+
+		std::vector<float> mDepth;
+		std::vector<float> mTileMaxDepth;
+		std::vector<OccluderCandidate> mCandidates;
+		std::uint32_t mMaxOccluders;
+
+		// Camera data captured by Begin
+		XMFLOAT4X4 mView;
+		XMFLOAT4X4 mViewProjection;
+		float mNearZ;
+		float mProjectionScaleX;
+		float mProjectionScaleY;
+		// Depth is depthScale + depthOffset / viewZ for a perspective projection
+		float mDepthScale;
+		float mDepthOffset;
+
+		OcclusionStats mStats;
+		double mRasterizeMicroseconds;
+	};
+}
@@ -0,0 +1,101 @@
+#include "Culling/ViewCuller.h"
+
+namespace renderer
+{
+	void BoundingSpheres::Resize(size_t count)
+	{
+		x.resize(count);
+		y.resize(count);
+		z.resize(count);
+		radius.resize(count);
+	}
+
+	void BoundingSpheres::Set(size_t index, const XMFLOAT3& center, float r)
+	{
+		x[index] = center.x;
+		y[index] = center.y;
+		z[index] = center.z;
+		radius[index] = r;
+	}
+
+	size_t BoundingSpheres::Size() const
+	{
+		return x.size();
+	}
+
+	void ViewCuller::SetViews(const Frustum* frustums, std::uint32_t count)
+	{
+		mViewCount = std::min(count, MaxViews);
+		mPlanes.resize(mViewCount * Frustum::PlaneCount * 4);
+		for (std::uint32_t v = 0; v < mViewCount; ++v)
+		{
+			float* planes = &mPlanes[v * Frustum::PlaneCount * 4];
+			for (int p = 0; p < Frustum::PlaneCount; ++p)
+			{
+				const XMFLOAT4& plane = frustums[v].planes[p];
+				planes[p * 4 + 0] = plane.x;
+				planes[p * 4 + 1] = plane.y;
+				planes[p * 4 + 2] = plane.z;
+				planes[p * 4 + 3] = plane.w;
+			}
+		}
+	}
+
+	std::uint32_t ViewCuller::GetViewCount() const
+	{
+		return mViewCount;
+	}
+
+	size_t ViewCuller::Cull(const BoundingSpheres& spheres, ViewMask* masks) const
+	{
+		return Cull(spheres, 0, spheres.Size(), masks);
+	}
+
+	size_t ViewCuller::Cull(const BoundingSpheres& spheres, size_t first, size_t count, ViewMask* masks) const
+	{
+		// Four spheres are tested per iteration. The tail is copied into padded arrays so the loop body stays branch free.
+		size_t visibleCount = 0;
+		const size_t end = first + count;
+		for (size_t i = first; i < end; i += 4)
+		{
+			const size_t lanes = std::min<size_t>(4, end - i);
+			XMFLOAT4 x(0, 0, 0, 0), y(0, 0, 0, 0), z(0, 0, 0, 0), r(0, 0, 0, 0);
+			std::memcpy(&x, &spheres.x[i], lanes * sizeof(float));
+			std::memcpy(&y, &spheres.y[i], lanes * sizeof(float));
+			std::memcpy(&z, &spheres.z[i], lanes * sizeof(float));
+			std::memcpy(&r, &spheres.radius[i], lanes * sizeof(float));
+
+			XMVECTOR vX = FV(x);
+			XMVECTOR vY = FV(y);
+			XMVECTOR vZ = FV(z);
+			XMVECTOR vNegRadius = XMVectorNegate(FV(r));
+
+			XMVECTOR visible = XMVectorZero();
+			const float* planes = mPlanes.data();
+			for (std::uint32_t v = 0; v < mViewCount; ++v)
+			{
+				XMVECTOR outside = XMVectorFalseInt();
+				for (int p = 0; p < Frustum::PlaneCount; ++p, planes += 4)
+				{
+					XMVECTOR distance = XMVectorMultiplyAdd(vX, XMVectorReplicatePtr(planes),
+						XMVectorMultiplyAdd(vY, XMVectorReplicatePtr(planes + 1),
+						XMVectorMultiplyAdd(vZ, XMVectorReplicatePtr(planes + 2), XMVectorReplicatePtr(planes + 3))));
+					outside = XMVectorOrInt(outside, XMVectorLess(distance, vNegRadius));
+				}
+				// Set this view's bit in every lane that was not outside any plane
+				visible = XMVectorOrInt(visible, XMVectorAndCInt(XMVectorReplicateInt(1u << v), outside));
+			}
+
+			XMUINT4 laneMasks;
+			XMStoreUInt4(&laneMasks, visible);
+			const ViewMask results[4] = { laneMasks.x, laneMasks.y, laneMasks.z, laneMasks.w };
+			ViewMask* out = masks + (i - first);
+			for (size_t lane = 0; lane < lanes; ++lane)
+			{
+				out[lane] = results[lane];
+				visibleCount += results[lane] != 0;
+			}
+		}
+		return visibleCount;
+	}
+}
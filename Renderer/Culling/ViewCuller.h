@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Culling/Frustum.h"
+
+namespace renderer
+{
+	/** Bit i is set when an entity is visible in view i */
+	using ViewMask = std::uint32_t;
+
+	/** World space bounding spheres stored as separate arrays so four can be tested at once */
+	struct BoundingSpheres
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+
+		void Resize(size_t count);
+		void Set(size_t index, const XMFLOAT3& center, float r);
+		size_t Size() const;
+	};
+
+	/** Tests entity bounds against the frustums of every view in one pass over the entities */
+	class ViewCuller
+	{
+	public:
+		static constexpr std::uint32_t MaxViews = 32;
+
+		/** Sets the frustums to cull against. Views past MaxViews are ignored */
+		void SetViews(const Frustum* frustums, std::uint32_t count);
+		std::uint32_t GetViewCount() const;
+		/** Writes a view mask per sphere and returns how many are visible in at least one view */
+		size_t Cull(const BoundingSpheres& spheres, ViewMask* masks) const;
+		size_t Cull(const BoundingSpheres& spheres, size_t first, size_t count, ViewMask* masks) const;
+
+	private:
+		// Plane components stored per view as [plane][x, y, z, w] for broadcasting into registers
+		std::vector<float> mPlanes;
+		std::uint32_t mViewCount = 0;
+	};
+}
@@ -0,0 +1,129 @@
+#include "BufferSubAllocator.h"
+
+namespace renderer
+{
+	BufferSubAllocator::BufferSubAllocator(std::uint32_t capacity, const ResizeCallback& onResize, std::uint32_t maxRanges)
+		: mAllocator(capacity, maxRanges), mOnResize(onResize), mMaxRanges(maxRanges)
+	{
+
+	}
+
+	BufferRangeHandle BufferSubAllocator::Allocate(std::uint32_t count)
+	{
+		OffsetAllocation range = mAllocator.Allocate(count);
+		// Out of ranges rather than space, which neither packing nor growing helps with. Every range and the one
+		// free region left after packing take a node, and the allocator keeps one back
+		if (!range.IsValid() && mAllocator.GetStats().allocations + 2 > mMaxRanges)
+		{
+			return InvalidBufferRange;
+		}
+		// Packing is enough when the space is there but in pieces
+		if (!range.IsValid() && count > 0 && mAllocator.GetStats().freeSpace >= count && Compact())
+		{
+			range = mAllocator.Allocate(count);
+		}
+		if (!range.IsValid() && count > 0 && Grow(count))
+		{
+			range = mAllocator.Allocate(count);
+		}
+		if (!range.IsValid())
+		{
+			return InvalidBufferRange;
+		}
+
+		BufferRangeHandle handle;
+		if (mFreeHandles.empty())
+		{
+			handle = static_cast<BufferRangeHandle>(mRanges.size());
+			mRanges.push_back(range);
+		}
+		else
+		{
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+			mRanges[handle] = range;
+		}
+		return handle;
+	}
+
+	void BufferSubAllocator::Free(BufferRangeHandle handle)
+	{
+		if (handle >= mRanges.size() || !mRanges[handle].IsValid())
+		{
+			return;
+		}
+		mAllocator.Free(mRanges[handle]);
+		mRanges[handle] = OffsetAllocation();
+		mFreeHandles.push_back(handle);
+	}
+
+	bool BufferSubAllocator::Reserve(std::uint32_t count)
+	{
+		// Ranges are allocated separately, so the free space does not have to be in one piece
+		return mAllocator.GetStats().freeSpace >= static_cast<std::uint64_t>(count) + count / 8 + 1 || Grow(count);
+	}
+
+	bool BufferSubAllocator::Grow(std::uint32_t count)
+	{
+		// Grows by at least half again. Free ranges are found by size class, which can round a count up by an
+		// eighth, so that much more is left free in the one region packing leaves
+		const std::uint64_t capacity = mAllocator.GetSize();
+		const std::uint64_t needed = capacity - mAllocator.GetStats().freeSpace + count + count / 8 + 1;
+		const std::uint64_t grown = std::min<std::uint64_t>(std::max(needed, capacity * 3 / 2), 0xfffffffe);
+		return Compact(static_cast<std::uint32_t>(grown));
+	}
+
+	std::uint32_t BufferSubAllocator::GetOffset(BufferRangeHandle handle) const
+	{
+		return mRanges[handle].offset;
+	}
+
+	std::uint32_t BufferSubAllocator::GetCount(BufferRangeHandle handle) const
+	{
+		return mAllocator.GetAllocationSize(mRanges[handle]);
+	}
+
+	bool BufferSubAllocator::Compact(std::uint32_t capacity)
+	{
+		if (capacity == 0)
+		{
+			capacity = mAllocator.GetSize();
+		}
+
+		// The allocator reports moves by node, which the handles are found from
+		mNodeHandles.resize(mMaxRanges);
+		for (BufferRangeHandle handle = 0; handle < mRanges.size(); ++handle)
+		{
+			if (mRanges[handle].IsValid())
+			{
+				mNodeHandles[mRanges[handle].node] = handle;
+			}
+		}
+
+		// Compacting changes nothing and moves nothing when the ranges do not fit, so the storage only has to follow
+		// on success
+		mMoves.clear();
+		const bool fits = mAllocator.Compact(capacity, [&](const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t count)
+		{
+			mRanges[mNodeHandles[from.node]] = to;
+			mMoves.push_back({ from.offset, to.offset, count });
+		});
+		if (!fits)
+		{
+			return false;
+		}
+
+		mOnResize(capacity, mMoves);
+		return true;
+	}
+
+	std::uint32_t BufferSubAllocator::GetCapacity() const
+	{
+		return mAllocator.GetSize();
+	}
+
+	OffsetAllocatorStats BufferSubAllocator::GetStats() const
+	{
+		return mAllocator.GetStats();
+	}
+}
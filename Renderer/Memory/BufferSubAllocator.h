@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Memory/OffsetAllocator.h"
+
+namespace renderer
+{
+	using BufferRangeHandle = std::uint32_t;
+	constexpr BufferRangeHandle InvalidBufferRange = 0xffffffff;
+
+	/** A range that moves when its buffer is compacted or grown. Offsets and counts are in elements */
+	struct BufferRelocation
+	{
+		std::uint32_t from;
+		std::uint32_t to;
+		std::uint32_t count;
+	};
+
+	/**
+	 * Ranges of one growable buffer handed out by handle, so the buffer can be packed or grown under them. The
+	 * owner of the storage is asked to move into storage of a new capacity, and handles stay valid throughout.
+	 */
+	class BufferSubAllocator
+	{
+	public:
+		/**
+		 * Called when the storage has to change, with the new capacity and the ranges to copy from the old storage
+		 * into the new one. The moves are in offset order and never overlap within the new storage.
+		 */
+		using ResizeCallback = std::function<void(std::uint32_t capacity, const std::vector<BufferRelocation>& moves)>;
+
+		BufferSubAllocator(std::uint32_t capacity, const ResizeCallback& onResize, std::uint32_t maxRanges = 64 * 1024);
+
+		/**
+		 * Allocates count elements, which must not be zero. Fragmented space is packed and full storage grown when
+		 * the range does not fit. Returns InvalidBufferRange when maxRanges are in use or the storage cannot grow.
+		 */
+		BufferRangeHandle Allocate(std::uint32_t count);
+		void Free(BufferRangeHandle handle);
+		/** Makes room for count more elements at once, so allocating many ranges does not grow the storage repeatedly */
+		bool Reserve(std::uint32_t count);
+		std::uint32_t GetOffset(BufferRangeHandle handle) const;
+		std::uint32_t GetCount(BufferRangeHandle handle) const;
+		/** Packs every range to the start of storage of the capacity, or the current capacity if zero */
+		bool Compact(std::uint32_t capacity = 0);
+		std::uint32_t GetCapacity() const;
+		OffsetAllocatorStats GetStats() const;
+
+	private:
+		/** Packs the ranges into storage with a free region of at least count */
+		bool Grow(std::uint32_t count);
+
+		OffsetAllocator mAllocator;
+		ResizeCallback mOnResize;
+		// Indexed by handle. Free handles have an invalid allocation
+		std::vector<OffsetAllocation> mRanges;
+		std::vector<BufferRangeHandle> mFreeHandles;
+		std::uint32_t mMaxRanges;
+		// Scratch of Compact: the handle of each allocator node, and the moves passed to the callback
+		std::vector<BufferRangeHandle> mNodeHandles;
+		std::vector<BufferRelocation> mMoves;
+	};
+}
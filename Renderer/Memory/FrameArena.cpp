@@ -0,0 +1,149 @@
+#include "FrameArena.h"
+
+namespace renderer
+{
+	LinearArena::LinearArena(size_t blockSize)
+		: mCurrent(nullptr), mEnd(nullptr), mBlockSize(blockSize), mUsed(0), mPeakUsed(0), mMemory(MemoryTag::FrameArena)
+	{
+
+	}
+
+	LinearArena::LinearArena(LinearArena&& other) noexcept
+		: mBlocks(std::move(other.mBlocks)), mCurrent(other.mCurrent), mEnd(other.mEnd), mBlockSize(other.mBlockSize),
+		mUsed(other.mUsed), mPeakUsed(other.mPeakUsed), mMemory(std::move(other.mMemory))
+	{
+		other.mCurrent = nullptr;
+		other.mEnd = nullptr;
+		other.mUsed = 0;
+	}
+
+	LinearArena& LinearArena::operator=(LinearArena&& other) noexcept
+	{
+		mBlocks = std::move(other.mBlocks);
+		mCurrent = other.mCurrent;
+		mEnd = other.mEnd;
+		mBlockSize = other.mBlockSize;
+		mUsed = other.mUsed;
+		mPeakUsed = other.mPeakUsed;
+		mMemory = std::move(other.mMemory);
+		other.mCurrent = nullptr;
+		other.mEnd = nullptr;
+		other.mUsed = 0;
+		return *this;
+	}
+
+	void* LinearArena::AllocateBlock(size_t size, size_t alignment)
+	{
+		// Blocks at least double so a growing use needs few of them
+		const size_t lastSize = mBlocks.empty() ? 0 : mBlocks.back().size;
+		Block block;
+		block.size = std::max(std::max(mBlockSize, lastSize * 2), size + alignment);
+		block.memory.reset(new std::uint8_t[block.size]);
+		mBlocks.push_back(std::move(block));
+		UseBlock(mBlocks.back());
+		mMemory.Set(GetCapacity());
+
+		// Whatever was left of the previous block is not counted, it is reclaimed by the next reset
+		return Allocate(size, alignment);
+	}
+
+	void LinearArena::UseBlock(Block& block)
+	{
+		mCurrent = block.memory.get();
+		mEnd = mCurrent + block.size;
+	}
+
+	void LinearArena::Reset()
+	{
+		mPeakUsed = std::max(mPeakUsed, mUsed);
+		if (mBlocks.size() > 1)
+		{
+			// Replace the blocks with one that fits the largest use seen, with some room to grow. The blocks are
+			// not kept because growing by doubling leaves them far bigger than the use together
+			mBlocks.clear();
+			Block block;
+			block.size = std::max(mBlockSize, mPeakUsed + mPeakUsed / 4);
+			block.memory.reset(new std::uint8_t[block.size]);
+			mBlocks.push_back(std::move(block));
+			mMemory.Set(GetCapacity());
+		}
+		if (mBlocks.empty())
+		{
+			mCurrent = nullptr;
+			mEnd = nullptr;
+		}
+		else
+		{
+			UseBlock(mBlocks.front());
+		}
+		mUsed = 0;
+	}
+
+	size_t LinearArena::GetUsed() const
+	{
+		return mUsed;
+	}
+
+	size_t LinearArena::GetPeakUsed() const
+	{
+		return std::max(mPeakUsed, mUsed);
+	}
+
+	size_t LinearArena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const auto& block : mBlocks)
+		{
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	FrameArena::FrameArena(std::uint32_t threadCount, size_t blockSize)
+		: mFrameIndex(0), mPeakUsed(0)
+	{
+		for (auto& arenas : mFrames)
+		{
+			for (std::uint32_t i = 0; i < std::max(threadCount, 1u); ++i)
+			{
+				arenas.emplace_back(blockSize);
+			}
+		}
+	}
+
+	void FrameArena::BeginFrame()
+	{
+		size_t used = 0;
+		for (const auto& arena : mFrames[mFrameIndex % FrameCount])
+		{
+			used += arena.GetUsed();
+		}
+		mPeakUsed = std::max(mPeakUsed, used);
+
+		++mFrameIndex;
+		for (auto& arena : mFrames[mFrameIndex % FrameCount])
+		{
+			arena.Reset();
+		}
+	}
+
+	LinearArena& FrameArena::GetArena(std::uint32_t thread)
+	{
+		return mFrames[mFrameIndex % FrameCount][thread];
+	}
+
+	std::uint32_t FrameArena::GetThreadCount() const
+	{
+		return static_cast<std::uint32_t>(mFrames[0].size());
+	}
+
+	std::uint64_t FrameArena::GetFrameIndex() const
+	{
+		return mFrameIndex;
+	}
+
+	size_t FrameArena::GetPeakUsed() const
+	{
+		return mPeakUsed;
+	}
+}
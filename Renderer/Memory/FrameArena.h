@@ -0,0 +1,185 @@
+#pragma once
+
+#include "Minimal.h"
+#include <cstddef>
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	/**
+	 * Bump allocator. Allocations are never freed one by one, everything is released together by Reset.
+	 * When a use overflows the first block, Reset replaces the blocks with one big enough for the whole use,
+	 * so once the size settles every use fits without touching the heap. Not thread safe.
+	 */
+	class LinearArena
+	{
+	public:
+		explicit LinearArena(size_t blockSize = 64 * 1024);
+		LinearArena(LinearArena&& other) noexcept;
+		LinearArena& operator=(LinearArena&& other) noexcept;
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			// The fast path is a pointer bump. Anything that does not fit goes to a new block
+			std::uintptr_t current = reinterpret_cast<std::uintptr_t>(mCurrent);
+			std::uintptr_t aligned = (current + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+			if (aligned + size > reinterpret_cast<std::uintptr_t>(mEnd))
+			{
+				return AllocateBlock(size, alignment);
+			}
+			mUsed += aligned + size - current;
+			mCurrent = reinterpret_cast<std::uint8_t*>(aligned + size);
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		template<typename T>
+		T* Allocate(size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		/** Releases every allocation. Only call once nothing allocated from the arena is used */
+		void Reset();
+		/** Bytes handed out since the last reset, including alignment padding */
+		size_t GetUsed() const;
+		/** Most bytes used between two resets */
+		size_t GetPeakUsed() const;
+		size_t GetCapacity() const;
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::uint8_t[]> memory;
+			size_t size;
+		};
+
+		void* AllocateBlock(size_t size, size_t alignment);
+		void UseBlock(Block& block);
+
+		std::vector<Block> mBlocks;
+		std::uint8_t* mCurrent;
+		std::uint8_t* mEnd;
+		size_t mBlockSize;
+		size_t mUsed;
+		size_t mPeakUsed;
+		// Every block is accounted to the frame arena tag
+		TrackedMemory mMemory;
+	};
+
+	/**
+	 * Arenas for data that only lives for a frame or two. Each frame has its own set so what was built last frame
+	 * stays readable while the next frame is built, and each thread has its own arena so threads never contend.
+	 * Memory from frame N is reused from frame N + FrameCount, so containers using it must be rebuilt or dropped by then.
+	 */
+	class FrameArena
+	{
+	public:
+		static constexpr std::uint32_t FrameCount = 2;
+
+		explicit FrameArena(std::uint32_t threadCount = 1, size_t blockSize = 64 * 1024);
+		/** Moves to the next frame and resets its arenas */
+		void BeginFrame();
+		/** Arena of the current frame for the thread. Thread 0 is the render thread */
+		LinearArena& GetArena(std::uint32_t thread = 0);
+		std::uint32_t GetThreadCount() const;
+		std::uint64_t GetFrameIndex() const;
+		/** Most bytes any frame used across all threads */
+		size_t GetPeakUsed() const;
+
+	private:
+		std::array<std::vector<LinearArena>, FrameCount> mFrames;
+		std::uint64_t mFrameIndex;
+		size_t mPeakUsed;
+	};
+
+	/**
+	 * Standard library allocator that takes memory from an arena and never frees it. Without an arena it uses the
+	 * heap, so containers that are sometimes built outside a frame keep working.
+	 */
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+		// The arena travels with the contents so moved containers free into the right place
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		ArenaAllocator(LinearArena* arena = nullptr) noexcept
+			: mArena(arena)
+		{
+
+		}
+
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+			: mArena(other.GetArena())
+		{
+
+		}
+
+		T* allocate(size_t count)
+		{
+			if (mArena)
+			{
+				return mArena->Allocate<T>(count);
+			}
+			return static_cast<T*>(::operator new(sizeof(T) * count));
+		}
+
+		void deallocate(T* pointer, size_t count)
+		{
+			if (!mArena)
+			{
+				::operator delete(pointer);
+			}
+		}
+
+		LinearArena* GetArena() const
+		{
+			return mArena;
+		}
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const
+		{
+			return mArena == other.GetArena();
+		}
+
+		template<typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const
+		{
+			return mArena != other.GetArena();
+		}
+
+	private:
+		LinearArena* mArena;
+	};
+
+	template<typename T>
+	using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+	template<typename Key, typename Value>
+	using FrameMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, ArenaAllocator<std::pair<const Key, Value>>>;
+
+	/**
+	 * Empties the vector and reserves room for the frame. With an arena the vector is rebuilt on it, otherwise it
+	 * keeps its heap memory from earlier frames.
+	 */
+	template<typename T>
+	void PrepareFrameVector(FrameVector<T>& vector, LinearArena* arena, size_t capacity)
+	{
+		if (arena || vector.get_allocator().GetArena())
+		{
+			vector = FrameVector<T>(ArenaAllocator<T>(arena));
+		}
+		else
+		{
+			vector.clear();
+		}
+		vector.reserve(capacity);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Minimal.h"
+
+namespace renderer
+{
+	/**
+	 * A file mapped read only into memory. Pages are read from disk the first time they are touched and shared with
+	 * the file cache, so opening costs the same whatever the size of the file.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/** Maps the whole file, closing the one mapped before. Fails for missing and empty files */
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const;
+		const std::uint8_t* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const std::uint8_t* mData;
+		size_t mSize;
+#ifdef _WIN32
+		HANDLE mFile;
+		HANDLE mMapping;
+#endif
+	};
+}
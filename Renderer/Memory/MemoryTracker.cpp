@@ -0,0 +1,180 @@
+#include "MemoryTracker.h"
+
+namespace renderer
+{
+	namespace
+	{
+		const char* TagNames[static_cast<size_t>(MemoryTag::Count)] =
+		{
+			"Entities", "Meshes", "Instances", "Lights", "Constants", "RenderQueue", "FrameArena", "Shaders", "StaticBatches", "Streaming", "FrameCapture", "SceneCommands"
+		};
+
+		const char* DomainNames[static_cast<size_t>(MemoryDomain::Count)] = { "CPU", "GPU" };
+
+		double ToMegabytes(std::uint64_t bytes)
+		{
+			return bytes / (1024.0 * 1024.0);
+		}
+	}
+
+	MemoryTracker& MemoryTracker::Get()
+	{
+		static MemoryTracker tracker;
+		return tracker;
+	}
+
+	MemoryTracker::MemoryTracker()
+	{
+		for (auto& counter : mCounters)
+		{
+			counter.current.store(0, std::memory_order_relaxed);
+			counter.peak.store(0, std::memory_order_relaxed);
+			counter.budget = 0;
+		}
+	}
+
+	MemoryTracker::Counter& MemoryTracker::GetCounter(MemoryTag tag, MemoryDomain domain)
+	{
+		return mCounters[static_cast<size_t>(tag) * static_cast<size_t>(MemoryDomain::Count) + static_cast<size_t>(domain)];
+	}
+
+	const MemoryTracker::Counter& MemoryTracker::GetCounter(MemoryTag tag, MemoryDomain domain) const
+	{
+		return mCounters[static_cast<size_t>(tag) * static_cast<size_t>(MemoryDomain::Count) + static_cast<size_t>(domain)];
+	}
+
+	void MemoryTracker::Allocate(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes)
+	{
+		Counter& counter = GetCounter(tag, domain);
+		const std::uint64_t previous = counter.current.fetch_add(bytes, std::memory_order_relaxed);
+		const std::uint64_t current = previous + bytes;
+
+		std::uint64_t peak = counter.peak.load(std::memory_order_relaxed);
+		while (current > peak && !counter.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+		{
+		}
+
+		// Only the allocation that crosses the budget reports, not every one made while over it
+		if (counter.budget != 0 && previous <= counter.budget && current > counter.budget && mBudgetCallback)
+		{
+			MemoryUsage usage;
+			usage.current = current;
+			usage.peak = std::max(peak, current);
+			usage.budget = counter.budget;
+			mBudgetCallback(tag, domain, usage);
+		}
+	}
+
+	void MemoryTracker::Free(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes)
+	{
+		GetCounter(tag, domain).current.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	MemoryUsage MemoryTracker::GetUsage(MemoryTag tag, MemoryDomain domain) const
+	{
+		const Counter& counter = GetCounter(tag, domain);
+		MemoryUsage usage;
+		usage.current = counter.current.load(std::memory_order_relaxed);
+		usage.peak = counter.peak.load(std::memory_order_relaxed);
+		usage.budget = counter.budget;
+		return usage;
+	}
+
+	std::uint64_t MemoryTracker::GetTotal(MemoryDomain domain) const
+	{
+		std::uint64_t total = 0;
+		for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+		{
+			total += GetCounter(static_cast<MemoryTag>(tag), domain).current.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+
+	void MemoryTracker::ResetPeaks()
+	{
+		for (auto& counter : mCounters)
+		{
+			counter.peak.store(counter.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	void MemoryTracker::SetBudget(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes)
+	{
+		GetCounter(tag, domain).budget = bytes;
+	}
+
+	void MemoryTracker::SetBudgetCallback(const MemoryBudgetCallback& callback)
+	{
+		mBudgetCallback = callback;
+	}
+
+	const char* MemoryTracker::GetTagName(MemoryTag tag)
+	{
+		return tag < MemoryTag::Count ? TagNames[static_cast<size_t>(tag)] : "Unknown";
+	}
+
+	const char* MemoryTracker::GetDomainName(MemoryDomain domain)
+	{
+		return domain < MemoryDomain::Count ? DomainNames[static_cast<size_t>(domain)] : "Unknown";
+	}
+
+	void MemoryTracker::Print(std::ostream& stream) const
+	{
+		const auto flags = stream.flags();
+		const auto precision = stream.precision();
+		stream << std::left << std::setw(16) << "Memory" << std::right << std::setw(6) << ""
+			<< std::setw(14) << "current MB" << std::setw(12) << "peak MB" << std::setw(12) << "budget MB" << "\n";
+		stream << std::fixed << std::setprecision(2);
+		for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+		{
+			for (std::uint32_t domain = 0; domain < static_cast<std::uint32_t>(MemoryDomain::Count); ++domain)
+			{
+				const MemoryUsage usage = GetUsage(static_cast<MemoryTag>(tag), static_cast<MemoryDomain>(domain));
+				if (usage.peak == 0 && usage.budget == 0)
+				{
+					continue;
+				}
+				stream << std::left << std::setw(16) << GetTagName(static_cast<MemoryTag>(tag)) << std::right
+					<< std::setw(6) << GetDomainName(static_cast<MemoryDomain>(domain))
+					<< std::setw(14) << ToMegabytes(usage.current) << std::setw(12) << ToMegabytes(usage.peak);
+				if (usage.budget != 0)
+				{
+					stream << std::setw(12) << ToMegabytes(usage.budget);
+				}
+				stream << "\n";
+			}
+		}
+		stream.flags(flags);
+		stream.precision(precision);
+	}
+
+	TrackedMemory::TrackedMemory(MemoryTag tag, MemoryDomain domain)
+		: mTag(tag), mDomain(domain), mBytes(0)
+	{
+
+	}
+
+	TrackedMemory::TrackedMemory(TrackedMemory&& other) noexcept
+		: mTag(other.mTag), mDomain(other.mDomain), mBytes(other.mBytes)
+	{
+		other.mBytes = 0;
+	}
+
+	TrackedMemory& TrackedMemory::operator=(TrackedMemory&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Set(0);
+			mTag = other.mTag;
+			mDomain = other.mDomain;
+			mBytes = other.mBytes;
+			other.mBytes = 0;
+		}
+		return *this;
+	}
+
+	TrackedMemory::~TrackedMemory()
+	{
+		Set(0);
+	}
+}
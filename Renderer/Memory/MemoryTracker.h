@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Minimal.h"
+#include <atomic>
+#include <functional>
+
+namespace renderer
+{
+	/** Renderer subsystem memory is accounted to */
+	enum class MemoryTag : std::uint32_t
+	{
+		// Entity lists of the scene
+		Entities,
+		// Vertex and index buffers
+		Meshes,
+		// Instance buffers and the bounds, masks and instance arrays they are built from
+		Instances,
+		// Light buffers and the packed lights uploaded to them
+		Lights,
+		// Constant buffers
+		Constants,
+		// Draw items and sort scratch
+		RenderQueue,
+		// Blocks of the frame arenas
+		FrameArena,
+		// Compiled shader bytecode
+		Shaders,
+		// Members of static batches and their geometry until it is uploaded
+		StaticBatches,
+		// World cells loaded by the streamer, including the ones waiting to be given to the renderer
+		Streaming,
+		// Frames waiting to be written to image files, and the staging textures the back buffer is read back through
+		FrameCapture,
+		// Scene commands recorded on other threads and not yet applied
+		SceneCommands,
+		Count
+	};
+
+	enum class MemoryDomain : std::uint32_t
+	{
+		Cpu,
+		Gpu,
+		Count
+	};
+
+	struct MemoryUsage
+	{
+		std::uint64_t current = 0;
+		std::uint64_t peak = 0;
+		// Budget the current bytes are checked against. Zero when there is none
+		std::uint64_t budget = 0;
+	};
+
+	/** Called on the allocating thread when an allocation takes a tag over its budget */
+	using MemoryBudgetCallback = std::function<void(MemoryTag tag, MemoryDomain domain, const MemoryUsage& usage)>;
+
+	/**
+	 * Current and peak bytes of every subsystem, on the CPU and the GPU. Counting is lock free so any thread can
+	 * report. There is one tracker for the process because heap containers have nowhere to keep a pointer to one.
+	 */
+	class MemoryTracker
+	{
+	public:
+		static MemoryTracker& Get();
+
+		void Allocate(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes);
+		void Free(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes);
+		MemoryUsage GetUsage(MemoryTag tag, MemoryDomain domain) const;
+		/** Current bytes of every tag in the domain */
+		std::uint64_t GetTotal(MemoryDomain domain) const;
+		/** Starts the peaks again from the current bytes, so a run can measure its own peaks */
+		void ResetPeaks();
+
+		/**
+		 * The callback runs each time the tag goes from within its budget to over it. Zero removes the budget.
+		 * Budgets and the callback should be set before other threads are allocating.
+		 */
+		void SetBudget(MemoryTag tag, MemoryDomain domain, std::uint64_t bytes);
+		void SetBudgetCallback(const MemoryBudgetCallback& callback);
+
+		static const char* GetTagName(MemoryTag tag);
+		static const char* GetDomainName(MemoryDomain domain);
+		/** Table of every tag with memory or a budget */
+		void Print(std::ostream& stream) const;
+
+	private:
+		MemoryTracker();
+
+		struct Counter
+		{
+			std::atomic<std::uint64_t> current;
+			std::atomic<std::uint64_t> peak;
+			std::uint64_t budget;
+		};
+
+		Counter& GetCounter(MemoryTag tag, MemoryDomain domain);
+		const Counter& GetCounter(MemoryTag tag, MemoryDomain domain) const;
+
+		std::array<Counter, static_cast<size_t>(MemoryTag::Count) * static_cast<size_t>(MemoryDomain::Count)> mCounters;
+		MemoryBudgetCallback mBudgetCallback;
+	};
+
+	/**
+	 * Bytes held by one container or resource. Setting it reports the change to the tracker and destroying it frees
+	 * what is left, so an owner only has to say how big it is now.
+	 */
+	class TrackedMemory
+	{
+	public:
+		explicit TrackedMemory(MemoryTag tag, MemoryDomain domain = MemoryDomain::Cpu);
+		TrackedMemory(TrackedMemory&& other) noexcept;
+		TrackedMemory& operator=(TrackedMemory&& other) noexcept;
+		TrackedMemory(const TrackedMemory&) = delete;
+		TrackedMemory& operator=(const TrackedMemory&) = delete;
+		~TrackedMemory();
+
+		void Set(std::uint64_t bytes)
+		{
+			if (bytes > mBytes)
+			{
+				MemoryTracker::Get().Allocate(mTag, mDomain, bytes - mBytes);
+			}
+			else if (bytes < mBytes)
+			{
+				MemoryTracker::Get().Free(mTag, mDomain, mBytes - bytes);
+			}
+			mBytes = bytes;
+		}
+
+		std::uint64_t Get() const
+		{
+			return mBytes;
+		}
+
+	private:
+		MemoryTag mTag;
+		MemoryDomain mDomain;
+		std::uint64_t mBytes;
+	};
+
+	/** Bytes the vector has allocated, used or not */
+	template<typename T, typename Allocator>
+	std::uint64_t GetCapacityBytes(const std::vector<T, Allocator>& vector)
+	{
+		return sizeof(T) * vector.capacity();
+	}
+}
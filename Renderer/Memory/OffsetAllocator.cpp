@@ -0,0 +1,412 @@
+#include "OffsetAllocator.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace renderer
+{
+	namespace
+	{
+		constexpr std::uint32_t MantissaBits = 3;
+		constexpr std::uint32_t MantissaValue = 1 << MantissaBits;
+		constexpr std::uint32_t MantissaMask = MantissaValue - 1;
+		constexpr std::uint32_t NotFound = 0xffffffff;
+
+		// Callers never pass zero
+		std::uint32_t CountLeadingZeros(std::uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse(&index, value);
+			return 31 - index;
+#else
+			return static_cast<std::uint32_t>(__builtin_clz(value));
+#endif
+		}
+
+		std::uint32_t CountTrailingZeros(std::uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return index;
+#else
+			return static_cast<std::uint32_t>(__builtin_ctz(value));
+#endif
+		}
+
+		/** Index of the lowest set bit at or above start */
+		std::uint32_t FindLowestSetBitAfter(std::uint32_t mask, std::uint32_t start)
+		{
+			if (start >= 32)
+			{
+				return NotFound;
+			}
+			const std::uint32_t bitsAfter = mask & ~((1u << start) - 1);
+			return bitsAfter == 0 ? NotFound : CountTrailingZeros(bitsAfter);
+		}
+
+		/**
+		 * Bin of a size as a float with a 3 bit mantissa. Rounding up finds a bin whose every range fits the size,
+		 * rounding down finds the bin a free range is filed under.
+		 */
+		std::uint32_t SizeToBin(std::uint32_t size, bool roundUp)
+		{
+			std::uint32_t exponent = 0;
+			std::uint32_t mantissa = 0;
+			if (size < MantissaValue)
+			{
+				// Denormals, stored exactly
+				mantissa = size;
+			}
+			else
+			{
+				const std::uint32_t highestBit = 31 - CountLeadingZeros(size);
+				const std::uint32_t mantissaStart = highestBit - MantissaBits;
+				exponent = mantissaStart + 1;
+				mantissa = (size >> mantissaStart) & MantissaMask;
+				if (roundUp && (size & ((1u << mantissaStart) - 1)) != 0)
+				{
+					// A mantissa overflow carries into the exponent, which is the next bin up
+					++mantissa;
+				}
+			}
+			return (exponent << MantissaBits) + mantissa;
+		}
+
+		std::uint32_t BinToSize(std::uint32_t bin)
+		{
+			const std::uint32_t exponent = bin >> MantissaBits;
+			const std::uint32_t mantissa = bin & MantissaMask;
+			return exponent == 0 ? mantissa : (mantissa | MantissaValue) << (exponent - 1);
+		}
+	}
+
+	OffsetAllocator::OffsetAllocator(std::uint32_t size, std::uint32_t maxAllocations)
+		: mSize(size), mMaxAllocations(std::max(maxAllocations, 2u))
+	{
+		Reset();
+	}
+
+	void OffsetAllocator::Reset()
+	{
+		ClearNodes();
+		if (mSize > 0)
+		{
+			InsertIntoBin(mSize, 0);
+		}
+	}
+
+	void OffsetAllocator::ClearNodes()
+	{
+		mFreeSpace = 0;
+		mAllocationCount = 0;
+		mUsedTopBins = 0;
+		mUsedLeafBins.fill(0);
+		mBinHeads.fill(Unused);
+
+		mNodes.assign(mMaxAllocations, Node());
+		mFreeNodes.resize(mMaxAllocations);
+		// Popped from the top, so node 0 is handed out first
+		for (std::uint32_t i = 0; i < mMaxAllocations; ++i)
+		{
+			mFreeNodes[i] = mMaxAllocations - i - 1;
+		}
+		mFreeNodeTop = mMaxAllocations - 1;
+	}
+
+	OffsetAllocation OffsetAllocator::Allocate(std::uint32_t size)
+	{
+		// One node is always kept back for what is left of the range that gets split
+		if (size == 0 || mFreeNodeTop == 0)
+		{
+			return OffsetAllocation();
+		}
+
+		// Round up so every range in the bin found is big enough
+		const std::uint32_t minBin = SizeToBin(size, true);
+		const std::uint32_t minTopBin = minBin >> MantissaBits;
+		const std::uint32_t minLeafBin = minBin & MantissaMask;
+
+		std::uint32_t topBin = minTopBin;
+		std::uint32_t leafBin = NotFound;
+		if (topBin < TopBinCount && (mUsedTopBins & (1u << topBin)))
+		{
+			leafBin = FindLowestSetBitAfter(mUsedLeafBins[topBin], minLeafBin);
+		}
+		if (leafBin == NotFound)
+		{
+			// Any range in a bigger top bin fits
+			topBin = FindLowestSetBitAfter(mUsedTopBins, minTopBin + 1);
+			if (topBin == NotFound)
+			{
+				return OffsetAllocation();
+			}
+			leafBin = CountTrailingZeros(mUsedLeafBins[topBin]);
+		}
+
+		const std::uint32_t bin = (topBin << MantissaBits) | leafBin;
+		const std::uint32_t nodeIndex = mBinHeads[bin];
+		Node& node = mNodes[nodeIndex];
+		const std::uint32_t nodeSize = node.size;
+		node.size = size;
+		node.used = true;
+
+		mBinHeads[bin] = node.binNext;
+		if (node.binNext != Unused)
+		{
+			mNodes[node.binNext].binPrevious = Unused;
+		}
+		if (mBinHeads[bin] == Unused)
+		{
+			mUsedLeafBins[topBin] &= ~(1u << leafBin);
+			if (mUsedLeafBins[topBin] == 0)
+			{
+				mUsedTopBins &= ~(1u << topBin);
+			}
+		}
+		mFreeSpace -= nodeSize;
+		++mAllocationCount;
+
+		// The rest of the range goes back as a free node after the allocation
+		const std::uint32_t remainder = nodeSize - size;
+		if (remainder > 0)
+		{
+			const std::uint32_t offset = mNodes[nodeIndex].offset;
+			const std::uint32_t newIndex = InsertIntoBin(remainder, offset + size);
+			Node& allocated = mNodes[nodeIndex];
+			if (allocated.neighbourNext != Unused)
+			{
+				mNodes[allocated.neighbourNext].neighbourPrevious = newIndex;
+			}
+			mNodes[newIndex].neighbourPrevious = nodeIndex;
+			mNodes[newIndex].neighbourNext = allocated.neighbourNext;
+			allocated.neighbourNext = newIndex;
+		}
+
+		OffsetAllocation allocation;
+		allocation.offset = mNodes[nodeIndex].offset;
+		allocation.node = nodeIndex;
+		return allocation;
+	}
+
+	void OffsetAllocator::Free(const OffsetAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+		{
+			return;
+		}
+
+		const std::uint32_t nodeIndex = allocation.node;
+		Node& node = mNodes[nodeIndex];
+		std::uint32_t offset = node.offset;
+		std::uint32_t size = node.size;
+
+		// Merge with free neighbours so the range goes back as big as it can be
+		if (node.neighbourPrevious != Unused && !mNodes[node.neighbourPrevious].used)
+		{
+			const Node& previous = mNodes[node.neighbourPrevious];
+			offset = previous.offset;
+			size += previous.size;
+			const std::uint32_t previousIndex = node.neighbourPrevious;
+			node.neighbourPrevious = previous.neighbourPrevious;
+			RemoveFromBin(previousIndex);
+		}
+		if (node.neighbourNext != Unused && !mNodes[node.neighbourNext].used)
+		{
+			const Node& next = mNodes[node.neighbourNext];
+			size += next.size;
+			const std::uint32_t nextIndex = node.neighbourNext;
+			node.neighbourNext = next.neighbourNext;
+			RemoveFromBin(nextIndex);
+		}
+
+		const std::uint32_t neighbourPrevious = node.neighbourPrevious;
+		const std::uint32_t neighbourNext = node.neighbourNext;
+		node = Node();
+		mFreeNodes[++mFreeNodeTop] = nodeIndex;
+		--mAllocationCount;
+
+		const std::uint32_t mergedIndex = InsertIntoBin(size, offset);
+		if (neighbourNext != Unused)
+		{
+			mNodes[mergedIndex].neighbourNext = neighbourNext;
+			mNodes[neighbourNext].neighbourPrevious = mergedIndex;
+		}
+		if (neighbourPrevious != Unused)
+		{
+			mNodes[mergedIndex].neighbourPrevious = neighbourPrevious;
+			mNodes[neighbourPrevious].neighbourNext = mergedIndex;
+		}
+	}
+
+	std::uint32_t OffsetAllocator::GetAllocationSize(const OffsetAllocation& allocation) const
+	{
+		return allocation.IsValid() ? mNodes[allocation.node].size : 0;
+	}
+
+	bool OffsetAllocator::Compact(std::uint32_t newSize, const MoveCallback& onMove)
+	{
+		if (newSize == 0)
+		{
+			newSize = mSize;
+		}
+
+		std::vector<OffsetAllocation> allocations;
+		allocations.reserve(mAllocationCount);
+		std::uint64_t usedSpace = 0;
+		for (std::uint32_t i = 0; i < mMaxAllocations; ++i)
+		{
+			if (mNodes[i].used)
+			{
+				allocations.push_back({ mNodes[i].offset, i });
+				usedSpace += mNodes[i].size;
+			}
+		}
+		if (usedSpace > newSize)
+		{
+			return false;
+		}
+		std::sort(allocations.begin(), allocations.end(), [](const OffsetAllocation& a, const OffsetAllocation& b)
+		{
+			return a.offset < b.offset;
+		});
+
+		std::vector<std::uint32_t> sizes(allocations.size());
+		for (size_t i = 0; i < allocations.size(); ++i)
+		{
+			sizes[i] = mNodes[allocations[i].node].size;
+		}
+
+		// Laid out end to end rather than allocated again, as allocating looks for a bin the rounded up size fits
+		// and could fail to place allocations that fit exactly. Every allocation already had a node and one more
+		// was kept back, so there are enough for the free range at the end
+		mSize = newSize;
+		ClearNodes();
+		std::vector<OffsetAllocation> moved(allocations.size());
+		std::uint32_t offset = 0;
+		std::uint32_t previous = Unused;
+		for (size_t i = 0; i < allocations.size(); ++i)
+		{
+			const std::uint32_t nodeIndex = mFreeNodes[mFreeNodeTop--];
+			Node& node = mNodes[nodeIndex];
+			node.offset = offset;
+			node.size = sizes[i];
+			node.used = true;
+			node.neighbourPrevious = previous;
+			if (previous != Unused)
+			{
+				mNodes[previous].neighbourNext = nodeIndex;
+			}
+			moved[i] = { offset, nodeIndex };
+			offset += sizes[i];
+			previous = nodeIndex;
+		}
+		mAllocationCount = static_cast<std::uint32_t>(allocations.size());
+		if (offset < mSize)
+		{
+			const std::uint32_t freeIndex = InsertIntoBin(mSize - offset, offset);
+			mNodes[freeIndex].neighbourPrevious = previous;
+			if (previous != Unused)
+			{
+				mNodes[previous].neighbourNext = freeIndex;
+			}
+		}
+
+		for (size_t i = 0; i < allocations.size(); ++i)
+		{
+			onMove(allocations[i], moved[i], sizes[i]);
+		}
+		return true;
+	}
+
+	std::uint32_t OffsetAllocator::GetSize() const
+	{
+		return mSize;
+	}
+
+	OffsetAllocatorStats OffsetAllocator::GetStats() const
+	{
+		OffsetAllocatorStats stats;
+		stats.freeSpace = mFreeSpace;
+		stats.allocations = mAllocationCount;
+		if (mUsedTopBins != 0)
+		{
+			const std::uint32_t topBin = 31 - CountLeadingZeros(mUsedTopBins);
+			const std::uint32_t leafBin = 31 - CountLeadingZeros(mUsedLeafBins[topBin]);
+			stats.largestFreeRegion = BinToSize((topBin << MantissaBits) | leafBin);
+		}
+		for (std::uint32_t head : mBinHeads)
+		{
+			for (std::uint32_t i = head; i != Unused; i = mNodes[i].binNext)
+			{
+				++stats.freeRegions;
+			}
+		}
+		return stats;
+	}
+
+	std::uint32_t OffsetAllocator::InsertIntoBin(std::uint32_t size, std::uint32_t offset)
+	{
+		// Round down so the range is at least as big as every size that maps to the bin
+		const std::uint32_t bin = SizeToBin(size, false);
+		const std::uint32_t topBin = bin >> MantissaBits;
+		const std::uint32_t leafBin = bin & MantissaMask;
+		if (mBinHeads[bin] == Unused)
+		{
+			mUsedLeafBins[topBin] |= 1u << leafBin;
+			mUsedTopBins |= 1u << topBin;
+		}
+
+		const std::uint32_t nodeIndex = mFreeNodes[mFreeNodeTop--];
+		Node& node = mNodes[nodeIndex];
+		node = Node();
+		node.offset = offset;
+		node.size = size;
+		node.binNext = mBinHeads[bin];
+		if (node.binNext != Unused)
+		{
+			mNodes[node.binNext].binPrevious = nodeIndex;
+		}
+		mBinHeads[bin] = nodeIndex;
+		mFreeSpace += size;
+		return nodeIndex;
+	}
+
+	void OffsetAllocator::RemoveFromBin(std::uint32_t nodeIndex)
+	{
+		Node& node = mNodes[nodeIndex];
+		if (node.binPrevious != Unused)
+		{
+			mNodes[node.binPrevious].binNext = node.binNext;
+			if (node.binNext != Unused)
+			{
+				mNodes[node.binNext].binPrevious = node.binPrevious;
+			}
+		}
+		else
+		{
+			// Head of its bin
+			const std::uint32_t bin = SizeToBin(node.size, false);
+			const std::uint32_t topBin = bin >> MantissaBits;
+			const std::uint32_t leafBin = bin & MantissaMask;
+			mBinHeads[bin] = node.binNext;
+			if (node.binNext != Unused)
+			{
+				mNodes[node.binNext].binPrevious = Unused;
+			}
+			if (mBinHeads[bin] == Unused)
+			{
+				mUsedLeafBins[topBin] &= ~(1u << leafBin);
+				if (mUsedLeafBins[topBin] == 0)
+				{
+					mUsedTopBins &= ~(1u << topBin);
+				}
+			}
+		}
+
+		mFreeSpace -= node.size;
+		node = Node();
+		mFreeNodes[++mFreeNodeTop] = nodeIndex;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Minimal.h"
+#include <functional>
+
+namespace renderer
+{
+	/** A range handed out by an OffsetAllocator. The node identifies it to the allocator when it is freed */
+	struct OffsetAllocation
+	{
+		static constexpr std::uint32_t NoSpace = 0xffffffff;
+
+		std::uint32_t offset = NoSpace;
+		std::uint32_t node = NoSpace;
+
+		bool IsValid() const
+		{
+			return offset != NoSpace;
+		}
+	};
+
+	struct OffsetAllocatorStats
+	{
+		std::uint32_t freeSpace = 0;
+		// Lower bound on the biggest allocation that would succeed
+		std::uint32_t largestFreeRegion = 0;
+		std::uint32_t freeRegions = 0;
+		std::uint32_t allocations = 0;
+	};
+
+	/**
+	 * Hands out ranges of a linear space, such as elements of a GPU buffer, without touching the space itself.
+	 * Free ranges are kept in two level segregated fit bins (TLSF): sizes are rounded to a float with a 3 bit
+	 * mantissa, the exponent picks one of 32 top level bins and the mantissa one of 8 leaf bins. Bitmasks of the
+	 * non empty bins find a big enough range with two bit scans, so allocating and freeing take constant time.
+	 * Freed ranges merge with free neighbours straight away, and Compact moves allocations together to undo
+	 * fragmentation that merging cannot.
+	 */
+	class OffsetAllocator
+	{
+	public:
+		/** Called for each allocation Compact moves, in offset order, with where it was and where it is now */
+		using MoveCallback = std::function<void(const OffsetAllocation& from, const OffsetAllocation& to, std::uint32_t size)>;
+
+		explicit OffsetAllocator(std::uint32_t size, std::uint32_t maxAllocations = 128 * 1024);
+		OffsetAllocator(OffsetAllocator&& other) noexcept = default;
+		OffsetAllocator& operator=(OffsetAllocator&& other) noexcept = default;
+
+		/** Returns an invalid allocation when there is no free range big enough or no free node */
+		OffsetAllocation Allocate(std::uint32_t size);
+		void Free(const OffsetAllocation& allocation);
+		std::uint32_t GetAllocationSize(const OffsetAllocation& allocation) const;
+		/** Frees everything */
+		void Reset();
+
+		/**
+		 * Packs every allocation to the start of a space of the new size, or the current size if it is zero, so the
+		 * free space becomes one range. Allocations only move down within the old size, so the callback can copy
+		 * them in place in the order it gets them. Fails, changing nothing, if the allocations do not fit.
+		 */
+		bool Compact(std::uint32_t newSize, const MoveCallback& onMove);
+
+		std::uint32_t GetSize() const;
+		OffsetAllocatorStats GetStats() const;
+
+	private:
+		static constexpr std::uint32_t Unused = 0xffffffff;
+		static constexpr std::uint32_t TopBinCount = 32;
+		static constexpr std::uint32_t BinsPerLeaf = 8;
+		static constexpr std::uint32_t LeafBinCount = TopBinCount * BinsPerLeaf;
+
+		struct Node
+		{
+			std::uint32_t offset = 0;
+			std::uint32_t size = 0;
+			// Free nodes of the same bin
+			std::uint32_t binPrevious = Unused;
+			std::uint32_t binNext = Unused;
+			// Nodes on either side in the space, free or not
+			std::uint32_t neighbourPrevious = Unused;
+			std::uint32_t neighbourNext = Unused;
+			bool used = false;
+		};
+
+		/** Empties the bins and frees every node, leaving no free range */
+		void ClearNodes();
+		std::uint32_t InsertIntoBin(std::uint32_t size, std::uint32_t offset);
+		void RemoveFromBin(std::uint32_t nodeIndex);
+
+		std::uint32_t mSize;
+		std::uint32_t mMaxAllocations;
+		std::uint32_t mFreeSpace;
+		std::uint32_t mAllocationCount;
+
+		std::uint32_t mUsedTopBins;
+		std::array<std::uint8_t, TopBinCount> mUsedLeafBins;
+		// First free node of every bin
+		std::array<std::uint32_t, LeafBinCount> mBinHeads;
+
+		std::vector<Node> mNodes;
+		// Stack of node indices not in use
+		std::vector<std::uint32_t> mFreeNodes;
+		std::uint32_t mFreeNodeTop;
+	};
+}
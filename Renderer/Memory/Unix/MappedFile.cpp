@@ -0,0 +1,71 @@
+#include "Memory/MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace renderer
+{
+	MappedFile::MappedFile()
+		: mData(nullptr), mSize(0)
+	{
+
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+		void* data = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		}
+		// The mapping keeps the file open on its own
+		close(file);
+		if (data == MAP_FAILED)
+		{
+			return false;
+		}
+
+		mData = static_cast<const std::uint8_t*>(data);
+		mSize = static_cast<size_t>(status.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData)
+		{
+			munmap(const_cast<std::uint8_t*>(mData), mSize);
+		}
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return mData != nullptr;
+	}
+
+	const std::uint8_t* MappedFile::GetData() const
+	{
+		return mData;
+	}
+
+	size_t MappedFile::GetSize() const
+	{
+		return mSize;
+	}
+}
@@ -0,0 +1,74 @@
+#include "Memory/MappedFile.h"
+
+namespace renderer
+{
+	MappedFile::MappedFile()
+		: mData(nullptr), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(nullptr)
+	{
+
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+		mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER size;
+		if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* data = mMapping ? MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data)
+		{
+			Close();
+			return false;
+		}
+
+		mData = static_cast<const std::uint8_t*>(data);
+		mSize = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData)
+		{
+			UnmapViewOfFile(mData);
+		}
+		if (mMapping)
+		{
+			CloseHandle(mMapping);
+		}
+		if (mFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(mFile);
+		}
+		mData = nullptr;
+		mSize = 0;
+		mFile = INVALID_HANDLE_VALUE;
+		mMapping = nullptr;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return mData != nullptr;
+	}
+
+	const std::uint8_t* MappedFile::GetData() const
+	{
+		return mData;
+	}
+
+	size_t MappedFile::GetSize() const
+	{
+		return mSize;
+	}
+}
@@ -2,7 +2,9 @@
 
 #include "Base/Base.h"
 #include "Math/Math.h"
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 #ifndef SAFE_DELETE
 #define SAFE_DELETE(p)		{ if(p) { delete p; (p)=NULL; } }
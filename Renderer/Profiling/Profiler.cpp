@@ -0,0 +1,207 @@
+#include "Profiling/Profiler.h"
+#include <mutex>
+
+namespace renderer
+{
+	namespace
+	{
+		/**
+		 * Every thread profile created, one per thread that was recording at the same time. Rings of threads that
+		 * exited stay in captures until a new thread takes them over from the retired list
+		 */
+		struct ThreadRegistry
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadProfile>> profiles;
+			std::vector<ThreadProfile*> retired;
+			std::uint32_t nextThreadId = 0;
+		};
+
+		ThreadRegistry& GetRegistry()
+		{
+			static ThreadRegistry registry;
+			return registry;
+		}
+
+		void WriteEscaped(std::ostream& stream, const std::string& text)
+		{
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\')
+				{
+					stream << '\\' << c;
+				}
+				else if (static_cast<unsigned char>(c) < 0x20)
+				{
+					stream << ' ';
+				}
+				else
+				{
+					stream << c;
+				}
+			}
+		}
+	}
+
+	/** Retires the ring of the thread it belongs to when that thread exits */
+	struct ThreadProfileOwner
+	{
+		~ThreadProfileOwner()
+		{
+			if (registered && Profiler::mThreadProfile)
+			{
+				Profiler::RetireThread();
+			}
+		}
+
+		bool registered = false;
+	};
+
+	thread_local ThreadProfile* Profiler::mThreadProfile = nullptr;
+	// Kept apart from the pointer so the hot path reads a trivial thread local without a guard
+	static thread_local ThreadProfileOwner tThreadProfileOwner;
+
+	ThreadProfile::ThreadProfile(std::uint32_t threadId)
+		: mEvents(new EventSlot[Capacity]), mHead(0), mThreadId(threadId), mDepth(0)
+	{
+
+	}
+
+	void ThreadProfile::Read(ThreadCapture& capture) const
+	{
+		// Every event before the published head is complete
+		const std::uint64_t head = mHead.load(std::memory_order_acquire);
+		const std::uint64_t first = head > Capacity ? head - Capacity : 0;
+		capture.events.reserve(head - first);
+		for (std::uint64_t i = first; i < head; ++i)
+		{
+			const EventSlot& slot = mEvents[i & (Capacity - 1)];
+			capture.events.push_back({ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+				slot.end.load(std::memory_order_relaxed), slot.depth.load(std::memory_order_relaxed) });
+		}
+
+		// The owning thread keeps recording while this copies. Drop whatever it may have overwritten meanwhile,
+		// including the slot of the event it may be writing past the head
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const std::uint64_t headAfter = mHead.load(std::memory_order_relaxed);
+		const std::uint64_t firstValid = headAfter >= Capacity ? headAfter - Capacity + 1 : 0;
+		if (firstValid > first)
+		{
+			const size_t overwritten = static_cast<size_t>(std::min(firstValid - first, head - first));
+			capture.events.erase(capture.events.begin(), capture.events.begin() + overwritten);
+		}
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadProfile& profile = GetThreadProfile();
+		ThreadRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		profile.mName = name;
+	}
+
+	ProfileCapture Profiler::Capture()
+	{
+		ThreadRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		ProfileCapture capture;
+		capture.threads.resize(registry.profiles.size());
+		for (size_t i = 0; i < registry.profiles.size(); ++i)
+		{
+			const ThreadProfile& profile = *registry.profiles[i];
+			ThreadCapture& thread = capture.threads[i];
+			thread.threadId = profile.mThreadId;
+			thread.threadName = profile.mName;
+			profile.Read(thread);
+		}
+		return capture;
+	}
+
+	void Profiler::WriteChromeTrace(const ProfileCapture& capture, std::ostream& stream)
+	{
+		// Timestamps start from the earliest event so the trace opens at the start of the capture
+		std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+		for (const auto& thread : capture.threads)
+		{
+			for (const auto& event : thread.events)
+			{
+				origin = std::min(origin, event.start);
+			}
+		}
+
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		auto separator = [&]()
+		{
+			stream << (first ? "\n" : ",\n");
+			first = false;
+		};
+
+		stream << std::fixed << std::setprecision(3);
+		for (const auto& thread : capture.threads)
+		{
+			separator();
+			stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadId << ",\"args\":{\"name\":\"";
+			WriteEscaped(stream, thread.threadName.empty() ? "Thread " + std::to_string(thread.threadId) : thread.threadName);
+			stream << "\"}}";
+
+			// Complete events carry their duration so the viewer nests them by time
+			for (const auto& event : thread.events)
+			{
+				separator();
+				stream << "{\"name\":\"";
+				WriteEscaped(stream, event.name);
+				stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId
+					<< ",\"ts\":" << (event.start - origin) / 1000.0
+					<< ",\"dur\":" << (event.end - event.start) / 1000.0
+					<< ",\"args\":{\"depth\":" << event.depth << "}}";
+			}
+		}
+		stream << "\n]}\n";
+	}
+
+	bool Profiler::SaveChromeTrace(const ProfileCapture& capture, const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+		WriteChromeTrace(capture, file);
+		return static_cast<bool>(file);
+	}
+
+	ThreadProfile& Profiler::RegisterThread()
+	{
+		ThreadRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		// Touching the owner constructs it, which ties the ring's lifetime to this thread
+		tThreadProfileOwner.registered = true;
+		const std::uint32_t threadId = registry.nextThreadId++;
+		if (registry.retired.empty())
+		{
+			registry.profiles.push_back(std::make_unique<ThreadProfile>(threadId));
+			return *registry.profiles.back();
+		}
+
+		// Captures read under the lock, so the old thread's events can be cleared while holding it
+		ThreadProfile& profile = *registry.retired.back();
+		registry.retired.pop_back();
+		profile.mHead.store(0, std::memory_order_relaxed);
+		profile.mThreadId = threadId;
+		profile.mDepth = 0;
+		profile.mName.clear();
+		return profile;
+	}
+
+	void Profiler::RetireThread()
+	{
+		ThreadRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.retired.push_back(mThreadProfile);
+		// Zones recorded after this, from later thread local destructors, must not write into a ring another thread took
+		mThreadProfile = nullptr;
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Minimal.h"
+#include <atomic>
+#include <chrono>
+
+namespace renderer
+{
+	/** A finished zone. Times are steady clock nanoseconds */
+	struct ProfileEvent
+	{
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t end;
+		// Number of zones the event was nested in on its thread
+		std::uint32_t depth;
+	};
+
+	/** Events of one thread copied out of its ring buffer */
+	struct ThreadCapture
+	{
+		std::uint32_t threadId;
+		std::string threadName;
+		// Ordered by end time
+		std::vector<ProfileEvent> events;
+	};
+
+	struct ProfileCapture
+	{
+		std::vector<ThreadCapture> threads;
+	};
+
+	/**
+	 * Zones recorded by one thread. Only the owning thread writes, so pushing is a few plain stores and publishing
+	 * the new head. The oldest events are overwritten once the buffer is full.
+	 * The ring outlives its thread. It is retired when the thread exits and handed to the next thread that registers.
+	 */
+	class ThreadProfile
+	{
+	public:
+		static constexpr std::uint32_t Capacity = 1u << 15;
+
+		ThreadProfile(std::uint32_t threadId);
+		void Push(const ProfileEvent& event)
+		{
+			// Orders the head published by the previous push before the writes below, so a reader that sees any of
+			// them also sees that head and knows the slot is being overwritten
+			std::atomic_thread_fence(std::memory_order_release);
+			std::uint64_t head = mHead.load(std::memory_order_relaxed);
+			EventSlot& slot = mEvents[head & (Capacity - 1)];
+			slot.name.store(event.name, std::memory_order_relaxed);
+			slot.start.store(event.start, std::memory_order_relaxed);
+			slot.end.store(event.end, std::memory_order_relaxed);
+			slot.depth.store(event.depth, std::memory_order_relaxed);
+			mHead.store(head + 1, std::memory_order_release);
+		}
+		/** Copies the completed events that are not being overwritten. Safe to call from any thread */
+		void Read(ThreadCapture& capture) const;
+
+	private:
+		friend class Profiler;
+		friend class ProfileZone;
+
+		// Fields are atomic so a reader copying a slot the owner is overwriting gets a value it then drops, rather
+		// than a data race. Relaxed accesses compile to plain moves
+		struct EventSlot
+		{
+			std::atomic<const char*> name;
+			std::atomic<std::uint64_t> start;
+			std::atomic<std::uint64_t> end;
+			std::atomic<std::uint32_t> depth;
+		};
+
+		std::unique_ptr<EventSlot[]> mEvents;
+		std::atomic<std::uint64_t> mHead;
+		std::uint32_t mThreadId;
+		std::uint32_t mDepth;
+		std::string mName;
+	};
+
+	/** Collects the zones of every thread and exports them for chrome://tracing or Perfetto */
+	class Profiler
+	{
+	public:
+		static std::uint64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		/** Profile of the calling thread, created the first time a thread records a zone */
+		static ThreadProfile& GetThreadProfile()
+		{
+			if (!mThreadProfile)
+			{
+				mThreadProfile = &RegisterThread();
+			}
+			return *mThreadProfile;
+		}
+
+		/** Names the calling thread in exported traces */
+		static void SetThreadName(const std::string& name);
+		/**
+		 * Copies the recent events of every thread that has recorded a zone, including threads that have exited until
+		 * their ring is reused
+		 */
+		static ProfileCapture Capture();
+		/** Writes the capture as Chrome trace event JSON */
+		static void WriteChromeTrace(const ProfileCapture& capture, std::ostream& stream);
+		static bool SaveChromeTrace(const ProfileCapture& capture, const std::string& path);
+
+	private:
+		friend struct ThreadProfileOwner;
+
+		static ThreadProfile& RegisterThread();
+		/** Hands the calling thread's ring back for reuse. Called as the thread exits */
+		static void RetireThread();
+
+		static thread_local ThreadProfile* mThreadProfile;
+	};
+
+	/** Records the time between its construction and destruction as a zone on the calling thread */
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name)
+			: mProfile(Profiler::GetThreadProfile()), mName(name), mDepth(mProfile.mDepth++), mStart(Profiler::Now())
+		{
+
+		}
+
+		~ProfileZone()
+		{
+			mProfile.Push({ mName, mStart, Profiler::Now(), mDepth });
+			--mProfile.mDepth;
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		ThreadProfile& mProfile;
+		const char* mName;
+		std::uint32_t mDepth;
+		std::uint64_t mStart;
+	};
+}
+
+// Zones compile to nothing unless the build enables profiling
+#if RENDERER_PROFILING_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+/** Profiles the rest of the enclosing scope. The name must outlive the profiler, such as a string literal */
+#define PROFILE_ZONE(name) ::renderer::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#endif
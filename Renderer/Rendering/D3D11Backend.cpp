@@ -0,0 +1,741 @@
+#include "D3D11Backend.h"
+
+namespace renderer
+{
+	D3D11Backend* D3D11Backend::Create(HWND windowHandle, const GraphicsConfig& config)
+	{
+		D3D11Backend* backend = new D3D11Backend(windowHandle, config);
+		if (!backend->InitializeD3D())
+		{
+			SAFE_DELETE(backend);
+			return nullptr;
+		}
+		backend->CreateBlendStates();
+		backend->CreateRenderStates();
+		backend->CreateDepthStencilStates();
+		return backend;
+	}
+
+	D3D11Backend::D3D11Backend(HWND windowHandle, const GraphicsConfig& config)
+		: mWindowHandle(windowHandle), mConfig(config), mDepthStencilView(nullptr), mRenderTargetView(nullptr), mSwapChain(nullptr),
+		mDevice(nullptr), mDeviceContext(nullptr), mDepthStencilBuffer(nullptr), mResolveTexture(nullptr), mReadbackOrder(0)
+	{
+
+	}
+
+	D3D11Backend::~D3D11Backend()
+	{
+		if (mSwapChain)
+		{
+			mSwapChain->SetFullscreenState(false, NULL);
+		}
+
+		SAFE_RELEASE(mStates.alphaBlend);
+		SAFE_RELEASE(mStates.colourBlend);
+		SAFE_RELEASE(mStates.cwCull);
+		SAFE_RELEASE(mStates.ccwCull);
+		SAFE_RELEASE(mStates.noCull);
+		SAFE_RELEASE(mStates.wireframe);
+		SAFE_RELEASE(mStates.fullDepth);
+		for (ReadbackTexture& readback : mReadbacks)
+		{
+			SAFE_RELEASE(readback.texture);
+		}
+		SAFE_RELEASE(mResolveTexture);
+
+		SAFE_RELEASE(mDepthStencilView);
+		SAFE_RELEASE(mDepthStencilBuffer);
+		SAFE_RELEASE(mRenderTargetView);
+		SAFE_RELEASE(mDeviceContext);
+		SAFE_RELEASE(mSwapChain);
+		SAFE_RELEASE(mDevice);
+	}
+
+	bool D3D11Backend::InitializeD3D()
+	{
+		ID3D11Device* tempDevice = nullptr;
+		ID3D11DeviceContext* tempDevCon = nullptr;
+
+		D3D_FEATURE_LEVEL dxFeatureLevel = D3D_FEATURE_LEVEL_11_1;
+
+		HRESULT hr;
+
+		//Create the Direct3D 11 Device and SwapChain
+		if (FAILED(hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, D3D11_CREATE_DEVICE_DEBUG, NULL, NULL, D3D11_SDK_VERSION, &tempDevice, &dxFeatureLevel, &tempDevCon)))
+		{
+			MessageBox(NULL, L"D3D11CreateDevice() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+		if (FAILED(hr = tempDevice->QueryInterface(__uuidof(ID3D11Device1), reinterpret_cast<void**>(&mDevice))))
+		{
+			SAFE_RELEASE(tempDevice);
+			SAFE_RELEASE(tempDevCon);
+			MessageBox(NULL, L"ID3D11Device::QueryInterface() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+
+		if (FAILED(hr = tempDevCon->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&mDeviceContext))))
+		{
+			SAFE_RELEASE(tempDevice);
+			SAFE_RELEASE(tempDevCon);
+			MessageBox(NULL, L"ID3D11DeviceContect::QueryInterface() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+
+		SAFE_RELEASE(tempDevice);
+		SAFE_RELEASE(tempDevCon);
+
+		IDXGIDevice* dxgiDevice = nullptr;
+		if (FAILED(hr = mDevice->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&dxgiDevice))))
+		{
+			MessageBox(NULL, L"ID3D11Device::QueryInterface() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+
+		IDXGIAdapter* dxgiAdapter = nullptr;
+		if (FAILED(hr = dxgiDevice->GetParent(__uuidof(IDXGIAdapter), reinterpret_cast<void**>(&dxgiAdapter))))
+		{
+			SAFE_RELEASE(dxgiDevice);
+			MessageBox(NULL, L"IDXGIDevice::GetParent() failed retrieving adapter.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+
+		}
+
+		IDXGIFactory2* dxgiFactory = nullptr;
+		if (FAILED(hr = dxgiAdapter->GetParent(__uuidof(IDXGIFactory2), reinterpret_cast<void**>(&dxgiFactory))))
+		{
+			SAFE_RELEASE(dxgiDevice);
+			SAFE_RELEASE(dxgiAdapter);
+			MessageBox(NULL, L"IDXGIAdapter::GetParent() failed retrieving factory.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+
+		//Create swapchain description
+		DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
+		ZeroMemory(&swapChainDesc, sizeof(DXGI_SWAP_CHAIN_DESC1));
+		swapChainDesc.Width = mConfig.screenWidth;
+		swapChainDesc.Height = mConfig.screenHeight;
+		swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+		swapChainDesc.BufferCount = 1;
+		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+
+		//Multisampling quality level
+		UINT qualityLevel;
+		if (mConfig.multiSamplingenabled)
+		{
+			mDevice->CheckMultisampleQualityLevels(DXGI_FORMAT_R8G8B8A8_UNORM, mConfig.multiSamplingCount, &qualityLevel);
+			if (qualityLevel == 0)
+			{
+				SAFE_RELEASE(dxgiDevice);
+				SAFE_RELEASE(dxgiAdapter);
+				SAFE_RELEASE(dxgiFactory);
+
+				MessageBox(NULL, L"Unsupported multisampling quality level.",
+					L"Error", MB_OK | MB_ICONERROR);
+				return false;
+			}
+			swapChainDesc.SampleDesc.Count = mConfig.multiSamplingCount;
+			swapChainDesc.SampleDesc.Quality = qualityLevel - 1;
+		}
+		else
+		{
+			swapChainDesc.SampleDesc.Count = 1;
+			swapChainDesc.SampleDesc.Quality = 0;
+		}
+
+		DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullScreenDesc;
+		ZeroMemory(&fullScreenDesc, sizeof(fullScreenDesc));
+		fullScreenDesc.RefreshRate.Denominator = 1;
+		fullScreenDesc.RefreshRate.Numerator = mConfig.refreshRate;
+		fullScreenDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+		fullScreenDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+		fullScreenDesc.Windowed = mConfig.windowed;
+
+		if (FAILED(hr = dxgiFactory->CreateSwapChainForHwnd(dxgiDevice, mWindowHandle, &swapChainDesc, &fullScreenDesc, NULL, &mSwapChain)))
+		{
+			SAFE_RELEASE(dxgiDevice);
+			SAFE_RELEASE(dxgiAdapter);
+			SAFE_RELEASE(dxgiFactory);
+			MessageBox(NULL, L"IDXGIDevice::CreateSwapChainForHwnd() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return false;
+		}
+
+		// Release temporary resources
+		SAFE_RELEASE(dxgiDevice);
+		SAFE_RELEASE(dxgiAdapter);
+		SAFE_RELEASE(dxgiFactory);
+
+		ID3D11Texture2D* backBuffer;
+		//Create back buffer and render target
+		hr = mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
+		hr = mDevice->CreateRenderTargetView(backBuffer, NULL, &mRenderTargetView);
+
+		SAFE_RELEASE(backBuffer);
+
+		//Describe the Depth/Stencil Buffer
+		D3D11_TEXTURE2D_DESC depthStencilDesc;
+
+		depthStencilDesc.Width = mConfig.screenWidth;
+		depthStencilDesc.Height = mConfig.screenHeight;
+		depthStencilDesc.MipLevels = 1;
+		depthStencilDesc.ArraySize = 1;
+		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; //24 bits for the depth and 8 bits for the stencil.
+		depthStencilDesc.SampleDesc.Count = swapChainDesc.SampleDesc.Count;
+		depthStencilDesc.SampleDesc.Quality = swapChainDesc.SampleDesc.Quality;
+		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		depthStencilDesc.CPUAccessFlags = 0;
+		depthStencilDesc.MiscFlags = 0;
+		mDevice->CreateTexture2D(&depthStencilDesc, NULL, &mDepthStencilBuffer);
+
+		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
+		ZeroMemory(&depthStencilViewDesc, sizeof(D3D11_DEPTH_STENCIL_VIEW_DESC));
+		depthStencilViewDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DMS;
+		depthStencilViewDesc.Texture2D.MipSlice = 0;
+
+		mDevice->CreateDepthStencilView(mDepthStencilBuffer, &depthStencilViewDesc, &mDepthStencilView);
+		return true;
+	}
+
+	void D3D11Backend::CreateBlendStates()
+	{
+		D3D11_BLEND_DESC blendDesc;
+
+		//Alpha blend state
+		ZeroMemory(&blendDesc, sizeof(blendDesc));
+		blendDesc.AlphaToCoverageEnable = true;
+		blendDesc.IndependentBlendEnable = false;
+		blendDesc.RenderTarget[0].BlendEnable = true;
+		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+		blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+		blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D10_COLOR_WRITE_ENABLE_ALL;
+		mDevice->CreateBlendState(&blendDesc, &mStates.alphaBlend);
+
+		//Colour blend state
+		ZeroMemory(&blendDesc, sizeof(blendDesc));
+		blendDesc.AlphaToCoverageEnable = true;
+		blendDesc.IndependentBlendEnable = false;
+		blendDesc.RenderTarget[0].BlendEnable = true;
+		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_COLOR;
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_BLEND_FACTOR;
+		blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+		blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D10_COLOR_WRITE_ENABLE_ALL;
+		mDevice->CreateBlendState(&blendDesc, &mStates.colourBlend);
+	}
+
+	void D3D11Backend::CreateRenderStates()
+	{
+		D3D11_RASTERIZER_DESC rastDesc;
+
+		//Clock-wise culling
+		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
+		rastDesc.FillMode = D3D11_FILL_SOLID;
+		rastDesc.CullMode = D3D11_CULL_BACK;
+		rastDesc.FrontCounterClockwise = FALSE;
+		rastDesc.DepthBias = 0;
+		rastDesc.DepthBiasClamp = 0.0f;
+		rastDesc.SlopeScaledDepthBias = 0.0f;
+		rastDesc.DepthClipEnable = TRUE;
+		rastDesc.ScissorEnable = FALSE;
+		rastDesc.MultisampleEnable = TRUE;
+		rastDesc.AntialiasedLineEnable = TRUE;
+		mDevice->CreateRasterizerState(&rastDesc, &mStates.cwCull);
+
+		//Counter-clockwise culling
+		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
+		rastDesc.FillMode = D3D11_FILL_SOLID;
+		rastDesc.CullMode = D3D11_CULL_BACK;
+		rastDesc.FrontCounterClockwise = TRUE;
+		rastDesc.DepthBias = 0;
+		rastDesc.DepthBiasClamp = 0.0f;
+		rastDesc.SlopeScaledDepthBias = 0.0f;
+		rastDesc.DepthClipEnable = TRUE;
+		rastDesc.ScissorEnable = FALSE;
+		rastDesc.MultisampleEnable = TRUE;
+		rastDesc.AntialiasedLineEnable = TRUE;
+		mDevice->CreateRasterizerState(&rastDesc, &mStates.ccwCull);
+
+		//No culling
+		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
+		rastDesc.FillMode = D3D11_FILL_SOLID;
+		rastDesc.CullMode = D3D11_CULL_NONE;
+		rastDesc.FrontCounterClockwise = FALSE;
+		rastDesc.DepthBias = 0;
+		rastDesc.DepthBiasClamp = 0.0f;
+		rastDesc.SlopeScaledDepthBias = 0.0f;
+		rastDesc.DepthClipEnable = TRUE;
+		rastDesc.ScissorEnable = FALSE;
+		rastDesc.MultisampleEnable = TRUE;
+		rastDesc.AntialiasedLineEnable = TRUE;
+		mDevice->CreateRasterizerState(&rastDesc, &mStates.noCull);
+
+		//Wireframe
+		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
+		rastDesc.FillMode = D3D11_FILL_WIREFRAME;
+		rastDesc.CullMode = D3D11_CULL_NONE;
+		rastDesc.FrontCounterClockwise = FALSE;
+		rastDesc.DepthBias = 0;
+		rastDesc.DepthBiasClamp = 0.0f;
+		rastDesc.SlopeScaledDepthBias = 0.0f;
+		rastDesc.DepthClipEnable = TRUE;
+		rastDesc.ScissorEnable = FALSE;
+		rastDesc.MultisampleEnable = TRUE;
+		rastDesc.AntialiasedLineEnable = TRUE;
+		mDevice->CreateRasterizerState(&rastDesc, &mStates.wireframe);
+	}
+
+	void D3D11Backend::CreateDepthStencilStates()
+	{
+		D3D11_DEPTH_STENCIL_DESC dssDesc;
+
+		//Create depth stencil state used for sky.
+		ZeroMemory(&dssDesc, sizeof(D3D11_DEPTH_STENCIL_DESC));
+		dssDesc.DepthEnable = true;
+		dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+		dssDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+		dssDesc.StencilEnable = FALSE;
+		dssDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+		dssDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+
+		mDevice->CreateDepthStencilState(&dssDesc, &mStates.fullDepth);
+	}
+
+	void D3D11Backend::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		mDeviceContext->VSSetShader(shader, 0, 0);
+	}
+
+	void D3D11Backend::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		mDeviceContext->PSSetShader(shader, 0, 0);
+	}
+
+	void D3D11Backend::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		mDeviceContext->IASetInputLayout(layout);
+	}
+
+	void D3D11Backend::SetPrimitiveTopology(std::uint32_t topology)
+	{
+		mDeviceContext->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology));
+	}
+
+	void D3D11Backend::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		mDeviceContext->RSSetState(state);
+	}
+
+	void D3D11Backend::SetBlendState(ID3D11BlendState* state, const float blendFactor[4], std::uint32_t sampleMask)
+	{
+		mDeviceContext->OMSetBlendState(state, blendFactor, sampleMask);
+	}
+
+	void D3D11Backend::SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef)
+	{
+		mDeviceContext->OMSetDepthStencilState(state, stencilRef);
+	}
+
+	void D3D11Backend::SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil)
+	{
+		mDeviceContext->OMSetRenderTargets(count, renderTargets, depthStencil);
+	}
+
+	void D3D11Backend::SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets)
+	{
+		mDeviceContext->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+	}
+
+	void D3D11Backend::SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset)
+	{
+		mDeviceContext->IASetIndexBuffer(buffer, static_cast<DXGI_FORMAT>(format), offset);
+	}
+
+	void D3D11Backend::SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		mDeviceContext->VSSetConstantBuffers(startSlot, count, buffers);
+	}
+
+	void D3D11Backend::SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		mDeviceContext->PSSetConstantBuffers(startSlot, count, buffers);
+	}
+
+	void D3D11Backend::SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources)
+	{
+		mDeviceContext->PSSetShaderResources(startSlot, count, resources);
+	}
+
+	ID3D11Buffer* D3D11Backend::CreateBuffer(const BufferDesc& desc, const void* data)
+	{
+		D3D11_BUFFER_DESC bufferDesc;
+		ZeroMemory(&bufferDesc, sizeof(D3D11_BUFFER_DESC));
+		bufferDesc.ByteWidth = desc.size;
+		switch (desc.binding)
+		{
+		case BufferBinding::Vertex:
+			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			break;
+		case BufferBinding::Index:
+			bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+			break;
+		case BufferBinding::Constant:
+			bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			break;
+		case BufferBinding::Structured:
+			bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+			bufferDesc.StructureByteStride = desc.stride;
+			break;
+		}
+		if (desc.usage == BufferUsage::Dynamic)
+		{
+			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		}
+		else
+		{
+			bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		}
+
+		D3D11_SUBRESOURCE_DATA initialData;
+		initialData.pSysMem = data;
+		initialData.SysMemPitch = 0;
+		initialData.SysMemSlicePitch = 0;
+
+		ID3D11Buffer* newBuffer = nullptr;
+		if (FAILED(mDevice->CreateBuffer(&bufferDesc, data ? &initialData : NULL, &newBuffer)))
+		{
+			MessageBox(NULL, L"ID3D11Device::CreateBuffer() failed.",
+				L"Error", MB_OK | MB_ICONERROR);
+			return nullptr;
+		}
+		return newBuffer;
+	}
+
+	void D3D11Backend::ReleaseBuffer(ID3D11Buffer* buffer)
+	{
+		SAFE_RELEASE(buffer);
+	}
+
+	std::uint32_t D3D11Backend::GetBufferSize(ID3D11Buffer* buffer) const
+	{
+		D3D11_BUFFER_DESC desc;
+		buffer->GetDesc(&desc);
+		return desc.ByteWidth;
+	}
+
+	void D3D11Backend::UpdateBuffer(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t size)
+	{
+		D3D11_BUFFER_DESC desc;
+		buffer->GetDesc(&desc);
+		if (desc.Usage == D3D11_USAGE_DYNAMIC)
+		{
+			D3D11_MAPPED_SUBRESOURCE mappedBuff;
+			if (FAILED(mDeviceContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuff)))
+			{
+				return;
+			}
+			// Copy the data into the buffer.
+			memcpy(mappedBuff.pData, data, size);
+			mDeviceContext->Unmap(buffer, 0);
+		}
+		else
+		{
+			D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+			mDeviceContext->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+		}
+	}
+
+	void D3D11Backend::CopyBuffer(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size)
+	{
+		D3D11_BOX box = { sourceOffset, 0, 0, sourceOffset + size, 1, 1 };
+		mDeviceContext->CopySubresourceRegion(dest, 0, destOffset, 0, 0, source, 0, &box);
+	}
+
+	ID3D11ShaderResourceView* D3D11Backend::CreateBufferView(ID3D11Buffer* buffer, std::uint32_t elementCount)
+	{
+		D3D11_BUFFER_SRV srvBuffer;
+		srvBuffer.FirstElement = 0;
+		srvBuffer.NumElements = elementCount;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		ZeroMemory(&srvDesc, sizeof(D3D11_SHADER_RESOURCE_VIEW_DESC));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer = srvBuffer;
+
+		ID3D11ShaderResourceView* view = nullptr;
+		mDevice->CreateShaderResourceView(buffer, &srvDesc, &view);
+		return view;
+	}
+
+	void D3D11Backend::ReleaseBufferView(ID3D11ShaderResourceView* view)
+	{
+		SAFE_RELEASE(view);
+	}
+
+	bool D3D11Backend::CreateShaders(const wchar_t* vertexPath, const wchar_t* pixelPath, const VertexElement* layout, std::uint32_t layoutCount, ShaderProgram& program)
+	{
+		std::vector<D3D11_INPUT_ELEMENT_DESC> vertexLayout(layoutCount);
+		for (std::uint32_t i = 0; i < layoutCount; ++i)
+		{
+			const VertexElement& element = layout[i];
+			vertexLayout[i].SemanticName = element.semantic;
+			vertexLayout[i].SemanticIndex = element.semanticIndex;
+			vertexLayout[i].Format = element.format == VertexFormat::Float4 ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R32G32B32_FLOAT;
+			vertexLayout[i].InputSlot = element.slot;
+			vertexLayout[i].AlignedByteOffset = element.offset;
+			vertexLayout[i].InputSlotClass = element.perInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+			vertexLayout[i].InstanceDataStepRate = element.perInstance ? 1 : 0;
+		}
+
+		// Vertex shader
+		{
+			ID3D10Blob* shaderBuffer = nullptr;
+			ID3D10Blob* errors = nullptr;
+			HRESULT hr = D3DCompileFromFile(vertexPath, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "vs_5_0", 0, 0, &shaderBuffer, &errors);
+			SAFE_RELEASE(errors);
+			if (FAILED(hr))
+			{
+				MessageBox(NULL, L"D3DCompileFromFile failed for the vertex shader.",
+					L"Error", MB_OK | MB_ICONERROR);
+				SAFE_RELEASE(shaderBuffer);
+				return false;
+			}
+			hr = mDevice->CreateVertexShader(shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), nullptr, &program.vertexShader);
+			if (SUCCEEDED(hr))
+			{
+				hr = mDevice->CreateInputLayout(vertexLayout.data(), layoutCount, shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), &program.inputLayout);
+			}
+			// The driver keeps its own copy of the bytecode for as long as the shader lives
+			program.bytecodeBytes = shaderBuffer->GetBufferSize();
+			SAFE_RELEASE(shaderBuffer);
+			if (FAILED(hr))
+			{
+				MessageBox(NULL, L"CreateInputLayout failed for the vertex shader.",
+					L"Error", MB_OK | MB_ICONERROR);
+				ReleaseShaders(program);
+				return false;
+			}
+		}
+
+		// Pixel shader
+		{
+			ID3D10Blob* shaderBuffer = nullptr;
+			ID3D10Blob* errors = nullptr;
+			HRESULT hr = D3DCompileFromFile(pixelPath, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "ps_5_0", 0, 0, &shaderBuffer, &errors);
+			SAFE_RELEASE(errors);
+			if (FAILED(hr))
+			{
+				MessageBox(NULL, L"D3DCompileFromFile failed for the pixel shader.",
+					L"Error", MB_OK | MB_ICONERROR);
+				SAFE_RELEASE(shaderBuffer);
+				ReleaseShaders(program);
+				return false;
+			}
+			hr = mDevice->CreatePixelShader(shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), nullptr, &program.pixelShader);
+			program.bytecodeBytes += shaderBuffer->GetBufferSize();
+			SAFE_RELEASE(shaderBuffer);
+			if (FAILED(hr))
+			{
+				ReleaseShaders(program);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void D3D11Backend::ReleaseShaders(ShaderProgram& program)
+	{
+		SAFE_RELEASE(program.vertexShader);
+		SAFE_RELEASE(program.inputLayout);
+		SAFE_RELEASE(program.pixelShader);
+		program.bytecodeBytes = 0;
+	}
+
+	const FixedFunctionStates& D3D11Backend::GetFixedFunctionStates() const
+	{
+		return mStates;
+	}
+
+	ID3D11RenderTargetView* D3D11Backend::GetBackBuffer() const
+	{
+		return mRenderTargetView;
+	}
+
+	ID3D11DepthStencilView* D3D11Backend::GetDepthStencil() const
+	{
+		return mDepthStencilView;
+	}
+
+	void D3D11Backend::SetViewport(const ViewportRect& viewport)
+	{
+		D3D11_VIEWPORT d3dViewport;
+		d3dViewport.TopLeftX = viewport.x;
+		d3dViewport.TopLeftY = viewport.y;
+		d3dViewport.Width = viewport.width;
+		d3dViewport.Height = viewport.height;
+		d3dViewport.MinDepth = 0.0f;
+		d3dViewport.MaxDepth = 1.0f;
+		mDeviceContext->RSSetViewports(1, &d3dViewport);
+	}
+
+	void D3D11Backend::ClearRenderTarget(ID3D11RenderTargetView* target, const float colour[4])
+	{
+		mDeviceContext->ClearRenderTargetView(target, colour);
+	}
+
+	void D3D11Backend::ClearDepthStencil(ID3D11DepthStencilView* target, float depth, std::uint8_t stencil)
+	{
+		mDeviceContext->ClearDepthStencilView(target, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depth, stencil);
+	}
+
+	void D3D11Backend::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance)
+	{
+		mDeviceContext->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+	}
+
+	void D3D11Backend::Present()
+	{
+		CopyBackBufferForReadback();
+		mSwapChain->Present(0, 0);
+	}
+
+	bool D3D11Backend::RequestBackBufferReadback(std::uint64_t id)
+	{
+		ReadbackTexture* free = nullptr;
+		for (ReadbackTexture& readback : mReadbacks)
+		{
+			// One copy per frame
+			if (readback.state == ReadbackState::Requested)
+			{
+				return false;
+			}
+			free = !free && readback.state == ReadbackState::Free ? &readback : free;
+		}
+		if (!free)
+		{
+			return false;
+		}
+
+		if (!free->texture)
+		{
+			ID3D11Texture2D* backBuffer = nullptr;
+			if (FAILED(mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer)))
+			{
+				return false;
+			}
+			backBuffer->GetDesc(&mBackBufferDesc);
+			SAFE_RELEASE(backBuffer);
+
+			D3D11_TEXTURE2D_DESC desc = mBackBufferDesc;
+			desc.MipLevels = 1;
+			desc.ArraySize = 1;
+			desc.SampleDesc.Count = 1;
+			desc.SampleDesc.Quality = 0;
+			desc.BindFlags = 0;
+			desc.MiscFlags = 0;
+			const std::uint64_t bytes = static_cast<std::uint64_t>(desc.Width) * desc.Height * 4;
+			if (mBackBufferDesc.SampleDesc.Count > 1 && !mResolveTexture)
+			{
+				desc.Usage = D3D11_USAGE_DEFAULT;
+				desc.CPUAccessFlags = 0;
+				if (FAILED(mDevice->CreateTexture2D(&desc, nullptr, &mResolveTexture)))
+				{
+					return false;
+				}
+				mReadbackMemory.Set(mReadbackMemory.Get() + bytes);
+			}
+			desc.Usage = D3D11_USAGE_STAGING;
+			desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+			if (FAILED(mDevice->CreateTexture2D(&desc, nullptr, &free->texture)))
+			{
+				return false;
+			}
+			mReadbackMemory.Set(mReadbackMemory.Get() + bytes);
+		}
+		free->state = ReadbackState::Requested;
+		free->id = id;
+		return true;
+	}
+
+	bool D3D11Backend::MapReadback(BackBufferReadback& readback)
+	{
+		std::uint32_t oldest = ReadbackTextureCount;
+		for (std::uint32_t i = 0; i < ReadbackTextureCount; ++i)
+		{
+			if (mReadbacks[i].state == ReadbackState::Copied && (oldest == ReadbackTextureCount || mReadbacks[i].order < mReadbacks[oldest].order))
+			{
+				oldest = i;
+			}
+		}
+		if (oldest == ReadbackTextureCount)
+		{
+			return false;
+		}
+
+		// Fails with DXGI_ERROR_WAS_STILL_DRAWING until the GPU has got through the copy
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		if (FAILED(mDeviceContext->Map(mReadbacks[oldest].texture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped)))
+		{
+			return false;
+		}
+		mReadbacks[oldest].state = ReadbackState::Mapped;
+		readback.id = mReadbacks[oldest].id;
+		readback.pixels = static_cast<const std::uint8_t*>(mapped.pData);
+		readback.width = mBackBufferDesc.Width;
+		readback.height = mBackBufferDesc.Height;
+		readback.rowPitch = mapped.RowPitch;
+		readback.texture = oldest;
+		return true;
+	}
+
+	void D3D11Backend::UnmapReadback(const BackBufferReadback& readback)
+	{
+		ReadbackTexture& texture = mReadbacks[readback.texture];
+		mDeviceContext->Unmap(texture.texture, 0);
+		texture.state = ReadbackState::Free;
+	}
+
+	void D3D11Backend::CopyBackBufferForReadback()
+	{
+		for (ReadbackTexture& readback : mReadbacks)
+		{
+			if (readback.state != ReadbackState::Requested)
+			{
+				continue;
+			}
+			// The back buffer is discarded by the present, so it is copied before
+			ID3D11Texture2D* backBuffer = nullptr;
+			mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
+			if (mResolveTexture)
+			{
+				mDeviceContext->ResolveSubresource(mResolveTexture, 0, backBuffer, 0, mBackBufferDesc.Format);
+				mDeviceContext->CopyResource(readback.texture, mResolveTexture);
+			}
+			else
+			{
+				mDeviceContext->CopyResource(readback.texture, backBuffer);
+			}
+			SAFE_RELEASE(backBuffer);
+			readback.state = ReadbackState::Copied;
+			readback.order = mReadbackOrder++;
+		}
+	}
+}
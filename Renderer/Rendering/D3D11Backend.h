@@ -0,0 +1,102 @@
+#pragma once
+
+#include "GraphicsBackend.h"
+#include "D3DIncludes.h"
+#include "Memory/MemoryTracker.h"
+#include <array>
+
+namespace renderer
+{
+	/** Owns the Direct3D 11 device and swap chain of a window and forwards the renderer's calls to them */
+	class D3D11Backend : public GraphicsBackend
+	{
+	public:
+		/** Creates the device and a swap chain for the window. Returns null if Direct3D 11 could not be initialized */
+		static D3D11Backend* Create(HWND windowHandle, const GraphicsConfig& config);
+		~D3D11Backend() override;
+
+		void SetVertexShader(ID3D11VertexShader* shader) override;
+		void SetPixelShader(ID3D11PixelShader* shader) override;
+		void SetInputLayout(ID3D11InputLayout* layout) override;
+		void SetPrimitiveTopology(std::uint32_t topology) override;
+		void SetRasterizerState(ID3D11RasterizerState* state) override;
+		void SetBlendState(ID3D11BlendState* state, const float blendFactor[4], std::uint32_t sampleMask) override;
+		void SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef) override;
+		void SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil) override;
+		void SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets) override;
+		void SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset) override;
+		void SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) override;
+		void SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) override;
+		void SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources) override;
+
+		ID3D11Buffer* CreateBuffer(const BufferDesc& desc, const void* data) override;
+		void ReleaseBuffer(ID3D11Buffer* buffer) override;
+		std::uint32_t GetBufferSize(ID3D11Buffer* buffer) const override;
+		void UpdateBuffer(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t size) override;
+		void CopyBuffer(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size) override;
+		ID3D11ShaderResourceView* CreateBufferView(ID3D11Buffer* buffer, std::uint32_t elementCount) override;
+		void ReleaseBufferView(ID3D11ShaderResourceView* view) override;
+		bool CreateShaders(const wchar_t* vertexPath, const wchar_t* pixelPath, const VertexElement* layout, std::uint32_t layoutCount, ShaderProgram& program) override;
+		void ReleaseShaders(ShaderProgram& program) override;
+		const FixedFunctionStates& GetFixedFunctionStates() const override;
+
+		ID3D11RenderTargetView* GetBackBuffer() const override;
+		ID3D11DepthStencilView* GetDepthStencil() const override;
+		void SetViewport(const ViewportRect& viewport) override;
+		void ClearRenderTarget(ID3D11RenderTargetView* target, const float colour[4]) override;
+		void ClearDepthStencil(ID3D11DepthStencilView* target, float depth, std::uint8_t stencil) override;
+		void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance) override;
+		void Present() override;
+
+		bool RequestBackBufferReadback(std::uint64_t id) override;
+		bool MapReadback(BackBufferReadback& readback) override;
+		void UnmapReadback(const BackBufferReadback& readback) override;
+
+	private:
+		D3D11Backend(HWND windowHandle, const GraphicsConfig& config);
+		bool InitializeD3D();
+		void CreateBlendStates();
+		void CreateRenderStates();
+		void CreateDepthStencilStates();
+		void CopyBackBufferForReadback();
+
+		// Handle to the window and config passed by the application
+		HWND mWindowHandle;
+		GraphicsConfig mConfig;
+
+		// Core graphics resources
+		ID3D11DepthStencilView* mDepthStencilView;
+		ID3D11RenderTargetView* mRenderTargetView;
+		IDXGISwapChain1* mSwapChain;
+		ID3D11Device1* mDevice;
+		ID3D11DeviceContext1* mDeviceContext;
+		ID3D11Texture2D* mDepthStencilBuffer;
+
+		FixedFunctionStates mStates;
+
+		// Frames read back a few at a time so mapping one never waits for the GPU to finish the frame
+		static constexpr std::uint32_t ReadbackTextureCount = 3;
+		enum class ReadbackState
+		{
+			Free,
+			// Copied at the next present
+			Requested,
+			Copied,
+			Mapped
+		};
+		struct ReadbackTexture
+		{
+			ID3D11Texture2D* texture = nullptr;
+			ReadbackState state = ReadbackState::Free;
+			std::uint64_t id = 0;
+			// When it was copied, so frames are mapped in order
+			std::uint64_t order = 0;
+		};
+		std::array<ReadbackTexture, ReadbackTextureCount> mReadbacks;
+		// Single sampled copy of a multisampled back buffer, which staging textures cannot take directly
+		ID3D11Texture2D* mResolveTexture;
+		D3D11_TEXTURE2D_DESC mBackBufferDesc;
+		std::uint64_t mReadbackOrder;
+		TrackedMemory mReadbackMemory = TrackedMemory(MemoryTag::FrameCapture, MemoryDomain::Gpu);
+	};
+}
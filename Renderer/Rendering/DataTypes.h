@@ -7,6 +7,8 @@ using namespace DirectX;
 
 namespace renderer
 {
+	class Camera;
+
 	/** Struct with config used for creating the graphics device */
 	struct GraphicsConfig
 	{
@@ -54,12 +56,17 @@ namespace renderer
 		XMFLOAT3 normal;
 	};
 
-	/** Types of primitives the renderer supports */
-	enum class MeshType
+	/** Index of a mesh in the MeshRegistry. Handles are dense so per mesh data is kept in arrays indexed by them */
+	using MeshHandle = std::uint32_t;
+	constexpr MeshHandle InvalidMesh = ~0u;
+
+	/** Handles of the primitives every registry starts with, in the order scene files store them */
+	struct BuiltinMeshes
 	{
-		Cone,
-		Cube,
-		Sphere
+		static constexpr MeshHandle Cone = 0;
+		static constexpr MeshHandle Cube = 1;
+		static constexpr MeshHandle Sphere = 2;
+		static constexpr MeshHandle Count = 3;
 	};
 
 	/** Phong material used by the renderer */
@@ -75,6 +82,8 @@ namespace renderer
 	public:
 		static constexpr std::uint32_t numVertices = 24;
 		static constexpr std::uint32_t numIndices = 36;
+		// Half the diagonal so the sphere encloses every vertex
+		static constexpr float boundingRadius = 0.8660254f;
 
 		// Vertices for a unit cube
 		static constexpr Vertex vertices[numVertices] =
@@ -118,7 +127,7 @@ namespace renderer
 
 			
 		// Indices in clock-wise order
-		static constexpr DWORD indices[numIndices] = {
+		static constexpr std::uint32_t indices[numIndices] = {
 			// Front Face
 			0, 1, 2,
 			0, 2, 3,
@@ -149,10 +158,29 @@ namespace renderer
 	struct Entity
 	{
 		std::shared_ptr<Material> material;
-		MeshType meshType = MeshType::Cube;
+		// A built-in mesh or one registered with the renderer's MeshRegistry
+		MeshHandle mesh = BuiltinMeshes::Cube;
 		XMFLOAT3 position = { 0, 0, 0 };
 		// Axis and Angle in degrees
 		XMFLOAT4 rotation = { 0, 0, 0, 0 };
 		XMFLOAT3 scale = { 0, 0, 1 };
+		// Static entities are merged into batches when added. Call Renderer::MarkStaticEntityChanged after moving one
+		bool isStatic = false;
+	};
+
+	/** Region of the back buffer a view is drawn into, in pixels */
+	struct ViewportRect
+	{
+		float x = 0;
+		float y = 0;
+		float width = 0;
+		float height = 0;
+	};
+
+	/** A camera and the part of the screen it renders to. The camera is owned by the caller */
+	struct RenderView
+	{
+		const Camera* camera = nullptr;
+		ViewportRect viewport;
 	};
 }
\ No newline at end of file
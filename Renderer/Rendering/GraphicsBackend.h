@@ -0,0 +1,154 @@
+#pragma once
+
+#include "PipelineState.h"
+#include "DataTypes.h"
+
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+
+namespace renderer
+{
+	/** What a buffer is bound as */
+	enum class BufferBinding : std::uint8_t
+	{
+		Vertex,
+		Index,
+		Constant,
+		// Read by shaders through a view
+		Structured
+	};
+
+	/** Default buffers are written in regions and copied on the GPU. Dynamic ones are rewritten whole every time */
+	enum class BufferUsage : std::uint8_t
+	{
+		Default,
+		Dynamic
+	};
+
+	struct BufferDesc
+	{
+		std::uint32_t size = 0;
+		BufferBinding binding = BufferBinding::Vertex;
+		BufferUsage usage = BufferUsage::Default;
+		// Size of one element of a structured buffer
+		std::uint32_t stride = 0;
+	};
+
+	enum class VertexFormat : std::uint8_t
+	{
+		Float3,
+		Float4
+	};
+
+	/** One attribute of the vertex layout, read from the buffer bound at the slot */
+	struct VertexElement
+	{
+		const char* semantic;
+		std::uint32_t semanticIndex;
+		VertexFormat format;
+		std::uint32_t slot;
+		std::uint32_t offset;
+		// Advances once per instance rather than once per vertex
+		bool perInstance;
+	};
+
+	/** A vertex and pixel shader pair with the input layout the vertex shader reads */
+	struct ShaderProgram
+	{
+		ID3D11VertexShader* vertexShader = nullptr;
+		ID3D11InputLayout* inputLayout = nullptr;
+		ID3D11PixelShader* pixelShader = nullptr;
+		// Bytecode the driver keeps for as long as the shaders live
+		std::uint64_t bytecodeBytes = 0;
+	};
+
+	/** Fixed function states the backend makes once, for pipeline states and the GraphicsManager shortcuts */
+	struct FixedFunctionStates
+	{
+		ID3D11RasterizerState* cwCull = nullptr;
+		ID3D11RasterizerState* ccwCull = nullptr;
+		ID3D11RasterizerState* noCull = nullptr;
+		ID3D11RasterizerState* wireframe = nullptr;
+		ID3D11BlendState* alphaBlend = nullptr;
+		ID3D11BlendState* colourBlend = nullptr;
+		ID3D11DepthStencilState* fullDepth = nullptr;
+	};
+
+	/** A frame copied from the back buffer, mapped for reading until it is unmapped */
+	struct BackBufferReadback
+	{
+		std::uint64_t id = 0;
+		const std::uint8_t* pixels = nullptr;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::uint32_t rowPitch = 0;
+		std::uint32_t texture = 0;
+	};
+
+	/**
+	 * Everything the renderer asks of the device. The Direct3D 11 backend forwards it to the device and the
+	 * recording backend keeps it in memory and records the calls, so the renderer runs and can be counted on any
+	 * platform. Binds reach the backend through the state tracker, which drops the redundant ones.
+	 * Resources are referred to by Direct3D pointer types, which other backends use as handles only.
+	 * Enum arguments are the Direct3D values.
+	 */
+	class GraphicsBackend
+	{
+	public:
+		virtual ~GraphicsBackend() = default;
+
+		// Binds
+		virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+		virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+		virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+		virtual void SetPrimitiveTopology(std::uint32_t topology) = 0;
+		virtual void SetRasterizerState(ID3D11RasterizerState* state) = 0;
+		virtual void SetBlendState(ID3D11BlendState* state, const float blendFactor[4], std::uint32_t sampleMask) = 0;
+		virtual void SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef) = 0;
+		virtual void SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil) = 0;
+		virtual void SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets) = 0;
+		virtual void SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset) = 0;
+		virtual void SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) = 0;
+		virtual void SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) = 0;
+		virtual void SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources) = 0;
+
+		// Resources
+		/** Returns null if the buffer could not be created. Data may be null to fill it later */
+		virtual ID3D11Buffer* CreateBuffer(const BufferDesc& desc, const void* data) = 0;
+		virtual void ReleaseBuffer(ID3D11Buffer* buffer) = 0;
+		virtual std::uint32_t GetBufferSize(ID3D11Buffer* buffer) const = 0;
+		/** Copies size bytes to the offset. Dynamic buffers are rewritten from the start, so the offset must be zero */
+		virtual void UpdateBuffer(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t size) = 0;
+		/** Copies size bytes between buffers on the GPU. The buffers must be different */
+		virtual void CopyBuffer(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size) = 0;
+		/** View shaders read a structured buffer of elementCount elements through */
+		virtual ID3D11ShaderResourceView* CreateBufferView(ID3D11Buffer* buffer, std::uint32_t elementCount) = 0;
+		virtual void ReleaseBufferView(ID3D11ShaderResourceView* view) = 0;
+		/** Compiles the HLSL files and creates the shaders. Returns false and leaves nothing created on failure */
+		virtual bool CreateShaders(const wchar_t* vertexPath, const wchar_t* pixelPath, const VertexElement* layout, std::uint32_t layoutCount, ShaderProgram& program) = 0;
+		virtual void ReleaseShaders(ShaderProgram& program) = 0;
+		virtual const FixedFunctionStates& GetFixedFunctionStates() const = 0;
+
+		// Frame
+		virtual ID3D11RenderTargetView* GetBackBuffer() const = 0;
+		virtual ID3D11DepthStencilView* GetDepthStencil() const = 0;
+		virtual void SetViewport(const ViewportRect& viewport) = 0;
+		virtual void ClearRenderTarget(ID3D11RenderTargetView* target, const float colour[4]) = 0;
+		virtual void ClearDepthStencil(ID3D11DepthStencilView* target, float depth, std::uint8_t stencil) = 0;
+		virtual void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance) = 0;
+		/** Shows the back buffer, copying it first for any readback requested */
+		virtual void Present() = 0;
+
+		// Readback
+		/**
+		 * Copies the back buffer to a staging texture when the frame is presented, to be mapped once the GPU has
+		 * done it. Fails if every staging texture still holds a frame that was not mapped and unmapped
+		 */
+		virtual bool RequestBackBufferReadback(std::uint64_t id) = 0;
+		/** Maps the oldest copied frame if the GPU has finished copying it. Never waits for the GPU */
+		virtual bool MapReadback(BackBufferReadback& readback) = 0;
+		virtual void UnmapReadback(const BackBufferReadback& readback) = 0;
+	};
+}
@@ -4,453 +4,214 @@ namespace renderer
 {
 	GraphicsManager* GraphicsManager::mGraphicsManager = nullptr;
 
-	GraphicsManager* GraphicsManager::Initialize(HWND windowHandle, const GraphicsConfig& config)
+	GraphicsManager* GraphicsManager::Initialize(GraphicsBackend* backend)
 	{
 		if (!mGraphicsManager)
 		{
-			mGraphicsManager = new GraphicsManager(windowHandle, config);
+			mGraphicsManager = new GraphicsManager(backend);
 		}
 		return mGraphicsManager;
 	}
 
-	GraphicsManager::GraphicsManager(HWND windowHandle, const GraphicsConfig& config)
-		: mWindowHandle(windowHandle), mConfig(config)
+	GraphicsManager::GraphicsManager(GraphicsBackend* backend)
+		: mBackend(backend)
 	{
-		InitializeD3D();
-		CreateBlendStates();
-		CreateRenderStates();
-		CreateDepthStencilStates();
+		mStateTracker.SetBackend(mBackend);
+		// D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+		SetPrimitiveTopology(4);
 	}
 
 	GraphicsManager::~GraphicsManager()
 	{
-		mSwapChain->SetFullscreenState(false, NULL);
+		mPipelineStates.Clear();
+		mStateTracker.SetBackend(nullptr);
+		SAFE_DELETE(mBackend);
 
-		SAFE_RELEASE(mAlphaBlend);
-		SAFE_RELEASE(mColourBlend);
-		SAFE_RELEASE(mCwCull);
-		SAFE_RELEASE(mCcwCull);
-		SAFE_RELEASE(mNoCull);
-		SAFE_RELEASE(mWireframe);
-		SAFE_RELEASE(mFullDepth);
+		mGraphicsManager = nullptr;
+	}
 
-		SAFE_RELEASE(mDepthStencilView);
-		SAFE_RELEASE(mDepthStencilBuffer);
-		SAFE_RELEASE(mRenderTargetView);
-		SAFE_RELEASE(mDeviceContext);
-		SAFE_RELEASE(mSwapChain);
-		SAFE_RELEASE(mDevice);
+	void GraphicsManager::SetViewport(const ViewportRect& viewport)
+	{
+		mBackend->SetViewport(viewport);
+	}
 
-		mGraphicsManager = nullptr;
+	void GraphicsManager::SetPrimitiveTopology(std::uint32_t topology)
+	{
+		mStateTracker.SetPrimitiveTopology(topology);
 	}
 
-	void GraphicsManager::InitializeD3D()
+	//Cull counterclockwise polygons.
+	void GraphicsManager::EnableClockwiseCulling()
 	{
-		ID3D11Device* tempDevice = nullptr;
-		ID3D11DeviceContext* tempDevCon = nullptr;
+		mStateTracker.SetRasterizerState(mBackend->GetFixedFunctionStates().cwCull);
+	}
 
-		D3D_FEATURE_LEVEL dxFeatureLevel = D3D_FEATURE_LEVEL_11_1;
+	//Cull clockwise polygons.
+	void GraphicsManager::EnableCounterClockwiseCulling()
+	{
+		mStateTracker.SetRasterizerState(mBackend->GetFixedFunctionStates().ccwCull);
+	}
 
-		HRESULT hr;
+	void GraphicsManager::DisableCulling()
+	{
+		mStateTracker.SetRasterizerState(mBackend->GetFixedFunctionStates().noCull);
+	}
 
-		//Create the Direct3D 11 Device and SwapChain
-		if (FAILED(hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, D3D11_CREATE_DEVICE_DEBUG, NULL, NULL, D3D11_SDK_VERSION, &tempDevice, &dxFeatureLevel, &tempDevCon)))
-		{
-			MessageBox(NULL, L"D3D11CreateDevice() failed.",
-				L"Error", MB_OK | MB_ICONERROR);
-			return;
-		}
-		if (FAILED(hr = tempDevice->QueryInterface(__uuidof(ID3D11Device1), reinterpret_cast<void**>(&mDevice))))
-		{
-			SAFE_RELEASE(tempDevice);
-			SAFE_RELEASE(tempDevCon);
-			MessageBox(NULL, L"ID3D11Device::QueryInterface() failed.",
-				L"Error", MB_OK | MB_ICONERROR);
-			return;
-		}
+	void GraphicsManager::EnableWireframeRendering()
+	{
+		mStateTracker.SetRasterizerState(mBackend->GetFixedFunctionStates().wireframe);
+	}
 
-		if (FAILED(hr = tempDevCon->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&mDeviceContext))))
-		{
-			SAFE_RELEASE(tempDevice);
-			SAFE_RELEASE(tempDevCon);
-			MessageBox(NULL, L"ID3D11DeviceContect::QueryInterface() failed.",
-				L"Error", MB_OK | MB_ICONERROR);
-			return;
-		}
+	void GraphicsManager::EnableAplhaBlending()
+	{
+		mStateTracker.SetBlendState(mBackend->GetFixedFunctionStates().alphaBlend, nullptr, 0xffffffff);
+	}
 
-		SAFE_RELEASE(tempDevice);
-		SAFE_RELEASE(tempDevCon);
+	void GraphicsManager::EnableColourBlending(float redFactor, float greenFactor, float blueFactor, float alphaFactor)
+	{
+		float blendFactor[] = { redFactor, greenFactor, blueFactor, alphaFactor };
+		mStateTracker.SetBlendState(mBackend->GetFixedFunctionStates().colourBlend, blendFactor, 0xffffffff);
+	}
 
-		IDXGIDevice* dxgiDevice = nullptr;
-		if (FAILED(hr = mDevice->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&dxgiDevice))))
-		{
-			MessageBox(NULL, L"ID3D11Device::QueryInterface() failed.",
-				L"Error", MB_OK | MB_ICONERROR);
-			return;
-		}
+	void GraphicsManager::DisableBlending()
+	{
+		mStateTracker.SetBlendState(nullptr, nullptr, 0xffffffff);
+	}
 
-		IDXGIAdapter* dxgiAdapter = nullptr;
-		if (FAILED(hr = dxgiDevice->GetParent(__uuidof(IDXGIAdapter), reinterpret_cast<void**>(&dxgiAdapter))))
-		{
-			SAFE_RELEASE(dxgiDevice);
-			MessageBox(NULL, L"IDXGIDevice::GetParent() failed retrieving adapter.",
-				L"Error", MB_OK | MB_ICONERROR);
-			return;
+	void GraphicsManager::EnableFullDepth()
+	{
+		mStateTracker.SetDepthStencilState(mBackend->GetFixedFunctionStates().fullDepth, 0);
+	}
 
+	void GraphicsManager::UseDefaultDpethStencilState()
+	{
+		mStateTracker.SetDepthStencilState(nullptr, 0);
+	}
+
+	// Creates a graphics buffer
+	ID3D11Buffer* GraphicsManager::CreateBuffer(const BufferDesc& desc, MemoryTag tag, const void* data)
+	{
+		ID3D11Buffer* newBuffer = mBackend->CreateBuffer(desc, data);
+		if (!newBuffer)
+		{
+			return nullptr;
 		}
 
-		IDXGIFactory2* dxgiFactory = nullptr;
-		if (FAILED(hr = dxgiAdapter->GetParent(__uuidof(IDXGIFactory2), reinterpret_cast<void**>(&dxgiFactory))))
+		mCounters.Add(RenderCounter::BufferCreations, 1);
+		mCounters.Add(RenderCounter::BytesCreated, desc.size);
+		MemoryTracker::Get().Allocate(tag, MemoryDomain::Gpu, desc.size);
+		return newBuffer;
+	}
+
+	void GraphicsManager::ReleaseBuffer(ID3D11Buffer*& buffer, MemoryTag tag)
+	{
+		if (!buffer)
 		{
-			SAFE_RELEASE(dxgiDevice);
-			SAFE_RELEASE(dxgiAdapter);
-			MessageBox(NULL, L"IDXGIAdapter::GetParent() failed retrieving factory.",
-				L"Error", MB_OK | MB_ICONERROR);
 			return;
 		}
+		MemoryTracker::Get().Free(tag, MemoryDomain::Gpu, mBackend->GetBufferSize(buffer));
+		mBackend->ReleaseBuffer(buffer);
+		buffer = nullptr;
+	}
 
-		//Create swapchain description
-		DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
-		ZeroMemory(&swapChainDesc, sizeof(DXGI_SWAP_CHAIN_DESC1));
-		swapChainDesc.Width = mConfig.screenWidth;
-		swapChainDesc.Height = mConfig.screenHeight;
-		swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-		swapChainDesc.BufferCount = 1;
-		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-
-		//Multisampling quality level
-		UINT qualityLevel;
-		if (mConfig.multiSamplingenabled)
+	//Updates a graphics buffer
+	void GraphicsManager::UpdateBuffer(ID3D11Buffer* buffer, const void* data, std::uint32_t dataSize)
+	{
+		const std::uint32_t size = mBackend->GetBufferSize(buffer);
+		if (dataSize == 0 || dataSize > size)
 		{
-			mDevice->CheckMultisampleQualityLevels(DXGI_FORMAT_R8G8B8A8_UNORM, mConfig.multiSamplingCount, &qualityLevel);
-			if (qualityLevel == 0)
-			{
-				SAFE_RELEASE(dxgiDevice);
-				SAFE_RELEASE(dxgiAdapter);
-				SAFE_RELEASE(dxgiFactory);
-
-				MessageBox(NULL, L"Unsupported multisampling quality level.",
-					L"Error", MB_OK | MB_ICONERROR);
-				return;
-			}
-			swapChainDesc.SampleDesc.Count = mConfig.multiSamplingCount;
-			swapChainDesc.SampleDesc.Quality = qualityLevel - 1;
+			dataSize = size;
 		}
-		else
+		mCounters.Add(RenderCounter::BufferUpdates, 1);
+		mCounters.Add(RenderCounter::BytesUploaded, dataSize);
+		mBackend->UpdateBuffer(buffer, 0, data, dataSize);
+	}
+
+	void GraphicsManager::UpdateBufferRegion(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t dataSize)
+	{
+		if (dataSize == 0)
 		{
-			swapChainDesc.SampleDesc.Count = 1;
-			swapChainDesc.SampleDesc.Quality = 0;
+			return;
 		}
+		mCounters.Add(RenderCounter::BufferUpdates, 1);
+		mCounters.Add(RenderCounter::BytesUploaded, dataSize);
+		mBackend->UpdateBuffer(buffer, offset, data, dataSize);
+	}
 
-		DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullScreenDesc;
-		ZeroMemory(&fullScreenDesc, sizeof(fullScreenDesc));
-		fullScreenDesc.RefreshRate.Denominator = 1;
-		fullScreenDesc.RefreshRate.Numerator = mConfig.refreshRate;
-		fullScreenDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-		fullScreenDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-		fullScreenDesc.Windowed = mConfig.windowed;
-
-		if (FAILED(hr = dxgiFactory->CreateSwapChainForHwnd(dxgiDevice, mWindowHandle, &swapChainDesc, &fullScreenDesc, NULL, &mSwapChain)))
+	void GraphicsManager::CopyBufferRegion(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size)
+	{
+		if (size == 0)
 		{
-			SAFE_RELEASE(dxgiDevice);
-			SAFE_RELEASE(dxgiAdapter);
-			SAFE_RELEASE(dxgiFactory);
-			MessageBox(NULL, L"IDXGIDevice::CreateSwapChainForHwnd() failed.",
-				L"Error", MB_OK | MB_ICONERROR);
 			return;
 		}
-
-		// Release temporary resources
-		SAFE_RELEASE(dxgiDevice);
-		SAFE_RELEASE(dxgiAdapter);
-		SAFE_RELEASE(dxgiFactory);
-
-		ID3D11Texture2D* backBuffer;
-		//Create back buffer and render target
-		hr = mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer);
-		hr = mDevice->CreateRenderTargetView(backBuffer, NULL, &mRenderTargetView);
-
-		SAFE_RELEASE(backBuffer);
-
-		//Describe the Depth/Stencil Buffer
-		D3D11_TEXTURE2D_DESC depthStencilDesc;
-
-		depthStencilDesc.Width = mConfig.screenWidth;
-		depthStencilDesc.Height = mConfig.screenHeight;
-		depthStencilDesc.MipLevels = 1;
-		depthStencilDesc.ArraySize = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT; //24 bits for the depth and 8 bits for the stencil.
-		depthStencilDesc.SampleDesc.Count = swapChainDesc.SampleDesc.Count;
-		depthStencilDesc.SampleDesc.Quality = swapChainDesc.SampleDesc.Quality;
-		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
-		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-		depthStencilDesc.CPUAccessFlags = 0;
-		depthStencilDesc.MiscFlags = 0;
-		mDevice->CreateTexture2D(&depthStencilDesc, NULL, &mDepthStencilBuffer);
-
-		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
-		ZeroMemory(&depthStencilViewDesc, sizeof(D3D11_DEPTH_STENCIL_VIEW_DESC));
-		depthStencilViewDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DMS;
-		depthStencilViewDesc.Texture2D.MipSlice = 0;
-
-		mDevice->CreateDepthStencilView(mDepthStencilBuffer, &depthStencilViewDesc, &mDepthStencilView);
-
-		CreateViewPort(mConfig.screenWidth, mConfig.screenHeight);
-		SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);	
+		mBackend->CopyBuffer(dest, destOffset, source, sourceOffset, size);
 	}
 
-	void GraphicsManager::CreateViewPort(float screenWidth, float screenHeight)
+	const PipelineState* GraphicsManager::CreatePipelineState(const PipelineStateDesc& desc)
 	{
-		//Create the Viewport
-		D3D11_VIEWPORT viewport;
-		ZeroMemory(&viewport, sizeof(D3D11_VIEWPORT));
-
-		viewport.TopLeftX = 0;
-		viewport.TopLeftY = 0;
-		viewport.Width = screenWidth;
-		viewport.Height = screenHeight;
-		viewport.MinDepth = 0.0f;
-		viewport.MaxDepth = 1.0f;
-
-		//Set the Viewport
-		SetViewports(1, &viewport);
+		return mPipelineStates.GetOrCreate(desc);
 	}
 
-	void GraphicsManager::SetViewports(int numViewPorts, const D3D11_VIEWPORT* mViewports)
+	void GraphicsManager::SetPipelineState(const PipelineState* state)
 	{
-		this->mViewports.clear();
-		for (int i = 0; i < numViewPorts; i++) {
-			const D3D11_VIEWPORT viewport = mViewports[i];
-			this->mViewports.push_back(viewport);
-		}
-
-		mDeviceContext->RSSetViewports(numViewPorts, mViewports);
-	}
-
-	D3D11_VIEWPORT* GraphicsManager::GetViewport(int slot)
-	{
-		return &this->mViewports.at(slot);
-	}
-
-	void GraphicsManager::CreateBlendStates()
-	{
-		D3D11_BLEND_DESC blendDesc;
-
-		//Alpha blend state
-		ZeroMemory(&blendDesc, sizeof(blendDesc));
-		blendDesc.AlphaToCoverageEnable = true;
-		blendDesc.IndependentBlendEnable = false;
-		blendDesc.RenderTarget[0].BlendEnable = true;
-		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
-		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-		blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
-		blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-		blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D10_COLOR_WRITE_ENABLE_ALL;
-		ID3D11BlendState* blendState;
-		mDevice->CreateBlendState(&blendDesc, &mAlphaBlend);
-
-		//Colour blend state
-		ZeroMemory(&blendDesc, sizeof(blendDesc));
-		blendDesc.AlphaToCoverageEnable = true;
-		blendDesc.IndependentBlendEnable = false;
-		blendDesc.RenderTarget[0].BlendEnable = true;
-		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_COLOR;
-		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_BLEND_FACTOR;
-		blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
-		blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-		blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D10_COLOR_WRITE_ENABLE_ALL;
-		mDevice->CreateBlendState(&blendDesc, &mColourBlend);
-	}
-
-	void GraphicsManager::CreateRenderStates()
-	{
-		D3D11_RASTERIZER_DESC rastDesc;
-
-		//Clock-wise culling
-		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
-		rastDesc.FillMode = D3D11_FILL_SOLID;
-		rastDesc.CullMode = D3D11_CULL_BACK;
-		rastDesc.FrontCounterClockwise = FALSE;
-		rastDesc.DepthBias = 0;
-		rastDesc.DepthBiasClamp = 0.0f;
-		rastDesc.SlopeScaledDepthBias = 0.0f;
-		rastDesc.DepthClipEnable = TRUE;
-		rastDesc.ScissorEnable = FALSE;
-		rastDesc.MultisampleEnable = TRUE;
-		rastDesc.AntialiasedLineEnable = TRUE;
-		mDevice->CreateRasterizerState(&rastDesc, &mCwCull);
-
-		//Counter-clockwise culling
-		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
-		rastDesc.FillMode = D3D11_FILL_SOLID;
-		rastDesc.CullMode = D3D11_CULL_BACK;
-		rastDesc.FrontCounterClockwise = TRUE;
-		rastDesc.DepthBias = 0;
-		rastDesc.DepthBiasClamp = 0.0f;
-		rastDesc.SlopeScaledDepthBias = 0.0f;
-		rastDesc.DepthClipEnable = TRUE;
-		rastDesc.ScissorEnable = FALSE;
-		rastDesc.MultisampleEnable = TRUE;
-		rastDesc.AntialiasedLineEnable = TRUE;
-		mDevice->CreateRasterizerState(&rastDesc, &mCcwCull);
-
-		//No culling
-		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
-		rastDesc.FillMode = D3D11_FILL_SOLID;
-		rastDesc.CullMode = D3D11_CULL_NONE;
-		rastDesc.FrontCounterClockwise = FALSE;
-		rastDesc.DepthBias = 0;
-		rastDesc.DepthBiasClamp = 0.0f;
-		rastDesc.SlopeScaledDepthBias = 0.0f;
-		rastDesc.DepthClipEnable = TRUE;
-		rastDesc.ScissorEnable = FALSE;
-		rastDesc.MultisampleEnable = TRUE;
-		rastDesc.AntialiasedLineEnable = TRUE;
-		mDevice->CreateRasterizerState(&rastDesc, &mNoCull);
-
-		//Wireframe
-		ZeroMemory(&rastDesc, sizeof(D3D11_RASTERIZER_DESC));
-		rastDesc.FillMode = D3D11_FILL_WIREFRAME;
-		rastDesc.CullMode = D3D11_CULL_NONE;
-		rastDesc.FrontCounterClockwise = FALSE;
-		rastDesc.DepthBias = 0;
-		rastDesc.DepthBiasClamp = 0.0f;
-		rastDesc.SlopeScaledDepthBias = 0.0f;
-		rastDesc.DepthClipEnable = TRUE;
-		rastDesc.ScissorEnable = FALSE;
-		rastDesc.MultisampleEnable = TRUE;
-		rastDesc.AntialiasedLineEnable = TRUE;
-		mDevice->CreateRasterizerState(&rastDesc, &mWireframe);
-	}
-
-	void GraphicsManager::CreateDepthStencilStates()
-	{
-		D3D11_DEPTH_STENCIL_DESC dssDesc;
-
-		//Create depth stencil state used for sky.
-		ZeroMemory(&dssDesc, sizeof(D3D11_DEPTH_STENCIL_DESC));
-		dssDesc.DepthEnable = true;
-		dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-		dssDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
-		dssDesc.StencilEnable = FALSE;
-		dssDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
-		dssDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
-
-		mDevice->CreateDepthStencilState(&dssDesc, &mFullDepth);
-	}
-
-	void GraphicsManager::SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY topology)
-	{
-		mDeviceContext->IASetPrimitiveTopology(topology);
+		mStateTracker.SetPipelineState(state);
 	}
 
-	//Cull counterclockwise polygons.
-	void GraphicsManager::EnableClockwiseCulling()
+	void GraphicsManager::ClearBackBuffer(const float colour[4])
 	{
-		mDeviceContext->RSSetState(mCwCull);
+		mBackend->ClearRenderTarget(mBackend->GetBackBuffer(), colour);
+		mBackend->ClearDepthStencil(mBackend->GetDepthStencil(), 1.0f, 0);
 	}
 
-	//Cull clockwise polygons.
-	void GraphicsManager::EnableCounterClockwiseCulling()
+	void GraphicsManager::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance)
 	{
-		mDeviceContext->RSSetState(mCcwCull);
+		mBackend->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
 	}
 
-	void GraphicsManager::DisableCulling()
+	ID3D11RenderTargetView* GraphicsManager::GetBackBuffer() const
 	{
-		mDeviceContext->RSSetState(mNoCull);
+		return mBackend->GetBackBuffer();
 	}
 
-	void GraphicsManager::EnableWireframeRendering()
+	ID3D11DepthStencilView* GraphicsManager::GetDepthStencil() const
 	{
-		mDeviceContext->RSSetState(mWireframe);
+		return mBackend->GetDepthStencil();
 	}
 
-	void GraphicsManager::EnableAplhaBlending()
+	GraphicsBackend* GraphicsManager::GetBackend() const
 	{
-		mDeviceContext->OMSetBlendState(mAlphaBlend, 0, 0xffffffff);
+		return mBackend;
 	}
 
-	void GraphicsManager::EnableColourBlending(float redFactor, float greenFactor, float blueFactor, float alphaFactor)
+	StateTracker& GraphicsManager::GetStateTracker()
 	{
-		float blendFactor[] = { redFactor, greenFactor, blueFactor, alphaFactor };
-		mDeviceContext->OMSetBlendState(mColourBlend, blendFactor, 0xffffffff);
+		return mStateTracker;
 	}
 
-	void GraphicsManager::DisableBlending()
+	RenderCounters& GraphicsManager::GetCounters()
 	{
-		mDeviceContext->OMSetBlendState(0, 0, 0xffffffff);
+		return mCounters;
 	}
 
-	void GraphicsManager::EnableFullDepth()
+	bool GraphicsManager::RequestBackBufferReadback(std::uint64_t id)
 	{
-		mDeviceContext->OMSetDepthStencilState(mFullDepth, 0);
+		return mBackend->RequestBackBufferReadback(id);
 	}
 
-	void GraphicsManager::UseDefaultDpethStencilState()
+	bool GraphicsManager::MapReadback(BackBufferReadback& readback)
 	{
-		mDeviceContext->OMSetDepthStencilState(NULL, 0);
+		return mBackend->MapReadback(readback);
 	}
 
-	// Creates a graphics buffer
-	ID3D11Buffer* GraphicsManager::CreateBuffer(const D3D11_BUFFER_DESC& bufferDesc, const void* data)
+	void GraphicsManager::UnmapReadback(const BackBufferReadback& readback)
 	{
-		//Create buffer using description and the address of the above buffer declaration.
-		ID3D11Buffer* newBuffer;
-		HRESULT hr;
-		if (data)
-		{
-			D3D11_SUBRESOURCE_DATA pInitialData;
-			pInitialData.pSysMem = data;
-			pInitialData.SysMemPitch = 0;
-			pInitialData.SysMemSlicePitch = 0;	
-
-			if (FAILED(hr = mDevice->CreateBuffer(&bufferDesc, &pInitialData, &newBuffer)))
-			{
-				MessageBox(NULL, L"ID3D11Device::CreateBuffer() failed.",
-					L"Error", MB_OK | MB_ICONERROR);
-				return nullptr;
-			}
-		}
-		else
-		{
-			if (FAILED(hr = mDevice->CreateBuffer(&bufferDesc, NULL, &newBuffer)))
-			{
-				MessageBox(NULL, L"ID3D11Device::CreateBuffer() failed.",
-					L"Error", MB_OK | MB_ICONERROR);
-				return nullptr;
-			}
-		}
-
-		return newBuffer;
+		mBackend->UnmapReadback(readback);
 	}
 
-	//Updates a graphics buffer
-	void GraphicsManager::UpdateBuffer(ID3D11Buffer* buffer, const void* data)
+	void GraphicsManager::Present()
 	{
-		D3D11_BUFFER_DESC desc;
-		buffer->GetDesc(&desc);
-		if (desc.Usage == D3D11_USAGE_DYNAMIC)
-		{
-			D3D11_MAPPED_SUBRESOURCE mappedBuff;
-			HRESULT hr = mDeviceContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuff);
-			// Copy the data into the buffer.
-			memcpy(mappedBuff.pData, data, desc.ByteWidth);
-			mDeviceContext->Unmap(buffer, 0);
-		}
-		else
-		{
-			mDeviceContext->UpdateSubresource(buffer, 0, NULL, data, 0, 0);
-		}
+		mBackend->Present();
+		// Render targets are bound again every frame, so nothing assumes present kept the last binding
+		mStateTracker.InvalidateRenderTargets();
 	}
 }
-	
-	
-
-	
\ No newline at end of file
@@ -1,20 +1,23 @@
 #pragma once
 
 #include "DataTypes.h"
-#include "GraphicsTypes.h"
+#include "GraphicsBackend.h"
+#include "PipelineState.h"
+#include "StateTracker.h"
+#include "RenderStats.h"
+#include "Memory/MemoryTracker.h"
 
 namespace renderer
 {
-	/** Class used to initialize DirectX11 and manage its device and context */
+	/** Manages the graphics backend the renderer draws through, counting what it creates and uploads */
 	class GraphicsManager
 	{
 	public:
-		/** Initializes DirectX 11 and the graphics manager */
-		static GraphicsManager* Initialize(HWND windowHandle, const GraphicsConfig& config);
+		/** Initializes the graphics manager, which takes ownership of the backend */
+		static GraphicsManager* Initialize(GraphicsBackend* backend);
 		~GraphicsManager();
-		void SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY topology);
-		void SetViewports(int numViewPorts, const D3D11_VIEWPORT* viewports);
-		D3D11_VIEWPORT* GetViewport(int slot);
+		void SetPrimitiveTopology(std::uint32_t topology);
+		void SetViewport(const ViewportRect& viewport);
 		void EnableClockwiseCulling();
 		void EnableCounterClockwiseCulling();
 		void EnableWireframeRendering();
@@ -24,41 +27,44 @@ namespace renderer
 		void DisableBlending();
 		void EnableFullDepth();
 		void UseDefaultDpethStencilState();
-		ID3D11Buffer* CreateBuffer(const D3D11_BUFFER_DESC& bufferDesc, const void* data = nullptr);
-		void UpdateBuffer(ID3D11Buffer* buffer, const void* dataSrc);
+		/** Creates a buffer and accounts its size to the tag as GPU memory */
+		ID3D11Buffer* CreateBuffer(const BufferDesc& desc, MemoryTag tag, const void* data = nullptr);
+		/** Releases a buffer made by CreateBuffer with the same tag and sets the pointer to null */
+		void ReleaseBuffer(ID3D11Buffer*& buffer, MemoryTag tag);
+		// Copies dataSize bytes to the start of the buffer. Zero copies the whole buffer
+		void UpdateBuffer(ID3D11Buffer* buffer, const void* dataSrc, std::uint32_t dataSize = 0);
+		/** Copies dataSize bytes to the offset of a default usage buffer */
+		void UpdateBufferRegion(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t dataSize);
+		/** Copies size bytes between buffers on the GPU. The buffers must be different */
+		void CopyBufferRegion(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size);
+		/** Returns the cached pipeline state for the description */
+		const PipelineState* CreatePipelineState(const PipelineStateDesc& desc);
+		void SetPipelineState(const PipelineState* state);
+		/** Clears the back buffer to the colour and the depth buffer to the far plane */
+		void ClearBackBuffer(const float colour[4]);
+		void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance);
+		ID3D11RenderTargetView* GetBackBuffer() const;
+		ID3D11DepthStencilView* GetDepthStencil() const;
+		GraphicsBackend* GetBackend() const;
+		// All binds should go through the state tracker so redundant ones are dropped
+		StateTracker& GetStateTracker();
+		// Buffer creations and uploads are counted here. The renderers add their own counts
+		RenderCounters& GetCounters();
+		/** See GraphicsBackend::RequestBackBufferReadback */
+		bool RequestBackBufferReadback(std::uint64_t id);
+		/** Maps the oldest copied frame if the GPU has finished copying it. Never waits for the GPU */
+		bool MapReadback(BackBufferReadback& readback);
+		void UnmapReadback(const BackBufferReadback& readback);
+		void Present();
 
 	private:
-		friend class Renderer;
-		friend class MeshRenderer;
+		explicit GraphicsManager(GraphicsBackend* backend);
 
-		GraphicsManager(HWND windowHandle, const GraphicsConfig& config);
-		void InitializeD3D();
-		void CreateViewPort(float screenWidth, float screenHeight);
-		void CreateBlendStates();
-		void CreateRenderStates();
-		void CreateDepthStencilStates();
-
-		// Handle to the window and config passed by the application
-		HWND mWindowHandle;
-		GraphicsConfig mConfig;
-
-		// Core graphics resources
-		ID3D11DepthStencilView* mDepthStencilView;
-		ID3D11RenderTargetView* mRenderTargetView;
-		IDXGISwapChain1* mSwapChain;
-		ID3D11Device1* mDevice;
-		ID3D11DeviceContext1* mDeviceContext;
-		ID3D11Texture2D* mDepthStencilBuffer;
-
-		std::vector<D3D11_VIEWPORT> mViewports;
-		ID3D11BlendState* mAlphaBlend;
-		ID3D11BlendState* mColourBlend;
-		ID3D11RasterizerState* mCwCull;
-		ID3D11RasterizerState* mCcwCull;
-		ID3D11RasterizerState* mNoCull;
-		ID3D11RasterizerState* mWireframe;
-		ID3D11DepthStencilState* mFullDepth;
+		GraphicsBackend* mBackend;
+		StateTracker mStateTracker;
+		PipelineStateCache mPipelineStates;
+		RenderCounters mCounters;
 
 		static GraphicsManager* mGraphicsManager;
 	};
-}
\ No newline at end of file
+}
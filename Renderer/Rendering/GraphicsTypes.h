@@ -1,29 +1,26 @@
 #pragma once
 
 #include "Minimal.h"
-#include "D3DIncludes.h"
+#include "ShaderTypes.h"
+#include "Memory/BufferSubAllocator.h"
+
+struct ID3D11Buffer;
+struct ID3D11ShaderResourceView;
 
 using namespace DirectX;
 
 namespace renderer
 {
-	/** Wrapper to store mesh buffers */
+	/** Ranges of a mesh in the vertex, index and instance buffers shared by every mesh */
 	struct MeshBuffers
 	{
-		ID3D11Buffer* vertexBuffer;
-		ID3D11Buffer* instanceBuffer;
-		ID3D11Buffer* indexBuffer;
+		BufferRangeHandle vertices = InvalidBufferRange;
+		BufferRangeHandle indices = InvalidBufferRange;
+		BufferRangeHandle instances = InvalidBufferRange;
 		uint32_t indexCount = 0;
 		uint32_t vertexCount = 0;
-
-		void Release()
-		{
-			SAFE_RELEASE(vertexBuffer);
-			SAFE_RELEASE(instanceBuffer);
-			SAFE_RELEASE(indexBuffer);
-			indexCount = 0;
-			vertexCount = 0;
-		}
+		// Registry version of the geometry in the ranges, so a reused mesh handle is uploaded again
+		uint32_t version = ~0u;
 	};
 
 
@@ -32,49 +29,5 @@ namespace renderer
 	{
 		ID3D11Buffer* buffer;
 		ID3D11ShaderResourceView* shaderResourceView;
-
-		void Release()
-		{
-			SAFE_RELEASE(shaderResourceView);
-			SAFE_RELEASE(buffer);
-		}
-	};
-
-	/** Point light for shader */
-	struct ShaderPointLight
-	{
-		XMFLOAT3 pos;
-		float range;
-		XMFLOAT3 att;
-		float pad;
-		XMFLOAT4 diffuse;
-		XMFLOAT4 specular;
-	};
-
-	/** Spot light for shader */
-	struct ShaderSpotLight
-	{
-		XMFLOAT3 pos;
-		float range;
-		XMFLOAT3 dir;
-		float cone;
-		XMFLOAT3 att;
-		float pad;
-		XMFLOAT4 diffuse;
-		XMFLOAT4 specular;
-	};
-
-	struct ShaderSceneParams
-	{
-		XMMATRIX ViewProj;
-		XMFLOAT3 camPos;
-		float ambient;
-		UINT pointLightCount;
-		UINT pad1, pad2, pad3;
-	};
-
-	struct MeshInstanceData
-	{
-		XMMATRIX world;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,406 @@
+#include "ImageFile.h"
+#include "Profiling/Profiler.h"
+#include <array>
+
+namespace renderer
+{
+	namespace
+	{
+		/** Next number of a PPM header, skipping whitespace and comments. Fails at the end of the file */
+		bool ReadHeaderValue(std::istream& file, std::uint32_t& value)
+		{
+			int c = file.get();
+			while (c == '#' || std::isspace(c))
+			{
+				if (c == '#')
+				{
+					while (c != '\n' && c != EOF)
+					{
+						c = file.get();
+					}
+				}
+				c = file.get();
+			}
+			if (c < '0' || c > '9')
+			{
+				return false;
+			}
+			std::uint64_t result = 0;
+			while (c >= '0' && c <= '9' && result <= UINT32_MAX)
+			{
+				result = result * 10 + (c - '0');
+				c = file.get();
+			}
+			// One whitespace character ends the value
+			value = static_cast<std::uint32_t>(result);
+			return result <= UINT32_MAX && std::isspace(c);
+		}
+
+		const std::uint8_t PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+		/** The CRC-32 PNG chunks end with, continuing from an earlier one */
+		std::uint32_t Crc32(const std::uint8_t* data, size_t size, std::uint32_t crc = 0)
+		{
+			static const std::array<std::uint32_t, 256> table = []()
+			{
+				std::array<std::uint32_t, 256> entries;
+				for (std::uint32_t i = 0; i < 256; ++i)
+				{
+					std::uint32_t value = i;
+					for (std::uint32_t bit = 0; bit < 8; ++bit)
+					{
+						value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+					}
+					entries[i] = value;
+				}
+				return entries;
+			}();
+			crc = ~crc;
+			for (size_t i = 0; i < size; ++i)
+			{
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		void AppendBigEndian(std::vector<std::uint8_t>& output, std::uint32_t value)
+		{
+			const std::uint8_t bytes[4] = { static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+				static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value) };
+			output.insert(output.end(), bytes, bytes + 4);
+		}
+
+		std::uint32_t ReadBigEndian(const std::uint8_t* data)
+		{
+			return (static_cast<std::uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+		}
+
+		/** Length, type, data and the CRC of the type and data */
+		void AppendChunk(std::vector<std::uint8_t>& output, const char* type, const std::uint8_t* data, size_t size)
+		{
+			AppendBigEndian(output, static_cast<std::uint32_t>(size));
+			const size_t start = output.size();
+			output.insert(output.end(), type, type + 4);
+			output.insert(output.end(), data, data + size);
+			AppendBigEndian(output, Crc32(output.data() + start, output.size() - start));
+		}
+
+		std::uint8_t Paeth(std::uint8_t left, std::uint8_t above, std::uint8_t aboveLeft)
+		{
+			const int estimate = left + above - aboveLeft;
+			const int toLeft = std::abs(estimate - left);
+			const int toAbove = std::abs(estimate - above);
+			const int toAboveLeft = std::abs(estimate - aboveLeft);
+			return toLeft <= toAbove && toLeft <= toAboveLeft ? left : toAbove <= toAboveLeft ? above : aboveLeft;
+		}
+
+		/**
+		 * Filters the row with each of the five PNG filters and writes the filter byte and the result of the one with
+		 * the smallest sum of absolute differences, which the PNG specification suggests as a cheap guess at what
+		 * compresses best. The candidates buffer holds five rows
+		 */
+		void FilterRow(const std::uint8_t* row, const std::uint8_t* above, size_t size, size_t pixelSize, std::uint8_t* candidates,
+			std::uint8_t* output)
+		{
+			// One loop per filter, with the first pixel, which has nothing to its left, done apart
+			std::uint8_t* none = candidates;
+			std::uint8_t* sub = candidates + size;
+			std::uint8_t* up = candidates + size * 2;
+			std::uint8_t* average = candidates + size * 3;
+			std::uint8_t* paeth = candidates + size * 4;
+			std::copy(row, row + size, none);
+			for (size_t i = 0; i < std::min(pixelSize, size); ++i)
+			{
+				sub[i] = row[i];
+				average[i] = static_cast<std::uint8_t>(row[i] - above[i] / 2);
+				paeth[i] = static_cast<std::uint8_t>(row[i] - above[i]);
+			}
+			for (size_t i = 0; i < size; ++i)
+			{
+				up[i] = static_cast<std::uint8_t>(row[i] - above[i]);
+			}
+			for (size_t i = pixelSize; i < size; ++i)
+			{
+				sub[i] = static_cast<std::uint8_t>(row[i] - row[i - pixelSize]);
+			}
+			for (size_t i = pixelSize; i < size; ++i)
+			{
+				average[i] = static_cast<std::uint8_t>(row[i] - (row[i - pixelSize] + above[i]) / 2);
+			}
+			for (size_t i = pixelSize; i < size; ++i)
+			{
+				paeth[i] = static_cast<std::uint8_t>(row[i] - Paeth(row[i - pixelSize], above[i], above[i - pixelSize]));
+			}
+
+			std::uint64_t bestSum = UINT64_MAX;
+			std::uint32_t bestFilter = 0;
+			for (std::uint32_t filter = 0; filter < 5; ++filter)
+			{
+				// Bytes read as signed, so small steps down count as small
+				const std::uint8_t* filtered = candidates + filter * size;
+				std::uint64_t sum = 0;
+				for (size_t i = 0; i < size; ++i)
+				{
+					sum += static_cast<std::uint64_t>(std::abs(static_cast<std::int8_t>(filtered[i])));
+				}
+				if (sum < bestSum)
+				{
+					bestSum = sum;
+					bestFilter = filter;
+				}
+			}
+			output[0] = static_cast<std::uint8_t>(bestFilter);
+			std::copy(candidates + bestFilter * size, candidates + (bestFilter + 1) * size, output + 1);
+		}
+
+		/** Reverses a filter in place, given the row above already reversed */
+		bool UnfilterRow(std::uint8_t filter, std::uint8_t* row, const std::uint8_t* above, size_t size, size_t pixelSize)
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				const std::uint8_t left = i >= pixelSize ? row[i - pixelSize] : 0;
+				const std::uint8_t aboveLeft = i >= pixelSize ? above[i - pixelSize] : 0;
+				switch (filter)
+				{
+				case 0: break;
+				case 1: row[i] = static_cast<std::uint8_t>(row[i] + left); break;
+				case 2: row[i] = static_cast<std::uint8_t>(row[i] + above[i]); break;
+				case 3: row[i] = static_cast<std::uint8_t>(row[i] + (left + above[i]) / 2); break;
+				case 4: row[i] = static_cast<std::uint8_t>(row[i] + Paeth(left, above[i], aboveLeft)); break;
+				default: return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	void Image::Resize(std::uint32_t newWidth, std::uint32_t newHeight)
+	{
+		width = newWidth;
+		height = newHeight;
+		pixels.resize(static_cast<size_t>(newWidth) * newHeight * 4);
+	}
+
+	bool ImageFile::SavePpm(const std::string& path, const Image& image)
+	{
+		return Save(path, image, ImageFormat::Ppm);
+	}
+
+	bool ImageFile::LoadPpm(const std::string& path, Image& image)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::uint32_t maxValue = 0;
+		if (!file || file.get() != 'P' || file.get() != '6' || !ReadHeaderValue(file, width) || !ReadHeaderValue(file, height) ||
+			!ReadHeaderValue(file, maxValue) || maxValue != 255 || width == 0 || height == 0 || width > 65536 || height > 65536)
+		{
+			return false;
+		}
+
+		image.Resize(width, height);
+		std::vector<std::uint8_t> row(static_cast<size_t>(width) * 3);
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			if (!file.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size())))
+			{
+				return false;
+			}
+			std::uint8_t* destination = image.pixels.data() + static_cast<size_t>(y) * width * 4;
+			for (std::uint32_t x = 0; x < width; ++x)
+			{
+				destination[x * 4] = row[x * 3];
+				destination[x * 4 + 1] = row[x * 3 + 1];
+				destination[x * 4 + 2] = row[x * 3 + 2];
+				destination[x * 4 + 3] = 255;
+			}
+		}
+		return true;
+	}
+
+	bool ImageFile::SavePng(const std::string& path, const Image& image, DeflateLevel level)
+	{
+		return Save(path, image, ImageFormat::Png, level);
+	}
+
+	bool ImageFile::LoadPng(const std::string& path, Image& image)
+	{
+		std::ifstream file(path, std::ios::binary);
+		const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (bytes.size() < 8 || !std::equal(PngSignature, PngSignature + 8, bytes.begin()))
+		{
+			return false;
+		}
+
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		size_t pixelSize = 0;
+		std::vector<std::uint8_t> compressed;
+		bool ended = false;
+		for (size_t offset = 8; !ended;)
+		{
+			if (offset + 12 > bytes.size())
+			{
+				return false;
+			}
+			const std::uint32_t length = ReadBigEndian(bytes.data() + offset);
+			if (length > bytes.size() - offset - 12)
+			{
+				return false;
+			}
+			const std::uint8_t* type = bytes.data() + offset + 4;
+			const std::uint8_t* data = type + 4;
+			if (Crc32(type, length + 4) != ReadBigEndian(data + length))
+			{
+				return false;
+			}
+			const std::string name(type, type + 4);
+			if (name == "IHDR")
+			{
+				// 8 bits per channel, deflate, the adaptive filters and no interlacing
+				if (length != 13 || data[8] != 8 || (data[9] != 2 && data[9] != 6) || data[10] != 0 || data[11] != 0 || data[12] != 0)
+				{
+					return false;
+				}
+				width = ReadBigEndian(data);
+				height = ReadBigEndian(data + 4);
+				pixelSize = data[9] == 6 ? 4 : 3;
+			}
+			else if (name == "IDAT")
+			{
+				compressed.insert(compressed.end(), data, data + length);
+			}
+			ended = name == "IEND";
+			offset += 12 + length;
+		}
+		if (width == 0 || height == 0 || width > 65536 || height > 65536)
+		{
+			return false;
+		}
+
+		const size_t rowSize = static_cast<size_t>(width) * pixelSize;
+		std::vector<std::uint8_t> filtered;
+		filtered.reserve((rowSize + 1) * height);
+		if (!Deflate::Decompress(compressed.data(), compressed.size(), filtered) || filtered.size() != (rowSize + 1) * height)
+		{
+			return false;
+		}
+		image.Resize(width, height);
+		const std::vector<std::uint8_t> zeros(rowSize, 0);
+		const std::uint8_t* above = zeros.data();
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			std::uint8_t* row = filtered.data() + y * (rowSize + 1);
+			if (!UnfilterRow(row[0], row + 1, above, rowSize, pixelSize))
+			{
+				return false;
+			}
+			std::uint8_t* destination = image.pixels.data() + static_cast<size_t>(y) * width * 4;
+			for (std::uint32_t x = 0; x < width; ++x)
+			{
+				destination[x * 4] = row[1 + x * pixelSize];
+				destination[x * 4 + 1] = row[1 + x * pixelSize + 1];
+				destination[x * 4 + 2] = row[1 + x * pixelSize + 2];
+				destination[x * 4 + 3] = 255;
+			}
+			above = row + 1;
+		}
+		return true;
+	}
+
+	void ImageFile::Encode(const Image& image, ImageFormat format, std::vector<std::uint8_t>& output, DeflateLevel level)
+	{
+		PROFILE_ZONE("ImageFile::Encode");
+		const size_t rowSize = static_cast<size_t>(image.width) * 3;
+		auto copyRow = [&](std::uint32_t y, std::uint8_t* destination)
+		{
+			const std::uint8_t* source = image.pixels.data() + static_cast<size_t>(y) * image.width * 4;
+			for (std::uint32_t x = 0; x < image.width; ++x)
+			{
+				destination[x * 3] = source[x * 4];
+				destination[x * 3 + 1] = source[x * 4 + 1];
+				destination[x * 3 + 2] = source[x * 4 + 2];
+			}
+		};
+
+		if (format == ImageFormat::Ppm)
+		{
+			const std::string header = "P6\n" + std::to_string(image.width) + " " + std::to_string(image.height) + "\n255\n";
+			const size_t start = output.size();
+			output.resize(start + header.size() + rowSize * image.height);
+			std::copy(header.begin(), header.end(), output.begin() + start);
+			for (std::uint32_t y = 0; y < image.height; ++y)
+			{
+				copyRow(y, output.data() + start + header.size() + y * rowSize);
+			}
+			return;
+		}
+
+		// Each row is filtered against the one above before the whole is compressed
+		std::vector<std::uint8_t> filtered((rowSize + 1) * image.height);
+		std::vector<std::uint8_t> rows(rowSize * 2, 0);
+		std::vector<std::uint8_t> candidates(rowSize * 5);
+		std::uint8_t* row = rows.data();
+		std::uint8_t* above = rows.data() + rowSize;
+		for (std::uint32_t y = 0; y < image.height; ++y)
+		{
+			copyRow(y, row);
+			FilterRow(row, above, rowSize, 3, candidates.data(), filtered.data() + y * (rowSize + 1));
+			std::swap(row, above);
+		}
+
+		output.insert(output.end(), PngSignature, PngSignature + 8);
+		std::vector<std::uint8_t> header;
+		AppendBigEndian(header, image.width);
+		AppendBigEndian(header, image.height);
+		// 8 bit RGB, deflate, adaptive filters, not interlaced
+		const std::uint8_t properties[5] = { 8, 2, 0, 0, 0 };
+		header.insert(header.end(), properties, properties + 5);
+		AppendChunk(output, "IHDR", header.data(), header.size());
+		std::vector<std::uint8_t> compressed;
+		Deflate::Compress(filtered.data(), filtered.size(), compressed, level);
+		AppendChunk(output, "IDAT", compressed.data(), compressed.size());
+		AppendChunk(output, "IEND", nullptr, 0);
+	}
+
+	bool ImageFile::Save(const std::string& path, const Image& image, ImageFormat format, DeflateLevel level)
+	{
+		std::vector<std::uint8_t> bytes;
+		Encode(image, format, bytes, level);
+		return WriteFile(path, bytes);
+	}
+
+	bool ImageFile::WriteFile(const std::string& path, const std::vector<std::uint8_t>& bytes)
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return static_cast<bool>(file);
+	}
+
+	ImageDifference ImageFile::Compare(const Image& a, const Image& b, std::uint32_t tolerance)
+	{
+		ImageDifference difference;
+		difference.sameSize = a.width == b.width && a.height == b.height;
+		if (!difference.sameSize)
+		{
+			return difference;
+		}
+
+		const size_t pixelCount = static_cast<size_t>(a.width) * a.height;
+		std::uint64_t totalError = 0;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			std::uint32_t pixelError = 0;
+			for (size_t channel = 0; channel < 3; ++channel)
+			{
+				const int error = std::abs(a.pixels[i * 4 + channel] - b.pixels[i * 4 + channel]);
+				totalError += static_cast<std::uint32_t>(error);
+				pixelError = std::max(pixelError, static_cast<std::uint32_t>(error));
+			}
+			difference.maxError = std::max(difference.maxError, pixelError);
+			difference.pixelsOverTolerance += pixelError > tolerance ? 1 : 0;
+		}
+		difference.meanError = pixelCount > 0 ? static_cast<double>(totalError) / (pixelCount * 3) : 0;
+		return difference;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "Capture/Deflate.h"
+
+namespace renderer
+{
+	/** Pixels in the back buffer's format: rows from the top, four bytes per pixel as red, green, blue and alpha */
+	struct Image
+	{
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::vector<std::uint8_t> pixels;
+
+		void Resize(std::uint32_t newWidth, std::uint32_t newHeight);
+	};
+
+	/** How far two images of the same size are apart, over the colour channels */
+	struct ImageDifference
+	{
+		bool sameSize = false;
+		std::uint32_t maxError = 0;
+		double meanError = 0;
+		// Pixels with any channel further apart than the tolerance
+		std::uint64_t pixelsOverTolerance = 0;
+	};
+
+	enum class ImageFormat
+	{
+		Ppm,
+		Png
+	};
+
+	/**
+	 * Reads and writes images as binary PPM, which holds the colour channels as they are and can be opened or
+	 * diffed by most image tools, or as PNG, which is smaller and previews anywhere. Alpha is not stored, so
+	 * loaded images are opaque.
+	 */
+	class ImageFile
+	{
+	public:
+		static bool SavePpm(const std::string& path, const Image& image);
+		/** Reads 8 bit binary PPM files, as SavePpm writes them */
+		static bool LoadPpm(const std::string& path, Image& image);
+		static bool SavePng(const std::string& path, const Image& image, DeflateLevel level = DeflateLevel::Default);
+		/** Reads 8 bit RGB and RGBA PNG files that are not interlaced, which covers what SavePng and most tools write */
+		static bool LoadPng(const std::string& path, Image& image);
+		/** Appends the file contents of the image in the format to the output */
+		static void Encode(const Image& image, ImageFormat format, std::vector<std::uint8_t>& output, DeflateLevel level = DeflateLevel::Default);
+		static bool Save(const std::string& path, const Image& image, ImageFormat format, DeflateLevel level = DeflateLevel::Default);
+		/** Writes the bytes as the whole file */
+		static bool WriteFile(const std::string& path, const std::vector<std::uint8_t>& bytes);
+		/** Compares red, green and blue. Images of different sizes are reported as such and not compared */
+		static ImageDifference Compare(const Image& a, const Image& b, std::uint32_t tolerance = 0);
+	};
+}
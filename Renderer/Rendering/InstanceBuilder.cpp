@@ -0,0 +1,101 @@
+#include "InstanceBuilder.h"
+
+namespace renderer
+{
+	void InstanceBuilder::Cull(const std::vector<std::shared_ptr<Entity>>& entities, float localRadius, const ViewCuller& culler, MeshInstances& instances)
+	{
+		const size_t count = entities.size();
+		instances.bounds.Resize(count);
+		instances.masks.resize(count);
+		instances.viewCount = culler.GetViewCount();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Entity& e = *entities[i];
+			float maxScale = std::max(std::abs(e.scale.x), std::max(std::abs(e.scale.y), std::abs(e.scale.z)));
+			instances.bounds.Set(i, e.position, localRadius * maxScale);
+		}
+
+		culler.Cull(instances.bounds, instances.masks.data());
+	}
+
+	void InstanceBuilder::Build(const std::vector<std::shared_ptr<Entity>>& entities, MeshInstances& instances, LinearArena* arena)
+	{
+		const size_t count = entities.size();
+		const std::uint32_t viewCount = instances.viewCount;
+
+		// Count first so every array is allocated once at its final size, which an arena cannot do by growing
+		size_t visibleCount = 0;
+		std::array<size_t, ViewCuller::MaxViews> viewCounts = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const ViewMask mask = instances.masks[i];
+			visibleCount += mask != 0;
+			for (std::uint32_t v = 0; v < viewCount; ++v)
+			{
+				viewCounts[v] += (mask >> v) & 1;
+			}
+		}
+
+		PrepareFrameVector(instances.instanceData, arena, visibleCount);
+		PrepareFrameVector(instances.entities, arena, visibleCount);
+		instances.viewInstances.resize(viewCount);
+		for (std::uint32_t v = 0; v < viewCount; ++v)
+		{
+			PrepareFrameVector(instances.viewInstances[v], arena, viewCounts[v]);
+		}
+
+		// World matrices are only built for entities at least one view can see
+		for (size_t i = 0; i < count; ++i)
+		{
+			const ViewMask mask = instances.masks[i];
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			const std::uint32_t instanceIndex = static_cast<std::uint32_t>(instances.instanceData.size());
+			MeshInstanceData data;
+			// Rows and columns need to be swapped for the shader
+			data.world = XMMatrixTranspose(CalculateWorldMatrix(*entities[i]));
+			instances.instanceData.push_back(data);
+			instances.entities.push_back(entities[i].get());
+
+			for (std::uint32_t v = 0; v < viewCount; ++v)
+			{
+				if (mask & (1u << v))
+				{
+					instances.viewInstances[v].push_back(instanceIndex);
+				}
+			}
+		}
+
+		const BoundingSpheres& bounds = instances.bounds;
+		std::uint64_t bytes = GetCapacityBytes(bounds.x) + GetCapacityBytes(bounds.y) + GetCapacityBytes(bounds.z) +
+			GetCapacityBytes(bounds.radius) + GetCapacityBytes(instances.masks) + GetCapacityBytes(instances.viewInstances);
+		if (!arena)
+		{
+			bytes += GetCapacityBytes(instances.instanceData) + GetCapacityBytes(instances.entities);
+			for (const auto& viewInstances : instances.viewInstances)
+			{
+				bytes += GetCapacityBytes(viewInstances);
+			}
+		}
+		instances.memory.Set(bytes);
+	}
+
+	void InstanceBuilder::Build(const std::vector<std::shared_ptr<Entity>>& entities, float localRadius, const ViewCuller& culler, MeshInstances& instances, LinearArena* arena)
+	{
+		Cull(entities, localRadius, culler, instances);
+		Build(entities, instances, arena);
+	}
+
+	XMMATRIX InstanceBuilder::CalculateWorldMatrix(const Entity& e)
+	{
+		// Change from degrees to radians
+		float angleInRad = e.rotation.w * Math::DegToRad;
+		auto rotation = XMQuaternionRotationAxis(FV({ e.rotation.x, e.rotation.y, e.rotation.z }), angleInRad);
+		return XMMatrixScaling(e.scale.x, e.scale.y, e.scale.z) * XMMatrixRotationQuaternion(rotation) *
+			XMMatrixTranslation(e.position.x, e.position.y, e.position.z);
+	}
+}
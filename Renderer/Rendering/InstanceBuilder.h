@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "ShaderTypes.h"
+#include "Culling/ViewCuller.h"
+#include "Memory/FrameArena.h"
+
+namespace renderer
+{
+	/** Instance data for one mesh type. Built once per frame and shared by every view */
+	struct MeshInstances
+	{
+		// Transposed world matrices of the entities visible in at least one view
+		FrameVector<MeshInstanceData> instanceData;
+		// Entity drawn by each instance
+		FrameVector<const Entity*> entities;
+		// Indices into the instance data drawn by each view
+		std::vector<FrameVector<std::uint32_t>> viewInstances;
+		// World bounds and view visibility of every entity, kept between frames to avoid reallocating
+		BoundingSpheres bounds;
+		std::vector<ViewMask> masks;
+		std::uint32_t viewCount = 0;
+		// Heap memory of the arrays. What comes from a frame arena is accounted to the arena
+		TrackedMemory memory = TrackedMemory(MemoryTag::Instances);
+	};
+
+	/**
+	 * Culls entities against all views in one pass and builds the instance data of the visible ones.
+	 * The steps can run separately so more culling, such as occlusion, can clear view bits in between.
+	 */
+	class InstanceBuilder
+	{
+	public:
+		/** Computes the bounds of the entities and their visibility in every view */
+		static void Cull(const std::vector<std::shared_ptr<Entity>>& entities, float localRadius, const ViewCuller& culler, MeshInstances& instances);
+		/**
+		 * Builds the instance data of the entities left visible in at least one view. With an arena the
+		 * per-frame arrays are allocated from it, otherwise they reuse their heap memory from earlier builds.
+		 */
+		static void Build(const std::vector<std::shared_ptr<Entity>>& entities, MeshInstances& instances, LinearArena* arena = nullptr);
+		static void Build(const std::vector<std::shared_ptr<Entity>>& entities, float localRadius, const ViewCuller& culler, MeshInstances& instances, LinearArena* arena = nullptr);
+		static XMMATRIX CalculateWorldMatrix(const Entity& entity);
+	};
+}
@@ -0,0 +1,58 @@
+#include "LightPacker.h"
+
+namespace renderer
+{
+	SpotLight LightPacker::CreateDefaultSpotLight()
+	{
+		SpotLight light;
+		light.position = { 0, 3, -2 };
+		light.direction = VF3(XMVector3Normalize(FV({ 0, 1, 1 })));
+		light.range = 10;
+		light.cone = 1.0f;
+		light.attenuation = { 1.0f, 0.85f, 0.6f };
+		// White as requested
+		light.diffuse = { 1, 1, 1 };
+		light.specular = { 1, 1, 1 };
+		return light;
+	}
+
+	ShaderPointLight LightPacker::Pack(const PointLight& light)
+	{
+		ShaderPointLight packed;
+		packed.pos = light.position;
+		packed.range = light.range;
+		packed.att = light.attenuation;
+		packed.pad = 0;
+		const auto& d = light.diffuse;
+		packed.diffuse = { d.x, d.y, d.z, 1 };
+		const auto& s = light.specular;
+		packed.specular = { s.x, s.y, s.z, 1 };
+		return packed;
+	}
+
+	ShaderSpotLight LightPacker::Pack(const SpotLight& light)
+	{
+		ShaderSpotLight packed;
+		packed.pos = light.position;
+		packed.range = light.range;
+		packed.dir = light.direction;
+		packed.cone = light.cone;
+		packed.att = light.attenuation;
+		packed.pad = 0;
+		const auto& d = light.diffuse;
+		packed.diffuse = { d.x, d.y, d.z, 1 };
+		const auto& s = light.specular;
+		packed.specular = { s.x, s.y, s.z, 1 };
+		return packed;
+	}
+
+	size_t LightPacker::PackPointLights(const std::vector<std::shared_ptr<PointLight>>& lights, ShaderPointLight* destination, size_t capacity)
+	{
+		const size_t count = std::min(lights.size(), capacity);
+		for (size_t i = 0; i < count; ++i)
+		{
+			destination[i] = Pack(*lights[i]);
+		}
+		return count;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "ShaderTypes.h"
+
+namespace renderer
+{
+	/** Converts lights to the layouts the shaders read */
+	class LightPacker
+	{
+	public:
+		/** Point lights the pixel shader's light buffer holds */
+		static constexpr std::uint32_t MaxPointLights = 20;
+		/** Light added to every lit surface */
+		static constexpr float DefaultAmbient = 0.25f;
+
+		/** Spot light used until one is added, since the pixel shader always reads one */
+		static SpotLight CreateDefaultSpotLight();
+		static ShaderPointLight Pack(const PointLight& light);
+		static ShaderSpotLight Pack(const SpotLight& light);
+		/** Packs lights until the destination is full and returns how many were packed */
+		static size_t PackPointLights(const std::vector<std::shared_ptr<PointLight>>& lights, ShaderPointLight* destination, size_t capacity);
+	};
+}
@@ -0,0 +1,89 @@
+#include "MegaBuffer.h"
+#include "GraphicsManager.h"
+
+namespace renderer
+{
+	MegaBuffer::MegaBuffer(GraphicsManager* graphicsManager, std::uint32_t stride, BufferBinding binding, MemoryTag tag, std::uint32_t capacity)
+		: mGM(graphicsManager), mStride(stride), mBinding(binding), mTag(tag), mBuffer(nullptr),
+		mRanges(capacity, [this](std::uint32_t newCapacity, const std::vector<BufferRelocation>& moves) { Resize(newCapacity, moves); })
+	{
+		mBuffer = CreateBuffer(capacity);
+	}
+
+	MegaBuffer::~MegaBuffer()
+	{
+		mGM->ReleaseBuffer(mBuffer, mTag);
+	}
+
+	BufferRangeHandle MegaBuffer::Allocate(std::uint32_t count, const void* data)
+	{
+		const BufferRangeHandle handle = mRanges.Allocate(count);
+		if (handle != InvalidBufferRange && data)
+		{
+			Upload(handle, data, count);
+		}
+		return handle;
+	}
+
+	void MegaBuffer::Free(BufferRangeHandle handle)
+	{
+		mRanges.Free(handle);
+	}
+
+	bool MegaBuffer::Reserve(std::uint32_t count)
+	{
+		return mRanges.Reserve(count);
+	}
+
+	void MegaBuffer::Upload(BufferRangeHandle handle, const void* data, std::uint32_t count)
+	{
+		mGM->UpdateBufferRegion(mBuffer, mRanges.GetOffset(handle) * mStride, data, count * mStride);
+	}
+
+	std::uint32_t MegaBuffer::GetOffset(BufferRangeHandle handle) const
+	{
+		return mRanges.GetOffset(handle);
+	}
+
+	bool MegaBuffer::Compact()
+	{
+		return mRanges.Compact();
+	}
+
+	ID3D11Buffer* MegaBuffer::GetBuffer() const
+	{
+		return mBuffer;
+	}
+
+	std::uint32_t MegaBuffer::GetStride() const
+	{
+		return mStride;
+	}
+
+	OffsetAllocatorStats MegaBuffer::GetStats() const
+	{
+		return mRanges.GetStats();
+	}
+
+	ID3D11Buffer* MegaBuffer::CreateBuffer(std::uint32_t capacity)
+	{
+		BufferDesc desc;
+		// Zero sized buffers cannot be created
+		desc.size = std::max<std::uint32_t>(capacity, 1) * mStride;
+		desc.binding = mBinding;
+		desc.usage = BufferUsage::Default;
+		return mGM->CreateBuffer(desc, mTag);
+	}
+
+	void MegaBuffer::Resize(std::uint32_t capacity, const std::vector<BufferRelocation>& moves)
+	{
+		// Copied into a new buffer on the GPU since a region cannot be copied within the same buffer
+		ID3D11Buffer* buffer = CreateBuffer(capacity);
+		for (const BufferRelocation& move : moves)
+		{
+			mGM->CopyBufferRegion(buffer, move.to * mStride, mBuffer, move.from * mStride, move.count * mStride);
+		}
+		mGM->ReleaseBuffer(mBuffer, mTag);
+		mBuffer = buffer;
+	}
+}
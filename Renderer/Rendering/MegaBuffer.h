@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GraphicsBackend.h"
+#include "Memory/BufferSubAllocator.h"
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	class GraphicsManager;
+
+	/**
+	 * One GPU buffer shared by many meshes, so they can all be drawn with a single bind and told apart by their
+	 * offsets. Ranges are handed out by handle and the buffer is packed or grown on the GPU when a range does not
+	 * fit. Sizes and offsets are in elements of the stride.
+	 */
+	class MegaBuffer
+	{
+	public:
+		MegaBuffer(GraphicsManager* graphicsManager, std::uint32_t stride, BufferBinding binding, MemoryTag tag, std::uint32_t capacity);
+		~MegaBuffer();
+		MegaBuffer(const MegaBuffer&) = delete;
+		MegaBuffer& operator=(const MegaBuffer&) = delete;
+
+		/** Returns InvalidBufferRange if the buffer could not be grown. Data may be null to upload later */
+		BufferRangeHandle Allocate(std::uint32_t count, const void* data = nullptr);
+		void Free(BufferRangeHandle handle);
+		/** Makes room for count more elements before allocating many ranges */
+		bool Reserve(std::uint32_t count);
+		/** Uploads count elements to the start of the range */
+		void Upload(BufferRangeHandle handle, const void* data, std::uint32_t count);
+		std::uint32_t GetOffset(BufferRangeHandle handle) const;
+		bool Compact();
+
+		ID3D11Buffer* GetBuffer() const;
+		std::uint32_t GetStride() const;
+		OffsetAllocatorStats GetStats() const;
+
+	private:
+		ID3D11Buffer* CreateBuffer(std::uint32_t capacity);
+		void Resize(std::uint32_t capacity, const std::vector<BufferRelocation>& moves);
+
+		GraphicsManager* mGM;
+		std::uint32_t mStride;
+		BufferBinding mBinding;
+		MemoryTag mTag;
+		ID3D11Buffer* mBuffer;
+		BufferSubAllocator mRanges;
+	};
+}
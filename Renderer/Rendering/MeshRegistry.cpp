@@ -0,0 +1,173 @@
+#include "MeshRegistry.h"
+
+namespace renderer
+{
+	MeshRegistry::MeshRegistry()
+	{
+		for (MeshHandle mesh = 0; mesh < BuiltinMeshes::Count; ++mesh)
+		{
+			MeshGeometry geometry;
+			// Cubes are the only primitive with geometry so far, the others have handles for scenes to name them
+			if (mesh == BuiltinMeshes::Cube)
+			{
+				geometry.vertices = Cube::vertices;
+				geometry.indices = Cube::indices;
+				geometry.vertexCount = Cube::numVertices;
+				geometry.indexCount = Cube::numIndices;
+			}
+			mGeometry.push_back(geometry);
+			mBoundingRadii.push_back(GetBuiltinBoundingRadius(mesh));
+			mReferenceCounts.push_back(0);
+			mVersions.push_back(0);
+			mLoaded.push_back(true);
+			mVertices.emplace_back();
+			mIndices.emplace_back();
+			mMeshlets.emplace_back();
+		}
+		UpdateMemory();
+	}
+
+	float MeshRegistry::GetBuiltinBoundingRadius(MeshHandle mesh)
+	{
+		// Remaining primitives are unit sized around the origin
+		return mesh == BuiltinMeshes::Cube ? Cube::boundingRadius : 1.0f;
+	}
+
+	MeshHandle MeshRegistry::Register(std::vector<Vertex> vertices, std::vector<std::uint32_t> indices)
+	{
+		if (indices.size() % 3 != 0 || vertices.size() > 0xffffffff || indices.size() > 0xffffffff)
+		{
+			return InvalidMesh;
+		}
+		const auto vertexCount = static_cast<std::uint32_t>(vertices.size());
+		if (std::any_of(indices.begin(), indices.end(), [&](std::uint32_t index) { return index >= vertexCount; }))
+		{
+			return InvalidMesh;
+		}
+
+		MeshHandle mesh;
+		if (!mFreeHandles.empty())
+		{
+			mesh = mFreeHandles.back();
+			mFreeHandles.pop_back();
+		}
+		else if (mGeometry.size() < MaxMeshes)
+		{
+			mesh = static_cast<MeshHandle>(mGeometry.size());
+			mGeometry.emplace_back();
+			mBoundingRadii.push_back(0);
+			mReferenceCounts.push_back(0);
+			mVersions.push_back(0);
+			mLoaded.push_back(false);
+			mVertices.emplace_back();
+			mIndices.emplace_back();
+			mMeshlets.emplace_back();
+		}
+		else
+		{
+			return InvalidMesh;
+		}
+
+		float radiusSquared = 0;
+		for (const Vertex& vertex : vertices)
+		{
+			const XMFLOAT3& p = vertex.position;
+			radiusSquared = std::max(radiusSquared, p.x * p.x + p.y * p.y + p.z * p.z);
+		}
+
+		if (indices.size() / 3 >= MinMeshletTriangles)
+		{
+			MeshletCuller::Build(vertices.data(), vertexCount, indices, mMeshlets[mesh]);
+		}
+
+		// Moving the lists keeps their storage, so the geometry can point into them
+		mVertices[mesh] = std::move(vertices);
+		mIndices[mesh] = std::move(indices);
+		MeshGeometry& geometry = mGeometry[mesh];
+		geometry.vertices = mVertices[mesh].data();
+		geometry.indices = mIndices[mesh].data();
+		geometry.vertexCount = vertexCount;
+		geometry.indexCount = static_cast<std::uint32_t>(mIndices[mesh].size());
+		geometry.meshlets = mMeshlets[mesh].empty() ? nullptr : mMeshlets[mesh].data();
+		geometry.meshletCount = static_cast<std::uint32_t>(mMeshlets[mesh].size());
+		mBoundingRadii[mesh] = std::sqrt(radiusSquared);
+		mReferenceCounts[mesh] = 1;
+		++mVersions[mesh];
+		mLoaded[mesh] = true;
+		UpdateMemory();
+		return mesh;
+	}
+
+	void MeshRegistry::AddReference(MeshHandle mesh, std::uint32_t count)
+	{
+		mReferenceCounts[mesh] += count;
+	}
+
+	void MeshRegistry::Release(MeshHandle mesh, std::uint32_t count)
+	{
+		if (mesh >= mReferenceCounts.size())
+		{
+			return;
+		}
+		mReferenceCounts[mesh] -= std::min(count, mReferenceCounts[mesh]);
+		if (mReferenceCounts[mesh] == 0 && mesh >= BuiltinMeshes::Count && mLoaded[mesh])
+		{
+			Unload(mesh);
+		}
+	}
+
+	bool MeshRegistry::IsLoaded(MeshHandle mesh) const
+	{
+		return mesh < mLoaded.size() && mLoaded[mesh];
+	}
+
+	MeshHandle MeshRegistry::GetHandleCount() const
+	{
+		return static_cast<MeshHandle>(mGeometry.size());
+	}
+
+	const MeshGeometry& MeshRegistry::GetGeometry(MeshHandle mesh) const
+	{
+		return mGeometry[mesh];
+	}
+
+	float MeshRegistry::GetBoundingRadius(MeshHandle mesh) const
+	{
+		return mBoundingRadii[mesh];
+	}
+
+	std::uint32_t MeshRegistry::GetReferenceCount(MeshHandle mesh) const
+	{
+		return mReferenceCounts[mesh];
+	}
+
+	std::uint32_t MeshRegistry::GetVersion(MeshHandle mesh) const
+	{
+		return mVersions[mesh];
+	}
+
+	void MeshRegistry::Unload(MeshHandle mesh)
+	{
+		std::vector<Vertex>().swap(mVertices[mesh]);
+		std::vector<std::uint32_t>().swap(mIndices[mesh]);
+		std::vector<Meshlet>().swap(mMeshlets[mesh]);
+		mGeometry[mesh] = MeshGeometry();
+		mBoundingRadii[mesh] = 0;
+		++mVersions[mesh];
+		mLoaded[mesh] = false;
+		mFreeHandles.push_back(mesh);
+		UpdateMemory();
+	}
+
+	void MeshRegistry::UpdateMemory()
+	{
+		std::uint64_t bytes = GetCapacityBytes(mGeometry) + GetCapacityBytes(mBoundingRadii) + GetCapacityBytes(mReferenceCounts) +
+			GetCapacityBytes(mVersions) + mLoaded.capacity() / 8 + GetCapacityBytes(mVertices) + GetCapacityBytes(mIndices) +
+			GetCapacityBytes(mMeshlets) + GetCapacityBytes(mFreeHandles);
+		for (MeshHandle mesh = 0; mesh < mGeometry.size(); ++mesh)
+		{
+			bytes += GetCapacityBytes(mVertices[mesh]) + GetCapacityBytes(mIndices[mesh]) + GetCapacityBytes(mMeshlets[mesh]);
+		}
+		mMemory.Set(bytes);
+	}
+}
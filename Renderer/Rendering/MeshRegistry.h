@@ -0,0 +1,81 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "RenderQueue.h"
+#include "Culling/MeshletCuller.h"
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	/** Vertices and indices of a mesh in its local space */
+	struct MeshGeometry
+	{
+		const Vertex* vertices = nullptr;
+		const std::uint32_t* indices = nullptr;
+		std::uint32_t vertexCount = 0;
+		std::uint32_t indexCount = 0;
+		// Meshlets covering the indices in order, for meshes large enough to cull in parts
+		const Meshlet* meshlets = nullptr;
+		std::uint32_t meshletCount = 0;
+	};
+
+	/**
+	 * Geometry the renderer can draw, numbered by dense handles so everything kept per mesh lives in arrays
+	 * indexed by handle. Starts with the built-in primitives, of which only the cube has geometry so far, and
+	 * takes any indexed triangle mesh after that. Meshes are reference counted: the renderer holds one reference
+	 * per entity drawing a mesh, and a registered mesh is unloaded when its last reference is released. The
+	 * handles of unloaded meshes are given out again, with a new version so stale copies can be told apart.
+	 */
+	class MeshRegistry
+	{
+	public:
+		// Handles have to fit the mesh bits of a sort key, next to the one static batches use
+		static constexpr MeshHandle MaxMeshes = RenderQueue::StaticBatchMesh;
+		// Meshes with at least this many triangles are split into meshlets, smaller ones are only culled whole
+		static constexpr std::uint32_t MinMeshletTriangles = 1024;
+
+		MeshRegistry();
+
+		/** Bounding radius of a built-in mesh, for scene data that can only name those */
+		static float GetBuiltinBoundingRadius(MeshHandle mesh);
+
+		/**
+		 * Takes the geometry of a new mesh, with triangles in clockwise order, and returns its handle with one
+		 * reference held by the caller. Large meshes get meshlets, which reorders their triangles. Returns
+		 * InvalidMesh if an index is out of range, the index count is not a whole number of triangles or every
+		 * handle is taken
+		 */
+		MeshHandle Register(std::vector<Vertex> vertices, std::vector<std::uint32_t> indices);
+		void AddReference(MeshHandle mesh, std::uint32_t count = 1);
+		/** Drops references, unloading a registered mesh when none are left. Built-in meshes stay loaded and handles never given out are ignored */
+		void Release(MeshHandle mesh, std::uint32_t count = 1);
+
+		bool IsLoaded(MeshHandle mesh) const;
+		/** One past the highest handle given out, for sizing arrays indexed by handle */
+		MeshHandle GetHandleCount() const;
+		/** Geometry of the mesh, or none if it is a built-in without geometry */
+		const MeshGeometry& GetGeometry(MeshHandle mesh) const;
+		/** Radius of the sphere around the origin enclosing the unscaled mesh */
+		float GetBoundingRadius(MeshHandle mesh) const;
+		std::uint32_t GetReferenceCount(MeshHandle mesh) const;
+		/** Changes whenever the handle gets new geometry */
+		std::uint32_t GetVersion(MeshHandle mesh) const;
+
+	private:
+		void Unload(MeshHandle mesh);
+		void UpdateMemory();
+
+		// Per handle. The geometry points into the vertex and index lists, or at the static tables of a built-in
+		std::vector<MeshGeometry> mGeometry;
+		std::vector<float> mBoundingRadii;
+		std::vector<std::uint32_t> mReferenceCounts;
+		std::vector<std::uint32_t> mVersions;
+		std::vector<bool> mLoaded;
+		std::vector<std::vector<Vertex>> mVertices;
+		std::vector<std::vector<std::uint32_t>> mIndices;
+		std::vector<std::vector<Meshlet>> mMeshlets;
+		// Handles of unloaded meshes, reused before new ones are added
+		std::vector<MeshHandle> mFreeHandles;
+		TrackedMemory mMemory = TrackedMemory(MemoryTag::Meshes);
+	};
+}
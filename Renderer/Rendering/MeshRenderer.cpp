@@ -1,6 +1,8 @@
 #include "MeshRenderer.h"
 #include "GraphicsManager.h"
+#include "LightPacker.h"
 #include "Camera/Camera.h"
+#include "Profiling/Profiler.h"
 
 namespace renderer
 {
@@ -16,10 +18,12 @@ namespace renderer
     }
 
     MeshRenderer::MeshRenderer(GraphicsManager* graphicsManager)
+        : mStaticBatcher(mMeshRegistry)
     {
         mGM = graphicsManager;
+        mOcclusionCullingEnabled = false;
 
-        mSceneParams.ambient = 0.25f;
+        mSceneParams.ambient = LightPacker::DefaultAmbient;
         mSceneParams.camPos = XMFLOAT3(0, 0, 0);
         mSceneParams.ViewProj = XMMatrixTranspose(XMMatrixIdentity());
         mSceneParams.pad1 = 0;
@@ -29,419 +33,704 @@ namespace renderer
 
         // Create dummy spot light because one is required by the pixel shader
         // This would have been implemented better if not for time constraints
-        mSpotLight = std::make_shared<SpotLight>();
-        mSpotLight->position = { 0, 3, -2 };
-        mSpotLight->direction = VF3(XMVector3Normalize(FV({ 0, 1, 1 })));
-        mSpotLight->range = 10;
-        mSpotLight->cone = 1.0f;
-        mSpotLight->attenuation = { 1.0f, 0.85f, 0.6f };
-        // White as requested
-        mSpotLight->diffuse = { 1, 1, 1 };
-        mSpotLight->specular = { 1, 1, 1 };
+        mSpotLight = std::make_shared<SpotLight>(LightPacker::CreateDefaultSpotLight());
 
         LoadShaders();
+        CreatePipelineStates();
         CreateConstantBuffers();
         CreateStructuredBuffers();
+        CreateGeometryBuffers();
     }
 
     MeshRenderer::~MeshRenderer()
     {
         // Buffers
-        SAFE_RELEASE(mSceneConstantBuffer);
-        SAFE_RELEASE(mMaterialConstantBuffer);
-        SAFE_RELEASE(mSpotLightConstantBuffer);
-        mPointLightStructuredBuffer.Release();
+        mGM->ReleaseBuffer(mSceneConstantBuffer, MemoryTag::Constants);
+        mGM->ReleaseBuffer(mMaterialConstantBuffer, MemoryTag::Constants);
+        mGM->ReleaseBuffer(mSpotLightConstantBuffer, MemoryTag::Lights);
+        mGM->GetBackend()->ReleaseBufferView(mPointLightStructuredBuffer.shaderResourceView);
+        mGM->ReleaseBuffer(mPointLightStructuredBuffer.buffer, MemoryTag::Lights);
       
         DeleteMeshBuffers();
+        mVertexBuffer.reset();
+        mIndexBuffer.reset();
+        mInstanceBuffer.reset();
         
         //Shaders
-        SAFE_RELEASE(mBaseVertexShader);
-        SAFE_RELEASE(mBaseVertexLayout);
-        SAFE_RELEASE(mBasePixelShader);
+        mGM->GetBackend()->ReleaseShaders(mBaseShaders);
 
         mMeshRenderer = nullptr;
     }
 
     // Note: This is just a forward renderer. Unfortunately due to time I couldn't implement defferred renderer
-    void MeshRenderer::Render(double frameTime, const Camera* camera)
+    void MeshRenderer::Render(double frameTime, const std::vector<RenderView>& views)
     {
-        if (mMeshTypeEntitiesMap.empty())
+        PROFILE_ZONE("MeshRenderer::Render");
+
+        // Clear the backbuffer with black background colour and refresh the Depth/Stencil view
+        float backgroundColour[4] = { 0, 0, 0, 1 };
+        mGM->ClearBackBuffer(backgroundColour);
+
+        // A frame with nothing to draw is still presented, so the window shows it and a capture requested for it completes
+        if ((mSceneEntities.activeMeshes.empty() && mStaticBatcher.GetChunks().empty()) || views.empty())
         {
+            mGM->Present();
             return;
         }
 
-        UpdateConstantBuffers(camera);
+        // What the arena handed out two frames ago is no longer referenced
+        mFrameArena.BeginFrame();
+
+        UpdateConstantBuffers();
         UpdateStructuredBuffers();
 
-        for (auto meshType : mInstanceBuffersToCreate)
+        // Only grows when meshes were registered since the last frame
+        const MeshHandle meshCount = mMeshRegistry.GetHandleCount();
+        if (mMeshBuffers.size() < meshCount)
+        {
+            mMeshBuffers.resize(meshCount);
+            mMeshInstances.resize(meshCount);
+        }
+        for (MeshHandle mesh : mSceneEntities.newMeshes)
         {
-            CreateMeshBuffers(meshType);
+            CreateMeshBuffers(mesh);
         }
-        mInstanceBuffersToCreate.clear();
+        mSceneEntities.ClearNewMeshes();
+        UpdateStaticBatches();
 
+        CullEntities(views);
         UpdateMeshInstanceBuffers();
 
-        // Clear the backbuffer with black background colour
-        float backgroundColour[4] = { 0, 0, 0, 1 };
-        mGM->mDeviceContext->ClearRenderTargetView(mGM->mRenderTargetView, backgroundColour);
+        // Sized for last frame's materials so numbering them does not rehash
+        const size_t materialCount = mMaterialIds.size();
+        mMaterialIds = FrameMap<const Material*, std::uint32_t>(&mFrameArena.GetArena());
+        mMaterialIds.reserve(materialCount);
 
-        // Refresh the Depth/Stencil view
-        mGM->mDeviceContext->ClearDepthStencilView(mGM->mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        // Binds go through the state tracker so the ones that match the last frame are dropped
+        StateTracker& stateTracker = mGM->GetStateTracker();
 
         // Set Render Target and bind depth stencil view to OM stage of pipeline.
-        mGM->mDeviceContext->OMSetRenderTargets(1, &mGM->mRenderTargetView, mGM->mDepthStencilView);
-
-        // Set vertex shader and input layout
-        mGM->mDeviceContext->VSSetShader(mBaseVertexShader, 0, 0);
-        mGM->mDeviceContext->IASetInputLayout(mBaseVertexLayout);
+        ID3D11RenderTargetView* renderTarget = mGM->GetBackBuffer();
+        stateTracker.SetRenderTargets(1, &renderTarget, mGM->GetDepthStencil());
 
-        // Set pixel shader
-        mGM->mDeviceContext->PSSetShader(mBasePixelShader, 0, 0);
+        // Shaders, input layout and fixed function state
+        mGM->SetPipelineState(mBasePipelineState);
 
         // Pixel shader uses all 3 while vertex shader uses scene only 
         ID3D11Buffer* buffers[3] = { mSceneConstantBuffer, mSpotLightConstantBuffer, mMaterialConstantBuffer };
-        mGM->mDeviceContext->VSSetConstantBuffers(0, 1, &mSceneConstantBuffer);
-        mGM->mDeviceContext->PSSetConstantBuffers(0, 3, buffers);
+        stateTracker.SetVSConstantBuffers(0, 1, &mSceneConstantBuffer);
+        stateTracker.SetPSConstantBuffers(0, 3, buffers);
 
         // Set shader resources
         ID3D11ShaderResourceView* resources[1] = { mPointLightStructuredBuffer.shaderResourceView };
-        mGM->mDeviceContext->PSSetShaderResources(0, 1, resources);
+        stateTracker.SetPSShaderResources(0, 1, resources);
+
+        // Draw meshes for each view into its part of the back buffer
+        for (std::uint32_t viewIndex = 0; viewIndex < mViewCuller.GetViewCount(); ++viewIndex)
+        {
+            const RenderView& view = views[viewIndex];
+
+            mGM->SetViewport(view.viewport);
 
-        mGM->EnableClockwiseCulling();
+            UpdateSceneConstantBuffer(view.camera);
 
-        // Draw meshes
-        DrawMeshes();
+            DrawMeshes(viewIndex, *view.camera);
+        }
 
         // Present the backbuffer to the screen
-        mGM->mSwapChain->Present(0, 0);
+        mGM->Present();
     }
 
-    void MeshRenderer::DrawMeshes()
+    void MeshRenderer::BuildRenderQueue(std::uint32_t viewIndex, const Camera& camera)
     {
-        for (const auto& keyValue : mMeshTypeEntitiesMap)
+        mRenderQueue.Clear();
+
+        // Depth along the camera's forward axis is the third column of the view matrix
+        const XMFLOAT4X4& view = camera.GetMatrices().view;
+        for (MeshHandle mesh : mSceneEntities.activeMeshes)
+        {
+            const auto& instances = mMeshInstances[mesh];
+            if (viewIndex >= instances.viewInstances.size())
+            {
+                continue;
+            }
+
+            for (std::uint32_t instanceIndex : instances.viewInstances[viewIndex])
+            {
+                const Entity* entity = instances.entities[instanceIndex];
+                const XMFLOAT3& p = entity->position;
+                float depth = p.x * view.m[0][2] + p.y * view.m[1][2] + p.z * view.m[2][2] + view.m[3][2];
+                SortKey key = RenderQueue::MakeKey(RenderPass::Opaque, mesh, GetMaterialId(entity->material.get()), depth);
+                mRenderQueue.Push(key, instanceIndex);
+            }
+        }
+
+        // Static chunks are queued as a whole, sorted by the depth of their centre
+        const auto& chunks = mStaticBatcher.GetChunks();
+        const BoundingSpheres& chunkBounds = mStaticBatcher.GetBounds();
+        const ViewMask viewBit = 1u << viewIndex;
+        for (std::uint32_t chunkIndex = 0; chunkIndex < mStaticMasks.size(); ++chunkIndex)
         {
-            const auto& buffers = mMeshTypeDataMap[keyValue.first];
-            DrawMeshes(buffers, keyValue.second);
+            if (mStaticMasks[chunkIndex] & viewBit)
+            {
+                float depth = chunkBounds.x[chunkIndex] * view.m[0][2] + chunkBounds.y[chunkIndex] * view.m[1][2] +
+                    chunkBounds.z[chunkIndex] * view.m[2][2] + view.m[3][2];
+                SortKey key = RenderQueue::MakeKey(RenderPass::Opaque, RenderQueue::StaticBatchMesh, GetMaterialId(chunks[chunkIndex].material), depth);
+                mRenderQueue.Push(key, chunkIndex);
+            }
         }
+
+        mRenderQueue.Sort(0, &mFrameArena.GetArena());
     }
 
-    void MeshRenderer::DrawMeshes(const MeshBuffers& buffers, const std::vector<std::shared_ptr<Entity>>& entities)
+    void MeshRenderer::DrawMeshes(std::uint32_t viewIndex, const Camera& camera)
     {
-        // Bind vertex and instance buffer for this mesh type
-        ID3D11Buffer* vertexBuffers[2] = { buffers.vertexBuffer, buffers.instanceBuffer };
-        UINT strides[2] = { sizeof(Vertex) , sizeof(MeshInstanceData) };
-        UINT offsets[2] = { 0, 0 };
-        mGM->mDeviceContext->IASetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+        PROFILE_ZONE("MeshRenderer::DrawMeshes");
+        BuildRenderQueue(viewIndex, camera);
+        // Before binding, since growing the meshlet range can replace the index buffer
+        CullMeshlets(camera);
+
+        // Every mesh lives in the shared buffers so they are bound once and draws only change offsets
+        BindMeshBuffers();
+
+        // Draws come sorted by mesh then material so materials are only set when they change
+        const MeshBuffers* buffers = nullptr;
+        const MeshInstances* instances = nullptr;
+        const Material* boundMaterial = nullptr;
+        std::uint32_t boundMesh = ~0u;
+        bool boundMeshlets = false;
+        const MeshletRange* meshletRange = mMeshletRanges.data();
+        const std::uint32_t meshletIndexOffset = mMeshletIndexRange != InvalidBufferRange ? mIndexBuffer->GetOffset(mMeshletIndexRange) : 0;
+        std::uint32_t indexOffset = 0;
+        std::int32_t vertexOffset = 0;
+        std::uint32_t instanceOffset = 0;
+        // Counted locally so the shared counters are only touched once per view
+        std::uint64_t drawCalls = 0;
+        std::uint64_t triangles = 0;
+        std::uint64_t materialUpdates = 0;
+        auto setMaterial = [&](const Material* material)
+        {
+            // This could be optimized by passing materials in a structured buffer
+            // and drawing all instances at the same time
+            if (material != boundMaterial)
+            {
+                mGM->UpdateBuffer(mMaterialConstantBuffer, material);
+                boundMaterial = material;
+                ++materialUpdates;
+            }
+        };
+        const auto& chunks = mStaticBatcher.GetChunks();
+        for (const RenderItem& item : mRenderQueue.GetItems())
+        {
+            const std::uint32_t mesh = RenderQueue::GetMesh(item.key);
+            if (mesh == RenderQueue::StaticBatchMesh)
+            {
+                // Chunks are pre-transformed so each has its own ranges and is drawn with the identity transform
+                const MeshBuffers& chunkBuffers = mStaticChunkBuffers[item.instance];
+                setMaterial(chunks[item.instance].material);
+                mGM->DrawIndexedInstanced(chunkBuffers.indexCount, 1, mIndexBuffer->GetOffset(chunkBuffers.indices),
+                    static_cast<std::int32_t>(mVertexBuffer->GetOffset(chunkBuffers.vertices)), mInstanceBuffer->GetOffset(mIdentityInstance));
+                ++drawCalls;
+                triangles += chunkBuffers.indexCount / 3;
+                continue;
+            }
+
+            if (mesh != boundMesh)
+            {
+                buffers = &mMeshBuffers[mesh];
+                instances = &mMeshInstances[mesh];
+                if (buffers->indexCount > 0)
+                {
+                    indexOffset = mIndexBuffer->GetOffset(buffers->indices);
+                    vertexOffset = static_cast<std::int32_t>(mVertexBuffer->GetOffset(buffers->vertices));
+                    instanceOffset = mInstanceBuffer->GetOffset(buffers->instances);
+                }
+                boundMesh = mesh;
+                boundMeshlets = mMeshRegistry.GetGeometry(mesh).meshletCount > 0;
+            }
+            // Meshes without geometry have nothing to draw
+            if (buffers->indexCount == 0)
+            {
+                continue;
+            }
+
+            // Meshlet meshes draw the triangles that survived culling, unless the stream had no room
+            std::uint32_t drawIndexOffset = indexOffset;
+            std::uint32_t drawIndexCount = buffers->indexCount;
+            if (boundMeshlets)
+            {
+                const MeshletRange& range = *meshletRange++;
+                if (range.count == 0)
+                {
+                    continue;
+                }
+                if (mMeshletIndexRange != InvalidBufferRange)
+                {
+                    drawIndexOffset = meshletIndexOffset + range.first;
+                    drawIndexCount = range.count;
+                }
+            }
+
+            setMaterial(instances->entities[item.instance]->material.get());
+            mGM->DrawIndexedInstanced(drawIndexCount, 1, drawIndexOffset, vertexOffset, instanceOffset + item.instance);
+            ++drawCalls;
+            triangles += drawIndexCount / 3;
+        }
 
-        // Bind index buffer
-        mGM->mDeviceContext->IASetIndexBuffer(buffers.indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+        auto& counters = mGM->GetCounters();
+        counters.Add(RenderCounter::DrawCalls, drawCalls);
+        counters.Add(RenderCounter::Instances, drawCalls);
+        counters.Add(RenderCounter::Triangles, triangles);
+        counters.Add(RenderCounter::MaterialUpdates, materialUpdates);
+        counters.Add(RenderCounter::ConstantBufferUpdates, materialUpdates);
+    }
 
-        // This could be optimized by passing materials in a structured buffer
-        // and drawing all instances at the same time
-        for (int i = 0; i < entities.size(); ++i)
+    void MeshRenderer::CullMeshlets(const Camera& camera)
+    {
+        PROFILE_ZONE("MeshRenderer::CullMeshlets");
+        mMeshletIndices.clear();
+        mMeshletRanges.clear();
+        mMeshletCuller.Begin(camera);
+        for (const RenderItem& item : mRenderQueue.GetItems())
         {
-            const auto& entity = entities[i];
-            // Update material constant buffer with entity material properties
-            mGM->UpdateBuffer(mMaterialConstantBuffer, entity->material.get());
+            const std::uint32_t mesh = RenderQueue::GetMesh(item.key);
+            if (mesh == RenderQueue::StaticBatchMesh || mMeshBuffers[mesh].indexCount == 0)
+            {
+                continue;
+            }
+            const MeshGeometry& geometry = mMeshRegistry.GetGeometry(mesh);
+            if (geometry.meshletCount == 0)
+            {
+                continue;
+            }
+
+            // Instance data holds the transposed world matrix the shader takes
+            const XMMATRIX world = XMMatrixTranspose(mMeshInstances[mesh].instanceData[item.instance].world);
+            MeshletRange range;
+            range.first = static_cast<std::uint32_t>(mMeshletIndices.size());
+            range.count = mMeshletCuller.Cull(geometry.meshlets, geometry.meshletCount, geometry.indices, world, mMeshletIndices);
+            mMeshletRanges.push_back(range);
+        }
+
+        const MeshletCullStats& stats = mMeshletCuller.GetStats();
+        auto& counters = mGM->GetCounters();
+        counters.Add(RenderCounter::MeshletsTested, stats.meshlets);
+        counters.Add(RenderCounter::MeshletsCulled, stats.frustumCulled + stats.backfaceCulled);
+        counters.Add(RenderCounter::MeshletTrianglesCulled, stats.trianglesCulled);
+        counters.Add(RenderCounter::MeshletCullNanoseconds, static_cast<std::uint64_t>(stats.passMicroseconds * 1000));
+        if (mMeshletIndices.empty())
+        {
+            return;
+        }
 
-            mGM->mDeviceContext->DrawIndexedInstanced(buffers.indexCount, 1, 0, 0, i);
+        const auto indexCount = static_cast<std::uint32_t>(mMeshletIndices.size());
+        if (indexCount > mMeshletIndexCapacity)
+        {
+            mIndexBuffer->Free(mMeshletIndexRange);
+            mMeshletIndexCapacity = std::max(indexCount, mMeshletIndexCapacity * 2);
+            mMeshletIndexRange = mIndexBuffer->Allocate(mMeshletIndexCapacity);
+            if (mMeshletIndexRange == InvalidBufferRange)
+            {
+                mMeshletIndexCapacity = 0;
+                return;
+            }
         }
+        mIndexBuffer->Upload(mMeshletIndexRange, mMeshletIndices.data(), indexCount);
+    }
+
+    void MeshRenderer::BindMeshBuffers()
+    {
+        // Bind the shared vertex and instance buffers
+        ID3D11Buffer* vertexBuffers[2] = { mVertexBuffer->GetBuffer(), mInstanceBuffer->GetBuffer() };
+        std::uint32_t strides[2] = { sizeof(Vertex) , sizeof(MeshInstanceData) };
+        std::uint32_t offsets[2] = { 0, 0 };
+        mGM->GetStateTracker().SetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+
+        // Bind the shared index buffer
+        mGM->GetStateTracker().SetIndexBuffer(mIndexBuffer->GetBuffer(), IndexFormat, 0);
+    }
+
+    std::uint32_t MeshRenderer::GetMaterialId(const Material* material)
+    {
+        // Ids past the key's material bits wrap, which only makes the grouping less exact
+        auto result = mMaterialIds.emplace(material, static_cast<std::uint32_t>(mMaterialIds.size()));
+        return result.first->second;
     }
 
-    void MeshRenderer::UpdateConstantBuffers(const Camera* camera)
+    void MeshRenderer::UpdateSceneConstantBuffer(const Camera* camera)
     {
-        // Scene params
         mSceneParams.camPos = camera->GetPosition();
         mSceneParams.ViewProj = XMMatrixTranspose(camera->GetViewProjection());
         mSceneParams.pointLightCount = mPointLights.size();
         mGM->UpdateBuffer(mSceneConstantBuffer, &mSceneParams);
+        mGM->GetCounters().Add(RenderCounter::ConstantBufferUpdates, 1);
+    }
 
+    void MeshRenderer::UpdateConstantBuffers()
+    {
         // Spot light
-        ShaderSpotLight shaderSpotLight;
-        shaderSpotLight.pos = mSpotLight->position;
-        shaderSpotLight.range = mSpotLight->range;
-        shaderSpotLight.dir = mSpotLight->direction;
-        shaderSpotLight.cone = mSpotLight->cone;
-        shaderSpotLight.att = mSpotLight->attenuation;
-        shaderSpotLight.pad = 0;
-        const auto& d = mSpotLight->diffuse;
-        shaderSpotLight.diffuse = { d.x, d.y, d.z, 1 };
-        const auto& s = mSpotLight->specular;
-        shaderSpotLight.specular = { s.x, s.y, s.z, 1 };
+        ShaderSpotLight shaderSpotLight = LightPacker::Pack(*mSpotLight);
         mGM->UpdateBuffer(mSpotLightConstantBuffer, &shaderSpotLight);
+        mGM->GetCounters().Add(RenderCounter::ConstantBufferUpdates, 1);
+        mGM->GetCounters().Add(RenderCounter::LightsUploaded, 1);
     }
 
     void MeshRenderer::UpdateStructuredBuffers()
     {
+        PROFILE_ZONE("MeshRenderer::UpdateStructuredBuffers");
         if (mPointLights.empty())
         {
             return;
         }
-        std::vector<ShaderPointLight> lights(MaxPointLightsAllowed);
-        for (int i = 0; i < mPointLights.size(); ++i)
+        mPackedPointLights.resize(MaxPointLightsAllowed);
+        mPackedPointLightMemory.Set(GetCapacityBytes(mPackedPointLights));
+        const size_t packed = LightPacker::PackPointLights(mPointLights, mPackedPointLights.data(), mPackedPointLights.size());
+        mGM->UpdateBuffer(mPointLightStructuredBuffer.buffer, mPackedPointLights.data());
+        mGM->GetCounters().Add(RenderCounter::LightsUploaded, packed);
+    }
+
+    void MeshRenderer::CullEntities(const std::vector<RenderView>& views)
+    {
+        PROFILE_ZONE("MeshRenderer::CullEntities");
+        // Visibility for every view is computed together so the instance data is only built once
+        mViewFrustums.resize(views.size());
+        for (size_t i = 0; i < views.size(); ++i)
         {
-            lights[i].pos = mPointLights[i]->position;
-            lights[i].range = mPointLights[i]->range;
-            lights[i].att = mPointLights[i]->attenuation;
-            lights[i].pad = 0;
-            const auto& d = mPointLights[i]->diffuse;
-            lights[i].diffuse = { d.x, d.y, d.z, 1 };
-            const auto& s = mPointLights[i]->specular;
-            lights[i].specular = { s.x, s.y, s.z, 1 };
+            mViewFrustums[i] = views[i].camera->GetFrustum();
+        }
+        mViewCuller.SetViews(mViewFrustums.data(), static_cast<std::uint32_t>(views.size()));
+
+        for (MeshHandle mesh : mSceneEntities.activeMeshes)
+        {
+            InstanceBuilder::Cull(mSceneEntities.meshEntities[mesh], mMeshRegistry.GetBoundingRadius(mesh), mViewCuller, mMeshInstances[mesh]);
+        }
+
+        CullStaticChunks();
+
+        if (mOcclusionCullingEnabled)
+        {
+            CullOccludedEntities(*views[0].camera);
         }
-        mGM->UpdateBuffer(mPointLightStructuredBuffer.buffer, lights.data());
     }
 
-    void MeshRenderer::UpdateMeshInstanceBuffers()
+    void MeshRenderer::CullStaticChunks()
     {
-        auto iter = mMeshTypeEntitiesMap.begin();
-        while (iter != mMeshTypeEntitiesMap.end())
+        // Chunks are only frustum culled. Occlusion culling tests entities, not whole chunks
+        const auto& chunks = mStaticBatcher.GetChunks();
+        mStaticMasks.resize(chunks.size());
+        if (chunks.empty())
+        {
+            return;
+        }
+        mViewCuller.Cull(mStaticBatcher.GetBounds(), mStaticMasks.data());
+
+        std::uint64_t visibleChunks = 0;
+        std::uint64_t visibleEntities = 0;
+        std::uint64_t culledEntities = 0;
+        for (size_t i = 0; i < chunks.size(); ++i)
         {
-            // Deal with case where entities were removed. Note I had no time to add remove entity functions
-            if (iter->second.empty())
+            // Chunks that could not be uploaded are never drawn
+            if (mStaticMasks[i] != 0 && mStaticChunkBuffers[i].indexCount > 0)
             {
-                mMeshTypeDataMap[iter->first].Release();
-                mMeshTypeDataMap.erase(iter->first);
-                iter = mMeshTypeEntitiesMap.erase(iter);
-                continue;
+                ++visibleChunks;
+                visibleEntities += chunks[i].entities.size();
+            }
+            else
+            {
+                mStaticMasks[i] = 0;
+                culledEntities += chunks[i].entities.size();
             }
-            UpdateMeshInstanceBuffer(iter->first);
-            ++iter;
         }
+        auto& counters = mGM->GetCounters();
+        counters.Add(RenderCounter::StaticChunksVisible, visibleChunks);
+        counters.Add(RenderCounter::EntitiesVisible, visibleEntities);
+        counters.Add(RenderCounter::EntitiesCulled, culledEntities);
     }
 
-    // ** Update the instance buffers with the new world transforms */
-    void MeshRenderer::UpdateMeshInstanceBuffer(MeshType meshType)
+    void MeshRenderer::UpdateStaticBatches()
     {
-        const auto& entities = mMeshTypeEntitiesMap[meshType];
-        std::vector<MeshInstanceData> instanceData(entities.size());
-        for (int i = 0; i < entities.size(); ++i)
+        if (!mStaticBatcher.HasChanges())
         {
-            const auto& e = entities[i];
-            auto& data = instanceData[i];
-            // Change from degrees to radians
-            float angleInRad = e->rotation.w * Math::DegToRad;
-            auto rotation = XMQuaternionRotationAxis(FV({ e->rotation.x, e->rotation.y, e->rotation.z }), angleInRad);
-            auto world = XMMatrixScaling(e->scale.x, e->scale.y, e->scale.z) * XMMatrixRotationQuaternion(rotation) * 
-                XMMatrixTranslation(e->position.x, e->position.y, e->position.z);
-            // Rows and columns need to be swapped for the shader
-            data.world = XMMatrixTranspose(world);
+            return;
+        }
+        PROFILE_ZONE("MeshRenderer::UpdateStaticBatches");
+        mStaticBatcher.Build();
+
+        // Rebuilt chunks get new ranges since their size may have changed
+        const auto& chunks = mStaticBatcher.GetChunks();
+        mStaticChunkBuffers.resize(chunks.size());
+        // Room for every rebuilt chunk is made first so a big build grows the buffers once
+        std::uint64_t vertexCount = 0;
+        std::uint64_t indexCount = 0;
+        for (std::uint32_t chunkIndex : mStaticBatcher.GetRebuiltChunks())
+        {
+            vertexCount += chunks[chunkIndex].vertexCount;
+            indexCount += chunks[chunkIndex].indexCount;
+        }
+        mVertexBuffer->Reserve(static_cast<std::uint32_t>(std::min<std::uint64_t>(vertexCount, 0xffffffff)));
+        mIndexBuffer->Reserve(static_cast<std::uint32_t>(std::min<std::uint64_t>(indexCount, 0xffffffff)));
+        for (std::uint32_t chunkIndex : mStaticBatcher.GetRebuiltChunks())
+        {
+            const StaticChunk& chunk = chunks[chunkIndex];
+            MeshBuffers& buffers = mStaticChunkBuffers[chunkIndex];
+            ReleaseMeshBuffers(buffers);
+            buffers.vertices = mVertexBuffer->Allocate(chunk.vertexCount, chunk.vertices.data());
+            buffers.indices = mIndexBuffer->Allocate(chunk.indexCount, chunk.indices.data());
+            if (buffers.vertices == InvalidBufferRange || buffers.indices == InvalidBufferRange)
+            {
+                ReleaseMeshBuffers(buffers);
+                continue;
+            }
+            buffers.vertexCount = chunk.vertexCount;
+            buffers.indexCount = chunk.indexCount;
         }
-        auto& meshBuffers = mMeshTypeDataMap[meshType];
-        mGM->UpdateBuffer(meshBuffers.instanceBuffer, instanceData.data());
+        mGM->GetCounters().Add(RenderCounter::StaticChunksRebuilt, mStaticBatcher.GetRebuiltChunks().size());
+        // The geometry is on the GPU now, so only the member lists are kept
+        mStaticBatcher.ReleaseRebuiltGeometry();
     }
 
-    void MeshRenderer::LoadShaders()
+    void MeshRenderer::CullOccludedEntities(const Camera& camera)
     {
-        // Base vertex shader
+        const ViewMask viewBit = 1;
+        mOcclusionCuller.Begin(camera);
+
+        // Cubes in the first view are the occluders because their bounds are exact enough to rasterize
+        if (BuiltinMeshes::Cube < mSceneEntities.meshEntities.size())
         {
-            D3D11_INPUT_ELEMENT_DESC vertexLayout[] =
-            {
-                // Data for the vertex buffer
-                { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "NORMAL",	 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-
-                // Data for the instance buffer
-                { "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
-                { "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
-                { "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
-                { "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
-            };
-
-            UINT numElements = ARRAYSIZE(vertexLayout);
-
-            ID3D10Blob* shaderBuffer = nullptr;
-            ID3D10Blob* errors = nullptr;
-            HRESULT hr = D3DCompileFromFile(L"../../Renderer/Shaders/BaseVS.hlsl", 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "vs_5_0", 0, 0, &shaderBuffer, &errors);
-            if (FAILED(hr))
-            {
-                MessageBox(NULL, L"D3DCompileFromFile failed with BaseVS.hlsl.",
-                    L"Error", MB_OK | MB_ICONERROR);
-                SAFE_RELEASE(shaderBuffer);
-                return;
-            }
-            hr = mGM->mDevice->CreateVertexShader(shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), nullptr, &mBaseVertexShader);
-            hr = mGM->mDevice->CreateInputLayout(vertexLayout, numElements, shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), &mBaseVertexLayout); 
-            if (FAILED(hr))
+            const auto& cubes = mSceneEntities.meshEntities[BuiltinMeshes::Cube];
+            const auto& instances = mMeshInstances[BuiltinMeshes::Cube];
+            for (size_t i = 0; i < cubes.size(); ++i)
             {
-                MessageBox(NULL, L"CreateInputLayout failed for BaseVS.hlsl.",
-                    L"Error", MB_OK | MB_ICONERROR);
-                SAFE_RELEASE(shaderBuffer);
-                return;
+                if (instances.masks[i] & viewBit)
+                {
+                    const auto& bounds = instances.bounds;
+                    mOcclusionCuller.AddOccluderCandidate(cubes[i].get(), XMFLOAT3(bounds.x[i], bounds.y[i], bounds.z[i]), bounds.radius[i]);
+                }
             }
-            SAFE_RELEASE(shaderBuffer);
         }
+        mOcclusionCuller.RasterizeOccluders();
+
+        for (MeshHandle mesh : mSceneEntities.activeMeshes)
+        {
+            auto& instances = mMeshInstances[mesh];
+            mOcclusionCuller.Cull(instances.bounds, viewBit, instances.masks.data());
+        }
+        mGM->GetCounters().Add(RenderCounter::EntitiesOccluded, mOcclusionCuller.GetStats().culled);
+    }
 
-        // Base pixel shader
+    void MeshRenderer::UpdateMeshInstanceBuffers()
+    {
+        PROFILE_ZONE("MeshRenderer::UpdateMeshInstanceBuffers");
+        size_t index = 0;
+        while (index < mSceneEntities.activeMeshes.size())
         {
-            ID3D10Blob* shaderBuffer = nullptr;
-            ID3D10Blob* errors = nullptr;
-            HRESULT hr = D3DCompileFromFile(L"../../Renderer/Shaders/BasePS.hlsl", 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "ps_5_0", 0, 0, &shaderBuffer, &errors);
-            if (FAILED(hr))
+            // Meshes whose entities were all removed give back their ranges. Deactivating moves the last active
+            // mesh into this slot, so the index is not advanced
+            const MeshHandle mesh = mSceneEntities.activeMeshes[index];
+            if (mSceneEntities.meshEntities[mesh].empty())
             {
-                MessageBox(NULL, L"D3DCompileFromFile failed with BasePS.hlsl.",
-                    L"Error", MB_OK | MB_ICONERROR);
-                SAFE_RELEASE(shaderBuffer);
-                return;
+                ReleaseMeshBuffers(mMeshBuffers[mesh]);
+                mMeshInstances[mesh] = MeshInstances();
+                mSceneEntities.Deactivate(mesh);
+                continue;
             }
-            hr = mGM->mDevice->CreatePixelShader(shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), nullptr, &mBasePixelShader);
-            SAFE_RELEASE(shaderBuffer)
+            UpdateMeshInstanceBuffer(mesh);
+            ++index;
+        }
+    }
+
+    // ** Update the instance buffers with the world transforms of entities visible in any view */
+    void MeshRenderer::UpdateMeshInstanceBuffer(MeshHandle mesh)
+    {
+        const auto& entities = mSceneEntities.meshEntities[mesh];
+        auto& instances = mMeshInstances[mesh];
+        InstanceBuilder::Build(entities, instances, &mFrameArena.GetArena());
+        const std::uint64_t visible = instances.instanceData.size();
+        mGM->GetCounters().Add(RenderCounter::EntitiesVisible, visible);
+        mGM->GetCounters().Add(RenderCounter::EntitiesCulled, entities.size() - visible);
+        // Meshes without geometry have no instance range
+        auto& meshBuffers = mMeshBuffers[mesh];
+        if (instances.instanceData.empty() || meshBuffers.instances == InvalidBufferRange)
+        {
+            return;
+        }
+
+        // The range is sized for every entity but only the visible ones are uploaded
+        mInstanceBuffer->Upload(meshBuffers.instances, instances.instanceData.data(), static_cast<std::uint32_t>(visible));
+    }
+
+    void MeshRenderer::LoadShaders()
+    {
+        const VertexElement vertexLayout[] =
+        {
+            // Data for the vertex buffer
+            { "POSITION", 0, VertexFormat::Float3, 0, 0, false },
+            { "NORMAL", 0, VertexFormat::Float3, 0, 12, false },
+
+            // Data for the instance buffer
+            { "WORLD", 0, VertexFormat::Float4, 1, 0, true },
+            { "WORLD", 1, VertexFormat::Float4, 1, 16, true },
+            { "WORLD", 2, VertexFormat::Float4, 1, 32, true },
+            { "WORLD", 3, VertexFormat::Float4, 1, 48, true }
+        };
+        const std::uint32_t numElements = sizeof(vertexLayout) / sizeof(vertexLayout[0]);
+
+        if (mGM->GetBackend()->CreateShaders(L"../../Renderer/Shaders/BaseVS.hlsl", L"../../Renderer/Shaders/BasePS.hlsl", vertexLayout, numElements, mBaseShaders))
+        {
+            // The driver keeps its own copy of the bytecode for as long as the shaders live
+            mShaderMemory.Set(mBaseShaders.bytecodeBytes);
         }
     }
 
+    void MeshRenderer::CreatePipelineStates()
+    {
+        PipelineStateDesc desc;
+        desc.vertexShader = mBaseShaders.vertexShader;
+        desc.inputLayout = mBaseShaders.inputLayout;
+        desc.pixelShader = mBaseShaders.pixelShader;
+        desc.primitiveTopology = TriangleList;
+        desc.rasterizerState = mGM->GetBackend()->GetFixedFunctionStates().cwCull;
+        mBasePipelineState = mGM->CreatePipelineState(desc);
+    }
+
     void MeshRenderer::CreateConstantBuffers()
     {
         // Scene Params
         {
-            D3D11_BUFFER_DESC desc;
-            ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.ByteWidth = sizeof(ShaderSceneParams);
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-            desc.MiscFlags = 0;
+            BufferDesc desc;
+            desc.usage = BufferUsage::Dynamic;
+            desc.size = sizeof(ShaderSceneParams);
+            desc.binding = BufferBinding::Constant;
 
-            mSceneConstantBuffer = mGM->CreateBuffer(desc, &mSceneParams);
+            mSceneConstantBuffer = mGM->CreateBuffer(desc, MemoryTag::Constants, &mSceneParams);
         }
 
         // Spot Light
         {
             // Create with no data originally because the spot light is not set yet
-            D3D11_BUFFER_DESC desc;
-            ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
+            BufferDesc desc;
             // Using dynamic because faster to update every frame to reflect user changes
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.ByteWidth = sizeof(ShaderSpotLight);
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-            desc.MiscFlags = 0;
+            desc.usage = BufferUsage::Dynamic;
+            desc.size = sizeof(ShaderSpotLight);
+            desc.binding = BufferBinding::Constant;
 
-            mSpotLightConstantBuffer = mGM->CreateBuffer(desc);
+            mSpotLightConstantBuffer = mGM->CreateBuffer(desc, MemoryTag::Lights);
         }
 
         // Material
         {
             // Create with no data originally because the material is not set yet
-            D3D11_BUFFER_DESC desc;
-            ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.ByteWidth = sizeof(Material);
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-            desc.MiscFlags = 0;
+            BufferDesc desc;
+            desc.usage = BufferUsage::Dynamic;
+            desc.size = sizeof(Material);
+            desc.binding = BufferBinding::Constant;
 
-            mMaterialConstantBuffer = mGM->CreateBuffer(desc);
+            mMaterialConstantBuffer = mGM->CreateBuffer(desc, MemoryTag::Constants);
         }
     }
 
     void MeshRenderer::CreateStructuredBuffers()
     {
         // Point Lights
-        D3D11_BUFFER_DESC desc;
-        ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-        desc.Usage = D3D11_USAGE_DYNAMIC;
-        desc.ByteWidth = sizeof(ShaderPointLight) * MaxPointLightsAllowed;
-        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-        desc.StructureByteStride = sizeof(ShaderPointLight);
+        BufferDesc desc;
+        desc.usage = BufferUsage::Dynamic;
+        desc.size = sizeof(ShaderPointLight) * MaxPointLightsAllowed;
+        desc.binding = BufferBinding::Structured;
+        desc.stride = sizeof(ShaderPointLight);
 
         // Buffer of data can be empty until used
-        mPointLightStructuredBuffer.buffer = mGM->CreateBuffer(desc);
+        mPointLightStructuredBuffer.buffer = mGM->CreateBuffer(desc, MemoryTag::Lights);
 
         if (!mPointLightStructuredBuffer.buffer)
         {
             return; 
         }
 
-        D3D11_BUFFER_SRV srvBuffer;
-        srvBuffer.FirstElement = 0;
         // Memory will be allocated for this number of elements but there could be less used
-        srvBuffer.NumElements = MaxPointLightsAllowed;
-
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-        ZeroMemory(&srvDesc, sizeof(D3D11_SHADER_RESOURCE_VIEW_DESC));
-        srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-        srvDesc.Buffer = srvBuffer;
+        mPointLightStructuredBuffer.shaderResourceView = mGM->GetBackend()->CreateBufferView(mPointLightStructuredBuffer.buffer, MaxPointLightsAllowed);
+    }
 
-        mGM->mDevice->CreateShaderResourceView(mPointLightStructuredBuffer.buffer, &srvDesc, &mPointLightStructuredBuffer.shaderResourceView);
+    void MeshRenderer::CreateGeometryBuffers()
+    {
+        // Grown when they fill up, so these only need to fit a typical scene
+        mVertexBuffer = std::make_unique<MegaBuffer>(mGM, sizeof(Vertex), BufferBinding::Vertex, MemoryTag::Meshes, 64 * 1024);
+        mIndexBuffer = std::make_unique<MegaBuffer>(mGM, sizeof(std::uint32_t), BufferBinding::Index, MemoryTag::Meshes, 256 * 1024);
+        mInstanceBuffer = std::make_unique<MegaBuffer>(mGM, sizeof(MeshInstanceData), BufferBinding::Vertex, MemoryTag::Instances, 64 * 1024);
+
+        MeshInstanceData identity;
+        identity.world = XMMatrixIdentity();
+        mIdentityInstance = mInstanceBuffer->Allocate(1, &identity);
     }
 
-    void MeshRenderer::CreateMeshBuffers(MeshType meshType)
+    void MeshRenderer::CreateMeshBuffers(MeshHandle mesh)
     {
-        if (mMeshTypeDataMap.find(meshType) == mMeshTypeDataMap.end())
+        MeshBuffers& buffers = mMeshBuffers[mesh];
+        // Geometry is uploaded the first time a mesh is drawn, and again if its handle was reused for another mesh
+        const std::uint32_t version = mMeshRegistry.GetVersion(mesh);
+        if (buffers.version != version)
         {
-            mMeshTypeDataMap.emplace(meshType, MeshBuffers());
+            ReleaseMeshBuffers(buffers);
+            buffers.version = version;
 
-            MeshBuffers& buffers = mMeshTypeDataMap[meshType];
-
-            const Vertex* vertices = nullptr; 
-            const DWORD* indices = nullptr;
-
-            // i had no time to add more primitives so just cube but renderer can support any primtive
-            if (meshType == MeshType::Cube)
-            {
-                buffers.vertexCount = Cube::numVertices;
-                buffers.indexCount = Cube::numIndices;
-                vertices = Cube::vertices;
-                indices = Cube::indices;
-            }
-            else
+            const MeshGeometry& geometry = mMeshRegistry.GetGeometry(mesh);
+            if (geometry.indexCount == 0)
             {
                 return;
             }
 
+            buffers.vertices = mVertexBuffer->Allocate(geometry.vertexCount, geometry.vertices);
+            buffers.indices = mIndexBuffer->Allocate(geometry.indexCount, geometry.indices);
+            if (buffers.vertices == InvalidBufferRange || buffers.indices == InvalidBufferRange)
             {
-                D3D11_BUFFER_DESC desc;
-                ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-                desc.Usage = D3D11_USAGE_DEFAULT;
-                desc.ByteWidth = sizeof(Vertex) * buffers.vertexCount;
-                desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-                desc.CPUAccessFlags = 0;
-                desc.MiscFlags = 0;
-
-                buffers.vertexBuffer = mGM->CreateBuffer(desc, vertices);
-            }
-            {
-                D3D11_BUFFER_DESC desc;
-                ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-                desc.Usage = D3D11_USAGE_DEFAULT;
-                desc.ByteWidth = sizeof(DWORD) * buffers.indexCount;
-                desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-                desc.CPUAccessFlags = 0;
-                desc.MiscFlags = 0;
-
-                buffers.indexBuffer = mGM->CreateBuffer(desc, indices);
+                ReleaseMeshBuffers(buffers);
+                buffers.version = version;
+                return;
             }
+            buffers.vertexCount = geometry.vertexCount;
+            buffers.indexCount = geometry.indexCount;
         }
 
-        MeshBuffers& buffers = mMeshTypeDataMap[meshType];
-        
-        SAFE_RELEASE(buffers.instanceBuffer);
-        
-        // The instance buffer is recreated to reflect the current number of entities in the scene
+        if (buffers.indexCount == 0)
         {
-            D3D11_BUFFER_DESC desc;
-            ZeroMemory(&desc, sizeof(D3D11_BUFFER_DESC));
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.ByteWidth = sizeof(MeshInstanceData) * mMeshTypeEntitiesMap[meshType].size();
-            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
+            return;
+        }
 
-            // Data is set on the update every frame because entity world transform may change
-            buffers.instanceBuffer = mGM->CreateBuffer(desc);
+        // The instance range is allocated again to fit the current number of entities in the scene
+        mInstanceBuffer->Free(buffers.instances);
+        // Data is set on the update every frame because entity world transform may change
+        const auto entityCount = static_cast<std::uint32_t>(mSceneEntities.meshEntities[mesh].size());
+        buffers.instances = mInstanceBuffer->Allocate(std::max<std::uint32_t>(entityCount, 1));
+        if (buffers.instances == InvalidBufferRange)
+        {
+            ReleaseMeshBuffers(buffers);
+            buffers.version = version;
         }
     }
 
     void MeshRenderer::DeleteMeshBuffers()
     {
-        for (auto& keyValue : mMeshTypeDataMap)
+        for (auto& buffers : mMeshBuffers)
+        {
+            ReleaseMeshBuffers(buffers);
+        }
+        mMeshBuffers.clear();
+        for (auto& buffers : mStaticChunkBuffers)
         {
-            keyValue.second.Release();
+            ReleaseMeshBuffers(buffers);
         }
-        mMeshTypeDataMap.clear();
+        mStaticChunkBuffers.clear();
+        mIndexBuffer->Free(mMeshletIndexRange);
+        mMeshletIndexRange = InvalidBufferRange;
+        mMeshletIndexCapacity = 0;
+    }
+
+    void MeshRenderer::ReleaseMeshBuffers(MeshBuffers& buffers)
+    {
+        // Only the ranges are freed. The shared buffers are released with the renderer
+        mVertexBuffer->Free(buffers.vertices);
+        mIndexBuffer->Free(buffers.indices);
+        mInstanceBuffer->Free(buffers.instances);
+        buffers = MeshBuffers();
     }
 
     void MeshRenderer::AddSpotLight(const std::shared_ptr<SpotLight>& spotLight)
@@ -464,12 +753,86 @@ namespace renderer
 
     void MeshRenderer::AddEntity(const std::shared_ptr<Entity>& entity)
     {
-        // Entities are recorded by mesh type because vertex instancing is being used to render them
-        if (mMeshTypeEntitiesMap.find(entity->meshType) == mMeshTypeEntitiesMap.end())
+        // Nothing can draw a mesh that is not loaded. Every entity added holds a reference to its mesh
+        if (!mMeshRegistry.IsLoaded(entity->mesh))
+        {
+            return;
+        }
+        mMeshRegistry.AddReference(entity->mesh);
+
+        // Static entities are merged into batches. The rest are recorded by mesh because vertex instancing is
+        // being used to render them
+        if (entity->isStatic && mStaticBatcher.CanBatch(*entity))
+        {
+            mStaticBatcher.Add(entity);
+            return;
+        }
+        mSceneEntities.Add(entity);
+    }
+
+    void MeshRenderer::AddEntities(const std::vector<std::shared_ptr<Entity>>& entities)
+    {
+        // Static entities go to the batcher one by one and the rest are added to their groups in one go
+        std::vector<std::shared_ptr<Entity>> instancedEntities;
+        instancedEntities.reserve(entities.size());
+        for (const auto& entity : entities)
         {
-            mMeshTypeEntitiesMap.emplace(entity->meshType, std::vector<std::shared_ptr<Entity>>());
+            if (!mMeshRegistry.IsLoaded(entity->mesh))
+            {
+                continue;
+            }
+            mMeshRegistry.AddReference(entity->mesh);
+            if (entity->isStatic && mStaticBatcher.CanBatch(*entity))
+            {
+                mStaticBatcher.Add(entity);
+            }
+            else
+            {
+                instancedEntities.push_back(entity);
+            }
+        }
+        mSceneEntities.Add(instancedEntities);
+    }
+
+    void MeshRenderer::RemoveEntity(const Entity* entity)
+    {
+        // Read first since removing can drop the last reference to the entity. Chunks that lose a member are
+        // rebuilt on the next frame
+        const MeshHandle mesh = entity->mesh;
+        if (mStaticBatcher.Remove(entity) || mSceneEntities.Remove(entity))
+        {
+            mMeshRegistry.Release(mesh);
+        }
+    }
+
+    void MeshRenderer::RemoveEntities(const std::vector<std::shared_ptr<Entity>>& entities)
+    {
+        for (const auto& entity : entities)
+        {
+            RemoveEntity(entity.get());
+        }
+    }
+
+    void MeshRenderer::MarkStaticEntityChanged(const Entity* entity)
+    {
+        mStaticBatcher.MarkChanged(entity);
+    }
+
+    MeshRegistry& MeshRenderer::GetMeshRegistry()
+    {
+        return mMeshRegistry;
+    }
+
+    void MeshRenderer::GetEntities(std::vector<const Entity*>& entities) const
+    {
+        entities.reserve(entities.size() + mSceneEntities.Size());
+        for (MeshHandle mesh : mSceneEntities.activeMeshes)
+        {
+            for (const auto& entity : mSceneEntities.meshEntities[mesh])
+            {
+                entities.push_back(entity.get());
+            }
         }
-        mMeshTypeEntitiesMap[entity->meshType].push_back(entity);
-        mInstanceBuffersToCreate.insert(entity->meshType);
+        mStaticBatcher.GetEntities(entities);
     }
 }
\ No newline at end of file
@@ -3,6 +3,19 @@
 
 #include "DataTypes.h"
 #include "GraphicsTypes.h"
+#include "GraphicsBackend.h"
+#include "MegaBuffer.h"
+#include "MeshRegistry.h"
+#include "InstanceBuilder.h"
+#include "SceneEntities.h"
+#include "RenderQueue.h"
+#include "StaticBatcher.h"
+#include "LightPacker.h"
+#include "Memory/FrameArena.h"
+#include "PipelineState.h"
+#include "Culling/ViewCuller.h"
+#include "Culling/OcclusionCuller.h"
+#include "Culling/MeshletCuller.h"
 
 namespace renderer
 {
@@ -14,35 +27,89 @@ namespace renderer
     public:
         static MeshRenderer* Initialize(GraphicsManager* graphicsManager);
         ~MeshRenderer(); 
-        void Render(double frameTime, const Camera* camera);
+        void Render(double frameTime, const std::vector<RenderView>& views);
         void AddSpotLight(const std::shared_ptr<SpotLight>& spotLight);
         void AddPointLight(const std::shared_ptr<PointLight>& pointLight);
         void AddEntity(const std::shared_ptr<Entity>& entity);
+        void AddEntities(const std::vector<std::shared_ptr<Entity>>& entities);
+        void RemoveEntity(const Entity* entity);
+        void RemoveEntities(const std::vector<std::shared_ptr<Entity>>& entities);
+        void MarkStaticEntityChanged(const Entity* entity);
+        MeshRegistry& GetMeshRegistry();
+        // Appends every entity added, whether it is drawn instanced or in a static batch
+        void GetEntities(std::vector<const Entity*>& entities) const;
 
     private:
         friend class Renderer;
+
+        /** Part of the meshlet index stream drawn by one queued instance */
+        struct MeshletRange
+        {
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
         MeshRenderer(GraphicsManager* graphicsManager);
-        void DrawMeshes();
-        void DrawMeshes(const MeshBuffers& buffers, const std::vector<std::shared_ptr<Entity>>& entities);
+        void BuildRenderQueue(std::uint32_t viewIndex, const Camera& camera);
+        void DrawMeshes(std::uint32_t viewIndex, const Camera& camera);
+        void CullMeshlets(const Camera& camera);
+        void BindMeshBuffers();
+        std::uint32_t GetMaterialId(const Material* material);
         void LoadShaders();
-        void UpdateConstantBuffers(const Camera* camera);
+        void CreatePipelineStates();
+        void UpdateSceneConstantBuffer(const Camera* camera);
+        void UpdateConstantBuffers();
         void UpdateStructuredBuffers();
+        void CullEntities(const std::vector<RenderView>& views);
+        void CullOccludedEntities(const Camera& camera);
+        void CullStaticChunks();
+        void UpdateStaticBatches();
         void UpdateMeshInstanceBuffers();
-        void UpdateMeshInstanceBuffer(MeshType meshType);
+        void UpdateMeshInstanceBuffer(MeshHandle mesh);
         void CreateConstantBuffers();
         void CreateStructuredBuffers();
-        void CreateMeshBuffers(MeshType meshType);
+        void CreateGeometryBuffers();
+        void CreateMeshBuffers(MeshHandle mesh);
         void DeleteMeshBuffers();
+        void ReleaseMeshBuffers(MeshBuffers& buffers);
 
         GraphicsManager* mGM;
-        std::unordered_map<MeshType, MeshBuffers> mMeshTypeDataMap;
-        std::unordered_map<MeshType, std::vector<std::shared_ptr<Entity>>> mMeshTypeEntitiesMap;
-        std::set<MeshType> mInstanceBuffersToCreate;
+        // Transient containers of the frame. Declared first so it outlives everything built on it
+        FrameArena mFrameArena;
+        // Declared before everything that reads mesh geometry
+        MeshRegistry mMeshRegistry;
+        // Ranges and instances of every mesh, indexed by mesh handle
+        std::vector<MeshBuffers> mMeshBuffers;
+        SceneEntities mSceneEntities;
+        std::vector<MeshInstances> mMeshInstances;
+
+        // Static entities merged into pre-transformed chunks, with the ranges and view visibility of each chunk
+        StaticBatcher mStaticBatcher;
+        std::vector<MeshBuffers> mStaticChunkBuffers;
+        std::vector<ViewMask> mStaticMasks;
+
+        // Visibility shared by all views drawn this frame
+        ViewCuller mViewCuller;
+        std::vector<Frustum> mViewFrustums;
+        // Occlusion culling only runs for the first view
+        OcclusionCuller mOcclusionCuller;
+        bool mOcclusionCullingEnabled;
+        // Triangles of the queued instances of meshlet meshes left after culling for the current view, in queue order
+        MeshletCuller mMeshletCuller;
+        std::vector<std::uint32_t> mMeshletIndices;
+        std::vector<MeshletRange> mMeshletRanges;
 
+        // Draws of the current view in sorted order
+        RenderQueue mRenderQueue;
+        // Materials numbered for the sort keys. Renumbered every frame
+        FrameMap<const Material*, std::uint32_t> mMaterialIds;
 
         // Data for buffers
         ShaderSceneParams mSceneParams;
         std::vector<std::shared_ptr<PointLight>> mPointLights;
+        // Packed point lights, kept between frames so uploading does not allocate
+        std::vector<ShaderPointLight> mPackedPointLights;
+        TrackedMemory mPackedPointLightMemory = TrackedMemory(MemoryTag::Lights);
         std::shared_ptr<SpotLight> mSpotLight;
 
         // Buffers
@@ -50,15 +117,28 @@ namespace renderer
         ID3D11Buffer* mMaterialConstantBuffer;
         ID3D11Buffer* mSpotLightConstantBuffer;
         StructuredBuffer mPointLightStructuredBuffer;
+        // Geometry and instances of every mesh type share these so a view binds them once
+        std::unique_ptr<MegaBuffer> mVertexBuffer;
+        std::unique_ptr<MegaBuffer> mIndexBuffer;
+        std::unique_ptr<MegaBuffer> mInstanceBuffer;
+        // Identity transform the pre-transformed static chunks are drawn with
+        BufferRangeHandle mIdentityInstance;
+        // Range the meshlet index stream is uploaded to for each view. Grown to the longest stream so far
+        BufferRangeHandle mMeshletIndexRange = InvalidBufferRange;
+        std::uint32_t mMeshletIndexCapacity = 0;
 
 
         //Shaders
-        ID3D11VertexShader* mBaseVertexShader;
-        ID3D11InputLayout* mBaseVertexLayout;
-        ID3D11PixelShader* mBasePixelShader;
+        ShaderProgram mBaseShaders;
+        const PipelineState* mBasePipelineState;
+        // Bytecode of the shaders above
+        TrackedMemory mShaderMemory = TrackedMemory(MemoryTag::Shaders, MemoryDomain::Gpu);
         
         static MeshRenderer* mMeshRenderer;
 
-        static constexpr std::uint32_t MaxPointLightsAllowed = 20;
+        static constexpr std::uint32_t MaxPointLightsAllowed = LightPacker::MaxPointLights;
+        // Direct3D values of D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST and DXGI_FORMAT_R32_UINT, which the backends take
+        static constexpr std::uint32_t TriangleList = 4;
+        static constexpr std::uint32_t IndexFormat = 42;
     };
 }
\ No newline at end of file
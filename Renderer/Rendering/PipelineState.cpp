@@ -0,0 +1,85 @@
+#include "PipelineState.h"
+
+namespace renderer
+{
+	namespace
+	{
+		template<typename T>
+		void HashCombine(size_t& seed, const T& value)
+		{
+			seed ^= std::hash<T>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		}
+	}
+
+	bool PipelineStateDesc::operator==(const PipelineStateDesc& other) const
+	{
+		return vertexShader == other.vertexShader &&
+			inputLayout == other.inputLayout &&
+			pixelShader == other.pixelShader &&
+			rasterizerState == other.rasterizerState &&
+			blendState == other.blendState &&
+			depthStencilState == other.depthStencilState &&
+			primitiveTopology == other.primitiveTopology &&
+			std::memcmp(blendFactor, other.blendFactor, sizeof(blendFactor)) == 0 &&
+			sampleMask == other.sampleMask &&
+			stencilRef == other.stencilRef;
+	}
+
+	size_t PipelineStateDesc::GetHash() const
+	{
+		size_t seed = 0;
+		HashCombine(seed, static_cast<const void*>(vertexShader));
+		HashCombine(seed, static_cast<const void*>(inputLayout));
+		HashCombine(seed, static_cast<const void*>(pixelShader));
+		HashCombine(seed, static_cast<const void*>(rasterizerState));
+		HashCombine(seed, static_cast<const void*>(blendState));
+		HashCombine(seed, static_cast<const void*>(depthStencilState));
+		HashCombine(seed, primitiveTopology);
+		for (float factor : blendFactor)
+		{
+			HashCombine(seed, factor);
+		}
+		HashCombine(seed, sampleMask);
+		HashCombine(seed, stencilRef);
+		return seed;
+	}
+
+	PipelineState::PipelineState(const PipelineStateDesc& desc, std::uint32_t id)
+		: mDesc(desc), mId(id)
+	{
+
+	}
+
+	const PipelineStateDesc& PipelineState::GetDesc() const
+	{
+		return mDesc;
+	}
+
+	std::uint32_t PipelineState::GetId() const
+	{
+		return mId;
+	}
+
+	const PipelineState* PipelineStateCache::GetOrCreate(const PipelineStateDesc& desc)
+	{
+		auto iter = mStates.find(desc);
+		if (iter != mStates.end())
+		{
+			return iter->second.get();
+		}
+		auto state = std::make_unique<PipelineState>(desc, static_cast<std::uint32_t>(mStates.size()));
+		const PipelineState* result = state.get();
+		mStates.emplace(desc, std::move(state));
+		return result;
+	}
+
+	size_t PipelineStateCache::Size() const
+	{
+		return mStates.size();
+	}
+
+	void PipelineStateCache::Clear()
+	{
+		mStates.clear();
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Minimal.h"
+
+// Direct3D objects are only referenced by pointer here so the header is portable
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11RasterizerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+
+namespace renderer
+{
+	/** Shaders and fixed function state used by a draw. Resources such as buffers are bound separately */
+	struct PipelineStateDesc
+	{
+		ID3D11VertexShader* vertexShader = nullptr;
+		ID3D11InputLayout* inputLayout = nullptr;
+		ID3D11PixelShader* pixelShader = nullptr;
+		// Null states use the Direct3D defaults
+		ID3D11RasterizerState* rasterizerState = nullptr;
+		ID3D11BlendState* blendState = nullptr;
+		ID3D11DepthStencilState* depthStencilState = nullptr;
+		// D3D_PRIMITIVE_TOPOLOGY value, triangle list by default
+		std::uint32_t primitiveTopology = 4;
+		float blendFactor[4] = { 1, 1, 1, 1 };
+		std::uint32_t sampleMask = 0xffffffff;
+		std::uint32_t stencilRef = 0;
+
+		bool operator==(const PipelineStateDesc& other) const;
+		size_t GetHash() const;
+	};
+
+	/** Immutable bundle of pipeline state. Created through the cache so equal descriptions share one object */
+	class PipelineState
+	{
+	public:
+		PipelineState(const PipelineStateDesc& desc, std::uint32_t id);
+		const PipelineStateDesc& GetDesc() const;
+		std::uint32_t GetId() const;
+
+	private:
+		PipelineStateDesc mDesc;
+		std::uint32_t mId;
+	};
+
+	/** Pipeline states keyed by their description */
+	class PipelineStateCache
+	{
+	public:
+		/** Returns the state matching the description, creating it the first time it is asked for */
+		const PipelineState* GetOrCreate(const PipelineStateDesc& desc);
+		size_t Size() const;
+		void Clear();
+
+	private:
+		struct DescHash
+		{
+			size_t operator()(const PipelineStateDesc& desc) const { return desc.GetHash(); }
+		};
+
+		std::unordered_map<PipelineStateDesc, std::unique_ptr<PipelineState>, DescHash> mStates;
+	};
+}
@@ -0,0 +1,250 @@
+#include "RecordingBackend.h"
+#include <cstring>
+
+namespace renderer
+{
+	namespace
+	{
+		/** Handles are never dereferenced, so any distinct, suitably aligned address will do */
+		template <typename T>
+		T* MakeHandle(std::uintptr_t& nextHandle)
+		{
+			return reinterpret_cast<T*>(++nextHandle * 16);
+		}
+	}
+
+	RecordingBackend::RecordingBackend()
+		: mNextHandle(0)
+	{
+		mStates.cwCull = MakeHandle<ID3D11RasterizerState>(mNextHandle);
+		mStates.ccwCull = MakeHandle<ID3D11RasterizerState>(mNextHandle);
+		mStates.noCull = MakeHandle<ID3D11RasterizerState>(mNextHandle);
+		mStates.wireframe = MakeHandle<ID3D11RasterizerState>(mNextHandle);
+		mStates.alphaBlend = MakeHandle<ID3D11BlendState>(mNextHandle);
+		mStates.colourBlend = MakeHandle<ID3D11BlendState>(mNextHandle);
+		mStates.fullDepth = MakeHandle<ID3D11DepthStencilState>(mNextHandle);
+		mBackBuffer = MakeHandle<ID3D11RenderTargetView>(mNextHandle);
+		mDepthStencil = MakeHandle<ID3D11DepthStencilView>(mNextHandle);
+	}
+
+	void RecordingBackend::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		Record(BackendCommand::SetVertexShader);
+	}
+
+	void RecordingBackend::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		Record(BackendCommand::SetPixelShader);
+	}
+
+	void RecordingBackend::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		Record(BackendCommand::SetInputLayout);
+	}
+
+	void RecordingBackend::SetPrimitiveTopology(std::uint32_t topology)
+	{
+		Record(BackendCommand::SetPrimitiveTopology);
+	}
+
+	void RecordingBackend::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		Record(BackendCommand::SetRasterizerState);
+	}
+
+	void RecordingBackend::SetBlendState(ID3D11BlendState* state, const float blendFactor[4], std::uint32_t sampleMask)
+	{
+		Record(BackendCommand::SetBlendState);
+	}
+
+	void RecordingBackend::SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef)
+	{
+		Record(BackendCommand::SetDepthStencilState);
+	}
+
+	void RecordingBackend::SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil)
+	{
+		Record(BackendCommand::SetRenderTargets);
+	}
+
+	void RecordingBackend::SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets)
+	{
+		Record(BackendCommand::SetVertexBuffers);
+	}
+
+	void RecordingBackend::SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset)
+	{
+		Record(BackendCommand::SetIndexBuffer);
+	}
+
+	void RecordingBackend::SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		Record(BackendCommand::SetVSConstantBuffers);
+	}
+
+	void RecordingBackend::SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		Record(BackendCommand::SetPSConstantBuffers);
+	}
+
+	void RecordingBackend::SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources)
+	{
+		Record(BackendCommand::SetPSShaderResources);
+	}
+
+	ID3D11Buffer* RecordingBackend::CreateBuffer(const BufferDesc& desc, const void* data)
+	{
+		Record(BackendCommand::CreateBuffer);
+		RecordedBuffer* buffer = new RecordedBuffer();
+		buffer->desc = desc;
+		buffer->bytes.resize(desc.size);
+		if (data && desc.size > 0)
+		{
+			std::memcpy(buffer->bytes.data(), data, desc.size);
+		}
+		return reinterpret_cast<ID3D11Buffer*>(buffer);
+	}
+
+	void RecordingBackend::ReleaseBuffer(ID3D11Buffer* buffer)
+	{
+		if (!buffer)
+		{
+			return;
+		}
+		Record(BackendCommand::ReleaseBuffer);
+		delete &GetRecordedBuffer(buffer);
+	}
+
+	std::uint32_t RecordingBackend::GetBufferSize(ID3D11Buffer* buffer) const
+	{
+		return buffer ? GetRecordedBuffer(buffer).desc.size : 0;
+	}
+
+	void RecordingBackend::UpdateBuffer(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t size)
+	{
+		Record(BackendCommand::UpdateBuffer);
+		RecordedBuffer& recorded = GetRecordedBuffer(buffer);
+		if (size > 0 && offset <= recorded.bytes.size() && size <= recorded.bytes.size() - offset)
+		{
+			std::memcpy(recorded.bytes.data() + offset, data, size);
+		}
+	}
+
+	void RecordingBackend::CopyBuffer(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size)
+	{
+		Record(BackendCommand::CopyBuffer);
+		RecordedBuffer& to = GetRecordedBuffer(dest);
+		const RecordedBuffer& from = GetRecordedBuffer(source);
+		if (size > 0 && destOffset <= to.bytes.size() && size <= to.bytes.size() - destOffset &&
+			sourceOffset <= from.bytes.size() && size <= from.bytes.size() - sourceOffset)
+		{
+			std::memcpy(to.bytes.data() + destOffset, from.bytes.data() + sourceOffset, size);
+		}
+	}
+
+	ID3D11ShaderResourceView* RecordingBackend::CreateBufferView(ID3D11Buffer* buffer, std::uint32_t elementCount)
+	{
+		return MakeHandle<ID3D11ShaderResourceView>(mNextHandle);
+	}
+
+	void RecordingBackend::ReleaseBufferView(ID3D11ShaderResourceView* view)
+	{
+
+	}
+
+	bool RecordingBackend::CreateShaders(const wchar_t* vertexPath, const wchar_t* pixelPath, const VertexElement* layout, std::uint32_t layoutCount, ShaderProgram& program)
+	{
+		program.vertexShader = MakeHandle<ID3D11VertexShader>(mNextHandle);
+		program.inputLayout = MakeHandle<ID3D11InputLayout>(mNextHandle);
+		program.pixelShader = MakeHandle<ID3D11PixelShader>(mNextHandle);
+		program.bytecodeBytes = 0;
+		return true;
+	}
+
+	void RecordingBackend::ReleaseShaders(ShaderProgram& program)
+	{
+		program = ShaderProgram();
+	}
+
+	const FixedFunctionStates& RecordingBackend::GetFixedFunctionStates() const
+	{
+		return mStates;
+	}
+
+	ID3D11RenderTargetView* RecordingBackend::GetBackBuffer() const
+	{
+		return mBackBuffer;
+	}
+
+	ID3D11DepthStencilView* RecordingBackend::GetDepthStencil() const
+	{
+		return mDepthStencil;
+	}
+
+	void RecordingBackend::SetViewport(const ViewportRect& viewport)
+	{
+		Record(BackendCommand::SetViewport);
+	}
+
+	void RecordingBackend::ClearRenderTarget(ID3D11RenderTargetView* target, const float colour[4])
+	{
+		Record(BackendCommand::ClearRenderTarget);
+	}
+
+	void RecordingBackend::ClearDepthStencil(ID3D11DepthStencilView* target, float depth, std::uint8_t stencil)
+	{
+		Record(BackendCommand::ClearDepthStencil);
+	}
+
+	void RecordingBackend::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance)
+	{
+		Record(BackendCommand::DrawIndexedInstanced);
+	}
+
+	void RecordingBackend::Present()
+	{
+		Record(BackendCommand::Present);
+	}
+
+	bool RecordingBackend::RequestBackBufferReadback(std::uint64_t id)
+	{
+		return false;
+	}
+
+	bool RecordingBackend::MapReadback(BackBufferReadback& readback)
+	{
+		return false;
+	}
+
+	void RecordingBackend::UnmapReadback(const BackBufferReadback& readback)
+	{
+
+	}
+
+	const std::vector<BackendCommand>& RecordingBackend::GetCommands() const
+	{
+		return mCommands;
+	}
+
+	size_t RecordingBackend::GetCount(BackendCommand command) const
+	{
+		return mCounts[static_cast<size_t>(command)];
+	}
+
+	void RecordingBackend::Clear()
+	{
+		mCommands.clear();
+		mCounts.fill(0);
+	}
+
+	void RecordingBackend::Record(BackendCommand command)
+	{
+		mCommands.push_back(command);
+		++mCounts[static_cast<size_t>(command)];
+	}
+
+	RecordingBackend::RecordedBuffer& RecordingBackend::GetRecordedBuffer(ID3D11Buffer* buffer)
+	{
+		return *reinterpret_cast<RecordedBuffer*>(buffer);
+	}
+}
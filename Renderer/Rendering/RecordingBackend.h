@@ -0,0 +1,109 @@
+#pragma once
+
+#include "GraphicsBackend.h"
+
+namespace renderer
+{
+	/** API calls a backend can receive */
+	enum class BackendCommand : std::uint8_t
+	{
+		SetVertexShader,
+		SetPixelShader,
+		SetInputLayout,
+		SetPrimitiveTopology,
+		SetRasterizerState,
+		SetBlendState,
+		SetDepthStencilState,
+		SetRenderTargets,
+		SetVertexBuffers,
+		SetIndexBuffer,
+		SetVSConstantBuffers,
+		SetPSConstantBuffers,
+		SetPSShaderResources,
+		CreateBuffer,
+		ReleaseBuffer,
+		UpdateBuffer,
+		CopyBuffer,
+		SetViewport,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		DrawIndexedInstanced,
+		Present,
+		Count
+	};
+
+	/**
+	 * Backend that records the calls it receives instead of talking to a device. Buffers are kept in memory, so
+	 * uploads and copies cost what the copies into a driver would. Shaders, states and views are stand in handles.
+	 * There is no image to read back, so readback requests fail. Works on every platform
+	 */
+	class RecordingBackend : public GraphicsBackend
+	{
+	public:
+		RecordingBackend();
+		RecordingBackend(const RecordingBackend&) = delete;
+		RecordingBackend& operator=(const RecordingBackend&) = delete;
+
+		void SetVertexShader(ID3D11VertexShader* shader) override;
+		void SetPixelShader(ID3D11PixelShader* shader) override;
+		void SetInputLayout(ID3D11InputLayout* layout) override;
+		void SetPrimitiveTopology(std::uint32_t topology) override;
+		void SetRasterizerState(ID3D11RasterizerState* state) override;
+		void SetBlendState(ID3D11BlendState* state, const float blendFactor[4], std::uint32_t sampleMask) override;
+		void SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef) override;
+		void SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil) override;
+		void SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets) override;
+		void SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset) override;
+		void SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) override;
+		void SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers) override;
+		void SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources) override;
+
+		ID3D11Buffer* CreateBuffer(const BufferDesc& desc, const void* data) override;
+		void ReleaseBuffer(ID3D11Buffer* buffer) override;
+		std::uint32_t GetBufferSize(ID3D11Buffer* buffer) const override;
+		void UpdateBuffer(ID3D11Buffer* buffer, std::uint32_t offset, const void* data, std::uint32_t size) override;
+		void CopyBuffer(ID3D11Buffer* dest, std::uint32_t destOffset, ID3D11Buffer* source, std::uint32_t sourceOffset, std::uint32_t size) override;
+		ID3D11ShaderResourceView* CreateBufferView(ID3D11Buffer* buffer, std::uint32_t elementCount) override;
+		void ReleaseBufferView(ID3D11ShaderResourceView* view) override;
+		bool CreateShaders(const wchar_t* vertexPath, const wchar_t* pixelPath, const VertexElement* layout, std::uint32_t layoutCount, ShaderProgram& program) override;
+		void ReleaseShaders(ShaderProgram& program) override;
+		const FixedFunctionStates& GetFixedFunctionStates() const override;
+
+		ID3D11RenderTargetView* GetBackBuffer() const override;
+		ID3D11DepthStencilView* GetDepthStencil() const override;
+		void SetViewport(const ViewportRect& viewport) override;
+		void ClearRenderTarget(ID3D11RenderTargetView* target, const float colour[4]) override;
+		void ClearDepthStencil(ID3D11DepthStencilView* target, float depth, std::uint8_t stencil) override;
+		void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t firstIndex, std::int32_t baseVertex, std::uint32_t firstInstance) override;
+		void Present() override;
+
+		bool RequestBackBufferReadback(std::uint64_t id) override;
+		bool MapReadback(BackBufferReadback& readback) override;
+		void UnmapReadback(const BackBufferReadback& readback) override;
+
+		/** Calls in the order they were received */
+		const std::vector<BackendCommand>& GetCommands() const;
+		size_t GetCount(BackendCommand command) const;
+		/** Forgets the calls recorded so far, such as once a frame so the record does not keep growing */
+		void Clear();
+
+	private:
+		/** What a buffer handle points to */
+		struct RecordedBuffer
+		{
+			BufferDesc desc;
+			std::vector<std::uint8_t> bytes;
+		};
+
+		void Record(BackendCommand command);
+		static RecordedBuffer& GetRecordedBuffer(ID3D11Buffer* buffer);
+
+		std::vector<BackendCommand> mCommands;
+		std::array<size_t, static_cast<size_t>(BackendCommand::Count)> mCounts = {};
+		FixedFunctionStates mStates;
+		ID3D11RenderTargetView* mBackBuffer;
+		ID3D11DepthStencilView* mDepthStencil;
+		// Stand in handles are numbered so every object gets a pointer of its own
+		std::uintptr_t mNextHandle;
+	};
+}
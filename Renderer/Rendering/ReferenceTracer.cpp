@@ -0,0 +1,251 @@
+#include "ReferenceTracer.h"
+#include "Camera/Camera.h"
+#include "InstanceBuilder.h"
+#include "MeshRegistry.h"
+#include "Profiling/Profiler.h"
+#include <atomic>
+#include <thread>
+
+namespace renderer
+{
+	namespace
+	{
+		float Dot3(FXMVECTOR a, FXMVECTOR b)
+		{
+			return XMVectorGetX(XMVector3Dot(a, b));
+		}
+
+		/**
+		 * ComputePointLightEffect and ComputeSpotLightEffect, which differ only in the spot light's falloff from the
+		 * centre of its cone. Returns the saturated sum of diffuse and specular the pixel shader adds up
+		 */
+		template<typename ShaderLight, typename Falloff>
+		XMVECTOR ComputeLightEffect(const ShaderLight& light, const Material& material, FXMVECTOR position, FXMVECTOR normal, FXMVECTOR toEye,
+			Falloff falloff)
+		{
+			XMVECTOR lightVec = XMVectorSubtract(XMLoadFloat3(&light.pos), position);
+			const float d = XMVectorGetX(XMVector3Length(lightVec));
+			if (d > light.range)
+			{
+				return XMVectorZero();
+			}
+			lightVec = XMVectorScale(lightVec, 1.0f / d);
+
+			const float diffuseFactor = Dot3(lightVec, normal);
+			if (!(diffuseFactor > 0.0f))
+			{
+				return XMVectorZero();
+			}
+			const XMVECTOR reflectVec = XMVector3Reflect(XMVectorNegate(lightVec), normal);
+			const float specularFactor = std::pow(std::max(Dot3(reflectVec, toEye), 0.0f), material.gloss);
+			// The shader divides only the falloff, so the last term is added to it rather than divided
+			const float att = falloff(lightVec) / (light.att.x + (light.att.y * d)) + (light.att.z * (d * d));
+			const XMVECTOR diffuse = XMVectorScale(XMVectorMultiply(XMLoadFloat4(&material.diffuse), XMLoadFloat4(&light.diffuse)), diffuseFactor * att);
+			const XMVECTOR specular = XMVectorScale(XMVectorMultiply(XMLoadFloat3(&material.specular), XMLoadFloat4(&light.specular)), specularFactor * att);
+			return XMVectorSaturate(XMVectorAdd(diffuse, specular));
+		}
+
+		std::uint8_t ToUnorm(float value)
+		{
+			return static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+		}
+	}
+
+	ReferenceTracer::ReferenceTracer()
+		: mMeshes(nullptr), mAmbient(LightPacker::DefaultAmbient), mThreadCount(0)
+	{
+		mSpotLight = LightPacker::Pack(LightPacker::CreateDefaultSpotLight());
+	}
+
+	void ReferenceTracer::SetThreadCount(std::uint32_t threadCount)
+	{
+		mThreadCount = threadCount;
+	}
+
+	void ReferenceTracer::SetLights(const SpotLight& spotLight, const std::vector<std::shared_ptr<PointLight>>& pointLights, float ambient)
+	{
+		mSpotLight = LightPacker::Pack(spotLight);
+		mPointLights.resize(LightPacker::MaxPointLights);
+		mPointLights.resize(LightPacker::PackPointLights(pointLights, mPointLights.data(), mPointLights.size()));
+		mAmbient = ambient;
+	}
+
+	void ReferenceTracer::Build(const std::vector<std::shared_ptr<Entity>>& entities, const MeshRegistry& meshes)
+	{
+		std::vector<const Entity*> pointers;
+		pointers.reserve(entities.size());
+		for (const auto& entity : entities)
+		{
+			pointers.push_back(entity.get());
+		}
+		Build(pointers, meshes);
+	}
+
+	void ReferenceTracer::Build(const std::vector<const Entity*>& entities, const MeshRegistry& meshes)
+	{
+		PROFILE_ZONE("ReferenceTracer::Build");
+		const std::uint64_t start = Profiler::Now();
+		mMeshes = &meshes;
+		std::vector<const Entity*> drawn;
+		drawn.reserve(entities.size());
+		for (const Entity* entity : entities)
+		{
+			if (entity->material && meshes.IsLoaded(entity->mesh) && meshes.GetGeometry(entity->mesh).indexCount > 0)
+			{
+				drawn.push_back(entity);
+			}
+		}
+		mQuery.Build(drawn, meshes);
+		mStats.entities = mQuery.GetStats().entities;
+		mStats.buildMilliseconds = (Profiler::Now() - start) / 1e6;
+	}
+
+	void ReferenceTracer::Render(const Camera& camera, std::uint32_t width, std::uint32_t height, Image& image)
+	{
+		PROFILE_ZONE("ReferenceTracer::Render");
+		const std::uint64_t start = Profiler::Now();
+		image.Resize(width, height);
+
+		// Pixel centres are taken back through the projection from the near plane to the far plane, so a hit at
+		// distance t along the ray is at depth t in the depth buffer's range
+		const XMMATRIX inverseViewProjection = camera.GetInverseViewProjection();
+		const XMFLOAT3 position = camera.GetPosition();
+		const XMVECTOR cameraPosition = XMLoadFloat3(&position);
+		const std::uint32_t tilesX = (width + TileSize - 1) / TileSize;
+		const std::uint32_t tileCount = tilesX * ((height + TileSize - 1) / TileSize);
+		const std::uint32_t hardwareThreads = mThreadCount > 0 ? mThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		const std::uint32_t threadCount = std::max(std::min(hardwareThreads, tileCount), 1u);
+
+		std::vector<std::uint64_t> hitCounts(threadCount);
+		std::atomic<std::uint32_t> next(0);
+		auto work = [&](std::uint32_t thread)
+		{
+			std::vector<Ray> rays(TileSize * TileSize);
+			std::vector<RayHit> hits(TileSize * TileSize);
+			std::vector<std::uint32_t> pixels(TileSize * TileSize);
+			for (std::uint32_t tile = next.fetch_add(1, std::memory_order_relaxed); tile < tileCount; tile = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				const std::uint32_t left = (tile % tilesX) * TileSize;
+				const std::uint32_t top = (tile / tilesX) * TileSize;
+				const std::uint32_t right = std::min(left + TileSize, width);
+				const std::uint32_t bottom = std::min(top + TileSize, height);
+
+				// Two by two quads so each packet covers neighbouring pixels
+				size_t count = 0;
+				for (std::uint32_t quadY = top; quadY < bottom; quadY += 2)
+				{
+					for (std::uint32_t quadX = left; quadX < right; quadX += 2)
+					{
+						for (std::uint32_t corner = 0; corner < 4; ++corner)
+						{
+							const std::uint32_t x = quadX + (corner & 1);
+							const std::uint32_t y = quadY + (corner >> 1);
+							if (x >= right || y >= bottom)
+							{
+								continue;
+							}
+							const float ndcX = (x + 0.5f) / width * 2 - 1;
+							const float ndcY = 1 - (y + 0.5f) / height * 2;
+							const XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 0, 1), inverseViewProjection);
+							const XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 1, 1), inverseViewProjection);
+							Ray& ray = rays[count];
+							XMStoreFloat3(&ray.origin, nearPoint);
+							XMStoreFloat3(&ray.direction, XMVectorSubtract(farPoint, nearPoint));
+							ray.maxDistance = 1;
+							pixels[count] = y * width + x;
+							++count;
+						}
+					}
+				}
+
+				mQuery.IntersectSerial(rays.data(), count, hits.data());
+				for (size_t i = 0; i < count; ++i)
+				{
+					XMFLOAT4 colour(0, 0, 0, 1);
+					if (hits[i].entity)
+					{
+						const XMVECTOR surface = XMVectorAdd(XMLoadFloat3(&rays[i].origin), XMVectorScale(XMLoadFloat3(&rays[i].direction), hits[i].distance));
+						XMStoreFloat4(&colour, Shade(hits[i], surface, cameraPosition));
+						++hitCounts[thread];
+					}
+					std::uint8_t* pixel = image.pixels.data() + static_cast<size_t>(pixels[i]) * 4;
+					pixel[0] = ToUnorm(colour.x);
+					pixel[1] = ToUnorm(colour.y);
+					pixel[2] = ToUnorm(colour.z);
+					pixel[3] = 255;
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+		{
+			workers.emplace_back(work, thread);
+		}
+		work(0);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		mStats.tiles = tileCount;
+		mStats.threads = threadCount;
+		mStats.rays = static_cast<std::uint64_t>(width) * height;
+		mStats.hits = 0;
+		for (std::uint64_t hitCount : hitCounts)
+		{
+			mStats.hits += hitCount;
+		}
+		mStats.renderMilliseconds = (Profiler::Now() - start) / 1e6;
+	}
+
+	const ReferenceTraceStats& ReferenceTracer::GetStats() const
+	{
+		return mStats;
+	}
+
+	XMVECTOR ReferenceTracer::Shade(const RayHit& hit, FXMVECTOR position, FXMVECTOR cameraPosition) const
+	{
+		const Material& material = *hit.entity->material;
+		const XMVECTOR normal = XMVector3Normalize(GetShaderNormal(hit));
+		const XMVECTOR toEye = XMVector3Normalize(XMVectorSubtract(cameraPosition, position));
+
+		XMVECTOR colour = XMVectorZero();
+		for (const ShaderPointLight& light : mPointLights)
+		{
+			colour = XMVectorAdd(colour, ComputeLightEffect(light, material, position, normal, toEye, [](FXMVECTOR) { return 1.0f; }));
+		}
+		colour = XMVectorAdd(colour, ComputeLightEffect(mSpotLight, material, position, normal, toEye, [&](FXMVECTOR lightVec)
+		{
+			return std::pow(std::max(Dot3(XMVectorNegate(lightVec), XMLoadFloat3(&mSpotLight.dir)), 0.0f), mSpotLight.cone);
+		}));
+		colour = XMVectorAdd(colour, XMVectorReplicate(mAmbient));
+		return XMVectorSaturate(colour);
+	}
+
+	XMVECTOR ReferenceTracer::GetShaderNormal(const RayHit& hit) const
+	{
+		const XMMATRIX world = InstanceBuilder::CalculateWorldMatrix(*hit.entity);
+		XMVECTOR localNormal;
+		if (hit.entity->mesh == BuiltinMeshes::Cube)
+		{
+			// The query tests cubes as boxes, so the face is found by taking the hit normal back into the cube's space
+			const XMFLOAT3 n = VF3(XMVector3TransformNormal(XMLoadFloat3(&hit.normal), XMMatrixTranspose(world)));
+			const XMFLOAT3 a(std::abs(n.x), std::abs(n.y), std::abs(n.z));
+			localNormal = a.x >= a.y && a.x >= a.z ? XMVectorSet(n.x < 0 ? -1.0f : 1.0f, 0, 0, 0) :
+				a.y >= a.z ? XMVectorSet(0, n.y < 0 ? -1.0f : 1.0f, 0, 0) : XMVectorSet(0, 0, n.z < 0 ? -1.0f : 1.0f, 0);
+		}
+		else
+		{
+			// Vertex normals blended across the triangle, as the rasterizer interpolates them
+			const MeshGeometry& geometry = mMeshes->GetGeometry(hit.entity->mesh);
+			const std::uint32_t* triangle = geometry.indices + hit.triangle * 3;
+			localNormal = XMVectorAdd(XMVectorAdd(
+				XMVectorScale(XMLoadFloat3(&geometry.vertices[triangle[0]].normal), 1 - hit.u - hit.v),
+				XMVectorScale(XMLoadFloat3(&geometry.vertices[triangle[1]].normal), hit.u)),
+				XMVectorScale(XMLoadFloat3(&geometry.vertices[triangle[2]].normal), hit.v));
+		}
+		// The vertex shader turns normals by the world matrix itself
+		return XMVector3TransformNormal(localNormal, world);
+	}
+}
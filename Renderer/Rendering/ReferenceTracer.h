@@ -0,0 +1,70 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "ShaderTypes.h"
+#include "ImageFile.h"
+#include "LightPacker.h"
+#include "Scene/RayQuery.h"
+
+namespace renderer
+{
+	class MeshRegistry;
+
+	/** Figures of the last Render */
+	struct ReferenceTraceStats
+	{
+		std::uint32_t entities = 0;
+		std::uint32_t tiles = 0;
+		std::uint32_t threads = 0;
+		std::uint64_t rays = 0;
+		std::uint64_t hits = 0;
+		double buildMilliseconds = 0;
+		double renderMilliseconds = 0;
+	};
+
+	/**
+	 * Renders what MeshRenderer draws on the CPU, one ray through the centre of every pixel, for golden images that
+	 * rasterized frames can be checked against numerically on any platform. Surfaces are lit with the math of
+	 * BasePS.hlsl and LightUtility.hlsli step by step, down to the vertex shader turning normals by the world
+	 * matrix rather than its inverse transpose and the precedence of the falloff terms, so a rasterizer without
+	 * multisampling matches it to within rounding wherever a pixel centre lands on the same surface. There are no
+	 * shadows since the shader has none, and pixels that hit nothing are black like the cleared back buffer.
+	 *
+	 * Entities go into a RayQuery hierarchy. Those the renderer would not draw, having no material or a built-in
+	 * mesh without geometry, are left out. The image is cut into tiles that threads take one at a time, and a tile's
+	 * rays are traced in packets of two by two pixels.
+	 */
+	class ReferenceTracer
+	{
+	public:
+		static constexpr std::uint32_t TileSize = 16;
+
+		ReferenceTracer();
+
+		/** Threads a frame is split over. Zero uses one per hardware thread */
+		void SetThreadCount(std::uint32_t threadCount);
+		/** Lights as MeshRenderer is given them. Point lights past the shader's limit are left out, as when packed */
+		void SetLights(const SpotLight& spotLight, const std::vector<std::shared_ptr<PointLight>>& pointLights,
+			float ambient = LightPacker::DefaultAmbient);
+		/** Takes a snapshot of the entities' transforms. The registry has to outlive later renders */
+		void Build(const std::vector<const Entity*>& entities, const MeshRegistry& meshes);
+		void Build(const std::vector<std::shared_ptr<Entity>>& entities, const MeshRegistry& meshes);
+		/** Renders the camera's view into the image, resized to the given size */
+		void Render(const Camera& camera, std::uint32_t width, std::uint32_t height, Image& image);
+		const ReferenceTraceStats& GetStats() const;
+
+	private:
+		/** Colour the pixel shader gives the surface a ray hit, before it is written to the back buffer */
+		XMVECTOR Shade(const RayHit& hit, FXMVECTOR position, FXMVECTOR cameraPosition) const;
+		/** Normal the pixel shader gets at the hit, before it normalizes it */
+		XMVECTOR GetShaderNormal(const RayHit& hit) const;
+
+		RayQuery mQuery;
+		const MeshRegistry* mMeshes;
+		ShaderSpotLight mSpotLight;
+		std::vector<ShaderPointLight> mPointLights;
+		float mAmbient;
+		std::uint32_t mThreadCount;
+		ReferenceTraceStats mStats;
+	};
+}
@@ -0,0 +1,215 @@
+#include "RenderQueue.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace renderer
+{
+	namespace
+	{
+		constexpr std::uint32_t RadixBits = 8;
+		constexpr std::uint32_t BucketCount = 1u << RadixBits;
+		constexpr std::uint32_t PassCount = 64 / RadixBits;
+		// Below this many items per thread starting threads costs more than it saves
+		constexpr size_t MinItemsPerThread = 1u << 16;
+
+		constexpr std::uint32_t PassShift = 60;
+		constexpr std::uint32_t MeshShift = 48;
+		constexpr std::uint32_t MaterialShift = 32;
+
+		/** Blocks each thread until all of them have arrived */
+		class Barrier
+		{
+		public:
+			explicit Barrier(std::uint32_t threadCount)
+				: mThreadCount(threadCount), mWaiting(0), mGeneration(0)
+			{
+
+			}
+
+			void Wait()
+			{
+				if (mThreadCount == 1)
+				{
+					return;
+				}
+				std::unique_lock<std::mutex> lock(mMutex);
+				std::uint32_t generation = mGeneration;
+				if (++mWaiting == mThreadCount)
+				{
+					mWaiting = 0;
+					++mGeneration;
+					mCondition.notify_all();
+					return;
+				}
+				mCondition.wait(lock, [&]() { return generation != mGeneration; });
+			}
+
+		private:
+			std::mutex mMutex;
+			std::condition_variable mCondition;
+			std::uint32_t mThreadCount;
+			std::uint32_t mWaiting;
+			std::uint32_t mGeneration;
+		};
+	}
+
+	SortKey RenderQueue::MakeKey(RenderPass pass, std::uint32_t mesh, std::uint32_t material, float viewDepth)
+	{
+		// Positive floats order the same as their bits read as integers
+		std::uint32_t depth = 0;
+		if (viewDepth > 0)
+		{
+			std::memcpy(&depth, &viewDepth, sizeof(depth));
+		}
+		if (pass == RenderPass::Transparent)
+		{
+			depth = ~depth;
+		}
+
+		return (static_cast<SortKey>(pass) << PassShift) |
+			(static_cast<SortKey>(mesh & ((1u << MeshBits) - 1)) << MeshShift) |
+			(static_cast<SortKey>(material & (MaxMaterials - 1)) << MaterialShift) |
+			depth;
+	}
+
+	std::uint32_t RenderQueue::GetMesh(SortKey key)
+	{
+		return static_cast<std::uint32_t>(key >> MeshShift) & ((1u << MeshBits) - 1);
+	}
+
+	void RenderQueue::Clear()
+	{
+		mItems.clear();
+	}
+
+	void RenderQueue::Push(SortKey key, std::uint32_t instance)
+	{
+		mItems.push_back({ key, instance });
+	}
+
+	void RenderQueue::Sort(std::uint32_t threadCount, LinearArena* arena)
+	{
+		RadixSort(mItems, mScratch, threadCount, arena);
+		mMemory.Set(GetCapacityBytes(mItems) + GetCapacityBytes(mScratch));
+	}
+
+	const std::vector<RenderItem>& RenderQueue::GetItems() const
+	{
+		return mItems;
+	}
+
+	size_t RenderQueue::Size() const
+	{
+		return mItems.size();
+	}
+
+	void RenderQueue::RadixSort(std::vector<RenderItem>& items, std::vector<RenderItem>& scratch, std::uint32_t threadCount,
+		LinearArena* arena)
+	{
+		const size_t count = items.size();
+		if (count < 2)
+		{
+			return;
+		}
+		// Scratch grows with the items' capacity rather than their count so it is not reallocated every time a frame
+		// has a few more items than any before
+		scratch.reserve(items.capacity());
+		scratch.resize(count);
+
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		threadCount = static_cast<std::uint32_t>(std::min<size_t>(threadCount, std::max<size_t>(1, count / MinItemsPerThread)));
+
+		FrameVector<std::array<size_t, BucketCount>> histograms(threadCount, ArenaAllocator<std::array<size_t, BucketCount>>(arena));
+		RenderItem* buffers[2] = { items.data(), scratch.data() };
+		Barrier barrier(threadCount);
+		bool skipPass = false;
+		std::uint32_t resultBuffer = 0;
+
+		auto sortPart = [&](std::uint32_t thread)
+		{
+			const size_t begin = count * thread / threadCount;
+			const size_t end = count * (thread + 1) / threadCount;
+			auto& histogram = histograms[thread];
+			std::uint32_t source = 0;
+
+			for (std::uint32_t pass = 0; pass < PassCount; ++pass)
+			{
+				const std::uint32_t shift = pass * RadixBits;
+				const RenderItem* in = buffers[source];
+
+				histogram.fill(0);
+				for (size_t i = begin; i < end; ++i)
+				{
+					++histogram[(in[i].key >> shift) & (BucketCount - 1)];
+				}
+				barrier.Wait();
+
+				// Turn the counts into the position each thread writes its first item of each digit to.
+				// Threads take consecutive ranges within a digit which keeps the sort stable.
+				if (thread == 0)
+				{
+					skipPass = false;
+					size_t offset = 0;
+					for (std::uint32_t bucket = 0; bucket < BucketCount; ++bucket)
+					{
+						size_t total = 0;
+						for (const auto& h : histograms)
+						{
+							total += h[bucket];
+						}
+						if (total == count)
+						{
+							skipPass = true;
+							break;
+						}
+						for (auto& h : histograms)
+						{
+							size_t bucketCount = h[bucket];
+							h[bucket] = offset;
+							offset += bucketCount;
+						}
+					}
+				}
+				barrier.Wait();
+
+				if (!skipPass)
+				{
+					RenderItem* out = buffers[source ^ 1];
+					for (size_t i = begin; i < end; ++i)
+					{
+						out[histogram[(in[i].key >> shift) & (BucketCount - 1)]++] = in[i];
+					}
+					source ^= 1;
+				}
+				// The next pass reads what every thread wrote in this one
+				barrier.Wait();
+			}
+
+			if (thread == 0)
+			{
+				resultBuffer = source;
+			}
+		};
+
+		FrameVector<std::thread> workers{ ArenaAllocator<std::thread>(arena) };
+		workers.reserve(threadCount - 1);
+		for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+		{
+			workers.emplace_back(sortPart, thread);
+		}
+		sortPart(0);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		if (resultBuffer == 1)
+		{
+			items.swap(scratch);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Minimal.h"
+#include "Memory/FrameArena.h"
+
+namespace renderer
+{
+	/**
+	 * Orders draws by pass, then mesh, then material, then view depth. The fields are packed from the most
+	 * significant bit down so sorting the keys as integers gives the draw order:
+	 * pass (4 bits) | mesh (12 bits) | material (16 bits) | depth (32 bits)
+	 */
+	using SortKey = std::uint64_t;
+
+	enum class RenderPass : std::uint8_t
+	{
+		// Front to back so early depth testing skips hidden pixels
+		Opaque,
+		// Back to front so blending composites correctly
+		Transparent
+	};
+
+	/** A draw waiting in the queue. The instance indexes the instance data of the key's mesh */
+	struct RenderItem
+	{
+		SortKey key;
+		std::uint32_t instance;
+	};
+
+	/** Draws of one view, sorted so state changes are grouped and opaque geometry is drawn nearest first */
+	class RenderQueue
+	{
+	public:
+		static constexpr std::uint32_t MeshBits = 12;
+		static constexpr std::uint32_t MaterialBits = 16;
+		static constexpr std::uint32_t MaxMaterials = 1u << MaterialBits;
+		// Mesh of static batches, whose items index the batch chunks instead of instance data
+		static constexpr std::uint32_t StaticBatchMesh = (1u << MeshBits) - 1;
+
+		/** View depth is the distance along the camera's forward axis */
+		static SortKey MakeKey(RenderPass pass, std::uint32_t mesh, std::uint32_t material, float viewDepth);
+		static std::uint32_t GetMesh(SortKey key);
+
+		void Clear();
+		void Push(SortKey key, std::uint32_t instance);
+		/** Sorts the items by key. A thread count of 0 uses every hardware thread. Temporaries come from the arena if given */
+		void Sort(std::uint32_t threadCount = 0, LinearArena* arena = nullptr);
+		const std::vector<RenderItem>& GetItems() const;
+		size_t Size() const;
+
+		/**
+		 * Stable LSD radix sort of the items by key, 8 bits per pass. Each thread histograms and scatters its own
+		 * part of the items. Passes where every key has the same digit are skipped, so the mostly constant high
+		 * bits cost one histogram each. Scratch is resized to match the items.
+		 */
+		static void RadixSort(std::vector<RenderItem>& items, std::vector<RenderItem>& scratch, std::uint32_t threadCount,
+			LinearArena* arena = nullptr);
+
+	private:
+		std::vector<RenderItem> mItems;
+		std::vector<RenderItem> mScratch;
+		TrackedMemory mMemory = TrackedMemory(MemoryTag::RenderQueue);
+	};
+}
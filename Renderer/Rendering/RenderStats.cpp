@@ -0,0 +1,89 @@
+#include "RenderStats.h"
+
+namespace renderer
+{
+	RenderCounters::RenderCounters()
+	{
+		for (auto& value : mValues)
+		{
+			value.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void RenderCounters::Collect(RenderStats& stats)
+	{
+		auto take = [&](RenderCounter counter)
+		{
+			return mValues[static_cast<size_t>(counter)].exchange(0, std::memory_order_relaxed);
+		};
+
+		stats.drawCalls = take(RenderCounter::DrawCalls);
+		stats.instances = take(RenderCounter::Instances);
+		stats.triangles = take(RenderCounter::Triangles);
+		stats.bufferCreations = take(RenderCounter::BufferCreations);
+		stats.bytesCreated = take(RenderCounter::BytesCreated);
+		stats.bufferUpdates = take(RenderCounter::BufferUpdates);
+		stats.bytesUploaded = take(RenderCounter::BytesUploaded);
+		stats.materialUpdates = take(RenderCounter::MaterialUpdates);
+		stats.constantBufferUpdates = take(RenderCounter::ConstantBufferUpdates);
+		stats.lightsUploaded = take(RenderCounter::LightsUploaded);
+		stats.entitiesVisible = take(RenderCounter::EntitiesVisible);
+		stats.entitiesCulled = take(RenderCounter::EntitiesCulled);
+		stats.entitiesOccluded = take(RenderCounter::EntitiesOccluded);
+		stats.staticChunksVisible = take(RenderCounter::StaticChunksVisible);
+		stats.staticChunksRebuilt = take(RenderCounter::StaticChunksRebuilt);
+		stats.meshletsTested = take(RenderCounter::MeshletsTested);
+		stats.meshletsCulled = take(RenderCounter::MeshletsCulled);
+		stats.meshletTrianglesCulled = take(RenderCounter::MeshletTrianglesCulled);
+		stats.meshletCullNanoseconds = take(RenderCounter::MeshletCullNanoseconds);
+	}
+
+	FrameTimeHistory::FrameTimeHistory()
+		: mCount(0)
+	{
+		for (auto& sample : mSamples)
+		{
+			sample.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void FrameTimeHistory::Add(double milliseconds)
+	{
+		// Only the render thread adds so the count does not need a read-modify-write
+		std::uint64_t count = mCount.load(std::memory_order_relaxed);
+		mSamples[count % WindowSize].store(static_cast<float>(milliseconds), std::memory_order_relaxed);
+		mCount.store(count + 1, std::memory_order_release);
+	}
+
+	FrameTimePercentiles FrameTimeHistory::GetPercentiles() const
+	{
+		const std::uint64_t count = mCount.load(std::memory_order_acquire);
+		const std::uint32_t sampleCount = static_cast<std::uint32_t>(std::min<std::uint64_t>(count, WindowSize));
+
+		FrameTimePercentiles percentiles;
+		percentiles.sampleCount = sampleCount;
+		if (sampleCount == 0)
+		{
+			return percentiles;
+		}
+
+		std::vector<float> samples(sampleCount);
+		for (std::uint32_t i = 0; i < sampleCount; ++i)
+		{
+			samples[i] = mSamples[i].load(std::memory_order_relaxed);
+		}
+
+		// Nearest rank percentiles
+		auto percentile = [&](double fraction)
+		{
+			size_t rank = static_cast<size_t>(std::ceil(fraction * sampleCount));
+			size_t index = std::min<size_t>(rank > 0 ? rank - 1 : 0, sampleCount - 1);
+			std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+			return static_cast<double>(samples[index]);
+		};
+		percentiles.p50 = percentile(0.50);
+		percentiles.p95 = percentile(0.95);
+		percentiles.p99 = percentile(0.99);
+		return percentiles;
+	}
+}
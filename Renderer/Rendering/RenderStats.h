@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Minimal.h"
+#include <atomic>
+
+namespace renderer
+{
+	/** What the renderer did in one frame */
+	struct RenderStats
+	{
+		std::uint64_t frameIndex = 0;
+		// Seconds, as passed to Renderer::Render
+		double frameTime = 0;
+
+		std::uint64_t drawCalls = 0;
+		std::uint64_t instances = 0;
+		std::uint64_t triangles = 0;
+
+		std::uint64_t bufferCreations = 0;
+		std::uint64_t bytesCreated = 0;
+		std::uint64_t bufferUpdates = 0;
+		std::uint64_t bytesUploaded = 0;
+		std::uint64_t materialUpdates = 0;
+		std::uint64_t constantBufferUpdates = 0;
+		std::uint64_t lightsUploaded = 0;
+
+		// Entities drawn in at least one view and entities no view could see
+		std::uint64_t entitiesVisible = 0;
+		std::uint64_t entitiesCulled = 0;
+		// Entities removed from the first view by occlusion culling
+		std::uint64_t entitiesOccluded = 0;
+		// Static batches drawn in at least one view and rebuilt because a member changed
+		std::uint64_t staticChunksVisible = 0;
+		std::uint64_t staticChunksRebuilt = 0;
+		// Meshlets of large meshes tested and culled over all views, the triangles that culling dropped and the time it took
+		std::uint64_t meshletsTested = 0;
+		std::uint64_t meshletsCulled = 0;
+		std::uint64_t meshletTrianglesCulled = 0;
+		std::uint64_t meshletCullNanoseconds = 0;
+
+		std::uint64_t stateBindsIssued = 0;
+		std::uint64_t stateBindsFiltered = 0;
+	};
+
+	enum class RenderCounter : std::uint32_t
+	{
+		DrawCalls,
+		Instances,
+		Triangles,
+		BufferCreations,
+		BytesCreated,
+		BufferUpdates,
+		BytesUploaded,
+		MaterialUpdates,
+		ConstantBufferUpdates,
+		LightsUploaded,
+		EntitiesVisible,
+		EntitiesCulled,
+		EntitiesOccluded,
+		StaticChunksVisible,
+		StaticChunksRebuilt,
+		MeshletsTested,
+		MeshletsCulled,
+		MeshletTrianglesCulled,
+		MeshletCullNanoseconds,
+		Count
+	};
+
+	/**
+	 * Counters the renderer adds to while it works. Adds are relaxed atomics so any thread can count without locks,
+	 * and hot loops should count locally and add once.
+	 */
+	class RenderCounters
+	{
+	public:
+		RenderCounters();
+		void Add(RenderCounter counter, std::uint64_t value)
+		{
+			mValues[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+		}
+		/** Moves the counts into the stats and starts counting from zero */
+		void Collect(RenderStats& stats);
+
+	private:
+		std::array<std::atomic<std::uint64_t>, static_cast<size_t>(RenderCounter::Count)> mValues;
+	};
+
+	struct FrameTimePercentiles
+	{
+		// Milliseconds
+		double p50 = 0;
+		double p95 = 0;
+		double p99 = 0;
+		std::uint32_t sampleCount = 0;
+	};
+
+	/**
+	 * Frame times of the most recent frames. Adding is a single store, and percentiles are only worked out when
+	 * they are read, which is safe from any thread.
+	 */
+	class FrameTimeHistory
+	{
+	public:
+		static constexpr std::uint32_t WindowSize = 1024;
+
+		FrameTimeHistory();
+		void Add(double milliseconds);
+		FrameTimePercentiles GetPercentiles() const;
+
+	private:
+		std::array<std::atomic<float>, WindowSize> mSamples;
+		std::atomic<std::uint64_t> mCount;
+	};
+}
@@ -2,39 +2,95 @@
 #include "GraphicsManager.h"
 #include "MeshRenderer.h"
 #include "Camera/Camera.h"
+#include "ReferenceTracer.h"
+#include "Scene/RayQuery.h"
+#include "Profiling/Profiler.h"
+#ifdef _WIN32
+#include "D3D11Backend.h"
+#endif
 
 namespace renderer
 {
     Renderer* Renderer::mRenderer = nullptr;
 
+#ifdef _WIN32
     Renderer* Renderer::Initialize(HWND windowHandle, const GraphicsConfig& config)
     {
-        if (!mRenderer)
+        if (mRenderer)
         {
-            mRenderer = new Renderer(windowHandle, config);
+            return mRenderer;
+        }
+        return Initialize(D3D11Backend::Create(windowHandle, config), config);
+    }
+#endif
+
+    Renderer* Renderer::Initialize(GraphicsBackend* backend, const GraphicsConfig& config)
+    {
+        if (mRenderer)
+        {
+            // Only one renderer is made, so a later backend is not used
+            SAFE_DELETE(backend);
+        }
+        else if (backend)
+        {
+            mRenderer = new Renderer(backend, config);
         }
         return mRenderer;
     }
 
-    Renderer::Renderer(HWND windowHandle, const GraphicsConfig& config)
+    Renderer::Renderer(GraphicsBackend* backend, const GraphicsConfig& config)
+        : mRayQuery(new RayQuery()), mRayQueryStale(true), mSceneCommands(new SceneCommandQueue()), mFrameIndex(0), mFrameCapture(nullptr), mNextCaptureId(0)
     {
-        mGM = GraphicsManager::Initialize(windowHandle, config);
+        mGM = GraphicsManager::Initialize(backend);
         mMR = MeshRenderer::Initialize(mGM);
 
         mCamera = new Camera(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 100), 0.4f * 3.14f, config.screenWidth, config.screenHeight, 0.01f, 2000.0f);
+
+        RenderView mainView;
+        mainView.camera = mCamera;
+        mainView.viewport.width = static_cast<float>(config.screenWidth);
+        mainView.viewport.height = static_cast<float>(config.screenHeight);
+        mViews.push_back(mainView);
     }
 
     Renderer::~Renderer()
     {
+        for (PendingCapture& pending : mPendingCaptures)
+        {
+            FrameCaptureResult result;
+            result.dropped = true;
+            result.path = pending.path;
+            pending.promise.set_value(result);
+        }
+        // Writes the frames already handed over before the renderer goes
+        SAFE_DELETE(mFrameCapture);
+        SAFE_DELETE(mRayQuery);
+        SAFE_DELETE(mSceneCommands);
         SAFE_DELETE(mMR);
         SAFE_DELETE(mGM);
         SAFE_DELETE(mCamera);
         mRenderer = nullptr;
     }
 
-    void Renderer::Render(double frameTime)
+    const RenderStats& Renderer::Render(double frameTime)
     {
-        mMR->Render(frameTime, mCamera);
+        PROFILE_ZONE("Renderer::Render");
+        const StateTrackerStats stateBefore = mGM->GetStateTracker().GetStats();
+        ApplySceneCommands();
+        mMR->Render(frameTime, mViews);
+        mRayQueryStale = true;
+        ReceiveCapturedFrames();
+
+        // Anything counted since the last frame, such as entities added between frames, lands in this one
+        mStats = RenderStats();
+        mGM->GetCounters().Collect(mStats);
+        mStats.frameIndex = mFrameIndex++;
+        mStats.frameTime = frameTime;
+        const StateTrackerStats& stateAfter = mGM->GetStateTracker().GetStats();
+        mStats.stateBindsIssued = stateAfter.issued - stateBefore.issued;
+        mStats.stateBindsFiltered = stateAfter.filtered - stateBefore.filtered;
+        mFrameTimes.Add(frameTime * 1000.0);
+        return mStats;
     }
 
     void Renderer::AddSpotLight(const std::shared_ptr<SpotLight>& spotLight)
@@ -50,10 +106,233 @@ namespace renderer
     void Renderer::AddEntity(const std::shared_ptr<Entity>& entity)
     {
         mMR->AddEntity(entity);
+        mRayQueryStale = true;
+    }
+
+    void Renderer::AddEntities(const std::vector<std::shared_ptr<Entity>>& entities)
+    {
+        mMR->AddEntities(entities);
+        mRayQueryStale = true;
+    }
+
+    void Renderer::RemoveEntity(const Entity* entity)
+    {
+        mMR->RemoveEntity(entity);
+        mRayQueryStale = true;
+    }
+
+    void Renderer::RemoveEntities(const std::vector<std::shared_ptr<Entity>>& entities)
+    {
+        mMR->RemoveEntities(entities);
+        mRayQueryStale = true;
+    }
+
+    void Renderer::MarkStaticEntityChanged(const Entity* entity)
+    {
+        mMR->MarkStaticEntityChanged(entity);
+        mRayQueryStale = true;
+    }
+
+    SceneCommandQueue& Renderer::GetSceneCommands()
+    {
+        return *mSceneCommands;
+    }
+
+    void Renderer::ApplySceneCommands()
+    {
+        if (!mSceneCommands->Merge(mSceneChanges))
+        {
+            return;
+        }
+        PROFILE_ZONE("Renderer::ApplySceneCommands");
+        RemoveEntities(mSceneChanges.removed);
+        AddEntities(mSceneChanges.added);
+        for (const auto& pointLight : mSceneChanges.addedPointLights)
+        {
+            AddPointLight(pointLight);
+        }
+        for (const Entity* entity : mSceneChanges.movedStatic)
+        {
+            MarkStaticEntityChanged(entity);
+        }
+        // Entities only moved by the commands are seen by the next ray query too
+        mRayQueryStale = true;
+        // Lets go of removed entities now rather than at the next merge
+        mSceneChanges.Clear();
+    }
+
+    MeshHandle Renderer::RegisterMesh(std::vector<Vertex> vertices, std::vector<std::uint32_t> indices)
+    {
+        return mMR->GetMeshRegistry().Register(std::move(vertices), std::move(indices));
+    }
+
+    void Renderer::ReleaseMesh(MeshHandle mesh)
+    {
+        mMR->GetMeshRegistry().Release(mesh);
+    }
+
+    MeshRegistry& Renderer::GetMeshRegistry() const
+    {
+        return mMR->GetMeshRegistry();
+    }
+
+    void Renderer::GetEntities(std::vector<const Entity*>& entities) const
+    {
+        mMR->GetEntities(entities);
     }
 
     Camera* Renderer::GetCamera() const
     {
         return mCamera;
     }
-}
\ No newline at end of file
+
+    bool Renderer::AddView(const RenderView& view)
+    {
+        if (!view.camera || mViews.size() == ViewCuller::MaxViews)
+        {
+            return false;
+        }
+        mViews.push_back(view);
+        return true;
+    }
+
+    void Renderer::ClearViews()
+    {
+        mViews.clear();
+    }
+
+    const std::vector<RenderView>& Renderer::GetViews() const
+    {
+        return mViews;
+    }
+
+    void Renderer::SetOcclusionCullingEnabled(bool enabled)
+    {
+        mMR->mOcclusionCullingEnabled = enabled;
+    }
+
+    bool Renderer::IsOcclusionCullingEnabled() const
+    {
+        return mMR->mOcclusionCullingEnabled;
+    }
+
+    const OcclusionStats& Renderer::GetOcclusionStats() const
+    {
+        return mMR->mOcclusionCuller.GetStats();
+    }
+
+    const StateTrackerStats& Renderer::GetStateStats() const
+    {
+        return mGM->GetStateTracker().GetStats();
+    }
+
+    const RenderStats& Renderer::GetStats() const
+    {
+        return mStats;
+    }
+
+    const StaticBatchStats& Renderer::GetStaticBatchStats() const
+    {
+        return mMR->mStaticBatcher.GetStats();
+    }
+
+    size_t Renderer::GetFrameArenaPeakUsed() const
+    {
+        return mMR->mFrameArena.GetPeakUsed();
+    }
+
+    FrameTimePercentiles Renderer::GetFrameTimePercentiles() const
+    {
+        return mFrameTimes.GetPercentiles();
+    }
+
+    RayQuery& Renderer::GetRayQuery()
+    {
+        if (mRayQueryStale)
+        {
+            mRayQueryEntities.clear();
+            mMR->GetEntities(mRayQueryEntities);
+            mRayQuery->Build(mRayQueryEntities, mMR->GetMeshRegistry());
+            mRayQueryStale = false;
+        }
+        return *mRayQuery;
+    }
+
+    bool Renderer::SaveReferenceImage(const std::string& path, const Camera& camera, std::uint32_t width, std::uint32_t height)
+    {
+        PROFILE_ZONE("Renderer::SaveReferenceImage");
+        std::vector<const Entity*> entities;
+        mMR->GetEntities(entities);
+        ReferenceTracer tracer;
+        tracer.SetLights(*mMR->mSpotLight, mMR->mPointLights, mMR->mSceneParams.ambient);
+        tracer.Build(entities, mMR->GetMeshRegistry());
+        Image image;
+        tracer.Render(camera, width, height, image);
+        return ImageFile::SavePpm(path, image);
+    }
+
+    std::future<FrameCaptureResult> Renderer::CaptureFrame(const std::string& path, ImageFormat format)
+    {
+        std::promise<FrameCaptureResult> promise;
+        std::future<FrameCaptureResult> future = promise.get_future();
+        const std::uint64_t id = ++mNextCaptureId;
+        if (!mGM->RequestBackBufferReadback(id))
+        {
+            FrameCaptureResult result;
+            result.dropped = true;
+            result.path = path;
+            promise.set_value(result);
+            return future;
+        }
+        mPendingCaptures.push_back({ id, path, format, std::move(promise) });
+        return future;
+    }
+
+    FrameCapture& Renderer::GetFrameCapture()
+    {
+        if (!mFrameCapture)
+        {
+            mFrameCapture = new FrameCapture();
+        }
+        return *mFrameCapture;
+    }
+
+    void Renderer::ReceiveCapturedFrames()
+    {
+        PROFILE_ZONE("Renderer::ReceiveCapturedFrames");
+        BackBufferReadback readback;
+        while (!mPendingCaptures.empty() && mGM->MapReadback(readback))
+        {
+            auto pending = std::find_if(mPendingCaptures.begin(), mPendingCaptures.end(), [&](const PendingCapture& capture)
+            {
+                return capture.id == readback.id;
+            });
+            if (pending == mPendingCaptures.end())
+            {
+                mGM->UnmapReadback(readback);
+                continue;
+            }
+            // The staging texture is copied out so it can take the next frame while this one is encoded
+            Image* image = GetFrameCapture().Acquire(readback.width, readback.height);
+            if (image)
+            {
+                const size_t rowSize = static_cast<size_t>(readback.width) * 4;
+                for (std::uint32_t y = 0; y < readback.height; ++y)
+                {
+                    std::memcpy(image->pixels.data() + y * rowSize, readback.pixels + static_cast<size_t>(y) * readback.rowPitch, rowSize);
+                }
+                mGM->UnmapReadback(readback);
+                mFrameCapture->Submit(image, pending->path, pending->format, std::move(pending->promise));
+            }
+            else
+            {
+                mGM->UnmapReadback(readback);
+                FrameCaptureResult result;
+                result.dropped = true;
+                result.path = pending->path;
+                pending->promise.set_value(result);
+            }
+            mPendingCaptures.erase(pending);
+        }
+    }
+}
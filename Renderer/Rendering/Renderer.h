@@ -1,29 +1,115 @@
 #pragma once
 
 #include "DataTypes.h"
+#include "RenderStats.h"
+#include "Capture/FrameCapture.h"
+#include "Scene/SceneCommands.h"
+#include "StaticBatcher.h"
 
 namespace renderer
 {
+    class GraphicsBackend;
+
     class Renderer
     {
     public:
+#ifdef _WIN32
+        // Draws to the window with Direct3D 11
         static Renderer* Initialize(HWND windowHandle, const GraphicsConfig& config);
+#endif
+        // Draws through the backend, which the renderer takes ownership of. Returns null if the backend is null
+        static Renderer* Initialize(GraphicsBackend* backend, const GraphicsConfig& config);
         ~Renderer();
-        void Render(double frameTime);
+        /** Draws every view and returns what the frame did */
+        const RenderStats& Render(double frameTime);
         // Pass shared pointers for lights to allow app to change position and colour
         void AddSpotLight(const std::shared_ptr<SpotLight>& spotLight);
         void AddPointLight(const std::shared_ptr<PointLight>& pointLight);
         void AddEntity(const std::shared_ptr<Entity>& entity);
+        // Adds a whole scene at once, which is much faster than adding its entities one by one
+        void AddEntities(const std::vector<std::shared_ptr<Entity>>& entities);
+        // Stops drawing the entity and releases the renderer's reference to it
+        void RemoveEntity(const Entity* entity);
+        void RemoveEntities(const std::vector<std::shared_ptr<Entity>>& entities);
+        // Rebuilds the static batch of an entity added with isStatic set, after it was moved or changed
+        void MarkStaticEntityChanged(const Entity* entity);
+        // Where other threads submit SceneCommandBuffers of entities to add, remove and move, as the methods above
+        // may only be called from the thread that renders. Safe to call from any thread
+        SceneCommandQueue& GetSceneCommands();
+        // Merges the submitted commands and gives their changes to the renderer in one go. Render does this first
+        void ApplySceneCommands();
+        // Adds geometry entities draw by setting their mesh to the returned handle, which holds one reference for
+        // the caller. Returns InvalidMesh if the geometry is not valid triangles
+        MeshHandle RegisterMesh(std::vector<Vertex> vertices, std::vector<std::uint32_t> indices);
+        // Gives back the caller's reference. The mesh is unloaded once no entity draws it either
+        void ReleaseMesh(MeshHandle mesh);
+        class MeshRegistry& GetMeshRegistry() const;
+        // Appends every entity added, whether it is drawn instanced or in a static batch
+        void GetEntities(std::vector<const Entity*>& entities) const;
         class Camera* GetCamera() const;
+        // Views are drawn in the order they were added. Starts with the renderer camera covering the screen
+        bool AddView(const RenderView& view);
+        void ClearViews();
+        const std::vector<RenderView>& GetViews() const;
+        // Occlusion culling hides entities behind large cubes in the first view. Off by default
+        void SetOcclusionCullingEnabled(bool enabled);
+        bool IsOcclusionCullingEnabled() const;
+        const struct OcclusionStats& GetOcclusionStats() const;
+        // Binds issued to Direct3D and dropped as redundant since the start
+        const struct StateTrackerStats& GetStateStats() const;
+        // Stats of the last rendered frame
+        const RenderStats& GetStats() const;
+        const StaticBatchStats& GetStaticBatchStats() const;
+        // Most bytes a frame took from the frame arena
+        size_t GetFrameArenaPeakUsed() const;
+        // Frame times over the last FrameTimeHistory::WindowSize frames. Safe to call from any thread
+        FrameTimePercentiles GetFrameTimePercentiles() const;
+        // Ray casts against every entity, for picking and line of sight. Rebuilt on the first call after a frame
+        // was rendered or entities were added, removed or marked changed, so entities moved in between are seen
+        class RayQuery& GetRayQuery();
+        // Ray traces what the camera sees on the CPU with the same lighting as the shaders and saves it as a PPM,
+        // a golden image to check rasterized frames of the same size against
+        bool SaveReferenceImage(const std::string& path, const Camera& camera, std::uint32_t width, std::uint32_t height);
+        // Saves the frame the next Render draws. It is read back from the GPU a few frames later and encoded on other
+        // threads, so rendering waits for neither. The future is ready once the file is written, or at once with
+        // dropped set if the frame could not be read back because earlier captures are still in flight
+        std::future<FrameCaptureResult> CaptureFrame(const std::string& path, ImageFormat format = ImageFormat::Png);
+        // Encoder threads and buffers captured frames go through, made on first use
+        FrameCapture& GetFrameCapture();
 
     private:
-        Renderer(HWND windowHandle, const GraphicsConfig& config);
+        Renderer(GraphicsBackend* backend, const GraphicsConfig& config);
+        // Hands frames the GPU has finished reading back to the frame capture
+        void ReceiveCapturedFrames();
 
         class GraphicsManager* mGM;
         class MeshRenderer* mMR;
         Camera* mCamera;
+        std::vector<RenderView> mViews;
 
         std::vector<std::shared_ptr<Entity>> mEntities;
+        RayQuery* mRayQuery;
+        // Entities gathered for the ray query, kept to avoid reallocating
+        std::vector<const Entity*> mRayQueryEntities;
+        bool mRayQueryStale;
+
+        SceneCommandQueue* mSceneCommands;
+        SceneChanges mSceneChanges;
+
+        RenderStats mStats;
+        FrameTimeHistory mFrameTimes;
+        std::uint64_t mFrameIndex;
+
+        FrameCapture* mFrameCapture;
+        struct PendingCapture
+        {
+            std::uint64_t id;
+            std::string path;
+            ImageFormat format;
+            std::promise<FrameCaptureResult> promise;
+        };
+        std::vector<PendingCapture> mPendingCaptures;
+        std::uint64_t mNextCaptureId;
 
         static Renderer* mRenderer;
     };
@@ -0,0 +1,149 @@
+#include "SceneEntities.h"
+
+namespace renderer
+{
+	namespace
+	{
+		// A node of the index map is roughly a pointer, the entry and the cached hash
+		constexpr std::uint64_t IndexNodeBytes = 4 * sizeof(void*);
+		constexpr std::uint32_t Inactive = ~0u;
+	}
+
+	std::vector<std::shared_ptr<Entity>>& SceneEntities::Activate(MeshHandle mesh)
+	{
+		if (mesh >= meshEntities.size())
+		{
+			meshEntities.resize(mesh + size_t(1));
+			activeIndices.resize(mesh + size_t(1), Inactive);
+			isNew.resize(mesh + size_t(1), false);
+		}
+		if (activeIndices[mesh] == Inactive)
+		{
+			activeIndices[mesh] = static_cast<std::uint32_t>(activeMeshes.size());
+			activeMeshes.push_back(mesh);
+		}
+		if (!isNew[mesh])
+		{
+			isNew[mesh] = true;
+			newMeshes.push_back(mesh);
+		}
+		return meshEntities[mesh];
+	}
+
+	void SceneEntities::Add(const std::shared_ptr<Entity>& entity)
+	{
+		auto& entities = Activate(entity->mesh);
+		const size_t capacity = entities.capacity();
+		indices[entity.get()] = entities.size();
+		entities.push_back(entity);
+		memory.Set(memory.Get() + sizeof(Entity) + IndexNodeBytes + sizeof(std::shared_ptr<Entity>) * (entities.capacity() - capacity));
+	}
+
+	void SceneEntities::Add(const std::vector<std::shared_ptr<Entity>>& entities)
+	{
+		MeshHandle meshCount = 0;
+		for (const auto& entity : entities)
+		{
+			meshCount = std::max(meshCount, entity->mesh + 1);
+		}
+		std::vector<size_t> counts(meshCount);
+		for (const auto& entity : entities)
+		{
+			++counts[entity->mesh];
+		}
+
+		// Groups are sized once per mesh rather than grown per entity
+		for (MeshHandle mesh = 0; mesh < meshCount; ++mesh)
+		{
+			if (counts[mesh] > 0)
+			{
+				auto& group = Activate(mesh);
+				group.reserve(group.size() + counts[mesh]);
+			}
+		}
+		indices.reserve(indices.size() + entities.size());
+		for (const auto& entity : entities)
+		{
+			auto& group = meshEntities[entity->mesh];
+			indices[entity.get()] = group.size();
+			group.push_back(entity);
+		}
+		UpdateMemory();
+	}
+
+	bool SceneEntities::Remove(const Entity* entity)
+	{
+		auto index = indices.find(entity);
+		if (index == indices.end())
+		{
+			return false;
+		}
+
+		// Order within a group does not matter, so the last entity fills the gap
+		auto& entities = meshEntities[entity->mesh];
+		if (index->second + 1 < entities.size())
+		{
+			entities[index->second] = std::move(entities.back());
+			indices[entities[index->second].get()] = index->second;
+		}
+		entities.pop_back();
+		indices.erase(index);
+		memory.Set(memory.Get() - sizeof(Entity) - IndexNodeBytes);
+		return true;
+	}
+
+	void SceneEntities::Remove(const std::vector<std::shared_ptr<Entity>>& entities)
+	{
+		for (const auto& entity : entities)
+		{
+			Remove(entity.get());
+		}
+	}
+
+	void SceneEntities::Deactivate(MeshHandle mesh)
+	{
+		const std::uint32_t index = activeIndices[mesh];
+		if (index == Inactive)
+		{
+			return;
+		}
+		activeMeshes[index] = activeMeshes.back();
+		activeIndices[activeMeshes[index]] = index;
+		activeMeshes.pop_back();
+		activeIndices[mesh] = Inactive;
+		std::vector<std::shared_ptr<Entity>>().swap(meshEntities[mesh]);
+		UpdateMemory();
+	}
+
+	void SceneEntities::ClearNewMeshes()
+	{
+		for (MeshHandle mesh : newMeshes)
+		{
+			isNew[mesh] = false;
+		}
+		newMeshes.clear();
+	}
+
+	size_t SceneEntities::Size() const
+	{
+		size_t size = 0;
+		for (MeshHandle mesh : activeMeshes)
+		{
+			size += meshEntities[mesh].size();
+		}
+		return size;
+	}
+
+	void SceneEntities::UpdateMemory()
+	{
+		std::uint64_t bytes = GetCapacityBytes(meshEntities) + GetCapacityBytes(activeMeshes) + GetCapacityBytes(newMeshes) +
+			GetCapacityBytes(activeIndices) + isNew.capacity() / 8;
+		for (MeshHandle mesh : activeMeshes)
+		{
+			const auto& entities = meshEntities[mesh];
+			bytes += (sizeof(Entity) + IndexNodeBytes) * entities.size() + GetCapacityBytes(entities);
+		}
+		bytes += sizeof(void*) * indices.bucket_count();
+		memory.Set(bytes);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	/** Entities in the scene grouped by mesh, which is how they are instanced */
+	struct SceneEntities
+	{
+		// Entities of each mesh, indexed by mesh handle
+		std::vector<std::vector<std::shared_ptr<Entity>>> meshEntities;
+		// Handles of the meshes with a group, so per mesh loops skip the handles nothing uses
+		std::vector<MeshHandle> activeMeshes;
+		// Where each entity is in its group, so removing one does not search
+		std::unordered_map<const Entity*, size_t> indices;
+		// Meshes that gained entities since their instance buffers were last created, each listed once
+		std::vector<MeshHandle> newMeshes;
+		// Where each mesh is in the active list, or ~0u, and whether it is in the new list
+		std::vector<std::uint32_t> activeIndices;
+		std::vector<bool> isNew;
+		// The lists and the entities they keep alive
+		TrackedMemory memory = TrackedMemory(MemoryTag::Entities);
+
+		void Add(const std::shared_ptr<Entity>& entity);
+		/** Adds a whole array, sizing each group once and reporting the memory once */
+		void Add(const std::vector<std::shared_ptr<Entity>>& entities);
+		/** Removes the entity by moving the last of its group into its place. Returns false if it was not added */
+		bool Remove(const Entity* entity);
+		void Remove(const std::vector<std::shared_ptr<Entity>>& entities);
+		/**
+		 * Frees the group of a mesh whose entities were all removed and takes it off the active list, moving the
+		 * last active mesh into its place
+		 */
+		void Deactivate(MeshHandle mesh);
+		void ClearNewMeshes();
+		size_t Size() const;
+		/** Reports the size of the lists to the tracker. Call after changing them directly */
+		void UpdateMemory();
+
+	private:
+		/** Group of the mesh, made active and listed as new */
+		std::vector<std::shared_ptr<Entity>>& Activate(MeshHandle mesh);
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/** Structures laid out to match the constant and structured buffers in the shaders */
+#include "Minimal.h"
+
+using namespace DirectX;
+
+namespace renderer
+{
+	/** Point light for shader */
+	struct ShaderPointLight
+	{
+		XMFLOAT3 pos;
+		float range;
+		XMFLOAT3 att;
+		float pad;
+		XMFLOAT4 diffuse;
+		XMFLOAT4 specular;
+	};
+
+	/** Spot light for shader */
+	struct ShaderSpotLight
+	{
+		XMFLOAT3 pos;
+		float range;
+		XMFLOAT3 dir;
+		float cone;
+		XMFLOAT3 att;
+		float pad;
+		XMFLOAT4 diffuse;
+		XMFLOAT4 specular;
+	};
+
+	struct ShaderSceneParams
+	{
+		XMMATRIX ViewProj;
+		XMFLOAT3 camPos;
+		float ambient;
+		std::uint32_t pointLightCount;
+		std::uint32_t pad1, pad2, pad3;
+	};
+
+	struct MeshInstanceData
+	{
+		XMMATRIX world;
+	};
+}
@@ -0,0 +1,256 @@
+#include "StateTracker.h"
+
+namespace renderer
+{
+	template<typename T, std::uint32_t SlotCount>
+	bool StateTracker::SlotArray<T, SlotCount>::Matches(std::uint32_t startSlot, std::uint32_t count, const T* values) const
+	{
+		// Slots past the tracked ones are always bound
+		if (startSlot + count > SlotCount)
+		{
+			return false;
+		}
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const std::uint32_t slot = startSlot + i;
+			if (!(known & (1u << slot)) || slots[slot] != values[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T, std::uint32_t SlotCount>
+	void StateTracker::SlotArray<T, SlotCount>::Store(std::uint32_t startSlot, std::uint32_t count, const T* values)
+	{
+		for (std::uint32_t i = 0; i < count && startSlot + i < SlotCount; ++i)
+		{
+			const std::uint32_t slot = startSlot + i;
+			slots[slot] = values[i];
+			known |= 1u << slot;
+		}
+	}
+
+	StateTracker::StateTracker(GraphicsBackend* backend)
+		: mBackend(backend)
+	{
+		Invalidate();
+	}
+
+	void StateTracker::SetBackend(GraphicsBackend* backend)
+	{
+		mBackend = backend;
+		Invalidate();
+	}
+
+	void StateTracker::Invalidate()
+	{
+		mKnown = 0;
+		mVertexBuffers.known = 0;
+		mVSConstantBuffers.known = 0;
+		mPSConstantBuffers.known = 0;
+		mPSShaderResources.known = 0;
+	}
+
+	void StateTracker::InvalidateRenderTargets()
+	{
+		mKnown &= ~RenderTargetsBit;
+	}
+
+	void StateTracker::SetPipelineState(const PipelineState* state)
+	{
+		const PipelineStateDesc& desc = state->GetDesc();
+		SetVertexShader(desc.vertexShader);
+		SetInputLayout(desc.inputLayout);
+		SetPixelShader(desc.pixelShader);
+		SetPrimitiveTopology(desc.primitiveTopology);
+		SetRasterizerState(desc.rasterizerState);
+		SetBlendState(desc.blendState, desc.blendFactor, desc.sampleMask);
+		SetDepthStencilState(desc.depthStencilState, desc.stencilRef);
+	}
+
+	void StateTracker::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		if (Issue(IsKnown(VertexShaderBit) && mVertexShader == shader))
+		{
+			mBackend->SetVertexShader(shader);
+			mVertexShader = shader;
+			mKnown |= VertexShaderBit;
+		}
+	}
+
+	void StateTracker::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		if (Issue(IsKnown(PixelShaderBit) && mPixelShader == shader))
+		{
+			mBackend->SetPixelShader(shader);
+			mPixelShader = shader;
+			mKnown |= PixelShaderBit;
+		}
+	}
+
+	void StateTracker::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		if (Issue(IsKnown(InputLayoutBit) && mInputLayout == layout))
+		{
+			mBackend->SetInputLayout(layout);
+			mInputLayout = layout;
+			mKnown |= InputLayoutBit;
+		}
+	}
+
+	void StateTracker::SetPrimitiveTopology(std::uint32_t topology)
+	{
+		if (Issue(IsKnown(TopologyBit) && mTopology == topology))
+		{
+			mBackend->SetPrimitiveTopology(topology);
+			mTopology = topology;
+			mKnown |= TopologyBit;
+		}
+	}
+
+	void StateTracker::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		if (Issue(IsKnown(RasterizerBit) && mRasterizerState == state))
+		{
+			mBackend->SetRasterizerState(state);
+			mRasterizerState = state;
+			mKnown |= RasterizerBit;
+		}
+	}
+
+	void StateTracker::SetBlendState(ID3D11BlendState* state, const float* blendFactor, std::uint32_t sampleMask)
+	{
+		static const float DefaultBlendFactor[4] = { 1, 1, 1, 1 };
+		if (!blendFactor)
+		{
+			blendFactor = DefaultBlendFactor;
+		}
+
+		bool matches = IsKnown(BlendBit) && mBlendState == state && mSampleMask == sampleMask &&
+			std::memcmp(mBlendFactor, blendFactor, sizeof(mBlendFactor)) == 0;
+		if (Issue(matches))
+		{
+			mBackend->SetBlendState(state, blendFactor, sampleMask);
+			mBlendState = state;
+			std::memcpy(mBlendFactor, blendFactor, sizeof(mBlendFactor));
+			mSampleMask = sampleMask;
+			mKnown |= BlendBit;
+		}
+	}
+
+	void StateTracker::SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef)
+	{
+		if (Issue(IsKnown(DepthStencilBit) && mDepthStencilState == state && mStencilRef == stencilRef))
+		{
+			mBackend->SetDepthStencilState(state, stencilRef);
+			mDepthStencilState = state;
+			mStencilRef = stencilRef;
+			mKnown |= DepthStencilBit;
+		}
+	}
+
+	void StateTracker::SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil)
+	{
+		bool matches = IsKnown(RenderTargetsBit) && mRenderTargetCount == count && mDepthStencilView == depthStencil &&
+			std::equal(renderTargets, renderTargets + count, mRenderTargets);
+		if (Issue(matches))
+		{
+			mBackend->SetRenderTargets(count, renderTargets, depthStencil);
+			// Binding more targets than are tracked leaves the state unknown
+			if (count <= MaxRenderTargets)
+			{
+				std::copy(renderTargets, renderTargets + count, mRenderTargets);
+				mRenderTargetCount = count;
+				mDepthStencilView = depthStencil;
+				mKnown |= RenderTargetsBit;
+			}
+			else
+			{
+				mKnown &= ~RenderTargetsBit;
+			}
+		}
+	}
+
+	void StateTracker::SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets)
+	{
+		VertexBufferBinding bindings[MaxVertexBuffers];
+		const std::uint32_t trackedCount = std::min(count, MaxVertexBuffers);
+		for (std::uint32_t i = 0; i < trackedCount; ++i)
+		{
+			bindings[i] = { buffers[i], strides[i], offsets[i] };
+		}
+
+		if (Issue(mVertexBuffers.Matches(startSlot, count, bindings)))
+		{
+			mBackend->SetVertexBuffers(startSlot, count, buffers, strides, offsets);
+			mVertexBuffers.Store(startSlot, trackedCount, bindings);
+		}
+	}
+
+	void StateTracker::SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset)
+	{
+		if (Issue(IsKnown(IndexBufferBit) && mIndexBuffer == buffer && mIndexFormat == format && mIndexOffset == offset))
+		{
+			mBackend->SetIndexBuffer(buffer, format, offset);
+			mIndexBuffer = buffer;
+			mIndexFormat = format;
+			mIndexOffset = offset;
+			mKnown |= IndexBufferBit;
+		}
+	}
+
+	void StateTracker::SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		if (Issue(mVSConstantBuffers.Matches(startSlot, count, buffers)))
+		{
+			mBackend->SetVSConstantBuffers(startSlot, count, buffers);
+			mVSConstantBuffers.Store(startSlot, count, buffers);
+		}
+	}
+
+	void StateTracker::SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers)
+	{
+		if (Issue(mPSConstantBuffers.Matches(startSlot, count, buffers)))
+		{
+			mBackend->SetPSConstantBuffers(startSlot, count, buffers);
+			mPSConstantBuffers.Store(startSlot, count, buffers);
+		}
+	}
+
+	void StateTracker::SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources)
+	{
+		if (Issue(mPSShaderResources.Matches(startSlot, count, resources)))
+		{
+			mBackend->SetPSShaderResources(startSlot, count, resources);
+			mPSShaderResources.Store(startSlot, count, resources);
+		}
+	}
+
+	const StateTrackerStats& StateTracker::GetStats() const
+	{
+		return mStats;
+	}
+
+	void StateTracker::ResetStats()
+	{
+		mStats = StateTrackerStats();
+	}
+
+	bool StateTracker::Issue(bool matches)
+	{
+		if (matches)
+		{
+			++mStats.filtered;
+			return false;
+		}
+		++mStats.issued;
+		return true;
+	}
+
+	bool StateTracker::IsKnown(StateBit bit) const
+	{
+		return (mKnown & bit) != 0;
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "GraphicsBackend.h"
+
+namespace renderer
+{
+	/** Number of binds passed on to the backend and dropped because the same value was already bound */
+	struct StateTrackerStats
+	{
+		std::uint64_t issued = 0;
+		std::uint64_t filtered = 0;
+	};
+
+	/**
+	 * Remembers what is bound and only passes binds that change something on to the backend.
+	 * Each setter stands for one API call in the stats.
+	 */
+	class StateTracker
+	{
+	public:
+		static constexpr std::uint32_t MaxRenderTargets = 8;
+		static constexpr std::uint32_t MaxVertexBuffers = 16;
+		static constexpr std::uint32_t MaxConstantBuffers = 14;
+		static constexpr std::uint32_t MaxShaderResources = 32;
+
+		explicit StateTracker(GraphicsBackend* backend = nullptr);
+		void SetBackend(GraphicsBackend* backend);
+		/** Forgets everything bound so the next binds are all issued. Needed when the context is changed directly */
+		void Invalidate();
+		void InvalidateRenderTargets();
+
+		/** Binds the shaders and fixed function state of the pipeline state */
+		void SetPipelineState(const PipelineState* state);
+		void SetVertexShader(ID3D11VertexShader* shader);
+		void SetPixelShader(ID3D11PixelShader* shader);
+		void SetInputLayout(ID3D11InputLayout* layout);
+		void SetPrimitiveTopology(std::uint32_t topology);
+		void SetRasterizerState(ID3D11RasterizerState* state);
+		/** A null blend factor is the Direct3D default of all ones */
+		void SetBlendState(ID3D11BlendState* state, const float* blendFactor, std::uint32_t sampleMask);
+		void SetDepthStencilState(ID3D11DepthStencilState* state, std::uint32_t stencilRef);
+		void SetRenderTargets(std::uint32_t count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil);
+		void SetVertexBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers, const std::uint32_t* strides, const std::uint32_t* offsets);
+		void SetIndexBuffer(ID3D11Buffer* buffer, std::uint32_t format, std::uint32_t offset);
+		void SetVSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers);
+		void SetPSConstantBuffers(std::uint32_t startSlot, std::uint32_t count, ID3D11Buffer* const* buffers);
+		void SetPSShaderResources(std::uint32_t startSlot, std::uint32_t count, ID3D11ShaderResourceView* const* resources);
+
+		const StateTrackerStats& GetStats() const;
+		void ResetStats();
+
+	private:
+		enum StateBit : std::uint32_t
+		{
+			VertexShaderBit = 1 << 0,
+			PixelShaderBit = 1 << 1,
+			InputLayoutBit = 1 << 2,
+			TopologyBit = 1 << 3,
+			RasterizerBit = 1 << 4,
+			BlendBit = 1 << 5,
+			DepthStencilBit = 1 << 6,
+			RenderTargetsBit = 1 << 7,
+			IndexBufferBit = 1 << 8
+		};
+
+		/** Bound values of one array of slots. Bit i of known is set when slot i holds a known value */
+		template<typename T, std::uint32_t SlotCount>
+		struct SlotArray
+		{
+			T slots[SlotCount] = {};
+			std::uint32_t known = 0;
+
+			bool Matches(std::uint32_t startSlot, std::uint32_t count, const T* values) const;
+			void Store(std::uint32_t startSlot, std::uint32_t count, const T* values);
+		};
+
+		struct VertexBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			std::uint32_t stride;
+			std::uint32_t offset;
+
+			bool operator!=(const VertexBufferBinding& other) const
+			{
+				return buffer != other.buffer || stride != other.stride || offset != other.offset;
+			}
+		};
+
+		/** Records whether a bind is needed and updates the stats */
+		bool Issue(bool matches);
+		bool IsKnown(StateBit bit) const;
+
+		GraphicsBackend* mBackend;
+		StateTrackerStats mStats;
+		std::uint32_t mKnown;
+
+		ID3D11VertexShader* mVertexShader;
+		ID3D11PixelShader* mPixelShader;
+		ID3D11InputLayout* mInputLayout;
+		std::uint32_t mTopology;
+		ID3D11RasterizerState* mRasterizerState;
+		ID3D11BlendState* mBlendState;
+		float mBlendFactor[4];
+		std::uint32_t mSampleMask;
+		ID3D11DepthStencilState* mDepthStencilState;
+		std::uint32_t mStencilRef;
+		std::uint32_t mRenderTargetCount;
+		ID3D11RenderTargetView* mRenderTargets[MaxRenderTargets];
+		ID3D11DepthStencilView* mDepthStencilView;
+		ID3D11Buffer* mIndexBuffer;
+		std::uint32_t mIndexFormat;
+		std::uint32_t mIndexOffset;
+
+		SlotArray<VertexBufferBinding, MaxVertexBuffers> mVertexBuffers;
+		SlotArray<ID3D11Buffer*, MaxConstantBuffers> mVSConstantBuffers;
+		SlotArray<ID3D11Buffer*, MaxConstantBuffers> mPSConstantBuffers;
+		SlotArray<ID3D11ShaderResourceView*, MaxShaderResources> mPSShaderResources;
+	};
+}
@@ -0,0 +1,263 @@
+#include "StaticBatcher.h"
+#include "InstanceBuilder.h"
+#include "Profiling/Profiler.h"
+#include <thread>
+
+namespace renderer
+{
+	StaticBatcher::StaticBatcher(const MeshRegistry& meshes, float cellSize, std::uint32_t maxChunkVertices)
+		: mMeshes(meshes), mCellSize(cellSize), mMaxChunkVertices(maxChunkVertices)
+	{
+
+	}
+
+	bool StaticBatcher::CanBatch(const Entity& entity) const
+	{
+		// Meshes too big to share a chunk gain nothing from merging, so they stay instanced
+		if (!entity.material || !mMeshes.IsLoaded(entity.mesh))
+		{
+			return false;
+		}
+		const std::uint32_t vertexCount = mMeshes.GetGeometry(entity.mesh).vertexCount;
+		return vertexCount > 0 && vertexCount <= mMaxChunkVertices;
+	}
+
+	size_t StaticBatcher::CellKeyHash::operator()(const CellKey& key) const
+	{
+		size_t hash = std::hash<const Material*>()(key.material);
+		for (std::int32_t value : { key.x, key.y, key.z })
+		{
+			hash ^= std::hash<std::int32_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+		return hash;
+	}
+
+	void StaticBatcher::Add(const std::shared_ptr<Entity>& entity)
+	{
+		const XMFLOAT3& p = entity->position;
+		const CellKey key = { entity->material.get(), static_cast<std::int32_t>(std::floor(p.x / mCellSize)),
+			static_cast<std::int32_t>(std::floor(p.y / mCellSize)), static_cast<std::int32_t>(std::floor(p.z / mCellSize)) };
+
+		// A cell whose chunk is full starts a new one, so chunks stay small enough to cull well
+		const MeshGeometry& geometry = mMeshes.GetGeometry(entity->mesh);
+		auto cell = mCellChunks.find(key);
+		if (cell == mCellChunks.end() || mChunks[cell->second].vertexCount + geometry.vertexCount > mMaxChunkVertices)
+		{
+			const auto chunkIndex = static_cast<std::uint32_t>(mChunks.size());
+			mChunks.emplace_back();
+			mChunks.back().material = key.material;
+			mBounds.Resize(mChunks.size());
+			cell = mCellChunks.insert_or_assign(key, chunkIndex).first;
+		}
+
+		StaticChunk& chunk = mChunks[cell->second];
+		chunk.entities.push_back(entity.get());
+		// Counted as members are added so fullness is known before the chunk is built
+		chunk.vertexCount += geometry.vertexCount;
+		chunk.indexCount += geometry.indexCount;
+		mEntities[entity.get()] = { entity, cell->second };
+		++mStats.entities;
+		MarkChunkChanged(cell->second);
+	}
+
+	bool StaticBatcher::Remove(const Entity* entity)
+	{
+		auto iter = mEntities.find(entity);
+		if (iter == mEntities.end())
+		{
+			return false;
+		}
+
+		StaticChunk& chunk = mChunks[iter->second.chunk];
+		auto member = std::find(chunk.entities.begin(), chunk.entities.end(), entity);
+		*member = chunk.entities.back();
+		chunk.entities.pop_back();
+		const MeshGeometry& geometry = mMeshes.GetGeometry(entity->mesh);
+		chunk.vertexCount -= geometry.vertexCount;
+		chunk.indexCount -= geometry.indexCount;
+		MarkChunkChanged(iter->second.chunk);
+		mEntities.erase(iter);
+		--mStats.entities;
+		return true;
+	}
+
+	void StaticBatcher::MarkChanged(const Entity* entity)
+	{
+		auto iter = mEntities.find(entity);
+		if (iter != mEntities.end())
+		{
+			MarkChunkChanged(iter->second.chunk);
+		}
+	}
+
+	void StaticBatcher::MarkChunkChanged(std::uint32_t chunkIndex)
+	{
+		if (!mChunks[chunkIndex].dirty)
+		{
+			mChunks[chunkIndex].dirty = true;
+			mDirtyChunks.push_back(chunkIndex);
+		}
+	}
+
+	bool StaticBatcher::HasChanges() const
+	{
+		return !mDirtyChunks.empty();
+	}
+
+	void StaticBatcher::Build(std::uint32_t threadCount)
+	{
+		PROFILE_ZONE("StaticBatcher::Build");
+		mRebuiltChunks.swap(mDirtyChunks);
+		mDirtyChunks.clear();
+		mStats.rebuilt = static_cast<std::uint32_t>(mRebuiltChunks.size());
+		mStats.threads = 0;
+		mStats.buildMilliseconds = 0;
+		if (mRebuiltChunks.empty())
+		{
+			return;
+		}
+
+		const std::uint64_t start = Profiler::Now();
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		threadCount = std::min<std::uint32_t>(threadCount, mStats.rebuilt);
+
+		// Chunks vary in size, so threads take the next one as they finish rather than a fixed share
+		std::atomic<std::uint32_t> next(0);
+		auto buildChunks = [&]()
+		{
+			for (std::uint32_t i = next.fetch_add(1, std::memory_order_relaxed); i < mRebuiltChunks.size();
+				i = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				RebuildChunk(mRebuiltChunks[i]);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+		{
+			workers.emplace_back(buildChunks);
+		}
+		buildChunks();
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		mStats.threads = threadCount;
+		mStats.buildMilliseconds = (Profiler::Now() - start) / 1e6;
+		mStats.chunks = static_cast<std::uint32_t>(mChunks.size());
+		mStats.vertices = 0;
+		mStats.indices = 0;
+		for (const StaticChunk& chunk : mChunks)
+		{
+			mStats.vertices += chunk.vertexCount;
+			mStats.indices += chunk.indexCount;
+		}
+		UpdateMemory();
+	}
+
+	const std::vector<std::uint32_t>& StaticBatcher::GetRebuiltChunks() const
+	{
+		return mRebuiltChunks;
+	}
+
+	void StaticBatcher::ReleaseRebuiltGeometry()
+	{
+		for (std::uint32_t chunkIndex : mRebuiltChunks)
+		{
+			StaticChunk& chunk = mChunks[chunkIndex];
+			std::vector<Vertex>().swap(chunk.vertices);
+			std::vector<std::uint32_t>().swap(chunk.indices);
+		}
+		mRebuiltChunks.clear();
+		UpdateMemory();
+	}
+
+	const std::vector<StaticChunk>& StaticBatcher::GetChunks() const
+	{
+		return mChunks;
+	}
+
+	const BoundingSpheres& StaticBatcher::GetBounds() const
+	{
+		return mBounds;
+	}
+
+	const StaticBatchStats& StaticBatcher::GetStats() const
+	{
+		return mStats;
+	}
+
+	void StaticBatcher::GetEntities(std::vector<const Entity*>& entities) const
+	{
+		for (const auto& batched : mEntities)
+		{
+			entities.push_back(batched.first);
+		}
+	}
+
+	void StaticBatcher::RebuildChunk(std::uint32_t chunkIndex)
+	{
+		StaticChunk& chunk = mChunks[chunkIndex];
+		chunk.dirty = false;
+		chunk.vertices.resize(chunk.vertexCount);
+		chunk.indices.resize(chunk.indexCount);
+
+		XMVECTOR boundsMin = XMVectorReplicate(std::numeric_limits<float>::max());
+		XMVECTOR boundsMax = XMVectorNegate(boundsMin);
+		std::uint32_t vertexBase = 0;
+		std::uint32_t indexBase = 0;
+		for (const Entity* entity : chunk.entities)
+		{
+			const MeshGeometry& geometry = mMeshes.GetGeometry(entity->mesh);
+			const XMMATRIX world = InstanceBuilder::CalculateWorldMatrix(*entity);
+			// Normals go through the inverse transpose so non uniform scales keep them perpendicular
+			const XMMATRIX normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+			for (std::uint32_t i = 0; i < geometry.vertexCount; ++i)
+			{
+				const XMVECTOR position = XMVector3TransformCoord(XMLoadFloat3(&geometry.vertices[i].position), world);
+				const XMVECTOR normal = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&geometry.vertices[i].normal), normalMatrix));
+				Vertex& vertex = chunk.vertices[vertexBase + i];
+				XMStoreFloat3(&vertex.position, position);
+				XMStoreFloat3(&vertex.normal, normal);
+				boundsMin = XMVectorMin(boundsMin, position);
+				boundsMax = XMVectorMax(boundsMax, position);
+			}
+			for (std::uint32_t i = 0; i < geometry.indexCount; ++i)
+			{
+				chunk.indices[indexBase + i] = vertexBase + geometry.indices[i];
+			}
+			vertexBase += geometry.vertexCount;
+			indexBase += geometry.indexCount;
+		}
+
+		// A sphere around the box of the vertices, tightened to the farthest vertex
+		const XMVECTOR center = XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f);
+		XMVECTOR radiusSquared = XMVectorZero();
+		for (const Vertex& vertex : chunk.vertices)
+		{
+			radiusSquared = XMVectorMax(radiusSquared, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertex.position), center)));
+		}
+		XMFLOAT3 sphereCenter;
+		XMStoreFloat3(&sphereCenter, center);
+		mBounds.Set(chunkIndex, sphereCenter, std::sqrt(XMVectorGetX(radiusSquared)));
+	}
+
+	void StaticBatcher::UpdateMemory()
+	{
+		// Called when building rather than adding, which would make adding quadratic
+		std::uint64_t bytes = sizeof(Entity) * mEntities.size() + GetCapacityBytes(mChunks) + GetCapacityBytes(mDirtyChunks) +
+			GetCapacityBytes(mRebuiltChunks) + GetCapacityBytes(mBounds.x) * 4;
+		for (const StaticChunk& chunk : mChunks)
+		{
+			bytes += GetCapacityBytes(chunk.entities) + GetCapacityBytes(chunk.vertices) + GetCapacityBytes(chunk.indices);
+		}
+		// Map nodes are roughly a pointer, the entry and the cached hash
+		bytes += (mCellChunks.size() + mEntities.size()) * 4 * sizeof(void*) + mEntities.size() * sizeof(BatchedEntity);
+		mMemory.Set(bytes);
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "MeshRegistry.h"
+#include "Culling/ViewCuller.h"
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	/** Static entities of one material in one grid cell, merged into a single mesh in world space */
+	struct StaticChunk
+	{
+		const Material* material = nullptr;
+		std::vector<const Entity*> entities;
+		// World space geometry from the last rebuild. Released once it has been uploaded
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+		std::uint32_t vertexCount = 0;
+		std::uint32_t indexCount = 0;
+		bool dirty = false;
+	};
+
+	struct StaticBatchStats
+	{
+		std::uint32_t chunks = 0;
+		std::uint32_t entities = 0;
+		std::uint64_t vertices = 0;
+		std::uint64_t indices = 0;
+		// Chunks rebuilt by the last Build, the threads it used and how long it took
+		std::uint32_t rebuilt = 0;
+		std::uint32_t threads = 0;
+		double buildMilliseconds = 0;
+	};
+
+	/**
+	 * Merges static entities into chunks of pre-transformed geometry so a chunk is culled and drawn as one mesh
+	 * with one draw and no instance data. Entities are grouped by material and by the grid cell of their position,
+	 * which keeps chunks spatially tight, and a cell that fills up starts another chunk. Only chunks with a
+	 * changed or new member are rebuilt, spread over worker threads.
+	 */
+	class StaticBatcher
+	{
+	public:
+		static constexpr float DefaultCellSize = 32.0f;
+		static constexpr std::uint32_t DefaultMaxChunkVertices = 64 * 1024;
+
+		/** Geometry of the entities' meshes comes from the registry, which has to outlive the batcher */
+		StaticBatcher(const MeshRegistry& meshes, float cellSize = DefaultCellSize, std::uint32_t maxChunkVertices = DefaultMaxChunkVertices);
+
+		/** Whether the entity can be batched. Entities without a material or geometry, or with more vertices than a chunk holds, cannot */
+		bool CanBatch(const Entity& entity) const;
+
+		/** Adds the entity to the chunk of its material and cell. Its chunk is rebuilt on the next Build */
+		void Add(const std::shared_ptr<Entity>& entity);
+		/** Takes the entity out of its chunk, which is rebuilt on the next Build. Returns false if it was not added */
+		bool Remove(const Entity* entity);
+		/** Rebuilds the entity's chunk on the next Build. The entity stays in its chunk even if it moved cell */
+		void MarkChanged(const Entity* entity);
+		bool HasChanges() const;
+
+		/** Rebuilds every changed chunk. A thread count of 0 uses every hardware thread */
+		void Build(std::uint32_t threadCount = 0);
+		/** Chunks rebuilt by the last Build, whose geometry is waiting to be uploaded */
+		const std::vector<std::uint32_t>& GetRebuiltChunks() const;
+		/** Frees the geometry of the rebuilt chunks once the renderer has uploaded it */
+		void ReleaseRebuiltGeometry();
+
+		const std::vector<StaticChunk>& GetChunks() const;
+		/** World bounds of every chunk, for culling them like entities */
+		const BoundingSpheres& GetBounds() const;
+		const StaticBatchStats& GetStats() const;
+		/** Appends every batched entity */
+		void GetEntities(std::vector<const Entity*>& entities) const;
+
+	private:
+		struct CellKey
+		{
+			const Material* material;
+			std::int32_t x, y, z;
+
+			bool operator==(const CellKey& other) const
+			{
+				return material == other.material && x == other.x && y == other.y && z == other.z;
+			}
+		};
+
+		struct CellKeyHash
+		{
+			size_t operator()(const CellKey& key) const;
+		};
+
+		/** A batched entity, kept alive like the scene entity lists, and its chunk */
+		struct BatchedEntity
+		{
+			std::shared_ptr<Entity> entity;
+			std::uint32_t chunk;
+		};
+
+		void MarkChunkChanged(std::uint32_t chunkIndex);
+		void RebuildChunk(std::uint32_t chunkIndex);
+		void UpdateMemory();
+
+		const MeshRegistry& mMeshes;
+		float mCellSize;
+		std::uint32_t mMaxChunkVertices;
+		std::vector<StaticChunk> mChunks;
+		BoundingSpheres mBounds;
+		// Chunk each cell is filling, and every batched entity
+		std::unordered_map<CellKey, std::uint32_t, CellKeyHash> mCellChunks;
+		std::unordered_map<const Entity*, BatchedEntity> mEntities;
+		std::vector<std::uint32_t> mDirtyChunks;
+		std::vector<std::uint32_t> mRebuiltChunks;
+		StaticBatchStats mStats;
+		TrackedMemory mMemory = TrackedMemory(MemoryTag::StaticBatches);
+	};
+}
@@ -0,0 +1,314 @@
+#include "FramePipeline.h"
+#include "Camera/Camera.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	FramePipeline::FramePipeline()
+		: mFrameIndex(1), mBeginTime(Profiler::Now()), mNextId(0), mEntityCount(0), mConfirmedFrame(0), mSpotLight(), mHasSpotLight(false),
+		mRenderEntityCount(0), mFrame(nullptr), mAcquiredFrame(0), mPublishedFrame(0), mAcquiredCount(0), mSkipped(0), mSleeping(0),
+		mClosed(false)
+	{
+	}
+
+	void FramePipeline::BeginFrame()
+	{
+		mBeginTime = Profiler::Now();
+	}
+
+	std::uint32_t FramePipeline::AddEntity(const Entity& entity)
+	{
+		++mEntityCount;
+		if (mFreeIds.empty())
+		{
+			const std::uint32_t id = mNextId++;
+			mAdded.push_back({ mFrameIndex, id, entity });
+			mTransforms.push_back({ id, entity.position, entity.rotation, entity.scale });
+			mMovedFrames.push_back(0);
+			return id;
+		}
+
+		// Moves of the entity that had the id were confirmed with its removal, so none are listed any more
+		const std::uint32_t id = mFreeIds.back();
+		mFreeIds.pop_back();
+		mAdded.push_back({ mFrameIndex, id, entity });
+		mTransforms[id] = { id, entity.position, entity.rotation, entity.scale };
+		mMovedFrames[id] = 0;
+		return id;
+	}
+
+	void FramePipeline::RemoveEntity(std::uint32_t id)
+	{
+		assert(id < mNextId);
+		mRemoved.push_back({ mFrameIndex, id });
+		--mEntityCount;
+	}
+
+	void FramePipeline::SetTransform(std::uint32_t id, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+	{
+		assert(id < mNextId);
+		mTransforms[id] = { id, position, rotation, scale };
+		if (mMovedFrames[id] <= mConfirmedFrame)
+		{
+			mMoved.push_back(id);
+		}
+		mMovedFrames[id] = mFrameIndex;
+	}
+
+	std::uint32_t FramePipeline::AddPointLight(const PointLight& light)
+	{
+		mPointLights.push_back(light);
+		return static_cast<std::uint32_t>(mPointLights.size() - 1);
+	}
+
+	void FramePipeline::SetPointLight(std::uint32_t id, const PointLight& light)
+	{
+		mPointLights[id] = light;
+	}
+
+	void FramePipeline::SetSpotLight(const SpotLight& light)
+	{
+		mSpotLight = light;
+		mHasSpotLight = true;
+	}
+
+	void FramePipeline::SetCamera(std::uint32_t index, const Camera& camera)
+	{
+		if (index >= mCameras.size())
+		{
+			mCameras.resize(index + 1, { { 0, 0, 0 }, { 0, 0, 0, 1 } });
+		}
+		mCameras[index] = { camera.GetPosition(), camera.GetOrientation() };
+	}
+
+	std::uint64_t FramePipeline::Publish(double frameTime)
+	{
+		PROFILE_ZONE("FramePipeline::Publish");
+		// Changes in frames the render thread has taken are on its side already. Additions and removals are in
+		// frame order, and a moved entity stays listed until a frame after its last move is taken
+		const std::uint64_t confirmed = mAcquiredFrame.load(std::memory_order_acquire);
+		if (confirmed > mConfirmedFrame)
+		{
+			mAdded.erase(mAdded.begin(), std::find_if(mAdded.begin(), mAdded.end(), [&](const EntityAddition& addition) { return addition.frameIndex > confirmed; }));
+			// The render side has dropped what a confirmed removal named, so its id can be handed out again
+			const auto removedEnd = std::find_if(mRemoved.begin(), mRemoved.end(), [&](const EntityRemoval& removal) { return removal.frameIndex > confirmed; });
+			for (auto removal = mRemoved.begin(); removal != removedEnd; ++removal)
+			{
+				mFreeIds.push_back(removal->id);
+			}
+			mRemoved.erase(mRemoved.begin(), removedEnd);
+			mMoved.erase(std::remove_if(mMoved.begin(), mMoved.end(), [&](std::uint32_t id) { return mMovedFrames[id] <= confirmed; }), mMoved.end());
+			mConfirmedFrame = confirmed;
+		}
+
+		// The buffer is filled from scratch, so one that comes back untaken needs nothing carried over
+		FrameSnapshot& frame = mBuffers.GetWriteBuffer();
+		frame.frameIndex = mFrameIndex;
+		frame.frameTime = frameTime;
+		frame.beginTime = mBeginTime;
+		frame.entityCount = mEntityCount;
+		frame.added.assign(mAdded.begin(), mAdded.end());
+		frame.removed.assign(mRemoved.begin(), mRemoved.end());
+		frame.transforms.clear();
+		for (std::uint32_t id : mMoved)
+		{
+			frame.transforms.push_back(mTransforms[id]);
+		}
+		frame.pointLights.assign(mPointLights.begin(), mPointLights.end());
+		frame.spotLight = mSpotLight;
+		frame.hasSpotLight = mHasSpotLight;
+		frame.cameras.assign(mCameras.begin(), mCameras.end());
+		frame.publishTime = Profiler::Now();
+		if (mBuffers.Publish())
+		{
+			mSkipped.fetch_add(1, std::memory_order_relaxed);
+		}
+		mPublishedFrame.store(mFrameIndex, std::memory_order_release);
+		Wake();
+
+		mBeginTime = frame.publishTime;
+		return mFrameIndex++;
+	}
+
+	void FramePipeline::WaitForAcquired(std::uint64_t frameIndex)
+	{
+		if (mAcquiredFrame.load(std::memory_order_acquire) >= frameIndex)
+		{
+			return;
+		}
+		PROFILE_ZONE("FramePipeline::WaitForAcquired");
+		std::unique_lock<std::mutex> lock(mMutex);
+		++mSleeping;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		mWake.wait(lock, [&]() { return mClosed || mAcquiredFrame.load(std::memory_order_acquire) >= frameIndex; });
+		--mSleeping;
+	}
+
+	void FramePipeline::Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mClosed = true;
+		}
+		mWake.notify_all();
+	}
+
+	const FrameSnapshot* FramePipeline::Acquire()
+	{
+		mChanges.added.clear();
+		mChanges.removed.clear();
+		mChanges.addedPointLights.clear();
+		mChanges.addedSpotLight.reset();
+		const FrameSnapshot* frame = mBuffers.Acquire();
+		if (!frame)
+		{
+			return nullptr;
+		}
+
+		PROFILE_ZONE("FramePipeline::Acquire");
+		Apply(*frame);
+		mFrame = frame;
+		mAcquiredCount.fetch_add(1, std::memory_order_relaxed);
+		mAcquiredFrame.store(frame->frameIndex, std::memory_order_release);
+		Wake();
+		return frame;
+	}
+
+	const FrameSnapshot* FramePipeline::WaitForFrame()
+	{
+		for (;;)
+		{
+			if (const FrameSnapshot* frame = Acquire())
+			{
+				return frame;
+			}
+
+			// Counted asleep before looking again, so either this sees the frame or publishing sees it asleep
+			std::unique_lock<std::mutex> lock(mMutex);
+			if (mClosed && !mBuffers.HasNew())
+			{
+				return nullptr;
+			}
+			++mSleeping;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			mWake.wait(lock, [&]() { return mClosed || mBuffers.HasNew(); });
+			--mSleeping;
+		}
+	}
+
+	const FrameChanges& FramePipeline::GetChanges() const
+	{
+		return mChanges;
+	}
+
+	void FramePipeline::ApplyCamera(std::uint32_t index, Camera& camera) const
+	{
+		if (mFrame && index < mFrame->cameras.size())
+		{
+			camera.SetPosition(mFrame->cameras[index].position);
+			camera.SetOrientation(mFrame->cameras[index].orientation);
+		}
+	}
+
+	const std::shared_ptr<Entity>& FramePipeline::GetEntity(std::uint32_t id) const
+	{
+		static const std::shared_ptr<Entity> none;
+		return id < mEntities.size() ? mEntities[id] : none;
+	}
+
+	std::uint32_t FramePipeline::GetEntityCount() const
+	{
+		return mRenderEntityCount;
+	}
+
+	FramePipelineStats FramePipeline::GetStats() const
+	{
+		FramePipelineStats stats;
+		stats.published = mPublishedFrame.load();
+		stats.acquired = mAcquiredCount.load();
+		stats.skipped = mSkipped.load();
+		return stats;
+	}
+
+	void FramePipeline::Apply(const FrameSnapshot& frame)
+	{
+		// Frames taken before may have had some of these changes already. Removals go first so an entity added
+		// and removed between two frames taken is never made
+		const std::uint64_t applied = mAcquiredFrame.load(std::memory_order_relaxed);
+		for (const EntityRemoval& removal : frame.removed)
+		{
+			if (removal.frameIndex <= applied)
+			{
+				continue;
+			}
+			if (removal.id >= mRemovedFrames.size())
+			{
+				mRemovedFrames.resize(removal.id + 1, 0);
+			}
+			mRemovedFrames[removal.id] = removal.frameIndex;
+			if (removal.id < mEntities.size() && mEntities[removal.id])
+			{
+				mChanges.removed.push_back(std::move(mEntities[removal.id]));
+				--mRenderEntityCount;
+			}
+		}
+		for (const EntityAddition& addition : frame.added)
+		{
+			if (addition.frameIndex <= applied || (addition.id < mRemovedFrames.size() && mRemovedFrames[addition.id] >= addition.frameIndex))
+			{
+				continue;
+			}
+			if (addition.id >= mEntities.size())
+			{
+				mEntities.resize(addition.id + 1);
+			}
+			mEntities[addition.id] = std::make_shared<Entity>(addition.entity);
+			mChanges.added.push_back(mEntities[addition.id]);
+			++mRenderEntityCount;
+		}
+		for (const EntityTransform& transform : frame.transforms)
+		{
+			if (transform.id < mEntities.size() && mEntities[transform.id])
+			{
+				Entity& entity = *mEntities[transform.id];
+				entity.position = transform.position;
+				entity.rotation = transform.rotation;
+				entity.scale = transform.scale;
+			}
+		}
+
+		// Lights are whole in every frame and only ever added
+		for (size_t i = 0; i < frame.pointLights.size(); ++i)
+		{
+			if (i == mRenderPointLights.size())
+			{
+				mRenderPointLights.push_back(std::make_shared<PointLight>(frame.pointLights[i]));
+				mChanges.addedPointLights.push_back(mRenderPointLights.back());
+			}
+			*mRenderPointLights[i] = frame.pointLights[i];
+		}
+		if (frame.hasSpotLight)
+		{
+			if (!mRenderSpotLight)
+			{
+				mRenderSpotLight = std::make_shared<SpotLight>();
+				mChanges.addedSpotLight = mRenderSpotLight;
+			}
+			*mRenderSpotLight = frame.spotLight;
+		}
+	}
+
+	void FramePipeline::Wake()
+	{
+		// A waiting thread counts itself before it looks at what it waits on, so either it sees the change or
+		// this sees it waiting. The lock is taken so the wake cannot come between its look and its wait
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mSleeping.load(std::memory_order_relaxed) > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+			}
+			mWake.notify_all();
+		}
+	}
+}
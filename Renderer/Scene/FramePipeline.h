@@ -0,0 +1,198 @@
+#pragma once
+
+#include "Base/TripleBuffer.h"
+#include "Rendering/DataTypes.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace renderer
+{
+	class Camera;
+
+	/** Where a camera is and which way it faces, which is all of it that changes from frame to frame */
+	struct CameraPose
+	{
+		XMFLOAT3 position;
+		XMFLOAT4 orientation;
+	};
+
+	/** Where an entity the simulation moved is in a frame */
+	struct EntityTransform
+	{
+		std::uint32_t id;
+		XMFLOAT3 position;
+		XMFLOAT4 rotation;
+		XMFLOAT3 scale;
+	};
+
+	/** An entity the simulation added in a frame, with where it starts */
+	struct EntityAddition
+	{
+		std::uint64_t frameIndex;
+		std::uint32_t id;
+		Entity entity;
+	};
+
+	struct EntityRemoval
+	{
+		std::uint64_t frameIndex;
+		std::uint32_t id;
+	};
+
+	/**
+	 * What the simulation hands the render thread for one frame. Additions, removals and transforms are every
+	 * change the render thread has not yet confirmed taking, so nothing is lost when it skips a frame. Lights and
+	 * cameras are whole.
+	 */
+	struct FrameSnapshot
+	{
+		// Counts from one
+		std::uint64_t frameIndex = 0;
+		double frameTime = 0;
+		// From Profiler::Now, when the simulation began the frame and when it published it
+		std::uint64_t beginTime = 0;
+		std::uint64_t publishTime = 0;
+		// Entities in the scene as of this frame, which the render side should have once it is applied
+		std::uint32_t entityCount = 0;
+		std::vector<EntityAddition> added;
+		std::vector<EntityRemoval> removed;
+		std::vector<EntityTransform> transforms;
+		// Indexed by light id
+		std::vector<PointLight> pointLights;
+		SpotLight spotLight = {};
+		bool hasSpotLight = false;
+		std::vector<CameraPose> cameras;
+	};
+
+	/** What the last frame taken changed on the render side, to give to the renderer before drawing it */
+	struct FrameChanges
+	{
+		std::vector<std::shared_ptr<Entity>> added;
+		std::vector<std::shared_ptr<Entity>> removed;
+		std::vector<std::shared_ptr<PointLight>> addedPointLights;
+		// Set on the frame the spot light first appears
+		std::shared_ptr<SpotLight> addedSpotLight;
+	};
+
+	struct FramePipelineStats
+	{
+		std::uint64_t published = 0;
+		std::uint64_t acquired = 0;
+		// Published frames replaced by a newer one before the render thread took them
+		std::uint64_t skipped = 0;
+	};
+
+	/**
+	 * Lets the simulation write frame N+1 while a render thread draws frame N. The simulation describes the scene
+	 * through ids rather than sharing entities with the renderer, and publishes a snapshot of each frame through a
+	 * triple buffer, so neither thread takes a lock or waits on the other while both have work. The render thread
+	 * keeps its own copies of the entities and lights, which it brings up to date from each snapshot it takes and
+	 * which are what the renderer holds.
+	 *
+	 * Additions and removals stay in the snapshots until the render thread has taken a frame that has them, and
+	 * moved entities until it has taken a frame with their latest transform, so frames it skips lose nothing.
+	 * Static entities should not be moved through the pipeline, as the renderer would not rebuild their batches.
+	 */
+	class FramePipeline
+	{
+	public:
+		FramePipeline();
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+
+		// Simulation thread
+
+		/** Marks the start of the next frame, for measuring latency. Otherwise it starts when the last was published */
+		void BeginFrame();
+		/**
+		 * Adds the entity from the next published frame. Ids count up from zero, and the id of a removed entity is
+		 * reused once the render thread has taken the frame that removed it
+		 */
+		std::uint32_t AddEntity(const Entity& entity);
+		void RemoveEntity(std::uint32_t id);
+		void SetTransform(std::uint32_t id, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale);
+		/** Lights cannot be removed, as the renderer cannot remove them. Ids count up from zero */
+		std::uint32_t AddPointLight(const PointLight& light);
+		void SetPointLight(std::uint32_t id, const PointLight& light);
+		void SetSpotLight(const SpotLight& light);
+		/** Poses of the cameras the frame is drawn from, indexed as the render thread's cameras are */
+		void SetCamera(std::uint32_t index, const Camera& camera);
+		/** Hands the frame to the render thread and starts the next one. Returns the index of the published frame */
+		std::uint64_t Publish(double frameTime);
+		/**
+		 * Waits until the render thread has taken the frame, or the pipeline is closed. Waiting for the frame just
+		 * published keeps the simulation one frame ahead of rendering rather than running free
+		 */
+		void WaitForAcquired(std::uint64_t frameIndex);
+		/** Stops waits on both threads. Frames already published can still be taken */
+		void Close();
+
+		// Render thread
+
+		/**
+		 * Takes the newest published frame and applies it to the render side copies, or returns null if nothing
+		 * was published since the last call. GetChanges then says what to give to the renderer
+		 */
+		const FrameSnapshot* Acquire();
+		/** As Acquire, waiting for a frame to be published. Returns null once the pipeline is closed and drained */
+		const FrameSnapshot* WaitForFrame();
+		const FrameChanges& GetChanges() const;
+		/** Moves the camera to its pose in the frame taken last. Cameras the frame has no pose for are left alone */
+		void ApplyCamera(std::uint32_t index, Camera& camera) const;
+		/** Render side copy of an entity, which is null before it is added and after it is removed */
+		const std::shared_ptr<Entity>& GetEntity(std::uint32_t id) const;
+		/** Entities on the render side */
+		std::uint32_t GetEntityCount() const;
+
+		FramePipelineStats GetStats() const;
+
+	private:
+		void Apply(const FrameSnapshot& frame);
+		/** Wakes the other thread if it is waiting. Called after changing what it waits on */
+		void Wake();
+
+		TripleBuffer<FrameSnapshot> mBuffers;
+
+		// Simulation side. Changes are kept until the render thread confirms taking a frame that has them
+		std::uint64_t mFrameIndex;
+		std::uint64_t mBeginTime;
+		std::uint32_t mNextId;
+		std::uint32_t mEntityCount;
+		std::vector<EntityAddition> mAdded;
+		std::vector<EntityRemoval> mRemoved;
+		// Ids of removed entities both sides have let go of, so everything indexed by id stays as big as the most
+		// entities there were at once
+		std::vector<std::uint32_t> mFreeIds;
+		// Indexed by entity id: where each moved entity is now, the frame it last moved in, and whether its id is
+		// in the list of moved entities not yet confirmed
+		std::vector<EntityTransform> mTransforms;
+		std::vector<std::uint64_t> mMovedFrames;
+		std::vector<std::uint32_t> mMoved;
+		std::uint64_t mConfirmedFrame;
+		std::vector<PointLight> mPointLights;
+		SpotLight mSpotLight;
+		bool mHasSpotLight;
+		std::vector<CameraPose> mCameras;
+
+		// Render side, indexed by entity id. The frame each id was last removed in is remembered, so an addition
+		// taken in the same frame as its removal is not made. A reused id is only added after that frame
+		std::vector<std::shared_ptr<Entity>> mEntities;
+		std::vector<std::uint64_t> mRemovedFrames;
+		std::uint32_t mRenderEntityCount;
+		std::vector<std::shared_ptr<PointLight>> mRenderPointLights;
+		std::shared_ptr<SpotLight> mRenderSpotLight;
+		FrameChanges mChanges;
+		const FrameSnapshot* mFrame;
+
+		// Last frame the render thread applied, which the simulation reads to let go of changes it has
+		alignas(64) std::atomic<std::uint64_t> mAcquiredFrame;
+		std::atomic<std::uint64_t> mPublishedFrame;
+		std::atomic<std::uint64_t> mAcquiredCount;
+		std::atomic<std::uint64_t> mSkipped;
+		// Waiting sleeps on the condition, and the other thread only takes the lock to wake a sleeper
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::atomic<std::uint32_t> mSleeping;
+		std::atomic<bool> mClosed;
+	};
+}
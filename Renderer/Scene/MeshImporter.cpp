@@ -0,0 +1,1579 @@
+#include "MeshImporter.h"
+#include "Memory/MappedFile.h"
+#include "Profiling/Profiler.h"
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+namespace renderer
+{
+	namespace
+	{
+		// OBJ files are split into at least this much text per chunk, so small files are not spread over threads
+		constexpr size_t MinObjChunkBytes = 1 << 20;
+		// Deeper JSON and node hierarchies are treated as broken, which also stops cycles between nodes
+		constexpr std::uint32_t MaxDepth = 64;
+
+		/** Calls func with every index below count, spread over the threads */
+		template<typename Func>
+		void ForEachParallel(size_t count, std::uint32_t threadCount, Func&& func)
+		{
+			// Chunks vary in size, so threads take the next one as they finish rather than a fixed share
+			std::atomic<size_t> next(0);
+			auto work = [&]()
+			{
+				for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+					i = next.fetch_add(1, std::memory_order_relaxed))
+				{
+					func(i);
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threadCount - 1);
+			for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+			{
+				workers.emplace_back(work);
+			}
+			work();
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		bool IsDigit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		const char* SkipSpaces(const char* current, const char* end)
+		{
+			while (current < end && (*current == ' ' || *current == '\t' || *current == '\r'))
+			{
+				++current;
+			}
+			return current;
+		}
+
+		/**
+		 * Reads a decimal number such as -1.5e3 without going past end, which strtod would do on text that is not
+		 * null terminated. Up to 19 significant digits are kept, which is plenty for floats
+		 */
+		bool ParseNumber(const char*& current, const char* end, double& value)
+		{
+			static constexpr double Powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+				1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+			const char* c = current;
+			bool negative = false;
+			if (c < end && (*c == '-' || *c == '+'))
+			{
+				negative = *c == '-';
+				++c;
+			}
+
+			std::uint64_t mantissa = 0;
+			std::int32_t exponent = 0;
+			std::uint32_t digits = 0;
+			std::uint32_t significant = 0;
+			auto addDigit = [&](char digit, bool fraction)
+			{
+				if (significant < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<std::uint32_t>(digit - '0');
+					significant += mantissa != 0;
+					exponent -= fraction;
+				}
+				else
+				{
+					exponent += !fraction;
+				}
+				++digits;
+			};
+			for (; c < end && IsDigit(*c); ++c)
+			{
+				addDigit(*c, false);
+			}
+			if (c < end && *c == '.')
+			{
+				for (++c; c < end && IsDigit(*c); ++c)
+				{
+					addDigit(*c, true);
+				}
+			}
+			if (digits == 0)
+			{
+				return false;
+			}
+
+			if (c < end && (*c == 'e' || *c == 'E'))
+			{
+				++c;
+				bool negativeExponent = false;
+				if (c < end && (*c == '-' || *c == '+'))
+				{
+					negativeExponent = *c == '-';
+					++c;
+				}
+				if (c == end || !IsDigit(*c))
+				{
+					return false;
+				}
+				std::int32_t written = 0;
+				for (; c < end && IsDigit(*c); ++c)
+				{
+					written = std::min(written * 10 + (*c - '0'), 100000);
+				}
+				exponent += negativeExponent ? -written : written;
+			}
+
+			double result = static_cast<double>(mantissa);
+			if (mantissa != 0 && exponent != 0)
+			{
+				if (exponent > 0 && exponent <= 22)
+				{
+					result *= Powers[exponent];
+				}
+				else if (exponent < 0 && exponent >= -22)
+				{
+					result /= Powers[-exponent];
+				}
+				else
+				{
+					result *= std::pow(10.0, exponent);
+				}
+			}
+			value = negative ? -result : result;
+			current = c;
+			return true;
+		}
+
+		bool ParseFloat(const char*& current, const char* end, float& value)
+		{
+			double number;
+			current = SkipSpaces(current, end);
+			if (!ParseNumber(current, end, number))
+			{
+				return false;
+			}
+			value = static_cast<float>(number);
+			return std::isfinite(value);
+		}
+
+		/** Reads a signed integer, saturating far beyond any index a mesh can have so it fails the range check */
+		bool ParseIndex(const char*& current, const char* end, std::int64_t& value)
+		{
+			const char* c = current;
+			const bool negative = c < end && *c == '-';
+			c += negative;
+			if (c == end || !IsDigit(*c))
+			{
+				return false;
+			}
+			std::int64_t parsed = 0;
+			for (; c < end && IsDigit(*c); ++c)
+			{
+				parsed = std::min<std::int64_t>(parsed * 10 + (*c - '0'), 1ll << 40);
+			}
+			value = negative ? -parsed : parsed;
+			current = c;
+			return true;
+		}
+
+		void GrowBounds(const XMFLOAT3& position, XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+		{
+			boundsMin = { std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z) };
+			boundsMax = { std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z) };
+		}
+
+		const XMFLOAT3 EmptyMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+		const XMFLOAT3 EmptyMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		/**
+		 * Gives vertices that have no normal, which is a zero one, the sum of the normals of the triangles around
+		 * them, weighted by area. Vertices share a sum through their slot, which for OBJ is their position so
+		 * that corners with different normals elsewhere still agree. Without slots each vertex is its own
+		 */
+		void GenerateNormals(MeshData& mesh, const std::uint32_t* vertexSlots, size_t slotCount)
+		{
+			PROFILE_ZONE("MeshImporter::GenerateNormals");
+			auto slotOf = [&](std::uint32_t vertex)
+			{
+				return vertexSlots ? vertexSlots[vertex] : vertex;
+			};
+
+			std::vector<XMFLOAT3> sums(slotCount, XMFLOAT3(0, 0, 0));
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			{
+				const std::uint32_t* corners = &mesh.indices[i];
+				XMVECTOR a = XMLoadFloat3(&mesh.vertices[corners[0]].position);
+				XMVECTOR b = XMLoadFloat3(&mesh.vertices[corners[1]].position);
+				XMVECTOR c = XMLoadFloat3(&mesh.vertices[corners[2]].position);
+				// Outward for clockwise triangles, with a length of twice the area
+				XMVECTOR normal = XMVector3Cross(b - a, c - a);
+				for (std::uint32_t corner = 0; corner < 3; ++corner)
+				{
+					XMFLOAT3& sum = sums[slotOf(corners[corner])];
+					XMStoreFloat3(&sum, XMLoadFloat3(&sum) + normal);
+				}
+			}
+
+			for (std::uint32_t vertex = 0; vertex < mesh.vertices.size(); ++vertex)
+			{
+				XMFLOAT3& normal = mesh.vertices[vertex].normal;
+				if (normal.x == 0 && normal.y == 0 && normal.z == 0)
+				{
+					XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&sums[slotOf(vertex)])));
+				}
+			}
+		}
+
+		/** Bits of ObjCorner::relative for indices counted back from the chunk's own elements */
+		enum ObjRelative : std::uint32_t
+		{
+			RelativePosition = 1 << 0,
+			RelativeNormal = 1 << 1
+		};
+
+		/** Position and normal of a face corner as written, the key corners are merged on */
+		struct ObjCorner
+		{
+			// Zero based index into every position of the file, or into the chunk's own if RelativePosition is set,
+			// which is negative for elements of earlier chunks
+			std::int32_t position;
+			// As position. -1 without RelativeNormal is no normal
+			std::int32_t normal;
+			std::uint32_t relative;
+
+			bool operator==(const ObjCorner& other) const
+			{
+				return position == other.position && normal == other.normal && relative == other.relative;
+			}
+		};
+
+		/** Open addressing hash table from corners to their index in the chunk's list of distinct corners */
+		class CornerTable
+		{
+		public:
+			/** Gives the index of the corner, adding it to corners when it is new */
+			std::uint32_t Insert(const ObjCorner& corner, std::vector<ObjCorner>& corners)
+			{
+				// Kept at most half full so probes stay short
+				if ((corners.size() + 1) * 2 > mSlots.size())
+				{
+					Grow(corners);
+				}
+				for (size_t slot = Hash(corner) & mMask;; slot = (slot + 1) & mMask)
+				{
+					const std::uint32_t entry = mSlots[slot];
+					if (entry == 0)
+					{
+						corners.push_back(corner);
+						mSlots[slot] = static_cast<std::uint32_t>(corners.size());
+						return mSlots[slot] - 1;
+					}
+					if (corners[entry - 1] == corner)
+					{
+						return entry - 1;
+					}
+				}
+			}
+
+		private:
+			size_t Hash(const ObjCorner& corner) const
+			{
+				// Faces mostly use positions written shortly before them, so runs of 16 positions share a block of
+				// slots to keep lookups in cache, and the blocks are spread over the table so none fills up. The
+				// normal picks one of four slots for the position
+				const std::uint32_t position = static_cast<std::uint32_t>(corner.position);
+				const std::uint32_t normal = (static_cast<std::uint32_t>(corner.normal) ^ corner.relative) * 0x9E3779B1u;
+				const size_t block = static_cast<size_t>(((position >> 4) * 0x9E3779B97F4A7C15ull) >> mBlockShift);
+				return block << 6 | (position & 15) << 2 | normal >> 30;
+			}
+
+			void Grow(const std::vector<ObjCorner>& corners)
+			{
+				const size_t size = std::max<size_t>(mSlots.size() * 2, 4096);
+				// Entries are one past the corner's index so zero is an empty slot
+				mSlots.assign(size, 0);
+				mMask = size - 1;
+				// The top bits of the product are the well mixed ones, and there are as many as there are blocks
+				mBlockShift = 64 + 6;
+				for (size_t bit = size; bit > 1; bit >>= 1)
+				{
+					--mBlockShift;
+				}
+				for (size_t i = 0; i < corners.size(); ++i)
+				{
+					size_t slot = Hash(corners[i]) & mMask;
+					while (mSlots[slot] != 0)
+					{
+						slot = (slot + 1) & mMask;
+					}
+					mSlots[slot] = static_cast<std::uint32_t>(i + 1);
+				}
+			}
+
+			std::vector<std::uint32_t> mSlots;
+			size_t mMask = 0;
+			std::uint32_t mBlockShift = 64;
+		};
+
+		/** A range of whole lines of an OBJ file and what was read from it */
+		struct ObjChunk
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+			std::vector<XMFLOAT3> positions;
+			std::vector<XMFLOAT3> normals;
+			// Distinct corners in the order they were first used, which become the chunk's vertices
+			std::vector<ObjCorner> corners;
+			// Triangles as indices into corners
+			std::vector<std::uint32_t> indices;
+			bool missingNormals = false;
+			// Lines read, which is the line that failed when error is set
+			std::uint64_t lines = 0;
+			std::string error;
+
+			// Where the chunk's elements start among those of the whole file, once every chunk is read
+			size_t positionBase = 0;
+			size_t normalBase = 0;
+			size_t vertexBase = 0;
+			size_t indexBase = 0;
+			XMFLOAT3 boundsMin = EmptyMin;
+			XMFLOAT3 boundsMax = EmptyMax;
+		};
+
+		/** Converts an index as written, which is one based or negative to count back, for ObjCorner */
+		bool ToCornerIndex(std::int64_t written, size_t chunkElements, std::uint32_t relativeBit, std::int32_t& index, std::uint32_t& relative)
+		{
+			const std::int64_t converted = written > 0 ? written - 1 : static_cast<std::int64_t>(chunkElements) + written;
+			if (written == 0 || converted > std::numeric_limits<std::int32_t>::max() || converted < std::numeric_limits<std::int32_t>::min())
+			{
+				return false;
+			}
+			index = static_cast<std::int32_t>(converted);
+			relative |= written < 0 ? relativeBit : 0;
+			return true;
+		}
+
+		/** Reads one line, which ends before end. Positions, normals and faces are read and everything else skipped */
+		bool ParseObjLine(ObjChunk& chunk, CornerTable& table, std::vector<std::uint32_t>& polygon, const char* current, const char* end)
+		{
+			current = SkipSpaces(current, end);
+			const char* keyword = current;
+			while (current < end && *current != ' ' && *current != '\t' && *current != '\r')
+			{
+				++current;
+			}
+			const size_t length = current - keyword;
+
+			if (length == 1 && keyword[0] == 'v')
+			{
+				// Anything after the position, such as w or a colour, is ignored
+				XMFLOAT3 position;
+				if (!ParseFloat(current, end, position.x) || !ParseFloat(current, end, position.y) || !ParseFloat(current, end, position.z))
+				{
+					chunk.error = "could not read position";
+					return false;
+				}
+				chunk.positions.push_back(position);
+			}
+			else if (length == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+			{
+				XMFLOAT3 normal;
+				if (!ParseFloat(current, end, normal.x) || !ParseFloat(current, end, normal.y) || !ParseFloat(current, end, normal.z))
+				{
+					chunk.error = "could not read normal";
+					return false;
+				}
+				chunk.normals.push_back(normal);
+			}
+			else if (length == 1 && keyword[0] == 'f')
+			{
+				// Corners are position, position/texture, position//normal or position/texture/normal
+				polygon.clear();
+				for (current = SkipSpaces(current, end); current < end; current = SkipSpaces(current, end))
+				{
+					std::int64_t position = 0;
+					std::int64_t texture = 0;
+					std::int64_t normal = 0;
+					bool valid = ParseIndex(current, end, position);
+					if (valid && current < end && *current == '/')
+					{
+						++current;
+						if (current < end && *current != '/')
+						{
+							valid = ParseIndex(current, end, texture);
+						}
+						if (valid && current < end && *current == '/')
+						{
+							++current;
+							valid = ParseIndex(current, end, normal);
+						}
+					}
+
+					ObjCorner corner = { 0, -1, 0 };
+					valid = valid && ToCornerIndex(position, chunk.positions.size(), RelativePosition, corner.position, corner.relative);
+					if (valid && normal != 0)
+					{
+						valid = ToCornerIndex(normal, chunk.normals.size(), RelativeNormal, corner.normal, corner.relative);
+					}
+					if (!valid)
+					{
+						chunk.error = "could not read face";
+						return false;
+					}
+					chunk.missingNormals |= normal == 0;
+					polygon.push_back(table.Insert(corner, chunk.corners));
+				}
+				if (polygon.size() < 3)
+				{
+					chunk.error = "face has fewer than three corners";
+					return false;
+				}
+
+				// Polygons are split into a fan around their first corner, turned around to be clockwise
+				for (size_t i = 1; i + 1 < polygon.size(); ++i)
+				{
+					chunk.indices.insert(chunk.indices.end(), { polygon[0], polygon[i + 1], polygon[i] });
+				}
+			}
+			return true;
+		}
+
+		void ParseObjChunk(ObjChunk& chunk)
+		{
+			PROFILE_ZONE("MeshImporter::ParseObjChunk");
+			CornerTable table;
+			std::vector<std::uint32_t> polygon;
+			for (const char* line = chunk.begin; line < chunk.end;)
+			{
+				const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', chunk.end - line));
+				lineEnd = lineEnd ? lineEnd : chunk.end;
+				++chunk.lines;
+				if (!ParseObjLine(chunk, table, polygon, line, lineEnd))
+				{
+					return;
+				}
+				line = lineEnd + 1;
+			}
+		}
+
+		/** Parsed JSON, as a tree of values */
+		struct JsonValue
+		{
+			enum class Type
+			{
+				Null,
+				Boolean,
+				Number,
+				String,
+				Array,
+				Object
+			};
+
+			Type type = Type::Null;
+			bool boolean = false;
+			double number = 0;
+			std::string string;
+			// Elements of an array, or values of an object with their names in names
+			std::vector<JsonValue> items;
+			std::vector<std::string> names;
+
+			/** Member of an object, or null if there is none */
+			const JsonValue* Find(const char* name) const
+			{
+				for (size_t i = 0; i < names.size(); ++i)
+				{
+					if (names[i] == name)
+					{
+						return &items[i];
+					}
+				}
+				return nullptr;
+			}
+
+			/** Element of an array, or null if out of range or not an array */
+			const JsonValue* At(std::uint64_t index) const
+			{
+				return type == Type::Array && index < items.size() ? &items[index] : nullptr;
+			}
+		};
+
+		/** Reads a JSON document from text that does not need to be null terminated */
+		class JsonReader
+		{
+		public:
+			JsonReader(const char* begin, const char* end)
+				: mBegin(begin), mCurrent(begin), mEnd(end)
+			{
+
+			}
+
+			/** Reads the document, which must be one value */
+			bool Read(JsonValue& value)
+			{
+				if (!ReadValue(value, 0))
+				{
+					return false;
+				}
+				SkipSpaces();
+				return mCurrent == mEnd;
+			}
+
+			size_t GetOffset() const
+			{
+				return mCurrent - mBegin;
+			}
+
+		private:
+			bool ReadValue(JsonValue& value, std::uint32_t depth)
+			{
+				SkipSpaces();
+				if (mCurrent == mEnd || depth > MaxDepth)
+				{
+					return false;
+				}
+
+				switch (*mCurrent)
+				{
+				case '{':
+					value.type = JsonValue::Type::Object;
+					return ReadItems('}', value, depth);
+				case '[':
+					value.type = JsonValue::Type::Array;
+					return ReadItems(']', value, depth);
+				case '"':
+					value.type = JsonValue::Type::String;
+					return ReadString(value.string);
+				case 't':
+					value.type = JsonValue::Type::Boolean;
+					value.boolean = true;
+					return ReadWord("true");
+				case 'f':
+					value.type = JsonValue::Type::Boolean;
+					return ReadWord("false");
+				case 'n':
+					return ReadWord("null");
+				default:
+					value.type = JsonValue::Type::Number;
+					return ParseNumber(mCurrent, mEnd, value.number);
+				}
+			}
+
+			/** Reads the elements of an array or the members of an object, starting at the opening bracket */
+			bool ReadItems(char close, JsonValue& value, std::uint32_t depth)
+			{
+				++mCurrent;
+				SkipSpaces();
+				if (mCurrent < mEnd && *mCurrent == close)
+				{
+					++mCurrent;
+					return true;
+				}
+				for (;;)
+				{
+					if (close == '}')
+					{
+						value.names.emplace_back();
+						SkipSpaces();
+						if (mCurrent == mEnd || *mCurrent != '"' || !ReadString(value.names.back()) || !Skip(':'))
+						{
+							return false;
+						}
+					}
+					value.items.emplace_back();
+					if (!ReadValue(value.items.back(), depth + 1))
+					{
+						return false;
+					}
+					SkipSpaces();
+					if (mCurrent < mEnd && *mCurrent == close)
+					{
+						++mCurrent;
+						return true;
+					}
+					if (!Skip(','))
+					{
+						return false;
+					}
+				}
+			}
+
+			bool ReadString(std::string& text)
+			{
+				for (++mCurrent; mCurrent < mEnd; ++mCurrent)
+				{
+					const char c = *mCurrent;
+					if (c == '"')
+					{
+						++mCurrent;
+						return true;
+					}
+					if (c != '\\')
+					{
+						text.push_back(c);
+						continue;
+					}
+
+					if (++mCurrent == mEnd)
+					{
+						return false;
+					}
+					switch (*mCurrent)
+					{
+					case 'b': text.push_back('\b'); break;
+					case 'f': text.push_back('\f'); break;
+					case 'n': text.push_back('\n'); break;
+					case 'r': text.push_back('\r'); break;
+					case 't': text.push_back('\t'); break;
+					case 'u':
+					{
+						std::uint32_t code;
+						if (!ReadHex(code))
+						{
+							return false;
+						}
+						// A high surrogate is followed by the low one of the pair
+						if (code >= 0xD800 && code < 0xDC00 && mEnd - mCurrent > 2 && mCurrent[1] == '\\' && mCurrent[2] == 'u')
+						{
+							mCurrent += 2;
+							std::uint32_t low;
+							if (!ReadHex(low) || low < 0xDC00 || low >= 0xE000)
+							{
+								return false;
+							}
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
+						AppendUtf8(code, text);
+						break;
+					}
+					default:
+						// Quotes, slashes and backslashes stand for themselves
+						text.push_back(*mCurrent);
+						break;
+					}
+				}
+				return false;
+			}
+
+			/** Reads the four digits after \u, leaving the reader on the last */
+			bool ReadHex(std::uint32_t& code)
+			{
+				if (mEnd - mCurrent < 5)
+				{
+					return false;
+				}
+				code = 0;
+				for (int i = 1; i <= 4; ++i)
+				{
+					const char c = mCurrent[i];
+					const std::uint32_t digit = IsDigit(c) ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 16;
+					if (digit > 15)
+					{
+						return false;
+					}
+					code = code * 16 + digit;
+				}
+				mCurrent += 4;
+				return true;
+			}
+
+			static void AppendUtf8(std::uint32_t code, std::string& text)
+			{
+				if (code < 0x80)
+				{
+					text.push_back(static_cast<char>(code));
+				}
+				else if (code < 0x800)
+				{
+					text.push_back(static_cast<char>(0xC0 | (code >> 6)));
+					text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+				else if (code < 0x10000)
+				{
+					text.push_back(static_cast<char>(0xE0 | (code >> 12)));
+					text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+					text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+				else
+				{
+					text.push_back(static_cast<char>(0xF0 | (code >> 18)));
+					text.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+					text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+					text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+				}
+			}
+
+			bool ReadWord(const char* word)
+			{
+				const size_t length = std::strlen(word);
+				if (static_cast<size_t>(mEnd - mCurrent) < length || std::memcmp(mCurrent, word, length) != 0)
+				{
+					return false;
+				}
+				mCurrent += length;
+				return true;
+			}
+
+			bool Skip(char c)
+			{
+				SkipSpaces();
+				if (mCurrent == mEnd || *mCurrent != c)
+				{
+					return false;
+				}
+				++mCurrent;
+				return true;
+			}
+
+			void SkipSpaces()
+			{
+				while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t' || *mCurrent == '\r' || *mCurrent == '\n'))
+				{
+					++mCurrent;
+				}
+			}
+
+			const char* mBegin;
+			const char* mCurrent;
+			const char* mEnd;
+		};
+
+		/** Reads a whole number that fits in a size, as glTF uses for indices, counts and offsets */
+		bool ReadUint(const JsonValue* value, std::uint64_t& result)
+		{
+			if (!value || value->type != JsonValue::Type::Number || value->number < 0 || value->number > 9007199254740992.0 ||
+				value->number != std::floor(value->number))
+			{
+				return false;
+			}
+			result = static_cast<std::uint64_t>(value->number);
+			return true;
+		}
+
+		/** Reads a member that may be left out for its default */
+		bool ReadUint(const JsonValue& object, const char* name, std::uint64_t defaultValue, std::uint64_t& result)
+		{
+			const JsonValue* value = object.Find(name);
+			result = defaultValue;
+			return !value || ReadUint(value, result);
+		}
+
+		/** Reads an array of exactly count numbers */
+		bool ReadFloats(const JsonValue* value, float* values, size_t count)
+		{
+			if (!value || value->type != JsonValue::Type::Array || value->items.size() != count)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (value->items[i].type != JsonValue::Type::Number)
+				{
+					return false;
+				}
+				values[i] = static_cast<float>(value->items[i].number);
+			}
+			return true;
+		}
+
+		bool DecodeBase64(const char* text, size_t length, std::vector<std::uint8_t>& data)
+		{
+			auto decode = [](char c) -> std::uint32_t
+			{
+				if (c >= 'A' && c <= 'Z') return c - 'A';
+				if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+				if (IsDigit(c)) return c - '0' + 52;
+				if (c == '+' || c == '-') return 62;
+				if (c == '/' || c == '_') return 63;
+				return 64;
+			};
+
+			data.clear();
+			data.reserve(length / 4 * 3);
+			std::uint32_t bits = 0;
+			std::uint32_t bitCount = 0;
+			for (size_t i = 0; i < length && text[i] != '='; ++i)
+			{
+				const std::uint32_t value = decode(text[i]);
+				if (value > 63)
+				{
+					return false;
+				}
+				bits = (bits << 6) | value;
+				bitCount += 6;
+				if (bitCount >= 8)
+				{
+					bitCount -= 8;
+					data.push_back(static_cast<std::uint8_t>(bits >> bitCount));
+				}
+			}
+			return true;
+		}
+
+		/** Undoes the %XX escapes of a URI */
+		std::string DecodeUri(const std::string& uri)
+		{
+			std::string decoded;
+			for (size_t i = 0; i < uri.size(); ++i)
+			{
+				unsigned int code;
+				if (uri[i] == '%' && i + 2 < uri.size() && std::sscanf(uri.c_str() + i + 1, "%2x", &code) == 1)
+				{
+					decoded.push_back(static_cast<char>(code));
+					i += 2;
+				}
+				else
+				{
+					decoded.push_back(uri[i]);
+				}
+			}
+			return decoded;
+		}
+
+		/** Bytes of a glTF buffer, mapped from a file, decoded from a data URI or in the binary chunk of a .glb */
+		struct GltfBuffer
+		{
+			const std::uint8_t* data = nullptr;
+			size_t size = 0;
+			std::unique_ptr<MappedFile> file;
+			std::vector<std::uint8_t> decoded;
+		};
+
+		/** Where the elements of an accessor lie in a buffer */
+		struct GltfAccessor
+		{
+			const std::uint8_t* data = nullptr;
+			size_t stride = 0;
+			size_t count = 0;
+			std::uint64_t componentType = 0;
+		};
+
+		enum GltfComponentType : std::uint64_t
+		{
+			GltfUnsignedByte = 5121,
+			GltfUnsignedShort = 5123,
+			GltfUnsignedInt = 5125,
+			GltfFloat = 5126
+		};
+
+		/** Finds an accessor and checks that its elements have the given type and lie inside their buffer */
+		bool GetAccessor(const JsonValue& document, const std::vector<GltfBuffer>& buffers, std::uint64_t index,
+			const char* type, GltfAccessor& accessor, std::string& error)
+		{
+			const JsonValue* accessors = document.Find("accessors");
+			const JsonValue* object = accessors ? accessors->At(index) : nullptr;
+			std::uint64_t viewIndex, offset, count;
+			if (!object || !ReadUint(object->Find("bufferView"), viewIndex) || !ReadUint(*object, "byteOffset", 0, offset) ||
+				!ReadUint(object->Find("componentType"), accessor.componentType) || !ReadUint(object->Find("count"), count))
+			{
+				error = "accessor " + std::to_string(index) + " is missing or has no buffer view";
+				return false;
+			}
+			const JsonValue* typeName = object->Find("type");
+			if (object->Find("sparse") || !typeName || typeName->string != type)
+			{
+				error = "accessor " + std::to_string(index) + " is sparse or not a " + type;
+				return false;
+			}
+
+			std::uint64_t componentSize;
+			switch (accessor.componentType)
+			{
+			case GltfUnsignedByte: componentSize = 1; break;
+			case GltfUnsignedShort: componentSize = 2; break;
+			case GltfUnsignedInt:
+			case GltfFloat: componentSize = 4; break;
+			default:
+				error = "accessor " + std::to_string(index) + " has an unsupported component type";
+				return false;
+			}
+			const std::uint64_t elementSize = componentSize * (typeName->string == "VEC3" ? 3 : 1);
+
+			const JsonValue* views = document.Find("bufferViews");
+			const JsonValue* view = views ? views->At(viewIndex) : nullptr;
+			std::uint64_t bufferIndex, viewOffset, viewLength, stride;
+			if (!view || !ReadUint(view->Find("buffer"), bufferIndex) || !ReadUint(*view, "byteOffset", 0, viewOffset) ||
+				!ReadUint(view->Find("byteLength"), viewLength) || !ReadUint(*view, "byteStride", elementSize, stride))
+			{
+				error = "accessor " + std::to_string(index) + " has no valid buffer view";
+				return false;
+			}
+			// The spec allows strides from 4 to 252 in steps of 4
+			if (view->Find("byteStride") && (stride < 4 || stride > 252 || stride % 4 != 0))
+			{
+				error = "accessor " + std::to_string(index) + " has a byte stride of " + std::to_string(stride);
+				return false;
+			}
+
+			// Numbers in the file go up to 2^53, so the bounds are worked out by subtracting, which cannot wrap
+			if (bufferIndex >= buffers.size() || stride < elementSize || viewOffset > buffers[bufferIndex].size ||
+				viewLength > buffers[bufferIndex].size - viewOffset ||
+				(count > 0 && (elementSize > viewLength || offset > viewLength - elementSize ||
+				count - 1 > (viewLength - elementSize - offset) / stride)))
+			{
+				error = "accessor " + std::to_string(index) + " runs past the end of its buffer";
+				return false;
+			}
+
+			accessor.data = buffers[bufferIndex].data + viewOffset + offset;
+			accessor.stride = static_cast<size_t>(stride);
+			accessor.count = static_cast<size_t>(count);
+			return true;
+		}
+
+		XMFLOAT3 ReadFloat3(const GltfAccessor& accessor, size_t index)
+		{
+			// Elements should be aligned but are copied in case they are not
+			XMFLOAT3 value;
+			std::memcpy(&value, accessor.data + accessor.stride * index, sizeof(value));
+			return value;
+		}
+
+		std::uint32_t ReadIndex(const GltfAccessor& accessor, size_t index)
+		{
+			const std::uint8_t* element = accessor.data + accessor.stride * index;
+			switch (accessor.componentType)
+			{
+			case GltfUnsignedByte:
+				return *element;
+			case GltfUnsignedShort:
+			{
+				std::uint16_t value;
+				std::memcpy(&value, element, sizeof(value));
+				return value;
+			}
+			default:
+			{
+				std::uint32_t value;
+				std::memcpy(&value, element, sizeof(value));
+				return value;
+			}
+			}
+		}
+
+		/** One primitive of a mesh placed by a node, converted on its own and joined with the others afterwards */
+		struct GltfPart
+		{
+			const JsonValue* primitive = nullptr;
+			XMFLOAT4X4 transform;
+			MeshData mesh;
+			bool missingNormals = false;
+			std::string error;
+			size_t vertexBase = 0;
+			size_t indexBase = 0;
+		};
+
+		void ConvertGltfPart(const JsonValue& document, const std::vector<GltfBuffer>& buffers, GltfPart& part)
+		{
+			PROFILE_ZONE("MeshImporter::ConvertGltfPart");
+			// Points and lines have no surface to draw
+			std::uint64_t mode;
+			if (!ReadUint(*part.primitive, "mode", 4, mode) || mode != 4)
+			{
+				return;
+			}
+
+			const JsonValue* attributes = part.primitive->Find("attributes");
+			std::uint64_t positionIndex;
+			GltfAccessor positions;
+			if (!attributes || !ReadUint(attributes->Find("POSITION"), positionIndex))
+			{
+				part.error = "primitive has no positions";
+				return;
+			}
+			if (!GetAccessor(document, buffers, positionIndex, "VEC3", positions, part.error))
+			{
+				return;
+			}
+			GltfAccessor normals;
+			std::uint64_t normalIndex;
+			const bool hasNormals = ReadUint(attributes->Find("NORMAL"), normalIndex);
+			if (hasNormals && !GetAccessor(document, buffers, normalIndex, "VEC3", normals, part.error))
+			{
+				return;
+			}
+			if (positions.componentType != GltfFloat || (hasNormals && (normals.componentType != GltfFloat || normals.count != positions.count)))
+			{
+				part.error = "primitive positions and normals must be floats of the same count";
+				return;
+			}
+
+			const XMMATRIX transform = XMLoadFloat4x4(&part.transform);
+			// Normals go through the inverse transpose so they stay perpendicular under non-uniform scale
+			XMVECTOR determinant;
+			const XMMATRIX normalTransform = XMMatrixTranspose(XMMatrixInverse(&determinant, transform));
+			part.mesh.vertices.resize(positions.count);
+			part.mesh.boundsMin = EmptyMin;
+			part.mesh.boundsMax = EmptyMax;
+			for (size_t i = 0; i < positions.count; ++i)
+			{
+				Vertex& vertex = part.mesh.vertices[i];
+				XMFLOAT3 position = ReadFloat3(positions, i);
+				XMStoreFloat3(&vertex.position, XMVector3TransformCoord(XMLoadFloat3(&position), transform));
+				vertex.position.z = -vertex.position.z;
+				GrowBounds(vertex.position, part.mesh.boundsMin, part.mesh.boundsMax);
+				if (hasNormals)
+				{
+					XMFLOAT3 normal = ReadFloat3(normals, i);
+					XMStoreFloat3(&vertex.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&normal), normalTransform)));
+					vertex.normal.z = -vertex.normal.z;
+				}
+				else
+				{
+					vertex.normal = { 0, 0, 0 };
+				}
+			}
+			part.missingNormals = !hasNormals;
+
+			std::uint64_t indicesIndex;
+			GltfAccessor indices;
+			const bool hasIndices = ReadUint(part.primitive->Find("indices"), indicesIndex);
+			if (hasIndices && !GetAccessor(document, buffers, indicesIndex, "SCALAR", indices, part.error))
+			{
+				return;
+			}
+			const size_t indexCount = hasIndices ? indices.count : positions.count;
+			if (indexCount % 3 != 0 || (hasIndices && indices.componentType == GltfFloat))
+			{
+				part.error = "primitive indices are not whole triangles of integers";
+				return;
+			}
+
+			// Triangles are turned around to be clockwise, unless a mirroring transform already turned them
+			const bool reversed = XMVectorGetX(determinant) >= 0;
+			part.mesh.indices.resize(indexCount);
+			for (size_t i = 0; i < indexCount; ++i)
+			{
+				const std::uint32_t index = hasIndices ? ReadIndex(indices, i) : static_cast<std::uint32_t>(i);
+				if (index >= positions.count)
+				{
+					part.error = "primitive index " + std::to_string(index) + " is past its vertices";
+					return;
+				}
+				part.mesh.indices[reversed ? i - i % 3 + (3 - i % 3) % 3 : i] = index;
+			}
+		}
+
+		/** Reads a node's transform from its matrix, or from its translation, rotation and scale */
+		XMMATRIX GetNodeTransform(const JsonValue& node)
+		{
+			// glTF matrices are column major for column vectors, which is the same memory as row major for rows
+			XMFLOAT4X4 matrix;
+			if (ReadFloats(node.Find("matrix"), &matrix.m[0][0], 16))
+			{
+				return XMLoadFloat4x4(&matrix);
+			}
+			XMFLOAT3 translation = { 0, 0, 0 };
+			XMFLOAT4 rotation = { 0, 0, 0, 1 };
+			XMFLOAT3 scale = { 1, 1, 1 };
+			ReadFloats(node.Find("translation"), &translation.x, 3);
+			ReadFloats(node.Find("rotation"), &rotation.x, 4);
+			ReadFloats(node.Find("scale"), &scale.x, 3);
+			return XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)) *
+				XMMatrixTranslation(translation.x, translation.y, translation.z);
+		}
+
+		/** Adds a part for each primitive of the node's mesh and those of its children */
+		bool AddGltfNode(const JsonValue& document, std::uint64_t nodeIndex, FXMMATRIX parent, std::uint32_t depth,
+			std::vector<GltfPart>& parts, std::string& error)
+		{
+			const JsonValue* nodes = document.Find("nodes");
+			const JsonValue* node = nodes ? nodes->At(nodeIndex) : nullptr;
+			if (!node || depth > MaxDepth)
+			{
+				error = "node " + std::to_string(nodeIndex) + " is missing or nested too deep";
+				return false;
+			}
+
+			const XMMATRIX transform = GetNodeTransform(*node) * parent;
+			std::uint64_t meshIndex;
+			if (ReadUint(node->Find("mesh"), meshIndex))
+			{
+				const JsonValue* meshes = document.Find("meshes");
+				const JsonValue* mesh = meshes ? meshes->At(meshIndex) : nullptr;
+				const JsonValue* primitives = mesh ? mesh->Find("primitives") : nullptr;
+				if (!primitives || primitives->type != JsonValue::Type::Array)
+				{
+					error = "mesh " + std::to_string(meshIndex) + " is missing or has no primitives";
+					return false;
+				}
+				for (const JsonValue& primitive : primitives->items)
+				{
+					parts.emplace_back();
+					parts.back().primitive = &primitive;
+					XMStoreFloat4x4(&parts.back().transform, transform);
+				}
+			}
+
+			const JsonValue* children = node->Find("children");
+			for (size_t i = 0; children && i < children->items.size(); ++i)
+			{
+				std::uint64_t child;
+				if (!ReadUint(&children->items[i], child) || !AddGltfNode(document, child, transform, depth + 1, parts, error))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/** Loads every buffer of the document. A .glb's own binary chunk is the buffer without a URI */
+		bool LoadGltfBuffers(const JsonValue& document, const std::string& path, const std::uint8_t* binary, size_t binarySize,
+			std::vector<GltfBuffer>& buffers, std::string& error)
+		{
+			const JsonValue* list = document.Find("buffers");
+			buffers.resize(list ? list->items.size() : 0);
+			for (size_t i = 0; i < buffers.size(); ++i)
+			{
+				const JsonValue& object = list->items[i];
+				GltfBuffer& buffer = buffers[i];
+				const JsonValue* uri = object.Find("uri");
+				std::uint64_t length;
+				if (!ReadUint(object.Find("byteLength"), length))
+				{
+					error = "buffer " + std::to_string(i) + " has no length";
+					return false;
+				}
+
+				const std::string base64 = ";base64,";
+				if (!uri)
+				{
+					buffer.data = binary;
+					buffer.size = binary ? binarySize : 0;
+				}
+				else if (uri->string.compare(0, 5, "data:") == 0)
+				{
+					const size_t start = uri->string.find(base64);
+					if (start == std::string::npos ||
+						!DecodeBase64(uri->string.data() + start + base64.size(), uri->string.size() - start - base64.size(), buffer.decoded))
+					{
+						error = "buffer " + std::to_string(i) + " has a data URI that is not base64";
+						return false;
+					}
+					buffer.data = buffer.decoded.data();
+					buffer.size = buffer.decoded.size();
+				}
+				else
+				{
+					const std::string bufferPath = (std::filesystem::path(path).parent_path() / DecodeUri(uri->string)).string();
+					buffer.file = std::make_unique<MappedFile>();
+					if (!buffer.file->Open(bufferPath))
+					{
+						error = "could not open " + bufferPath;
+						return false;
+					}
+					buffer.data = buffer.file->GetData();
+					buffer.size = buffer.file->GetSize();
+				}
+
+				if (buffer.size < length)
+				{
+					error = "buffer " + std::to_string(i) + " is shorter than its length";
+					return false;
+				}
+				buffer.size = static_cast<size_t>(length);
+			}
+			return true;
+		}
+	}
+
+	void MeshData::Clear()
+	{
+		vertices.clear();
+		indices.clear();
+		lods.clear();
+		boundsMin = { 0, 0, 0 };
+		boundsMax = { 0, 0, 0 };
+	}
+
+	MeshImporter::MeshImporter()
+		: mThreadCount(0)
+	{
+
+	}
+
+	void MeshImporter::SetThreadCount(std::uint32_t threadCount)
+	{
+		mThreadCount = threadCount;
+	}
+
+	bool MeshImporter::Import(const std::string& path, MeshData& mesh)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; });
+		if (extension == ".obj")
+		{
+			return ImportObj(path, mesh);
+		}
+		if (extension == ".gltf" || extension == ".glb")
+		{
+			return ImportGltf(path, mesh);
+		}
+		return Fail(path + ": unknown mesh format " + extension, mesh);
+	}
+
+	bool MeshImporter::ImportObj(const std::string& path, MeshData& mesh)
+	{
+		PROFILE_ZONE("MeshImporter::ImportObj");
+		mStats = MeshImportStats();
+		mError.clear();
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return Fail("Could not open " + path, mesh);
+		}
+
+		// Chunks end after a line break, so every line is read whole by one of them. A single thread reads the
+		// file as one chunk, which leaves no corners unmerged between chunks
+		const std::uint64_t parseStart = Profiler::Now();
+		const char* text = reinterpret_cast<const char*>(file.GetData());
+		const char* textEnd = text + file.GetSize();
+		const std::uint32_t threads = GetThreadCount(std::max<size_t>(file.GetSize() / MinObjChunkBytes, 1));
+		const size_t chunkCount = threads > 1 ? std::min<size_t>(threads * 4, file.GetSize() / MinObjChunkBytes) : 1;
+		std::vector<ObjChunk> chunks(chunkCount);
+		const char* chunkBegin = text;
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			const char* target = std::max(chunkBegin, text + file.GetSize() / chunkCount * (i + 1));
+			const char* lineEnd = i + 1 < chunkCount ? static_cast<const char*>(std::memchr(target, '\n', textEnd - target)) : nullptr;
+			chunks[i].begin = chunkBegin;
+			chunks[i].end = lineEnd ? lineEnd + 1 : textEnd;
+			chunkBegin = chunks[i].end;
+		}
+		ForEachParallel(chunkCount, threads, [&](size_t i)
+		{
+			ParseObjChunk(chunks[i]);
+		});
+		mStats.threads = threads;
+		mStats.chunks = static_cast<std::uint32_t>(chunkCount);
+		mStats.parseMilliseconds = (Profiler::Now() - parseStart) / 1e6;
+
+		// Number the elements of every chunk after those of the chunks before it
+		const std::uint64_t mergeStart = Profiler::Now();
+		std::uint64_t lines = 0;
+		size_t positionCount = 0;
+		size_t normalCount = 0;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		bool missingNormals = false;
+		for (ObjChunk& chunk : chunks)
+		{
+			if (!chunk.error.empty())
+			{
+				return Fail(path + "(" + std::to_string(lines + chunk.lines) + "): " + chunk.error, mesh);
+			}
+			lines += chunk.lines;
+			chunk.positionBase = positionCount;
+			chunk.normalBase = normalCount;
+			chunk.vertexBase = vertexCount;
+			chunk.indexBase = indexCount;
+			positionCount += chunk.positions.size();
+			normalCount += chunk.normals.size();
+			vertexCount += chunk.corners.size();
+			indexCount += chunk.indices.size();
+			missingNormals |= chunk.missingNormals;
+		}
+		if (vertexCount > std::numeric_limits<std::uint32_t>::max())
+		{
+			return Fail(path + ": too many vertices for 32 bit indices", mesh);
+		}
+
+		std::vector<XMFLOAT3> positions(positionCount);
+		std::vector<XMFLOAT3> normals(normalCount);
+		ForEachParallel(chunkCount, threads, [&](size_t i)
+		{
+			ObjChunk& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+			std::vector<XMFLOAT3>().swap(chunk.positions);
+			std::vector<XMFLOAT3>().swap(chunk.normals);
+		});
+
+		// Each chunk's distinct corners become its vertices, and its triangles are moved past the vertices before
+		mesh.vertices.resize(vertexCount);
+		mesh.indices.resize(indexCount);
+		std::vector<std::uint32_t> vertexPositions(missingNormals ? vertexCount : 0);
+		ForEachParallel(chunkCount, threads, [&](size_t i)
+		{
+			ObjChunk& chunk = chunks[i];
+			for (size_t corner = 0; corner < chunk.corners.size(); ++corner)
+			{
+				const ObjCorner& written = chunk.corners[corner];
+				const std::int64_t position = written.position + ((written.relative & RelativePosition) ? static_cast<std::int64_t>(chunk.positionBase) : 0);
+				const std::int64_t normal = written.normal + ((written.relative & RelativeNormal) ? static_cast<std::int64_t>(chunk.normalBase) : 0);
+				const bool hasNormal = written.normal != -1 || (written.relative & RelativeNormal);
+				if (position < 0 || position >= static_cast<std::int64_t>(positionCount) ||
+					(hasNormal && (normal < 0 || normal >= static_cast<std::int64_t>(normalCount))))
+				{
+					chunk.error = "face uses a position or normal that is not in the file";
+					return;
+				}
+
+				Vertex& vertex = mesh.vertices[chunk.vertexBase + corner];
+				vertex.position = positions[position];
+				vertex.position.z = -vertex.position.z;
+				vertex.normal = hasNormal ? normals[normal] : XMFLOAT3(0, 0, 0);
+				vertex.normal.z = -vertex.normal.z;
+				GrowBounds(vertex.position, chunk.boundsMin, chunk.boundsMax);
+				if (!vertexPositions.empty())
+				{
+					vertexPositions[chunk.vertexBase + corner] = static_cast<std::uint32_t>(position);
+				}
+			}
+
+			const std::uint32_t vertexBase = static_cast<std::uint32_t>(chunk.vertexBase);
+			std::transform(chunk.indices.begin(), chunk.indices.end(), mesh.indices.begin() + chunk.indexBase,
+				[vertexBase](std::uint32_t index) { return index + vertexBase; });
+			std::vector<ObjCorner>().swap(chunk.corners);
+			std::vector<std::uint32_t>().swap(chunk.indices);
+		});
+
+		mesh.boundsMin = EmptyMin;
+		mesh.boundsMax = EmptyMax;
+		for (const ObjChunk& chunk : chunks)
+		{
+			if (!chunk.error.empty())
+			{
+				return Fail(path + ": " + chunk.error, mesh);
+			}
+			GrowBounds(chunk.boundsMin, mesh.boundsMin, mesh.boundsMax);
+			GrowBounds(chunk.boundsMax, mesh.boundsMin, mesh.boundsMax);
+		}
+		if (mesh.vertices.empty())
+		{
+			mesh.boundsMin = mesh.boundsMax = { 0, 0, 0 };
+		}
+		if (missingNormals)
+		{
+			GenerateNormals(mesh, vertexPositions.data(), positionCount);
+		}
+
+		mStats.corners = indexCount;
+		mStats.vertices = vertexCount;
+		mStats.triangles = indexCount / 3;
+		mStats.mergeMilliseconds = (Profiler::Now() - mergeStart) / 1e6;
+		return true;
+	}
+
+	bool MeshImporter::ImportGltf(const std::string& path, MeshData& mesh)
+	{
+		PROFILE_ZONE("MeshImporter::ImportGltf");
+		mStats = MeshImportStats();
+		mError.clear();
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return Fail("Could not open " + path, mesh);
+		}
+
+		// A .glb is a header followed by a JSON chunk and an optional binary chunk, each with its length and type
+		const std::uint64_t parseStart = Profiler::Now();
+		const std::uint8_t* data = file.GetData();
+		const char* json = reinterpret_cast<const char*>(data);
+		size_t jsonSize = file.GetSize();
+		const std::uint8_t* binary = nullptr;
+		size_t binarySize = 0;
+		if (file.GetSize() >= 12 && std::memcmp(data, "glTF", 4) == 0)
+		{
+			std::uint32_t header[5] = {};
+			std::memcpy(header, data, std::min<size_t>(sizeof(header), file.GetSize()));
+			if (file.GetSize() < 20 || header[1] != 2 || header[2] > file.GetSize() || header[2] < 20 || header[4] != 0x4E4F534A ||
+				header[3] > header[2] - 20)
+			{
+				return Fail(path + ": not a version 2 binary glTF", mesh);
+			}
+			json = reinterpret_cast<const char*>(data + 20);
+			jsonSize = header[3];
+
+			const size_t binaryHeader = 20 + ((jsonSize + 3) & ~size_t(3));
+			std::uint32_t chunk[2];
+			if (binaryHeader + 8 <= header[2])
+			{
+				std::memcpy(chunk, data + binaryHeader, sizeof(chunk));
+				if (chunk[1] == 0x004E4942 && chunk[0] <= header[2] - binaryHeader - 8)
+				{
+					binary = data + binaryHeader + 8;
+					binarySize = chunk[0];
+				}
+			}
+		}
+
+		JsonValue document;
+		JsonReader reader(json, json + jsonSize);
+		if (!reader.Read(document) || document.type != JsonValue::Type::Object)
+		{
+			return Fail(path + ": JSON is broken at byte " + std::to_string(reader.GetOffset()), mesh);
+		}
+		std::vector<GltfBuffer> buffers;
+		std::string error;
+		if (!LoadGltfBuffers(document, path, binary, binarySize, buffers, error))
+		{
+			return Fail(path + ": " + error, mesh);
+		}
+
+		// The nodes of the default scene place the meshes. Files without scenes have every mesh once where it is
+		std::vector<GltfPart> parts;
+		const JsonValue* scenes = document.Find("scenes");
+		if (scenes && !scenes->items.empty())
+		{
+			std::uint64_t sceneIndex;
+			const JsonValue* scene = ReadUint(document, "scene", 0, sceneIndex) ? scenes->At(sceneIndex) : nullptr;
+			const JsonValue* roots = scene ? scene->Find("nodes") : nullptr;
+			for (size_t i = 0; roots && i < roots->items.size(); ++i)
+			{
+				std::uint64_t root;
+				if (!ReadUint(&roots->items[i], root) || !AddGltfNode(document, root, XMMatrixIdentity(), 0, parts, error))
+				{
+					return Fail(path + ": " + (error.empty() ? "scene has a node that is not an index" : error), mesh);
+				}
+			}
+		}
+		else if (const JsonValue* meshes = document.Find("meshes"))
+		{
+			for (const JsonValue& object : meshes->items)
+			{
+				const JsonValue* primitives = object.Find("primitives");
+				for (size_t i = 0; primitives && i < primitives->items.size(); ++i)
+				{
+					parts.emplace_back();
+					parts.back().primitive = &primitives->items[i];
+					XMStoreFloat4x4(&parts.back().transform, XMMatrixIdentity());
+				}
+			}
+		}
+
+		const std::uint32_t threads = GetThreadCount(parts.size());
+		ForEachParallel(parts.size(), threads, [&](size_t i)
+		{
+			ConvertGltfPart(document, buffers, parts[i]);
+		});
+		mStats.threads = threads;
+		mStats.chunks = static_cast<std::uint32_t>(parts.size());
+		mStats.parseMilliseconds = (Profiler::Now() - parseStart) / 1e6;
+
+		const std::uint64_t mergeStart = Profiler::Now();
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		for (GltfPart& part : parts)
+		{
+			if (!part.error.empty())
+			{
+				return Fail(path + ": " + part.error, mesh);
+			}
+			part.vertexBase = vertexCount;
+			part.indexBase = indexCount;
+			vertexCount += part.mesh.vertices.size();
+			indexCount += part.mesh.indices.size();
+		}
+		if (vertexCount > std::numeric_limits<std::uint32_t>::max())
+		{
+			return Fail(path + ": too many vertices for 32 bit indices", mesh);
+		}
+
+		// Normals are made for each part on its own, since glTF does not share vertices between primitives
+		mesh.vertices.resize(vertexCount);
+		mesh.indices.resize(indexCount);
+		ForEachParallel(parts.size(), threads, [&](size_t i)
+		{
+			GltfPart& part = parts[i];
+			if (part.missingNormals)
+			{
+				GenerateNormals(part.mesh, nullptr, part.mesh.vertices.size());
+			}
+			std::copy(part.mesh.vertices.begin(), part.mesh.vertices.end(), mesh.vertices.begin() + part.vertexBase);
+			const std::uint32_t vertexBase = static_cast<std::uint32_t>(part.vertexBase);
+			std::transform(part.mesh.indices.begin(), part.mesh.indices.end(), mesh.indices.begin() + part.indexBase,
+				[vertexBase](std::uint32_t index) { return index + vertexBase; });
+		});
+
+		mesh.boundsMin = EmptyMin;
+		mesh.boundsMax = EmptyMax;
+		for (const GltfPart& part : parts)
+		{
+			if (!part.mesh.vertices.empty())
+			{
+				GrowBounds(part.mesh.boundsMin, mesh.boundsMin, mesh.boundsMax);
+				GrowBounds(part.mesh.boundsMax, mesh.boundsMin, mesh.boundsMax);
+			}
+		}
+		if (mesh.vertices.empty())
+		{
+			mesh.boundsMin = mesh.boundsMax = { 0, 0, 0 };
+		}
+
+		mStats.corners = indexCount;
+		mStats.vertices = vertexCount;
+		mStats.triangles = indexCount / 3;
+		mStats.mergeMilliseconds = (Profiler::Now() - mergeStart) / 1e6;
+		return true;
+	}
+
+	const std::string& MeshImporter::GetError() const
+	{
+		return mError;
+	}
+
+	const MeshImportStats& MeshImporter::GetStats() const
+	{
+		return mStats;
+	}
+
+	bool MeshImporter::ExportObj(const std::string& path, const MeshData& mesh)
+	{
+		PROFILE_ZONE("MeshImporter::ExportObj");
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		// Nine digits bring every float back exactly. Lines are gathered into blocks since streams are slow per line
+		std::string block;
+		char line[128];
+		auto flush = [&](bool force)
+		{
+			if (force || block.size() > (1 << 20))
+			{
+				file.write(block.data(), block.size());
+				block.clear();
+			}
+		};
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			block.append(line, std::snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", vertex.position.x, vertex.position.y, -vertex.position.z));
+			flush(false);
+		}
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			block.append(line, std::snprintf(line, sizeof(line), "vn %.9g %.9g %.9g\n", vertex.normal.x, vertex.normal.y, -vertex.normal.z));
+			flush(false);
+		}
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const std::uint32_t a = mesh.indices[i] + 1;
+			const std::uint32_t b = mesh.indices[i + 1] + 1;
+			const std::uint32_t c = mesh.indices[i + 2] + 1;
+			block.append(line, std::snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u\n", a, a, c, c, b, b));
+			flush(false);
+		}
+		flush(true);
+		return static_cast<bool>(file);
+	}
+
+	bool MeshImporter::Fail(const std::string& error, MeshData& mesh)
+	{
+		mError = error;
+		mesh.Clear();
+		return false;
+	}
+
+	std::uint32_t MeshImporter::GetThreadCount(size_t chunkCount) const
+	{
+		const std::uint32_t threads = mThreadCount > 0 ? mThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		return static_cast<std::uint32_t>(std::max<size_t>(std::min<size_t>(threads, chunkCount), 1));
+	}
+}
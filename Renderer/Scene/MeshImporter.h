@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Rendering/DataTypes.h"
+
+namespace renderer
+{
+	/** A lower detail version of a mesh, drawing a subset of its vertices */
+	struct MeshLod
+	{
+		std::vector<std::uint32_t> indices;
+		// Roughly the farthest the surface moved from the full detail mesh, in the units of the vertex positions
+		float error = 0;
+	};
+
+	/** Geometry ready for the renderer's vertex and index buffers, with triangles in clockwise order */
+	struct MeshData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+		// Bounds of the vertex positions
+		XMFLOAT3 boundsMin = { 0, 0, 0 };
+		XMFLOAT3 boundsMax = { 0, 0, 0 };
+		// Lower detail index buffers over the same vertices, finest first. Filled by MeshSimplifier
+		std::vector<MeshLod> lods;
+
+		void Clear();
+	};
+
+	/** Figures of the last import */
+	struct MeshImportStats
+	{
+		std::uint32_t threads = 0;
+		// Pieces parsed independently: ranges of whole lines of an OBJ, or primitives of a glTF
+		std::uint32_t chunks = 0;
+		// Triangle corners read, and the vertices left after merging the ones with the same position and normal
+		std::uint64_t corners = 0;
+		std::uint64_t vertices = 0;
+		std::uint64_t triangles = 0;
+		// Reading the chunks, then joining them into one mesh
+		double parseMilliseconds = 0;
+		double mergeMilliseconds = 0;
+	};
+
+	/**
+	 * Reads meshes from Wavefront OBJ and glTF 2.0 files, the latter as .gltf with external or embedded buffers or
+	 * as .glb. Files are mapped into memory. An OBJ is split into chunks of whole lines parsed on several threads,
+	 * each merging the corners with the same position and normal through a hash table, and the chunks are joined
+	 * afterwards. glTF primitives are already indexed, so they are converted on several threads as they are.
+	 *
+	 * Everything in a file becomes one mesh, with glTF node transforms applied. Both formats are right handed with
+	 * counter-clockwise triangles, so z is negated and every triangle turned around to be clockwise as the renderer
+	 * draws them. Missing normals are made smooth from the triangles around each position. Texture coordinates and
+	 * materials are skipped.
+	 */
+	class MeshImporter
+	{
+	public:
+		MeshImporter();
+
+		/** Threads used to parse. Zero uses one per hardware thread */
+		void SetThreadCount(std::uint32_t threadCount);
+		/** Reads the file, picking the format from its extension */
+		bool Import(const std::string& path, MeshData& mesh);
+		bool ImportObj(const std::string& path, MeshData& mesh);
+		bool ImportGltf(const std::string& path, MeshData& mesh);
+		/** Why the last import failed */
+		const std::string& GetError() const;
+		const MeshImportStats& GetStats() const;
+
+		/** Writes the mesh as OBJ with normals, undoing the change of handedness of importing */
+		static bool ExportObj(const std::string& path, const MeshData& mesh);
+
+	private:
+		bool Fail(const std::string& error, MeshData& mesh);
+		std::uint32_t GetThreadCount(size_t chunkCount) const;
+
+		std::uint32_t mThreadCount;
+		std::string mError;
+		MeshImportStats mStats;
+	};
+}
@@ -0,0 +1,690 @@
+#include "MeshSimplifier.h"
+#include "Profiling/Profiler.h"
+#include <atomic>
+#include <thread>
+
+namespace renderer
+{
+	namespace
+	{
+		// Border planes weigh this much more than triangles so borders keep their shape
+		constexpr float BorderWeight = 10.0f;
+		// Cost of a collapse between vertices whose normals are opposite, relative to its squared length
+		constexpr float NormalWeight = 1.0f;
+		// Collapses that turn a triangle by more than about 75 degrees are skipped
+		constexpr float MinNormalCosine = 0.25f;
+		// Vertices at one position whose normals are closer than this are welded as one
+		constexpr float WeldNormalCosine = 0.9999f;
+		// Many collapses of a pass are skipped because a neighbour already collapsed, so a pass takes collapses up
+		// to this much more costly than the one that would have reached its target
+		constexpr float PassCostSlack = 1.5f;
+		constexpr std::uint32_t NoVertex = ~0u;
+
+		enum class VertexKind : std::uint8_t
+		{
+			// Inside the surface, collapses onto any neighbour
+			Manifold,
+			// On one border, only collapses onto its neighbours along it
+			Border,
+			// Where borders meet or an edge has more than two triangles. Stays, but others collapse onto it
+			Locked,
+			// A position with several normals, a hard edge. Neither collapses nor takes collapses, since a vertex
+			// collapsed onto it would not know which of the normals to use
+			Seam
+		};
+
+		/** Weighted sum of squared distances to planes, as x^T A x + 2 b.x + c with A symmetric */
+		struct Quadric
+		{
+			float a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+			float b0 = 0, b1 = 0, b2 = 0;
+			float c = 0;
+			float weight = 0;
+		};
+
+		void AddPlane(Quadric& q, const XMFLOAT3& n, float d, float weight)
+		{
+			q.a00 += weight * n.x * n.x;
+			q.a11 += weight * n.y * n.y;
+			q.a22 += weight * n.z * n.z;
+			q.a01 += weight * n.x * n.y;
+			q.a02 += weight * n.x * n.z;
+			q.a12 += weight * n.y * n.z;
+			q.b0 += weight * n.x * d;
+			q.b1 += weight * n.y * d;
+			q.b2 += weight * n.z * d;
+			q.c += weight * d * d;
+			q.weight += weight;
+		}
+
+		void AddQuadric(Quadric& q, const Quadric& other)
+		{
+			q.a00 += other.a00;
+			q.a11 += other.a11;
+			q.a22 += other.a22;
+			q.a01 += other.a01;
+			q.a02 += other.a02;
+			q.a12 += other.a12;
+			q.b0 += other.b0;
+			q.b1 += other.b1;
+			q.b2 += other.b2;
+			q.c += other.c;
+			q.weight += other.weight;
+		}
+
+		/** Mean squared distance of the point to the planes */
+		float Evaluate(const Quadric& q, const XMFLOAT3& p)
+		{
+			const float error = q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+				2 * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+				2 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+			return q.weight > 0 ? std::abs(error) / q.weight : 0.0f;
+		}
+
+		XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+		}
+
+		XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+		}
+
+		float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		/** Normal of a clockwise triangle scaled by twice its area */
+		XMFLOAT3 TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+		{
+			return Cross(Subtract(p1, p0), Subtract(p2, p0));
+		}
+
+		std::uint32_t HashPosition(const XMFLOAT3& p)
+		{
+			std::uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+
+		/**
+		 * Simplification state of one mesh, kept between levels so each carries on from the last. Indices are
+		 * always original vertices. The topology works on positions, each named by its first vertex.
+		 */
+		class QuadricSimplifier
+		{
+		public:
+			QuadricSimplifier(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices);
+
+			/** Collapses edges until at most targetTriangles are left or none can collapse. Returns the error so far */
+			float Reduce(size_t targetTriangles);
+			const std::vector<std::uint32_t>& GetIndices() const { return mIndices; }
+			std::uint32_t GetPasses() const { return mPasses; }
+
+		private:
+			struct Collapse
+			{
+				std::uint32_t from;
+				std::uint32_t to;
+				float cost;
+				float error;
+			};
+
+			void Weld(const std::vector<std::uint32_t>& indices);
+			void BuildAdjacency();
+			bool HasEdge(std::uint32_t from, std::uint32_t to) const;
+			void ClassifyVertices();
+			void ComputeQuadrics();
+			bool CanCollapse(std::uint32_t from, std::uint32_t to) const;
+			bool CheckCollapse(std::uint32_t from, std::uint32_t to, size_t& removedTriangles) const;
+			bool RunPass(size_t targetTriangles);
+
+			std::uint32_t GetPosition(std::uint32_t vertex) const { return mPositionIds[vertex]; }
+
+			const std::vector<Vertex>& mVertices;
+			// Positions moved and scaled into the unit cube so the quadrics keep their precision
+			std::vector<XMFLOAT3> mPositions;
+			float mScale;
+			// First vertex of each vertex's position, and the next vertex at the same position with another normal
+			std::vector<std::uint32_t> mPositionIds;
+			std::vector<std::uint32_t> mNextWedge;
+			// Per position
+			std::vector<VertexKind> mKinds;
+			std::vector<std::uint32_t> mBorderNext;
+			std::vector<std::uint32_t> mBorderPrevious;
+			std::vector<Quadric> mQuadrics;
+			// Triangles around each position, rebuilt every pass
+			std::vector<std::uint32_t> mTriangleOffsets;
+			std::vector<std::uint32_t> mTriangles;
+			// Where each position collapsed to in the current pass, and whether it took part in a collapse
+			std::vector<std::uint32_t> mCollapseTargets;
+			std::vector<std::uint8_t> mTouched;
+			std::vector<Collapse> mCollapses;
+			std::vector<std::uint32_t> mIndices;
+			float mError;
+			std::uint32_t mPasses;
+		};
+
+		QuadricSimplifier::QuadricSimplifier(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices)
+			: mVertices(vertices), mScale(1), mError(0), mPasses(0)
+		{
+			XMFLOAT3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+			XMFLOAT3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (const Vertex& vertex : vertices)
+			{
+				const XMFLOAT3& p = vertex.position;
+				boundsMin = XMFLOAT3(std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z));
+				boundsMax = XMFLOAT3(std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z));
+			}
+			const float extent = std::max({ boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z });
+			mScale = extent > 0 ? 1.0f / extent : 1.0f;
+			mPositions.resize(vertices.size());
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				mPositions[i] = XMFLOAT3((vertices[i].position.x - boundsMin.x) * mScale, (vertices[i].position.y - boundsMin.y) * mScale,
+					(vertices[i].position.z - boundsMin.z) * mScale);
+			}
+
+			Weld(indices);
+			BuildAdjacency();
+			ClassifyVertices();
+			ComputeQuadrics();
+			mCollapseTargets.resize(vertices.size());
+			for (std::uint32_t i = 0; i < mCollapseTargets.size(); ++i)
+			{
+				mCollapseTargets[i] = i;
+			}
+			mTouched.resize(vertices.size());
+		}
+
+		void QuadricSimplifier::Weld(const std::vector<std::uint32_t>& indices)
+		{
+			// Vertices with the same position share a position id, found through an open addressing table
+			const auto vertexCount = static_cast<std::uint32_t>(mVertices.size());
+			size_t tableSize = 16;
+			while (tableSize < vertexCount * size_t(2))
+			{
+				tableSize *= 2;
+			}
+			std::vector<std::uint32_t> table(tableSize, NoVertex);
+			mPositionIds.resize(vertexCount);
+			mNextWedge.assign(vertexCount, NoVertex);
+			std::vector<std::uint32_t> wedges(vertexCount);
+			for (std::uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+			{
+				const XMFLOAT3& p = mVertices[vertex].position;
+				size_t slot = HashPosition(p) & (tableSize - 1);
+				while (table[slot] != NoVertex && std::memcmp(&mVertices[table[slot]].position, &p, sizeof(p)) != 0)
+				{
+					slot = (slot + 1) & (tableSize - 1);
+				}
+				if (table[slot] == NoVertex)
+				{
+					table[slot] = vertex;
+				}
+				const std::uint32_t position = table[slot];
+				mPositionIds[vertex] = position;
+
+				// Vertices repeating a normal already at the position are replaced by the first with it
+				std::uint32_t wedge = position;
+				std::uint32_t last = position;
+				while (wedge != NoVertex && wedge != vertex &&
+					Dot(mVertices[wedge].normal, mVertices[vertex].normal) < WeldNormalCosine)
+				{
+					last = wedge;
+					wedge = mNextWedge[wedge];
+				}
+				if (wedge == NoVertex)
+				{
+					mNextWedge[last] = vertex;
+					wedge = vertex;
+				}
+				wedges[vertex] = wedge;
+			}
+
+			// Triangles whose corners share a position have no area and would confuse the topology
+			mIndices.reserve(indices.size());
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				const std::uint32_t a = wedges[indices[i]];
+				const std::uint32_t b = wedges[indices[i + 1]];
+				const std::uint32_t c = wedges[indices[i + 2]];
+				if (GetPosition(a) != GetPosition(b) && GetPosition(b) != GetPosition(c) && GetPosition(a) != GetPosition(c))
+				{
+					mIndices.insert(mIndices.end(), { a, b, c });
+				}
+			}
+		}
+
+		void QuadricSimplifier::BuildAdjacency()
+		{
+			mTriangleOffsets.assign(mVertices.size() + 1, 0);
+			for (std::uint32_t vertex : mIndices)
+			{
+				++mTriangleOffsets[GetPosition(vertex) + 1];
+			}
+			for (size_t i = 1; i < mTriangleOffsets.size(); ++i)
+			{
+				mTriangleOffsets[i] += mTriangleOffsets[i - 1];
+			}
+			mTriangles.resize(mIndices.size());
+			std::vector<std::uint32_t>& fill = mCollapseTargets;
+			fill.assign(mTriangleOffsets.begin(), mTriangleOffsets.end() - 1);
+			for (size_t i = 0; i < mIndices.size(); ++i)
+			{
+				mTriangles[fill[GetPosition(mIndices[i])]++] = static_cast<std::uint32_t>(i / 3);
+			}
+			for (std::uint32_t i = 0; i < fill.size(); ++i)
+			{
+				fill[i] = i;
+			}
+		}
+
+		bool QuadricSimplifier::HasEdge(std::uint32_t from, std::uint32_t to) const
+		{
+			for (std::uint32_t i = mTriangleOffsets[from]; i < mTriangleOffsets[from + 1]; ++i)
+			{
+				const std::uint32_t* corners = &mIndices[mTriangles[i] * size_t(3)];
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					if (GetPosition(corners[k]) == from && GetPosition(corners[(k + 1) % 3]) == to)
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		void QuadricSimplifier::ClassifyVertices()
+		{
+			const auto vertexCount = static_cast<std::uint32_t>(mVertices.size());
+			mKinds.assign(vertexCount, VertexKind::Locked);
+			mBorderNext.assign(vertexCount, NoVertex);
+			mBorderPrevious.assign(vertexCount, NoVertex);
+			for (std::uint32_t position = 0; position < vertexCount; ++position)
+			{
+				if (GetPosition(position) != position || mTriangleOffsets[position] == mTriangleOffsets[position + 1])
+				{
+					continue;
+				}
+				if (mNextWedge[position] != NoVertex)
+				{
+					mKinds[position] = VertexKind::Seam;
+					continue;
+				}
+
+				// An edge with no twin going the other way is on a border
+				std::uint32_t bordersOut = 0;
+				std::uint32_t bordersIn = 0;
+				bool manifold = true;
+				for (std::uint32_t i = mTriangleOffsets[position]; i < mTriangleOffsets[position + 1]; ++i)
+				{
+					const std::uint32_t* corners = &mIndices[mTriangles[i] * size_t(3)];
+					std::uint32_t k = 0;
+					while (GetPosition(corners[k]) != position)
+					{
+						++k;
+					}
+					const std::uint32_t next = GetPosition(corners[(k + 1) % 3]);
+					const std::uint32_t previous = GetPosition(corners[(k + 2) % 3]);
+					if (!HasEdge(next, position))
+					{
+						++bordersOut;
+						mBorderNext[position] = next;
+					}
+					if (!HasEdge(position, previous))
+					{
+						++bordersIn;
+						mBorderPrevious[position] = previous;
+					}
+					// The same edge in two triangles going the same way joins more than two triangles
+					for (std::uint32_t j = i + 1; j < mTriangleOffsets[position + 1]; ++j)
+					{
+						const std::uint32_t* other = &mIndices[mTriangles[j] * size_t(3)];
+						for (std::uint32_t m = 0; m < 3; ++m)
+						{
+							manifold &= !(GetPosition(other[m]) == position && GetPosition(other[(m + 1) % 3]) == next);
+						}
+					}
+				}
+				if (!manifold)
+				{
+					mKinds[position] = VertexKind::Locked;
+				}
+				else if (bordersOut == 0 && bordersIn == 0)
+				{
+					mKinds[position] = VertexKind::Manifold;
+				}
+				else if (bordersOut == 1 && bordersIn == 1)
+				{
+					mKinds[position] = VertexKind::Border;
+				}
+			}
+		}
+
+		void QuadricSimplifier::ComputeQuadrics()
+		{
+			mQuadrics.assign(mVertices.size(), Quadric());
+			for (size_t i = 0; i < mIndices.size(); i += 3)
+			{
+				const std::uint32_t positions[3] = { GetPosition(mIndices[i]), GetPosition(mIndices[i + 1]), GetPosition(mIndices[i + 2]) };
+				const XMFLOAT3& p0 = mPositions[positions[0]];
+				XMFLOAT3 normal = TriangleNormal(p0, mPositions[positions[1]], mPositions[positions[2]]);
+				const float length = std::sqrt(Dot(normal, normal));
+				if (length == 0)
+				{
+					continue;
+				}
+				normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+				for (std::uint32_t position : positions)
+				{
+					AddPlane(mQuadrics[position], normal, -Dot(normal, p0), length * 0.5f);
+				}
+
+				// Planes through border edges, upright to the triangle, hold the border in place
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t from = positions[k];
+					const std::uint32_t to = positions[(k + 1) % 3];
+					if (HasEdge(to, from))
+					{
+						continue;
+					}
+					const XMFLOAT3 edge = Subtract(mPositions[to], mPositions[from]);
+					XMFLOAT3 side = Cross(edge, normal);
+					const float sideLength = std::sqrt(Dot(side, side));
+					if (sideLength == 0)
+					{
+						continue;
+					}
+					side = XMFLOAT3(side.x / sideLength, side.y / sideLength, side.z / sideLength);
+					const float weight = BorderWeight * Dot(edge, edge);
+					AddPlane(mQuadrics[from], side, -Dot(side, mPositions[from]), weight);
+					AddPlane(mQuadrics[to], side, -Dot(side, mPositions[from]), weight);
+				}
+			}
+		}
+
+		bool QuadricSimplifier::CanCollapse(std::uint32_t from, std::uint32_t to) const
+		{
+			if (mKinds[to] == VertexKind::Seam)
+			{
+				return false;
+			}
+			return mKinds[from] == VertexKind::Manifold ||
+				(mKinds[from] == VertexKind::Border && (to == mBorderNext[from] || to == mBorderPrevious[from]));
+		}
+
+		bool QuadricSimplifier::CheckCollapse(std::uint32_t from, std::uint32_t to, size_t& removedTriangles) const
+		{
+			// Neighbours may have collapsed earlier in the pass, so corners go through the collapse targets
+			removedTriangles = 0;
+			for (std::uint32_t i = mTriangleOffsets[from]; i < mTriangleOffsets[from + 1]; ++i)
+			{
+				const std::uint32_t* corners = &mIndices[mTriangles[i] * size_t(3)];
+				std::uint32_t positions[3];
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					positions[k] = mCollapseTargets[GetPosition(corners[k])];
+				}
+				if (positions[0] == positions[1] || positions[1] == positions[2] || positions[0] == positions[2])
+				{
+					continue;
+				}
+				if (positions[0] == to || positions[1] == to || positions[2] == to)
+				{
+					++removedTriangles;
+					continue;
+				}
+
+				const XMFLOAT3 before = TriangleNormal(mPositions[positions[0]], mPositions[positions[1]], mPositions[positions[2]]);
+				for (std::uint32_t& position : positions)
+				{
+					position = position == from ? to : position;
+				}
+				const XMFLOAT3 after = TriangleNormal(mPositions[positions[0]], mPositions[positions[1]], mPositions[positions[2]]);
+				const float lengths = std::sqrt(Dot(before, before) * Dot(after, after));
+				if (lengths == 0 || Dot(before, after) < MinNormalCosine * lengths)
+				{
+					return false;
+				}
+				// Nor may it face away from its vertex normals, which would light it from behind
+				const XMFLOAT3& n0 = mVertices[positions[0]].normal;
+				const XMFLOAT3& n1 = mVertices[positions[1]].normal;
+				const XMFLOAT3& n2 = mVertices[positions[2]].normal;
+				if (Dot(after, XMFLOAT3(n0.x + n1.x + n2.x, n0.y + n1.y + n2.y, n0.z + n1.z + n2.z)) <= 0)
+				{
+					return false;
+				}
+			}
+			// Without a triangle on the edge the two vertices are not neighbours any more
+			return removedTriangles > 0;
+		}
+
+		bool QuadricSimplifier::RunPass(size_t targetTriangles)
+		{
+			BuildAdjacency();
+
+			// Every edge once, in whichever direction is allowed and costs less
+			mCollapses.clear();
+			for (size_t i = 0; i < mIndices.size(); i += 3)
+			{
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t a = GetPosition(mIndices[i + k]);
+					const std::uint32_t b = GetPosition(mIndices[i + (k + 1) % 3]);
+					if (a > b && HasEdge(b, a))
+					{
+						continue;
+					}
+					Collapse best = { NoVertex, NoVertex, FLT_MAX, 0 };
+					for (const auto& edge : { std::make_pair(a, b), std::make_pair(b, a) })
+					{
+						if (!CanCollapse(edge.first, edge.second))
+						{
+							continue;
+						}
+						const XMFLOAT3& p = mPositions[edge.first];
+						const XMFLOAT3& q = mPositions[edge.second];
+						const XMFLOAT3 offset = Subtract(q, p);
+						const float error = Evaluate(mQuadrics[edge.first], q);
+						const float normalChange = 1.0f - Dot(mVertices[edge.first].normal, mVertices[edge.second].normal);
+						const float cost = error + NormalWeight * normalChange * Dot(offset, offset);
+						if (cost < best.cost)
+						{
+							best = { edge.first, edge.second, cost, error };
+						}
+					}
+					if (best.from != NoVertex)
+					{
+						mCollapses.push_back(best);
+					}
+				}
+			}
+			if (mCollapses.empty())
+			{
+				return false;
+			}
+			std::sort(mCollapses.begin(), mCollapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			// A collapse usually removes two triangles
+			const size_t triangleCount = mIndices.size() / 3;
+			const size_t neededTriangles = triangleCount - targetTriangles;
+			const size_t goal = neededTriangles / 2;
+			const float costLimit = goal < mCollapses.size() ? mCollapses[goal].cost * PassCostSlack : FLT_MAX;
+			size_t removedTriangles = 0;
+			std::vector<std::uint32_t> collapsed;
+			for (const Collapse& collapse : mCollapses)
+			{
+				if (removedTriangles >= neededTriangles || collapse.cost > costLimit)
+				{
+					break;
+				}
+				size_t removed = 0;
+				if (mTouched[collapse.from] || mTouched[collapse.to] || !CheckCollapse(collapse.from, collapse.to, removed))
+				{
+					continue;
+				}
+
+				mCollapseTargets[collapse.from] = collapse.to;
+				mTouched[collapse.from] = 1;
+				mTouched[collapse.to] = 1;
+				collapsed.push_back(collapse.from);
+				removedTriangles += removed;
+				AddQuadric(mQuadrics[collapse.to], mQuadrics[collapse.from]);
+				mError = std::max(mError, collapse.error);
+
+				// The border skips the collapsed vertex
+				if (mKinds[collapse.from] == VertexKind::Border)
+				{
+					const std::uint32_t next = mBorderNext[collapse.from];
+					const std::uint32_t previous = mBorderPrevious[collapse.from];
+					if (collapse.to == next)
+					{
+						mBorderNext[previous] = next;
+						mBorderPrevious[next] = previous;
+					}
+					else
+					{
+						mBorderPrevious[next] = previous;
+						mBorderNext[previous] = next;
+					}
+				}
+			}
+			if (collapsed.empty())
+			{
+				return false;
+			}
+
+			// Collapsed positions have one vertex, so their triangles move to the vertex they collapsed onto
+			size_t written = 0;
+			for (size_t i = 0; i < mIndices.size(); i += 3)
+			{
+				std::uint32_t corners[3];
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t vertex = mIndices[i + k];
+					corners[k] = mCollapseTargets[GetPosition(vertex)] != GetPosition(vertex) ? mCollapseTargets[GetPosition(vertex)] : vertex;
+				}
+				if (GetPosition(corners[0]) != GetPosition(corners[1]) && GetPosition(corners[1]) != GetPosition(corners[2]) &&
+					GetPosition(corners[0]) != GetPosition(corners[2]))
+				{
+					std::copy(corners, corners + 3, mIndices.begin() + written);
+					written += 3;
+				}
+			}
+			mIndices.resize(written);
+
+			for (std::uint32_t position : collapsed)
+			{
+				mTouched[mCollapseTargets[position]] = 0;
+				mTouched[position] = 0;
+				mCollapseTargets[position] = position;
+			}
+			return true;
+		}
+
+		float QuadricSimplifier::Reduce(size_t targetTriangles)
+		{
+			while (mIndices.size() / 3 > targetTriangles && RunPass(targetTriangles))
+			{
+				++mPasses;
+			}
+			// Errors are mean squared distances in the unit cube
+			return std::sqrt(mError) / mScale;
+		}
+	}
+
+	MeshSimplifier::MeshSimplifier()
+		: mThreadCount(0), mLodRatios({ 0.5f, 0.25f, 0.125f })
+	{
+
+	}
+
+	void MeshSimplifier::SetThreadCount(std::uint32_t threadCount)
+	{
+		mThreadCount = threadCount;
+	}
+
+	void MeshSimplifier::SetLodRatios(const std::vector<float>& ratios)
+	{
+		mLodRatios = ratios;
+	}
+
+	void MeshSimplifier::BuildLods(const std::vector<MeshData*>& meshes)
+	{
+		PROFILE_ZONE("MeshSimplifier::BuildLods");
+		const std::uint64_t start = Profiler::Now();
+		const std::uint32_t hardwareThreads = mThreadCount > 0 ? mThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		const auto threadCount = static_cast<std::uint32_t>(std::max<size_t>(std::min<size_t>(hardwareThreads, meshes.size()), 1));
+
+		// Meshes vary in size, so threads take the next one as they finish rather than a fixed share
+		std::vector<std::uint32_t> passes(meshes.size());
+		std::atomic<size_t> next(0);
+		auto work = [&]()
+		{
+			for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < meshes.size(); i = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				MeshData& mesh = *meshes[i];
+				mesh.lods.clear();
+				QuadricSimplifier simplifier(mesh.vertices, mesh.indices);
+				const size_t triangleCount = mesh.indices.size() / 3;
+				for (float ratio : mLodRatios)
+				{
+					MeshLod lod;
+					lod.error = simplifier.Reduce(static_cast<size_t>(triangleCount * ratio));
+					lod.indices = simplifier.GetIndices();
+					mesh.lods.push_back(std::move(lod));
+				}
+				passes[i] = simplifier.GetPasses();
+			}
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+		{
+			workers.emplace_back(work);
+		}
+		work();
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		mStats = MeshSimplifyStats();
+		mStats.meshes = static_cast<std::uint32_t>(meshes.size());
+		mStats.threads = threadCount;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			mStats.sourceTriangles += meshes[i]->indices.size() / 3;
+			for (const MeshLod& lod : meshes[i]->lods)
+			{
+				mStats.lodTriangles += lod.indices.size() / 3;
+			}
+			mStats.passes += passes[i];
+		}
+		mStats.milliseconds = (Profiler::Now() - start) / 1e6;
+	}
+
+	void MeshSimplifier::BuildLods(MeshData& mesh)
+	{
+		BuildLods(std::vector<MeshData*>{ &mesh });
+	}
+
+	const MeshSimplifyStats& MeshSimplifier::GetStats() const
+	{
+		return mStats;
+	}
+
+	float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices, size_t targetIndexCount,
+		std::vector<std::uint32_t>& result)
+	{
+		QuadricSimplifier simplifier(vertices, indices);
+		const float error = simplifier.Reduce(targetIndexCount / 3);
+		result = simplifier.GetIndices();
+		return error;
+	}
+}
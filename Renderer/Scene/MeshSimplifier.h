@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MeshImporter.h"
+
+namespace renderer
+{
+	/** Figures of the last BuildLods */
+	struct MeshSimplifyStats
+	{
+		std::uint32_t meshes = 0;
+		std::uint32_t threads = 0;
+		// Triangles of the full meshes and of all their levels together
+		std::uint64_t sourceTriangles = 0;
+		std::uint64_t lodTriangles = 0;
+		// Edge collapse passes over all meshes and levels
+		std::uint64_t passes = 0;
+		double milliseconds = 0;
+	};
+
+	/**
+	 * Makes lower detail index buffers of a mesh by edge collapses ordered by Garland-Heckbert quadric error. A
+	 * vertex is always collapsed onto a neighbour, so every level indexes the original vertex buffer and a chain
+	 * of levels shares one set of vertices. Each level carries on from the one before it, keeping the quadrics.
+	 *
+	 * Vertices with the same position are welded for the topology. Positions with more than one normal, such as
+	 * the corners of a cube, are hard edges and never move. Border vertices only slide along their own border, and
+	 * the border planes are added to their quadrics so it keeps its shape. A collapse that would flip a triangle
+	 * is skipped, and one between vertices with different normals costs more, so shading changes as little as
+	 * the geometry.
+	 */
+	class MeshSimplifier
+	{
+	public:
+		MeshSimplifier();
+
+		/** Threads used to simplify several meshes at once. Zero uses one per hardware thread */
+		void SetThreadCount(std::uint32_t threadCount);
+		/** Fraction of the full mesh's triangles every level aims for, finest first. Defaults to 1/2, 1/4 and 1/8 */
+		void SetLodRatios(const std::vector<float>& ratios);
+		/**
+		 * Replaces the levels of every mesh, simplifying one mesh per thread at a time. A level stops short of its
+		 * ratio when no collapse is left that keeps the borders, hard edges and triangle orientations
+		 */
+		void BuildLods(const std::vector<MeshData*>& meshes);
+		void BuildLods(MeshData& mesh);
+		const MeshSimplifyStats& GetStats() const;
+
+		/**
+		 * Simplifies the triangles given by indices to at most targetIndexCount indices where possible, writing
+		 * them to result. Returns the error, in the units of the vertex positions
+		 */
+		static float Simplify(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices, size_t targetIndexCount,
+			std::vector<std::uint32_t>& result);
+
+	private:
+		std::uint32_t mThreadCount;
+		std::vector<float> mLodRatios;
+		MeshSimplifyStats mStats;
+	};
+}
@@ -0,0 +1,754 @@
+#include "RayQuery.h"
+#include "Rendering/InstanceBuilder.h"
+#include "Rendering/MeshRegistry.h"
+#include "Profiling/Profiler.h"
+#include <atomic>
+#include <thread>
+
+namespace renderer
+{
+	namespace
+	{
+		// Packets handed to a thread at a time, enough that taking them is cheap next to tracing them
+		constexpr size_t PacketsPerTask = 64;
+		constexpr std::uint32_t SahBins = 12;
+
+		float& Lane(XMFLOAT4A& vector, std::uint32_t lane)
+		{
+			return (&vector.x)[lane];
+		}
+
+		float Component(const XMFLOAT3& vector, std::uint32_t axis)
+		{
+			return (&vector.x)[axis];
+		}
+
+		std::uint32_t LaneMask(FXMVECTOR comparison)
+		{
+			XMUINT4 lanes;
+			XMStoreUInt4(&lanes, comparison);
+			return (lanes.x ? 1u : 0u) | (lanes.y ? 2u : 0u) | (lanes.z ? 4u : 0u) | (lanes.w ? 8u : 0u);
+		}
+
+		/** Half the surface area, which is all the SAH needs */
+		float HalfArea(const XMFLOAT3& min, const XMFLOAT3& max)
+		{
+			const float x = max.x - min.x;
+			const float y = max.y - min.y;
+			const float z = max.z - min.z;
+			return x * y + y * z + z * x;
+		}
+
+		void Grow(XMFLOAT3& min, XMFLOAT3& max, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+		{
+			min = XMFLOAT3(std::min(min.x, boxMin.x), std::min(min.y, boxMin.y), std::min(min.z, boxMin.z));
+			max = XMFLOAT3(std::max(max.x, boxMax.x), std::max(max.y, boxMax.y), std::max(max.z, boxMax.z));
+		}
+
+		/** Keeps directions along an axis from making infinite or undefined slab distances */
+		float SafeInverse(float value)
+		{
+			return 1.0f / (std::abs(value) > 1e-20f ? value : std::copysign(1e-20f, value));
+		}
+
+		/** Unit box around the origin. Rays starting inside hit the face they leave through */
+		bool IntersectBox(const XMFLOAT3& o, const XMFLOAT3& d, float maxDistance, float& t, XMFLOAT3& normal)
+		{
+			float tNear = -FLT_MAX;
+			float tFar = FLT_MAX;
+			std::uint32_t nearAxis = 0;
+			std::uint32_t farAxis = 0;
+			for (std::uint32_t axis = 0; axis < 3; ++axis)
+			{
+				const float inverse = SafeInverse(Component(d, axis));
+				const float t1 = (-0.5f - Component(o, axis)) * inverse;
+				const float t2 = (0.5f - Component(o, axis)) * inverse;
+				if (std::min(t1, t2) > tNear)
+				{
+					tNear = std::min(t1, t2);
+					nearAxis = axis;
+				}
+				if (std::max(t1, t2) < tFar)
+				{
+					tFar = std::max(t1, t2);
+					farAxis = axis;
+				}
+			}
+			if (tNear > tFar || tFar < 0)
+			{
+				return false;
+			}
+			const bool inside = tNear < 0;
+			t = inside ? tFar : tNear;
+			if (t > maxDistance)
+			{
+				return false;
+			}
+			// Entering through the face the ray points into, leaving through the one it points out of
+			const std::uint32_t axis = inside ? farAxis : nearAxis;
+			const float sign = (Component(d, axis) < 0) == inside ? -1.0f : 1.0f;
+			normal = XMFLOAT3(axis == 0 ? sign : 0, axis == 1 ? sign : 0, axis == 2 ? sign : 0);
+			return true;
+		}
+
+		/** Sphere of radius 0.5 around the origin */
+		bool IntersectSphere(const XMFLOAT3& o, const XMFLOAT3& d, float maxDistance, float& t, XMFLOAT3& normal)
+		{
+			const float a = d.x * d.x + d.y * d.y + d.z * d.z;
+			const float b = o.x * d.x + o.y * d.y + o.z * d.z;
+			const float c = o.x * o.x + o.y * o.y + o.z * o.z - 0.25f;
+			const float discriminant = b * b - a * c;
+			if (discriminant < 0 || a <= 0)
+			{
+				return false;
+			}
+			const float root = std::sqrt(discriminant);
+			t = (-b - root) / a;
+			if (t < 0)
+			{
+				t = (-b + root) / a;
+			}
+			if (t < 0 || t > maxDistance)
+			{
+				return false;
+			}
+			normal = XMFLOAT3(o.x + t * d.x, o.y + t * d.y, o.z + t * d.z);
+			return true;
+		}
+
+		/**
+		 * Cone with its apex at y = 0.5 and a base of radius 0.5 at y = -0.5, so its radius is half the height
+		 * below the apex. The side is where x^2 + z^2 = (0.5 (0.5 - y))^2 between the base and the apex
+		 */
+		bool IntersectCone(const XMFLOAT3& o, const XMFLOAT3& d, float maxDistance, float& t, XMFLOAT3& normal)
+		{
+			bool found = false;
+			t = maxDistance;
+			auto trySide = [&](float candidate)
+			{
+				const float y = o.y + candidate * d.y;
+				if (candidate >= 0 && candidate <= t && y >= -0.5f && y <= 0.5f)
+				{
+					t = candidate;
+					normal = XMFLOAT3(2 * (o.x + candidate * d.x), 0.5f * (0.5f - y), 2 * (o.z + candidate * d.z));
+					found = true;
+				}
+			};
+
+			const float height = 0.5f - o.y;
+			const float a = d.x * d.x + d.z * d.z - 0.25f * d.y * d.y;
+			const float b = 2 * (o.x * d.x + o.z * d.z) + 0.5f * height * d.y;
+			const float c = o.x * o.x + o.z * o.z - 0.25f * height * height;
+			if (std::abs(a) < 1e-12f * (d.x * d.x + d.y * d.y + d.z * d.z))
+			{
+				// Parallel to the side, which the ray crosses once
+				if (b != 0)
+				{
+					trySide(-c / b);
+				}
+			}
+			else
+			{
+				const float discriminant = b * b - 4 * a * c;
+				if (discriminant >= 0)
+				{
+					const float root = std::sqrt(discriminant);
+					trySide((-b - root) / (2 * a));
+					trySide((-b + root) / (2 * a));
+				}
+			}
+
+			if (d.y != 0)
+			{
+				const float candidate = (-0.5f - o.y) / d.y;
+				const float x = o.x + candidate * d.x;
+				const float z = o.z + candidate * d.z;
+				if (candidate >= 0 && candidate <= t && x * x + z * z <= 0.25f)
+				{
+					t = candidate;
+					normal = XMFLOAT3(0, -1, 0);
+					found = true;
+				}
+			}
+			return found;
+		}
+
+		/** Both sides of every triangle, skipping meshlets whose sphere the ray misses or only reaches past the best hit */
+		bool IntersectMesh(const MeshGeometry& geometry, FXMVECTOR origin, FXMVECTOR direction, float maxDistance, float& t, XMVECTOR& normal,
+			RayHit& hit)
+		{
+			const float directionSq = XMVectorGetX(XMVector3LengthSq(direction));
+			bool found = false;
+			t = maxDistance;
+			auto testTriangles = [&](std::uint32_t first, std::uint32_t end)
+			{
+				for (std::uint32_t i = first; i < end; i += 3)
+				{
+					const XMVECTOR p0 = XMLoadFloat3(&geometry.vertices[geometry.indices[i]].position);
+					const XMVECTOR edge1 = XMVectorSubtract(XMLoadFloat3(&geometry.vertices[geometry.indices[i + 1]].position), p0);
+					const XMVECTOR edge2 = XMVectorSubtract(XMLoadFloat3(&geometry.vertices[geometry.indices[i + 2]].position), p0);
+					const XMVECTOR p = XMVector3Cross(direction, edge2);
+					const float determinant = XMVectorGetX(XMVector3Dot(edge1, p));
+					if (determinant == 0)
+					{
+						continue;
+					}
+					const float inverse = 1.0f / determinant;
+					const XMVECTOR offset = XMVectorSubtract(origin, p0);
+					const float u = XMVectorGetX(XMVector3Dot(offset, p)) * inverse;
+					if (u < 0 || u > 1)
+					{
+						continue;
+					}
+					const XMVECTOR q = XMVector3Cross(offset, edge1);
+					const float v = XMVectorGetX(XMVector3Dot(direction, q)) * inverse;
+					if (v < 0 || u + v > 1)
+					{
+						continue;
+					}
+					const float candidate = XMVectorGetX(XMVector3Dot(edge2, q)) * inverse;
+					if (candidate >= 0 && candidate <= t)
+					{
+						t = candidate;
+						normal = XMVector3Cross(edge1, edge2);
+						hit.triangle = i / 3;
+						hit.u = u;
+						hit.v = v;
+						found = true;
+					}
+				}
+			};
+
+			if (geometry.meshletCount == 0)
+			{
+				testTriangles(0, geometry.indexCount);
+				return found;
+			}
+			for (std::uint32_t m = 0; m < geometry.meshletCount; ++m)
+			{
+				const Meshlet& meshlet = geometry.meshlets[m];
+				const XMVECTOR toCenter = XMVectorSubtract(XMLoadFloat3(&meshlet.center), origin);
+				const float along = XMVectorGetX(XMVector3Dot(toCenter, direction));
+				const float missSq = XMVectorGetX(XMVector3LengthSq(toCenter)) * directionSq - along * along;
+				const float radiusSq = meshlet.radius * meshlet.radius * directionSq;
+				if (missSq > radiusSq)
+				{
+					continue;
+				}
+				const float halfChord = std::sqrt(radiusSq - std::max(missSq, 0.0f));
+				if (along + halfChord < 0 || along - halfChord > t * directionSq)
+				{
+					continue;
+				}
+				testTriangles(meshlet.indexOffset, meshlet.indexOffset + meshlet.triangleCount * 3);
+			}
+			return found;
+		}
+	}
+
+	RayQuery::RayQuery()
+		: mMeshes(nullptr), mThreadCount(0)
+	{
+
+	}
+
+	void RayQuery::SetThreadCount(std::uint32_t threadCount)
+	{
+		mThreadCount = threadCount;
+	}
+
+	void RayQuery::Build(const std::vector<std::shared_ptr<Entity>>& entities, const MeshRegistry& meshes)
+	{
+		std::vector<const Entity*> pointers;
+		pointers.reserve(entities.size());
+		for (const auto& entity : entities)
+		{
+			pointers.push_back(entity.get());
+		}
+		Build(pointers, meshes);
+	}
+
+	void RayQuery::Build(const std::vector<const Entity*>& entities, const MeshRegistry& meshes)
+	{
+		PROFILE_ZONE("RayQuery::Build");
+		const std::uint64_t start = Profiler::Now();
+		mMeshes = &meshes;
+		mShapes.clear();
+		mNodes.clear();
+
+		// World bounds of every shape, from the bounds of its mesh moved by the absolute rotation and scale
+		std::vector<Shape> shapes;
+		std::vector<XMFLOAT3> boxMin;
+		std::vector<XMFLOAT3> boxMax;
+		std::vector<XMFLOAT3> centroids;
+		shapes.reserve(entities.size());
+		boxMin.reserve(entities.size());
+		boxMax.reserve(entities.size());
+		centroids.reserve(entities.size());
+		for (const Entity* entity : entities)
+		{
+			const XMMATRIX world = InstanceBuilder::CalculateWorldMatrix(*entity);
+			Shape shape;
+			if (!MakeShape(*entity, meshes, world, shape))
+			{
+				continue;
+			}
+			XMVECTOR localMin = XMVectorReplicate(-0.5f);
+			XMVECTOR localMax = XMVectorReplicate(0.5f);
+			if (shape.kind == ShapeKind::Mesh)
+			{
+				const MeshBounds& bounds = GetMeshBounds(shape.mesh);
+				localMin = XMLoadFloat3(&bounds.min);
+				localMax = XMLoadFloat3(&bounds.max);
+			}
+			const XMVECTOR center = XMVector3Transform(XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f), world);
+			const XMVECTOR extents = XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f);
+			const XMVECTOR worldExtents = XMVectorAdd(XMVectorAdd(
+				XMVectorScale(XMVectorAbs(world.r[0]), XMVectorGetX(extents)),
+				XMVectorScale(XMVectorAbs(world.r[1]), XMVectorGetY(extents))),
+				XMVectorScale(XMVectorAbs(world.r[2]), XMVectorGetZ(extents)));
+			shape.min = VF3(XMVectorSubtract(center, worldExtents));
+			shape.max = VF3(XMVectorAdd(center, worldExtents));
+			shapes.push_back(shape);
+			boxMin.push_back(shape.min);
+			boxMax.push_back(shape.max);
+			centroids.push_back(VF3(center));
+		}
+
+		// Top down with binned SAH splits. Children are allocated in pairs, and a tree over n shapes never has more
+		// than 2n - 1 nodes, so reserving that keeps references to nodes valid
+		const auto shapeCount = static_cast<std::uint32_t>(shapes.size());
+		std::vector<std::uint32_t> order(shapeCount);
+		for (std::uint32_t i = 0; i < shapeCount; ++i)
+		{
+			order[i] = i;
+		}
+		std::uint32_t maxDepth = 0;
+		if (shapeCount > 0)
+		{
+			mNodes.reserve(shapeCount * 2);
+			mNodes.emplace_back();
+			struct Task
+			{
+				std::uint32_t node;
+				std::uint32_t first;
+				std::uint32_t count;
+				std::uint32_t depth;
+			};
+			std::vector<Task> tasks = { { 0, 0, shapeCount, 1 } };
+			while (!tasks.empty())
+			{
+				const Task task = tasks.back();
+				tasks.pop_back();
+				maxDepth = std::max(maxDepth, task.depth);
+
+				Node& node = mNodes[task.node];
+				node.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+				node.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+				XMFLOAT3 centroidMin = node.min;
+				XMFLOAT3 centroidMax = node.max;
+				for (std::uint32_t i = task.first; i < task.first + task.count; ++i)
+				{
+					Grow(node.min, node.max, boxMin[order[i]], boxMax[order[i]]);
+					Grow(centroidMin, centroidMax, centroids[order[i]], centroids[order[i]]);
+				}
+				if (task.count <= MaxLeafShapes)
+				{
+					node.first = task.first;
+					node.count = static_cast<std::uint16_t>(task.count);
+					node.axis = 0;
+					continue;
+				}
+
+				// Cheapest split between bins on any axis, by count times area on each side
+				float bestCost = FLT_MAX;
+				std::uint32_t bestAxis = 0;
+				std::uint32_t bestSplit = 0;
+				for (std::uint32_t axis = 0; axis < 3; ++axis)
+				{
+					const float low = Component(centroidMin, axis);
+					const float extent = Component(centroidMax, axis) - low;
+					if (extent <= 0)
+					{
+						continue;
+					}
+					std::uint32_t binCounts[SahBins] = {};
+					XMFLOAT3 binMin[SahBins];
+					XMFLOAT3 binMax[SahBins];
+					std::fill(binMin, binMin + SahBins, XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX));
+					std::fill(binMax, binMax + SahBins, XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+					const float scale = SahBins / extent;
+					for (std::uint32_t i = task.first; i < task.first + task.count; ++i)
+					{
+						const std::uint32_t shape = order[i];
+						const auto bin = std::min(static_cast<std::uint32_t>((Component(centroids[shape], axis) - low) * scale), SahBins - 1);
+						++binCounts[bin];
+						Grow(binMin[bin], binMax[bin], boxMin[shape], boxMax[shape]);
+					}
+					float rightArea[SahBins];
+					std::uint32_t rightCount[SahBins];
+					XMFLOAT3 sweepMin(FLT_MAX, FLT_MAX, FLT_MAX);
+					XMFLOAT3 sweepMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+					std::uint32_t count = 0;
+					for (std::uint32_t bin = SahBins - 1; bin > 0; --bin)
+					{
+						Grow(sweepMin, sweepMax, binMin[bin], binMax[bin]);
+						count += binCounts[bin];
+						rightArea[bin] = count > 0 ? HalfArea(sweepMin, sweepMax) : 0;
+						rightCount[bin] = count;
+					}
+					sweepMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+					sweepMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+					count = 0;
+					for (std::uint32_t split = 1; split < SahBins; ++split)
+					{
+						Grow(sweepMin, sweepMax, binMin[split - 1], binMax[split - 1]);
+						count += binCounts[split - 1];
+						if (count == 0 || rightCount[split] == 0)
+						{
+							continue;
+						}
+						const float cost = count * HalfArea(sweepMin, sweepMax) + rightCount[split] * rightArea[split];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestSplit = split;
+						}
+					}
+				}
+
+				std::uint32_t* first = order.data() + task.first;
+				std::uint32_t* end = first + task.count;
+				std::uint32_t* middle = first + task.count / 2;
+				if (bestSplit > 0)
+				{
+					const float low = Component(centroidMin, bestAxis);
+					const float scale = SahBins / (Component(centroidMax, bestAxis) - low);
+					middle = std::partition(first, end, [&](std::uint32_t shape)
+					{
+						return std::min(static_cast<std::uint32_t>((Component(centroids[shape], bestAxis) - low) * scale), SahBins - 1) < bestSplit;
+					});
+				}
+				else
+				{
+					// Every centroid is in one place, so any even split is as good as another
+					bestAxis = 0;
+				}
+
+				const auto left = static_cast<std::uint32_t>(mNodes.size());
+				const auto leftCount = static_cast<std::uint32_t>(middle - first);
+				node.first = left;
+				node.count = 0;
+				node.axis = static_cast<std::uint16_t>(bestAxis);
+				mNodes.emplace_back();
+				mNodes.emplace_back();
+				tasks.push_back({ left, task.first, leftCount, task.depth + 1 });
+				tasks.push_back({ left + 1, task.first + leftCount, task.count - leftCount, task.depth + 1 });
+			}
+		}
+
+		// Leaves refer to runs of shapes, so the shapes are stored in the order the tree left them
+		mShapes.reserve(shapeCount);
+		for (std::uint32_t shape : order)
+		{
+			mShapes.push_back(shapes[shape]);
+		}
+
+		mStats = RayQueryStats();
+		mStats.entities = shapeCount;
+		mStats.nodes = static_cast<std::uint32_t>(mNodes.size());
+		mStats.depth = maxDepth;
+		mStats.buildMilliseconds = (Profiler::Now() - start) / 1e6;
+	}
+
+	void RayQuery::Intersect(const Ray* rays, size_t count, RayHit* hits, RayQueryMode mode)
+	{
+		PROFILE_ZONE("RayQuery::Intersect");
+		const std::uint64_t start = Profiler::Now();
+		const size_t packetCount = (count + PacketSize - 1) / PacketSize;
+		const size_t taskCount = (packetCount + PacketsPerTask - 1) / PacketsPerTask;
+		const std::uint32_t hardwareThreads = mThreadCount > 0 ? mThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		const auto threadCount = static_cast<std::uint32_t>(std::max<size_t>(std::min<size_t>(hardwareThreads, taskCount), 1));
+
+		std::vector<TraceCounts> counts(threadCount);
+		std::atomic<size_t> next(0);
+		auto work = [&](std::uint32_t thread)
+		{
+			// A walk never holds more than one pending node per level
+			std::vector<std::uint32_t> stack;
+			stack.reserve(mStats.depth + 1);
+			for (size_t task = next.fetch_add(1, std::memory_order_relaxed); task < taskCount; task = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				const size_t end = std::min(count, (task + 1) * PacketsPerTask * PacketSize);
+				for (size_t first = task * PacketsPerTask * PacketSize; first < end; first += PacketSize)
+				{
+					const auto laneCount = static_cast<std::uint32_t>(std::min<size_t>(PacketSize, end - first));
+					TracePacket(rays + first, laneCount, hits + first, mode, stack, counts[thread]);
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (std::uint32_t thread = 1; thread < threadCount; ++thread)
+		{
+			workers.emplace_back(work, thread);
+		}
+		work(0);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		mStats.rays = count;
+		mStats.hits = 0;
+		mStats.nodesVisited = 0;
+		mStats.shapesTested = 0;
+		for (const TraceCounts& threadCounts : counts)
+		{
+			mStats.hits += threadCounts.hits;
+			mStats.nodesVisited += threadCounts.nodesVisited;
+			mStats.shapesTested += threadCounts.shapesTested;
+		}
+		mStats.threads = threadCount;
+		mStats.queryMilliseconds = (Profiler::Now() - start) / 1e6;
+	}
+
+	RayHit RayQuery::Intersect(const Ray& ray, RayQueryMode mode)
+	{
+		RayHit hit;
+		Intersect(&ray, 1, &hit, mode);
+		return hit;
+	}
+
+	void RayQuery::IntersectSerial(const Ray* rays, size_t count, RayHit* hits, RayQueryMode mode) const
+	{
+		std::vector<std::uint32_t> stack;
+		stack.reserve(mStats.depth + 1);
+		TraceCounts counts;
+		for (size_t first = 0; first < count; first += PacketSize)
+		{
+			const auto laneCount = static_cast<std::uint32_t>(std::min<size_t>(PacketSize, count - first));
+			TracePacket(rays + first, laneCount, hits + first, mode, stack, counts);
+		}
+	}
+
+	bool RayQuery::IntersectEntity(const Entity& entity, const MeshRegistry& meshes, const Ray& ray, RayHit& hit)
+	{
+		Shape shape;
+		return MakeShape(entity, meshes, InstanceBuilder::CalculateWorldMatrix(entity), shape) &&
+			IntersectShape(shape, meshes, XMLoadFloat3(&ray.origin), XMLoadFloat3(&ray.direction), ray.maxDistance, hit);
+	}
+
+	const RayQueryStats& RayQuery::GetStats() const
+	{
+		return mStats;
+	}
+
+	bool RayQuery::MakeShape(const Entity& entity, const MeshRegistry& meshes, FXMMATRIX world, Shape& shape)
+	{
+		if (entity.scale.x == 0 || entity.scale.y == 0 || entity.scale.z == 0 || !meshes.IsLoaded(entity.mesh))
+		{
+			return false;
+		}
+		switch (entity.mesh)
+		{
+		case BuiltinMeshes::Cube:
+			shape.kind = ShapeKind::Box;
+			break;
+		case BuiltinMeshes::Sphere:
+			shape.kind = ShapeKind::Sphere;
+			break;
+		case BuiltinMeshes::Cone:
+			shape.kind = ShapeKind::Cone;
+			break;
+		default:
+			if (meshes.GetGeometry(entity.mesh).indexCount == 0)
+			{
+				return false;
+			}
+			shape.kind = ShapeKind::Mesh;
+			break;
+		}
+		XMStoreFloat4x4(&shape.worldToLocal, XMMatrixInverse(nullptr, world));
+		shape.entity = &entity;
+		shape.mesh = entity.mesh;
+		return true;
+	}
+
+	bool RayQuery::IntersectShape(const Shape& shape, const MeshRegistry& meshes, FXMVECTOR origin, FXMVECTOR direction, float maxDistance,
+		RayHit& hit)
+	{
+		// Distances along the ray are the same in both spaces, since the transform is affine
+		const XMMATRIX worldToLocal = XMLoadFloat4x4(&shape.worldToLocal);
+		const XMVECTOR localOrigin = XMVector3Transform(origin, worldToLocal);
+		const XMVECTOR localDirection = XMVector3TransformNormal(direction, worldToLocal);
+		float t = 0;
+		XMVECTOR normal = XMVectorZero();
+		if (shape.kind == ShapeKind::Mesh)
+		{
+			if (!IntersectMesh(meshes.GetGeometry(shape.mesh), localOrigin, localDirection, maxDistance, t, normal, hit))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			const XMFLOAT3 o = VF3(localOrigin);
+			const XMFLOAT3 d = VF3(localDirection);
+			XMFLOAT3 localNormal;
+			const bool found = shape.kind == ShapeKind::Box ? IntersectBox(o, d, maxDistance, t, localNormal) :
+				shape.kind == ShapeKind::Sphere ? IntersectSphere(o, d, maxDistance, t, localNormal) :
+				IntersectCone(o, d, maxDistance, t, localNormal);
+			if (!found)
+			{
+				return false;
+			}
+			normal = XMLoadFloat3(&localNormal);
+		}
+
+		// Normals go back to world space by the transpose of the inverse transform
+		hit.entity = shape.entity;
+		hit.distance = t;
+		XMStoreFloat3(&hit.normal, XMVector3Normalize(XMVector3TransformNormal(normal, XMMatrixTranspose(worldToLocal))));
+		return true;
+	}
+
+	void RayQuery::TracePacket(const Ray* rays, std::uint32_t laneCount, RayHit* hits, RayQueryMode mode, std::vector<std::uint32_t>& stack,
+		TraceCounts& counts) const
+	{
+		// Lanes past the end of the batch start finished
+		XMFLOAT4A originX(0, 0, 0, 0), originY(0, 0, 0, 0), originZ(0, 0, 0, 0);
+		XMFLOAT4A inverseX(0, 0, 0, 0), inverseY(0, 0, 0, 0), inverseZ(0, 0, 0, 0);
+		XMFLOAT4A closest(-1, -1, -1, -1);
+		std::uint32_t active = 0;
+		for (std::uint32_t lane = 0; lane < laneCount; ++lane)
+		{
+			const Ray& ray = rays[lane];
+			Lane(originX, lane) = ray.origin.x;
+			Lane(originY, lane) = ray.origin.y;
+			Lane(originZ, lane) = ray.origin.z;
+			Lane(inverseX, lane) = SafeInverse(ray.direction.x);
+			Lane(inverseY, lane) = SafeInverse(ray.direction.y);
+			Lane(inverseZ, lane) = SafeInverse(ray.direction.z);
+			Lane(closest, lane) = ray.maxDistance;
+			hits[lane] = RayHit();
+			active |= ray.maxDistance >= 0 ? 1u << lane : 0;
+		}
+		if (mNodes.empty())
+		{
+			return;
+		}
+
+		const XMVECTOR vOriginX = XMLoadFloat4A(&originX);
+		const XMVECTOR vOriginY = XMLoadFloat4A(&originY);
+		const XMVECTOR vOriginZ = XMLoadFloat4A(&originZ);
+		const XMVECTOR vInverseX = XMLoadFloat4A(&inverseX);
+		const XMVECTOR vInverseY = XMLoadFloat4A(&inverseY);
+		const XMVECTOR vInverseZ = XMLoadFloat4A(&inverseZ);
+		XMVECTOR vClosest = XMLoadFloat4A(&closest);
+		const XMVECTOR zero = XMVectorZero();
+
+		// Lanes of the rays still going that cross a box before their closest hit, testing the slabs of all four at once
+		auto crossedBy = [&](const XMFLOAT3& min, const XMFLOAT3& max)
+		{
+			const XMVECTOR nearX = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(min.x), vOriginX), vInverseX);
+			const XMVECTOR farX = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(max.x), vOriginX), vInverseX);
+			const XMVECTOR nearY = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(min.y), vOriginY), vInverseY);
+			const XMVECTOR farY = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(max.y), vOriginY), vInverseY);
+			const XMVECTOR nearZ = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(min.z), vOriginZ), vInverseZ);
+			const XMVECTOR farZ = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(max.z), vOriginZ), vInverseZ);
+			const XMVECTOR entry = XMVectorMax(XMVectorMax(XMVectorMin(nearX, farX), XMVectorMin(nearY, farY)), XMVectorMin(nearZ, farZ));
+			const XMVECTOR exit = XMVectorMin(XMVectorMin(XMVectorMax(nearX, farX), XMVectorMax(nearY, farY)), XMVectorMax(nearZ, farZ));
+			const XMVECTOR crossed = XMVectorAndInt(XMVectorAndInt(XMVectorLessOrEqual(entry, exit), XMVectorGreaterOrEqual(exit, zero)),
+				XMVectorLessOrEqual(entry, vClosest));
+			return LaneMask(crossed) & active;
+		};
+
+		stack.clear();
+		stack.push_back(0);
+		while (!stack.empty() && active != 0)
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+			++counts.nodesVisited;
+
+			// Nodes are tested when taken rather than when pushed, so hits found in the meantime shorten the rays first
+			const std::uint32_t mask = crossedBy(node.min, node.max);
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			if (node.count == 0)
+			{
+				// The nearer child is taken first, going by the first ray still in the box
+				std::uint32_t lane = 0;
+				while ((mask & (1u << lane)) == 0)
+				{
+					++lane;
+				}
+				const bool backwards = Component(rays[lane].direction, node.axis) < 0;
+				stack.push_back(backwards ? node.first : node.first + 1);
+				stack.push_back(backwards ? node.first + 1 : node.first);
+				continue;
+			}
+
+			// Each shape's own bounds are tested for the whole packet before the exact test of each ray
+			for (std::uint32_t s = node.first; s < node.first + node.count; ++s)
+			{
+				const Shape& shape = mShapes[s];
+				const std::uint32_t shapeMask = crossedBy(shape.min, shape.max);
+				for (std::uint32_t lane = 0; lane < PacketSize; ++lane)
+				{
+					if ((shapeMask & (1u << lane)) == 0)
+					{
+						continue;
+					}
+					++counts.shapesTested;
+					const Ray& ray = rays[lane];
+					RayHit hit;
+					if (IntersectShape(shape, *mMeshes, XMLoadFloat3(&ray.origin), XMLoadFloat3(&ray.direction), Lane(closest, lane), hit))
+					{
+						hits[lane] = hit;
+						Lane(closest, lane) = hit.distance;
+						if (mode == RayQueryMode::Any)
+						{
+							active &= ~(1u << lane);
+						}
+					}
+				}
+				vClosest = XMLoadFloat4A(&closest);
+			}
+		}
+
+		for (std::uint32_t lane = 0; lane < laneCount; ++lane)
+		{
+			counts.hits += hits[lane].entity ? 1 : 0;
+		}
+	}
+
+	const RayQuery::MeshBounds& RayQuery::GetMeshBounds(MeshHandle mesh)
+	{
+		if (mesh >= mMeshBounds.size())
+		{
+			mMeshBounds.resize(mMeshes->GetHandleCount());
+		}
+		MeshBounds& bounds = mMeshBounds[mesh];
+		const std::uint32_t version = mMeshes->GetVersion(mesh);
+		if (bounds.version != version)
+		{
+			const MeshGeometry& geometry = mMeshes->GetGeometry(mesh);
+			XMFLOAT3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+			XMFLOAT3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (std::uint32_t i = 0; i < geometry.vertexCount; ++i)
+			{
+				Grow(min, max, geometry.vertices[i].position, geometry.vertices[i].position);
+			}
+			bounds.min = min;
+			bounds.max = max;
+			bounds.version = version;
+		}
+		return bounds;
+	}
+}
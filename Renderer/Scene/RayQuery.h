@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Rendering/DataTypes.h"
+
+namespace renderer
+{
+	class MeshRegistry;
+
+	/** Ray in world space. Distances are in multiples of the direction, so a unit direction gives world units */
+	struct Ray
+	{
+		XMFLOAT3 origin = { 0, 0, 0 };
+		XMFLOAT3 direction = { 0, 0, 1 };
+		float maxDistance = FLT_MAX;
+	};
+
+	/** Where a ray met an entity. The entity is null when the ray hit nothing */
+	struct RayHit
+	{
+		const Entity* entity = nullptr;
+		float distance = 0;
+		// Unit world space normal of the surface, pointing out of the shape
+		XMFLOAT3 normal = { 0, 0, 0 };
+		// Triangle of a registered mesh, as its first index over three, and the weights of its second and third
+		// vertices at the hit. Zero for the built-in shapes
+		std::uint32_t triangle = 0;
+		float u = 0;
+		float v = 0;
+	};
+
+	enum class RayQueryMode
+	{
+		// The nearest hit of every ray, for picking and placement
+		Closest,
+		// Any hit before the ray's max distance, which is enough to tell whether a line of sight is blocked
+		Any
+	};
+
+	/** Figures of the last Build and the last batch of rays */
+	struct RayQueryStats
+	{
+		std::uint32_t entities = 0;
+		std::uint32_t nodes = 0;
+		std::uint32_t depth = 0;
+		double buildMilliseconds = 0;
+		std::uint64_t rays = 0;
+		std::uint64_t hits = 0;
+		// Node bounds tested per packet and shapes tested exactly per ray
+		std::uint64_t nodesVisited = 0;
+		std::uint64_t shapesTested = 0;
+		std::uint32_t threads = 0;
+		double queryMilliseconds = 0;
+	};
+
+	/**
+	 * Casts rays against entities through a bounding volume hierarchy over their world bounds. The hierarchy is a
+	 * snapshot: moving, adding or removing entities takes another Build, and hits point at the entities it was
+	 * built from.
+	 *
+	 * Rays are traced in packets of four that share a walk of the hierarchy, with the node bounds of all four
+	 * tested at once, so batches whose neighbouring rays go the same way, such as rays through neighbouring pixels,
+	 * are fastest. Each ray is then tested exactly against the shapes in the leaves it reaches, in the shape's own
+	 * space: cubes as oriented boxes, spheres and cones analytically, and registered meshes triangle by triangle,
+	 * skipping meshlets the ray misses. Spheres have a radius of 0.5 and cones stand on the y axis with a base of
+	 * radius 0.5 at y = -0.5 and the apex at y = 0.5, so every built-in fits the unit cube.
+	 */
+	class RayQuery
+	{
+	public:
+		static constexpr std::uint32_t PacketSize = 4;
+		static constexpr std::uint32_t MaxLeafShapes = 4;
+
+		RayQuery();
+
+		/** Threads a batch is split over. Zero uses one per hardware thread */
+		void SetThreadCount(std::uint32_t threadCount);
+		/**
+		 * Builds the hierarchy from the entities' current transforms. Entities with a zero scale or a mesh that is
+		 * not loaded are left out. The registry is read by later queries, so it has to outlive them
+		 */
+		void Build(const std::vector<const Entity*>& entities, const MeshRegistry& meshes);
+		void Build(const std::vector<std::shared_ptr<Entity>>& entities, const MeshRegistry& meshes);
+		/** Writes a hit for every ray. Batches are split over threads in runs of whole packets */
+		void Intersect(const Ray* rays, size_t count, RayHit* hits, RayQueryMode mode = RayQueryMode::Closest);
+		RayHit Intersect(const Ray& ray, RayQueryMode mode = RayQueryMode::Closest);
+		/**
+		 * Writes a hit for every ray on the calling thread and leaves the stats alone, so threads of a caller that
+		 * splits its own work can share one query
+		 */
+		void IntersectSerial(const Ray* rays, size_t count, RayHit* hits, RayQueryMode mode = RayQueryMode::Closest) const;
+		/** Tests one entity exactly, without the hierarchy. Returns false if the ray misses it */
+		static bool IntersectEntity(const Entity& entity, const MeshRegistry& meshes, const Ray& ray, RayHit& hit);
+		const RayQueryStats& GetStats() const;
+
+	private:
+		/** Box of a node. Leaves have shapes, and the two children of an inner node are next to each other */
+		struct Node
+		{
+			XMFLOAT3 min;
+			// First shape of a leaf or the left child of an inner node
+			std::uint32_t first;
+			XMFLOAT3 max;
+			// Zero for an inner node
+			std::uint16_t count;
+			// Axis the children of an inner node were split on, for visiting the nearer one first
+			std::uint16_t axis;
+		};
+
+		enum class ShapeKind : std::uint32_t
+		{
+			Box,
+			Sphere,
+			Cone,
+			Mesh
+		};
+
+		/** An entity ready to test, with the transform from world space into its mesh's space */
+		struct Shape
+		{
+			XMFLOAT4X4 worldToLocal;
+			// World bounds, which the whole packet is tested against before testing the shape exactly
+			XMFLOAT3 min;
+			XMFLOAT3 max;
+			const Entity* entity;
+			MeshHandle mesh;
+			ShapeKind kind;
+		};
+
+		struct TraceCounts
+		{
+			std::uint64_t hits = 0;
+			std::uint64_t nodesVisited = 0;
+			std::uint64_t shapesTested = 0;
+		};
+
+		/** Bounds of the unscaled mesh, cached by handle and version */
+		struct MeshBounds
+		{
+			XMFLOAT3 min;
+			XMFLOAT3 max;
+			std::uint32_t version = 0;
+		};
+
+		static bool MakeShape(const Entity& entity, const MeshRegistry& meshes, FXMMATRIX world, Shape& shape);
+		static bool IntersectShape(const Shape& shape, const MeshRegistry& meshes, FXMVECTOR origin, FXMVECTOR direction, float maxDistance,
+			RayHit& hit);
+		void TracePacket(const Ray* rays, std::uint32_t laneCount, RayHit* hits, RayQueryMode mode, std::vector<std::uint32_t>& stack,
+			TraceCounts& counts) const;
+		const MeshBounds& GetMeshBounds(MeshHandle mesh);
+
+		std::vector<Node> mNodes;
+		std::vector<Shape> mShapes;
+		std::vector<MeshBounds> mMeshBounds;
+		const MeshRegistry* mMeshes;
+		std::uint32_t mThreadCount;
+		RayQueryStats mStats;
+	};
+}
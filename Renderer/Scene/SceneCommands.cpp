@@ -0,0 +1,200 @@
+#include "SceneCommands.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	void SceneChanges::Clear()
+	{
+		added.clear();
+		removed.clear();
+		addedPointLights.clear();
+		movedStatic.clear();
+		commands = 0;
+		batches = 0;
+	}
+
+	SceneCommandQueue::SceneCommandQueue()
+	{
+	}
+
+	SceneCommandQueue::~SceneCommandQueue()
+	{
+		SceneCommandBatch* batch = mBatches.PopAll();
+		while (batch)
+		{
+			SceneCommandBatch* next = batch->next;
+			delete batch;
+			batch = next;
+		}
+	}
+
+	void SceneCommandQueue::Submit(std::unique_ptr<SceneCommandBatch> batch)
+	{
+		mBatches.Push(batch.release());
+	}
+
+	bool SceneCommandQueue::Merge(SceneChanges& changes)
+	{
+		changes.Clear();
+		SceneCommandBatch* first = mBatches.PopAll();
+		if (!first)
+		{
+			return false;
+		}
+
+		PROFILE_ZONE("SceneCommandQueue::Merge");
+		// Sized once for the whole merge. Additions are only looked up again when something is removed, which is
+		// rare enough in bulk loads that they do not pay for the lookups
+		size_t additions = 0;
+		std::uint32_t removals = 0;
+		for (SceneCommandBatch* batch = first; batch; batch = batch->next)
+		{
+			additions += batch->commands.size();
+			removals += batch->removals;
+		}
+		changes.added.reserve(additions);
+		mAddedIndices.clear();
+
+		bool cancelled = false;
+		SceneCommandBatch* batch = first;
+		while (batch)
+		{
+			for (SceneCommand& command : batch->commands)
+			{
+				switch (command.type)
+				{
+				case SceneCommandType::AddEntity:
+					if (removals > 0)
+					{
+						mAddedIndices[command.entity.get()] = changes.added.size();
+					}
+					changes.added.push_back(std::move(command.entity));
+					break;
+				case SceneCommandType::RemoveEntity:
+				{
+					// An addition earlier in the merge is dropped. The removal still goes to the renderer, which
+					// ignores it unless the entity was there before
+					auto added = mAddedIndices.find(command.entity.get());
+					if (added != mAddedIndices.end())
+					{
+						changes.added[added->second].reset();
+						mAddedIndices.erase(added);
+						cancelled = true;
+					}
+					changes.removed.push_back(std::move(command.entity));
+					break;
+				}
+				case SceneCommandType::UpdateEntity:
+				{
+					Entity& entity = *command.entity;
+					entity.position = command.position;
+					entity.rotation = command.rotation;
+					entity.scale = command.scale;
+					if (entity.isStatic)
+					{
+						changes.movedStatic.push_back(&entity);
+					}
+					break;
+				}
+				}
+			}
+			changes.addedPointLights.insert(changes.addedPointLights.end(), batch->pointLights.begin(), batch->pointLights.end());
+			changes.commands += batch->commands.size() + batch->pointLights.size();
+			++changes.batches;
+
+			SceneCommandBatch* next = batch->next;
+			delete batch;
+			batch = next;
+		}
+		if (cancelled)
+		{
+			changes.added.erase(std::remove(changes.added.begin(), changes.added.end(), nullptr), changes.added.end());
+		}
+		return true;
+	}
+
+	bool SceneCommandQueue::IsEmpty() const
+	{
+		return mBatches.IsEmpty();
+	}
+
+	SceneCommandBuffer::SceneCommandBuffer(SceneCommandQueue& queue)
+		: mQueue(queue), mLastSize(0)
+	{
+	}
+
+	SceneCommandBuffer::~SceneCommandBuffer()
+	{
+		Submit();
+	}
+
+	void SceneCommandBuffer::AddEntity(const std::shared_ptr<Entity>& entity)
+	{
+		SceneCommand command = {};
+		command.type = SceneCommandType::AddEntity;
+		command.entity = entity;
+		GetBatch().commands.push_back(std::move(command));
+	}
+
+	void SceneCommandBuffer::AddEntities(const std::vector<std::shared_ptr<Entity>>& entities)
+	{
+		SceneCommandBatch& batch = GetBatch();
+		batch.commands.reserve(batch.commands.size() + entities.size());
+		for (const auto& entity : entities)
+		{
+			AddEntity(entity);
+		}
+	}
+
+	void SceneCommandBuffer::RemoveEntity(const std::shared_ptr<Entity>& entity)
+	{
+		SceneCommand command = {};
+		command.type = SceneCommandType::RemoveEntity;
+		command.entity = entity;
+		SceneCommandBatch& batch = GetBatch();
+		batch.commands.push_back(std::move(command));
+		++batch.removals;
+	}
+
+	void SceneCommandBuffer::UpdateEntity(const std::shared_ptr<Entity>& entity, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+	{
+		SceneCommand command;
+		command.type = SceneCommandType::UpdateEntity;
+		command.entity = entity;
+		command.position = position;
+		command.rotation = rotation;
+		command.scale = scale;
+		GetBatch().commands.push_back(std::move(command));
+	}
+
+	void SceneCommandBuffer::AddPointLight(const std::shared_ptr<PointLight>& pointLight)
+	{
+		GetBatch().pointLights.push_back(pointLight);
+	}
+
+	void SceneCommandBuffer::Submit()
+	{
+		if (!mBatch || (mBatch->commands.empty() && mBatch->pointLights.empty()))
+		{
+			return;
+		}
+		mLastSize = mBatch->commands.size();
+		mBatch->memory.Set(mBatch->commands.capacity() * sizeof(SceneCommand) + mBatch->pointLights.capacity() * sizeof(std::shared_ptr<PointLight>));
+		mQueue.Submit(std::move(mBatch));
+	}
+
+	size_t SceneCommandBuffer::GetSize() const
+	{
+		return mBatch ? mBatch->commands.size() + mBatch->pointLights.size() : 0;
+	}
+
+	SceneCommandBatch& SceneCommandBuffer::GetBatch()
+	{
+		if (!mBatch)
+		{
+			mBatch = std::make_unique<SceneCommandBatch>();
+			mBatch->commands.reserve(mLastSize);
+		}
+		return *mBatch;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Base/MpscQueue.h"
+#include "Rendering/DataTypes.h"
+#include "Memory/MemoryTracker.h"
+
+namespace renderer
+{
+	enum class SceneCommandType : std::uint8_t
+	{
+		AddEntity,
+		RemoveEntity,
+		// Moves the entity when the command is applied, on the thread that renders
+		UpdateEntity
+	};
+
+	struct SceneCommand
+	{
+		SceneCommandType type;
+		std::shared_ptr<Entity> entity;
+		// Of UpdateEntity
+		XMFLOAT3 position;
+		XMFLOAT4 rotation;
+		XMFLOAT3 scale;
+	};
+
+	/** Commands one thread recorded and submitted together, applied in the order they were recorded */
+	struct SceneCommandBatch
+	{
+		std::vector<SceneCommand> commands;
+		std::vector<std::shared_ptr<PointLight>> pointLights;
+		std::uint32_t removals = 0;
+		SceneCommandBatch* next = nullptr;
+		TrackedMemory memory = TrackedMemory(MemoryTag::SceneCommands);
+	};
+
+	/** What merging the submitted commands changed, to give to the renderer in one go */
+	struct SceneChanges
+	{
+		// Removals go to the renderer before additions, so an entity removed and added again stays
+		std::vector<std::shared_ptr<Entity>> added;
+		std::vector<std::shared_ptr<Entity>> removed;
+		std::vector<std::shared_ptr<PointLight>> addedPointLights;
+		// Static entities that were moved, whose batches need rebuilding
+		std::vector<const Entity*> movedStatic;
+		std::uint64_t commands = 0;
+		std::uint32_t batches = 0;
+
+		void Clear();
+	};
+
+	/**
+	 * Scene commands from any number of threads, merged into the scene at a frame boundary. Threads record into
+	 * SceneCommandBuffers of their own and submit whole batches through a lock free queue, so recording takes no
+	 * lock and never touches the renderer. The thread that renders merges every submitted batch in one pass, in
+	 * the order each thread recorded them, and gives the renderer all the additions and removals at once.
+	 */
+	class SceneCommandQueue
+	{
+	public:
+		SceneCommandQueue();
+		~SceneCommandQueue();
+		SceneCommandQueue(const SceneCommandQueue&) = delete;
+		SceneCommandQueue& operator=(const SceneCommandQueue&) = delete;
+
+		/** Any thread. The queue owns the batch from here */
+		void Submit(std::unique_ptr<SceneCommandBatch> batch);
+		/**
+		 * Takes every batch submitted so far and applies the updates to their entities. Gives the entities to add
+		 * and remove, leaving out additions removed later in the same merge. Returns false if there was nothing to
+		 * merge. Only call from one thread at a time, between frames
+		 */
+		bool Merge(SceneChanges& changes);
+		/** Only a hint while other threads submit */
+		bool IsEmpty() const;
+
+	private:
+		MpscQueue<SceneCommandBatch> mBatches;
+		// Where each entity added in the merge is in the additions, only filled when the merge removes any
+		std::unordered_map<const Entity*, size_t> mAddedIndices;
+	};
+
+	/**
+	 * Records scene commands on one thread. Nothing reaches the scene until Submit, and then as one batch merged
+	 * at the next frame boundary. Submitting allocates the batch, so record in bulk and submit once per frame or
+	 * per load rather than per command. Entities given to the buffer should not be changed directly any more, as
+	 * the renderer may be reading them. Move them with UpdateEntity instead.
+	 */
+	class SceneCommandBuffer
+	{
+	public:
+		explicit SceneCommandBuffer(SceneCommandQueue& queue);
+		/** Submits whatever is left */
+		~SceneCommandBuffer();
+		SceneCommandBuffer(const SceneCommandBuffer&) = delete;
+		SceneCommandBuffer& operator=(const SceneCommandBuffer&) = delete;
+
+		void AddEntity(const std::shared_ptr<Entity>& entity);
+		void AddEntities(const std::vector<std::shared_ptr<Entity>>& entities);
+		void RemoveEntity(const std::shared_ptr<Entity>& entity);
+		void UpdateEntity(const std::shared_ptr<Entity>& entity, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale);
+		void AddPointLight(const std::shared_ptr<PointLight>& pointLight);
+		/** Hands everything recorded since the last submit to the queue */
+		void Submit();
+		/** Commands recorded and not yet submitted */
+		size_t GetSize() const;
+
+	private:
+		SceneCommandBatch& GetBatch();
+
+		SceneCommandQueue& mQueue;
+		std::unique_ptr<SceneCommandBatch> mBatch;
+		// Size of the last batch submitted, which the next is reserved for
+		size_t mLastSize;
+	};
+}
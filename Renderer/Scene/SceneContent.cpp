@@ -0,0 +1,58 @@
+#include "SceneContent.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	namespace
+	{
+		/** Pointers to every element of one shared block, which they all keep alive */
+		template<typename T>
+		std::vector<std::shared_ptr<T>> ShareElements(const std::shared_ptr<std::vector<T>>& block)
+		{
+			std::vector<std::shared_ptr<T>> pointers;
+			pointers.reserve(block->size());
+			for (T& element : *block)
+			{
+				pointers.emplace_back(block, &element);
+			}
+			return pointers;
+		}
+	}
+
+	SceneContent SceneContent::Create(const SceneArrays& scene)
+	{
+		auto materials = ShareElements(std::make_shared<std::vector<Material>>(scene.materials, scene.materials + scene.materialCount));
+		SceneContent content = Create(scene, materials);
+		content.materials = std::move(materials);
+		return content;
+	}
+
+	SceneContent SceneContent::Create(const SceneArrays& scene, const std::vector<std::shared_ptr<Material>>& materials)
+	{
+		PROFILE_ZONE("SceneContent::Create");
+		SceneContent content;
+		auto entities = std::make_shared<std::vector<Entity>>(scene.entityCount);
+		for (std::uint32_t i = 0; i < scene.entityCount; ++i)
+		{
+			Entity& entity = (*entities)[i];
+			entity.material = materials[scene.materialIndices[i]];
+			entity.mesh = scene.meshTypes[i];
+			entity.position = scene.positions[i];
+			entity.rotation = scene.rotations[i];
+			entity.scale = scene.scales[i];
+			entity.isStatic = (scene.flags[i] & SceneEntityStatic) != 0;
+		}
+		content.entities = ShareElements(entities);
+
+		// Lights are few and the renderers take them one at a time
+		for (std::uint32_t i = 0; i < scene.pointLightCount; ++i)
+		{
+			content.pointLights.push_back(std::make_shared<PointLight>(scene.pointLights[i]));
+		}
+		for (std::uint32_t i = 0; i < scene.spotLightCount; ++i)
+		{
+			content.spotLights.push_back(std::make_shared<SpotLight>(scene.spotLights[i]));
+		}
+		return content;
+	}
+}
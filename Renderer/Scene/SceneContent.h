@@ -0,0 +1,26 @@
+#pragma once
+
+#include "SceneFile.h"
+
+namespace renderer
+{
+	/**
+	 * Renderer objects made from scene arrays. The entities share one allocation, as do the materials, so a large
+	 * scene costs two allocations rather than one per entity, and each pointer keeps its whole block alive.
+	 */
+	struct SceneContent
+	{
+		std::vector<std::shared_ptr<Material>> materials;
+		std::vector<std::shared_ptr<Entity>> entities;
+		std::vector<std::shared_ptr<PointLight>> pointLights;
+		std::vector<std::shared_ptr<SpotLight>> spotLights;
+
+		/** The arrays must be valid, as SceneFile::Open and SceneText::Import leave them */
+		static SceneContent Create(const SceneArrays& scene);
+		/**
+		 * Uses the given materials, numbered like the scene's, instead of making new ones, so scenes loaded
+		 * separately can share them. Content made this way holds no materials of its own
+		 */
+		static SceneContent Create(const SceneArrays& scene, const std::vector<std::shared_ptr<Material>>& materials);
+	};
+}
@@ -0,0 +1,400 @@
+#include "SceneFile.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	namespace
+	{
+		struct SceneHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			std::uint32_t sectionCount;
+			std::uint32_t reserved;
+			std::uint64_t fileSize;
+		};
+
+		/** Entry of the section table, which follows the header */
+		struct SectionHeader
+		{
+			std::uint32_t id;
+			// Size of an element when the file was written, so layouts that differ from this build are caught
+			std::uint32_t elementSize;
+			std::uint64_t count;
+			std::uint64_t offset;
+		};
+
+		enum class SectionId : std::uint32_t
+		{
+			Positions = 1,
+			Rotations,
+			Scales,
+			MeshTypes,
+			MaterialIndices,
+			Flags,
+			Materials,
+			PointLights,
+			SpotLights
+		};
+
+		constexpr char SceneMagic[4] = { 'S', 'C', 'N', 'E' };
+
+		static_assert(sizeof(SceneHeader) == 24 && sizeof(SectionHeader) == 24, "Scene files store headers as they are in memory");
+
+		/** What the reader expects of a section and where it puts it */
+		struct SectionLayout
+		{
+			SectionId id;
+			std::uint32_t elementSize;
+			bool perEntity;
+			bool required;
+		};
+
+		constexpr SectionLayout SectionLayouts[] =
+		{
+			{ SectionId::Positions, sizeof(XMFLOAT3), true, true },
+			{ SectionId::Rotations, sizeof(XMFLOAT4), true, true },
+			{ SectionId::Scales, sizeof(XMFLOAT3), true, true },
+			{ SectionId::MeshTypes, sizeof(std::uint8_t), true, true },
+			{ SectionId::MaterialIndices, sizeof(std::uint32_t), true, true },
+			{ SectionId::Flags, sizeof(std::uint8_t), true, true },
+			{ SectionId::Materials, sizeof(Material), false, true },
+			{ SectionId::PointLights, sizeof(PointLight), false, false },
+			{ SectionId::SpotLights, sizeof(SpotLight), false, false },
+		};
+
+		/** Array of the section in the scene and its count, or null for a section this version does not know */
+		const void** GetSectionArray(SceneArrays& arrays, SectionId id, std::uint32_t*& count)
+		{
+			count = &arrays.entityCount;
+			switch (id)
+			{
+			case SectionId::Positions: return reinterpret_cast<const void**>(&arrays.positions);
+			case SectionId::Rotations: return reinterpret_cast<const void**>(&arrays.rotations);
+			case SectionId::Scales: return reinterpret_cast<const void**>(&arrays.scales);
+			case SectionId::MeshTypes: return reinterpret_cast<const void**>(&arrays.meshTypes);
+			case SectionId::MaterialIndices: return reinterpret_cast<const void**>(&arrays.materialIndices);
+			case SectionId::Flags: return reinterpret_cast<const void**>(&arrays.flags);
+			case SectionId::Materials:
+				count = &arrays.materialCount;
+				return reinterpret_cast<const void**>(&arrays.materials);
+			case SectionId::PointLights:
+				count = &arrays.pointLightCount;
+				return reinterpret_cast<const void**>(&arrays.pointLights);
+			case SectionId::SpotLights:
+				count = &arrays.spotLightCount;
+				return reinterpret_cast<const void**>(&arrays.spotLights);
+			}
+			return nullptr;
+		}
+
+		std::uint64_t AlignSection(std::uint64_t offset)
+		{
+			return (offset + SceneFile::SectionAlignment - 1) & ~static_cast<std::uint64_t>(SceneFile::SectionAlignment - 1);
+		}
+
+		bool IsFinite(const float* values, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (!std::isfinite(values[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	void SceneData::AddEntity(const Entity& entity, std::uint32_t materialIndex)
+	{
+		positions.push_back(entity.position);
+		rotations.push_back(entity.rotation);
+		scales.push_back(entity.scale);
+		meshTypes.push_back(static_cast<std::uint8_t>(entity.mesh));
+		materialIndices.push_back(materialIndex);
+		flags.push_back(entity.isStatic ? SceneEntityStatic : 0);
+	}
+
+	bool SceneData::Capture(const std::vector<std::shared_ptr<Entity>>& entities, const std::vector<std::shared_ptr<PointLight>>& pointLights,
+		const std::vector<std::shared_ptr<SpotLight>>& spotLights)
+	{
+		Clear();
+		std::unordered_map<const Material*, std::uint32_t> materialIndices;
+		for (const auto& entity : entities)
+		{
+			// The renderer cannot draw an entity without a material, so there is no way to store one. Scene files
+			// only name the built-in meshes
+			if (!entity->material || entity->mesh >= BuiltinMeshes::Count)
+			{
+				Clear();
+				return false;
+			}
+			auto result = materialIndices.emplace(entity->material.get(), static_cast<std::uint32_t>(materials.size()));
+			if (result.second)
+			{
+				materials.push_back(*entity->material);
+			}
+			AddEntity(*entity, result.first->second);
+		}
+		for (const auto& light : pointLights)
+		{
+			this->pointLights.push_back(*light);
+		}
+		for (const auto& light : spotLights)
+		{
+			this->spotLights.push_back(*light);
+		}
+		return true;
+	}
+
+	void SceneData::Clear()
+	{
+		*this = SceneData();
+	}
+
+	SceneArrays SceneData::GetArrays() const
+	{
+		SceneArrays arrays;
+		arrays.entityCount = static_cast<std::uint32_t>(positions.size());
+		arrays.positions = positions.data();
+		arrays.rotations = rotations.data();
+		arrays.scales = scales.data();
+		arrays.meshTypes = meshTypes.data();
+		arrays.materialIndices = materialIndices.data();
+		arrays.flags = flags.data();
+		arrays.materialCount = static_cast<std::uint32_t>(materials.size());
+		arrays.materials = materials.data();
+		arrays.pointLightCount = static_cast<std::uint32_t>(pointLights.size());
+		arrays.pointLights = pointLights.data();
+		arrays.spotLightCount = static_cast<std::uint32_t>(spotLights.size());
+		arrays.spotLights = spotLights.data();
+		return arrays;
+	}
+
+	SceneFile::SceneFile()
+	{
+
+	}
+
+	bool SceneFile::Open(const std::string& path, bool validate)
+	{
+		PROFILE_ZONE("SceneFile::Open");
+		Close();
+		if (!mFile.Open(path))
+		{
+			mError = "Could not open " + path;
+			return false;
+		}
+		if (!ReadLayout(mFile.GetData(), mFile.GetSize(), mArrays, mError) || (validate && !ValidateArrays(mArrays, mError)))
+		{
+			const std::string error = mError;
+			Close();
+			mError = error;
+			return false;
+		}
+		return true;
+	}
+
+	void SceneFile::Close()
+	{
+		mFile.Close();
+		mArrays = SceneArrays();
+		mError.clear();
+	}
+
+	bool SceneFile::IsOpen() const
+	{
+		return mFile.IsOpen();
+	}
+
+	const SceneArrays& SceneFile::GetArrays() const
+	{
+		return mArrays;
+	}
+
+	const std::string& SceneFile::GetError() const
+	{
+		return mError;
+	}
+
+	bool SceneFile::Save(const std::string& path, const SceneArrays& scene)
+	{
+		struct SectionData
+		{
+			SectionHeader header;
+			const void* data;
+		};
+
+		SceneArrays arrays = scene;
+		std::vector<SectionData> sections;
+		std::uint64_t offset = AlignSection(sizeof(SceneHeader) + sizeof(SectionHeader) * std::size(SectionLayouts));
+		for (const SectionLayout& layout : SectionLayouts)
+		{
+			std::uint32_t* count;
+			const void* data = *GetSectionArray(arrays, layout.id, count);
+			sections.push_back({ { static_cast<std::uint32_t>(layout.id), layout.elementSize, *count, offset }, data });
+			offset = AlignSection(offset + static_cast<std::uint64_t>(layout.elementSize) * *count);
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		SceneHeader header = {};
+		std::memcpy(header.magic, SceneMagic, sizeof(SceneMagic));
+		header.version = Version;
+		header.sectionCount = static_cast<std::uint32_t>(sections.size());
+		header.fileSize = offset;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const SectionData& section : sections)
+		{
+			file.write(reinterpret_cast<const char*>(&section.header), sizeof(section.header));
+		}
+
+		const char padding[SectionAlignment] = {};
+		std::uint64_t written = sizeof(SceneHeader) + sizeof(SectionHeader) * sections.size();
+		for (const SectionData& section : sections)
+		{
+			file.write(padding, static_cast<std::streamsize>(section.header.offset - written));
+			const std::uint64_t size = section.header.count * section.header.elementSize;
+			if (size > 0)
+			{
+				file.write(static_cast<const char*>(section.data), static_cast<std::streamsize>(size));
+			}
+			written = section.header.offset + size;
+		}
+		file.write(padding, static_cast<std::streamsize>(offset - written));
+		return static_cast<bool>(file);
+	}
+
+	bool SceneFile::Validate(const void* data, size_t size, std::string* error)
+	{
+		SceneArrays arrays;
+		std::string reason;
+		const bool valid = ReadLayout(static_cast<const std::uint8_t*>(data), size, arrays, reason) && ValidateArrays(arrays, reason);
+		if (error)
+		{
+			*error = reason;
+		}
+		return valid;
+	}
+
+	bool SceneFile::ReadLayout(const std::uint8_t* data, size_t size, SceneArrays& arrays, std::string& error)
+	{
+		arrays = SceneArrays();
+		SceneHeader header;
+		if (size < sizeof(header))
+		{
+			error = "File is too small for a scene";
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, SceneMagic, sizeof(SceneMagic)) != 0)
+		{
+			error = "Not a scene file";
+			return false;
+		}
+		if (header.version != Version)
+		{
+			error = "Scene file version " + std::to_string(header.version) + " is not supported";
+			return false;
+		}
+		if (header.fileSize != size)
+		{
+			error = "Scene file is " + std::to_string(size) + " bytes but should be " + std::to_string(header.fileSize);
+			return false;
+		}
+		if (header.sectionCount > (size - sizeof(header)) / sizeof(SectionHeader))
+		{
+			error = "Section table runs past the end of the file";
+			return false;
+		}
+
+		// The entity sections must agree on the count, which the first of them sets
+		bool entityCountSet = false;
+		std::uint32_t found = 0;
+		for (std::uint32_t i = 0; i < header.sectionCount; ++i)
+		{
+			SectionHeader section;
+			std::memcpy(&section, data + sizeof(header) + sizeof(SectionHeader) * i, sizeof(section));
+			auto layout = std::find_if(std::begin(SectionLayouts), std::end(SectionLayouts), [&](const SectionLayout& l) { return static_cast<std::uint32_t>(l.id) == section.id; });
+			if (layout == std::end(SectionLayouts))
+			{
+				continue;
+			}
+
+			const std::string name = "Section " + std::to_string(section.id);
+			const std::uint32_t bit = 1u << section.id;
+			if (found & bit)
+			{
+				error = name + " appears twice";
+				return false;
+			}
+			found |= bit;
+			if (section.elementSize != layout->elementSize)
+			{
+				error = name + " has " + std::to_string(section.elementSize) + " byte elements but this build uses " + std::to_string(layout->elementSize);
+				return false;
+			}
+			if (section.offset % SectionAlignment != 0 || section.offset > size || section.count > (size - section.offset) / section.elementSize)
+			{
+				error = name + " is misaligned or runs past the end of the file";
+				return false;
+			}
+			if (section.count > std::numeric_limits<std::uint32_t>::max())
+			{
+				error = name + " has too many elements";
+				return false;
+			}
+
+			std::uint32_t* count;
+			const void** array = GetSectionArray(arrays, layout->id, count);
+			const auto elementCount = static_cast<std::uint32_t>(section.count);
+			if (layout->perEntity && entityCountSet && *count != elementCount)
+			{
+				error = name + " has " + std::to_string(elementCount) + " entities but the sections before it have " + std::to_string(*count);
+				return false;
+			}
+			entityCountSet = entityCountSet || layout->perEntity;
+			*count = elementCount;
+			*array = data + section.offset;
+		}
+
+		for (const SectionLayout& layout : SectionLayouts)
+		{
+			if (layout.required && !(found & (1u << static_cast<std::uint32_t>(layout.id))))
+			{
+				error = "Section " + std::to_string(static_cast<std::uint32_t>(layout.id)) + " is missing";
+				arrays = SceneArrays();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SceneFile::ValidateArrays(const SceneArrays& arrays, std::string& error)
+	{
+		PROFILE_ZONE("SceneFile::ValidateArrays");
+		for (std::uint32_t i = 0; i < arrays.entityCount; ++i)
+		{
+			if (arrays.meshTypes[i] >= BuiltinMeshes::Count || arrays.materialIndices[i] >= arrays.materialCount ||
+				(arrays.flags[i] & ~SceneEntityKnownFlags) != 0)
+			{
+				error = "Entity " + std::to_string(i) + " has an unknown mesh type, material or flag";
+				return false;
+			}
+		}
+		// Transforms are checked as flat arrays of floats, which is as fast as reading them
+		if (!IsFinite(reinterpret_cast<const float*>(arrays.positions), arrays.entityCount * size_t(3)) ||
+			!IsFinite(reinterpret_cast<const float*>(arrays.rotations), arrays.entityCount * size_t(4)) ||
+			!IsFinite(reinterpret_cast<const float*>(arrays.scales), arrays.entityCount * size_t(3)))
+		{
+			error = "An entity has a transform that is not finite";
+			return false;
+		}
+		return true;
+	}
+}
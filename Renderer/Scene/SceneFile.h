@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Rendering/DataTypes.h"
+#include "Memory/MappedFile.h"
+
+namespace renderer
+{
+	/** Bits of an entity's flags in scene data */
+	enum SceneEntityFlags : std::uint8_t
+	{
+		SceneEntityStatic = 1 << 0,
+		SceneEntityKnownFlags = SceneEntityStatic
+	};
+
+	/**
+	 * A scene as one array per field. The arrays belong to whoever made the view, such as a SceneFile pointing
+	 * into its mapping or a SceneData.
+	 */
+	struct SceneArrays
+	{
+		// Entity i is made of element i of every entity array
+		std::uint32_t entityCount = 0;
+		const XMFLOAT3* positions = nullptr;
+		// Axis and angle in degrees, as in Entity
+		const XMFLOAT4* rotations = nullptr;
+		const XMFLOAT3* scales = nullptr;
+		const std::uint8_t* meshTypes = nullptr;
+		// Index into materials
+		const std::uint32_t* materialIndices = nullptr;
+		const std::uint8_t* flags = nullptr;
+
+		std::uint32_t materialCount = 0;
+		const Material* materials = nullptr;
+		std::uint32_t pointLightCount = 0;
+		const PointLight* pointLights = nullptr;
+		std::uint32_t spotLightCount = 0;
+		const SpotLight* spotLights = nullptr;
+	};
+
+	/** Scene arrays held in memory, for building a scene to save or importing one from text */
+	struct SceneData
+	{
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT4> rotations;
+		std::vector<XMFLOAT3> scales;
+		std::vector<std::uint8_t> meshTypes;
+		std::vector<std::uint32_t> materialIndices;
+		std::vector<std::uint8_t> flags;
+		std::vector<Material> materials;
+		std::vector<PointLight> pointLights;
+		std::vector<SpotLight> spotLights;
+
+		/** Appends the entity. Its material is given as an index into materials */
+		void AddEntity(const Entity& entity, std::uint32_t materialIndex);
+		/**
+		 * Copies renderer objects into arrays, numbering materials in the order they are first used. Fails if an
+		 * entity has no material, which the renderer needs to draw it, or uses a registered mesh, which scene
+		 * files have no geometry for
+		 */
+		bool Capture(const std::vector<std::shared_ptr<Entity>>& entities, const std::vector<std::shared_ptr<PointLight>>& pointLights,
+			const std::vector<std::shared_ptr<SpotLight>>& spotLights);
+		void Clear();
+		SceneArrays GetArrays() const;
+	};
+
+	/**
+	 * Binary scene file, mapped into memory so its arrays are used where they lie without parsing or copying.
+	 * Files are a header, a table of sections and then the sections, each an array aligned to SectionAlignment.
+	 * Values are stored as they are in memory, little endian. Sections this version does not know are skipped,
+	 * so later versions can add some without breaking older readers, and the version only changes when the
+	 * meaning of an existing section does.
+	 */
+	class SceneFile
+	{
+	public:
+		static constexpr std::uint32_t Version = 1;
+		static constexpr std::uint32_t SectionAlignment = 64;
+
+		SceneFile();
+
+		/**
+		 * Maps the file and points the arrays into it. Validating reads every entity once to check its values.
+		 * Without it only the layout is checked, which is for files that are trusted, such as ones validated once
+		 * when they were exported.
+		 */
+		bool Open(const std::string& path, bool validate = true);
+		void Close();
+		bool IsOpen() const;
+		/** Arrays of the open file. They point into the mapping so are only valid until it is closed */
+		const SceneArrays& GetArrays() const;
+		/** Why the last Open failed */
+		const std::string& GetError() const;
+
+		static bool Save(const std::string& path, const SceneArrays& scene);
+		/**
+		 * Checks a whole file in memory: the header and version, that every section is in bounds, aligned and the
+		 * size its element count says, and that every mesh type, material index and flag is in range and every
+		 * transform is finite. Gives the reason through error when it fails.
+		 */
+		static bool Validate(const void* data, size_t size, std::string* error = nullptr);
+
+	private:
+		/** Checks the header and sections and points the arrays at them */
+		static bool ReadLayout(const std::uint8_t* data, size_t size, SceneArrays& arrays, std::string& error);
+		static bool ValidateArrays(const SceneArrays& arrays, std::string& error);
+
+		MappedFile mFile;
+		SceneArrays mArrays;
+		std::string mError;
+	};
+}
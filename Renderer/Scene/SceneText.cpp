@@ -0,0 +1,243 @@
+#include "SceneText.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	namespace
+	{
+		const char* MeshNames[BuiltinMeshes::Count] = { "cone", "cube", "sphere" };
+
+		/** Reads the words and numbers of one line */
+		class LineReader
+		{
+		public:
+			LineReader(const char* begin, const char* end)
+				: mCurrent(begin), mEnd(end)
+			{
+
+			}
+
+			bool ReadWord(std::string& word)
+			{
+				SkipSpaces();
+				const char* start = mCurrent;
+				while (mCurrent < mEnd && *mCurrent != ' ' && *mCurrent != '\t' && *mCurrent != '\r')
+				{
+					++mCurrent;
+				}
+				word.assign(start, mCurrent);
+				return !word.empty();
+			}
+
+			bool ReadFloats(float* values, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					SkipSpaces();
+					char* next;
+					values[i] = std::strtof(mCurrent, &next);
+					if (next == mCurrent || next > mEnd)
+					{
+						return false;
+					}
+					mCurrent = next;
+				}
+				return true;
+			}
+
+			bool ReadUint(std::uint32_t& value)
+			{
+				SkipSpaces();
+				char* next;
+				const unsigned long parsed = std::strtoul(mCurrent, &next, 10);
+				if (next == mCurrent || next > mEnd || parsed > std::numeric_limits<std::uint32_t>::max())
+				{
+					return false;
+				}
+				value = static_cast<std::uint32_t>(parsed);
+				mCurrent = next;
+				return true;
+			}
+
+			bool AtEnd()
+			{
+				SkipSpaces();
+				return mCurrent >= mEnd;
+			}
+
+		private:
+			void SkipSpaces()
+			{
+				while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t' || *mCurrent == '\r'))
+				{
+					++mCurrent;
+				}
+			}
+
+			const char* mCurrent;
+			const char* mEnd;
+		};
+
+		template<typename T>
+		bool ReadFloats(LineReader& reader, T& value)
+		{
+			static_assert(sizeof(T) % sizeof(float) == 0, "Only structs of floats can be read");
+			return reader.ReadFloats(reinterpret_cast<float*>(&value), sizeof(T) / sizeof(float));
+		}
+
+		template<typename... T>
+		void WriteFloats(std::ostream& stream, const T&... values)
+		{
+			auto write = [&](const auto& value)
+			{
+				const float* floats = reinterpret_cast<const float*>(&value);
+				for (size_t i = 0; i < sizeof(value) / sizeof(float); ++i)
+				{
+					stream << ' ' << floats[i];
+				}
+			};
+			(write(values), ...);
+		}
+	}
+
+	bool SceneText::Import(const std::string& path, SceneData& scene, std::string* error)
+	{
+		PROFILE_ZONE("SceneText::Import");
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			if (error)
+			{
+				*error = "Could not open " + path;
+			}
+			return false;
+		}
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// Every line is ended with a null so numbers are never read from the next one
+		if (text.empty() || text.back() != '\n')
+		{
+			text.push_back('\n');
+		}
+
+		scene.Clear();
+		std::string kind;
+		std::string word;
+		size_t lineNumber = 0;
+		size_t lineStart = 0;
+		while (lineStart < text.size())
+		{
+			++lineNumber;
+			const size_t lineEnd = text.find('\n', lineStart);
+			text[lineEnd] = '\0';
+			LineReader reader(text.data() + lineStart, text.data() + lineEnd);
+			lineStart = lineEnd + 1;
+
+			bool valid = true;
+			if (!reader.ReadWord(kind) || kind[0] == '#')
+			{
+				continue;
+			}
+			else if (kind == "entity")
+			{
+				Entity entity;
+				std::uint32_t materialIndex = 0;
+				const auto mesh = reader.ReadWord(word) ? std::find(std::begin(MeshNames), std::end(MeshNames), word) : std::end(MeshNames);
+				valid = mesh != std::end(MeshNames) && reader.ReadUint(materialIndex) && ReadFloats(reader, entity.position) &&
+					ReadFloats(reader, entity.rotation) && ReadFloats(reader, entity.scale);
+				entity.mesh = static_cast<MeshHandle>(mesh - std::begin(MeshNames));
+				if (valid && !reader.AtEnd())
+				{
+					valid = reader.ReadWord(word) && word == "static" && reader.AtEnd();
+					entity.isStatic = valid;
+				}
+				scene.AddEntity(entity, materialIndex);
+			}
+			else if (kind == "material")
+			{
+				Material material;
+				valid = ReadFloats(reader, material.diffuse) && ReadFloats(reader, material.specular) && ReadFloats(reader, material.gloss) && reader.AtEnd();
+				scene.materials.push_back(material);
+			}
+			else if (kind == "pointlight")
+			{
+				PointLight light;
+				valid = ReadFloats(reader, light) && reader.AtEnd();
+				scene.pointLights.push_back(light);
+			}
+			else if (kind == "spotlight")
+			{
+				SpotLight light;
+				valid = ReadFloats(reader, light) && reader.AtEnd();
+				scene.spotLights.push_back(light);
+			}
+			else
+			{
+				valid = false;
+			}
+
+			if (!valid)
+			{
+				if (error)
+				{
+					*error = path + "(" + std::to_string(lineNumber) + "): could not read " + kind;
+				}
+				scene.Clear();
+				return false;
+			}
+		}
+
+		// Materials may come after the entities using them, so indices are checked at the end
+		for (size_t i = 0; i < scene.materialIndices.size(); ++i)
+		{
+			if (scene.materialIndices[i] >= scene.materials.size())
+			{
+				if (error)
+				{
+					*error = path + ": entity " + std::to_string(i) + " uses a material that is not in the file";
+				}
+				scene.Clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SceneText::Export(const std::string& path, const SceneArrays& scene)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+
+		// Nine digits are enough to read every float back exactly
+		file << std::setprecision(9);
+		file << "# Scene with " << scene.entityCount << " entities\n";
+		for (std::uint32_t i = 0; i < scene.materialCount; ++i)
+		{
+			file << "material";
+			WriteFloats(file, scene.materials[i]);
+			file << '\n';
+		}
+		for (std::uint32_t i = 0; i < scene.pointLightCount; ++i)
+		{
+			file << "pointlight";
+			WriteFloats(file, scene.pointLights[i]);
+			file << '\n';
+		}
+		for (std::uint32_t i = 0; i < scene.spotLightCount; ++i)
+		{
+			file << "spotlight";
+			WriteFloats(file, scene.spotLights[i]);
+			file << '\n';
+		}
+		for (std::uint32_t i = 0; i < scene.entityCount; ++i)
+		{
+			file << "entity " << MeshNames[std::min<std::uint32_t>(scene.meshTypes[i], BuiltinMeshes::Count - 1)] << ' ' << scene.materialIndices[i];
+			WriteFloats(file, scene.positions[i], scene.rotations[i], scene.scales[i]);
+			file << ((scene.flags[i] & SceneEntityStatic) ? " static\n" : "\n");
+		}
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "SceneFile.h"
+
+namespace renderer
+{
+	/**
+	 * Scenes as text, one item per line, for hand editing and for tools that cannot write the binary format.
+	 * Lines start with the kind of item and blank lines and lines starting with # are ignored:
+	 *   material <diffuse r g b a> <specular r g b> <gloss>
+	 *   pointlight <position> <range> <attenuation> <diffuse> <specular>
+	 *   spotlight <position> <range> <direction> <cone> <attenuation> <diffuse> <specular>
+	 *   entity <cone|cube|sphere> <material index> <position> <rotation axis and degrees> <scale> [static]
+	 * Every value has to be parsed, so loading is far slower than mapping a SceneFile.
+	 */
+	class SceneText
+	{
+	public:
+		/** Replaces the scene with the file. Gives the line that failed through error */
+		static bool Import(const std::string& path, SceneData& scene, std::string* error = nullptr);
+		static bool Export(const std::string& path, const SceneArrays& scene);
+	};
+}
@@ -0,0 +1,192 @@
+#include "WorldPartition.h"
+#include "Rendering/MeshRegistry.h"
+#include <filesystem>
+
+namespace renderer
+{
+	namespace
+	{
+		struct IndexHeader
+		{
+			char magic[4];
+			std::uint32_t version;
+			float cellSize;
+			std::uint32_t cellCount;
+		};
+
+		constexpr char IndexMagic[4] = { 'W', 'R', 'L', 'D' };
+		const char* IndexFileName = "world.index";
+		const char* WorldFileName = "world.scene";
+
+		static_assert(sizeof(WorldCell) == 36, "Index files store cells as they are in memory");
+	}
+
+	WorldPartition::WorldPartition()
+		: mCellSize(0)
+	{
+
+	}
+
+	bool WorldPartition::Build(const SceneArrays& scene, float cellSize, const std::string& directory)
+	{
+		if (cellSize <= 0)
+		{
+			return false;
+		}
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		// Entities are bucketed by cell first so each cell file is written in one go
+		std::unordered_map<std::uint64_t, std::uint32_t> cellIndices;
+		std::vector<WorldCell> cells;
+		std::vector<std::vector<std::uint32_t>> cellEntities;
+		for (std::uint32_t i = 0; i < scene.entityCount; ++i)
+		{
+			const XMFLOAT3& position = scene.positions[i];
+			const auto x = static_cast<std::int32_t>(std::floor(position.x / cellSize));
+			const auto z = static_cast<std::int32_t>(std::floor(position.z / cellSize));
+			auto result = cellIndices.emplace(GetCellKey(x, z), static_cast<std::uint32_t>(cells.size()));
+			if (result.second)
+			{
+				const float infinity = std::numeric_limits<float>::infinity();
+				cells.push_back({ x, z, 0, { infinity, infinity, infinity }, { -infinity, -infinity, -infinity } });
+				cellEntities.emplace_back();
+			}
+
+			// The bounds take in the sphere around the scaled mesh, like culling does
+			WorldCell& cell = cells[result.first->second];
+			const XMFLOAT3& scale = scene.scales[i];
+			const float radius = MeshRegistry::GetBuiltinBoundingRadius(scene.meshTypes[i]) *
+				std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+			XMStoreFloat3(&cell.boundsMin, XMVectorMin(XMLoadFloat3(&cell.boundsMin), XMVectorSubtract(XMLoadFloat3(&position), XMVectorReplicate(radius))));
+			XMStoreFloat3(&cell.boundsMax, XMVectorMax(XMLoadFloat3(&cell.boundsMax), XMVectorAdd(XMLoadFloat3(&position), XMVectorReplicate(radius))));
+			++cell.entityCount;
+			cellEntities[result.first->second].push_back(i);
+		}
+
+		// Every cell keeps the whole material table so material indices mean the same in all of them
+		WorldPartition partition;
+		partition.mDirectory = directory;
+		SceneData data;
+		for (size_t i = 0; i < cells.size(); ++i)
+		{
+			data.Clear();
+			data.materials.assign(scene.materials, scene.materials + scene.materialCount);
+			for (std::uint32_t entity : cellEntities[i])
+			{
+				data.positions.push_back(scene.positions[entity]);
+				data.rotations.push_back(scene.rotations[entity]);
+				data.scales.push_back(scene.scales[entity]);
+				data.meshTypes.push_back(scene.meshTypes[entity]);
+				data.materialIndices.push_back(scene.materialIndices[entity]);
+				data.flags.push_back(scene.flags[entity]);
+			}
+			if (!SceneFile::Save(partition.GetCellPath(cells[i]), data.GetArrays()))
+			{
+				return false;
+			}
+		}
+
+		// Lights are not streamed, so they go in the world file with the materials
+		data.Clear();
+		data.materials.assign(scene.materials, scene.materials + scene.materialCount);
+		data.pointLights.assign(scene.pointLights, scene.pointLights + scene.pointLightCount);
+		data.spotLights.assign(scene.spotLights, scene.spotLights + scene.spotLightCount);
+		if (!SceneFile::Save(partition.GetWorldPath(), data.GetArrays()))
+		{
+			return false;
+		}
+
+		std::ofstream file((std::filesystem::path(directory) / IndexFileName).string(), std::ios::binary);
+		IndexHeader header;
+		std::memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+		header.version = Version;
+		header.cellSize = cellSize;
+		header.cellCount = static_cast<std::uint32_t>(cells.size());
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(cells.data()), cells.size() * sizeof(WorldCell));
+		return static_cast<bool>(file);
+	}
+
+	bool WorldPartition::Open(const std::string& directory)
+	{
+		std::ifstream file((std::filesystem::path(directory) / IndexFileName).string(), std::ios::binary);
+		IndexHeader header;
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0 || header.version != Version || !(header.cellSize > 0))
+		{
+			return false;
+		}
+
+		std::vector<WorldCell> cells(header.cellCount);
+		if (!file.read(reinterpret_cast<char*>(cells.data()), cells.size() * sizeof(WorldCell)))
+		{
+			return false;
+		}
+
+		mDirectory = directory;
+		mCellSize = header.cellSize;
+		mCells = std::move(cells);
+		mCellIndices.clear();
+		for (std::uint32_t i = 0; i < mCells.size(); ++i)
+		{
+			mCellIndices[GetCellKey(mCells[i].x, mCells[i].z)] = i;
+		}
+		return true;
+	}
+
+	float WorldPartition::GetCellSize() const
+	{
+		return mCellSize;
+	}
+
+	const std::vector<WorldCell>& WorldPartition::GetCells() const
+	{
+		return mCells;
+	}
+
+	std::int32_t WorldPartition::FindCell(std::int32_t x, std::int32_t z) const
+	{
+		auto iter = mCellIndices.find(GetCellKey(x, z));
+		return iter == mCellIndices.end() ? -1 : static_cast<std::int32_t>(iter->second);
+	}
+
+	std::string WorldPartition::GetCellPath(const WorldCell& cell) const
+	{
+		const std::string name = "cell_" + std::to_string(cell.x) + "_" + std::to_string(cell.z) + ".scene";
+		return (std::filesystem::path(mDirectory) / name).string();
+	}
+
+	std::string WorldPartition::GetWorldPath() const
+	{
+		return (std::filesystem::path(mDirectory) / WorldFileName).string();
+	}
+
+	std::uint64_t WorldPartition::GetEntityCount() const
+	{
+		std::uint64_t count = 0;
+		for (const WorldCell& cell : mCells)
+		{
+			count += cell.entityCount;
+		}
+		return count;
+	}
+
+	void WorldPartition::GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const
+	{
+		XMVECTOR worldMin = XMVectorReplicate(mCells.empty() ? 0.0f : std::numeric_limits<float>::max());
+		XMVECTOR worldMax = XMVectorNegate(worldMin);
+		for (const WorldCell& cell : mCells)
+		{
+			worldMin = XMVectorMin(worldMin, XMLoadFloat3(&cell.boundsMin));
+			worldMax = XMVectorMax(worldMax, XMLoadFloat3(&cell.boundsMax));
+		}
+		XMStoreFloat3(&boundsMin, worldMin);
+		XMStoreFloat3(&boundsMax, worldMax);
+	}
+
+	std::uint64_t WorldPartition::GetCellKey(std::int32_t x, std::int32_t z)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(z);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SceneFile.h"
+
+namespace renderer
+{
+	/** A square of a partitioned world and the bounds of what is in it. Stored as is in index files */
+	struct WorldCell
+	{
+		// Position on the grid. The cell covers [x, x + 1) * cell size on the x axis and the same on z
+		std::int32_t x;
+		std::int32_t z;
+		std::uint32_t entityCount;
+		// Bounds of the entities in the cell, which can stick out of its square
+		XMFLOAT3 boundsMin;
+		XMFLOAT3 boundsMax;
+	};
+
+	/**
+	 * A world split into square cells on the ground plane, each saved as its own scene file so it can be loaded
+	 * and dropped independently. A directory holds the cells, a world scene file with the materials and lights
+	 * every cell shares, and an index of the cells and their bounds.
+	 */
+	class WorldPartition
+	{
+	public:
+		static constexpr std::uint32_t Version = 1;
+
+		WorldPartition();
+
+		/** Splits the scene and saves it into the directory, which is created if needed */
+		static bool Build(const SceneArrays& scene, float cellSize, const std::string& directory);
+
+		/** Reads the index of a world built into the directory */
+		bool Open(const std::string& directory);
+		float GetCellSize() const;
+		const std::vector<WorldCell>& GetCells() const;
+		/** Index of the cell at the grid position, or -1 if the world has nothing there */
+		std::int32_t FindCell(std::int32_t x, std::int32_t z) const;
+		std::string GetCellPath(const WorldCell& cell) const;
+		std::string GetWorldPath() const;
+		std::uint64_t GetEntityCount() const;
+		/** Bounds of every cell together */
+		void GetBounds(XMFLOAT3& boundsMin, XMFLOAT3& boundsMax) const;
+
+	private:
+		static std::uint64_t GetCellKey(std::int32_t x, std::int32_t z);
+
+		std::string mDirectory;
+		float mCellSize;
+		std::vector<WorldCell> mCells;
+		std::unordered_map<std::uint64_t, std::uint32_t> mCellIndices;
+	};
+}
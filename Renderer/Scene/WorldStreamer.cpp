@@ -0,0 +1,348 @@
+#include "WorldStreamer.h"
+#include "Profiling/Profiler.h"
+
+namespace renderer
+{
+	WorldStreamer::WorldStreamer(const WorldStreamingConfig& config)
+		: mConfig(config), mLastPosition(0, 0, 0), mVelocity(0, 0, 0), mHasPosition(false), mLoadingCell(-1), mLoadMilliseconds(0), mStopping(false)
+	{
+
+	}
+
+	WorldStreamer::~WorldStreamer()
+	{
+		Close();
+	}
+
+	bool WorldStreamer::Open(const std::string& directory)
+	{
+		Close();
+		SceneFile worldFile;
+		if (!mPartition.Open(directory) || !worldFile.Open(mPartition.GetWorldPath()))
+		{
+			mPartition = WorldPartition();
+			return false;
+		}
+		mWorldContent = SceneContent::Create(worldFile.GetArrays());
+		mCells.assign(mPartition.GetCells().size(), CellSlot());
+
+		if (!mConfig.synchronous)
+		{
+			mStopping = false;
+			mLoader = std::thread(&WorldStreamer::LoaderThread, this);
+		}
+		UpdateMemory();
+		return true;
+	}
+
+	void WorldStreamer::Close()
+	{
+		if (mLoader.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStopping = true;
+			}
+			mWake.notify_all();
+			mLoader.join();
+		}
+		mRequests.clear();
+		mCompleted.clear();
+		mLoadingCell = -1;
+		mLoadMilliseconds = 0;
+		std::vector<CellSlot>().swap(mCells);
+		std::vector<std::uint32_t>().swap(mActiveCells);
+		mWorldContent = SceneContent();
+		mHasPosition = false;
+		mVelocity = XMFLOAT3(0, 0, 0);
+		mStats = WorldStreamingStats();
+		UpdateMemory();
+	}
+
+	const WorldPartition& WorldStreamer::GetPartition() const
+	{
+		return mPartition;
+	}
+
+	const SceneContent& WorldStreamer::GetWorldContent() const
+	{
+		return mWorldContent;
+	}
+
+	void WorldStreamer::Update(const XMFLOAT3& position, double frameTime, std::vector<std::shared_ptr<Entity>>& added, std::vector<std::shared_ptr<Entity>>& removed)
+	{
+		PROFILE_ZONE("WorldStreamer::Update");
+		added.clear();
+		removed.clear();
+		mStats.entitiesAdded = 0;
+		mStats.entitiesRemoved = 0;
+		if (mCells.empty())
+		{
+			return;
+		}
+
+		// Velocity is smoothed over a few frames so one uneven frame does not throw the prefetch off
+		const XMVECTOR current = XMLoadFloat3(&position);
+		if (mHasPosition && frameTime > 0)
+		{
+			const XMVECTOR measured = XMVectorScale(XMVectorSubtract(current, XMLoadFloat3(&mLastPosition)), static_cast<float>(1.0 / frameTime));
+			XMStoreFloat3(&mVelocity, XMVectorLerp(XMLoadFloat3(&mVelocity), measured, 0.5f));
+		}
+		mLastPosition = position;
+		mHasPosition = true;
+		XMFLOAT3 ahead;
+		XMStoreFloat3(&ahead, XMVectorAdd(current, XMVectorScale(XMLoadFloat3(&mVelocity), mConfig.lookAheadSeconds)));
+
+		// Cells are wanted near the camera and anywhere along its path to where it is heading, which is covered by
+		// circles a load radius apart. Bounds can stick out of their square, so one more cell is looked at on each
+		// side of each circle
+		for (std::uint32_t cellIndex : mActiveCells)
+		{
+			mCells[cellIndex].wanted = false;
+		}
+		const auto& cells = mPartition.GetCells();
+		const float cellSize = mPartition.GetCellSize();
+		const float loadRadius = mConfig.loadRadius;
+		const float pathLength = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&ahead), current)));
+		const auto steps = static_cast<std::uint32_t>(std::ceil(pathLength / std::max(loadRadius, 1.0f)));
+		for (std::uint32_t step = 0; step <= steps; ++step)
+		{
+			XMFLOAT3 center;
+			XMStoreFloat3(&center, XMVectorLerp(current, XMLoadFloat3(&ahead), steps > 0 ? static_cast<float>(step) / steps : 0.0f));
+			const auto minX = static_cast<std::int32_t>(std::floor((center.x - loadRadius) / cellSize)) - 1;
+			const auto maxX = static_cast<std::int32_t>(std::floor((center.x + loadRadius) / cellSize)) + 1;
+			const auto minZ = static_cast<std::int32_t>(std::floor((center.z - loadRadius) / cellSize)) - 1;
+			const auto maxZ = static_cast<std::int32_t>(std::floor((center.z + loadRadius) / cellSize)) + 1;
+			for (std::int32_t z = minZ; z <= maxZ; ++z)
+			{
+				for (std::int32_t x = minX; x <= maxX; ++x)
+				{
+					const std::int32_t cellIndex = mPartition.FindCell(x, z);
+					if (cellIndex < 0 || mCells[cellIndex].wanted)
+					{
+						continue;
+					}
+					if (GetDistance(cells[cellIndex], center) > loadRadius)
+					{
+						continue;
+					}
+					CellSlot& slot = mCells[cellIndex];
+					if (!slot.active)
+					{
+						slot.active = true;
+						mActiveCells.push_back(static_cast<std::uint32_t>(cellIndex));
+					}
+					slot.wanted = true;
+					slot.distance = GetDistance(cells[cellIndex], position);
+				}
+			}
+		}
+
+		if (mConfig.synchronous)
+		{
+			// Everything wanted is loaded now, nearest first, which is what stalls the frame
+			std::sort(mActiveCells.begin(), mActiveCells.end(), [&](std::uint32_t a, std::uint32_t b) { return mCells[a].distance < mCells[b].distance; });
+			for (std::uint32_t cellIndex : mActiveCells)
+			{
+				if (mCells[cellIndex].wanted && mCells[cellIndex].state == CellState::Unloaded)
+				{
+					const std::uint64_t start = Profiler::Now();
+					bool failed;
+					SceneContent content = LoadCell(cellIndex, failed);
+					mStats.loadMilliseconds += (Profiler::Now() - start) / 1e6;
+					ReceiveCell(cellIndex, std::move(content), failed);
+				}
+			}
+		}
+		else
+		{
+			bool requested;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				// Finished cells are taken first so none of them is requested again
+				for (CompletedCell& cell : mCompleted)
+				{
+					ReceiveCell(cell.cellIndex, std::move(cell.content), cell.failed);
+				}
+				mCompleted.clear();
+				mStats.loadMilliseconds = mLoadMilliseconds;
+
+				// The queue is rebuilt from what is wanted now, dropping cells the camera has moved away from
+				mRequests.clear();
+				for (std::uint32_t cellIndex : mActiveCells)
+				{
+					CellSlot& slot = mCells[cellIndex];
+					const bool loading = mLoadingCell == static_cast<std::int64_t>(cellIndex);
+					if (slot.state == CellState::Requested && !slot.wanted && !loading)
+					{
+						slot.state = CellState::Unloaded;
+					}
+					else if (slot.wanted && (slot.state == CellState::Unloaded || (slot.state == CellState::Requested && !loading)))
+					{
+						slot.state = CellState::Requested;
+						mRequests.push_back(cellIndex);
+					}
+				}
+				std::sort(mRequests.begin(), mRequests.end(), [&](std::uint32_t a, std::uint32_t b) { return mCells[a].distance > mCells[b].distance; });
+				requested = !mRequests.empty();
+			}
+			if (requested)
+			{
+				mWake.notify_one();
+			}
+		}
+
+		// Nearest cells are given to the renderer first
+		std::uint32_t addBudget = mConfig.addBudget > 0 ? mConfig.addBudget : std::numeric_limits<std::uint32_t>::max();
+		std::sort(mActiveCells.begin(), mActiveCells.end(), [&](std::uint32_t a, std::uint32_t b) { return mCells[a].distance < mCells[b].distance; });
+		for (std::uint32_t cellIndex : mActiveCells)
+		{
+			CellSlot& slot = mCells[cellIndex];
+			const auto& entities = slot.content.entities;
+			if (addBudget == 0 || !slot.wanted || slot.state != CellState::Loaded || slot.committed == entities.size())
+			{
+				continue;
+			}
+			const std::uint32_t count = std::min(addBudget, static_cast<std::uint32_t>(entities.size()) - slot.committed);
+			added.insert(added.end(), entities.begin() + slot.committed, entities.begin() + slot.committed + count);
+			slot.committed += count;
+			addBudget -= count;
+		}
+
+		// Cells past the unload radius of the camera and of where it is heading are taken back, last added first
+		std::uint32_t removeBudget = mConfig.removeBudget > 0 ? mConfig.removeBudget : std::numeric_limits<std::uint32_t>::max();
+		for (std::uint32_t cellIndex : mActiveCells)
+		{
+			CellSlot& slot = mCells[cellIndex];
+			if (slot.wanted || slot.state != CellState::Loaded ||
+				std::min(GetDistance(cells[cellIndex], position), GetDistance(cells[cellIndex], ahead)) <= mConfig.unloadRadius)
+			{
+				continue;
+			}
+			const std::uint32_t count = std::min(removeBudget, slot.committed);
+			const auto& entities = slot.content.entities;
+			removed.insert(removed.end(), entities.begin() + (slot.committed - count), entities.begin() + slot.committed);
+			slot.committed -= count;
+			removeBudget -= count;
+			if (slot.committed == 0)
+			{
+				slot.content = SceneContent();
+				slot.state = CellState::Unloaded;
+				++mStats.cellsEvicted;
+			}
+		}
+
+		mStats.cellsResident = 0;
+		mStats.cellsPending = 0;
+		mStats.cellsMissing = 0;
+		mActiveCells.erase(std::remove_if(mActiveCells.begin(), mActiveCells.end(), [&](std::uint32_t cellIndex)
+		{
+			CellSlot& slot = mCells[cellIndex];
+			const bool resident = slot.state == CellState::Loaded && slot.committed == slot.content.entities.size();
+			mStats.cellsResident += resident ? 1 : 0;
+			mStats.cellsPending += slot.wanted && !resident ? 1 : 0;
+			mStats.cellsMissing += !resident && GetDistance(cells[cellIndex], position) <= loadRadius ? 1 : 0;
+			slot.active = slot.wanted || slot.state != CellState::Unloaded;
+			return !slot.active;
+		}), mActiveCells.end());
+
+		mStats.entitiesAdded = static_cast<std::uint32_t>(added.size());
+		mStats.entitiesRemoved = static_cast<std::uint32_t>(removed.size());
+		mStats.entitiesResident += added.size();
+		mStats.entitiesResident -= removed.size();
+		UpdateMemory();
+	}
+
+	void WorldStreamer::Preload(const XMFLOAT3& position, std::vector<std::shared_ptr<Entity>>& added)
+	{
+		// Nothing has been requested yet, so loading like a synchronous streamer without budgets gets everything
+		const WorldStreamingConfig config = mConfig;
+		mConfig.synchronous = true;
+		mConfig.addBudget = 0;
+		mConfig.removeBudget = 0;
+		std::vector<std::shared_ptr<Entity>> removed;
+		Update(position, 0, added, removed);
+		mConfig = config;
+	}
+
+	const WorldStreamingStats& WorldStreamer::GetStats() const
+	{
+		return mStats;
+	}
+
+	void WorldStreamer::LoaderThread()
+	{
+		Profiler::SetThreadName("World loader");
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (;;)
+		{
+			mWake.wait(lock, [&]() { return mStopping || !mRequests.empty(); });
+			if (mStopping)
+			{
+				return;
+			}
+			const std::uint32_t cellIndex = mRequests.back();
+			mRequests.pop_back();
+			mLoadingCell = cellIndex;
+			lock.unlock();
+
+			// The partition and world materials do not change while the thread runs, so need no lock
+			const std::uint64_t start = Profiler::Now();
+			bool failed;
+			SceneContent content = LoadCell(cellIndex, failed);
+			const double milliseconds = (Profiler::Now() - start) / 1e6;
+
+			lock.lock();
+			mCompleted.push_back({ cellIndex, std::move(content), failed });
+			mLoadingCell = -1;
+			mLoadMilliseconds += milliseconds;
+		}
+	}
+
+	SceneContent WorldStreamer::LoadCell(std::uint32_t cellIndex, bool& failed)
+	{
+		PROFILE_ZONE("WorldStreamer::LoadCell");
+		// Cells share the world's materials, so their indices have to be in its table
+		SceneFile file;
+		const SceneArrays& arrays = file.GetArrays();
+		failed = !file.Open(mPartition.GetCellPath(mPartition.GetCells()[cellIndex])) || arrays.materialCount > mWorldContent.materials.size();
+		return failed ? SceneContent() : SceneContent::Create(arrays, mWorldContent.materials);
+	}
+
+	void WorldStreamer::ReceiveCell(std::uint32_t cellIndex, SceneContent&& content, bool failed)
+	{
+		// A cell the camera left while it loaded is dropped. A cell that failed stays loaded and empty so it is
+		// not retried every frame
+		CellSlot& slot = mCells[cellIndex];
+		++mStats.cellsLoaded;
+		mStats.cellsFailed += failed ? 1 : 0;
+		if (!slot.wanted)
+		{
+			slot.state = CellState::Unloaded;
+			return;
+		}
+		slot.state = CellState::Loaded;
+		slot.content = std::move(content);
+		slot.committed = 0;
+	}
+
+	float WorldStreamer::GetDistance(const WorldCell& cell, const XMFLOAT3& position) const
+	{
+		// Distance to the nearest point of the cell's bounds, zero inside them
+		const XMVECTOR point = XMLoadFloat3(&position);
+		const XMVECTOR nearest = XMVectorClamp(point, XMLoadFloat3(&cell.boundsMin), XMLoadFloat3(&cell.boundsMax));
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(point, nearest)));
+	}
+
+	void WorldStreamer::UpdateMemory()
+	{
+		std::uint64_t bytes = GetCapacityBytes(mCells) + GetCapacityBytes(mActiveCells);
+		for (std::uint32_t cellIndex : mActiveCells)
+		{
+			// Entities given to the renderer are counted by it
+			const CellSlot& slot = mCells[cellIndex];
+			bytes += GetCapacityBytes(slot.content.entities) + sizeof(Entity) * (slot.content.entities.size() - slot.committed);
+		}
+		mMemory.Set(bytes);
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "WorldPartition.h"
+#include "SceneContent.h"
+#include "Memory/MemoryTracker.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace renderer
+{
+	struct WorldStreamingConfig
+	{
+		// Cells whose bounds come this close to the camera, or to where it is heading, are loaded
+		float loadRadius = 150.0f;
+		// Cells are evicted once further than this from both, which is more than the load radius so a camera on
+		// the edge of a cell does not load and evict it over and over
+		float unloadRadius = 200.0f;
+		// How far ahead to prefetch, in seconds of the camera's current velocity
+		float lookAheadSeconds = 1.0f;
+		// Most entities given to and taken from the renderer per update. Zero is no limit
+		std::uint32_t addBudget = 20000;
+		std::uint32_t removeBudget = 20000;
+		// Loads cells inside Update rather than on the loader thread, for comparing against
+		bool synchronous = false;
+	};
+
+	struct WorldStreamingStats
+	{
+		// Cells wholly given to the renderer, and cells requested but not there yet
+		std::uint32_t cellsResident = 0;
+		std::uint32_t cellsPending = 0;
+		// Cells within the load radius of the camera that were not resident, which shows up as pop in
+		std::uint32_t cellsMissing = 0;
+		std::uint64_t entitiesResident = 0;
+		// Entities given to and taken from the renderer by the last update
+		std::uint32_t entitiesAdded = 0;
+		std::uint32_t entitiesRemoved = 0;
+		// Totals since the world was opened
+		std::uint64_t cellsLoaded = 0;
+		std::uint64_t cellsEvicted = 0;
+		std::uint64_t cellsFailed = 0;
+		double loadMilliseconds = 0;
+	};
+
+	/**
+	 * Keeps the part of a partitioned world around the camera in the renderer. Cells near the camera, or near
+	 * where its velocity will take it, are loaded nearest first on a background thread. Loaded cells are handed
+	 * to the renderer, and far ones taken back, a budgeted number of entities per frame so that a burst of cells
+	 * arriving together is spread over several frames rather than stalling one.
+	 */
+	class WorldStreamer
+	{
+	public:
+		explicit WorldStreamer(const WorldStreamingConfig& config = WorldStreamingConfig());
+		~WorldStreamer();
+		WorldStreamer(const WorldStreamer&) = delete;
+		WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+		/** Opens a world built by WorldPartition::Build and starts the loader thread */
+		bool Open(const std::string& directory);
+		/** Stops loading. Entities already given to the renderer stay there */
+		void Close();
+		const WorldPartition& GetPartition() const;
+		/** Lights and materials of the whole world, which are not streamed */
+		const SceneContent& GetWorldContent() const;
+
+		/**
+		 * Call once per frame with the camera position. Requests the cells that are now needed and gives the
+		 * entities to add to the renderer and remove from it this frame, within the budgets
+		 */
+		void Update(const XMFLOAT3& position, double frameTime, std::vector<std::shared_ptr<Entity>>& added, std::vector<std::shared_ptr<Entity>>& removed);
+		/**
+		 * Loads every cell around the position at once and gives all their entities, as a loading screen would
+		 * before the first Update
+		 */
+		void Preload(const XMFLOAT3& position, std::vector<std::shared_ptr<Entity>>& added);
+		const WorldStreamingStats& GetStats() const;
+
+	private:
+		enum class CellState
+		{
+			Unloaded,
+			// Waiting for or being loaded by the loader thread
+			Requested,
+			// Loaded, with its first committed entities given to the renderer
+			Loaded
+		};
+
+		/** Streaming state of one cell of the partition */
+		struct CellSlot
+		{
+			CellState state = CellState::Unloaded;
+			// In mActiveCells
+			bool active = false;
+			bool wanted = false;
+			// Distance from the camera. Nearer cells load first
+			float distance = 0;
+			SceneContent content;
+			std::uint32_t committed = 0;
+		};
+
+		void LoaderThread();
+		SceneContent LoadCell(std::uint32_t cellIndex, bool& failed);
+		void ReceiveCell(std::uint32_t cellIndex, SceneContent&& content, bool failed);
+		float GetDistance(const WorldCell& cell, const XMFLOAT3& position) const;
+		void UpdateMemory();
+
+		WorldStreamingConfig mConfig;
+		WorldPartition mPartition;
+		SceneContent mWorldContent;
+		std::vector<CellSlot> mCells;
+		// Cells that are wanted or not yet unloaded, which are the only ones looked at each update
+		std::vector<std::uint32_t> mActiveCells;
+		XMFLOAT3 mLastPosition;
+		XMFLOAT3 mVelocity;
+		bool mHasPosition;
+		WorldStreamingStats mStats;
+		TrackedMemory mMemory = TrackedMemory(MemoryTag::Streaming);
+
+		// Shared with the loader thread. Requests are sorted so the nearest cell is at the back
+		std::thread mLoader;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::vector<std::uint32_t> mRequests;
+		std::int64_t mLoadingCell;
+		struct CompletedCell
+		{
+			std::uint32_t cellIndex;
+			SceneContent content;
+			bool failed;
+		};
+		std::vector<CompletedCell> mCompleted;
+		double mLoadMilliseconds;
+		bool mStopping;
+	};
+}
@@ -0,0 +1,167 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<std::uint64_t> allocationCount(0);
+	std::atomic<std::uint64_t> allocationBytes(0);
+
+	void* CountedAllocate(size_t size, size_t alignment)
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+		if (size == 0)
+		{
+			size = 1;
+		}
+#ifdef _WIN32
+		return alignment > alignof(std::max_align_t) ? _aligned_malloc(size, alignment) : std::malloc(size);
+#else
+		if (alignment > alignof(std::max_align_t))
+		{
+			void* pointer = nullptr;
+			return posix_memalign(&pointer, alignment, size) == 0 ? pointer : nullptr;
+		}
+		return std::malloc(size);
+#endif
+	}
+
+	void CountedFree(void* pointer, size_t alignment)
+	{
+#ifdef _WIN32
+		if (alignment > alignof(std::max_align_t))
+		{
+			_aligned_free(pointer);
+			return;
+		}
+#endif
+		std::free(pointer);
+	}
+
+	void* AllocateOrThrow(size_t size, size_t alignment)
+	{
+		void* pointer = CountedAllocate(size, alignment);
+		if (!pointer)
+		{
+			throw std::bad_alloc();
+		}
+		return pointer;
+	}
+}
+
+namespace stress
+{
+	std::uint64_t AllocationCounter::GetCount()
+	{
+		return allocationCount.load(std::memory_order_relaxed);
+	}
+
+	std::uint64_t AllocationCounter::GetBytes()
+	{
+		return allocationBytes.load(std::memory_order_relaxed);
+	}
+}
+
+// Replacements of every global allocation function. The aligned ones pair with the aligned deletes
+void* operator new(size_t size)
+{
+	return AllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size)
+{
+	return AllocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	CountedFree(pointer, alignof(std::max_align_t));
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	CountedFree(pointer, static_cast<size_t>(alignment));
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Minimal.h"
+
+namespace stress
+{
+	/**
+	 * Counts what the process takes from the heap. The stress test replaces the global operator new and delete
+	 * to count, so every container and make_shared is seen, whichever thread allocates.
+	 */
+	class AllocationCounter
+	{
+	public:
+		/** Calls to operator new since the process started */
+		static std::uint64_t GetCount();
+		/** Bytes requested from operator new since the process started */
+		static std::uint64_t GetBytes();
+	};
+}
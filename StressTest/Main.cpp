@@ -0,0 +1,395 @@
+// Headless stress test of the renderer's CPU side on generated scenes.
+// Usage: StressTest [options]
+//   --entities <n[,n...]>  entity counts to run, one run each. 50 by default
+//   --lights <n>           point lights. 10 by default
+//   --mix <cone:cube:sphere>  relative weights of the mesh types. 0:1:0 by default
+//   --materials <n>        distinct materials. 2 by default
+//   --sphere-segments <n>  draws spheres as a registered sphere of n segments, split into meshlets once it has at
+//                          least 1024 triangles. Scenes using it cannot be saved
+//   --animated <fraction>  fraction of entities moving every frame. 0 by default
+//   --static <fraction>    fraction of the entities that do not move marked static and batched. 0 by default
+//   --static-changes <n>   static entities marked changed every frame, rebuilding their batches. 0 by default
+//   --seed <n>             seed of the scene generator. 1 by default
+//   --scene <path>         renders a scene file instead of generating one. The entity count comes from the file
+//   --save-scene <path>    saves the scene of the last run as a scene file for later runs
+//   --world <dir>          streams a partitioned world in around the first view instead of generating a scene. The
+//                          entity count is of the whole world
+//   --save-world <dir>     saves the scene of the last run as a partitioned world for later runs
+//   --cell-size <n>        width of the cells of a saved world. 64 by default
+//   --stream-radius <n>    distance cells are loaded within. They are evicted beyond 4/3 of it. 150 by default
+//   --stream-budget <n>    most entities added to or removed from the renderer per frame, 0 for no limit. 20000 by default
+//   --stream-sync          loads cells on the render thread as they are needed, to compare against
+//   --frames <n>           timed frames. 300 by default
+//   --warmup <n>           frames rendered before timing. 10 by default
+//   --views <n>            split screen views. 1 by default
+//   --occlusion            turns on occlusion culling
+//   --pipelined            renders on a thread of its own from frame snapshots while the next frame is simulated.
+//                          Not with --world or --static-changes. Fails with exit code 1 if the renderer ends up
+//                          with other entities, or in other places, than the simulation gave it
+//   --churn <n>            entities added every frame and removed again 8 frames later. 0 by default
+//   --budget <tag:cpu|gpu=MB>  memory budget of a subsystem, such as Instances:gpu=64. Repeatable. Going over
+//                          one is reported and fails the run with exit code 1
+//   --check-allocations    fails with exit code 1 if any timed frame allocates from the heap. Buffers growing
+//                          past their largest size so far count, so warm up with the busiest views
+//   --camera <path>        replays a camera track instead of circling the scene. Sets the number of timed frames
+//   --timestep <seconds>   replays the track at a fixed step instead of its recorded frame times
+//   --record-camera <path> saves the camera of the timed frames as a track for later runs
+//   --reference <path>     ray traces the first view of the last frame on the CPU and saves it as a PPM golden image
+//   --json <path>          also saves the results as JSON for charting
+//   --trace <path>         saves the profiler zones of the last frames as a Chrome trace
+
+#include "StressDriver.h"
+#include "Profiling/Profiler.h"
+#include "Memory/MemoryTracker.h"
+#include "Scene/SceneFile.h"
+#include "Scene/WorldPartition.h"
+#include <atomic>
+
+using namespace stress;
+using renderer::MemoryTag;
+using renderer::MemoryDomain;
+using renderer::MemoryTracker;
+
+namespace
+{
+	std::vector<size_t> ParseCounts(const std::string& text)
+	{
+		std::vector<size_t> counts;
+		std::stringstream stream(text);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			counts.push_back(static_cast<size_t>(std::strtoull(item.c_str(), nullptr, 10)));
+		}
+		return counts;
+	}
+
+	bool ParseMix(const std::string& text, std::array<float, 3>& mix)
+	{
+		std::stringstream stream(text);
+		std::string item;
+		for (float& weight : mix)
+		{
+			if (!std::getline(stream, item, ':'))
+			{
+				return false;
+			}
+			weight = std::max(static_cast<float>(std::atof(item.c_str())), 0.0f);
+		}
+		return true;
+	}
+
+	bool ParseBudget(const std::string& text)
+	{
+		const size_t colon = text.find(':');
+		const size_t equals = text.find('=', colon);
+		if (colon == std::string::npos || equals == std::string::npos)
+		{
+			return false;
+		}
+		const std::string tagName = text.substr(0, colon);
+		const std::string domainName = text.substr(colon + 1, equals - colon - 1);
+		const double megabytes = std::atof(text.c_str() + equals + 1);
+
+		MemoryDomain domain;
+		if (domainName == "cpu")
+		{
+			domain = MemoryDomain::Cpu;
+		}
+		else if (domainName == "gpu")
+		{
+			domain = MemoryDomain::Gpu;
+		}
+		else
+		{
+			return false;
+		}
+
+		for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+		{
+			if (tagName == MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)))
+			{
+				MemoryTracker::Get().SetBudget(static_cast<MemoryTag>(tag), domain, static_cast<std::uint64_t>(megabytes * 1024 * 1024));
+				return megabytes > 0;
+			}
+		}
+		return false;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	StressConfig config;
+	std::vector<size_t> entityCounts = { config.entityCount };
+	std::string jsonPath;
+	std::string tracePath;
+	std::string recordCameraPath;
+	bool checkAllocations = false;
+	std::atomic<std::uint32_t> budgetsExceeded(0);
+	MemoryTracker::Get().SetBudgetCallback([&](MemoryTag tag, MemoryDomain domain, const renderer::MemoryUsage& usage)
+	{
+		budgetsExceeded.fetch_add(1, std::memory_order_relaxed);
+		std::cerr << "Memory budget exceeded: " << MemoryTracker::GetTagName(tag) << " " << MemoryTracker::GetDomainName(domain)
+			<< " " << usage.current << " bytes of " << usage.budget << "\n";
+	});
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--occlusion")
+		{
+			config.occlusionCulling = true;
+		}
+		else if (arg == "--check-allocations")
+		{
+			checkAllocations = true;
+		}
+		else if (arg == "--stream-sync")
+		{
+			config.streaming.synchronous = true;
+		}
+		else if (arg == "--pipelined")
+		{
+			config.pipelined = true;
+		}
+		else if (!hasValue)
+		{
+			std::cerr << "Unknown or incomplete option " << arg << "\n";
+			return 2;
+		}
+		else if (arg == "--entities")
+		{
+			entityCounts = ParseCounts(argv[++i]);
+		}
+		else if (arg == "--lights")
+		{
+			config.lightCount = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--mix")
+		{
+			if (!ParseMix(argv[++i], config.meshMix))
+			{
+				std::cerr << "Mesh mix should look like 1:2:1\n";
+				return 2;
+			}
+		}
+		else if (arg == "--sphere-segments")
+		{
+			config.sphereSegments = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--materials")
+		{
+			config.materialCount = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--animated")
+		{
+			config.animatedFraction = static_cast<float>(std::atof(argv[++i]));
+		}
+		else if (arg == "--static")
+		{
+			config.staticFraction = static_cast<float>(std::atof(argv[++i]));
+		}
+		else if (arg == "--static-changes")
+		{
+			config.staticChangesPerFrame = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--seed")
+		{
+			config.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--scene")
+		{
+			config.scenePath = argv[++i];
+		}
+		else if (arg == "--save-scene")
+		{
+			config.saveScenePath = argv[++i];
+		}
+		else if (arg == "--world")
+		{
+			config.worldPath = argv[++i];
+		}
+		else if (arg == "--save-world")
+		{
+			config.saveWorldPath = argv[++i];
+		}
+		else if (arg == "--cell-size")
+		{
+			config.cellSize = static_cast<float>(std::atof(argv[++i]));
+			if (!(config.cellSize > 0))
+			{
+				std::cerr << "Cell size should be more than 0\n";
+				return 2;
+			}
+		}
+		else if (arg == "--stream-radius")
+		{
+			config.streaming.loadRadius = std::max(static_cast<float>(std::atof(argv[++i])), 0.0f);
+			config.streaming.unloadRadius = config.streaming.loadRadius * 4.0f / 3.0f;
+		}
+		else if (arg == "--stream-budget")
+		{
+			config.streaming.addBudget = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			config.streaming.removeBudget = config.streaming.addBudget;
+		}
+		else if (arg == "--churn")
+		{
+			config.churnPerFrame = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--frames")
+		{
+			config.frameCount = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--warmup")
+		{
+			config.warmupFrames = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--views")
+		{
+			config.viewCount = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else if (arg == "--camera")
+		{
+			auto track = std::make_shared<renderer::CameraTrack>();
+			if (!track->Load(argv[++i]) || track->GetSamples().empty())
+			{
+				std::cerr << "Could not read camera track " << argv[i] << "\n";
+				return 2;
+			}
+			config.cameraTrack = track;
+		}
+		else if (arg == "--timestep")
+		{
+			config.cameraTimeStep = std::atof(argv[++i]);
+		}
+		else if (arg == "--record-camera")
+		{
+			recordCameraPath = argv[++i];
+		}
+		else if (arg == "--budget")
+		{
+			if (!ParseBudget(argv[++i]))
+			{
+				std::cerr << "Budgets should look like Instances:gpu=64\n";
+				return 2;
+			}
+		}
+		else if (arg == "--reference")
+		{
+			config.referencePath = argv[++i];
+		}
+		else if (arg == "--json")
+		{
+			jsonPath = argv[++i];
+		}
+		else if (arg == "--trace")
+		{
+			tracePath = argv[++i];
+		}
+		else
+		{
+			std::cerr << "Unknown option " << arg << "\n";
+			return 2;
+		}
+	}
+
+	if (config.pipelined && (!config.worldPath.empty() || config.staticChangesPerFrame > 0))
+	{
+		std::cerr << "--pipelined cannot stream a world or change static entities\n";
+		return 2;
+	}
+
+	if (!config.scenePath.empty())
+	{
+		// Checked once here so a bad file fails before any run, and its size replaces the entity counts
+		renderer::SceneFile sceneFile;
+		if (!sceneFile.Open(config.scenePath))
+		{
+			std::cerr << sceneFile.GetError() << "\n";
+			return 2;
+		}
+		entityCounts = { sceneFile.GetArrays().entityCount };
+	}
+	if (!config.worldPath.empty())
+	{
+		// Only the index is read here. Cells that fail to load later are counted in the results
+		renderer::WorldPartition partition;
+		if (!partition.Open(config.worldPath))
+		{
+			std::cerr << "Could not read the world in " << config.worldPath << "\n";
+			return 2;
+		}
+		entityCounts = { static_cast<size_t>(partition.GetEntityCount()) };
+	}
+
+	std::vector<StressResult> results;
+	for (size_t entityCount : entityCounts)
+	{
+		config.entityCount = entityCount;
+		// Only the last run is saved when several are made, which is the same path for every scale
+		if (!recordCameraPath.empty())
+		{
+			config.cameraRecording = std::make_shared<renderer::CameraTrack>();
+		}
+		results.push_back(StressDriver::Run(config));
+		StressDriver::Print(results.back(), std::cout);
+		std::cout << "\n";
+	}
+
+	if (results.size() > 1)
+	{
+		StressDriver::PrintTable(results, std::cout);
+	}
+
+	if (config.cameraRecording && !config.cameraRecording->Save(recordCameraPath))
+	{
+		std::cerr << "Could not write " << recordCameraPath << "\n";
+		return 2;
+	}
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream file(jsonPath);
+		StressDriver::WriteJson(results, file);
+		if (!file)
+		{
+			std::cerr << "Could not write " << jsonPath << "\n";
+			return 2;
+		}
+	}
+
+	if (!tracePath.empty() && !renderer::Profiler::SaveChromeTrace(renderer::Profiler::Capture(), tracePath))
+	{
+		std::cerr << "Could not write " << tracePath << "\n";
+		return 2;
+	}
+
+	if (budgetsExceeded.load() > 0)
+	{
+		std::cerr << budgetsExceeded.load() << " memory budget(s) exceeded\n";
+		return 1;
+	}
+
+	for (const auto& result : results)
+	{
+		if (result.entityCountError != 0 || result.framesInconsistent > 0 || result.transformsWrong > 0)
+		{
+			std::cerr << result.config.entityCount << " entities: the renderer did not end up with the simulation's entities\n";
+			return 1;
+		}
+	}
+
+	if (checkAllocations)
+	{
+		for (const auto& result : results)
+		{
+			if (result.maxFrameAllocations > 0)
+			{
+				std::cerr << result.config.entityCount << " entities: timed frames allocated from the heap, up to "
+					<< result.maxFrameAllocations << " times in a frame\n";
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
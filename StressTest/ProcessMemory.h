@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Minimal.h"
+
+namespace stress
+{
+	/** Memory the operating system has given the process. Zero when the platform cannot tell */
+	class ProcessMemory
+	{
+	public:
+		/** Resident memory right now */
+		static std::uint64_t GetCurrentBytes();
+		/** Most resident memory since the process started */
+		static std::uint64_t GetPeakBytes();
+	};
+}
@@ -0,0 +1,731 @@
+#include "StressDriver.h"
+#include "Rendering/Renderer.h"
+#include "Rendering/RecordingBackend.h"
+#include "Rendering/MeshRegistry.h"
+#include "Camera/Camera.h"
+#include "AllocationCounter.h"
+#include "ProcessMemory.h"
+#include "Rendering/ReferenceTracer.h"
+#include "Scene/FramePipeline.h"
+#include "Profiling/Profiler.h"
+#include <chrono>
+#include <deque>
+#include <thread>
+
+using namespace renderer;
+
+namespace stress
+{
+	namespace
+	{
+		const char* MeshNames[3] = { "cone", "cube", "sphere" };
+
+		double ToMegabytes(std::uint64_t bytes)
+		{
+			return bytes / (1024.0 * 1024.0);
+		}
+	}
+
+	StressResult StressDriver::Run(const StressConfig& config)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		StressResult result;
+		result.config = config;
+
+		MemoryTracker& memoryTracker = MemoryTracker::Get();
+		memoryTracker.ResetPeaks();
+		const std::uint64_t trackedBefore = memoryTracker.GetTotal(MemoryDomain::Cpu) + memoryTracker.GetTotal(MemoryDomain::Gpu);
+
+		auto setupStart = Clock::now();
+		StressScene scene(config);
+		// The real renderer, drawing through a backend that keeps buffers in memory and records calls instead of
+		// talking to a device
+		RecordingBackend* backend = new RecordingBackend();
+		GraphicsConfig graphicsConfig;
+		graphicsConfig.screenWidth = 1280;
+		graphicsConfig.screenHeight = 720;
+		std::unique_ptr<Renderer> renderer(Renderer::Initialize(backend, graphicsConfig));
+		renderer->SetOcclusionCullingEnabled(config.occlusionCulling);
+		// Lights given to the renderer, for the reference image
+		std::vector<std::shared_ptr<PointLight>> pointLights;
+		// Pipelined, the renderer holds the pipeline's copies of the entities and lights rather than the scene's
+		FramePipeline pipeline;
+		for (const auto& light : scene.GetPointLights())
+		{
+			if (config.pipelined)
+			{
+				pipeline.AddPointLight(*light);
+			}
+			else
+			{
+				renderer->AddPointLight(light);
+				pointLights.push_back(light);
+			}
+		}
+		MeshHandle sphere = InvalidMesh;
+		if (config.sphereSegments > 0)
+		{
+			std::vector<Vertex> vertices;
+			std::vector<std::uint32_t> indices;
+			StressScene::CreateSphere(config.sphereSegments, vertices, indices);
+			sphere = renderer->GetMeshRegistry().Register(std::move(vertices), std::move(indices));
+			for (const auto& entity : scene.GetEntities())
+			{
+				entity->mesh = entity->mesh == BuiltinMeshes::Sphere && sphere != InvalidMesh ? sphere : entity->mesh;
+			}
+		}
+		if (config.pipelined)
+		{
+			// Set up as the first frame, taken here before the render thread starts. Entity ids are their indices
+			for (const auto& entity : scene.GetEntities())
+			{
+				pipeline.AddEntity(*entity);
+			}
+			pipeline.Publish(0);
+			pipeline.Acquire();
+			const FrameChanges& changes = pipeline.GetChanges();
+			for (const auto& light : changes.addedPointLights)
+			{
+				renderer->AddPointLight(light);
+				pointLights.push_back(light);
+			}
+			renderer->AddEntities(changes.added);
+		}
+		else
+		{
+			renderer->AddEntities(scene.GetEntities());
+		}
+		// The entities hold the sphere from here on
+		renderer->GetMeshRegistry().Release(sphere);
+		result.setupSeconds = std::chrono::duration<double>(Clock::now() - setupStart).count();
+		if (!config.saveScenePath.empty() && !scene.Save(config.saveScenePath))
+		{
+			std::cerr << "Could not write " << config.saveScenePath << "\n";
+		}
+		if (!config.saveWorldPath.empty() && !scene.SaveWorld(config.saveWorldPath, config.cellSize))
+		{
+			std::cerr << "Could not write the world in " << config.saveWorldPath << "\n";
+		}
+		result.sceneBytes = ProcessMemory::GetCurrentBytes();
+
+		// Split screen views side by side, all the same size as a 1280x720 screen
+		const std::uint32_t viewCount = std::max(1u, std::min(config.viewCount, 32u));
+		const float viewWidth = 1280.0f / viewCount;
+		std::vector<std::unique_ptr<Camera>> cameras;
+		std::vector<RenderView> views;
+		for (std::uint32_t i = 0; i < viewCount; ++i)
+		{
+			cameras.push_back(std::make_unique<Camera>(XMFLOAT3(0, 2, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, 2, 1), 0.4f * Math::Pi, viewWidth, 720.0f, 0.1f, 1000.0f));
+			RenderView view;
+			view.camera = cameras.back().get();
+			view.viewport = { viewWidth * i, 0, viewWidth, 720.0f };
+			views.push_back(view);
+		}
+		// The views replace the renderer's own camera
+		auto setViews = [&](const std::vector<RenderView>& renderViews)
+		{
+			renderer->ClearViews();
+			for (const RenderView& view : renderViews)
+			{
+				renderer->AddView(view);
+			}
+		};
+
+		// Simulated time advances at a fixed 60Hz, or as the camera track says, so every run animates the same way
+		// however fast it is
+		const double scriptedTimeStep = 1.0 / 60.0;
+		const std::uint32_t totalFrames = config.warmupFrames + config.frameCount;
+		const CameraTrack* track = config.cameraTrack.get();
+		CameraTrackPlayer player;
+		double time = 0;
+		std::vector<double> frameTimes;
+		frameTimes.reserve(config.frameCount);
+		std::vector<double> latencies;
+		latencies.reserve(config.frameCount);
+		std::uint64_t simulationNanoseconds = 0;
+		std::uint64_t renderNanoseconds = 0;
+		RenderStats totals;
+		std::uint64_t totalAllocations = 0;
+		WorldStreamer* streamer = scene.GetStreamer();
+		std::vector<std::shared_ptr<Entity>> streamedIn;
+		std::vector<std::shared_ptr<Entity>> streamedOut;
+		std::uint64_t totalResident = 0;
+		std::vector<std::uint32_t> animated;
+		scene.GetAnimatedIndices(animated);
+		// Churned entities live this many frames, held as entities or as pipeline ids
+		const size_t churnFrames = 8;
+		std::deque<std::vector<std::shared_ptr<Entity>>> churned;
+		std::deque<std::vector<std::uint32_t>> churnedIds;
+		size_t nextChurned = 0;
+
+		auto countFrame = [&](const RenderStats& stats)
+		{
+			totals.drawCalls += stats.drawCalls;
+			totals.triangles += stats.triangles;
+			totals.entitiesVisible += stats.entitiesVisible;
+			totals.entitiesCulled += stats.entitiesCulled;
+			totals.entitiesOccluded += stats.entitiesOccluded;
+			totals.bytesUploaded += stats.bytesUploaded;
+			totals.stateBindsIssued += stats.stateBindsIssued;
+			totals.stateBindsFiltered += stats.stateBindsFiltered;
+			totals.staticChunksVisible += stats.staticChunksVisible;
+			totals.staticChunksRebuilt += stats.staticChunksRebuilt;
+			totals.meshletsTested += stats.meshletsTested;
+			totals.meshletsCulled += stats.meshletsCulled;
+			totals.meshletTrianglesCulled += stats.meshletTrianglesCulled;
+			totals.meshletCullNanoseconds += stats.meshletCullNanoseconds;
+		};
+
+		// Pipelined, the render thread draws with cameras of its own moved to each frame's poses, and times frames
+		// from one finishing to the next. The loop's frames start at the second, as the first was the setup
+		std::vector<std::unique_ptr<Camera>> renderCameras;
+		std::vector<RenderView> renderViews = views;
+		std::thread renderThread;
+		if (config.pipelined)
+		{
+			for (std::uint32_t i = 0; i < viewCount; ++i)
+			{
+				renderCameras.push_back(std::make_unique<Camera>(*cameras[i]));
+				renderViews[i].camera = renderCameras.back().get();
+			}
+			setViews(renderViews);
+			renderThread = std::thread([&]()
+			{
+				Profiler::SetThreadName("Render");
+				std::uint64_t lastEnd = Profiler::Now();
+				std::uint64_t lastAllocations = AllocationCounter::GetCount();
+				while (const FrameSnapshot* frame = pipeline.WaitForFrame())
+				{
+					const std::uint64_t renderStart = Profiler::Now();
+					const FrameChanges& changes = pipeline.GetChanges();
+					renderer->RemoveEntities(changes.removed);
+					renderer->AddEntities(changes.added);
+					for (std::uint32_t i = 0; i < viewCount; ++i)
+					{
+						pipeline.ApplyCamera(i, *renderCameras[i]);
+					}
+					result.framesInconsistent += pipeline.GetEntityCount() != frame->entityCount ? 1 : 0;
+					const RenderStats& stats = renderer->Render(frame->frameTime);
+					// Only what the last frame did is of interest, so the record does not grow
+					backend->Clear();
+					const std::uint64_t end = Profiler::Now();
+					const std::uint64_t allocations = AllocationCounter::GetCount();
+					if (frame->frameIndex >= config.warmupFrames + 2)
+					{
+						countFrame(stats);
+						frameTimes.push_back((end - lastEnd) / 1e6);
+						latencies.push_back((end - frame->beginTime) / 1e6);
+						renderNanoseconds += end - renderStart;
+						// Both threads, as the simulation allocating shows up in the frame too
+						totalAllocations += allocations - lastAllocations;
+						result.maxFrameAllocations = std::max(result.maxFrameAllocations, allocations - lastAllocations);
+					}
+					lastEnd = end;
+					lastAllocations = allocations;
+				}
+			});
+		}
+		else
+		{
+			setViews(views);
+		}
+		for (std::uint32_t frame = 0; track || frame < totalFrames; ++frame)
+		{
+			const bool timed = frame >= config.warmupFrames;
+			double frameTime = scriptedTimeStep;
+			if (track)
+			{
+				// Warmup plays the start of the track, then the timed frames play all of it
+				if (frame == 0 || frame == config.warmupFrames)
+				{
+					player.Start(track, config.cameraTimeStep);
+				}
+				if (!player.Advance(*cameras[0], frameTime))
+				{
+					if (timed)
+					{
+						break;
+					}
+					player.Start(track, config.cameraTimeStep);
+					player.Advance(*cameras[0], frameTime);
+				}
+				for (std::uint32_t i = 1; i < viewCount; ++i)
+				{
+					cameras[i]->SetPosition(cameras[0]->GetPosition());
+					cameras[i]->SetOrientation(cameras[0]->GetOrientation());
+					cameras[i]->SetYaw(Math::Pi * 2.0f * i / viewCount);
+				}
+			}
+			else
+			{
+				const double progress = totalFrames > 1 ? static_cast<double>(frame) / (totalFrames - 1) : 0.0;
+				for (std::uint32_t i = 0; i < viewCount; ++i)
+				{
+					scene.UpdateCamera(*cameras[i], i, viewCount, progress);
+				}
+			}
+			if (config.cameraRecording && timed)
+			{
+				config.cameraRecording->Record(*cameras[0], frameTime);
+			}
+			time += frameTime;
+
+			if (streamer && frame == 0)
+			{
+				// The cells around the start are loaded before the first frame, as behind a loading screen
+				streamer->Preload(cameras[0]->GetPosition(), streamedIn);
+				renderer->AddEntities(streamedIn);
+			}
+
+			const std::uint64_t allocationsBefore = AllocationCounter::GetCount();
+			auto frameStart = Clock::now();
+			const std::uint64_t simulationStart = Profiler::Now();
+			{
+				PROFILE_ZONE("StressDriver::Frame");
+				if (config.pipelined)
+				{
+					pipeline.BeginFrame();
+				}
+				if (streamer)
+				{
+					// Streaming is part of the frame, so cells loaded on this thread show in its time
+					streamer->Update(cameras[0]->GetPosition(), frameTime, streamedIn, streamedOut);
+					renderer->RemoveEntities(streamedOut);
+					renderer->AddEntities(streamedIn);
+					if (timed)
+					{
+						const WorldStreamingStats& streaming = streamer->GetStats();
+						totalResident += streaming.entitiesResident;
+						result.maxEntitiesResident = std::max(result.maxEntitiesResident, streaming.entitiesResident);
+						result.maxEntitiesAdded = std::max(result.maxEntitiesAdded, streaming.entitiesAdded);
+						result.maxEntitiesRemoved = std::max(result.maxEntitiesRemoved, streaming.entitiesRemoved);
+						result.framesMissingCells += streaming.cellsMissing > 0 ? 1 : 0;
+					}
+				}
+				scene.Animate(time);
+				// Spread over the static entities so each change usually lands in a different chunk
+				const auto& staticEntities = scene.GetStaticEntities();
+				for (std::uint32_t i = 0; i < config.staticChangesPerFrame && !staticEntities.empty(); ++i)
+				{
+					renderer->MarkStaticEntityChanged(staticEntities[(static_cast<size_t>(frame) * config.staticChangesPerFrame + i) * 7919 % staticEntities.size()]);
+				}
+				// Copies of scene entities floating above it, each removed again some frames later
+				const auto& entities = scene.GetEntities();
+				if (config.churnPerFrame > 0 && !entities.empty())
+				{
+					if (config.pipelined)
+					{
+						churnedIds.emplace_back();
+					}
+					else
+					{
+						churned.emplace_back();
+					}
+					for (std::uint32_t i = 0; i < config.churnPerFrame; ++i)
+					{
+						Entity entity = *entities[nextChurned++ % entities.size()];
+						entity.position.y += 4.0f;
+						entity.isStatic = false;
+						if (config.pipelined)
+						{
+							churnedIds.back().push_back(pipeline.AddEntity(entity));
+						}
+						else
+						{
+							churned.back().push_back(std::make_shared<Entity>(entity));
+						}
+					}
+					if (config.pipelined && churnedIds.size() > churnFrames)
+					{
+						for (std::uint32_t id : churnedIds.front())
+						{
+							pipeline.RemoveEntity(id);
+						}
+						churnedIds.pop_front();
+					}
+					if (!config.pipelined)
+					{
+						renderer->AddEntities(churned.back());
+						if (churned.size() > churnFrames)
+						{
+							renderer->RemoveEntities(churned.front());
+							churned.pop_front();
+						}
+					}
+					result.entitiesChurned += config.churnPerFrame;
+				}
+
+				if (config.pipelined)
+				{
+					for (std::uint32_t index : animated)
+					{
+						const Entity& entity = *entities[index];
+						pipeline.SetTransform(index, entity.position, entity.rotation, entity.scale);
+					}
+					for (std::uint32_t i = 0; i < viewCount; ++i)
+					{
+						pipeline.SetCamera(i, *cameras[i]);
+					}
+					const std::uint64_t frameIndex = pipeline.Publish(frameTime);
+					simulationNanoseconds += timed ? Profiler::Now() - simulationStart : 0;
+					// The next frame is written while this one renders, but the simulation gets no further ahead
+					pipeline.WaitForAcquired(frameIndex);
+				}
+				else
+				{
+					const std::uint64_t renderStart = Profiler::Now();
+					const RenderStats& stats = renderer->Render(frameTime);
+					backend->Clear();
+					if (timed)
+					{
+						countFrame(stats);
+						simulationNanoseconds += renderStart - simulationStart;
+						renderNanoseconds += Profiler::Now() - renderStart;
+					}
+				}
+			}
+			if (timed && !config.pipelined)
+			{
+				frameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+				latencies.push_back(frameTimes.back());
+				const std::uint64_t allocations = AllocationCounter::GetCount() - allocationsBefore;
+				totalAllocations += allocations;
+				result.maxFrameAllocations = std::max(result.maxFrameAllocations, allocations);
+			}
+		}
+		if (config.pipelined)
+		{
+			pipeline.Close();
+			renderThread.join();
+			result.framesSkipped = pipeline.GetStats().skipped;
+		}
+
+		// Everything the simulation has should be in the renderer, where it last put it
+		std::vector<const Entity*> rendered;
+		renderer->GetEntities(rendered);
+		size_t expected = scene.GetEntities().size();
+		for (const auto& ids : churnedIds)
+		{
+			expected += ids.size();
+		}
+		for (const auto& entities : churned)
+		{
+			expected += entities.size();
+		}
+		if (!streamer)
+		{
+			result.entityCountError = static_cast<std::int64_t>(rendered.size()) - static_cast<std::int64_t>(expected);
+		}
+		for (std::uint32_t index : animated)
+		{
+			const Entity& entity = *scene.GetEntities()[index];
+			const Entity* copy = config.pipelined ? pipeline.GetEntity(index).get() : &entity;
+			result.transformsWrong += !copy || std::memcmp(&copy->position, &entity.position, sizeof(entity.position)) != 0 ||
+				std::memcmp(&copy->rotation, &entity.rotation, sizeof(entity.rotation)) != 0 ? 1 : 0;
+		}
+
+		// A track decides how many frames were timed
+		result.config.frameCount = static_cast<std::uint32_t>(frameTimes.size());
+		result.frameTimes = Summarize(frameTimes);
+		result.latency = Summarize(latencies);
+		const double frameCount = std::max(result.config.frameCount, 1u);
+		// A streamed world only has part of its entities in the renderer at a time
+		result.entitiesResident = streamer ? totalResident / frameCount : static_cast<double>(config.entityCount);
+		if (result.frameTimes.mean > 0)
+		{
+			result.framesPerSecond = 1000.0 / result.frameTimes.mean;
+			result.entitiesPerSecond = result.entitiesResident * result.framesPerSecond;
+		}
+
+		result.drawCalls = totals.drawCalls / frameCount;
+		result.triangles = totals.triangles / frameCount;
+		result.entitiesVisible = totals.entitiesVisible / frameCount;
+		result.entitiesCulled = totals.entitiesCulled / frameCount;
+		result.entitiesOccluded = totals.entitiesOccluded / frameCount;
+		result.bytesUploaded = totals.bytesUploaded / frameCount;
+		result.stateBindsIssued = totals.stateBindsIssued / frameCount;
+		result.stateBindsFiltered = totals.stateBindsFiltered / frameCount;
+		result.staticChunksVisible = totals.staticChunksVisible / frameCount;
+		result.staticChunksRebuilt = totals.staticChunksRebuilt / frameCount;
+		result.meshletsTested = totals.meshletsTested / frameCount;
+		result.meshletsCulled = totals.meshletsCulled / frameCount;
+		result.meshletTrianglesCulled = totals.meshletTrianglesCulled / frameCount;
+		result.meshletCullMilliseconds = totals.meshletCullNanoseconds / 1e6 / frameCount;
+		result.simulationMilliseconds = simulationNanoseconds / 1e6 / frameCount;
+		result.renderMilliseconds = renderNanoseconds / 1e6 / frameCount;
+		result.staticBatches = renderer->GetStaticBatchStats();
+		result.frameAllocations = totalAllocations / frameCount;
+		result.frameArenaBytes = renderer->GetFrameArenaPeakUsed();
+		result.peakBytes = ProcessMemory::GetPeakBytes();
+		if (streamer)
+		{
+			result.streaming = streamer->GetStats();
+		}
+
+		if (!config.referencePath.empty())
+		{
+			// The renderer lights scenes with its default spot light, as none is added
+			std::vector<const Entity*> entities;
+			renderer->GetEntities(entities);
+			ReferenceTracer tracer;
+			tracer.SetLights(LightPacker::CreateDefaultSpotLight(), pointLights);
+			tracer.Build(entities, renderer->GetMeshRegistry());
+			Image image;
+			const Camera& camera = *cameras[0];
+			tracer.Render(camera, static_cast<std::uint32_t>(camera.GetWidth()), static_cast<std::uint32_t>(camera.GetHeight()), image);
+			if (!ImageFile::SavePpm(config.referencePath, image))
+			{
+				std::cerr << "Could not write " << config.referencePath << "\n";
+			}
+			result.referenceMilliseconds = tracer.GetStats().renderMilliseconds;
+		}
+
+		for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+		{
+			for (std::uint32_t domain = 0; domain < static_cast<std::uint32_t>(MemoryDomain::Count); ++domain)
+			{
+				result.trackedMemory[tag][domain] = memoryTracker.GetUsage(static_cast<MemoryTag>(tag), static_cast<MemoryDomain>(domain));
+			}
+		}
+		// Everything the renderer and streamer accounted for should be returned when they go
+		renderer.reset();
+		if (streamer)
+		{
+			streamer->Close();
+		}
+		const std::uint64_t trackedAfter = memoryTracker.GetTotal(MemoryDomain::Cpu) + memoryTracker.GetTotal(MemoryDomain::Gpu);
+		result.leakedBytes = static_cast<std::int64_t>(trackedAfter - trackedBefore);
+		return result;
+	}
+
+	FrameTimeSummary StressDriver::Summarize(std::vector<double>& milliseconds)
+	{
+		FrameTimeSummary summary;
+		if (milliseconds.empty())
+		{
+			return summary;
+		}
+
+		std::sort(milliseconds.begin(), milliseconds.end());
+		auto percentile = [&](double fraction)
+		{
+			size_t rank = static_cast<size_t>(std::ceil(fraction * milliseconds.size()));
+			return milliseconds[std::min(rank > 0 ? rank - 1 : 0, milliseconds.size() - 1)];
+		};
+
+		double sum = 0;
+		for (double value : milliseconds)
+		{
+			sum += value;
+		}
+		summary.min = milliseconds.front();
+		summary.mean = sum / milliseconds.size();
+		summary.p50 = percentile(0.50);
+		summary.p90 = percentile(0.90);
+		summary.p95 = percentile(0.95);
+		summary.p99 = percentile(0.99);
+		summary.max = milliseconds.back();
+		return summary;
+	}
+
+	void StressDriver::Print(const StressResult& result, std::ostream& stream)
+	{
+		const StressConfig& config = result.config;
+		const float mixTotal = config.meshMix[0] + config.meshMix[1] + config.meshMix[2];
+		stream << std::fixed << std::setprecision(0);
+		if (!config.worldPath.empty())
+		{
+			const WorldStreamingConfig& streaming = config.streaming;
+			stream << "Scene: " << config.entityCount << " entities streamed from " << config.worldPath << ", load radius "
+				<< streaming.loadRadius << ", unload radius " << streaming.unloadRadius << ", budget ";
+			if (streaming.addBudget > 0)
+			{
+				stream << streaming.addBudget << " entities per frame, ";
+			}
+			else
+			{
+				stream << "unlimited, ";
+			}
+			stream << (streaming.synchronous ? "loaded on the render thread" : "loaded in the background") << "\n" << std::setprecision(2);
+		}
+		else if (!config.scenePath.empty())
+		{
+			stream << "Scene: " << config.entityCount << " entities from " << config.scenePath << "\n" << std::setprecision(2);
+		}
+		else
+		{
+			stream << "Scene: " << config.entityCount << " entities (";
+			for (std::uint32_t i = 0; i < 3; ++i)
+			{
+				stream << (i > 0 ? ", " : "") << MeshNames[i] << " " << (mixTotal > 0 ? 100.0 * config.meshMix[i] / mixTotal : 0) << "%";
+			}
+			stream << "), " << config.lightCount << " lights, " << config.materialCount << " materials, "
+				<< config.animatedFraction * 100.0 << "% animated, " << config.staticFraction * 100.0 << "% of the rest static, seed " << config.seed << "\n" << std::setprecision(2);
+		}
+		stream << "Frames: " << config.frameCount << " timed after " << config.warmupFrames << " warmup, "
+			<< config.viewCount << " view(s), occlusion culling " << (config.occlusionCulling ? "on" : "off") << ", camera ";
+		if (!config.cameraTrack)
+		{
+			stream << "circling the scene\n";
+		}
+		else if (config.cameraTimeStep > 0)
+		{
+			stream << "track every " << config.cameraTimeStep * 1000.0 << " ms\n";
+		}
+		else
+		{
+			stream << "track at recorded frame times\n";
+		}
+		stream << "Setup: " << result.setupSeconds * 1000.0 << " ms\n";
+
+		const FrameTimeSummary& t = result.frameTimes;
+		stream << "Frame time ms: min " << t.min << "  mean " << t.mean << "  p50 " << t.p50 << "  p90 " << t.p90
+			<< "  p95 " << t.p95 << "  p99 " << t.p99 << "  max " << t.max << "\n";
+		stream << "Throughput: " << result.framesPerSecond << " frames/s, " << std::setprecision(0) << result.entitiesPerSecond
+			<< " entities/s, " << result.drawCalls * result.framesPerSecond << " draws/s\n";
+		const FrameTimeSummary& l = result.latency;
+		stream << std::setprecision(2) << "Latency ms: p50 " << l.p50 << "  p95 " << l.p95 << "  p99 " << l.p99 << "  max " << l.max
+			<< ", " << result.simulationMilliseconds << " ms simulating and " << result.renderMilliseconds << " ms rendering a frame "
+			<< (config.pipelined ? "on separate threads" : "on one thread") << "\n";
+		if (config.pipelined || config.churnPerFrame > 0)
+		{
+			stream << "Consistency: " << result.entitiesChurned << " entities added while rendering, entity count off by "
+				<< result.entityCountError << ", " << result.framesInconsistent << " frames with the wrong entity count, "
+				<< result.transformsWrong << " animated entities out of place, " << result.framesSkipped << " frames skipped\n";
+		}
+		stream << std::setprecision(0);
+		stream << "Per frame: " << result.drawCalls << " draws, " << result.triangles << " triangles, "
+			<< result.entitiesVisible << " visible, " << result.entitiesCulled << " culled, " << result.entitiesOccluded << " occluded, "
+			<< result.stateBindsIssued << " binds issued, " << result.stateBindsFiltered << " filtered, "
+			<< std::setprecision(2) << ToMegabytes(static_cast<std::uint64_t>(result.bytesUploaded)) << " MB uploaded\n";
+		stream << "Memory: " << ToMegabytes(result.sceneBytes) << " MB resident after setup, "
+			<< ToMegabytes(result.peakBytes) << " MB peak, " << ToMegabytes(result.frameArenaBytes) << " MB frame arena\n";
+		const StaticBatchStats& batches = result.staticBatches;
+		if (batches.entities > 0)
+		{
+			// Build time is of the last build that rebuilt anything, which is the first frame unless members change
+			stream << "Static batches: " << batches.chunks << " chunks of " << batches.entities << " entities, "
+				<< ToMegabytes(batches.vertices * sizeof(Vertex) + batches.indices * sizeof(std::uint32_t)) << " MB of geometry, last built "
+				<< batches.rebuilt << " chunks in " << batches.buildMilliseconds << " ms on " << batches.threads << " thread(s), "
+				<< result.staticChunksVisible << " visible and " << result.staticChunksRebuilt << " rebuilt per frame\n";
+		}
+		if (result.meshletsTested > 0)
+		{
+			stream << "Meshlets: " << std::setprecision(0) << result.meshletsTested << " tested, " << result.meshletsCulled << " culled, "
+				<< result.meshletTrianglesCulled << " triangles culled per frame in " << std::setprecision(3) << result.meshletCullMilliseconds << " ms\n";
+		}
+		if (!config.worldPath.empty())
+		{
+			// Frames that add streamed entities allocate by design, so the allocation counts below include them
+			const WorldStreamingStats& streaming = result.streaming;
+			stream << "Streaming: " << std::setprecision(0) << result.entitiesResident << " entities resident on average, "
+				<< result.maxEntitiesResident << " at most, up to " << result.maxEntitiesAdded << " added and "
+				<< result.maxEntitiesRemoved << " removed in a frame, " << streaming.cellsLoaded << " cells loaded in "
+				<< std::setprecision(2) << streaming.loadMilliseconds << " ms, " << streaming.cellsEvicted << " evicted, "
+				<< streaming.cellsFailed << " failed, " << result.framesMissingCells << " frames with cells missing near the camera\n";
+		}
+		stream << "Heap allocations per frame: " << result.frameAllocations << " mean, " << result.maxFrameAllocations << " max\n";
+
+		stream << "Tracked memory MB (current/peak):";
+		for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+		{
+			for (std::uint32_t domain = 0; domain < static_cast<std::uint32_t>(MemoryDomain::Count); ++domain)
+			{
+				const MemoryUsage& usage = result.trackedMemory[tag][domain];
+				if (usage.peak > 0)
+				{
+					stream << "  " << MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)) << " "
+						<< MemoryTracker::GetDomainName(static_cast<MemoryDomain>(domain)) << " "
+						<< ToMegabytes(usage.current) << "/" << ToMegabytes(usage.peak);
+				}
+			}
+		}
+		stream << "\n";
+		if (result.leakedBytes != 0)
+		{
+			stream << "Leaked: " << result.leakedBytes << " tracked bytes were not released with the renderer\n";
+		}
+		if (!result.config.referencePath.empty())
+		{
+			stream << "Reference image: " << result.config.referencePath << " traced in " << result.referenceMilliseconds << " ms\n";
+		}
+	}
+
+	void StressDriver::PrintTable(const std::vector<StressResult>& results, std::ostream& stream)
+	{
+		stream << std::right << std::setw(10) << "Entities" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms"
+			<< std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(14) << "entities/s"
+			<< std::setw(10) << "draws" << std::setw(12) << "peak MB" << "\n";
+		for (const auto& result : results)
+		{
+			const FrameTimeSummary& t = result.frameTimes;
+			stream << std::setw(10) << result.config.entityCount << std::fixed << std::setprecision(3)
+				<< std::setw(10) << t.p50 << std::setw(10) << t.p95 << std::setw(10) << t.p99 << std::setw(10) << t.max
+				<< std::setprecision(0) << std::setw(14) << result.entitiesPerSecond << std::setw(10) << result.drawCalls
+				<< std::setprecision(1) << std::setw(12) << ToMegabytes(result.peakBytes) << "\n";
+		}
+	}
+
+	void StressDriver::WriteJson(const std::vector<StressResult>& results, std::ostream& stream)
+	{
+		stream << std::setprecision(10) << "{\n  \"runs\": [";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const StressResult& r = results[i];
+			const StressConfig& c = r.config;
+			const FrameTimeSummary& t = r.frameTimes;
+			stream << (i > 0 ? ",\n" : "\n") << "    {\n"
+				<< "      \"config\": { \"entities\": " << c.entityCount << ", \"lights\": " << c.lightCount
+				<< ", \"meshMix\": [" << c.meshMix[0] << ", " << c.meshMix[1] << ", " << c.meshMix[2] << "]"
+				<< ", \"materials\": " << c.materialCount << ", \"animatedFraction\": " << c.animatedFraction
+				<< ", \"staticFraction\": " << c.staticFraction << ", \"staticChangesPerFrame\": " << c.staticChangesPerFrame
+				<< ", \"seed\": " << c.seed << ", \"sphereSegments\": " << c.sphereSegments << ", \"sceneFile\": " << (c.scenePath.empty() ? "false" : "true")
+				<< ", \"world\": " << (c.worldPath.empty() ? "false" : "true") << ", \"frames\": " << c.frameCount << ", \"warmupFrames\": " << c.warmupFrames
+				<< ", \"views\": " << c.viewCount << ", \"occlusionCulling\": " << (c.occlusionCulling ? "true" : "false")
+				<< ", \"cameraTrack\": " << (c.cameraTrack ? "true" : "false") << ", \"cameraTimeStep\": " << c.cameraTimeStep
+				<< ", \"pipelined\": " << (c.pipelined ? "true" : "false") << ", \"churnPerFrame\": " << c.churnPerFrame << " },\n"
+				<< "      \"setupSeconds\": " << r.setupSeconds << ",\n"
+				<< "      \"frameTimeMs\": { \"min\": " << t.min << ", \"mean\": " << t.mean << ", \"p50\": " << t.p50
+				<< ", \"p90\": " << t.p90 << ", \"p95\": " << t.p95 << ", \"p99\": " << t.p99 << ", \"max\": " << t.max << " },\n"
+				<< "      \"framesPerSecond\": " << r.framesPerSecond << ", \"entitiesPerSecond\": " << r.entitiesPerSecond << ",\n"
+				<< "      \"latencyMs\": { \"p50\": " << r.latency.p50 << ", \"p95\": " << r.latency.p95 << ", \"p99\": " << r.latency.p99
+				<< ", \"max\": " << r.latency.max << " },\n"
+				<< "      \"pipeline\": { \"simulationMs\": " << r.simulationMilliseconds << ", \"renderMs\": " << r.renderMilliseconds
+				<< ", \"framesSkipped\": " << r.framesSkipped << ", \"entitiesChurned\": " << r.entitiesChurned
+				<< ", \"entityCountError\": " << r.entityCountError << ", \"framesInconsistent\": " << r.framesInconsistent
+				<< ", \"transformsWrong\": " << r.transformsWrong << " },\n"
+				<< "      \"perFrame\": { \"drawCalls\": " << r.drawCalls << ", \"triangles\": " << r.triangles
+				<< ", \"entitiesVisible\": " << r.entitiesVisible << ", \"entitiesCulled\": " << r.entitiesCulled
+				<< ", \"entitiesOccluded\": " << r.entitiesOccluded << ", \"bytesUploaded\": " << r.bytesUploaded
+				<< ", \"stateBindsIssued\": " << r.stateBindsIssued << ", \"stateBindsFiltered\": " << r.stateBindsFiltered
+				<< ", \"staticChunksVisible\": " << r.staticChunksVisible << ", \"staticChunksRebuilt\": " << r.staticChunksRebuilt
+				<< ", \"meshletsTested\": " << r.meshletsTested << ", \"meshletsCulled\": " << r.meshletsCulled
+				<< ", \"meshletTrianglesCulled\": " << r.meshletTrianglesCulled << ", \"meshletCullMs\": " << r.meshletCullMilliseconds << " },\n"
+				<< "      \"staticBatches\": { \"chunks\": " << r.staticBatches.chunks << ", \"entities\": " << r.staticBatches.entities
+				<< ", \"vertices\": " << r.staticBatches.vertices << ", \"indices\": " << r.staticBatches.indices
+				<< ", \"lastBuildChunks\": " << r.staticBatches.rebuilt << ", \"lastBuildThreads\": " << r.staticBatches.threads
+				<< ", \"lastBuildMs\": " << r.staticBatches.buildMilliseconds << " },\n"
+				<< "      \"streaming\": { \"entitiesResident\": " << r.entitiesResident << ", \"maxEntitiesResident\": " << r.maxEntitiesResident
+				<< ", \"maxEntitiesAdded\": " << r.maxEntitiesAdded << ", \"maxEntitiesRemoved\": " << r.maxEntitiesRemoved
+				<< ", \"cellsLoaded\": " << r.streaming.cellsLoaded << ", \"cellsEvicted\": " << r.streaming.cellsEvicted
+				<< ", \"cellsFailed\": " << r.streaming.cellsFailed << ", \"loadMs\": " << r.streaming.loadMilliseconds
+				<< ", \"framesMissingCells\": " << r.framesMissingCells << " },\n"
+				<< "      \"memory\": { \"sceneBytes\": " << r.sceneBytes << ", \"peakBytes\": " << r.peakBytes
+				<< ", \"frameArenaBytes\": " << r.frameArenaBytes << ", \"frameAllocations\": " << r.frameAllocations
+				<< ", \"maxFrameAllocations\": " << r.maxFrameAllocations << ", \"leakedBytes\": " << r.leakedBytes << " },\n"
+				<< "      \"trackedMemory\": {";
+			for (std::uint32_t tag = 0; tag < static_cast<std::uint32_t>(MemoryTag::Count); ++tag)
+			{
+				const auto& cpu = r.trackedMemory[tag][static_cast<size_t>(MemoryDomain::Cpu)];
+				const auto& gpu = r.trackedMemory[tag][static_cast<size_t>(MemoryDomain::Gpu)];
+				stream << (tag > 0 ? ", " : " ") << "\"" << MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)) << "\": { "
+					<< "\"cpuCurrent\": " << cpu.current << ", \"cpuPeak\": " << cpu.peak
+					<< ", \"gpuCurrent\": " << gpu.current << ", \"gpuPeak\": " << gpu.peak << " }";
+			}
+			stream << " }\n"
+				<< "    }";
+		}
+		stream << "\n  ]\n}\n";
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "StressScene.h"
+#include "Rendering/RenderStats.h"
+#include "Memory/MemoryTracker.h"
+#include "Rendering/StaticBatcher.h"
+
+namespace stress
+{
+	/** Frame time distribution in milliseconds */
+	struct FrameTimeSummary
+	{
+		double min = 0;
+		double mean = 0;
+		double p50 = 0;
+		double p90 = 0;
+		double p95 = 0;
+		double p99 = 0;
+		double max = 0;
+	};
+
+	/** What one stress run measured */
+	struct StressResult
+	{
+		StressConfig config;
+		// Time to generate or load the scene and add it to the renderer
+		double setupSeconds = 0;
+		FrameTimeSummary frameTimes;
+		double framesPerSecond = 0;
+		// Entities processed per second of frame time, visible or not
+		double entitiesPerSecond = 0;
+		// Averages over the timed frames
+		double drawCalls = 0;
+		double triangles = 0;
+		double entitiesVisible = 0;
+		double entitiesCulled = 0;
+		double entitiesOccluded = 0;
+		double bytesUploaded = 0;
+		double stateBindsIssued = 0;
+		double stateBindsFiltered = 0;
+		double staticChunksVisible = 0;
+		double staticChunksRebuilt = 0;
+		double meshletsTested = 0;
+		double meshletsCulled = 0;
+		double meshletTrianglesCulled = 0;
+		double meshletCullMilliseconds = 0;
+		// Chunk counts and geometry of the static batches, with the time and threads of their last build
+		renderer::StaticBatchStats staticBatches;
+		// Resident memory after the scene was set up and the process high-water mark after the run
+		std::uint64_t sceneBytes = 0;
+		std::uint64_t peakBytes = 0;
+		// Streaming of a partitioned world. The stats are of the last frame, with totals since the world was opened
+		renderer::WorldStreamingStats streaming;
+		double entitiesResident = 0;
+		std::uint64_t maxEntitiesResident = 0;
+		std::uint32_t maxEntitiesAdded = 0;
+		std::uint32_t maxEntitiesRemoved = 0;
+		// Timed frames with cells within the load radius of the camera not yet in the renderer, which show as pop in
+		std::uint32_t framesMissingCells = 0;
+		// Heap allocations made while rendering timed frames. Steady state frames should make none
+		double frameAllocations = 0;
+		std::uint64_t maxFrameAllocations = 0;
+		// Most the renderer took from its frame arena in one frame
+		std::uint64_t frameArenaBytes = 0;
+		// Tracked memory of every subsystem at the end of the run, with peaks over the run
+		std::array<std::array<renderer::MemoryUsage, static_cast<size_t>(renderer::MemoryDomain::Count)>,
+			static_cast<size_t>(renderer::MemoryTag::Count)> trackedMemory;
+		// Tracked bytes the renderer did not give back when it was destroyed
+		std::int64_t leakedBytes = 0;
+		// Time to ray trace the reference image, when one was saved
+		double referenceMilliseconds = 0;
+		// From the simulation beginning a frame to the renderer finishing it, which pipelining adds a frame to
+		FrameTimeSummary latency;
+		// Means over the timed frames of the time spent simulating and rendering one frame, which are on
+		// different threads when pipelined
+		double simulationMilliseconds = 0;
+		double renderMilliseconds = 0;
+		// Frames the render thread never took, which should be none as the simulation waits for each to be taken
+		std::uint64_t framesSkipped = 0;
+		std::uint64_t entitiesChurned = 0;
+		// Checks of the pipelined render side. Entities the renderer has that the simulation does not, or the other
+		// way when negative, frames whose entity count did not match the snapshot's, and animated entities left
+		// somewhere other than where the simulation last put them
+		std::int64_t entityCountError = 0;
+		std::uint32_t framesInconsistent = 0;
+		std::uint64_t transformsWrong = 0;
+	};
+
+	/** Renders generated scenes headlessly for a number of frames and reports how the frames went */
+	class StressDriver
+	{
+	public:
+		static StressResult Run(const StressConfig& config);
+		static void Print(const StressResult& result, std::ostream& stream);
+		/** One row per run, for comparing scales */
+		static void PrintTable(const std::vector<StressResult>& results, std::ostream& stream);
+		static void WriteJson(const std::vector<StressResult>& results, std::ostream& stream);
+		/** Nearest rank percentiles of the samples, which are sorted in place */
+		static FrameTimeSummary Summarize(std::vector<double>& milliseconds);
+	};
+}
@@ -0,0 +1,237 @@
+#include "StressScene.h"
+#include "Scene/SceneContent.h"
+#include <random>
+
+using namespace renderer;
+
+namespace stress
+{
+	StressScene::StressScene(const StressConfig& config)
+		: mExtent(10.0f)
+	{
+		if (!config.worldPath.empty())
+		{
+			LoadWorld(config);
+		}
+		else if (!config.scenePath.empty())
+		{
+			Load(config.scenePath);
+		}
+		else
+		{
+			Generate(config);
+		}
+	}
+
+	void StressScene::Generate(const StressConfig& config)
+	{
+		std::mt19937 random(config.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		mExtent = std::max(std::sqrt(static_cast<float>(config.entityCount)) * Spacing * 0.5f, 10.0f);
+		std::uniform_real_distribution<float> ground(-mExtent, mExtent);
+
+		const std::uint32_t materialCount = std::max(config.materialCount, 1u);
+		for (std::uint32_t i = 0; i < materialCount; ++i)
+		{
+			auto material = std::make_shared<Material>();
+			material->diffuse = { unit(random), unit(random), unit(random), 1 };
+			material->specular = { 0.3f, 0.3f, 0.3f };
+			material->gloss = 1.0f + unit(random) * 31.0f;
+			mMaterials.push_back(material);
+		}
+
+		// A mix of all zeros falls back to cubes, the only mesh the renderer has geometry for
+		std::array<float, 3> mix = config.meshMix;
+		if (mix[0] + mix[1] + mix[2] <= 0)
+		{
+			mix = { 0, 1, 0 };
+		}
+		std::discrete_distribution<std::uint32_t> meshType(mix.begin(), mix.end());
+		std::uniform_int_distribution<std::uint32_t> material(0, materialCount - 1);
+		// Static entities are picked from their own sequence so a seed makes the same scene with or without them
+		std::mt19937 staticRandom(config.seed + 1);
+
+		mEntities.reserve(config.entityCount);
+		for (size_t i = 0; i < config.entityCount; ++i)
+		{
+			auto entity = std::make_shared<Entity>();
+			entity->mesh = meshType(random);
+			entity->material = mMaterials[material(random)];
+			float size = 0.5f + unit(random) * 1.5f;
+			entity->scale = { size, size * (0.5f + unit(random) * 2.0f), size };
+			entity->position = { ground(random), entity->scale.y * 0.5f, ground(random) };
+			entity->rotation = { 0, 1, 0, unit(random) * 360.0f };
+			mEntities.push_back(entity);
+
+			if (unit(random) < config.animatedFraction)
+			{
+				mAnimations.push_back({ entity.get(), static_cast<std::uint32_t>(i), entity->position.y, entity->rotation.w, unit(random) * Math::Pi * 2.0f });
+			}
+			else if (unit(staticRandom) < config.staticFraction)
+			{
+				entity->isStatic = true;
+				mStaticEntities.push_back(entity.get());
+			}
+		}
+
+		for (std::uint32_t i = 0; i < config.lightCount; ++i)
+		{
+			auto light = std::make_shared<PointLight>();
+			light->position = { ground(random), 2.0f + unit(random) * 8.0f, ground(random) };
+			light->range = 10.0f + unit(random) * 20.0f;
+			light->attenuation = { 0, 0.2f, 0 };
+			light->diffuse = { unit(random), unit(random), unit(random) };
+			light->specular = { 1, 1, 1 };
+			mPointLights.push_back(light);
+		}
+	}
+
+	void StressScene::Load(const std::string& path)
+	{
+		// The file was validated when the options were read
+		SceneFile file;
+		if (!file.Open(path))
+		{
+			return;
+		}
+		SceneContent content = SceneContent::Create(file.GetArrays());
+		mMaterials = std::move(content.materials);
+		mEntities = std::move(content.entities);
+		mPointLights = std::move(content.pointLights);
+
+		// The cameras circle inside the square around everything
+		for (const auto& entity : mEntities)
+		{
+			mExtent = std::max({ mExtent, std::abs(entity->position.x), std::abs(entity->position.z) });
+			if (entity->isStatic)
+			{
+				mStaticEntities.push_back(entity.get());
+			}
+		}
+	}
+
+	void StressScene::LoadWorld(const StressConfig& config)
+	{
+		// The world was checked when the options were read. Its entities arrive as the cameras move, and only
+		// its lights are added up front
+		mStreamer = std::make_unique<WorldStreamer>(config.streaming);
+		if (!mStreamer->Open(config.worldPath))
+		{
+			return;
+		}
+		mMaterials = mStreamer->GetWorldContent().materials;
+		mPointLights = mStreamer->GetWorldContent().pointLights;
+
+		XMFLOAT3 boundsMin, boundsMax;
+		mStreamer->GetPartition().GetBounds(boundsMin, boundsMax);
+		mExtent = std::max({ mExtent, std::abs(boundsMin.x), std::abs(boundsMin.z), std::abs(boundsMax.x), std::abs(boundsMax.z) });
+	}
+
+	bool StressScene::Save(const std::string& path) const
+	{
+		SceneData data;
+		return data.Capture(mEntities, mPointLights, {}) && SceneFile::Save(path, data.GetArrays());
+	}
+
+	bool StressScene::SaveWorld(const std::string& directory, float cellSize) const
+	{
+		SceneData data;
+		return data.Capture(mEntities, mPointLights, {}) && WorldPartition::Build(data.GetArrays(), cellSize, directory);
+	}
+
+	WorldStreamer* StressScene::GetStreamer()
+	{
+		return mStreamer.get();
+	}
+
+	const std::vector<std::shared_ptr<Entity>>& StressScene::GetEntities() const
+	{
+		return mEntities;
+	}
+
+	const std::vector<std::shared_ptr<PointLight>>& StressScene::GetPointLights() const
+	{
+		return mPointLights;
+	}
+
+	const std::vector<const Entity*>& StressScene::GetStaticEntities() const
+	{
+		return mStaticEntities;
+	}
+
+	void StressScene::GetAnimatedIndices(std::vector<std::uint32_t>& indices) const
+	{
+		for (const auto& animation : mAnimations)
+		{
+			indices.push_back(animation.index);
+		}
+	}
+
+	float StressScene::GetExtent() const
+	{
+		return mExtent;
+	}
+
+	void StressScene::Animate(double time)
+	{
+		const float t = static_cast<float>(time);
+		for (const auto& animation : mAnimations)
+		{
+			animation.entity->position.y = animation.baseHeight + 0.5f + 0.5f * std::sin(t * 2.0f + animation.phase);
+			animation.entity->rotation.w = std::fmod(animation.baseAngle + t * 90.0f, 360.0f);
+		}
+	}
+
+	void StressScene::UpdateCamera(Camera& camera, std::uint32_t viewIndex, std::uint32_t viewCount, double progress) const
+	{
+		// Circle inside the scene at head height so most of it is beyond the far plane or behind the camera
+		const float angle = static_cast<float>(progress) * Math::Pi * 2.0f;
+		const float radius = mExtent * 0.5f;
+		XMFLOAT3 position(std::cos(angle) * radius, 2.0f, std::sin(angle) * radius);
+
+		// Looking along the path, turned for each extra view
+		const float lookAngle = angle + Math::Pi * 0.5f + Math::Pi * 2.0f * viewIndex / std::max(viewCount, 1u);
+		XMFLOAT3 target(position.x + std::cos(lookAngle), position.y - 0.1f, position.z + std::sin(lookAngle));
+
+		camera.SetPosition(position);
+		camera.SetTarget(target);
+	}
+
+	void StressScene::CreateSphere(std::uint32_t segments, std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices)
+	{
+		segments = std::max(segments, 3u);
+		const std::uint32_t rings = std::max(segments / 2, 2u);
+		vertices.clear();
+		indices.clear();
+		vertices.push_back(Vertex(0, 0.5f, 0, 0, 1, 0));
+		for (std::uint32_t ring = 1; ring < rings; ++ring)
+		{
+			const float theta = Math::Pi * ring / rings;
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const float phi = Math::Pi * 2.0f * segment / segments;
+				const XMFLOAT3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				vertices.push_back(Vertex(normal.x * 0.5f, normal.y * 0.5f, normal.z * 0.5f, normal.x, normal.y, normal.z));
+			}
+		}
+		vertices.push_back(Vertex(0, -0.5f, 0, 0, -1, 0));
+
+		const auto south = static_cast<std::uint32_t>(vertices.size() - 1);
+		auto ringVertex = [&](std::uint32_t ring, std::uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+		// Going around with increasing angle is anticlockwise seen from outside, so the segments run backwards
+		for (std::uint32_t segment = 0; segment < segments; ++segment)
+		{
+			indices.insert(indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+			for (std::uint32_t ring = 1; ring + 1 < rings; ++ring)
+			{
+				const std::uint32_t a = ringVertex(ring, segment);
+				const std::uint32_t b = ringVertex(ring, segment + 1);
+				const std::uint32_t c = ringVertex(ring + 1, segment);
+				const std::uint32_t d = ringVertex(ring + 1, segment + 1);
+				indices.insert(indices.end(), { a, b, d, a, d, c });
+			}
+			indices.insert(indices.end(), { south, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1) });
+		}
+	}
+}
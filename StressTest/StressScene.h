@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Rendering/DataTypes.h"
+#include "Camera/Camera.h"
+#include "Camera/CameraTrack.h"
+#include "Scene/WorldStreamer.h"
+
+namespace stress
+{
+	/** Parameters of a generated scene and how long to render it */
+	struct StressConfig
+	{
+		size_t entityCount = 50;
+		std::uint32_t lightCount = 10;
+		// Relative weights of cones, cubes and spheres, indexed by built-in mesh handle
+		std::array<float, 3> meshMix = { 0, 1, 0 };
+		std::uint32_t materialCount = 2;
+		// Fraction of entities that move and spin every frame
+		float animatedFraction = 0;
+		// Fraction of the entities that do not move marked static, so the renderer batches them
+		float staticFraction = 0;
+		// Static entities marked changed every frame, which rebuilds their batches
+		std::uint32_t staticChangesPerFrame = 0;
+		std::uint32_t seed = 1;
+		// Spheres are drawn as a registered sphere with this many segments around, which is split into meshlets
+		// once it is large enough. Zero keeps the built-in sphere. Scenes using it cannot be saved
+		std::uint32_t sphereSegments = 0;
+		// Scene file rendered instead of a generated scene, in which case the settings above are unused
+		std::string scenePath;
+		// Saves the scene that was rendered as a scene file when set
+		std::string saveScenePath;
+		// Partitioned world streamed in around the first view instead of a scene, in which case the entity count is
+		// of the whole world and the generator settings are unused
+		std::string worldPath;
+		// Saves the scene that was rendered as a partitioned world with cells of the given width when set
+		std::string saveWorldPath;
+		float cellSize = 64.0f;
+		renderer::WorldStreamingConfig streaming;
+		std::uint32_t frameCount = 300;
+		// Frames rendered before timing starts so buffers and caches are warm
+		std::uint32_t warmupFrames = 10;
+		std::uint32_t viewCount = 1;
+		bool occlusionCulling = false;
+		// Path every view follows instead of circling the scene. The timed frames play the whole track once
+		std::shared_ptr<const renderer::CameraTrack> cameraTrack;
+		// Seconds between replayed frames. Zero replays the recorded frames with their frame times
+		double cameraTimeStep = 0;
+		// Receives the first view's camera during the timed frames when set
+		std::shared_ptr<renderer::CameraTrack> cameraRecording;
+		// Ray traces the first view of the last frame on the CPU and saves it as a PPM golden image when set
+		std::string referencePath;
+		// Renders on a thread of its own from snapshots the simulation publishes through a FramePipeline, while
+		// the simulation writes the next frame. Not for streamed worlds or static changes
+		bool pipelined = false;
+		// Entities added every frame, each removed again a few frames later, to check that entities added while
+		// rendering all arrive
+		std::uint32_t churnPerFrame = 0;
+	};
+
+	/**
+	 * Deterministic scene for stress tests. Entities are spread over a square that grows with their count so the
+	 * density, and so the share of the scene a camera sees up close, stays the same at every scale. Scenes can
+	 * also be loaded from a scene file, or streamed from a partitioned world, in which case nothing is animated.
+	 */
+	class StressScene
+	{
+	public:
+		explicit StressScene(const StressConfig& config);
+		const std::vector<std::shared_ptr<renderer::Entity>>& GetEntities() const;
+		const std::vector<std::shared_ptr<renderer::PointLight>>& GetPointLights() const;
+		const std::vector<const renderer::Entity*>& GetStaticEntities() const;
+		/** Appends the indices in GetEntities of the entities Animate moves */
+		void GetAnimatedIndices(std::vector<std::uint32_t>& indices) const;
+		bool Save(const std::string& path) const;
+		bool SaveWorld(const std::string& directory, float cellSize) const;
+		/** Streamer of the world when one is being streamed, whose entities are not in GetEntities */
+		renderer::WorldStreamer* GetStreamer();
+		/** Half the width of the square the entities are spread over */
+		float GetExtent() const;
+		/** Moves the animated entities to where they are at the given time in seconds */
+		void Animate(double time);
+		/**
+		 * Places the camera of a view on the scripted path. The path circles the scene once as progress goes from
+		 * 0 to 1, and each view looks in a different direction like split screen players.
+		 */
+		void UpdateCamera(renderer::Camera& camera, std::uint32_t viewIndex, std::uint32_t viewCount, double progress) const;
+		/** Smooth sphere of radius one half, like the built-in one, with half as many rings as segments */
+		static void CreateSphere(std::uint32_t segments, std::vector<renderer::Vertex>& vertices, std::vector<std::uint32_t>& indices);
+
+		// Average distance between neighbouring entities on the ground
+		static constexpr float Spacing = 3.0f;
+
+	private:
+		/** Animated entity and where its motion starts */
+		struct Animation
+		{
+			renderer::Entity* entity;
+			std::uint32_t index;
+			float baseHeight;
+			float baseAngle;
+			float phase;
+		};
+
+		void Generate(const StressConfig& config);
+		void Load(const std::string& path);
+		void LoadWorld(const StressConfig& config);
+
+		std::vector<std::shared_ptr<renderer::Material>> mMaterials;
+		std::vector<std::shared_ptr<renderer::Entity>> mEntities;
+		std::vector<std::shared_ptr<renderer::PointLight>> mPointLights;
+		std::vector<Animation> mAnimations;
+		std::vector<const renderer::Entity*> mStaticEntities;
+		std::unique_ptr<renderer::WorldStreamer> mStreamer;
+		float mExtent;
+	};
+}
@@ -0,0 +1,47 @@
+#include "ProcessMemory.h"
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace stress
+{
+	std::uint64_t ProcessMemory::GetCurrentBytes()
+	{
+#ifdef __APPLE__
+		mach_task_basic_info info;
+		mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+		if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+		{
+			return 0;
+		}
+		return info.resident_size;
+#else
+		// The second field of statm is the resident set in pages
+		std::ifstream statm("/proc/self/statm");
+		std::uint64_t size = 0;
+		std::uint64_t resident = 0;
+		if (!(statm >> size >> resident))
+		{
+			return 0;
+		}
+		return resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	std::uint64_t ProcessMemory::GetPeakBytes()
+	{
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+		{
+			return 0;
+		}
+#ifdef __APPLE__
+		// Bytes on macOS, kilobytes everywhere else
+		return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+		return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+}
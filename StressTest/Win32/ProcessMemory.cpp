@@ -0,0 +1,25 @@
+#include "ProcessMemory.h"
+#include <psapi.h>
+
+namespace stress
+{
+	std::uint64_t ProcessMemory::GetCurrentBytes()
+	{
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return 0;
+		}
+		return counters.WorkingSetSize;
+	}
+
+	std::uint64_t ProcessMemory::GetPeakBytes()
+	{
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return 0;
+		}
+		return counters.PeakWorkingSetSize;
+	}
+}